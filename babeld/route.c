@@ -247,6 +247,77 @@ flush_route(struct babel_route *route)
     release_source(src);
 }
 
+/* Flush a batch of routes that have already been unlinked from the
+   table.  Equivalent to calling flush_route() on each of them, except
+   that the table was compacted in a single pass beforehand. */
+static void
+flush_unlinked_routes(struct babel_route *unlinked)
+{
+    while(unlinked) {
+        struct babel_route *route = unlinked;
+        struct source *src = route->src;
+        unsigned oldmetric = route_metric(route);
+        int lost = 0;
+
+        unlinked = route->next;
+
+        if(route->installed) {
+            uninstall_route(route);
+            lost = 1;
+        }
+
+        route->next = NULL;
+        free(route);
+
+        if(lost)
+            route_lost(src, oldmetric);
+
+        release_source(src);
+    }
+}
+
+/* Remove all routes matched by the given predicate in a single pass
+   over the table, then flush them.  Avoids the per-route slot search
+   and table shift performed by flush_route(), which made mass removals
+   quadratic in the size of the table. */
+static void
+flush_matching_routes(int (*match)(struct babel_route *, const void *),
+                      const void *arg)
+{
+    struct babel_route *unlinked = NULL;
+    int i, j;
+
+    for(i = 0; i < route_slots; i++) {
+        struct babel_route **rp = &routes[i];
+        while(*rp) {
+            if(match(*rp, arg)) {
+                struct babel_route *route = *rp;
+                *rp = route->next;
+                route->next = unlinked;
+                unlinked = route;
+            } else {
+                rp = &(*rp)->next;
+            }
+        }
+    }
+
+    /* Compact the slot array over the emptied slots. */
+    j = 0;
+    for(i = 0; i < route_slots; i++) {
+        if(routes[i] != NULL)
+            routes[j++] = routes[i];
+    }
+    route_slots = j;
+
+    if(route_slots == 0)
+        resize_route_table(0);
+    else while(max_route_slots > 8 && route_slots < max_route_slots / 4)
+        resize_route_table(max_route_slots / 2);
+
+    /* The table is consistent again, so route_lost() may search it. */
+    flush_unlinked_routes(unlinked);
+}
+
 void
 flush_all_routes(void)
 {
@@ -267,49 +338,38 @@ flush_all_routes(void)
     check_sources_released();
 }
 
+static int
+route_match_neighbour(struct babel_route *route, const void *arg)
+{
+    return route->neigh == (const struct neighbour *)arg;
+}
+
 void
 flush_neighbour_routes(struct neighbour *neigh)
 {
-    int i;
+    flush_matching_routes(route_match_neighbour, neigh);
+}
 
-    i = 0;
-    while(i < route_slots) {
-        struct babel_route *r;
-        r = routes[i];
-        while(r) {
-            if(r->neigh == neigh) {
-                flush_route(r);
-                goto again;
-            }
-            r = r->next;
-        }
-        i++;
-    again:
-        ;
-    }
+struct interface_match_args {
+    const struct interface *ifp;
+    int v4only;
+};
+
+static int
+route_match_interface(struct babel_route *route, const void *arg)
+{
+    const struct interface_match_args *args = arg;
+
+    return route->neigh->ifp == args->ifp &&
+        (!args->v4only || v4mapped(route->nexthop));
 }
 
 void
 flush_interface_routes(struct interface *ifp, int v4only)
 {
-    int i;
+    struct interface_match_args args = { ifp, v4only };
 
-    i = 0;
-    while(i < route_slots) {
-        struct babel_route *r;
-        r = routes[i];
-        while(r) {
-            if(r->neigh->ifp == ifp &&
-               (!v4only || v4mapped(r->nexthop))) {
-                flush_route(r);
-                goto again;
-            }
-            r = r->next;
-        }
-        i++;
-    again:
-        ;
-    }
+    flush_matching_routes(route_match_interface, &args);
 }
 
 struct route_stream {
@@ -1110,6 +1170,13 @@ route_lost(struct source *src, unsigned oldmetric)
     }
 }
 
+static int
+route_match_expired(struct babel_route *route, const void *arg)
+{
+    /* Protect against clock being stepped. */
+    return route->time > babel_now.tv_sec || route_old(route);
+}
+
 /* This is called periodically to flush old routes.  It will also send
    requests for routes that are about to expire. */
 void
@@ -1120,16 +1187,12 @@ expire_routes(void)
 
     debugf(BABEL_DEBUG_COMMON,"Expiring old routes.");
 
-    i = 0;
-    while(i < route_slots) {
-        r = routes[i];
-        while(r) {
-            /* Protect against clock being stepped. */
-            if(r->time > babel_now.tv_sec || route_old(r)) {
-                flush_route(r);
-                goto again;
-            }
+    /* Flush expired routes first, in a single batch, so that the
+       update pass below works on a stable table. */
+    flush_matching_routes(route_match_expired, NULL);
 
+    for(i = 0; i < route_slots; i++) {
+        for(r = routes[i]; r; r = r->next) {
             update_route_metric(r);
 
             if(r->installed && r->refmetric < INFINITY) {
@@ -1138,10 +1201,6 @@ expire_routes(void)
                     send_unicast_request(r->neigh,
                                          r->src->prefix, r->src->plen);
             }
-            r = r->next;
         }
-        i++;
-    again:
-        ;
     }
 }
@@ -222,6 +222,10 @@ struct bfd_session {
 	struct thread *xmttimer_ev;
 	struct thread *echo_xmttimer_ev;
 	uint64_t echo_detect_TO;
+	/* Kernel receive timestamp delay (in usec) of the packet being
+	 * processed; consumed by the receive timer updates so detection
+	 * runs from actual packet arrival. */
+	uint64_t rx_queue_delay;
 
 	/* software object state */
 	uint8_t polling;
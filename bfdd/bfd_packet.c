@@ -42,6 +42,7 @@
  * Prototypes
  */
 static int ptm_bfd_process_echo_pkt(int s);
+static uint64_t bp_rx_queue_delay(void);
 int _ptm_bfd_send(struct bfd_session *bs, uint16_t *port, const void *data,
 		  size_t datalen);
 
@@ -166,30 +167,37 @@ void ptm_bfd_echo_snd(struct bfd_session *bfd)
 	bfd->stats.tx_echo_pkt++;
 }
 
+/* Returns -1 when the socket is drained, 0 otherwise (including
+ * per-packet errors, which should not stop a batched receive). */
 static int ptm_bfd_process_echo_pkt(int s)
 {
 	struct bfd_session *bfd;
 	uint32_t my_discr = 0;
 	uint8_t ttl = 0;
+	int ret;
 
 	/* Receive and parse echo packet. */
-	if (bp_bfd_echo_in(s, &ttl, &my_discr) == -1)
+	ret = bp_bfd_echo_in(s, &ttl, &my_discr);
+	if (ret == -2)
+		return -1;
+	if (ret == -1)
 		return 0;
 
 	/* Your discriminator not zero - use it to find session */
 	bfd = bfd_id_lookup(my_discr);
 	if (bfd == NULL) {
 		log_debug("echo-packet: no matching session (id:%u)", my_discr);
-		return -1;
+		return 0;
 	}
 
 	if (!BFD_CHECK_FLAG(bfd->flags, BFD_SESS_FLAG_ECHO_ACTIVE)) {
 		log_debug("echo-packet: echo disabled [%s] (id:%u)",
 			  bs_to_string(bfd), my_discr);
-		return -1;
+		return 0;
 	}
 
 	bfd->stats.rx_echo_pkt++;
+	bfd->rx_queue_delay = bp_rx_queue_delay();
 
 	/* Compute detect time */
 	bfd->echo_detect_TO = bfd->remote_detect_mult * bfd->echo_xmt_TO;
@@ -250,6 +258,30 @@ void ptm_bfd_snd(struct bfd_session *bfd, int fbit)
 	bfd->stats.tx_ctrl_pkt++;
 }
 
+/*
+ * Kernel receive timestamp of the packet currently being processed
+ * (zero when the kernel did not supply one).  Detection timeouts are
+ * computed against this instead of the time the event loop got around
+ * to the packet, so queueing delay under load does not show up as
+ * interval jitter.
+ */
+static struct timeval bfd_rx_tstamp;
+
+static uint64_t bp_rx_queue_delay(void)
+{
+	struct timeval now, delay;
+
+	if (!timerisset(&bfd_rx_tstamp))
+		return 0;
+
+	gettimeofday(&now, NULL);
+	timersub(&now, &bfd_rx_tstamp, &delay);
+	if (delay.tv_sec < 0 || delay.tv_usec < 0)
+		return 0;
+
+	return ((uint64_t)delay.tv_sec * 1000000) + delay.tv_usec;
+}
+
 ssize_t bfd_recv_ipv4(int sd, uint8_t *msgbuf, size_t msgbuflen, uint8_t *ttl,
 		      ifindex_t *ifindex, struct sockaddr_any *local,
 		      struct sockaddr_any *peer)
@@ -286,8 +318,17 @@ ssize_t bfd_recv_ipv4(int sd, uint8_t *msgbuf, size_t msgbuflen, uint8_t *ttl,
 	peer->sa_sin = *((struct sockaddr_in *)(msghdr.msg_name));
 
 	/* Get and check TTL */
+	timerclear(&bfd_rx_tstamp);
 	for (cm = CMSG_FIRSTHDR(&msghdr); cm != NULL;
 	     cm = CMSG_NXTHDR(&msghdr, cm)) {
+#ifdef SO_TIMESTAMP
+		if (cm->cmsg_level == SOL_SOCKET
+		    && cm->cmsg_type == SCM_TIMESTAMP) {
+			memcpy(&bfd_rx_tstamp, CMSG_DATA(cm),
+			       sizeof(bfd_rx_tstamp));
+			continue;
+		}
+#endif /* SO_TIMESTAMP */
 		if (cm->cmsg_level != IPPROTO_IP)
 			continue;
 
@@ -397,8 +438,17 @@ ssize_t bfd_recv_ipv6(int sd, uint8_t *msgbuf, size_t msgbuflen, uint8_t *ttl,
 	peer->sa_sin6 = *((struct sockaddr_in6 *)(msghdr6.msg_name));
 
 	/* Get and check TTL */
+	timerclear(&bfd_rx_tstamp);
 	for (cm = CMSG_FIRSTHDR(&msghdr6); cm != NULL;
 	     cm = CMSG_NXTHDR(&msghdr6, cm)) {
+#ifdef SO_TIMESTAMP
+		if (cm->cmsg_level == SOL_SOCKET
+		    && cm->cmsg_type == SCM_TIMESTAMP) {
+			memcpy(&bfd_rx_tstamp, CMSG_DATA(cm),
+			       sizeof(bfd_rx_tstamp));
+			continue;
+		}
+#endif /* SO_TIMESTAMP */
 		if (cm->cmsg_level != IPPROTO_IPV6)
 			continue;
 
@@ -498,9 +548,20 @@ static void cp_debug(bool mhop, struct sockaddr_any *peer,
 		  mhop ? "yes" : "no", peerstr, localstr, portstr, vrfstr);
 }
 
-int bfd_recv_cb(struct thread *t)
+/*
+ * Process up to BFD_RX_BATCH packets per listening socket wakeup.
+ *
+ * The shared sockets carry every session's control traffic; waking the
+ * event loop once per packet leaves later packets queued behind vty and
+ * zebra processing long enough to trip detection timers at aggressive
+ * intervals.  Draining the socket in a single wakeup amortizes that
+ * overhead, while the bound keeps a control packet flood from starving
+ * the rest of the event loop.
+ */
+#define BFD_RX_BATCH 32
+
+static int bfd_recv_ctrl(int sd)
 {
-	int sd = THREAD_FD(t);
 	struct bfd_session *bfd;
 	struct bfd_pkt *cp;
 	bool is_mhop;
@@ -511,15 +572,6 @@ int bfd_recv_cb(struct thread *t)
 	struct sockaddr_any local, peer;
 	uint8_t msgbuf[1516];
 
-	/* Schedule next read. */
-	bfd_sd_reschedule(sd);
-
-	/* Handle echo packets. */
-	if (sd == bglobal.bg_echo || sd == bglobal.bg_echov6) {
-		ptm_bfd_process_echo_pkt(sd);
-		return 0;
-	}
-
 	/* Sanitize input/output. */
 	memset(&local, 0, sizeof(local));
 	memset(&peer, 0, sizeof(peer));
@@ -536,6 +588,10 @@ int bfd_recv_cb(struct thread *t)
 				     &local, &peer);
 	}
 
+	/* Socket drained; wait for the next wakeup. */
+	if (mlen == -1)
+		return -1;
+
 	/* Implement RFC 5880 6.8.6 */
 	if (mlen < BFD_PKT_LEN) {
 		cp_debug(is_mhop, &peer, &local, ifindex, vrfid,
@@ -590,6 +646,7 @@ int bfd_recv_cb(struct thread *t)
 	}
 
 	bfd->stats.rx_ctrl_pkt++;
+	bfd->rx_queue_delay = bp_rx_queue_delay();
 
 	/*
 	 * Multi hop: validate packet TTL.
@@ -667,12 +724,39 @@ int bfd_recv_cb(struct thread *t)
 	return 0;
 }
 
+int bfd_recv_cb(struct thread *t)
+{
+	int sd = THREAD_FD(t);
+	int count;
+
+	/* Schedule next read. */
+	bfd_sd_reschedule(sd);
+
+	/* Handle echo packets. */
+	if (sd == bglobal.bg_echo || sd == bglobal.bg_echov6) {
+		for (count = 0; count < BFD_RX_BATCH; count++) {
+			if (ptm_bfd_process_echo_pkt(sd) == -1)
+				break;
+		}
+		return 0;
+	}
+
+	/* Handle control packets. */
+	for (count = 0; count < BFD_RX_BATCH; count++) {
+		if (bfd_recv_ctrl(sd) == -1)
+			break;
+	}
+
+	return 0;
+}
+
 /*
  * bp_bfd_echo_in: proccesses an BFD echo packet. On TTL == BFD_TTL_VAL
  * the packet is looped back or returns the my discriminator ID along
  * with the TTL.
  *
- * Returns -1 on error or loopback or 0 on success.
+ * Returns -2 when the socket has nothing left to read, -1 on error or
+ * loopback or 0 on success.
  */
 int bp_bfd_echo_in(int sd, uint8_t *ttl, uint32_t *my_discr)
 {
@@ -690,6 +774,10 @@ int bp_bfd_echo_in(int sd, uint8_t *ttl, uint32_t *my_discr)
 		rlen = bfd_recv_ipv6(sd, msgbuf, sizeof(msgbuf), ttl, &ifindex,
 				     &local, &peer);
 
+	/* Socket drained. */
+	if (rlen == -1)
+		return -2;
+
 	/* Short packet, better not risk reading it. */
 	if (rlen < (ssize_t)sizeof(*bep)) {
 		cp_debug(false, &peer, &local, ifindex, vrfid,
@@ -837,6 +925,16 @@ static void bp_set_ipopts(int sd)
 		log_fatal("set-ipopts: setsockopt(IP_PKTINFO, %d): %s", pktinfo,
 			  strerror(errno));
 #endif /* BFD_LINUX */
+#ifdef SO_TIMESTAMP
+	int tstamp = 1;
+
+	/* Timestamp packets in the kernel so detection timeouts don't
+	 * include the time they spent queued behind a busy event loop. */
+	if (setsockopt(sd, SOL_SOCKET, SO_TIMESTAMP, &tstamp, sizeof(tstamp))
+	    == -1)
+		log_warning("set-ipopts: setsockopt(SO_TIMESTAMP, %d): %s",
+			    tstamp, strerror(errno));
+#endif /* SO_TIMESTAMP */
 #ifdef BFD_BSD
 	int yes = 1;
 
@@ -1068,6 +1166,17 @@ static void bp_set_ipv6opts(int sd)
 		log_fatal("set-ipv6opts: setsockopt(IPV6_PKTINFO, %d): %s",
 			  ipv6_pktinfo, strerror(errno));
 
+#ifdef SO_TIMESTAMP
+	int tstamp = 1;
+
+	/* Timestamp packets in the kernel so detection timeouts don't
+	 * include the time they spent queued behind a busy event loop. */
+	if (setsockopt(sd, SOL_SOCKET, SO_TIMESTAMP, &tstamp, sizeof(tstamp))
+	    == -1)
+		log_warning("set-ipv6opts: setsockopt(SO_TIMESTAMP, %d): %s",
+			    tstamp, strerror(errno));
+#endif /* SO_TIMESTAMP */
+
 	if (setsockopt(sd, IPPROTO_IPV6, IPV6_V6ONLY, &ipv6_only,
 		       sizeof(ipv6_only))
 	    == -1)
@@ -39,6 +39,18 @@ void bfd_recvtimer_update(struct bfd_session *bs)
 {
 	struct timeval tv = {.tv_sec = 0, .tv_usec = bs->detect_TO};
 
+	/* The detection time runs from the kernel receive timestamp of
+	 * the packet, not from when the event loop got around to it;
+	 * subtract the queueing delay so load on this box does not
+	 * stretch the detection window. */
+	if (bs->rx_queue_delay) {
+		if (bs->rx_queue_delay < bs->detect_TO)
+			tv.tv_usec = bs->detect_TO - bs->rx_queue_delay;
+		else
+			tv.tv_usec = 1;
+		bs->rx_queue_delay = 0;
+	}
+
 	/* Remove previous schedule if any. */
 	bfd_recvtimer_delete(bs);
 
@@ -60,6 +72,16 @@ void bfd_echo_recvtimer_update(struct bfd_session *bs)
 {
 	struct timeval tv = {.tv_sec = 0, .tv_usec = bs->echo_detect_TO};
 
+	/* As with the control receive timer, run the detection time
+	 * from the kernel receive timestamp of the echo packet. */
+	if (bs->rx_queue_delay) {
+		if (bs->rx_queue_delay < bs->echo_detect_TO)
+			tv.tv_usec = bs->echo_detect_TO - bs->rx_queue_delay;
+		else
+			tv.tv_usec = 1;
+		bs->rx_queue_delay = 0;
+	}
+
 	/* Remove previous schedule if any. */
 	bfd_echo_recvtimer_delete(bs);
 
@@ -308,7 +308,6 @@ void bgp_addpath_type_changed(struct bgp *bgp)
 {
 	afi_t afi;
 	safi_t safi;
-	struct listnode *node, *nnode;
 	struct peer *peer;
 	int peer_count[AFI_MAX][SAFI_MAX][BGP_ADDPATH_MAX];
 	enum bgp_addpath_strat type;
@@ -319,7 +318,7 @@ void bgp_addpath_type_changed(struct bgp *bgp)
 		}
 	}
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		FOREACH_AFI_SAFI(afi, safi) {
 			type = peer->addpath_type[afi][safi];
 			if (type != BGP_ADDPATH_NONE) {
@@ -418,44 +417,88 @@ void bgp_addpath_set_peer_type(struct peer *peer, afi_t afi, safi_t safi,
  * that no longer need them, and give them to paths that do. This prevents
  * best-per-as updates from needing to do a separate withdraw and update just to
  * swap out which path is sent.
+ *
+ * Paths only gain or lose an ID when their eligibility changes, so this is
+ * written to make the steady state (every eligible path already holds its ID)
+ * a single walk with no allocator calls; the allocation pass and the pool
+ * drain only run for strategies where this bestpath run actually changed
+ * something.
  */
 void bgp_addpath_update_ids(struct bgp *bgp, struct bgp_node *bn, afi_t afi,
 			  safi_t safi)
 {
 	int i;
 	struct bgp_path_info *pi;
-	struct id_alloc_pool **pool_ptr;
+	int want[BGP_ADDPATH_MAX];
+	int need_ids = 0;
 
-	for (i = 0; i < BGP_ADDPATH_MAX; i++) {
-		struct id_alloc *alloc =
-			bgp->tx_addpath.id_allocators[afi][safi][i];
-		pool_ptr = &(bn->tx_addpath.free_ids[i]);
+	if (!bgp_addpath_is_addpath_used(&bgp->tx_addpath, afi, safi))
+		return;
 
-		if (bgp->tx_addpath.peercount[afi][safi][i] == 0)
-			continue;
+	for (i = 0; i < BGP_ADDPATH_MAX; i++)
+		want[i] = 0;
 
-		/* Free Unused IDs back to the pool.*/
-		for (pi = bgp_node_get_bgp_path_info(bn); pi; pi = pi->next) {
-			if (pi->tx_addpath.addpath_tx_id[i] != IDALLOC_INVALID
-			    && !bgp_addpath_tx_path(i, pi)) {
-				idalloc_free_to_pool(pool_ptr,
-					pi->tx_addpath.addpath_tx_id[i]);
-				pi->tx_addpath.addpath_tx_id[i] =
-					IDALLOC_INVALID;
+	/* Free unused IDs back to the pool, and count the paths still
+	 * waiting for one per strategy.
+	 */
+	for (pi = bgp_node_get_bgp_path_info(bn); pi; pi = pi->next) {
+		for (i = 0; i < BGP_ADDPATH_MAX; i++) {
+			int tx;
+
+			if (bgp->tx_addpath.peercount[afi][safi][i] == 0)
+				continue;
+
+			tx = bgp_addpath_tx_path(i, pi);
+			if (pi->tx_addpath.addpath_tx_id[i]
+			    != IDALLOC_INVALID) {
+				if (!tx) {
+					idalloc_free_to_pool(
+						&(bn->tx_addpath.free_ids[i]),
+						pi->tx_addpath
+							.addpath_tx_id[i]);
+					pi->tx_addpath.addpath_tx_id[i] =
+						IDALLOC_INVALID;
+				}
+			} else if (tx) {
+				want[i]++;
+				need_ids = 1;
 			}
 		}
+	}
 
-		/* Give IDs to paths that need them (pulling from the pool) */
+	/* Give IDs to paths that need them, preferring IDs just freed on
+	 * this node so a best-per-as swap reuses the old ID instead of
+	 * withdrawing it.
+	 */
+	if (need_ids) {
 		for (pi = bgp_node_get_bgp_path_info(bn); pi; pi = pi->next) {
-			if (pi->tx_addpath.addpath_tx_id[i] == IDALLOC_INVALID
-			    && bgp_addpath_tx_path(i, pi)) {
-				pi->tx_addpath.addpath_tx_id[i] =
-					idalloc_allocate_prefer_pool(
-						alloc, pool_ptr);
+			for (i = 0; i < BGP_ADDPATH_MAX; i++) {
+				if (want[i] == 0)
+					continue;
+
+				if (pi->tx_addpath.addpath_tx_id[i]
+					    == IDALLOC_INVALID
+				    && bgp_addpath_tx_path(i, pi)) {
+					pi->tx_addpath.addpath_tx_id[i] =
+						idalloc_allocate_prefer_pool(
+							bgp->tx_addpath.id_allocators
+								[afi][safi][i],
+							&(bn->tx_addpath
+								  .free_ids[i]));
+					want[i]--;
+				}
 			}
 		}
+	}
 
-		/* Free any IDs left in the pool to the main allocator */
-		idalloc_drain_pool(alloc, pool_ptr);
+	/* Free any IDs left in the pools to the main allocator.  This also
+	 * sweeps up IDs parked here by bgp_addpath_free_info_data().
+	 */
+	for (i = 0; i < BGP_ADDPATH_MAX; i++) {
+		if (bn->tx_addpath.free_ids[i]
+		    && bgp->tx_addpath.id_allocators[afi][safi][i])
+			idalloc_drain_pool(
+				bgp->tx_addpath.id_allocators[afi][safi][i],
+				&(bn->tx_addpath.free_ids[i]));
 	}
 }
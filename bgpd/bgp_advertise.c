@@ -184,7 +184,12 @@ void bgp_adj_in_set(struct bgp_node *rn, struct peer *peer, struct attr *attr,
 
 	for (adj = rn->adj_in; adj; adj = adj->next) {
 		if (adj->peer == peer && adj->addpath_rx_id == addpath_id) {
-			if (adj->attr != attr) {
+			/* 'attr' is the un-interned parse buffer, so compare
+			 * by value: a refresh carrying unchanged attributes
+			 * must not cycle the stored reference through the
+			 * attribute hash.
+			 */
+			if (!attrhash_cmp(adj->attr, attr)) {
 				bgp_attr_unintern(&adj->attr);
 				adj->attr = bgp_attr_intern(attr);
 			}
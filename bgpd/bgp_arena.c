@@ -0,0 +1,125 @@
+/* BGP per-burst parse arena.
+ * Copyright (C) 2019
+ *
+ * This file is part of FRRouting.
+ *
+ * FRRouting is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any later
+ * version.
+ *
+ * FRRouting is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "memory.h"
+
+#include "bgpd/bgp_memory.h"
+#include "bgpd/bgp_arena.h"
+
+DEFINE_MTYPE_STATIC(BGPD, BGP_PARSE_ARENA, "BGP parse arena")
+
+/* Granularity of a fresh block; oversized requests get their own */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct arena_block {
+	struct arena_block *next;
+	size_t size;
+	size_t used;
+	/* data follows the header */
+};
+
+#define ARENA_BLOCK_DATA(blk) ((char *)((blk) + 1))
+
+/* Newest (active) block first; the head survives across bursts so a
+ * steady workload settles on zero mallocs per burst.
+ */
+static struct arena_block *arena_blocks;
+static int arena_depth;
+
+static struct arena_block *arena_block_new(size_t size)
+{
+	struct arena_block *blk;
+
+	blk = XMALLOC(MTYPE_BGP_PARSE_ARENA,
+		      sizeof(struct arena_block) + size);
+	blk->size = size;
+	blk->used = 0;
+	blk->next = NULL;
+
+	return blk;
+}
+
+void bgp_parse_arena_begin(void)
+{
+	arena_depth++;
+}
+
+void bgp_parse_arena_end(void)
+{
+	struct arena_block *blk, *next;
+
+	assert(arena_depth > 0);
+	if (--arena_depth > 0)
+		return;
+
+	/* Keep the newest block for the next burst, drop overflow */
+	if (!arena_blocks)
+		return;
+
+	blk = arena_blocks->next;
+	while (blk) {
+		next = blk->next;
+		XFREE(MTYPE_BGP_PARSE_ARENA, blk);
+		blk = next;
+	}
+
+	arena_blocks->next = NULL;
+	arena_blocks->used = 0;
+}
+
+void *bgp_parse_arena_alloc(size_t size)
+{
+	struct arena_block *blk = arena_blocks;
+	void *ptr;
+
+	if (arena_depth == 0)
+		return NULL;
+
+	/* Keep everything 8-byte aligned */
+	size = (size + 7) & ~(size_t)7;
+
+	if (!blk || blk->used + size > blk->size) {
+		blk = arena_block_new(MAX(size, ARENA_BLOCK_SIZE));
+		blk->next = arena_blocks;
+		arena_blocks = blk;
+	}
+
+	ptr = ARENA_BLOCK_DATA(blk) + blk->used;
+	blk->used += size;
+
+	return ptr;
+}
+
+bool bgp_parse_arena_owns(const void *ptr)
+{
+	const struct arena_block *blk;
+	const char *p = ptr;
+
+	for (blk = arena_blocks; blk; blk = blk->next) {
+		const char *base = ARENA_BLOCK_DATA(blk);
+
+		if (p >= base && p < base + blk->size)
+			return true;
+	}
+
+	return false;
+}
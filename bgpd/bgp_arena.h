@@ -0,0 +1,54 @@
+/* BGP per-burst parse arena.
+ * Copyright (C) 2019
+ *
+ * This file is part of FRRouting.
+ *
+ * FRRouting is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any later
+ * version.
+ *
+ * FRRouting is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_BGP_ARENA_H
+#define _FRR_BGP_ARENA_H
+
+#include <zebra.h>
+
+/*
+ * Bump allocator for transient structures built while parsing a burst
+ * of packets (aspath segments, community temporaries, ...).  The arena
+ * is armed around the packet-processing loop and recycled wholesale
+ * when the burst is done, so parse-time temporaries cost no individual
+ * malloc/free round trips.  Anything that outlives the burst -- i.e.
+ * objects inserted into one of the intern hashes -- must be promoted
+ * to regular heap storage first; bgp_parse_arena_owns() lets the
+ * interning code detect when that is needed.
+ *
+ * Main-thread only; worker pthreads may call bgp_parse_arena_owns()
+ * but never allocate.
+ */
+
+/* Arm the arena; may nest, allocations live until the outermost end */
+extern void bgp_parse_arena_begin(void);
+
+/* Disarm and recycle; all arena allocations die here */
+extern void bgp_parse_arena_end(void);
+
+/* Returns uninitialized memory, or NULL when no arena is armed
+ * (callers fall back to the heap).
+ */
+extern void *bgp_parse_arena_alloc(size_t size);
+
+/* True if ptr lies within the arena */
+extern bool bgp_parse_arena_owns(const void *ptr);
+
+#endif /* _FRR_BGP_ARENA_H */
@@ -36,6 +36,7 @@
 #include "bgpd/bgp_debug.h"
 #include "bgpd/bgp_attr.h"
 #include "bgpd/bgp_errors.h"
+#include "bgpd/bgp_arena.h"
 
 /* Attr. Flags and Attr. Type Code. */
 #define AS_HEADER_SIZE 2
@@ -99,6 +100,10 @@ static as_t *assegment_data_new(int num)
 
 static void assegment_data_free(as_t *asdata)
 {
+	/* burst-arena data is recycled wholesale when the burst ends */
+	if (bgp_parse_arena_owns(asdata))
+		return;
+
 	XFREE(MTYPE_AS_SEG_DATA, asdata);
 }
 
@@ -125,6 +130,28 @@ static struct assegment *assegment_new(uint8_t type, unsigned short length)
 	return new;
 }
 
+/* Parse-time variant of assegment_new: backed by the per-burst arena
+ * when one is armed, so short-lived segments cost no malloc/free.
+ */
+static struct assegment *assegment_parse_new(uint8_t type,
+					     unsigned short length)
+{
+	struct assegment *new;
+
+	new = bgp_parse_arena_alloc(sizeof(struct assegment));
+	if (!new)
+		return assegment_new(type, length);
+
+	memset(new, 0, sizeof(struct assegment));
+	if (length)
+		new->as = bgp_parse_arena_alloc(ASSEGMENT_DATA_SIZE(length, 1));
+
+	new->length = length;
+	new->type = type;
+
+	return new;
+}
+
 static void assegment_free(struct assegment *seg)
 {
 	if (!seg)
@@ -132,6 +159,8 @@ static void assegment_free(struct assegment *seg)
 
 	if (seg->as)
 		assegment_data_free(seg->as);
+	if (bgp_parse_arena_owns(seg))
+		return;
 	memset(seg, 0xfe, sizeof(struct assegment));
 	XFREE(MTYPE_AS_SEG, seg);
 
@@ -215,8 +244,14 @@ static struct assegment *assegment_append_asns(struct assegment *seg,
 	if (!seg)
 		return seg;
 
-	newas = XREALLOC(MTYPE_AS_SEG_DATA, seg->as,
-			 ASSEGMENT_DATA_SIZE(seg->length + num, 1));
+	if (bgp_parse_arena_owns(seg->as)) {
+		/* arena memory cannot be realloc'd; bump a fresh run */
+		newas = bgp_parse_arena_alloc(
+			ASSEGMENT_DATA_SIZE(seg->length + num, 1));
+		memcpy(newas, seg->as, ASSEGMENT_DATA_SIZE(seg->length, 1));
+	} else
+		newas = XREALLOC(MTYPE_AS_SEG_DATA, seg->as,
+				 ASSEGMENT_DATA_SIZE(seg->length + num, 1));
 
 	seg->as = newas;
 	memcpy(seg->as + seg->length, asnos,
@@ -305,6 +340,34 @@ static struct aspath *aspath_new(void)
 	return XCALLOC(MTYPE_AS_PATH, sizeof(struct aspath));
 }
 
+/* Build the packed ASN buffer for an aspath that is being interned;
+ * interned aspaths are immutable, so it never needs a rebuild.
+ */
+static void aspath_flat_build(struct aspath *aspath)
+{
+	struct assegment *seg;
+	unsigned int count = 0;
+	unsigned int i = 0;
+
+	if (aspath->flat)
+		return;
+
+	for (seg = aspath->segments; seg; seg = seg->next)
+		count += seg->length;
+
+	if (!count)
+		return;
+
+	aspath->flat = XMALLOC(MTYPE_AS_SEG_DATA, count * sizeof(uint32_t));
+	aspath->flat_count = count;
+
+	for (seg = aspath->segments; seg; seg = seg->next) {
+		memcpy(aspath->flat + i, seg->as,
+		       seg->length * sizeof(uint32_t));
+		i += seg->length;
+	}
+}
+
 /* Free AS path structure. */
 void aspath_free(struct aspath *aspath)
 {
@@ -313,6 +376,7 @@ void aspath_free(struct aspath *aspath)
 	if (aspath->segments)
 		assegment_free_all(aspath->segments);
 	XFREE(MTYPE_AS_STR, aspath->str);
+	XFREE(MTYPE_AS_SEG_DATA, aspath->flat);
 
 	if (aspath->json) {
 		json_object_free(aspath->json);
@@ -649,6 +713,8 @@ struct aspath *aspath_intern(struct aspath *aspath)
 
 	find->refcnt++;
 
+	aspath_flat_build(find);
+
 	return find;
 }
 
@@ -691,12 +757,21 @@ static void *aspath_hash_alloc(void *arg)
 	/* New aspath structure is needed. */
 	new = XMALLOC(MTYPE_AS_PATH, sizeof(struct aspath));
 
-	/* Reuse segments and string representation */
 	new->refcnt = 0;
-	new->segments = aspath->segments;
+
+	/* Reuse segments and string representation; segments living in
+	 * the parse arena must be promoted to the heap since the
+	 * interned aspath outlives the burst.
+	 */
+	if (aspath->segments && bgp_parse_arena_owns(aspath->segments))
+		new->segments = assegment_dup_all(aspath->segments);
+	else
+		new->segments = aspath->segments;
 	new->str = aspath->str;
 	new->str_len = aspath->str_len;
 	new->json = aspath->json;
+	new->flat = NULL;
+	new->flat_count = 0;
 
 	return new;
 }
@@ -773,7 +848,7 @@ static int assegments_parse(struct stream *s, size_t length,
 		}
 
 		/* now its safe to trust lengths */
-		seg = assegment_new(segh.type, segh.length);
+		seg = assegment_parse_new(segh.type, segh.length);
 
 		if (head)
 			prev->next = seg;
@@ -841,6 +916,8 @@ struct aspath *aspath_parse(struct stream *s, size_t length, int use32bit)
 
 	find->refcnt++;
 
+	aspath_flat_build(find);
+
 	return find;
 }
 
@@ -1149,6 +1226,17 @@ int aspath_loop_check(struct aspath *aspath, as_t asno)
 	if ((aspath == NULL) || (aspath->segments == NULL))
 		return 0;
 
+	/* Interned aspaths carry a packed copy of their ASNs; the
+	 * branch-free scan over contiguous memory vectorizes.
+	 */
+	if (aspath->flat) {
+		unsigned int i;
+
+		for (i = 0; i < aspath->flat_count; i++)
+			count += (aspath->flat[i] == asno);
+		return count;
+	}
+
 	seg = aspath->segments;
 
 	while (seg) {
@@ -71,6 +71,12 @@ struct aspath {
 	   and AS path regular expression match.  */
 	char *str;
 	unsigned short str_len;
+
+	/* Packed copy of all ASNs in segment order, built when the aspath
+	   is interned.  Hot scans (loop check) run over this contiguous
+	   buffer instead of chasing the segment list.  */
+	uint32_t *flat;
+	unsigned int flat_count;
 };
 
 #define ASPATH_STR_DEFAULT_LEN 32
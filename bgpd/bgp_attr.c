@@ -19,6 +19,7 @@
  */
 
 #include <zebra.h>
+#include <pthread.h>
 
 #include "linklist.h"
 #include "prefix.h"
@@ -462,8 +463,25 @@ static void transit_finish(void)
 	transit_hash = NULL;
 }
 
-/* Attribute hash routines. */
-static struct hash *attrhash;
+/* Attribute hash routines.
+ *
+ * The attribute hash is striped into independently locked tables so
+ * that worker pthreads (best-path selection today, UPDATE parsing on
+ * the I/O threads eventually) can intern and unintern attributes
+ * concurrently; an attribute only contends with others that fall into
+ * the same stripe.  The referenced aspath/community/etc. hashes are
+ * shared more widely and keep a single lock, which is taken and
+ * released separately so the two levels never nest.
+ */
+#define ATTRHASH_STRIPES 32
+
+static struct hash *attrhash[ATTRHASH_STRIPES];
+static pthread_mutex_t attrhash_mtx[ATTRHASH_STRIPES];
+
+static uint32_t attrhash_stripe(struct attr *attr)
+{
+	return attrhash_key_make(attr) & (ATTRHASH_STRIPES - 1);
+}
 
 /* Shallow copy of an attribute
  * Though, not so shallow that it doesn't copy the contents
@@ -476,7 +494,13 @@ void bgp_attr_dup(struct attr *new, struct attr *orig)
 
 unsigned long int attr_count(void)
 {
-	return attrhash->count;
+	unsigned long count = 0;
+	int i;
+
+	for (i = 0; i < ATTRHASH_STRIPES; i++)
+		count += attrhash[i]->count;
+
+	return count;
 }
 
 unsigned long int attr_unknown_count(void)
@@ -572,8 +596,13 @@ bool attrhash_cmp(const void *p1, const void *p2)
 
 static void attrhash_init(void)
 {
-	attrhash =
-		hash_create(attrhash_key_make, attrhash_cmp, "BGP Attributes");
+	int i;
+
+	for (i = 0; i < ATTRHASH_STRIPES; i++) {
+		attrhash[i] = hash_create(attrhash_key_make, attrhash_cmp,
+					  "BGP Attributes");
+		pthread_mutex_init(&attrhash_mtx[i], NULL);
+	}
 }
 
 /*
@@ -586,16 +615,21 @@ static void attr_vfree(void *attr)
 
 static void attrhash_finish(void)
 {
-	hash_clean(attrhash, attr_vfree);
-	hash_free(attrhash);
-	attrhash = NULL;
+	int i;
+
+	for (i = 0; i < ATTRHASH_STRIPES; i++) {
+		hash_clean(attrhash[i], attr_vfree);
+		hash_free(attrhash[i]);
+		attrhash[i] = NULL;
+		pthread_mutex_destroy(&attrhash_mtx[i]);
+	}
 }
 
 static void attr_show_all_iterator(struct hash_bucket *bucket, struct vty *vty)
 {
 	struct attr *attr = bucket->data;
 
-	vty_out(vty, "attr[%ld] nexthop %s\n", attr->refcnt,
+	vty_out(vty, "attr[%u] nexthop %s\n", (unsigned int)attr->refcnt,
 		inet_ntoa(attr->nexthop));
 	vty_out(vty, "\tflags: %" PRIu64 " med: %u local_pref: %u origin: %u weight: %u label: %u\n",
 		attr->flag, attr->med, attr->local_pref, attr->origin,
@@ -604,9 +638,13 @@ static void attr_show_all_iterator(struct hash_bucket *bucket, struct vty *vty)
 
 void attr_show_all(struct vty *vty)
 {
-	hash_iterate(attrhash, (void (*)(struct hash_bucket *,
-					 void *))attr_show_all_iterator,
-		     vty);
+	int i;
+
+	for (i = 0; i < ATTRHASH_STRIPES; i++)
+		hash_iterate(attrhash[i],
+			     (void (*)(struct hash_bucket *,
+				       void *))attr_show_all_iterator,
+			     vty);
 }
 
 static void *bgp_attr_hash_alloc(void *p)
@@ -629,9 +667,17 @@ static void *bgp_attr_hash_alloc(void *p)
 }
 
 /* Internet argument attribute. */
+/* Serializes updates to the referenced aspath/community/etc. hashes;
+ * taken on its own, never while holding a stripe lock.
+ */
+static pthread_mutex_t attr_subs_mtx = PTHREAD_MUTEX_INITIALIZER;
+
 struct attr *bgp_attr_intern(struct attr *attr)
 {
 	struct attr *find;
+	uint32_t stripe;
+
+	pthread_mutex_lock(&attr_subs_mtx);
 
 	/* Intern referenced strucutre. */
 	if (attr->aspath) {
@@ -688,14 +734,20 @@ struct attr *bgp_attr_intern(struct attr *attr)
 	}
 #endif
 
+	pthread_mutex_unlock(&attr_subs_mtx);
+
 	/* At this point, attr only contains intern'd pointers.  that means
 	 * if we find it in attrhash, it has all the same pointers and we
 	 * correctly updated the refcounts on these.
 	 * If we don't find it, we need to allocate a one because in all
 	 * cases this returns a new reference to a hashed attr, but the input
 	 * wasn't on hash. */
-	find = (struct attr *)hash_get(attrhash, attr, bgp_attr_hash_alloc);
+	stripe = attrhash_stripe(attr);
+	pthread_mutex_lock(&attrhash_mtx[stripe]);
+	find = (struct attr *)hash_get(attrhash[stripe], attr,
+				       bgp_attr_hash_alloc);
 	find->refcnt++;
+	pthread_mutex_unlock(&attrhash_mtx[stripe]);
 
 	return find;
 }
@@ -863,21 +915,30 @@ void bgp_attr_unintern(struct attr **pattr)
 	struct attr *attr = *pattr;
 	struct attr *ret;
 	struct attr tmp;
-
-	/* Decrement attribute reference. */
-	attr->refcnt--;
+	uint32_t stripe;
 
 	tmp = *attr;
 
-	/* If reference becomes zero then free attribute object. */
-	if (attr->refcnt == 0) {
-		ret = hash_release(attrhash, attr);
+	stripe = attrhash_stripe(attr);
+	pthread_mutex_lock(&attrhash_mtx[stripe]);
+
+	/* Decrement attribute reference; if it becomes zero then free
+	 * the attribute object.  The final decrement is done under the
+	 * stripe lock so it cannot race an intern of an equal attribute.
+	 */
+	if (atomic_fetch_sub_explicit(&attr->refcnt, 1, memory_order_acq_rel)
+	    == 1) {
+		ret = hash_release(attrhash[stripe], attr);
 		assert(ret != NULL);
 		XFREE(MTYPE_ATTR, attr);
 		*pattr = NULL;
 	}
 
+	pthread_mutex_unlock(&attrhash_mtx[stripe]);
+
+	pthread_mutex_lock(&attr_subs_mtx);
 	bgp_attr_unintern_sub(&tmp);
+	pthread_mutex_unlock(&attr_subs_mtx);
 }
 
 void bgp_attr_flush(struct attr *attr)
@@ -1051,6 +1112,41 @@ const uint8_t attr_flags_values[] = {
 };
 static const size_t attr_flags_values_max = array_size(attr_flags_values) - 1;
 
+/*
+ * Diagnostic-free version of the flag check in bgp_attr_flag_invalid(),
+ * suitable for the I/O pthread's pre-validation pass.  Unknown attribute
+ * types are reported as well-formed; the two must stay in agreement so
+ * that pre-validated packets can skip the main-thread check.
+ */
+bool bgp_attr_flags_wellformed(uint8_t attr_code, uint8_t flags)
+{
+	uint8_t mask = BGP_ATTR_FLAG_EXTLEN;
+
+	/* there may be attributes we don't know about */
+	if (attr_code > attr_flags_values_max)
+		return true;
+	if (attr_flags_values[attr_code] == 0)
+		return true;
+
+	if (!CHECK_FLAG(BGP_ATTR_FLAG_OPTIONAL, flags)
+	    && !CHECK_FLAG(BGP_ATTR_FLAG_TRANS, flags))
+		return false;
+
+	if (CHECK_FLAG(flags, BGP_ATTR_FLAG_PARTIAL)) {
+		if (!CHECK_FLAG(flags, BGP_ATTR_FLAG_OPTIONAL))
+			return false;
+		if (CHECK_FLAG(flags, BGP_ATTR_FLAG_OPTIONAL)
+		    && !CHECK_FLAG(flags, BGP_ATTR_FLAG_TRANS))
+			return false;
+	}
+
+	if (CHECK_FLAG(flags, BGP_ATTR_FLAG_OPTIONAL)
+	    && CHECK_FLAG(flags, BGP_ATTR_FLAG_TRANS))
+		SET_FLAG(mask, BGP_ATTR_FLAG_PARTIAL);
+
+	return (flags & ~mask) == attr_flags_values[attr_code];
+}
+
 static int bgp_attr_flag_invalid(struct bgp_attr_parser_args *args)
 {
 	uint8_t mask = BGP_ATTR_FLAG_EXTLEN;
@@ -2543,8 +2639,12 @@ bgp_attr_parse_ret_t bgp_attr_parse(struct peer *peer, struct attr *attr,
 		   with the Attribute Type Code, then the Error Subcode is set
 		   to
 		   Attribute Flags Error.  The Data field contains the erroneous
-		   attribute (type, length and value). */
-		if (bgp_attr_flag_invalid(&attr_args)) {
+		   attribute (type, length and value).
+
+		   Skipped when the I/O pthread already vetted the flag octets
+		   (bgp_update_prevalidate() uses the same table). */
+		if (!CHECK_FLAG(BGP_INPUT(peer)->flags, BGP_PACKET_PREVALIDATED)
+		    && bgp_attr_flag_invalid(&attr_args)) {
 			ret = bgp_attr_malformed(
 				&attr_args, BGP_NOTIFY_UPDATE_ATTR_FLAG_ERR,
 				attr_args.total);
@@ -22,6 +22,7 @@
 #define _QUAGGA_BGP_ATTR_H
 
 #include "mpls.h"
+#include "frratomic.h"
 #include "bgp_attr_evpn.h"
 
 /* Simple bit mapping. */
@@ -112,8 +113,11 @@ struct attr {
 	/* Community structure */
 	struct community *community;
 
-	/* Reference count of this attribute. */
-	unsigned long refcnt;
+	/* Reference count of this attribute; zero-transitions are
+	 * serialized by the owning hash stripe lock in bgp_attr.c, but
+	 * reads may be lock-free from other pthreads.
+	 */
+	_Atomic uint32_t refcnt;
 
 	/* Flag of attribute is set or not. */
 	uint64_t flag;
@@ -263,6 +267,7 @@ extern void bgp_attr_dup(struct attr *, struct attr *);
 extern void bgp_attr_undup(struct attr *new, struct attr *old);
 extern struct attr *bgp_attr_intern(struct attr *attr);
 extern void bgp_attr_unintern_sub(struct attr *);
+extern bool bgp_attr_flags_wellformed(uint8_t attr_code, uint8_t flags);
 extern void bgp_attr_unintern(struct attr **);
 extern void bgp_attr_flush(struct attr *);
 extern struct attr *bgp_attr_default_set(struct attr *attr, uint8_t);
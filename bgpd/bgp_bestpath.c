@@ -0,0 +1,279 @@
+/* BGP parallel best-path selection.
+ * Implements a pool of worker pthreads that run best-path selection
+ * for disjoint shards of queued route nodes; announcement of the
+ * results stays serialized on the main thread.
+ * Copyright (C) 2019
+ *
+ * This file is part of FRRouting.
+ *
+ * FRRouting is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any later
+ * version.
+ *
+ * FRRouting is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+#include <pthread.h>
+
+#include "frr_pthread.h"
+#include "memory.h"
+#include "prefix.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_memory.h"
+#include "bgpd/bgp_bestpath.h"
+
+/*
+ * The batch protocol is fork/join: the main thread buckets a batch of
+ * route nodes into one shard per worker under pool_mtx, broadcasts
+ * pool_work_cond, then sleeps on pool_done_cond until every shard has
+ * drained.  Because the main thread is parked for the whole window and
+ * each node lands in exactly one shard, workers only ever touch
+ * node-local state concurrently; the shared attribute hashes are
+ * covered by the intern/unintern locking in bgp_attr.c.
+ */
+struct bbp_shard {
+	void **items;
+	uint32_t count;
+};
+
+static pthread_mutex_t pool_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done_cond = PTHREAD_COND_INITIALIZER;
+
+static struct frr_pthread *pool_threads[BGP_BESTPATH_WORKERS_MAX];
+static struct bbp_shard pool_shards[BGP_BESTPATH_WORKERS_MAX];
+static uint32_t pool_nworkers;
+
+/* Batch in flight; all three are stable while any shard is full */
+static struct bgp *pool_bgp;
+static void (*pool_fn)(void *item);
+static uint32_t pool_pending;
+
+static void *bgp_bestpath_worker_start(void *arg)
+{
+	struct frr_pthread *fpt = arg;
+	struct bbp_shard *shard = fpt->data;
+	uint32_t i;
+
+	/*
+	 * Like the keepalive pthread, this is a plain condvar loop; we
+	 * are not using fpt_run and the fpt->master event loop.
+	 */
+	frr_pthread_set_name(fpt);
+	frr_pthread_notify_running(fpt);
+
+	pthread_mutex_lock(&pool_mtx);
+	while (atomic_load_explicit(&fpt->running, memory_order_relaxed)) {
+		if (shard->count == 0) {
+			pthread_cond_wait(&pool_work_cond, &pool_mtx);
+			continue;
+		}
+
+		pthread_mutex_unlock(&pool_mtx);
+
+		for (i = 0; i < shard->count; i++)
+			pool_fn(shard->items[i]);
+
+		pthread_mutex_lock(&pool_mtx);
+		shard->count = 0;
+		if (--pool_pending == 0)
+			pthread_cond_signal(&pool_done_cond);
+	}
+	pthread_mutex_unlock(&pool_mtx);
+
+	return NULL;
+}
+
+/* Hand the batch to the workers and block until every shard drained.
+ * 'sizes' gives the per-shard item counts; 'items' holds the shards
+ * back to back in shard order. */
+static void bgp_pool_dispatch(struct bgp *bgp, void **items, uint32_t *sizes,
+			      void (*fn)(void *item))
+{
+	uint32_t w, off;
+
+	pthread_mutex_lock(&pool_mtx);
+
+	pool_bgp = bgp;
+	pool_fn = fn;
+	pool_pending = 0;
+	off = 0;
+	for (w = 0; w < pool_nworkers; w++) {
+		pool_shards[w].items = items + off;
+		pool_shards[w].count = sizes[w];
+		off += sizes[w];
+		if (sizes[w])
+			pool_pending++;
+	}
+
+	pthread_cond_broadcast(&pool_work_cond);
+	while (pool_pending > 0)
+		pthread_cond_wait(&pool_done_cond, &pool_mtx);
+	pool_bgp = NULL;
+	pool_fn = NULL;
+
+	pthread_mutex_unlock(&pool_mtx);
+}
+
+/* Per-item work of bgp_bestpath_select() */
+static void bgp_bestpath_item_run(void *arg)
+{
+	struct bgp_bestpath_result *res = arg;
+	struct bgp_table *table = bgp_node_table(res->rn);
+
+	bgp_best_selection(pool_bgp, res->rn,
+			   &pool_bgp->maxpaths[table->afi][table->safi],
+			   &res->old_and_new, table->afi, table->safi);
+}
+
+static int bgp_bestpath_worker_stop(struct frr_pthread *fpt, void **result)
+{
+	atomic_store_explicit(&fpt->running, false, memory_order_relaxed);
+
+	pthread_mutex_lock(&pool_mtx);
+	pthread_cond_broadcast(&pool_work_cond);
+	pthread_mutex_unlock(&pool_mtx);
+
+	pthread_join(fpt->thread, result);
+	return 0;
+}
+
+static void bgp_bestpath_pool_stop(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < pool_nworkers; i++) {
+		frr_pthread_stop(pool_threads[i], NULL);
+		frr_pthread_destroy(pool_threads[i]);
+		pool_threads[i] = NULL;
+	}
+
+	pool_nworkers = 0;
+}
+
+void bgp_bestpath_pool_apply(void)
+{
+	struct frr_pthread_attr attr = {
+		.start = bgp_bestpath_worker_start,
+		.stop = bgp_bestpath_worker_stop,
+	};
+	char name[32], os_name[OS_THREAD_NAMELEN];
+	uint32_t want = bm->bestpath_workers;
+	uint32_t i;
+
+	/*
+	 * Workers may only be spawned once bgp_pthreads_run() has been
+	 * called (i.e. after the daemon forked); before that, config
+	 * read just records the count and we get re-applied later.
+	 */
+	if (!bgp_pth_io_pool[0]
+	    || !atomic_load_explicit(&bgp_pth_io_pool[0]->running,
+				     memory_order_relaxed))
+		return;
+
+	if (want == pool_nworkers)
+		return;
+
+	bgp_bestpath_pool_stop();
+
+	for (i = 0; i < want; i++) {
+		snprintf(name, sizeof(name), "BGP best-path worker %u", i);
+		snprintf(os_name, sizeof(os_name), "bgpd_bp%u", i);
+
+		pool_threads[i] = frr_pthread_new(&attr, name, os_name);
+		pool_threads[i]->data = &pool_shards[i];
+		frr_pthread_run(pool_threads[i], NULL);
+		frr_pthread_wait_running(pool_threads[i]);
+	}
+
+	pool_nworkers = want;
+}
+
+bool bgp_bestpath_pool_active(void)
+{
+	return pool_nworkers > 0;
+}
+
+void bgp_bestpath_select(struct bgp *bgp, struct bgp_bestpath_result *results,
+			 uint32_t count)
+{
+	uint32_t sizes[BGP_BESTPATH_WORKERS_MAX] = {0};
+	uint32_t cursor[BGP_BESTPATH_WORKERS_MAX];
+	void **items;
+	uint32_t i, w, off;
+
+	assert(pool_nworkers && count);
+
+	/* Bucket the nodes by prefix hash, one contiguous run per shard */
+	for (i = 0; i < count; i++)
+		sizes[prefix_hash_key(&results[i].rn->p) % pool_nworkers]++;
+
+	items = XMALLOC(MTYPE_BGP_PROCESS_QUEUE, count * sizeof(*items));
+
+	off = 0;
+	for (w = 0; w < pool_nworkers; w++) {
+		cursor[w] = off;
+		off += sizes[w];
+	}
+
+	for (i = 0; i < count; i++) {
+		w = prefix_hash_key(&results[i].rn->p) % pool_nworkers;
+		items[cursor[w]++] = &results[i];
+	}
+
+	bgp_best_selection_defer_reap = true;
+	bgp_pool_dispatch(bgp, items, sizes, bgp_bestpath_item_run);
+	bgp_best_selection_defer_reap = false;
+
+	/* Serial reap phase.  Reaping drops peer references, unlinks
+	 * from the shared nexthop cache and frees addpath state, none
+	 * of which is thread-safe, so the workers leave removed paths
+	 * in place and we collect them here, under the same rule
+	 * bgp_best_selection() applies: a removed path survives while
+	 * it is still the selected one.
+	 */
+	for (i = 0; i < count; i++) {
+		struct bgp_node *rn = results[i].rn;
+		struct bgp_path_info *pi, *next;
+
+		for (pi = bgp_node_get_bgp_path_info(rn); pi; pi = next) {
+			next = pi->next;
+			if (CHECK_FLAG(pi->flags, BGP_PATH_REMOVED)
+			    && pi != results[i].old_and_new.old)
+				bgp_path_info_reap(rn, pi);
+		}
+	}
+
+	XFREE(MTYPE_BGP_PROCESS_QUEUE, items);
+}
+
+/*
+ * Apply 'fn' to every item on the worker pool, split into contiguous
+ * chunks of roughly equal size.  Each item must be safe to process
+ * independently of every other item in the batch; blocks until done.
+ */
+void bgp_bestpath_pool_run(void **items, uint32_t count, void (*fn)(void *item))
+{
+	uint32_t sizes[BGP_BESTPATH_WORKERS_MAX] = {0};
+	uint32_t w;
+
+	assert(pool_nworkers && count);
+
+	for (w = 0; w < pool_nworkers; w++)
+		sizes[w] = count / pool_nworkers
+			   + (w < count % pool_nworkers ? 1 : 0);
+
+	bgp_pool_dispatch(NULL, items, sizes, fn);
+}
@@ -0,0 +1,68 @@
+/* BGP parallel best-path selection.
+ * Copyright (C) 2019
+ *
+ * This file is part of FRRouting.
+ *
+ * FRRouting is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any later
+ * version.
+ *
+ * FRRouting is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_BGP_BESTPATH_H
+#define _FRR_BGP_BESTPATH_H
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+
+/* Upper bound for 'bgp bestpath-workers'; must match the CLI range */
+#define BGP_BESTPATH_WORKERS_MAX 16
+
+/* Don't bother sharding batches smaller than this */
+#define BGP_BESTPATH_PARALLEL_MIN 64
+
+/*
+ * One queued node plus the selection outcome computed for it on a
+ * worker; the apply phase consumes old_and_new on the main thread.
+ */
+struct bgp_bestpath_result {
+	struct bgp_node *rn;
+	struct bgp_path_info_pair old_and_new;
+};
+
+/*
+ * Reconcile the worker pool with bm->bestpath_workers.  A no-op until
+ * bgp_pthreads_run() has started the daemon's pthreads.
+ */
+extern void bgp_bestpath_pool_apply(void);
+
+/* True if workers are up and bgp_bestpath_select() may be used */
+extern bool bgp_bestpath_pool_active(void);
+
+/*
+ * Run bgp_best_selection() for every node in 'results', sharded across
+ * the worker pool by prefix hash.  Blocks until all workers are done;
+ * the caller remains responsible for the serialized apply phase.
+ */
+extern void bgp_bestpath_select(struct bgp *bgp,
+				struct bgp_bestpath_result *results,
+				uint32_t count);
+
+/*
+ * Generic batch entry point: apply 'fn' to every item on the worker
+ * pool and block until done.  Items must be independently processable.
+ */
+extern void bgp_bestpath_pool_run(void **items, uint32_t count,
+				  void (*fn)(void *item));
+
+#endif /* _FRR_BGP_BESTPATH_H */
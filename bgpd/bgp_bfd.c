@@ -237,7 +237,7 @@ static void bgp_bfd_update_type(struct peer *peer)
 static int bgp_bfd_dest_replay(int command, struct zclient *client,
 			       zebra_size_t length, vrf_id_t vrf_id)
 {
-	struct listnode *mnode, *node, *nnode;
+	struct listnode *mnode;
 	struct bgp *bgp;
 	struct peer *peer;
 
@@ -250,7 +250,7 @@ static int bgp_bfd_dest_replay(int command, struct zclient *client,
 	/* Replay the peer, if BFD is enabled in BGP */
 
 	for (ALL_LIST_ELEMENTS_RO(bm->bgp, mnode, bgp))
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 			bgp_bfd_update_peer(peer);
 		}
 
@@ -316,12 +316,12 @@ static int bgp_bfd_dest_update(int command, struct zclient *zclient,
 
 	/* Bring the peer down if BFD is enabled in BGP */
 	{
-		struct listnode *mnode, *node, *nnode;
+		struct listnode *mnode;
 		struct bgp *bgp;
 		struct peer *peer;
 
 		for (ALL_LIST_ELEMENTS_RO(bm->bgp, mnode, bgp))
-			for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+			frr_each_safe (bgp_peers, &bgp->peer, peer) {
 				if (!peer->bfd_info)
 					continue;
 
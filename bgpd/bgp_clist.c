@@ -252,6 +252,11 @@ community_list_get(struct community_list_handler *ch, const char *name,
 	return list;
 }
 
+/* Bumped on any community-list configuration change; memoized match
+ * results from an older generation are ignored.
+ */
+static uint64_t clist_generation = 1;
+
 static void community_list_delete(struct community_list_master *cm,
 				  struct community_list *list)
 {
@@ -277,6 +282,8 @@ static void community_list_delete(struct community_list_master *cm,
 
 	hash_release(cm->hash, list);
 	community_list_free(list);
+
+	clist_generation++;
 }
 
 static int community_list_empty_p(struct community_list *list)
@@ -296,6 +303,8 @@ static void community_list_entry_add(struct community_list *list,
 	else
 		list->head = entry;
 	list->tail = entry;
+
+	clist_generation++;
 }
 
 /* Delete community-list entry from the list.  */
@@ -315,6 +324,8 @@ static void community_list_entry_delete(struct community_list_master *cm,
 
 	community_entry_free(entry);
 
+	clist_generation++;
+
 	if (community_list_empty_p(list))
 		community_list_delete(cm, list);
 }
@@ -649,7 +660,8 @@ community_regexp_delete (struct community *com, regex_t * reg)
 
 /* When given community attribute matches to the community-list return
    1 else return 0.  */
-int community_list_match(struct community *com, struct community_list *list)
+static int community_list_match_walk(struct community *com,
+				     struct community_list *list)
 {
 	struct community_entry *entry;
 
@@ -674,6 +686,27 @@ int community_list_match(struct community *com, struct community_list *list)
 	return 0;
 }
 
+int community_list_match(struct community *com, struct community_list *list)
+{
+	struct community_list_memo *memo;
+
+	/*
+	 * Communities are interned and shared across paths, so the same
+	 * (attr, list) pair is evaluated over and over - in particular the
+	 * regexec runs for expanded lists.  Memoize the verdict on the
+	 * community itself.
+	 */
+	memo = &com->memo[((uintptr_t)list >> 4) % COMMUNITY_LIST_MEMO_SIZE];
+	if (memo->list == list && memo->generation == clist_generation)
+		return memo->result;
+
+	memo->list = list;
+	memo->generation = clist_generation;
+	memo->result = community_list_match_walk(com, list);
+
+	return memo->result;
+}
+
 int lcommunity_list_match(struct lcommunity *lcom, struct community_list *list)
 {
 	struct community_entry *entry;
@@ -27,6 +27,7 @@
 
 #include "bgpd/bgp_memory.h"
 #include "bgpd/bgp_community.h"
+#include "bgpd/bgp_arena.h"
 
 /* Hash of community attribute. */
 static struct hash *comhash;
@@ -40,6 +41,12 @@ static struct community *community_new(void)
 /* Free communities value.  */
 void community_free(struct community **com)
 {
+	/* arena temporaries are recycled wholesale with the burst */
+	if (bgp_parse_arena_owns(*com)) {
+		*com = NULL;
+		return;
+	}
+
 	XFREE(MTYPE_COMMUNITY_VAL, (*com)->val);
 	XFREE(MTYPE_COMMUNITY_STR, (*com)->str);
 
@@ -63,6 +70,7 @@ static void community_add_val(struct community *com, uint32_t val)
 
 	val = htonl(val);
 	memcpy(com_lastval(com), &val, sizeof(uint32_t));
+	com->summary = 0;
 }
 
 /* Delete one community. */
@@ -91,6 +99,7 @@ void community_del_val(struct community *com, uint32_t *val)
 				XFREE(MTYPE_COMMUNITY_VAL, com->val);
 				com->val = NULL;
 			}
+			com->summary = 0;
 			return;
 		}
 		i++;
@@ -111,6 +120,21 @@ struct community *community_delete(struct community *com1,
 	return com1;
 }
 
+/* Membership-summary bit for one community value (host byte order). */
+static uint64_t community_summary_bit(uint32_t val)
+{
+	return 1ULL << ((val * 0x9e3779b9u) >> 26);
+}
+
+static void community_summary_build(struct community *com)
+{
+	int i;
+
+	com->summary = 0;
+	for (i = 0; i < com->size; i++)
+		com->summary |= community_summary_bit(community_val_get(com, i));
+}
+
 /* Callback function from qsort(). */
 static int community_compare(const void *a1, const void *a2)
 {
@@ -133,6 +157,9 @@ int community_include(struct community *com, uint32_t val)
 {
 	int i;
 
+	if (com->summary && !(com->summary & community_summary_bit(val)))
+		return 0;
+
 	val = htonl(val);
 
 	for (i = 0; i < com->size; i++)
@@ -180,6 +207,39 @@ struct community *community_uniq_sort(struct community *com)
 	return new;
 }
 
+/* Parse-time variant of community_uniq_sort: the scratch community and
+ * its value buffer live in the per-burst arena, sized up front from the
+ * raw attribute so deduplication needs no reallocation.
+ */
+static struct community *community_uniq_sort_parse(struct community *com)
+{
+	struct community *new;
+	uint32_t val;
+	int i;
+
+	new = bgp_parse_arena_alloc(sizeof(struct community));
+	if (!new)
+		return community_uniq_sort(com);
+
+	memset(new, 0, sizeof(struct community));
+	new->val = bgp_parse_arena_alloc(com->size * sizeof(uint32_t));
+
+	for (i = 0; i < com->size; i++) {
+		val = community_val_get(com, i);
+
+		if (community_include(new, val))
+			continue;
+
+		val = htonl(val);
+		memcpy(new->val + new->size, &val, sizeof(uint32_t));
+		new->size++;
+	}
+
+	qsort(new->val, new->size, sizeof(uint32_t), community_compare);
+
+	return new;
+}
+
 /* Convert communities attribute to string.
 
    For Well-known communities value, below keyword is used.
@@ -481,6 +541,19 @@ static void set_community_string(struct community *com, bool make_json)
 	com->str = str;
 }
 
+/* Promote an arena-backed parse temporary to the heap on a hash miss;
+ * heap temporaries are inserted as-is, like hash_alloc_intern.
+ */
+static void *community_hash_alloc(void *p)
+{
+	struct community *com = p;
+
+	if (bgp_parse_arena_owns(com))
+		return community_dup(com);
+
+	return com;
+}
+
 /* Intern communities attribute.  */
 struct community *community_intern(struct community *com)
 {
@@ -490,7 +563,7 @@ struct community *community_intern(struct community *com)
 	assert(com->refcnt == 0);
 
 	/* Lookup community hash. */
-	find = (struct community *)hash_get(comhash, com, hash_alloc_intern);
+	find = (struct community *)hash_get(comhash, com, community_hash_alloc);
 
 	/* Arguemnt com is allocated temporary.  So when it is not used in
 	   hash, it should be freed.  */
@@ -500,6 +573,9 @@ struct community *community_intern(struct community *com)
 	/* Increment refrence counter.  */
 	find->refcnt++;
 
+	if (!find->summary)
+		community_summary_build(find);
+
 	/* Make string.  */
 	if (!find->str)
 		set_community_string(find, false);
@@ -539,7 +615,7 @@ struct community *community_parse(uint32_t *pnt, unsigned short length)
 	tmp.size = length / 4;
 	tmp.val = pnt;
 
-	new = community_uniq_sort(&tmp);
+	new = community_uniq_sort_parse(&tmp);
 
 	return community_intern(new);
 }
@@ -595,6 +671,11 @@ int community_match(const struct community *com1, const struct community *com2)
 	if (com1->size < com2->size)
 		return 0;
 
+	/* A subset relation requires com2's summary bits on com1. */
+	if (com1->summary && com2->summary
+	    && (com1->summary & com2->summary) != com2->summary)
+		return 0;
+
 	/* Every community on com2 needs to be on com1 for this to match */
 	while (i < com1->size && j < com2->size) {
 		if (memcmp(com1->val + i, com2->val + j, sizeof(uint32_t)) == 0)
@@ -636,6 +717,7 @@ struct community *community_merge(struct community *com1,
 
 	memcpy(com1->val + com1->size, com2->val, com2->size * 4);
 	com1->size += com2->size;
+	com1->summary = 0;
 
 	return com1;
 }
@@ -25,6 +25,16 @@
 #include "bgpd/bgp_route.h"
 
 /* Communities attribute.  */
+/* Memoized community-list evaluation result; maintained by bgp_clist.c,
+   direct-mapped by list pointer and validated against the global
+   community-list configuration generation.  */
+struct community_list_memo {
+	const void *list;
+	uint64_t generation;
+	int result;
+};
+#define COMMUNITY_LIST_MEMO_SIZE 8
+
 struct community {
 	/* Reference count of communities value.  */
 	unsigned long refcnt;
@@ -41,6 +51,16 @@ struct community {
 	/* String of community attribute.  This sring is used by vty output
 	   and expanded community-list for regular expression match.  */
 	char *str;
+
+	/* 64-bit membership summary over the values, built when the
+	   community is interned: a value can only be present if its hashed
+	   bit is set, so non-matching include/match tests reject in O(1).
+	   0 means "not computed" and falls back to the full scan.  */
+	uint64_t summary;
+
+	/* Community-list match results for this (interned, shared) value;
+	   repeated policy evaluation becomes a table lookup.  */
+	struct community_list_memo memo[COMMUNITY_LIST_MEMO_SIZE];
 };
 
 /* Well-known communities value.  */
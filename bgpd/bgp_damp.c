@@ -45,6 +45,65 @@ static struct bgp_damp_config *damp = &bgp_damp_cfg;
 #define BGP_DAMP_LIST_ADD(N, A) BGP_PATH_INFO_ADD(N, A, no_reuse_list)
 #define BGP_DAMP_LIST_DEL(N, A) BGP_PATH_INFO_DEL(N, A, no_reuse_list)
 
+static int bgp_reuse_timer(struct thread *t);
+
+/* Damp info structures are pooled: a flap storm allocates and frees
+   tens of thousands of them, so they are carved out of slab chunks and
+   recycled through a free list instead of hitting the allocator per
+   flap.  The slabs are only returned once dampening is disabled (which
+   frees every damp info first).  */
+struct bgp_damp_pool_chunk {
+	struct bgp_damp_pool_chunk *next;
+	struct bgp_damp_info slots[BGP_DAMP_POOL_CHUNK];
+};
+
+static struct bgp_damp_pool_chunk *damp_pool_chunks;
+static struct bgp_damp_info *damp_pool_free; /* chained through ->next */
+
+static struct bgp_damp_info *bgp_damp_info_alloc(void)
+{
+	struct bgp_damp_info *bdi;
+
+	if (!damp_pool_free) {
+		struct bgp_damp_pool_chunk *chunk;
+		int i;
+
+		chunk = XCALLOC(MTYPE_BGP_DAMP_INFO, sizeof(*chunk));
+		chunk->next = damp_pool_chunks;
+		damp_pool_chunks = chunk;
+
+		for (i = 0; i < BGP_DAMP_POOL_CHUNK; i++) {
+			chunk->slots[i].next = damp_pool_free;
+			damp_pool_free = &chunk->slots[i];
+		}
+	}
+
+	bdi = damp_pool_free;
+	damp_pool_free = bdi->next;
+	memset(bdi, 0, sizeof(*bdi));
+
+	return bdi;
+}
+
+static void bgp_damp_info_release(struct bgp_damp_info *bdi)
+{
+	bdi->next = damp_pool_free;
+	damp_pool_free = bdi;
+}
+
+/* Hand all slabs back; only valid once every damp info is freed.  */
+static void bgp_damp_pool_drain(void)
+{
+	struct bgp_damp_pool_chunk *chunk, *next;
+
+	for (chunk = damp_pool_chunks; chunk; chunk = next) {
+		next = chunk->next;
+		XFREE(MTYPE_BGP_DAMP_INFO, chunk);
+	}
+	damp_pool_chunks = NULL;
+	damp_pool_free = NULL;
+}
+
 /* Calculate reuse list index by penalty value.  */
 static int bgp_reuse_index(int penalty)
 {
@@ -74,6 +133,13 @@ static void bgp_reuse_list_add(struct bgp_damp_info *bdi)
 	if (damp->reuse_list[index])
 		damp->reuse_list[index]->prev = bdi;
 	damp->reuse_list[index] = bdi;
+
+	/* Restart the reuse timer when the lists go non-empty; it
+	   stops itself once they drain, so an idle router pays nothing
+	   for having dampening configured.  */
+	if (damp->reuse_count++ == 0 && !damp->t_reuse)
+		thread_add_timer(bm->master, bgp_reuse_timer, NULL, DELTA_REUSE,
+				 &damp->t_reuse);
 }
 
 /* Delete BGP dampening information from reuse list.  */
@@ -85,6 +151,8 @@ static void bgp_reuse_list_delete(struct bgp_damp_info *bdi)
 		bdi->prev->next = bdi->next;
 	else
 		damp->reuse_list[bdi->index] = bdi->next;
+
+	damp->reuse_count--;
 }
 
 /* Return decayed penalty value.  */
@@ -112,8 +180,6 @@ static int bgp_reuse_timer(struct thread *t)
 	time_t t_now, t_diff;
 
 	damp->t_reuse = NULL;
-	thread_add_timer(bm->master, bgp_reuse_timer, NULL, DELTA_REUSE,
-			 &damp->t_reuse);
 
 	t_now = bgp_clock();
 
@@ -132,6 +198,10 @@ static int bgp_reuse_timer(struct thread *t)
 
 		next = bdi->next;
 
+		/* Off its reuse list now; re-insertion below counts it
+		   again.  */
+		damp->reuse_count--;
+
 		/* Set t-diff = t-now - t-updated.  */
 		t_diff = t_now - bdi->t_updated;
 
@@ -168,6 +238,11 @@ static int bgp_reuse_timer(struct thread *t)
 			bgp_reuse_list_add(bdi);
 	}
 
+	/* Only keep ticking while something is waiting to be reused. */
+	if (damp->reuse_count && !damp->t_reuse)
+		thread_add_timer(bm->master, bgp_reuse_timer, NULL, DELTA_REUSE,
+				 &damp->t_reuse);
+
 	return 0;
 }
 
@@ -193,8 +268,7 @@ int bgp_damp_withdraw(struct bgp_path_info *path, struct bgp_node *rn,
 		   2. set figure-of-merit = 1.
 		   3. withdraw the route.  */
 
-		bdi = XCALLOC(MTYPE_BGP_DAMP_INFO,
-			      sizeof(struct bgp_damp_info));
+		bdi = bgp_damp_info_alloc();
 		bdi->path = path;
 		bdi->rn = rn;
 		bdi->penalty =
@@ -354,7 +428,7 @@ void bgp_damp_info_free(struct bgp_damp_info *bdi, int withdraw)
 	if (bdi->lastrecord == BGP_RECORD_WITHDRAW && withdraw)
 		bgp_path_info_delete(bdi->rn, path);
 
-	XFREE(MTYPE_BGP_DAMP_INFO, bdi);
+	bgp_damp_info_release(bdi);
 }
 
 static void bgp_damp_parameter_set(int hlife, int reuse, int sup, int maxsup)
@@ -437,9 +511,8 @@ int bgp_damp_enable(struct bgp *bgp, afi_t afi, safi_t safi, time_t half,
 	SET_FLAG(bgp->af_flags[afi][safi], BGP_CONFIG_DAMPENING);
 	bgp_damp_parameter_set(half, reuse, suppress, max);
 
-	/* Register reuse timer.  */
-	thread_add_timer(bm->master, bgp_reuse_timer, NULL, DELTA_REUSE,
-			 &damp->t_reuse);
+	/* The reuse timer is started by the first reuse list
+	   insertion; nothing to do until a route actually flaps.  */
 
 	return 0;
 }
@@ -499,6 +572,9 @@ int bgp_damp_disable(struct bgp *bgp, afi_t afi, safi_t safi)
 	/* Clean BGP dampening information.  */
 	bgp_damp_info_clean();
 
+	/* Every damp info is free now; hand the slabs back too. */
+	bgp_damp_pool_drain();
+
 	/* Clear configuration */
 	bgp_damp_config_clean(&bgp_damp_cfg);
 
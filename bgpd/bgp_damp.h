@@ -101,6 +101,10 @@ struct bgp_damp_config {
 	struct bgp_damp_info **reuse_list;
 	int reuse_offset;
 
+	/* Number of entries currently on the reuse lists; the reuse
+	   timer only runs while this is non-zero.  */
+	unsigned int reuse_count;
+
 	/* All dampening information which is not on reuse list.  */
 	struct bgp_damp_info *no_reuse_list;
 
@@ -127,6 +131,9 @@ struct bgp_damp_config {
 #define REUSE_LIST_SIZE          256
 #define REUSE_ARRAY_SIZE        1024
 
+/* Damp infos per pool slab; MTYPE_BGP_DAMP_INFO is accounted in slabs. */
+#define BGP_DAMP_POOL_CHUNK      256
+
 extern int bgp_damp_enable(struct bgp *, afi_t, safi_t, time_t, unsigned int,
 			   unsigned int, time_t);
 extern int bgp_damp_disable(struct bgp *, afi_t, safi_t);
@@ -19,6 +19,7 @@
  */
 
 #include <zebra.h>
+#include <pthread.h>
 
 #include "log.h"
 #include "stream.h"
@@ -30,6 +31,8 @@
 #include "queue.h"
 #include "memory.h"
 #include "filter.h"
+#include "frr_pthread.h"
+#include "ringbuf.h"
 
 #include "bgpd/bgp_table.h"
 #include "bgpd/bgpd.h"
@@ -101,6 +104,182 @@ struct bgp_dump bgp_dump_updates;
 /* BGP dump structure for 'dump bgp routes' */
 struct bgp_dump bgp_dump_routes;
 
+/* MRT records are still formatted on the main thread (into
+ * bgp_dump_obuf, as always), but the blocking file I/O is done by a
+ * dedicated dump pthread: finished records are pushed through a byte
+ * ring which the pthread drains, fflushing once the ring runs empty.
+ * The mutex covers both the ring and the dumps' FILE pointers.
+ */
+static pthread_mutex_t bgp_dump_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bgp_dump_cond = PTHREAD_COND_INITIALIZER;
+static struct ringbuf *bgp_dump_ring;
+
+/* Each ring message is this header followed by `len' bytes of MRT
+ * record.  len == 0 is a sentinel asking the dump pthread to close the
+ * dump's file once everything queued ahead of it has been written. */
+struct bgp_dump_msg {
+	struct bgp_dump *bd;
+	uint32_t len;
+};
+
+#define BGP_DUMP_RING_SIZE (4 * 1024 * 1024)
+
+/* Largest possible single record; matches the bgp_dump_obuf size. */
+#define BGP_DUMP_RECORD_MAX                                                    \
+	((BGP_MAX_PACKET_SIZE << 1) + BGP_DUMP_MSG_HEADER                      \
+	 + BGP_DUMP_HEADER_SIZE)
+
+/* Hand a finished record over to the dump pthread.  If the ring is
+ * full (or the pthread never came up), write synchronously rather than
+ * dropping the record.  Caller needs not hold the mutex. */
+static void bgp_dump_write(struct bgp_dump *bgp_dump, struct stream *obuf)
+{
+	struct bgp_dump_msg msg;
+
+	msg.bd = bgp_dump;
+	msg.len = stream_get_endp(obuf);
+
+	pthread_mutex_lock(&bgp_dump_mtx);
+	{
+		if (bgp_dump->fp == NULL) {
+			pthread_mutex_unlock(&bgp_dump_mtx);
+			return;
+		}
+
+		if (bgp_dump_ring
+		    && ringbuf_space(bgp_dump_ring) >= sizeof(msg) + msg.len) {
+			ringbuf_put(bgp_dump_ring, &msg, sizeof(msg));
+			ringbuf_put(bgp_dump_ring, STREAM_DATA(obuf), msg.len);
+			pthread_cond_signal(&bgp_dump_cond);
+		} else {
+			fwrite(STREAM_DATA(obuf), msg.len, 1, bgp_dump->fp);
+			fflush(bgp_dump->fp);
+		}
+	}
+	pthread_mutex_unlock(&bgp_dump_mtx);
+}
+
+/* Ask the dump pthread to close the file behind any queued records. */
+static void bgp_dump_close_async(struct bgp_dump *bgp_dump)
+{
+	struct bgp_dump_msg msg;
+
+	msg.bd = bgp_dump;
+	msg.len = 0;
+
+	pthread_mutex_lock(&bgp_dump_mtx);
+	{
+		if (bgp_dump->fp) {
+			if (bgp_dump_ring
+			    && ringbuf_space(bgp_dump_ring) >= sizeof(msg)) {
+				ringbuf_put(bgp_dump_ring, &msg, sizeof(msg));
+				pthread_cond_signal(&bgp_dump_cond);
+			} else {
+				fclose(bgp_dump->fp);
+				bgp_dump->fp = NULL;
+			}
+		}
+	}
+	pthread_mutex_unlock(&bgp_dump_mtx);
+}
+
+/* Write out one queued record.  Must hold the mutex; returns false if
+ * the ring held no complete message. */
+static bool bgp_dump_drain_one(uint8_t *buf)
+{
+	struct bgp_dump_msg msg;
+
+	if (!bgp_dump_ring
+	    || ringbuf_remain(bgp_dump_ring) < sizeof(msg))
+		return false;
+
+	ringbuf_get(bgp_dump_ring, &msg, sizeof(msg));
+	if (msg.len)
+		ringbuf_get(bgp_dump_ring, buf, msg.len);
+
+	if (msg.bd->fp == NULL)
+		return true;
+
+	if (msg.len == 0) {
+		fclose(msg.bd->fp);
+		msg.bd->fp = NULL;
+	} else
+		fwrite(buf, msg.len, 1, msg.bd->fp);
+
+	return true;
+}
+
+/* Flush whatever the dump pthread has written so far.  Must hold the
+ * mutex. */
+static void bgp_dump_flush_files(void)
+{
+	if (bgp_dump_all.fp)
+		fflush(bgp_dump_all.fp);
+	if (bgp_dump_updates.fp)
+		fflush(bgp_dump_updates.fp);
+	if (bgp_dump_routes.fp)
+		fflush(bgp_dump_routes.fp);
+}
+
+/* Entry function for the MRT dump pthread. */
+void *bgp_dump_pthread_start(void *arg)
+{
+	struct frr_pthread *fpt = arg;
+	uint8_t *buf;
+
+	fpt->master->owner = pthread_self();
+
+	/*
+	 * We are not using normal FRR pthread mechanics and are
+	 * not using fpt_run
+	 */
+	frr_pthread_set_name(fpt);
+
+	buf = XMALLOC(MTYPE_TMP, BGP_DUMP_RECORD_MAX);
+
+	pthread_mutex_lock(&bgp_dump_mtx);
+	bgp_dump_ring = ringbuf_new(BGP_DUMP_RING_SIZE);
+
+	/* notify anybody waiting on us that we are done starting up */
+	frr_pthread_notify_running(fpt);
+
+	while (atomic_load_explicit(&fpt->running, memory_order_relaxed)) {
+		if (!bgp_dump_drain_one(buf)) {
+			/* Ring is empty: push everything written so far
+			 * out to disk before going to sleep. */
+			bgp_dump_flush_files();
+			pthread_cond_wait(&bgp_dump_cond, &bgp_dump_mtx);
+		}
+	}
+
+	/* Drain the remainder so no records are lost on shutdown. */
+	while (bgp_dump_drain_one(buf))
+		;
+	bgp_dump_flush_files();
+
+	ringbuf_del(bgp_dump_ring);
+	bgp_dump_ring = NULL;
+	pthread_mutex_unlock(&bgp_dump_mtx);
+
+	XFREE(MTYPE_TMP, buf);
+
+	return NULL;
+}
+
+int bgp_dump_pthread_stop(struct frr_pthread *fpt, void **result)
+{
+	assert(fpt->running);
+
+	atomic_store_explicit(&fpt->running, false, memory_order_relaxed);
+
+	pthread_mutex_lock(&bgp_dump_mtx);
+	pthread_cond_signal(&bgp_dump_cond);
+	pthread_mutex_unlock(&bgp_dump_mtx);
+
+	pthread_join(fpt->thread, result);
+	return 0;
+}
+
 static FILE *bgp_dump_open_file(struct bgp_dump *bgp_dump)
 {
 	int ret;
@@ -124,12 +303,17 @@ static FILE *bgp_dump_open_file(struct bgp_dump *bgp_dump)
 		return NULL;
 	}
 
-	if (bgp_dump->fp)
-		fclose(bgp_dump->fp);
+	oldumask = umask(0777 & ~LOGFILE_MASK);
 
+	/* The dump pthread may be writing to the old file right now. */
+	pthread_mutex_lock(&bgp_dump_mtx);
+	{
+		if (bgp_dump->fp)
+			fclose(bgp_dump->fp);
 
-	oldumask = umask(0777 & ~LOGFILE_MASK);
-	bgp_dump->fp = fopen(realpath, "w");
+		bgp_dump->fp = fopen(realpath, "w");
+	}
+	pthread_mutex_unlock(&bgp_dump_mtx);
 
 	if (bgp_dump->fp == NULL) {
 		flog_warn(EC_BGP_DUMP, "bgp_dump_open_file: %s: %s", realpath,
@@ -218,7 +402,6 @@ static void bgp_dump_set_size(struct stream *s, int type)
 static void bgp_dump_routes_index_table(struct bgp *bgp)
 {
 	struct peer *peer;
-	struct listnode *node;
 	uint16_t peerno = 1;
 	struct stream *obuf;
 
@@ -241,7 +424,7 @@ static void bgp_dump_routes_index_table(struct bgp *bgp)
 	}
 
 	/* Peer count ( plus one extra internal peer ) */
-	stream_putw(obuf, listcount(bgp->peer) + 1);
+	stream_putw(obuf, bgp_peers_count(&bgp->peer) + 1);
 
 	/* Populate fake peer at index 0, for locally originated routes */
 	/* Peer type (IPv4) */
@@ -256,7 +439,7 @@ static void bgp_dump_routes_index_table(struct bgp *bgp)
 	stream_putl(obuf, 0);
 
 	/* Walk down all peers */
-	for (ALL_LIST_ELEMENTS_RO(bgp->peer, node, peer)) {
+	frr_each (bgp_peers, &bgp->peer, peer) {
 
 		/* Peer's type */
 		if (sockunion_family(&peer->su) == AF_INET) {
@@ -294,8 +477,7 @@ static void bgp_dump_routes_index_table(struct bgp *bgp)
 
 	bgp_dump_set_size(obuf, MSG_TABLE_DUMP_V2);
 
-	fwrite(STREAM_DATA(obuf), stream_get_endp(obuf), 1, bgp_dump_routes.fp);
-	fflush(bgp_dump_routes.fp);
+	bgp_dump_write(&bgp_dump_routes, obuf);
 }
 
 
@@ -377,49 +559,104 @@ bgp_dump_route_node_record(int afi, struct bgp_node *rn,
 	stream_putw_at(obuf, sizep, entry_count);
 
 	bgp_dump_set_size(obuf, MSG_TABLE_DUMP_V2);
-	fwrite(STREAM_DATA(obuf), stream_get_endp(obuf), 1, bgp_dump_routes.fp);
+	bgp_dump_write(&bgp_dump_routes, obuf);
 
 	return path;
 }
 
 
-/* Runs under child process. */
-static unsigned int bgp_dump_routes_func(int afi, int first_run,
-					 unsigned int seq)
+/* A RIB dump no longer serializes the whole table inside the interval
+ * callback - at full-table scale that stalled the main thread for
+ * seconds.  Instead the interval callback pins a snapshot of the table
+ * (the walk array locks every node) and an event callback then records
+ * a bounded chunk of it at a time, so bgp_process and peer I/O keep
+ * running in between.  File writes go through the dump pthread like
+ * every other record.
+ */
+#define BGP_DUMP_ROUTES_CHUNK 4096
+
+static struct {
+	afi_t afi;
+	unsigned int seq;
+	struct bgp_table *table; /* locked while the walk is held */
+	struct bgp_node **nodes;
+	unsigned int count;
+	unsigned int pos;
+	struct thread *t_chunk;
+} bgp_dump_rib;
+
+static int bgp_dump_routes_chunk(struct thread *);
+
+static void bgp_dump_rib_walk_start(struct bgp *bgp, afi_t afi)
 {
+	bgp_dump_rib.afi = afi;
+	bgp_dump_rib.table = bgp->rib[afi][SAFI_UNICAST];
+	bgp_table_lock(bgp_dump_rib.table);
+	bgp_dump_rib.nodes = bgp_table_walk_acquire(bgp_dump_rib.table,
+						    &bgp_dump_rib.count);
+	bgp_dump_rib.pos = 0;
+
+	bgp_dump_rib.t_chunk = NULL;
+	thread_add_event(bm->master, bgp_dump_routes_chunk, NULL, 0,
+			 &bgp_dump_rib.t_chunk);
+}
+
+static void bgp_dump_rib_walk_end(void)
+{
+	bgp_table_walk_release(bgp_dump_rib.table);
+	bgp_table_unlock(bgp_dump_rib.table);
+	bgp_dump_rib.table = NULL;
+	bgp_dump_rib.nodes = NULL;
+}
+
+static int bgp_dump_routes_chunk(struct thread *t)
+{
+	unsigned int budget = BGP_DUMP_ROUTES_CHUNK;
 	struct bgp_path_info *path;
 	struct bgp_node *rn;
 	struct bgp *bgp;
-	struct bgp_table *table;
-
-	bgp = bgp_get_default();
-	if (!bgp)
-		return seq;
 
-	if (bgp_dump_routes.fp == NULL)
-		return seq;
+	bgp_dump_rib.t_chunk = NULL;
 
-	/* Note that bgp_dump_routes_index_table will do ipv4 and ipv6 peers,
-	   so this should only be done on the first call to
-	   bgp_dump_routes_func.
-	   ( this function will be called once for ipv4 and once for ipv6 ) */
-	if (first_run)
-		bgp_dump_routes_index_table(bgp);
+	/* "no dump" or an open failure while the walk was under way. */
+	if (bgp_dump_routes.fp == NULL) {
+		bgp_dump_rib_walk_end();
+		return 0;
+	}
 
-	/* Walk down each BGP route. */
-	table = bgp->rib[afi][SAFI_UNICAST];
+	while (budget && bgp_dump_rib.pos < bgp_dump_rib.count) {
+		rn = bgp_table_walk_next(bgp_dump_rib.nodes,
+					 bgp_dump_rib.count, bgp_dump_rib.pos);
+		bgp_dump_rib.pos++;
+		budget--;
 
-	for (rn = bgp_table_top(table); rn; rn = bgp_route_next(rn)) {
 		path = bgp_node_get_bgp_path_info(rn);
 		while (path) {
-			path = bgp_dump_route_node_record(afi, rn, path, seq);
-			seq++;
+			path = bgp_dump_route_node_record(
+				bgp_dump_rib.afi, rn, path, bgp_dump_rib.seq);
+			bgp_dump_rib.seq++;
 		}
 	}
 
-	fflush(bgp_dump_routes.fp);
+	if (bgp_dump_rib.pos < bgp_dump_rib.count) {
+		thread_add_event(bm->master, bgp_dump_routes_chunk, NULL, 0,
+				 &bgp_dump_rib.t_chunk);
+		return 0;
+	}
+
+	bgp_dump_rib_walk_end();
 
-	return seq;
+	bgp = bgp_get_default();
+	if (bgp_dump_rib.afi == AFI_IP && bgp) {
+		bgp_dump_rib_walk_start(bgp, AFI_IP6);
+		return 0;
+	}
+
+	/* Whole RIB dumped.  For a RIB dump there's no point in leaving
+	 * the file open until the next scheduled dump starts; let the
+	 * dump pthread close it behind the queued records. */
+	bgp_dump_close_async(&bgp_dump_routes);
+	return 0;
 }
 
 static int bgp_dump_interval_func(struct thread *t)
@@ -433,13 +670,17 @@ static int bgp_dump_interval_func(struct thread *t)
 		/* In case of bgp_dump_routes, we need special route dump
 		 * function. */
 		if (bgp_dump->type == BGP_DUMP_ROUTES) {
-			unsigned int seq = bgp_dump_routes_func(AFI_IP, 1, 0);
-			bgp_dump_routes_func(AFI_IP6, 0, seq);
-			/* Close the file now. For a RIB dump there's no point
-			 * in leaving
-			 * it open until the next scheduled dump starts. */
-			fclose(bgp_dump->fp);
-			bgp_dump->fp = NULL;
+			struct bgp *bgp = bgp_get_default();
+
+			/* Don't start over if the previous dump is
+			 * still being chunked out - it will finish into
+			 * the file just opened and close it. */
+			if (bgp && !bgp_dump_rib.table) {
+				bgp_dump_routes_index_table(bgp);
+				bgp_dump_rib.seq = 0;
+				bgp_dump_rib_walk_start(bgp, AFI_IP);
+			} else if (!bgp)
+				bgp_dump_close_async(bgp_dump);
 		}
 	}
 
@@ -515,9 +756,8 @@ void bgp_dump_state(struct peer *peer, int status_old, int status_new)
 	/* Set length. */
 	bgp_dump_set_size(obuf, MSG_PROTOCOL_BGP4MP);
 
-	/* Write to the stream. */
-	fwrite(STREAM_DATA(obuf), stream_get_endp(obuf), 1, bgp_dump_all.fp);
-	fflush(bgp_dump_all.fp);
+	/* Hand over to the dump pthread. */
+	bgp_dump_write(&bgp_dump_all, obuf);
 }
 
 static void bgp_dump_packet_func(struct bgp_dump *bgp_dump, struct peer *peer,
@@ -549,9 +789,8 @@ static void bgp_dump_packet_func(struct bgp_dump *bgp_dump, struct peer *peer,
 	/* Set length. */
 	bgp_dump_set_size(obuf, MSG_PROTOCOL_BGP4MP);
 
-	/* Write to the stream. */
-	fwrite(STREAM_DATA(obuf), stream_get_endp(obuf), 1, bgp_dump->fp);
-	fflush(bgp_dump->fp);
+	/* Hand over to the dump pthread. */
+	bgp_dump_write(bgp_dump, obuf);
 }
 
 /* Called from bgp_packet.c when BGP packet is received. */
@@ -668,11 +907,24 @@ static int bgp_dump_unset(struct bgp_dump *bgp_dump)
 		bgp_dump->filename = NULL;
 	}
 
-	/* Closing file. */
-	if (bgp_dump->fp) {
-		fclose(bgp_dump->fp);
-		bgp_dump->fp = NULL;
+	/* Cancel an in-progress chunked RIB dump. */
+	if (bgp_dump == &bgp_dump_routes && bgp_dump_rib.table) {
+		if (bgp_dump_rib.t_chunk) {
+			thread_cancel(bgp_dump_rib.t_chunk);
+			bgp_dump_rib.t_chunk = NULL;
+		}
+		bgp_dump_rib_walk_end();
+	}
+
+	/* Closing file.  The dump pthread may be mid-write to it. */
+	pthread_mutex_lock(&bgp_dump_mtx);
+	{
+		if (bgp_dump->fp) {
+			fclose(bgp_dump->fp);
+			bgp_dump->fp = NULL;
+		}
 	}
+	pthread_mutex_unlock(&bgp_dump_mtx);
 
 	/* Removing interval thread. */
 	if (bgp_dump->t_interval) {
@@ -49,9 +49,15 @@
 #define TABLE_DUMP_V2_PEER_INDEX_TABLE_AS2 0
 #define TABLE_DUMP_V2_PEER_INDEX_TABLE_AS4 2
 
+struct frr_pthread;
+
 extern void bgp_dump_init(void);
 extern void bgp_dump_finish(void);
 extern void bgp_dump_state(struct peer *, int, int);
 extern void bgp_dump_packet(struct peer *, int, struct stream *);
 
+/* MRT dump pthread lifecycle, driven from bgp_pthreads_run()/_finish() */
+extern void *bgp_dump_pthread_start(void *arg);
+extern int bgp_dump_pthread_stop(struct frr_pthread *fpt, void **result);
+
 #endif /* _QUAGGA_BGP_DUMP_H */
@@ -70,6 +70,27 @@ static void ecommunity_hash_free(struct ecommunity *ecom)
 }
 
 
+/* Membership-summary bit for one extended community value. */
+static uint64_t ecommunity_summary_bit(const uint8_t *p)
+{
+	uint32_t hi, lo;
+
+	memcpy(&hi, p, sizeof(uint32_t));
+	memcpy(&lo, p + sizeof(uint32_t), sizeof(uint32_t));
+
+	return 1ULL << (((hi * 0x9e3779b9u) ^ lo) >> 26);
+}
+
+static void ecommunity_summary_build(struct ecommunity *ecom)
+{
+	int i;
+
+	ecom->summary = 0;
+	for (i = 0; i < ecom->size; i++)
+		ecom->summary |= ecommunity_summary_bit(
+			ecom->val + i * ECOMMUNITY_SIZE);
+}
+
 /* Add a new Extended Communities value to Extended Communities
    Attribute structure.  When the value is already exists in the
    structure, we don't add the value.  Newly added value is sorted by
@@ -86,6 +107,7 @@ int ecommunity_add_val(struct ecommunity *ecom, struct ecommunity_val *eval)
 		ecom->size++;
 		ecom->val = XMALLOC(MTYPE_ECOMMUNITY_VAL, ecom_length(ecom));
 		memcpy(ecom->val, eval->val, ECOMMUNITY_SIZE);
+		ecom->summary = 0;
 		return 1;
 	}
 
@@ -108,6 +130,7 @@ int ecommunity_add_val(struct ecommunity *ecom, struct ecommunity_val *eval)
 		ecom->val + c * ECOMMUNITY_SIZE,
 		(ecom->size - 1 - c) * ECOMMUNITY_SIZE);
 	memcpy(ecom->val + c * ECOMMUNITY_SIZE, eval->val, ECOMMUNITY_SIZE);
+	ecom->summary = 0;
 
 	return 1;
 }
@@ -197,6 +220,7 @@ struct ecommunity *ecommunity_merge(struct ecommunity *ecom1,
 	memcpy(ecom1->val + (ecom1->size * ECOMMUNITY_SIZE), ecom2->val,
 	       ecom2->size * ECOMMUNITY_SIZE);
 	ecom1->size += ecom2->size;
+	ecom1->summary = 0;
 
 	return ecom1;
 }
@@ -215,6 +239,9 @@ struct ecommunity *ecommunity_intern(struct ecommunity *ecom)
 
 	find->refcnt++;
 
+	if (!find->summary)
+		ecommunity_summary_build(find);
+
 	if (!find->str)
 		find->str =
 			ecommunity_ecom2str(find, ECOMMUNITY_FORMAT_DISPLAY, 0);
@@ -866,6 +893,11 @@ int ecommunity_match(const struct ecommunity *ecom1,
 	if (ecom1->size < ecom2->size)
 		return 0;
 
+	/* A subset relation requires ecom2's summary bits on ecom1. */
+	if (ecom1->summary && ecom2->summary
+	    && (ecom1->summary & ecom2->summary) != ecom2->summary)
+		return 0;
+
 	/* Every community on com2 needs to be on com1 for this to match */
 	while (i < ecom1->size && j < ecom2->size) {
 		if (memcmp(ecom1->val + i * ECOMMUNITY_SIZE,
@@ -972,6 +1004,7 @@ int ecommunity_del_val(struct ecommunity *ecom, struct ecommunity_val *eval)
 		       (ecom->size - c) * ECOMMUNITY_SIZE);
 	XFREE(MTYPE_ECOMMUNITY_VAL, ecom->val);
 	ecom->val = p;
+	ecom->summary = 0;
 	return 1;
 }
 
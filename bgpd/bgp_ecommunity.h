@@ -87,6 +87,10 @@ struct ecommunity {
 
 	/* Human readable format string.  */
 	char *str;
+
+	/* 64-bit membership summary over the values, built at intern time;
+	   lets non-matching subset tests reject in O(1).  0 = not computed. */
+	uint64_t summary;
 };
 
 struct ecommunity_as {
@@ -536,6 +536,53 @@ static void evpn_convert_nexthop_to_ipv6(struct attr *attr)
 	attr->mp_nexthop_len = IPV6_MAX_BYTELEN;
 }
 
+/*
+ * Pending batched REMOTE_MACIP message to zebra. Zebra already parses
+ * multiple MACIP records per message; consecutive records of the same
+ * type are packed here and the message is sent from an event, so that
+ * installing a large remote routing table does not cost one zapi
+ * message per MAC.
+ */
+#define REMOTE_MACIP_RECORD_MAX_LEN                                            \
+	(4 + ETH_ALEN + 4 + IPV6_MAX_BYTELEN + IPV4_MAX_BYTELEN + 1 + 4)
+
+static struct {
+	struct stream *s; /* message currently being packed */
+	int add;	  /* type of 's'; -1 when none pending */
+	vrf_id_t vrf_id;  /* vrf of 's' */
+	struct thread *t_flush;
+} remote_macip_batch = {.add = -1};
+
+/*
+ * Send the pending batched REMOTE_MACIP message to zebra.
+ */
+static int bgp_zebra_flush_remote_macip(struct thread *t)
+{
+	struct stream *s = remote_macip_batch.s;
+
+	if (t)
+		remote_macip_batch.t_flush = NULL;
+
+	if (!s)
+		return 0;
+
+	remote_macip_batch.s = NULL;
+	remote_macip_batch.add = -1;
+
+	if (!zclient || zclient->sock < 0) {
+		stream_free(s);
+		return 0;
+	}
+
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	stream_reset(zclient->obuf);
+	stream_put(zclient->obuf, STREAM_DATA(s), stream_get_endp(s));
+	stream_free(s);
+
+	return zclient_send_message(zclient);
+}
+
 /*
  * Add (update) or delete MACIP from zebra.
  */
@@ -561,12 +608,29 @@ static int bgp_zebra_send_remote_macip(struct bgp *bgp, struct bgpevpn *vpn,
 				   __PRETTY_FUNCTION__);
 		return 0;
 	}
-	s = zclient->obuf;
-	stream_reset(s);
 
-	zclient_create_header(
-		s, add ? ZEBRA_REMOTE_MACIP_ADD : ZEBRA_REMOTE_MACIP_DEL,
-		bgp->vrf_id);
+	/*
+	 * Close out the pending message if it is of the other type, for
+	 * another vrf, or cannot take another record.
+	 */
+	if (remote_macip_batch.s
+	    && (remote_macip_batch.add != add
+		|| remote_macip_batch.vrf_id != bgp->vrf_id
+		|| STREAM_WRITEABLE(remote_macip_batch.s)
+			   < REMOTE_MACIP_RECORD_MAX_LEN))
+		bgp_zebra_flush_remote_macip(NULL);
+
+	if (!remote_macip_batch.s) {
+		remote_macip_batch.s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+		remote_macip_batch.add = add;
+		remote_macip_batch.vrf_id = bgp->vrf_id;
+		zclient_create_header(remote_macip_batch.s,
+				      add ? ZEBRA_REMOTE_MACIP_ADD
+					  : ZEBRA_REMOTE_MACIP_DEL,
+				      bgp->vrf_id);
+	}
+	s = remote_macip_batch.s;
+
 	stream_putl(s, vpn->vni);
 	stream_put(s, &p->prefix.macip_addr.mac.octet, ETH_ALEN); /* Mac Addr */
 	/* IP address length and IP address, if any. */
@@ -587,8 +651,6 @@ static int bgp_zebra_send_remote_macip(struct bgp *bgp, struct bgpevpn *vpn,
 		stream_putl(s, seq);
 	}
 
-	stream_putw_at(s, 0, stream_get_endp(s));
-
 	if (bgp_debug_zebra(NULL))
 		zlog_debug(
 			"Tx %s MACIP, VNI %u MAC %s IP %s flags 0x%x seq %u remote VTEP %s",
@@ -600,7 +662,11 @@ static int bgp_zebra_send_remote_macip(struct bgp *bgp, struct bgpevpn *vpn,
 			inet_ntop(AF_INET, &remote_vtep_ip, buf2,
 				  sizeof(buf2)));
 
-	return zclient_send_message(zclient);
+	if (!remote_macip_batch.t_flush)
+		thread_add_event(bm->master, bgp_zebra_flush_remote_macip,
+				 NULL, 0, &remote_macip_batch.t_flush);
+
+	return 0;
 }
 
 /*
@@ -1081,8 +1147,10 @@ static int evpn_es_route_select_install(struct bgp *bgp,
 	 * bestpath has changed; update relevant fields and install or uninstall
 	 * into the zebra RIB.
 	 */
-	if (old_select || new_select)
+	if (old_select || new_select) {
 		bgp_bump_version(rn);
+		bgp_table_change_record(rn, new_select == NULL);
+	}
 
 	if (old_select)
 		bgp_path_info_unset_flag(rn, old_select, BGP_PATH_SELECTED);
@@ -1115,6 +1183,66 @@ static int evpn_es_route_select_install(struct bgp *bgp,
 	return ret;
 }
 
+/*
+ * Single-path fast path for MAC-IP (type-2) and IMET (type-3) routes.
+ *
+ * The overwhelming majority of these routes have exactly one path - the
+ * local route or a single remote VTEP's - yet each host move or import
+ * pays for the full bgp_best_selection() walk.  For a lone path the
+ * outcome is determined by the path's own usability, so compute the
+ * old/new pair directly and skip the comparison machinery.  Returns
+ * false when the node needs the real selection.
+ */
+static bool evpn_route_select_single(struct bgp *bgp, struct bgp_node *rn,
+				     struct bgp_path_info_pair *result)
+{
+	const struct prefix_evpn *evp = (const struct prefix_evpn *)&rn->p;
+	struct bgp_path_info *pi = bgp_node_get_bgp_path_info(rn);
+
+	if (evp->prefix.route_type != BGP_EVPN_MAC_IP_ROUTE
+	    && evp->prefix.route_type != BGP_EVPN_IMET_ROUTE)
+		return false;
+
+	/* Only when there is exactly one path to look at. */
+	if (!pi || pi->next)
+		return false;
+
+	/*
+	 * Deterministic-MED and addpath do their flag and ID bookkeeping
+	 * inside bgp_best_selection(); neither changes the outcome for a
+	 * lone path, but stay off the fast path so that state remains
+	 * exact.
+	 */
+	if (bgp_flag_check(bgp, BGP_FLAG_DETERMINISTIC_MED)
+	    || bgp_addpath_is_addpath_used(&bgp->tx_addpath, AFI_L2VPN,
+					   SAFI_EVPN))
+		return false;
+
+	result->old = CHECK_FLAG(pi->flags, BGP_PATH_SELECTED) ? pi : NULL;
+	result->new = NULL;
+
+	if (BGP_PATH_HOLDDOWN(pi)) {
+		/* Same reap rule as bgp_best_selection(): a removed path
+		 * that is not the selected one goes away right here.
+		 */
+		if (CHECK_FLAG(pi->flags, BGP_PATH_REMOVED)
+		    && pi != result->old) {
+			bgp_path_info_reap(rn, pi);
+			result->old = NULL;
+		}
+		return true;
+	}
+
+	if (pi->peer && pi->peer != bgp->peer_self
+	    && !CHECK_FLAG(pi->peer->sflags, PEER_STATUS_NSF_WAIT)
+	    && pi->peer->status != Established)
+		return true;
+
+	bgp_path_info_unset_flag(rn, pi, BGP_PATH_DMED_CHECK);
+	result->new = pi;
+	return true;
+}
+
 /*
  * Calculate the best path for an EVPN route. Install/update best path in zebra,
  * if appropriate.
@@ -1128,9 +1256,12 @@ static int evpn_route_select_install(struct bgp *bgp, struct bgpevpn *vpn,
 	safi_t safi = SAFI_EVPN;
 	int ret = 0;
 
-	/* Compute the best path. */
-	bgp_best_selection(bgp, rn, &bgp->maxpaths[afi][safi], &old_and_new,
-			   afi, safi);
+	/* Compute the best path; the common single-path MAC-IP/IMET case
+	 * short-circuits the full selection.
+	 */
+	if (!evpn_route_select_single(bgp, rn, &old_and_new))
+		bgp_best_selection(bgp, rn, &bgp->maxpaths[afi][safi],
+				   &old_and_new, afi, safi);
 	old_select = old_and_new.old;
 	new_select = old_and_new.new;
 
@@ -1159,8 +1290,10 @@ static int evpn_route_select_install(struct bgp *bgp, struct bgpevpn *vpn,
 	/* bestpath has changed; update relevant fields and install or uninstall
 	 * into the zebra RIB.
 	 */
-	if (old_select || new_select)
+	if (old_select || new_select) {
 		bgp_bump_version(rn);
+		bgp_table_change_record(rn, new_select == NULL);
+	}
 
 	if (old_select)
 		bgp_path_info_unset_flag(rn, old_select, BGP_PATH_SELECTED);
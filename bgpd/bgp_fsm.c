@@ -46,6 +46,7 @@
 #include "bgpd/bgp_network.h"
 #include "bgpd/bgp_route.h"
 #include "bgpd/bgp_dump.h"
+#include "bgpd/bgp_statesync.h"
 #include "bgpd/bgp_open.h"
 #include "bgpd/bgp_advertise.h"
 #include "bgpd/bgp_updgrp.h"
@@ -90,8 +91,6 @@ int bgp_event(struct thread *);
 
 /* BGP thread functions. */
 static int bgp_start_timer(struct thread *);
-static int bgp_connect_timer(struct thread *);
-static int bgp_holdtime_timer(struct thread *);
 
 /* BGP FSM functions. */
 static int bgp_start(struct peer *);
@@ -149,12 +148,12 @@ static struct peer *peer_xfer_conn(struct peer *from_peer)
 	bgp_writes_off(from_peer);
 	bgp_reads_off(from_peer);
 
-	BGP_TIMER_OFF(peer->t_routeadv);
-	BGP_TIMER_OFF(peer->t_connect);
+	bgp_fsm_timer_off(&peer->ft_routeadv);
+	bgp_fsm_timer_off(&peer->ft_connect);
 	BGP_TIMER_OFF(peer->t_connect_check_r);
 	BGP_TIMER_OFF(peer->t_connect_check_w);
-	BGP_TIMER_OFF(from_peer->t_routeadv);
-	BGP_TIMER_OFF(from_peer->t_connect);
+	bgp_fsm_timer_off(&from_peer->ft_routeadv);
+	bgp_fsm_timer_off(&from_peer->ft_connect);
 	BGP_TIMER_OFF(from_peer->t_connect_check_r);
 	BGP_TIMER_OFF(from_peer->t_connect_check_w);
 	BGP_TIMER_OFF(from_peer->t_process_packet);
@@ -201,6 +200,9 @@ static struct peer *peer_xfer_conn(struct peer *from_peer)
 			stream_fifo_push(peer->ibuf,
 					 stream_fifo_pop(from_peer->ibuf));
 
+		/* the pre-parse NLRI estimates describe those packets */
+		bgp_io_nlri_pending_xfer(peer, from_peer);
+
 		ringbuf_wipe(peer->ibuf_work);
 		ringbuf_copy(peer->ibuf_work, from_peer->ibuf_work,
 			     ringbuf_remain(from_peer->ibuf_work));
@@ -299,6 +301,139 @@ static struct peer *peer_xfer_conn(struct peer *from_peer)
 	return (peer);
 }
 
+/*
+ * One-shot FSM timer wheel.
+ *
+ * Connect, holdtime and routeadv timers used to hold one lib/thread
+ * timer per peer; at a thousand peers that keeps several thousand
+ * entries churning in the event loop's timer heap, with the hold timer
+ * re-armed on every received packet.  Instead, peers carry embedded
+ * bgp_fsm_timer nodes linked into second-granularity slots, and a
+ * single one-second tick serves whatever is due.  Arming and disarming
+ * are O(1) list operations.
+ *
+ * Entries further out than one rotation simply stay in their slot and
+ * are skipped until their due second comes around again.  Expiry lands
+ * on the due second's tick, i.e. up to one second late - same jitter
+ * direction as a lib/thread timer under load, and always on the safe
+ * side for hold and MRAI timers.
+ */
+#define BGP_FSM_WHEEL_SLOTS 1024
+#define BGP_FSM_WHEEL_MASK (BGP_FSM_WHEEL_SLOTS - 1)
+
+static struct bgp_fsm_timer *fsm_wheel[BGP_FSM_WHEEL_SLOTS];
+static time_t fsm_wheel_last; /* every slot up to this second is served */
+static uint32_t fsm_wheel_count;
+static struct thread *t_fsm_tick;
+
+static int bgp_fsm_wheel_tick(struct thread *thread);
+static void bgp_connect_expire(struct peer *peer);
+static void bgp_holdtime_expire(struct peer *peer);
+static void bgp_routeadv_expire(struct peer *peer);
+
+void bgp_fsm_timer_off(struct bgp_fsm_timer *ft)
+{
+	ft->due = 0;
+	if (!ft->pprev)
+		return;
+
+	if (ft->next)
+		ft->next->pprev = ft->pprev;
+	*ft->pprev = ft->next;
+	ft->next = NULL;
+	ft->pprev = NULL;
+	fsm_wheel_count--;
+}
+
+static void bgp_fsm_timer_on(struct peer *peer, struct bgp_fsm_timer *ft,
+			     void (*handler)(struct peer *peer), uint32_t delay)
+{
+	struct bgp_fsm_timer **slot;
+
+	bgp_fsm_timer_off(ft);
+
+	/* Don't let a dormant wheel replay the whole idle gap */
+	if (fsm_wheel_count == 0)
+		fsm_wheel_last = bgp_clock();
+
+	ft->peer = peer;
+	ft->handler = handler;
+	ft->due = bgp_clock() + MAX(delay, 1);
+
+	slot = &fsm_wheel[ft->due & BGP_FSM_WHEEL_MASK];
+	ft->next = *slot;
+	if (*slot)
+		(*slot)->pprev = &ft->next;
+	*slot = ft;
+	ft->pprev = slot;
+	fsm_wheel_count++;
+
+	if (!t_fsm_tick)
+		thread_add_timer(bm->master, bgp_fsm_wheel_tick, NULL, 1,
+				 &t_fsm_tick);
+}
+
+unsigned long bgp_fsm_timer_remain(struct bgp_fsm_timer *ft)
+{
+	time_t now = bgp_clock();
+
+	if (!ft->due || ft->due <= now)
+		return 0;
+	return ft->due - now;
+}
+
+static int bgp_fsm_wheel_tick(struct thread *thread)
+{
+	time_t now = bgp_clock();
+	time_t t;
+
+	t_fsm_tick = NULL;
+
+	for (t = fsm_wheel_last + 1; t <= now; t++) {
+		struct bgp_fsm_timer **slot =
+			&fsm_wheel[t & BGP_FSM_WHEEL_MASK];
+		struct bgp_fsm_timer *ft, *next;
+		struct bgp_fsm_timer *due_head = NULL, **due_tail = &due_head;
+
+		/*
+		 * Move due entries onto a private chain before firing
+		 * anything: an FSM event may delete other peers (e.g. a
+		 * doppelganger) and thereby unlink arbitrary entries, so
+		 * we must not hold a saved pointer into the slot list
+		 * across a handler call.  The chain keeps valid pprev
+		 * links so bgp_fsm_timer_off() works while queued.
+		 */
+		for (ft = *slot; ft; ft = next) {
+			next = ft->next;
+			if (ft->due > now)
+				continue;
+
+			if (ft->next)
+				ft->next->pprev = ft->pprev;
+			*ft->pprev = ft->next;
+
+			ft->next = NULL;
+			ft->pprev = due_tail;
+			*due_tail = ft;
+			due_tail = &ft->next;
+		}
+
+		while (due_head) {
+			struct peer *peer = due_head->peer;
+			void (*handler)(struct peer *peer) = due_head->handler;
+
+			bgp_fsm_timer_off(due_head);
+			handler(peer);
+		}
+	}
+	fsm_wheel_last = now;
+
+	if (fsm_wheel_count)
+		thread_add_timer(bm->master, bgp_fsm_wheel_tick, NULL, 1,
+				 &t_fsm_tick);
+	return 0;
+}
+
 /* Hook function called after bgp event is occered.  And vty's
    neighbor command invoke this function after making neighbor
    structure. */
@@ -316,10 +451,10 @@ void bgp_timer_set(struct peer *peer)
 			BGP_TIMER_ON(peer->t_start, bgp_start_timer,
 				     peer->v_start);
 		}
-		BGP_TIMER_OFF(peer->t_connect);
-		BGP_TIMER_OFF(peer->t_holdtime);
+		bgp_fsm_timer_off(&peer->ft_connect);
+		bgp_fsm_timer_off(&peer->ft_holdtime);
 		bgp_keepalives_off(peer);
-		BGP_TIMER_OFF(peer->t_routeadv);
+		bgp_fsm_timer_off(&peer->ft_routeadv);
 		break;
 
 	case Connect:
@@ -327,11 +462,11 @@ void bgp_timer_set(struct peer *peer)
 		   status.  Make sure start timer is off and connect timer is
 		   on. */
 		BGP_TIMER_OFF(peer->t_start);
-		BGP_TIMER_ON(peer->t_connect, bgp_connect_timer,
-			     peer->v_connect);
-		BGP_TIMER_OFF(peer->t_holdtime);
+		bgp_fsm_timer_on(peer, &peer->ft_connect, bgp_connect_expire,
+				 peer->v_connect);
+		bgp_fsm_timer_off(&peer->ft_holdtime);
 		bgp_keepalives_off(peer);
-		BGP_TIMER_OFF(peer->t_routeadv);
+		bgp_fsm_timer_off(&peer->ft_routeadv);
 		break;
 
 	case Active:
@@ -341,62 +476,65 @@ void bgp_timer_set(struct peer *peer)
 		/* If peer is passive mode, do not set connect timer. */
 		if (CHECK_FLAG(peer->flags, PEER_FLAG_PASSIVE)
 		    || CHECK_FLAG(peer->sflags, PEER_STATUS_NSF_WAIT)) {
-			BGP_TIMER_OFF(peer->t_connect);
+			bgp_fsm_timer_off(&peer->ft_connect);
 		} else {
-			BGP_TIMER_ON(peer->t_connect, bgp_connect_timer,
-				     peer->v_connect);
+			bgp_fsm_timer_on(peer, &peer->ft_connect,
+					 bgp_connect_expire, peer->v_connect);
 		}
-		BGP_TIMER_OFF(peer->t_holdtime);
+		bgp_fsm_timer_off(&peer->ft_holdtime);
 		bgp_keepalives_off(peer);
-		BGP_TIMER_OFF(peer->t_routeadv);
+		bgp_fsm_timer_off(&peer->ft_routeadv);
 		break;
 
 	case OpenSent:
 		/* OpenSent status. */
 		BGP_TIMER_OFF(peer->t_start);
-		BGP_TIMER_OFF(peer->t_connect);
+		bgp_fsm_timer_off(&peer->ft_connect);
 		if (peer->v_holdtime != 0) {
-			BGP_TIMER_ON(peer->t_holdtime, bgp_holdtime_timer,
-				     peer->v_holdtime);
+			bgp_fsm_timer_on(peer, &peer->ft_holdtime,
+					 bgp_holdtime_expire,
+					 peer->v_holdtime);
 		} else {
-			BGP_TIMER_OFF(peer->t_holdtime);
+			bgp_fsm_timer_off(&peer->ft_holdtime);
 		}
 		bgp_keepalives_off(peer);
-		BGP_TIMER_OFF(peer->t_routeadv);
+		bgp_fsm_timer_off(&peer->ft_routeadv);
 		break;
 
 	case OpenConfirm:
 		/* OpenConfirm status. */
 		BGP_TIMER_OFF(peer->t_start);
-		BGP_TIMER_OFF(peer->t_connect);
+		bgp_fsm_timer_off(&peer->ft_connect);
 
 		/* If the negotiated Hold Time value is zero, then the Hold Time
 		   timer and KeepAlive timers are not started. */
 		if (peer->v_holdtime == 0) {
-			BGP_TIMER_OFF(peer->t_holdtime);
+			bgp_fsm_timer_off(&peer->ft_holdtime);
 			bgp_keepalives_off(peer);
 		} else {
-			BGP_TIMER_ON(peer->t_holdtime, bgp_holdtime_timer,
-				     peer->v_holdtime);
+			bgp_fsm_timer_on(peer, &peer->ft_holdtime,
+					 bgp_holdtime_expire,
+					 peer->v_holdtime);
 			bgp_keepalives_on(peer);
 		}
-		BGP_TIMER_OFF(peer->t_routeadv);
+		bgp_fsm_timer_off(&peer->ft_routeadv);
 		break;
 
 	case Established:
 		/* In Established status start and connect timer is turned
 		   off. */
 		BGP_TIMER_OFF(peer->t_start);
-		BGP_TIMER_OFF(peer->t_connect);
+		bgp_fsm_timer_off(&peer->ft_connect);
 
 		/* Same as OpenConfirm, if holdtime is zero then both holdtime
 		   and keepalive must be turned off. */
 		if (peer->v_holdtime == 0) {
-			BGP_TIMER_OFF(peer->t_holdtime);
+			bgp_fsm_timer_off(&peer->ft_holdtime);
 			bgp_keepalives_off(peer);
 		} else {
-			BGP_TIMER_ON(peer->t_holdtime, bgp_holdtime_timer,
-				     peer->v_holdtime);
+			bgp_fsm_timer_on(peer, &peer->ft_holdtime,
+					 bgp_holdtime_expire,
+					 peer->v_holdtime);
 			bgp_keepalives_on(peer);
 		}
 		break;
@@ -407,10 +545,10 @@ void bgp_timer_set(struct peer *peer)
 	/* fallthru */
 	case Clearing:
 		BGP_TIMER_OFF(peer->t_start);
-		BGP_TIMER_OFF(peer->t_connect);
-		BGP_TIMER_OFF(peer->t_holdtime);
+		bgp_fsm_timer_off(&peer->ft_connect);
+		bgp_fsm_timer_off(&peer->ft_holdtime);
 		bgp_keepalives_off(peer);
-		BGP_TIMER_OFF(peer->t_routeadv);
+		bgp_fsm_timer_off(&peer->ft_routeadv);
 		break;
 	}
 }
@@ -434,58 +572,32 @@ static int bgp_start_timer(struct thread *thread)
 }
 
 /* BGP connect retry timer. */
-static int bgp_connect_timer(struct thread *thread)
+static void bgp_connect_expire(struct peer *peer)
 {
-	struct peer *peer;
-	int ret;
-
-	peer = THREAD_ARG(thread);
-
 	assert(!peer->t_write);
 	assert(!peer->t_read);
 
-	peer->t_connect = NULL;
-
 	if (bgp_debug_neighbor_events(peer))
 		zlog_debug("%s [FSM] Timer (connect timer expire)", peer->host);
 
-	if (CHECK_FLAG(peer->sflags, PEER_STATUS_ACCEPT_PEER)) {
+	if (CHECK_FLAG(peer->sflags, PEER_STATUS_ACCEPT_PEER))
 		bgp_stop(peer);
-		ret = -1;
-	} else {
-		THREAD_VAL(thread) = ConnectRetry_timer_expired;
-		bgp_event(thread); /* bgp_event unlocks peer */
-		ret = 0;
-	}
-
-	return ret;
+	else
+		bgp_event_update(peer, ConnectRetry_timer_expired);
 }
 
 /* BGP holdtime timer. */
-static int bgp_holdtime_timer(struct thread *thread)
+static void bgp_holdtime_expire(struct peer *peer)
 {
-	struct peer *peer;
-
-	peer = THREAD_ARG(thread);
-	peer->t_holdtime = NULL;
-
 	if (bgp_debug_neighbor_events(peer))
 		zlog_debug("%s [FSM] Timer (holdtime timer expire)",
 			   peer->host);
 
-	THREAD_VAL(thread) = Hold_Timer_expired;
-	bgp_event(thread); /* bgp_event unlocks peer */
-
-	return 0;
+	bgp_event_update(peer, Hold_Timer_expired);
 }
 
-int bgp_routeadv_timer(struct thread *thread)
+static void bgp_routeadv_expire(struct peer *peer)
 {
-	struct peer *peer;
-
-	peer = THREAD_ARG(thread);
-	peer->t_routeadv = NULL;
-
 	if (bgp_debug_neighbor_events(peer))
 		zlog_debug("%s [FSM] Timer (routeadv timer expire)",
 			   peer->host);
@@ -498,7 +610,24 @@ int bgp_routeadv_timer(struct thread *thread)
 	/* MRAI timer will be started again when FIFO is built, no need to
 	 * do it here.
 	 */
-	return 0;
+}
+
+/*
+ * (Re)start the MRAI timer.  A zero delay fires right away: the packet
+ * generation event is scheduled immediately instead of bouncing through
+ * the wheel.  Peers of the same update-group share their MRAI interval,
+ * so their timers expire on the same wheel tick and the group's packets
+ * are built once per tick rather than once per peer.
+ */
+void bgp_routeadv_on(struct peer *peer, uint32_t delay)
+{
+	if (delay == 0) {
+		bgp_fsm_timer_off(&peer->ft_routeadv);
+		bgp_routeadv_expire(peer);
+		return;
+	}
+
+	bgp_fsm_timer_on(peer, &peer->ft_routeadv, bgp_routeadv_expire, delay);
 }
 
 /* BGP Peer Down Cause */
@@ -661,7 +790,6 @@ void bgp_update_delay_end(struct bgp *bgp)
  */
 void bgp_start_routeadv(struct bgp *bgp)
 {
-	struct listnode *node, *nnode;
 	struct peer *peer;
 
 	zlog_info("bgp_start_routeadv(), update hold status %d",
@@ -673,11 +801,10 @@ void bgp_start_routeadv(struct bgp *bgp)
 	quagga_timestamp(3, bgp->update_delay_peers_resume_time,
 			 sizeof(bgp->update_delay_peers_resume_time));
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (peer->status != Established)
 			continue;
-		BGP_TIMER_OFF(peer->t_routeadv);
-		BGP_TIMER_ON(peer->t_routeadv, bgp_routeadv_timer, 0);
+		bgp_routeadv_on(peer, 0);
 	}
 }
 
@@ -696,8 +823,7 @@ void bgp_adjust_routeadv(struct peer *peer)
 		 * different
 		 * duration and schedule write thread immediately.
 		 */
-		if (peer->t_routeadv)
-			BGP_TIMER_OFF(peer->t_routeadv);
+		bgp_fsm_timer_off(&peer->ft_routeadv);
 
 		peer->synctime = bgp_clock();
 		thread_add_timer_msec(bm->master, bgp_generate_updgrp_packets,
@@ -725,8 +851,7 @@ void bgp_adjust_routeadv(struct peer *peer)
 	 */
 	diff = difftime(nowtime, peer->last_update);
 	if (diff > (double)peer->v_routeadv) {
-		BGP_TIMER_OFF(peer->t_routeadv);
-		BGP_TIMER_ON(peer->t_routeadv, bgp_routeadv_timer, 0);
+		bgp_routeadv_on(peer, 0);
 		return;
 	}
 
@@ -746,15 +871,13 @@ void bgp_adjust_routeadv(struct peer *peer)
 	 *
 	 *                     (MRAI - m) < r
 	 */
-	if (peer->t_routeadv)
-		remain = thread_timer_remain_second(peer->t_routeadv);
+	if (peer->ft_routeadv.due)
+		remain = bgp_fsm_timer_remain(&peer->ft_routeadv);
 	else
 		remain = peer->v_routeadv;
 	diff = peer->v_routeadv - diff;
-	if (diff <= (double)remain) {
-		BGP_TIMER_OFF(peer->t_routeadv);
-		BGP_TIMER_ON(peer->t_routeadv, bgp_routeadv_timer, diff);
-	}
+	if (diff <= (double)remain)
+		bgp_routeadv_on(peer, diff);
 }
 
 static int bgp_maxmed_onstartup_applicable(struct bgp *bgp)
@@ -884,13 +1007,12 @@ static int bgp_establish_wait_timer(struct thread *thread)
      - start the timer */
 static void bgp_update_delay_begin(struct bgp *bgp)
 {
-	struct listnode *node, *nnode;
 	struct peer *peer;
 
 	/* Stop the processing of queued work. Enqueue shall continue */
 	work_queue_plug(bm->process_main_queue);
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer))
+	frr_each_safe (bgp_peers, &bgp->peer, peer)
 		peer->update_delay_over = 0;
 
 	/* Start the update-delay timer */
@@ -1016,6 +1138,9 @@ void bgp_fsm_change_status(struct peer *peer, int status)
 		zlog_debug("%s went from %s to %s", peer->host,
 			   lookup_msg(bgp_status_msg, peer->ostatus, NULL),
 			   lookup_msg(bgp_status_msg, peer->status, NULL));
+
+	/* Mirror the transition onto a hot standby, if one is attached. */
+	bgp_statesync_peer_state(peer);
 }
 
 /* Flush the event queue and ensure the peer is shut down */
@@ -1130,15 +1255,17 @@ int bgp_stop(struct peer *peer)
 
 	/* Stop all timers. */
 	BGP_TIMER_OFF(peer->t_start);
-	BGP_TIMER_OFF(peer->t_connect);
-	BGP_TIMER_OFF(peer->t_holdtime);
-	BGP_TIMER_OFF(peer->t_routeadv);
+	bgp_fsm_timer_off(&peer->ft_connect);
+	bgp_fsm_timer_off(&peer->ft_holdtime);
+	bgp_fsm_timer_off(&peer->ft_routeadv);
 
 	/* Clear input and output buffer.  */
 	pthread_mutex_lock(&peer->io_mtx);
 	{
-		if (peer->ibuf)
+		if (peer->ibuf) {
 			stream_fifo_clean(peer->ibuf);
+			bgp_io_nlri_pending_reset(peer);
+		}
 		if (peer->obuf)
 			stream_fifo_clean(peer->obuf);
 
@@ -1172,7 +1299,12 @@ int bgp_stop(struct peer *peer)
 		/* peer address family status flags*/
 		peer->af_sflags[afi][safi] = 0;
 
-		/* Received ORF prefix-filter */
+		/* Received ORF prefix-filter; the update group's conf peer
+		 * may hold a reference to it and the list itself is freed
+		 * just below.
+		 */
+		if (peer->orf_plist[afi][safi])
+			update_group_orf_plist_detach(peer, afi, safi);
 		peer->orf_plist[afi][safi] = NULL;
 
 		if ((peer->status == OpenConfirm)
@@ -1518,7 +1650,7 @@ static int bgp_fsm_open(struct peer *peer)
 	bgp_keepalive_send(peer);
 
 	/* Reset holdtimer value. */
-	BGP_TIMER_OFF(peer->t_holdtime);
+	bgp_fsm_timer_off(&peer->ft_holdtime);
 
 	return 0;
 }
@@ -1681,10 +1813,8 @@ static int bgp_establish(struct peer *peer)
 	 * end
 	 * of read-only mode.
 	 */
-	if (!bgp_update_delay_active(peer->bgp)) {
-		BGP_TIMER_OFF(peer->t_routeadv);
-		BGP_TIMER_ON(peer->t_routeadv, bgp_routeadv_timer, 0);
-	}
+	if (!bgp_update_delay_active(peer->bgp))
+		bgp_routeadv_on(peer, 0);
 
 	if (peer->doppelganger && (peer->doppelganger->status != Deleted)) {
 		if (bgp_debug_neighbor_events(peer))
@@ -1715,14 +1845,14 @@ static int bgp_establish(struct peer *peer)
 /* Keepalive packet is received. */
 static int bgp_fsm_keepalive(struct peer *peer)
 {
-	BGP_TIMER_OFF(peer->t_holdtime);
+	bgp_fsm_timer_off(&peer->ft_holdtime);
 	return 0;
 }
 
 /* Update packet is received. */
 static int bgp_fsm_update(struct peer *peer)
 {
-	BGP_TIMER_OFF(peer->t_holdtime);
+	bgp_fsm_timer_off(&peer->ft_holdtime);
 	return 0;
 }
 
@@ -1764,13 +1894,13 @@ void bgp_fsm_nht_update(struct peer *peer, int valid)
 		break;
 	case Connect:
 		if (!valid) {
-			BGP_TIMER_OFF(peer->t_connect);
+			bgp_fsm_timer_off(&peer->ft_connect);
 			BGP_EVENT_ADD(peer, TCP_fatal_error);
 		}
 		break;
 	case Active:
 		if (valid) {
-			BGP_TIMER_OFF(peer->t_connect);
+			bgp_fsm_timer_off(&peer->ft_connect);
 			BGP_EVENT_ADD(peer, ConnectRetry_timer_expired);
 		}
 		break;
@@ -62,7 +62,13 @@ extern int bgp_event(struct thread *);
 extern int bgp_event_update(struct peer *, int event);
 extern int bgp_stop(struct peer *peer);
 extern void bgp_timer_set(struct peer *);
-extern int bgp_routeadv_timer(struct thread *);
+
+/* One-shot FSM timer wheel (see bgp_fsm.c) */
+extern void bgp_fsm_timer_off(struct bgp_fsm_timer *ft);
+extern unsigned long bgp_fsm_timer_remain(struct bgp_fsm_timer *ft);
+
+/* (Re)start the MRAI timer for a peer; 0 expires it immediately */
+extern void bgp_routeadv_on(struct peer *peer, uint32_t delay);
 extern void bgp_fsm_change_status(struct peer *peer, int status);
 extern const char *peer_down_str[];
 extern void bgp_update_delay_end(struct bgp *);
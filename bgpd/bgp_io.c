@@ -28,17 +28,21 @@
 #include "log.h"		// for zlog_debug, safe_strerror, zlog_err
 #include "memory.h"		// for MTYPE_TMP, XCALLOC, XFREE
 #include "network.h"		// for ERRNO_IO_RETRY
+#include "prefix.h"		// for PSIZE, IPV4_MAX_BITLEN
 #include "stream.h"		// for stream_get_endp, stream_getw_from, str...
 #include "ringbuf.h"		// for ringbuf_remain, ringbuf_peek, ringbuf_...
 #include "thread.h"		// for THREAD_OFF, THREAD_ARG, thread, thread...
+#include "tokenbucket.h"	// for token_bucket_consume, token_bucket_init
 #include "zassert.h"		// for assert
 
 #include "bgpd/bgp_io.h"
+#include "bgpd/bgp_attr.h"	// for bgp_attr_flags_wellformed, BGP_ATTR_F...
 #include "bgpd/bgp_debug.h"	// for bgp_debug_neighbor_events, bgp_type_str
 #include "bgpd/bgp_errors.h"	// for expanded error reference information
 #include "bgpd/bgp_fsm.h"	// for BGP_EVENT_ADD, bgp_event
 #include "bgpd/bgp_packet.h"	// for bgp_notify_send_with_data, bgp_notify...
 #include "bgpd/bgpd.h"		// for peer, BGP_MARKER_SIZE, bgp_master, bm
+#include "bgpd/bgp_vty.h"	// for afi_safi_print
 /* clang-format on */
 
 /* forward declarations */
@@ -46,17 +50,39 @@ static uint16_t bgp_write(struct peer *);
 static uint16_t bgp_read(struct peer *);
 static int bgp_process_writes(struct thread *);
 static int bgp_process_reads(struct thread *);
+static int bgp_process_reads_resume(struct thread *);
 static bool validate_header(struct peer *);
+static bool bgp_update_prevalidate(const uint8_t *pkt, uint16_t pktsize);
+static void bgp_io_nlri_account(struct peer *peer, const uint8_t *pkt,
+				uint16_t pktsize, int sign);
+static bool bgp_io_nlri_overlimit(struct peer *peer, afi_t *ret_afi,
+				  safi_t *ret_safi);
 
 /* generic i/o status codes */
 #define BGP_IO_TRANS_ERR (1 << 0) // EAGAIN or similar occurred
 #define BGP_IO_FATAL_ERR (1 << 1) // some kind of fatal TCP error
 
+/*
+ * Return the I/O pthread this peer is pinned to, picking one round-robin
+ * on first use.  The assignment is never changed afterwards so a peer's
+ * read/write events - and hence the writers of its ibuf/obuf - all stay
+ * on a single event loop.  Only called from the main pthread.
+ */
+static struct frr_pthread *bgp_peer_io_fpt(struct peer *peer)
+{
+	static uint32_t next;
+
+	if (!peer->io_fpt)
+		peer->io_fpt = bgp_pth_io_pool[next++ % bgp_io_nthreads];
+
+	return peer->io_fpt;
+}
+
 /* Thread external API ----------------------------------------------------- */
 
 void bgp_writes_on(struct peer *peer)
 {
-	struct frr_pthread *fpt = bgp_pth_io;
+	struct frr_pthread *fpt = bgp_peer_io_fpt(peer);
 	assert(fpt->running);
 
 	assert(peer->status != Deleted);
@@ -74,7 +100,7 @@ void bgp_writes_on(struct peer *peer)
 
 void bgp_writes_off(struct peer *peer)
 {
-	struct frr_pthread *fpt = bgp_pth_io;
+	struct frr_pthread *fpt = bgp_peer_io_fpt(peer);
 	assert(fpt->running);
 
 	thread_cancel_async(fpt->master, &peer->t_write, NULL);
@@ -85,7 +111,7 @@ void bgp_writes_off(struct peer *peer)
 
 void bgp_reads_on(struct peer *peer)
 {
-	struct frr_pthread *fpt = bgp_pth_io;
+	struct frr_pthread *fpt = bgp_peer_io_fpt(peer);
 	assert(fpt->running);
 
 	assert(peer->status != Deleted);
@@ -105,7 +131,7 @@ void bgp_reads_on(struct peer *peer)
 
 void bgp_reads_off(struct peer *peer)
 {
-	struct frr_pthread *fpt = bgp_pth_io;
+	struct frr_pthread *fpt = bgp_peer_io_fpt(peer);
 	assert(fpt->running);
 
 	thread_cancel_async(fpt->master, &peer->t_read, NULL);
@@ -121,7 +147,7 @@ void bgp_reads_off(struct peer *peer)
  */
 static int bgp_process_writes(struct thread *thread)
 {
-	static struct peer *peer;
+	struct peer *peer;
 	peer = THREAD_ARG(thread);
 	uint16_t status;
 	bool reschedule;
@@ -130,7 +156,7 @@ static int bgp_process_writes(struct thread *thread)
 	if (peer->fd < 0)
 		return -1;
 
-	struct frr_pthread *fpt = bgp_pth_io;
+	struct frr_pthread *fpt = peer->io_fpt;
 
 	pthread_mutex_lock(&peer->io_mtx);
 	{
@@ -170,11 +196,13 @@ static int bgp_process_writes(struct thread *thread)
 static int bgp_process_reads(struct thread *thread)
 {
 	/* clang-format off */
-	static struct peer *peer;	// peer to read from
+	struct peer *peer;		// peer to read from
 	uint16_t status;		// bgp_read status code
 	bool more = true;		// whether we got more data
 	bool fatal = false;		// whether fatal error occurred
 	bool added_pkt = false;		// whether we pushed onto ->ibuf
+	uint32_t pkts = 0;		// packets pushed onto ->ibuf
+	uint32_t pps;			// configured read rate limit
 	/* clang-format on */
 
 	peer = THREAD_ARG(thread);
@@ -182,7 +210,14 @@ static int bgp_process_reads(struct thread *thread)
 	if (peer->fd < 0 || bm->terminating)
 		return -1;
 
-	struct frr_pthread *fpt = bgp_pth_io;
+	struct frr_pthread *fpt = peer->io_fpt;
+
+	/* Config is written by the main thread; reading it racily here
+	 * is benign, we pick the new value up on the next pass. */
+	pps = atomic_load_explicit(&peer->bgp->io_read_pps,
+				   memory_order_relaxed);
+	if (pps && peer->read_limit.rate != pps)
+		token_bucket_init(&peer->read_limit, pps, pps);
 
 	pthread_mutex_lock(&peer->io_mtx);
 	{
@@ -203,8 +238,10 @@ static int bgp_process_reads(struct thread *thread)
 	}
 
 	while (more) {
-		/* static buffer for transferring packets */
-		static unsigned char pktbuf[BGP_MAX_PACKET_SIZE];
+		/* stack buffer for transferring packets; must not be
+		 * shared between the pool's pthreads
+		 */
+		unsigned char pktbuf[BGP_MAX_PACKET_SIZE];
 		/* shorter alias to peer's input buffer */
 		struct ringbuf *ibw = peer->ibuf_work;
 		/* packet size as given by header */
@@ -237,6 +274,20 @@ static int bgp_process_reads(struct thread *thread)
 			assert(ringbuf_get(ibw, pktbuf, pktsize) == pktsize);
 			stream_put(pkt, pktbuf, pktsize);
 
+			/*
+			 * Vet the cheap, stateless parts of an UPDATE here
+			 * so the main thread can skip them.  A failed check
+			 * just leaves the packet untagged: the main thread
+			 * rediscovers the problem with its full error
+			 * handling (notify subcodes, treat-as-withdraw).
+			 */
+			if (pktbuf[BGP_MARKER_SIZE + 2] == BGP_MSG_UPDATE) {
+				if (bgp_update_prevalidate(pktbuf, pktsize))
+					SET_FLAG(pkt->flags,
+						 BGP_PACKET_PREVALIDATED);
+				bgp_io_nlri_account(peer, pktbuf, pktsize, 1);
+			}
+
 			pthread_mutex_lock(&peer->io_mtx);
 			{
 				stream_fifo_push(peer->ibuf, pkt);
@@ -244,6 +295,48 @@ static int bgp_process_reads(struct thread *thread)
 			pthread_mutex_unlock(&peer->io_mtx);
 
 			added_pkt = true;
+			pkts++;
+
+			/*
+			 * Trip a hard maximum-prefix limit before the flood
+			 * reaches the main thread.  The notify goes out from
+			 * here, as for a bad header; the main thread still
+			 * runs the authoritative per-prefix check for
+			 * anything below this bar.
+			 */
+			if (pktbuf[BGP_MARKER_SIZE + 2] == BGP_MSG_UPDATE) {
+				afi_t ol_afi;
+				safi_t ol_safi;
+				uint8_t ndata[7];
+				iana_afi_t pkt_afi;
+				iana_safi_t pkt_safi;
+
+				if (!bgp_io_nlri_overlimit(peer, &ol_afi,
+							   &ol_safi))
+					continue;
+
+				zlog_info(
+					"%%MAXPFXEXCEED: No. of %s prefix queued from %s exceed limit %ld before processing",
+					afi_safi_print(ol_afi, ol_safi),
+					peer->host,
+					peer->pmax[ol_afi][ol_safi]);
+
+				pkt_afi = afi_int2iana(ol_afi);
+				pkt_safi = safi_int2iana(ol_safi);
+				ndata[0] = (pkt_afi >> 8);
+				ndata[1] = pkt_afi;
+				ndata[2] = pkt_safi;
+				ndata[3] = (peer->pmax[ol_afi][ol_safi] >> 24);
+				ndata[4] = (peer->pmax[ol_afi][ol_safi] >> 16);
+				ndata[5] = (peer->pmax[ol_afi][ol_safi] >> 8);
+				ndata[6] = (peer->pmax[ol_afi][ol_safi]);
+
+				bgp_notify_send_with_data(
+					peer, BGP_NOTIFY_CEASE,
+					BGP_NOTIFY_CEASE_MAX_PREFIX, ndata, 7);
+				fatal = true;
+				break;
+			}
 		} else
 			break;
 	}
@@ -255,8 +348,17 @@ static int bgp_process_reads(struct thread *thread)
 		/* wipe buffer just in case someone screwed up */
 		ringbuf_wipe(peer->ibuf_work);
 	} else {
-		thread_add_read(fpt->master, bgp_process_reads, peer, peer->fd,
+		/* Charge this burst against the peer's read allowance; an
+		 * empty bucket pauses reading until it refills, letting
+		 * TCP backpressure hold the peer off meanwhile. */
+		if (pps && !token_bucket_consume(&peer->read_limit, pkts))
+			thread_add_timer_msec(
+				fpt->master, bgp_process_reads_resume, peer,
+				token_bucket_wait_msec(&peer->read_limit, 1),
 				&peer->t_read);
+		else
+			thread_add_read(fpt->master, bgp_process_reads, peer,
+					peer->fd, &peer->t_read);
 		if (added_pkt)
 			thread_add_timer_msec(bm->master, bgp_process_packet,
 					      peer, 0, &peer->t_process_packet);
@@ -265,6 +367,21 @@ static int bgp_process_reads(struct thread *thread)
 	return 0;
 }
 
+/* Re-arm the read job once the rate-limit pause in bgp_process_reads()
+ * has elapsed. */
+static int bgp_process_reads_resume(struct thread *thread)
+{
+	struct peer *peer = THREAD_ARG(thread);
+
+	if (peer->fd < 0 || bm->terminating)
+		return -1;
+
+	thread_add_read(peer->io_fpt->master, bgp_process_reads, peer,
+			peer->fd, &peer->t_read);
+
+	return 0;
+}
+
 /*
  * Flush peer output buffer.
  *
@@ -272,7 +389,12 @@ static int bgp_process_reads(struct thread *thread)
  * The amount of packets written is equal to the minimum of peer->wpkt_quanta
  * and the number of packets on the output buffer, unless an error occurs.
  *
- * If write() returns an error, the appropriate FSM event is generated.
+ * Queued packets are coalesced: everything covered by one quantum goes to
+ * the kernel in a single sendmsg(), and MSG_MORE is set while more packets
+ * remain queued behind the current burst so the kernel can fill segments
+ * instead of flushing one small UPDATE per syscall.
+ *
+ * If the write fails, the appropriate FSM event is generated.
  *
  * The return value is equal to the number of packets written
  * (which may be zero).
@@ -281,86 +403,137 @@ static uint16_t bgp_write(struct peer *peer)
 {
 	uint8_t type;
 	struct stream *s;
-	int num;
+	ssize_t num;
 	int update_last_write = 0;
 	unsigned int count = 0;
 	uint32_t uo = 0;
 	uint16_t status = 0;
 	uint32_t wpkt_quanta_old;
+	struct iovec iov[BGP_WRITE_PACKET_MAX];
+	struct msghdr mh;
+	unsigned int iovcnt;
+	int flags;
 
 	wpkt_quanta_old = atomic_load_explicit(&peer->bgp->wpkt_quanta,
 					       memory_order_relaxed);
 
-	while (count < wpkt_quanta_old && (s = stream_fifo_head(peer->obuf))) {
-		int writenum;
-		do {
-			writenum = stream_get_endp(s) - stream_get_getp(s);
-			num = write(peer->fd, stream_pnt(s), writenum);
+	while (count < wpkt_quanta_old && stream_fifo_head(peer->obuf)) {
+		/*
+		 * Gather the head of the queue - up to the remainder of the
+		 * write quantum - into one vector.  Nothing queued behind a
+		 * NOTIFY is ever sent, so stop gathering there.
+		 */
+		iovcnt = 0;
+		for (s = stream_fifo_head(peer->obuf);
+		     s && iovcnt < array_size(iov)
+		     && count + iovcnt < wpkt_quanta_old;
+		     s = s->next) {
+			iov[iovcnt].iov_base = stream_pnt(s);
+			iov[iovcnt].iov_len =
+				stream_get_endp(s) - stream_get_getp(s);
+			iovcnt++;
+
+			if (stream_getc_from(s, BGP_MARKER_SIZE + 2)
+			    == BGP_MSG_NOTIFY) {
+				s = NULL;
+				break;
+			}
+		}
 
-			if (num < 0) {
-				if (!ERRNO_IO_RETRY(errno)) {
-					BGP_EVENT_ADD(peer, TCP_fatal_error);
-					SET_FLAG(status, BGP_IO_FATAL_ERR);
-				} else {
-					SET_FLAG(status, BGP_IO_TRANS_ERR);
-				}
+		flags = 0;
+#ifdef MSG_MORE
+		/* more packets remain beyond this burst */
+		if (s)
+			flags |= MSG_MORE;
+#endif
+
+		memset(&mh, 0, sizeof(mh));
+		mh.msg_iov = iov;
+		mh.msg_iovlen = iovcnt;
+
+		num = sendmsg(peer->fd, &mh, flags);
+
+		if (num < 0) {
+			if (!ERRNO_IO_RETRY(errno)) {
+				BGP_EVENT_ADD(peer, TCP_fatal_error);
+				SET_FLAG(status, BGP_IO_FATAL_ERR);
+			} else {
+				SET_FLAG(status, BGP_IO_TRANS_ERR);
+			}
 
-				goto done;
-			} else if (num != writenum)
-				stream_forward_getp(s, num);
+			goto done;
+		}
 
-		} while (num != writenum);
+		/* account the bytes written back to the queued streams */
+		while (num > 0 && (s = stream_fifo_head(peer->obuf))) {
+			ssize_t writenum =
+				stream_get_endp(s) - stream_get_getp(s);
 
-		/* Retrieve BGP packet type. */
-		stream_set_getp(s, BGP_MARKER_SIZE + 2);
-		type = stream_getc(s);
+			if (num < writenum) {
+				/*
+				 * Partially written packet; the next pass
+				 * (or i/o cycle) picks up at the new getp.
+				 */
+				stream_forward_getp(s, num);
+				num = 0;
+				break;
+			}
 
-		switch (type) {
-		case BGP_MSG_OPEN:
-			atomic_fetch_add_explicit(&peer->open_out, 1,
-						  memory_order_relaxed);
-			break;
-		case BGP_MSG_UPDATE:
-			atomic_fetch_add_explicit(&peer->update_out, 1,
-						  memory_order_relaxed);
-			uo++;
-			break;
-		case BGP_MSG_NOTIFY:
-			atomic_fetch_add_explicit(&peer->notify_out, 1,
-						  memory_order_relaxed);
-			/* Double start timer. */
-			peer->v_start *= 2;
+			num -= writenum;
+
+			/* Retrieve BGP packet type. */
+			stream_set_getp(s, BGP_MARKER_SIZE + 2);
+			type = stream_getc(s);
+
+			switch (type) {
+			case BGP_MSG_OPEN:
+				atomic_fetch_add_explicit(&peer->open_out, 1,
+							  memory_order_relaxed);
+				break;
+			case BGP_MSG_UPDATE:
+				atomic_fetch_add_explicit(&peer->update_out, 1,
+							  memory_order_relaxed);
+				uo++;
+				break;
+			case BGP_MSG_NOTIFY:
+				atomic_fetch_add_explicit(&peer->notify_out, 1,
+							  memory_order_relaxed);
+				/* Double start timer. */
+				peer->v_start *= 2;
+
+				/* Overflow check. */
+				if (peer->v_start >= (60 * 2))
+					peer->v_start = (60 * 2);
+
+				/*
+				 * Handle Graceful Restart case where the state
+				 * changes to Connect instead of Idle.
+				 */
+				BGP_EVENT_ADD(peer, BGP_Stop);
+				goto done;
 
-			/* Overflow check. */
-			if (peer->v_start >= (60 * 2))
-				peer->v_start = (60 * 2);
+			case BGP_MSG_KEEPALIVE:
+				atomic_fetch_add_explicit(&peer->keepalive_out,
+							  1,
+							  memory_order_relaxed);
+				break;
+			case BGP_MSG_ROUTE_REFRESH_NEW:
+			case BGP_MSG_ROUTE_REFRESH_OLD:
+				atomic_fetch_add_explicit(&peer->refresh_out, 1,
+							  memory_order_relaxed);
+				break;
+			case BGP_MSG_CAPABILITY:
+				atomic_fetch_add_explicit(
+					&peer->dynamic_cap_out, 1,
+					memory_order_relaxed);
+				break;
+			}
 
-			/*
-			 * Handle Graceful Restart case where the state changes
-			 * to Connect instead of Idle.
-			 */
-			BGP_EVENT_ADD(peer, BGP_Stop);
-			goto done;
+			count++;
 
-		case BGP_MSG_KEEPALIVE:
-			atomic_fetch_add_explicit(&peer->keepalive_out, 1,
-						  memory_order_relaxed);
-			break;
-		case BGP_MSG_ROUTE_REFRESH_NEW:
-		case BGP_MSG_ROUTE_REFRESH_OLD:
-			atomic_fetch_add_explicit(&peer->refresh_out, 1,
-						  memory_order_relaxed);
-			break;
-		case BGP_MSG_CAPABILITY:
-			atomic_fetch_add_explicit(&peer->dynamic_cap_out, 1,
-						  memory_order_relaxed);
-			break;
+			stream_free(stream_fifo_pop(peer->obuf));
+			update_last_write = 1;
 		}
-
-		count++;
-
-		stream_free(stream_fifo_pop(peer->obuf));
-		update_last_write = 1;
 	}
 
 done : {
@@ -392,7 +565,8 @@ static uint16_t bgp_read(struct peer *peer)
 	size_t readsize; // how many bytes we want to read
 	ssize_t nbytes;  // how many bytes we actually read
 	uint16_t status = 0;
-	static uint8_t ibw[BGP_MAX_PACKET_SIZE * BGP_READ_PACKET_MAX];
+	/* stack buffer: each I/O pthread needs its own copy */
+	uint8_t ibw[BGP_MAX_PACKET_SIZE * BGP_READ_PACKET_MAX];
 
 	readsize = MIN(ringbuf_space(peer->ibuf_work), sizeof(ibw));
 	nbytes = read(peer->fd, ibw, readsize);
@@ -440,6 +614,280 @@ static uint16_t bgp_read(struct peer *peer)
 	return status;
 }
 
+/*
+ * Length-framing walk over a raw IPv4-unicast NLRI section.
+ */
+static bool bgp_nlri_lengths_ok(const uint8_t *nlri, uint16_t len)
+{
+	uint16_t off = 0;
+	uint8_t plen;
+
+	while (off < len) {
+		plen = nlri[off++];
+		if (plen > IPV4_MAX_BITLEN)
+			return false;
+		off += PSIZE(plen);
+	}
+
+	return off == len;
+}
+
+/*
+ * Cheap, stateless structural checks on an assembled UPDATE: the section
+ * lengths, each attribute's boundaries and flag octet, and the length
+ * walk over the IPv4-unicast withdraw/NLRI sections.  Attribute
+ * semantics and the NLRI carried inside MP_REACH/MP_UNREACH stay on the
+ * main thread.
+ *
+ * Returns true if every check passed; these exact checks may then be
+ * skipped when the packet is parsed (see BGP_PACKET_PREVALIDATED).
+ */
+static bool bgp_update_prevalidate(const uint8_t *pkt, uint16_t pktsize)
+{
+	const uint8_t *body = pkt + BGP_HEADER_SIZE;
+	uint16_t len = pktsize - BGP_HEADER_SIZE;
+	uint16_t off, withdraw_len, attr_len, attr_end;
+
+	/* Unfeasible Routes Length */
+	if (len < 2)
+		return false;
+	withdraw_len = (body[0] << 8) | body[1];
+	off = 2;
+	if (withdraw_len > len - off)
+		return false;
+	if (!bgp_nlri_lengths_ok(body + off, withdraw_len))
+		return false;
+	off += withdraw_len;
+
+	/* Total Path Attribute Length */
+	if (len - off < 2)
+		return false;
+	attr_len = (body[off] << 8) | body[off + 1];
+	off += 2;
+	if (attr_len > len - off)
+		return false;
+	attr_end = off + attr_len;
+
+	while (off < attr_end) {
+		uint8_t flags, type;
+		uint16_t alen;
+
+		if (attr_end - off < 2)
+			return false;
+		flags = body[off];
+		type = body[off + 1];
+		off += 2;
+
+		if (CHECK_FLAG(flags, BGP_ATTR_FLAG_EXTLEN)) {
+			if (attr_end - off < 2)
+				return false;
+			alen = (body[off] << 8) | body[off + 1];
+			off += 2;
+		} else {
+			if (attr_end - off < 1)
+				return false;
+			alen = body[off];
+			off += 1;
+		}
+
+		if (alen > attr_end - off)
+			return false;
+		if (!bgp_attr_flags_wellformed(type, flags))
+			return false;
+		off += alen;
+	}
+
+	/* remainder of the message is IPv4-unicast NLRI */
+	return bgp_nlri_lengths_ok(body + off, len - off);
+}
+
+/*
+ * Count the prefixes announced by a raw length-framed NLRI section.
+ * Tolerant of malformed input; this only feeds an approximate check and
+ * real validation happens at parse time.
+ */
+static uint32_t bgp_nlri_count(const uint8_t *nlri, uint16_t len)
+{
+	uint16_t off = 0;
+	uint32_t n = 0;
+
+	while (off < len) {
+		off += 1 + PSIZE(nlri[off]);
+		n++;
+	}
+
+	return n;
+}
+
+/*
+ * Approximate the number of announced prefixes in an assembled UPDATE,
+ * bucketed by afi/safi.  The top-level NLRI section is IPv4 unicast; of
+ * the MP_REACH_NLRI families only the plain length-framed ones are
+ * counted and anything else is ignored, so this can only undercount -
+ * the safe direction, since the authoritative maximum-prefix check
+ * still runs after the packet is parsed.
+ */
+static void bgp_update_nlri_estimate(const uint8_t *pkt, uint16_t pktsize,
+				     uint32_t counts[AFI_MAX][SAFI_MAX])
+{
+	const uint8_t *body = pkt + BGP_HEADER_SIZE;
+	uint16_t len = pktsize - BGP_HEADER_SIZE;
+	uint16_t off, withdraw_len, attr_len, attr_end;
+
+	memset(counts, 0, AFI_MAX * SAFI_MAX * sizeof(counts[0][0]));
+
+	if (len < 2)
+		return;
+	withdraw_len = (body[0] << 8) | body[1];
+	off = 2;
+	if (withdraw_len > len - off)
+		return;
+	off += withdraw_len;
+
+	if (len - off < 2)
+		return;
+	attr_len = (body[off] << 8) | body[off + 1];
+	off += 2;
+	if (attr_len > len - off)
+		return;
+	attr_end = off + attr_len;
+
+	while (off < attr_end) {
+		uint8_t flags, type;
+		uint16_t alen;
+
+		if (attr_end - off < 2)
+			return;
+		flags = body[off];
+		type = body[off + 1];
+		off += 2;
+
+		if (CHECK_FLAG(flags, BGP_ATTR_FLAG_EXTLEN)) {
+			if (attr_end - off < 2)
+				return;
+			alen = (body[off] << 8) | body[off + 1];
+			off += 2;
+		} else {
+			if (attr_end - off < 1)
+				return;
+			alen = body[off];
+			off += 1;
+		}
+
+		if (alen > attr_end - off)
+			return;
+
+		if (type == BGP_ATTR_MP_REACH_NLRI && alen >= 5) {
+			iana_afi_t pkt_afi = (body[off] << 8) | body[off + 1];
+			iana_safi_t pkt_safi = body[off + 2];
+			/* afi + safi + nhlen + nexthop + reserved */
+			uint16_t noff = 4 + body[off + 3] + 1;
+			afi_t afi;
+			safi_t safi;
+
+			if (noff <= alen
+			    && bgp_map_afi_safi_iana2int(pkt_afi, pkt_safi,
+							 &afi, &safi) == 0
+			    && (afi == AFI_IP || afi == AFI_IP6)
+			    && (safi == SAFI_UNICAST || safi == SAFI_MULTICAST
+				|| safi == SAFI_LABELED_UNICAST))
+				counts[afi][safi] += bgp_nlri_count(
+					body + off + noff, alen - noff);
+		}
+
+		off += alen;
+	}
+
+	/* remainder of the message is IPv4-unicast NLRI */
+	counts[AFI_IP][SAFI_UNICAST] += bgp_nlri_count(body + off, len - off);
+}
+
+/*
+ * Charge (or refund, for a negative sign) an UPDATE's announced-NLRI
+ * estimate against the peer's unprocessed-ingest counters.
+ */
+static void bgp_io_nlri_account(struct peer *peer, const uint8_t *pkt,
+				uint16_t pktsize, int sign)
+{
+	uint32_t counts[AFI_MAX][SAFI_MAX];
+	afi_t afi;
+	safi_t safi;
+
+	bgp_update_nlri_estimate(pkt, pktsize, counts);
+
+	FOREACH_AFI_SAFI (afi, safi) {
+		if (!counts[afi][safi])
+			continue;
+		atomic_fetch_add_explicit(&peer->ibuf_nlri_pending[afi][safi],
+					  sign * counts[afi][safi],
+					  memory_order_relaxed);
+	}
+}
+
+/*
+ * Whether the announced NLRI queued on ibuf alone exceed a configured
+ * hard maximum-prefix limit.  Deliberately ignores the prefixes already
+ * accepted: re-announcements of an existing table (e.g. after a route
+ * refresh) then cannot trip this check no matter how far behind the
+ * main thread is, while a flood larger than the peer may ever hold is
+ * cut off before it consumes parse cycles.
+ */
+static bool bgp_io_nlri_overlimit(struct peer *peer, afi_t *ret_afi,
+				  safi_t *ret_safi)
+{
+	afi_t afi;
+	safi_t safi;
+
+	FOREACH_AFI_SAFI (afi, safi) {
+		if (!CHECK_FLAG(peer->af_flags[afi][safi], PEER_FLAG_MAX_PREFIX)
+		    || CHECK_FLAG(peer->af_flags[afi][safi],
+				  PEER_FLAG_MAX_PREFIX_WARNING))
+			continue;
+
+		if (atomic_load_explicit(&peer->ibuf_nlri_pending[afi][safi],
+					 memory_order_relaxed)
+		    > peer->pmax[afi][safi]) {
+			*ret_afi = afi;
+			*ret_safi = safi;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void bgp_io_nlri_dequeue(struct peer *peer, struct stream *pkt)
+{
+	bgp_io_nlri_account(peer, pkt->data, stream_get_endp(pkt), -1);
+}
+
+void bgp_io_nlri_pending_reset(struct peer *peer)
+{
+	afi_t afi;
+	safi_t safi;
+
+	FOREACH_AFI_SAFI (afi, safi)
+		atomic_store_explicit(&peer->ibuf_nlri_pending[afi][safi], 0,
+				      memory_order_relaxed);
+}
+
+void bgp_io_nlri_pending_xfer(struct peer *peer, struct peer *from_peer)
+{
+	afi_t afi;
+	safi_t safi;
+
+	FOREACH_AFI_SAFI (afi, safi) {
+		atomic_store_explicit(
+			&peer->ibuf_nlri_pending[afi][safi],
+			atomic_load_explicit(
+				&from_peer->ibuf_nlri_pending[afi][safi],
+				memory_order_relaxed),
+			memory_order_relaxed);
+		atomic_store_explicit(&from_peer->ibuf_nlri_pending[afi][safi],
+				      0, memory_order_relaxed);
+	}
+}
+
 /*
  * Called after we have read a BGP packet header. Validates marker, message
  * type and packet length. If any of these aren't correct, sends a notify.
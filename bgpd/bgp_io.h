@@ -100,4 +100,37 @@ extern void bgp_reads_on(struct peer *peer);
  */
 extern void bgp_reads_off(struct peer *peer);
 
+/**
+ * Refunds an UPDATE's announced-NLRI estimate when the main thread takes
+ * the packet off peer->ibuf for processing.
+ *
+ * The I/O thread charges the same estimate as it queues the packet and
+ * resets the session if the unprocessed backlog exceeds a hard
+ * maximum-prefix limit, so overlimit floods are cut off before they
+ * consume parse cycles.
+ *
+ * @param peer - peer the packet was read from
+ * @param pkt - the complete UPDATE message
+ */
+extern void bgp_io_nlri_dequeue(struct peer *peer, struct stream *pkt);
+
+/**
+ * Zeroes the peer's unprocessed announced-NLRI counters.
+ *
+ * Must accompany any wholesale flush of peer->ibuf (e.g. session reset).
+ *
+ * @param peer - peer to reset
+ */
+extern void bgp_io_nlri_pending_reset(struct peer *peer);
+
+/**
+ * Moves the unprocessed announced-NLRI counters between peers, along with
+ * the ibuf contents they describe (connection transfer).
+ *
+ * @param peer - peer inheriting the queued packets
+ * @param from_peer - peer being drained
+ */
+extern void bgp_io_nlri_pending_xfer(struct peer *peer,
+				     struct peer *from_peer);
+
 #endif /* _FRR_BGP_IO_H */
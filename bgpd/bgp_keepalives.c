@@ -38,13 +38,19 @@
 
 /*
  * Peer KeepAlive Timer.
- * Associates a peer with the time of its last keepalive.
+ * Associates a peer with the time of its last keepalive and hangs it off
+ * the timer wheel slot where its next keepalive falls due.
  */
 struct pkat {
 	/* the peer to send keepalives to */
 	struct peer *peer;
 	/* absolute time of last keepalive sent */
 	struct timeval last;
+	/* absolute time the next keepalive is due */
+	struct timeval due;
+	/* wheel slot membership; pprev is NULL when unlinked */
+	struct pkat *next;
+	struct pkat **pprev;
 };
 
 /* List of peers we are sending keepalives for, and associated mutex. */
@@ -52,11 +58,38 @@ static pthread_mutex_t *peerhash_mtx;
 static pthread_cond_t *peerhash_cond;
 static struct hash *peerhash;
 
+/*
+ * Hierarchical timer wheel, keyed by the second each peer's next
+ * keepalive is due.  Level 0 slots are one second wide; each deeper
+ * level is KA_WHEEL_SLOTS times coarser and is cascaded into the level
+ * above as the clock crosses its slot boundaries.  A tick therefore
+ * only ever touches the peers that are actually due, instead of
+ * iterating the whole peer table.
+ */
+#define KA_WHEEL_BITS 6
+#define KA_WHEEL_SLOTS (1 << KA_WHEEL_BITS)
+#define KA_WHEEL_MASK (KA_WHEEL_SLOTS - 1)
+#define KA_WHEEL_LEVELS 3
+/* widest horizon the wheel can represent; farther entries recirculate */
+#define KA_WHEEL_SPAN ((int64_t)1 << (KA_WHEEL_BITS * KA_WHEEL_LEVELS))
+
+static struct pkat *ka_wheel[KA_WHEEL_LEVELS][KA_WHEEL_SLOTS];
+/* last wheel second served; only meaningful while the pthread runs */
+static int64_t ka_wheel_sec;
+
+/* a keepalive due at most this much in the future is sent anyway; this
+ * groups peers due at roughly the same time into one tick */
+static const struct timeval ka_tolerance = {0, 100000};
+
 static struct pkat *pkat_new(struct peer *peer)
 {
 	struct pkat *pkat = XMALLOC(MTYPE_TMP, sizeof(struct pkat));
 	pkat->peer = peer;
 	monotime(&pkat->last);
+	pkat->due = pkat->last;
+	pkat->due.tv_sec += peer->v_keepalive;
+	pkat->next = NULL;
+	pkat->pprev = NULL;
 	return pkat;
 }
 
@@ -65,62 +98,161 @@ static void pkat_del(void *pkat)
 	XFREE(MTYPE_TMP, pkat);
 }
 
+/*
+ * Wheel second this entry should be served in.  The sub-second part is
+ * rounded up unless it is inside the send tolerance, so a served entry
+ * is always past (due - tolerance).
+ */
+static int64_t pkat_due_sec(const struct pkat *pkat)
+{
+	if (pkat->due.tv_usec > ka_tolerance.tv_usec)
+		return pkat->due.tv_sec + 1;
+	return pkat->due.tv_sec;
+}
+
+static void ka_wheel_unlink(struct pkat *pkat)
+{
+	if (!pkat->pprev)
+		return;
+
+	if (pkat->next)
+		pkat->next->pprev = pkat->pprev;
+	*pkat->pprev = pkat->next;
+	pkat->next = NULL;
+	pkat->pprev = NULL;
+}
+
+static void ka_wheel_link(struct pkat **slot, struct pkat *pkat)
+{
+	pkat->next = *slot;
+	if (pkat->next)
+		pkat->next->pprev = &pkat->next;
+	pkat->pprev = slot;
+	*slot = pkat;
+}
 
 /*
- * Callback for hash_iterate. Determines if a peer needs a keepalive and if so,
- * generates and sends it.
- *
- * For any given peer, if the elapsed time since its last keepalive exceeds its
- * configured keepalive timer, a keepalive is sent to the peer and its
- * last-sent time is reset. Additionally, If the elapsed time does not exceed
- * the configured keepalive timer, but the time until the next keepalive is due
- * is within a hardcoded tolerance, a keepalive is sent as if the configured
- * timer was exceeded. Doing this helps alleviate nanosecond sleeps between
- * ticks by grouping together peers who are due for keepalives at roughly the
- * same time. This tolerance value is arbitrarily chosen to be 100ms.
- *
- * In addition, this function calculates the maximum amount of time that the
- * keepalive thread can sleep before another tick needs to take place. This is
- * equivalent to shortest time until a keepalive is due for any one peer.
- *
- * @return maximum time to wait until next update (0 if infinity)
+ * Hang an entry off the slot matching its due second.  The level is
+ * picked from how far out that second is; cascading re-runs this as the
+ * due second draws nearer.  Caller must hold peerhash_mtx.
  */
-static void peer_process(struct hash_bucket *hb, void *arg)
+static void ka_wheel_schedule(struct pkat *pkat)
 {
-	struct pkat *pkat = hb->data;
+	int64_t due = pkat_due_sec(pkat);
+	int64_t delta;
+	unsigned int level, shift;
+
+	if (due < ka_wheel_sec)
+		due = ka_wheel_sec;
+	if (due - ka_wheel_sec >= KA_WHEEL_SPAN)
+		due = ka_wheel_sec + KA_WHEEL_SPAN - 1;
+
+	delta = due - ka_wheel_sec;
+	for (level = 0, shift = 0; level < KA_WHEEL_LEVELS - 1;
+	     level++, shift += KA_WHEEL_BITS)
+		if (delta < (int64_t)1 << (shift + KA_WHEEL_BITS))
+			break;
+
+	ka_wheel_link(&ka_wheel[level][(due >> shift) & KA_WHEEL_MASK], pkat);
+}
 
-	struct timeval *next_update = arg;
+/* Push a deeper level's slot back through ka_wheel_schedule(); its
+ * entries land in the level above (or come due in the current tick). */
+static void ka_wheel_cascade(unsigned int level, unsigned int slot)
+{
+	struct pkat *pkat, *next;
 
-	static struct timeval elapsed;  // elapsed time since keepalive
-	static struct timeval ka = {0}; // peer->v_keepalive as a timeval
-	static struct timeval diff;     // ka - elapsed
+	pkat = ka_wheel[level][slot];
+	ka_wheel[level][slot] = NULL;
 
-	static struct timeval tolerance = {0, 100000};
+	for (; pkat; pkat = next) {
+		next = pkat->next;
+		pkat->next = NULL;
+		pkat->pprev = NULL;
+		ka_wheel_schedule(pkat);
+	}
+}
 
-	/* calculate elapsed time since last keepalive */
-	monotime_since(&pkat->last, &elapsed);
+/*
+ * Serve one wheel second: cascade any deeper-level slot whose boundary
+ * this second crosses, then send keepalives to every peer in the level
+ * 0 slot.  All sends for the tick are batched back to back under one
+ * lock hold.
+ */
+static void ka_wheel_tick(void)
+{
+	int64_t t = ka_wheel_sec + 1;
+	struct pkat *pkat, *next;
+	struct timeval elapsed; // elapsed time since keepalive
+	struct timeval ka = {0}; // peer->v_keepalive as a timeval
+	struct timeval diff;	// ka - elapsed
+
+	if ((t & KA_WHEEL_MASK) == 0)
+		ka_wheel_cascade(1, (t >> KA_WHEEL_BITS) & KA_WHEEL_MASK);
+	if ((t & (((int64_t)1 << (2 * KA_WHEEL_BITS)) - 1)) == 0)
+		ka_wheel_cascade(2, (t >> (2 * KA_WHEEL_BITS)) & KA_WHEEL_MASK);
+
+	ka_wheel_sec = t;
+
+	pkat = ka_wheel[0][t & KA_WHEEL_MASK];
+	ka_wheel[0][t & KA_WHEEL_MASK] = NULL;
+
+	for (; pkat; pkat = next) {
+		next = pkat->next;
+		pkat->next = NULL;
+		pkat->pprev = NULL;
+
+		/* calculate elapsed time since last keepalive */
+		monotime_since(&pkat->last, &elapsed);
+
+		ka.tv_sec = pkat->peer->v_keepalive;
+		timersub(&ka, &elapsed, &diff);
+
+		if (elapsed.tv_sec >= ka.tv_sec
+		    || timercmp(&diff, &ka_tolerance, <)) {
+			if (bgp_debug_neighbor_events(pkat->peer))
+				zlog_debug(
+					"%s [FSM] Timer (keepalive timer expire)",
+					pkat->peer->host);
+
+			bgp_keepalive_send(pkat->peer);
+			monotime(&pkat->last);
+			pkat->due = pkat->last;
+			pkat->due.tv_sec += pkat->peer->v_keepalive;
+		}
 
-	/* calculate difference between elapsed time and configured time */
-	ka.tv_sec = pkat->peer->v_keepalive;
-	timersub(&ka, &elapsed, &diff);
+		ka_wheel_schedule(pkat);
+	}
+}
+
+/*
+ * Seconds until the next slot that needs serving, or -1 if the wheel is
+ * empty.  Scans slot occupancy only, never the entries themselves; for
+ * deeper levels the next slot boundary is when the cascade must run.
+ */
+static int64_t ka_wheel_next_due(void)
+{
+	int64_t best = -1;
+	unsigned int level, shift, k;
 
-	int send_keepalive =
-		elapsed.tv_sec >= ka.tv_sec || timercmp(&diff, &tolerance, <);
+	for (level = 0, shift = 0; level < KA_WHEEL_LEVELS;
+	     level++, shift += KA_WHEEL_BITS) {
+		int64_t base = ka_wheel_sec >> shift;
 
-	if (send_keepalive) {
-		if (bgp_debug_neighbor_events(pkat->peer))
-			zlog_debug("%s [FSM] Timer (keepalive timer expire)",
-				   pkat->peer->host);
+		for (k = 1; k <= KA_WHEEL_SLOTS; k++) {
+			int64_t when;
 
-		bgp_keepalive_send(pkat->peer);
-		monotime(&pkat->last);
-		memset(&elapsed, 0x00, sizeof(struct timeval));
-		diff = ka;
+			if (!ka_wheel[level][(base + k) & KA_WHEEL_MASK])
+				continue;
+
+			when = ((base + k) << shift) - ka_wheel_sec;
+			if (best < 0 || when < best)
+				best = when;
+			break;
+		}
 	}
 
-	/* if calculated next update for this peer < current delay, use it */
-	if (next_update->tv_sec < 0 || timercmp(&diff, next_update, <))
-		*next_update = diff;
+	return best;
 }
 
 static bool peer_hash_cmp(const void *f, const void *s)
@@ -146,6 +278,7 @@ static void bgp_keepalives_finish(void *arg)
 	}
 
 	peerhash = NULL;
+	memset(ka_wheel, 0, sizeof(ka_wheel));
 
 	pthread_mutex_unlock(peerhash_mtx);
 	pthread_mutex_destroy(peerhash_mtx);
@@ -164,9 +297,9 @@ void *bgp_keepalives_start(void *arg)
 	fpt->master->owner = pthread_self();
 
 	struct timeval currtime = {0, 0};
-	struct timeval aftertime = {0, 0};
 	struct timeval next_update = {0, 0};
 	struct timespec next_update_ts = {0, 0};
+	int64_t wait;
 
 	peerhash_mtx = XCALLOC(MTYPE_TMP, sizeof(pthread_mutex_t));
 	peerhash_cond = XCALLOC(MTYPE_TMP, sizeof(pthread_cond_t));
@@ -191,6 +324,10 @@ void *bgp_keepalives_start(void *arg)
 	peerhash = hash_create_size(2048, peer_hash_key, peer_hash_cmp, NULL);
 	pthread_mutex_lock(peerhash_mtx);
 
+	/* start the wheel clock at the current second */
+	monotime(&currtime);
+	ka_wheel_sec = currtime.tv_sec;
+
 	/* register cleanup handler */
 	pthread_cleanup_push(&bgp_keepalives_finish, NULL);
 
@@ -209,15 +346,19 @@ void *bgp_keepalives_start(void *arg)
 
 		monotime(&currtime);
 
-		next_update.tv_sec = -1;
-
-		hash_iterate(peerhash, peer_process, &next_update);
-		if (next_update.tv_sec == -1)
-			memset(&next_update, 0x00, sizeof(next_update));
+		/* serve every wheel second up to now; seconds whose
+		 * slots are empty cost nothing */
+		while (ka_wheel_sec < currtime.tv_sec)
+			ka_wheel_tick();
 
-		monotime_since(&currtime, &aftertime);
+		/* sleep until the boundary of the next occupied slot (or
+		 * pending cascade); the send tolerance absorbs peers due
+		 * just past it */
+		wait = ka_wheel_next_due();
+		next_update.tv_sec =
+			(wait < 0) ? currtime.tv_sec : ka_wheel_sec + wait;
+		next_update.tv_usec = (wait < 0) ? currtime.tv_usec : 0;
 
-		timeradd(&currtime, &next_update, &next_update);
 		TIMEVAL_TO_TIMESPEC(&next_update, &next_update_ts);
 	}
 
@@ -251,6 +392,7 @@ void bgp_keepalives_on(struct peer *peer)
 		if (!hash_lookup(peerhash, &holder)) {
 			struct pkat *pkat = pkat_new(peer);
 			hash_get(peerhash, pkat, hash_alloc_intern);
+			ka_wheel_schedule(pkat);
 			peer_lock(peer);
 		}
 		SET_FLAG(peer->thread_flags, PEER_THREAD_KEEPALIVES_ON);
@@ -280,6 +422,7 @@ void bgp_keepalives_off(struct peer *peer)
 		holder.peer = peer;
 		struct pkat *res = hash_release(peerhash, &holder);
 		if (res) {
+			ka_wheel_unlink(res);
 			pkat_del(res);
 			peer_unlock(peer);
 		}
@@ -81,6 +81,8 @@ DEFINE_MTYPE_STATIC(BGPD, BGP_LABEL_CBQ, "BGP Dynamic Label Callback")
 struct lp_chunk {
 	uint32_t	first;
 	uint32_t	last;
+	uint32_t	nfree;		/* un-allocated labels in chunk */
+	uint32_t	scan;		/* where to resume the free-label scan */
 };
 
 /*
@@ -107,7 +109,14 @@ struct lp_fifo {
 	struct lp_lcb	lcb;
 };
 
-struct lp_cbq_item {
+/*
+ * Callback deliveries are batched: one work queue item carries up to
+ * LP_CBQ_BATCH notifications, so a table load pays the work queue
+ * bookkeeping once per batch instead of once per prefix.
+ */
+#define LP_CBQ_BATCH	128
+
+struct lp_cbq_entry {
 	int		(*cbfunc)(mpls_label_t label, void *lblid, bool alloc);
 	int		type;
 	mpls_label_t	label;
@@ -115,57 +124,103 @@ struct lp_cbq_item {
 	bool		allocated;	/* false = lost */
 };
 
+struct lp_cbq_item {
+	uint32_t	count;
+	struct lp_cbq_entry entry[LP_CBQ_BATCH];
+};
+
+/* Most recently enqueued, not yet full, callback batch */
+static struct lp_cbq_item *lp_cbq_open;
+
+/*
+ * Return a label to its chunk's free-label accounting.
+ */
+static void lp_chunk_return(mpls_label_t label)
+{
+	struct listnode *node;
+	struct lp_chunk *chunk;
+
+	for (ALL_LIST_ELEMENTS_RO(lp->chunks, node, chunk)) {
+		if (label < chunk->first || label > chunk->last)
+			continue;
+		chunk->nfree++;
+		if (label < chunk->scan)
+			chunk->scan = label;
+		return;
+	}
+}
+
 static wq_item_status lp_cbq_docallback(struct work_queue *wq, void *data)
 {
-	struct lp_cbq_item *lcbq = data;
+	struct lp_cbq_item *item = data;
+	struct lp_cbq_entry *lcbq;
+	uint32_t i;
 	int rc;
 	int debug = BGP_DEBUG(labelpool, LABELPOOL);
 
-	if (debug)
-		zlog_debug("%s: calling callback with labelid=%p label=%u allocated=%d",
-			__func__, lcbq->labelid, lcbq->label, lcbq->allocated);
-
-	if (lcbq->label == MPLS_LABEL_NONE) {
-		/* shouldn't happen */
-		flog_err(EC_BGP_LABEL, "%s: error: label==MPLS_LABEL_NONE",
-			 __func__);
-		return WQ_SUCCESS;
-	}
+	/*
+	 * Callbacks may request labels, which must not append to the
+	 * batch being consumed here.
+	 */
+	if (lp_cbq_open == item)
+		lp_cbq_open = NULL;
 
-	rc = (*(lcbq->cbfunc))(lcbq->label, lcbq->labelid, lcbq->allocated);
+	for (i = 0; i < item->count; i++) {
+		lcbq = &item->entry[i];
 
-	if (lcbq->allocated && rc) {
-		/*
-		 * Callback rejected allocation. This situation could arise
-		 * if there was a label request followed by the requestor
-		 * deciding it didn't need the assignment (e.g., config
-		 * change) while the reply to the original request (with
-		 * label) was in the work queue.
-		 */
 		if (debug)
-			zlog_debug("%s: callback rejected allocation, releasing labelid=%p label=%u",
-				__func__, lcbq->labelid, lcbq->label);
+			zlog_debug("%s: calling callback with labelid=%p label=%u allocated=%d",
+				__func__, lcbq->labelid, lcbq->label,
+				lcbq->allocated);
 
-		uintptr_t lbl = lcbq->label;
-		void *labelid;
-		struct lp_lcb *lcb;
+		if (lcbq->label == MPLS_LABEL_NONE) {
+			/* shouldn't happen */
+			flog_err(EC_BGP_LABEL,
+				 "%s: error: label==MPLS_LABEL_NONE",
+				 __func__);
+			continue;
+		}
 
-		/*
-		 * If the rejected label was marked inuse by this labelid,
-		 * release the label back to the pool.
-		 *
-		 * Further, if the rejected label was still assigned to
-		 * this labelid in the LCB, delete the LCB.
-		 */
-		if (!skiplist_search(lp->inuse, (void *)lbl, &labelid)) {
-			if (labelid == lcbq->labelid) {
-				if (!skiplist_search(lp->ledger, labelid,
-					(void **)&lcb)) {
-					if (lcbq->label == lcb->label)
-						skiplist_delete(lp->ledger,
-							labelid, NULL);
+		rc = (*(lcbq->cbfunc))(lcbq->label, lcbq->labelid,
+				       lcbq->allocated);
+
+		if (lcbq->allocated && rc) {
+			/*
+			 * Callback rejected allocation. This situation could
+			 * arise if there was a label request followed by the
+			 * requestor deciding it didn't need the assignment
+			 * (e.g., config change) while the reply to the
+			 * original request (with label) was in the work queue.
+			 */
+			if (debug)
+				zlog_debug("%s: callback rejected allocation, releasing labelid=%p label=%u",
+					__func__, lcbq->labelid, lcbq->label);
+
+			uintptr_t lbl = lcbq->label;
+			void *labelid;
+			struct lp_lcb *lcb;
+
+			/*
+			 * If the rejected label was marked inuse by this
+			 * labelid, release the label back to the pool.
+			 *
+			 * Further, if the rejected label was still assigned to
+			 * this labelid in the LCB, delete the LCB.
+			 */
+			if (!skiplist_search(lp->inuse, (void *)lbl,
+					     &labelid)) {
+				if (labelid == lcbq->labelid) {
+					if (!skiplist_search(lp->ledger,
+						labelid, (void **)&lcb)) {
+						if (lcbq->label == lcb->label)
+							skiplist_delete(
+								lp->ledger,
+								labelid, NULL);
+					}
+					skiplist_delete(lp->inuse, (void *)lbl,
+							NULL);
+					lp_chunk_return(lcbq->label);
 				}
-				skiplist_delete(lp->inuse, (void *)lbl, NULL);
 			}
 		}
 	}
@@ -173,6 +228,34 @@ static wq_item_status lp_cbq_docallback(struct work_queue *wq, void *data)
 	return WQ_SUCCESS;
 }
 
+/*
+ * Queue a callback for delivery, appending to the open batch when one
+ * exists.
+ */
+static void lp_cbq_enqueue(
+	int		(*cbfunc)(mpls_label_t label, void *lblid, bool alloc),
+	int		type,
+	mpls_label_t	label,
+	void		*labelid,
+	bool		allocated)
+{
+	struct lp_cbq_item *q = lp_cbq_open;
+	struct lp_cbq_entry *e;
+
+	if (!q || q->count == LP_CBQ_BATCH) {
+		q = XCALLOC(MTYPE_BGP_LABEL_CBQ, sizeof(struct lp_cbq_item));
+		work_queue_add(lp->callback_q, q);
+		lp_cbq_open = q;
+	}
+
+	e = &q->entry[q->count++];
+	e->cbfunc = cbfunc;
+	e->type = type;
+	e->label = label;
+	e->labelid = labelid;
+	e->allocated = allocated;
+}
+
 static void lp_cbq_item_free(struct work_queue *wq, void *data)
 {
 	XFREE(MTYPE_BGP_LABEL_CBQ, data);
@@ -206,6 +289,8 @@ void bgp_lp_init(struct thread_master *master, struct labelpool *pool)
 	lp->callback_q->spec.workfunc = lp_cbq_docallback;
 	lp->callback_q->spec.del_item_data = lp_cbq_item_free;
 	lp->callback_q->spec.max_retries = 0;
+
+	lp_cbq_open = NULL;
 }
 
 void bgp_lp_finish(void)
@@ -232,6 +317,7 @@ void bgp_lp_finish(void)
 	lp->requests = NULL;
 
 	work_queue_free_and_null(&lp->callback_q);
+	lp_cbq_open = NULL;
 
 	lp = NULL;
 }
@@ -243,29 +329,64 @@ static mpls_label_t get_label_from_pool(void *labelid)
 	int debug = BGP_DEBUG(labelpool, LABELPOOL);
 
 	/*
-	 * Find a free label
-	 * Linear search is not efficient but should be executed infrequently.
+	 * Find a free label.  Chunks with no free labels are skipped
+	 * outright, and each chunk remembers where its last scan left
+	 * off, so a bulk allocation run does not rescan the allocated
+	 * front of the chunk for every label.
 	 */
 	for (ALL_LIST_ELEMENTS_RO(lp->chunks, node, chunk)) {
 		uintptr_t lbl;
+		int pass;
 
-		if (debug)
-			zlog_debug("%s: chunk first=%u last=%u",
-				__func__, chunk->first, chunk->last);
+		if (!chunk->nfree)
+			continue;
 
-		for (lbl = chunk->first; lbl <= chunk->last; ++lbl) {
-			/* labelid is key to all-request "ledger" list */
-			if (!skiplist_insert(lp->inuse, (void *)lbl, labelid)) {
-				/*
-				 * Success
+		if (debug)
+			zlog_debug("%s: chunk first=%u last=%u nfree=%u",
+				__func__, chunk->first, chunk->last,
+				chunk->nfree);
+
+		for (pass = 0; pass < 2; pass++) {
+			for (lbl = chunk->scan; lbl <= chunk->last; ++lbl) {
+				/* labelid is key to all-request "ledger"
+				 * list
 				 */
-				return lbl;
+				if (!skiplist_insert(lp->inuse, (void *)lbl,
+						     labelid)) {
+					/*
+					 * Success
+					 */
+					chunk->nfree--;
+					chunk->scan = lbl + 1;
+					return lbl;
+				}
 			}
+			/* free labels must be behind the scan point */
+			chunk->scan = chunk->first;
 		}
 	}
 	return MPLS_LABEL_NONE;
 }
 
+/*
+ * Ask zebra for enough labels to cover the queued requests that no
+ * pending chunk will satisfy, in a single exchange.
+ */
+static void lp_request_backlog(void)
+{
+	uint32_t needed;
+
+	if (LABEL_FIFO_COUNT(lp->requests) <= lp->pending_count)
+		return;
+
+	needed = LABEL_FIFO_COUNT(lp->requests) - lp->pending_count;
+	if (needed < LP_CHUNK_SIZE)
+		needed = LP_CHUNK_SIZE;
+
+	if (!zclient_send_get_label_chunk(zclient, 0, needed))
+		lp->pending_count += needed;
+}
+
 /*
  * Success indicated by value of "label" field in returned LCB
  */
@@ -350,17 +471,8 @@ void bgp_lp_get(
 		 * this is a duplicate request that we filled already).
 		 * Enqueue response work item with new label.
 		 */
-		struct lp_cbq_item *q;
-
-		q = XCALLOC(MTYPE_BGP_LABEL_CBQ, sizeof(struct lp_cbq_item));
-
-		q->cbfunc = lcb->cbfunc;
-		q->type = lcb->type;
-		q->label = lcb->label;
-		q->labelid = lcb->labelid;
-		q->allocated = true;
-
-		work_queue_add(lp->callback_q, q);
+		lp_cbq_enqueue(lcb->cbfunc, lcb->type, lcb->label,
+			       lcb->labelid, true);
 
 		return;
 	}
@@ -387,12 +499,7 @@ void bgp_lp_get(
 	lf->lcb = *lcb;
 	LABEL_FIFO_ADD(lp->requests, lf);
 
-	if (LABEL_FIFO_COUNT(lp->requests) > lp->pending_count) {
-		if (!zclient_send_get_label_chunk(zclient, 0, LP_CHUNK_SIZE)) {
-			lp->pending_count += LP_CHUNK_SIZE;
-			return;
-		}
-	}
+	lp_request_backlog();
 }
 
 void bgp_lp_release(
@@ -408,6 +515,7 @@ void bgp_lp_release(
 
 			/* no longer in use */
 			skiplist_delete(lp->inuse, (void *)lbl, NULL);
+			lp_chunk_return(label);
 
 			/* no longer requested */
 			skiplist_delete(lp->ledger, labelid, NULL);
@@ -435,6 +543,8 @@ void bgp_lp_event_chunk(uint8_t keep, uint32_t first, uint32_t last)
 
 	chunk->first = first;
 	chunk->last = last;
+	chunk->nfree = last - first + 1;
+	chunk->scan = first;
 
 	listnode_add(lp->chunks, chunk);
 
@@ -488,25 +598,24 @@ void bgp_lp_event_chunk(uint8_t keep, uint32_t first, uint32_t last)
 		 * we filled the request from local pool.
 		 * Enqueue response work item with new label.
 		 */
-		struct lp_cbq_item *q = XCALLOC(MTYPE_BGP_LABEL_CBQ,
-			sizeof(struct lp_cbq_item));
-
-		q->cbfunc = lcb->cbfunc;
-		q->type = lcb->type;
-		q->label = lcb->label;
-		q->labelid = lcb->labelid;
-		q->allocated = true;
-
 		if (debug)
 			zlog_debug("%s: assigning label %u to labelid %p",
-				__func__, q->label, q->labelid);
+				__func__, lcb->label, lcb->labelid);
 
-		work_queue_add(lp->callback_q, q);
+		lp_cbq_enqueue(lcb->cbfunc, lcb->type, lcb->label,
+			       lcb->labelid, true);
 
 finishedrequest:
 		LABEL_FIFO_DEL(lp->requests, lf);
 		XFREE(MTYPE_BGP_LABEL_FIFO, lf);
 	}
+
+	/*
+	 * If this chunk ran dry before the request queue did, ask for the
+	 * rest of the backlog now rather than waiting for the next
+	 * bgp_lp_get() to notice.
+	 */
+	lp_request_backlog();
 }
 
 /*
@@ -567,16 +676,9 @@ void bgp_lp_event_zebra_up(void)
 				/*
 				 * invalidate
 				 */
-				struct lp_cbq_item *q;
-
-				q = XCALLOC(MTYPE_BGP_LABEL_CBQ,
-					sizeof(struct lp_cbq_item));
-				q->cbfunc = lcb->cbfunc;
-				q->type = lcb->type;
-				q->label = lcb->label;
-				q->labelid = lcb->labelid;
-				q->allocated = false;
-				work_queue_add(lp->callback_q, q);
+				lp_cbq_enqueue(lcb->cbfunc, lcb->type,
+					       lcb->label, lcb->labelid,
+					       false);
 
 				lcb->label = MPLS_LABEL_NONE;
 			}
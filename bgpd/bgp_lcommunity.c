@@ -173,6 +173,89 @@ struct lcommunity *lcommunity_merge(struct lcommunity *lcom1,
 	return lcom1;
 }
 
+void lcommunity_builder_init(struct lcommunity_builder *b)
+{
+	b->size = 0;
+	b->capacity = LCOMMUNITY_BUILDER_INLINE;
+	b->val = b->inline_val;
+}
+
+/* Sorted-unique insert into the builder's buffer, growing it
+   geometrically once the inline storage is exhausted.  */
+static void lcommunity_builder_add_val(struct lcommunity_builder *b,
+				       const uint8_t *val)
+{
+	uint8_t *p;
+	int ret;
+	int c;
+
+	c = 0;
+	for (p = b->val; c < b->size; p += LCOMMUNITY_SIZE, c++) {
+		ret = memcmp(p, val, LCOMMUNITY_SIZE);
+		if (ret == 0)
+			return;
+		if (ret > 0)
+			break;
+	}
+
+	if (b->size == b->capacity) {
+		b->capacity *= 2;
+		if (b->val == b->inline_val) {
+			b->val = XMALLOC(MTYPE_LCOMMUNITY_VAL,
+					 b->capacity * LCOMMUNITY_SIZE);
+			memcpy(b->val, b->inline_val,
+			       b->size * LCOMMUNITY_SIZE);
+		} else
+			b->val = XREALLOC(MTYPE_LCOMMUNITY_VAL, b->val,
+					  b->capacity * LCOMMUNITY_SIZE);
+	}
+
+	memmove(b->val + (c + 1) * LCOMMUNITY_SIZE,
+		b->val + c * LCOMMUNITY_SIZE, (b->size - c) * LCOMMUNITY_SIZE);
+	memcpy(b->val + c * LCOMMUNITY_SIZE, val, LCOMMUNITY_SIZE);
+	b->size++;
+}
+
+void lcommunity_builder_add(struct lcommunity_builder *b,
+			    const struct lcommunity *lcom)
+{
+	int i;
+
+	if (!lcom)
+		return;
+
+	for (i = 0; i < lcom->size; i++)
+		lcommunity_builder_add_val(b,
+					   lcom->val + (i * LCOMMUNITY_SIZE));
+}
+
+/* Produce the composed set as a regular heap lcommunity, equivalent to
+   what lcommunity_uniq_sort() of the merged inputs would have built,
+   and reset the builder for reuse.  */
+struct lcommunity *lcommunity_builder_finish(struct lcommunity_builder *b)
+{
+	struct lcommunity *new;
+
+	new = lcommunity_new();
+	new->size = b->size;
+
+	if (b->size) {
+		if (b->val == b->inline_val) {
+			new->val = XMALLOC(MTYPE_LCOMMUNITY_VAL,
+					   lcom_length(new));
+			memcpy(new->val, b->val, lcom_length(new));
+		} else
+			/* Hand the heap buffer over, trimmed to its
+			   final size.  */
+			new->val = XREALLOC(MTYPE_LCOMMUNITY_VAL, b->val,
+					    lcom_length(new));
+	}
+
+	lcommunity_builder_init(b);
+
+	return new;
+}
+
 static void set_lcommunity_string(struct lcommunity *lcom, bool make_json)
 {
 	int i;
@@ -553,14 +636,17 @@ static void *bgp_aggr_lcommunty_hash_alloc(void *p)
 
 static void bgp_aggr_lcommunity_prepare(struct hash_backet *hb, void *arg)
 {
-	struct lcommunity *lcommerge = NULL;
 	struct lcommunity *hb_lcommunity = hb->data;
 	struct lcommunity **aggr_lcommunity = arg;
 
 	if (*aggr_lcommunity) {
-		lcommerge = lcommunity_merge(*aggr_lcommunity, hb_lcommunity);
-		*aggr_lcommunity = lcommunity_uniq_sort(lcommerge);
-		lcommunity_free(&lcommerge);
+		struct lcommunity_builder b;
+
+		lcommunity_builder_init(&b);
+		lcommunity_builder_add(&b, *aggr_lcommunity);
+		lcommunity_builder_add(&b, hb_lcommunity);
+		lcommunity_free(aggr_lcommunity);
+		*aggr_lcommunity = lcommunity_builder_finish(&b);
 	} else
 		*aggr_lcommunity = lcommunity_dup(hb_lcommunity);
 }
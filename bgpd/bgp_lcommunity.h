@@ -52,6 +52,34 @@ struct lcommunity_val {
 
 #define lcom_length(X)    ((X)->size * LCOMMUNITY_SIZE)
 
+/* In-place builder for composing a large-community set without the
+ * dup/merge/uniq_sort transient allocations.  Values stay sorted and
+ * unique as they are added; sets of up to LCOMMUNITY_BUILDER_INLINE
+ * values (the overwhelmingly common case) live entirely in the builder
+ * itself, so "set large-community ... additive" on a path does not
+ * touch the allocator at all until the final result is produced.
+ */
+#define LCOMMUNITY_BUILDER_INLINE 16
+
+struct lcommunity_builder {
+	/* Values added so far. */
+	int size;
+
+	/* Values `val' can hold before it must grow. */
+	int capacity;
+
+	/* Points at `inline_val' until the set outgrows it. */
+	uint8_t *val;
+
+	uint8_t inline_val[LCOMMUNITY_BUILDER_INLINE * LCOMMUNITY_SIZE];
+};
+
+extern void lcommunity_builder_init(struct lcommunity_builder *b);
+extern void lcommunity_builder_add(struct lcommunity_builder *b,
+				   const struct lcommunity *lcom);
+extern struct lcommunity *
+lcommunity_builder_finish(struct lcommunity_builder *b);
+
 extern void lcommunity_init(void);
 extern void lcommunity_finish(void);
 extern void lcommunity_free(struct lcommunity **);
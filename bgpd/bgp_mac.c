@@ -186,14 +186,13 @@ static void bgp_process_mac_rescan_table(struct bgp *bgp, struct peer *peer,
 
 static void bgp_mac_rescan_evpn_table(struct bgp *bgp)
 {
-	struct listnode *node;
 	struct peer *peer;
 	safi_t safi;
 	afi_t afi;
 
 	afi = AFI_L2VPN;
 	safi = SAFI_EVPN;
-	for (ALL_LIST_ELEMENTS_RO(bgp->peer, node, peer)) {
+	frr_each (bgp_peers, &bgp->peer, peer) {
 
 		if (CHECK_FLAG(peer->sflags, PEER_STATUS_GROUP))
 			continue;
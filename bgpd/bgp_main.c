@@ -145,10 +145,17 @@ void sighup(void)
 /* SIGINT handler. */
 __attribute__((__noreturn__)) void sigint(void)
 {
+	struct listnode *node, *nnode;
+	struct bgp *bgp;
+
 	zlog_notice("Terminating on signal");
 	assert(bm->terminating == false);
 	bm->terminating = true;	/* global flag that shutting down */
 
+	/* Snapshot the local RIBs before the sessions are torn down. */
+	for (ALL_LIST_ELEMENTS(bm->bgp, node, nnode, bgp))
+		bgp_rib_cache_write(bgp);
+
 	bgp_terminate();
 
 	bgp_exit(0);
@@ -457,6 +464,9 @@ int main(int argc, char **argv)
 
 	/* BGP master init. */
 	bgp_master_init(frr_init());
+	/* bgpd keeps a timer per peer FSM; the O(1) wheel backend beats the
+	 * default heap at scale. */
+	thread_master_use_timer_wheel(bm->master);
 	bm->port = bgp_port;
 	if (bgp_port == 0)
 		bgp_option_set(BGP_OPT_NO_LISTEN);
@@ -478,6 +488,16 @@ int main(int argc, char **argv)
 	frr_config_fork();
 	/* must be called after fork() */
 	bgp_pthreads_run();
+
+	/* Pre-populate tables from a rib cache left by the previous run. */
+	{
+		struct listnode *node;
+		struct bgp *bgp;
+
+		for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp))
+			bgp_rib_cache_read(bgp);
+	}
+
 	frr_run(bm->master);
 
 	/* Not reached. */
@@ -42,7 +42,7 @@ DEFINE_MTYPE(BGPD, BGP_PEER_AF, "BGP peer af")
 DEFINE_MTYPE(BGPD, BGP_UPDGRP, "BGP update group")
 DEFINE_MTYPE(BGPD, BGP_UPD_SUBGRP, "BGP update subgroup")
 DEFINE_MTYPE(BGPD, BGP_PACKET, "BGP packet")
-DEFINE_MTYPE(BGPD, ATTR, "BGP attribute")
+DEFINE_MTYPE_POOL(BGPD, ATTR, "BGP attribute")
 DEFINE_MTYPE(BGPD, AS_PATH, "BGP aspath")
 DEFINE_MTYPE(BGPD, AS_SEG, "BGP aspath seg")
 DEFINE_MTYPE(BGPD, AS_SEG_DATA, "BGP aspath segment data")
@@ -50,7 +50,10 @@ DEFINE_MTYPE(BGPD, AS_STR, "BGP aspath str")
 
 DEFINE_MTYPE(BGPD, BGP_TABLE, "BGP table")
 DEFINE_MTYPE(BGPD, BGP_NODE, "BGP node")
-DEFINE_MTYPE(BGPD, BGP_ROUTE, "BGP route")
+DEFINE_MTYPE(BGPD, BGP_TABLE_WALK, "BGP table walk array")
+DEFINE_MTYPE(BGPD, BGP_TABLE_CHANGE, "BGP table change feed")
+DEFINE_MTYPE(BGPD, BGP_RMAP_CACHE, "BGP inbound route-map cache")
+DEFINE_MTYPE_POOL(BGPD, BGP_ROUTE, "BGP route")
 DEFINE_MTYPE(BGPD, BGP_ROUTE_EXTRA, "BGP ancillary route info")
 DEFINE_MTYPE(BGPD, BGP_CONN, "BGP connected")
 DEFINE_MTYPE(BGPD, BGP_STATIC, "BGP static")
@@ -120,6 +123,7 @@ DEFINE_MTYPE(BGPD, BGP_EVPN_ES_VTEP, "BGP EVPN ES VTEP Ip")
 DEFINE_MTYPE(BGPD, BGP_EVPN_ES, "BGP EVPN ESI Information")
 DEFINE_MTYPE(BGPD, BGP_EVPN_IMPORT_RT, "BGP EVPN Import RT")
 DEFINE_MTYPE(BGPD, BGP_EVPN_VRF_IMPORT_RT, "BGP EVPN VRF Import RT")
+DEFINE_MTYPE(BGPD, BGP_VPN_IMPORT_RT, "BGP VPN Import RT")
 DEFINE_MTYPE(BGPD, BGP_EVPN_MACIP, "BGP EVPN MAC IP")
 
 DEFINE_MTYPE(BGPD, BGP_FLOWSPEC, "BGP flowspec")
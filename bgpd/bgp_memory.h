@@ -46,6 +46,9 @@ DECLARE_MTYPE(AS_STR)
 
 DECLARE_MTYPE(BGP_TABLE)
 DECLARE_MTYPE(BGP_NODE)
+DECLARE_MTYPE(BGP_TABLE_WALK)
+DECLARE_MTYPE(BGP_TABLE_CHANGE)
+DECLARE_MTYPE(BGP_RMAP_CACHE)
 DECLARE_MTYPE(BGP_ROUTE)
 DECLARE_MTYPE(BGP_ROUTE_EXTRA)
 DECLARE_MTYPE(BGP_CONN)
@@ -117,6 +120,7 @@ DECLARE_MTYPE(BGP_EVPN_ES_VTEP)
 DECLARE_MTYPE(BGP_EVPN)
 DECLARE_MTYPE(BGP_EVPN_IMPORT_RT)
 DECLARE_MTYPE(BGP_EVPN_VRF_IMPORT_RT)
+DECLARE_MTYPE(BGP_VPN_IMPORT_RT)
 DECLARE_MTYPE(BGP_EVPN_MACIP)
 
 DECLARE_MTYPE(BGP_FLOWSPEC)
@@ -248,12 +248,55 @@ void bgp_mp_list_clear(struct list *mp_list)
 /*
  * bgp_mp_list_add
  *
- * Adds a multipath entry to the mp_list
+ * Adds a multipath entry to the mp_list.  Candidates are collected
+ * unordered in O(1); the ordering required by the update walk is
+ * established once by bgp_mp_list_sort.
  */
 void bgp_mp_list_add(struct list *mp_list, struct bgp_path_info *mpinfo)
 {
 	assert(mp_list && mpinfo);
-	listnode_add_sort(mp_list, mpinfo);
+	listnode_add(mp_list, mpinfo);
+}
+
+static int bgp_path_info_mpath_cmp_qsort(const void *p1, const void *p2)
+{
+	return bgp_path_info_mpath_cmp(*(struct bgp_path_info *const *)p1,
+				       *(struct bgp_path_info *const *)p2);
+}
+
+/*
+ * bgp_mp_list_sort
+ *
+ * Order the collected candidates by bgp_path_info_mpath_cmp.  A single
+ * qsort pass costs O(n log n) comparisons, against O(n^2) for the
+ * sorted-insertion this replaces - the comparator (nexthop plus peer
+ * address) is the expensive part at many-way ECMP widths.
+ */
+void bgp_mp_list_sort(struct list *mp_list)
+{
+	struct bgp_path_info *sarr[64], **arr = sarr;
+	unsigned int count, i = 0;
+	struct listnode *node;
+
+	assert(mp_list);
+	count = listcount(mp_list);
+	if (count < 2)
+		return;
+
+	if (count > array_size(sarr))
+		arr = XMALLOC(MTYPE_TMP, count * sizeof(*arr));
+
+	for (node = listhead(mp_list); node; node = listnextnode(node))
+		arr[i++] = listgetdata(node);
+
+	qsort(arr, count, sizeof(*arr), bgp_path_info_mpath_cmp_qsort);
+
+	i = 0;
+	for (node = listhead(mp_list); node; node = listnextnode(node))
+		node->data = arr[i++];
+
+	if (arr != sarr)
+		XFREE(MTYPE_TMP, arr);
 }
 
 /*
@@ -453,6 +496,9 @@ void bgp_path_info_mpath_update(struct bgp_node *rn,
 	cur_mpath = NULL;
 	old_mpath_count = 0;
 	prev_mpath = new_best;
+	/* the parallel walk below needs both lists ordered the same way */
+	if (mp_list)
+		bgp_mp_list_sort(mp_list);
 	mp_node = listhead(mp_list);
 	debug = bgp_debug_bestpath(&rn->p);
 
@@ -696,7 +742,7 @@ void bgp_path_info_mpath_aggregate_update(struct bgp_path_info *new_best,
 	uint8_t origin;
 	struct community *community, *commerge;
 	struct ecommunity *ecomm, *ecommerge;
-	struct lcommunity *lcomm, *lcommerge;
+	struct lcommunity *lcomm;
 	struct attr attr = {0};
 
 	if (old_best && (old_best != new_best)
@@ -768,11 +814,14 @@ void bgp_path_info_mpath_aggregate_update(struct bgp_path_info *new_best,
 			}
 			if (mpinfo->attr->lcommunity) {
 				if (lcomm) {
-					lcommerge = lcommunity_merge(
-						lcomm,
-						mpinfo->attr->lcommunity);
-					lcomm = lcommunity_uniq_sort(lcommerge);
-					lcommunity_free(&lcommerge);
+					struct lcommunity_builder b;
+
+					lcommunity_builder_init(&b);
+					lcommunity_builder_add(&b, lcomm);
+					lcommunity_builder_add(
+						&b, mpinfo->attr->lcommunity);
+					lcommunity_free(&lcomm);
+					lcomm = lcommunity_builder_finish(&b);
 				} else
 					lcomm = lcommunity_dup(
 						mpinfo->attr->lcommunity);
@@ -55,6 +55,7 @@ extern int bgp_path_info_nexthop_cmp(struct bgp_path_info *bpi1,
 extern void bgp_mp_list_init(struct list *);
 extern void bgp_mp_list_clear(struct list *);
 extern void bgp_mp_list_add(struct list *mp_list, struct bgp_path_info *mpinfo);
+extern void bgp_mp_list_sort(struct list *mp_list);
 extern void bgp_mp_dmed_deselect(struct bgp_path_info *dmed_best);
 extern void bgp_path_info_mpath_update(struct bgp_node *rn,
 				       struct bgp_path_info *new_best,
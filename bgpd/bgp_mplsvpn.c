@@ -24,6 +24,8 @@
 #include "prefix.h"
 #include "log.h"
 #include "memory.h"
+#include "hash.h"
+#include "jhash.h"
 #include "stream.h"
 #include "queue.h"
 #include "filter.h"
@@ -407,6 +409,174 @@ static int ecom_intersect(struct ecommunity *e1, struct ecommunity *e2)
 	return 0;
 }
 
+/*
+ * RT-to-subscriber index for VPN-to-VRF leaking.
+ *
+ * Maps each route target appearing in some VRF's fromvpn rtlist to the
+ * list of importing bgp instances, so a VPN route update or withdraw is
+ * delivered only to the VRFs whose import RT can match instead of being
+ * offered to every instance on bm->bgp.  The per-VRF checks in the leak
+ * functions remain authoritative; the index is only a superset filter.
+ * Mirrors the import_rt hashes used on the EVPN side.
+ */
+struct vpn_irt_node {
+	/* RT */
+	struct ecommunity_val rt;
+
+	/* List of bgp instances importing routes with this RT */
+	struct list *vrfs;
+};
+
+static struct hash *vpn_import_rt_hash;
+
+static unsigned int vpn_import_rt_hash_key_make(void *p)
+{
+	struct vpn_irt_node *irt = p;
+	char *pnt = irt->rt.val;
+
+	return jhash(pnt, ECOMMUNITY_SIZE, 0x9e3f7b2d);
+}
+
+static bool vpn_import_rt_hash_cmp(const void *p1, const void *p2)
+{
+	const struct vpn_irt_node *irt1 = p1;
+	const struct vpn_irt_node *irt2 = p2;
+
+	if (irt1 == NULL && irt2 == NULL)
+		return true;
+
+	if (irt1 == NULL || irt2 == NULL)
+		return false;
+
+	return (memcmp(irt1->rt.val, irt2->rt.val, ECOMMUNITY_SIZE) == 0);
+}
+
+static struct vpn_irt_node *vpn_import_rt_new(struct ecommunity_val *rt)
+{
+	struct vpn_irt_node *irt;
+
+	irt = XCALLOC(MTYPE_BGP_VPN_IMPORT_RT, sizeof(struct vpn_irt_node));
+
+	irt->rt = *rt;
+	irt->vrfs = list_new();
+
+	/* Add to hash */
+	if (!hash_get(vpn_import_rt_hash, irt, hash_alloc_intern)) {
+		XFREE(MTYPE_BGP_VPN_IMPORT_RT, irt);
+		return NULL;
+	}
+
+	return irt;
+}
+
+static void vpn_import_rt_free(struct vpn_irt_node *irt)
+{
+	hash_release(vpn_import_rt_hash, irt);
+	list_delete(&irt->vrfs);
+	XFREE(MTYPE_BGP_VPN_IMPORT_RT, irt);
+}
+
+static struct vpn_irt_node *lookup_vpn_import_rt(struct ecommunity_val *rt)
+{
+	struct vpn_irt_node *irt;
+	struct vpn_irt_node tmp;
+
+	memset(&tmp, 0, sizeof(struct vpn_irt_node));
+	memcpy(&tmp.rt, rt, ECOMMUNITY_SIZE);
+	irt = hash_lookup(vpn_import_rt_hash, &tmp);
+	return irt;
+}
+
+/* hash_iterate callback: drop the given bgp instance from one RT node */
+static void vpn_import_rt_unsub_one(struct hash_bucket *bucket, void *arg)
+{
+	struct vpn_irt_node *irt = bucket->data;
+	struct bgp *bgp = arg;
+
+	listnode_delete(irt->vrfs, bgp);
+	if (list_isempty(irt->vrfs))
+		vpn_import_rt_free(irt);
+}
+
+/*
+ * Remove an instance from the index entirely.  Must be called when an
+ * instance goes away; also the first half of a resubscribe.
+ */
+void vpn_rt_subscriber_remove(struct bgp *bgp_vrf)
+{
+	if (!vpn_import_rt_hash)
+		return;
+
+	hash_iterate(vpn_import_rt_hash, vpn_import_rt_unsub_one, bgp_vrf);
+}
+
+/*
+ * Bring the index in line with the instance's current fromvpn rtlists.
+ * Called from vpn_leak_postchange(); the previous rtlist may already be
+ * gone by then, so removal is a full scan rather than a per-RT lookup.
+ */
+void vpn_rt_subscriber_sync(struct bgp *bgp_vrf)
+{
+	afi_t afi;
+	int i;
+
+	if (!vpn_import_rt_hash)
+		return;
+
+	vpn_rt_subscriber_remove(bgp_vrf);
+
+	for (afi = AFI_IP; afi < AFI_MAX; ++afi) {
+		struct ecommunity *ecom;
+		struct vpn_irt_node *irt;
+		struct ecommunity_val *eval;
+
+		if (!vpn_leak_from_vpn_active(bgp_vrf, afi, NULL))
+			continue;
+
+		ecom = bgp_vrf->vpn_policy[afi]
+			       .rtlist[BGP_VPN_POLICY_DIR_FROMVPN];
+
+		for (i = 0; i < ecom->size; ++i) {
+			eval = (struct ecommunity_val *)(ecom->val
+							 + (i * ECOMMUNITY_SIZE));
+			irt = lookup_vpn_import_rt(eval);
+			if (!irt)
+				irt = vpn_import_rt_new(eval);
+			if (irt && !listnode_lookup(irt->vrfs, bgp_vrf))
+				listnode_add(irt->vrfs, bgp_vrf);
+		}
+	}
+}
+
+/*
+ * Collect into 'vrfs' every instance subscribed to any RT carried by
+ * 'ecom', without duplicates.
+ */
+static void vpn_rt_subscribers(struct ecommunity *ecom, struct list *vrfs)
+{
+	struct vpn_irt_node *irt;
+	struct ecommunity_val *eval;
+	struct listnode *node;
+	struct bgp *bgp;
+	int i;
+
+	if (!ecom)
+		return;
+
+	for (i = 0; i < ecom->size; ++i) {
+		eval = (struct ecommunity_val *)(ecom->val
+						 + (i * ECOMMUNITY_SIZE));
+		irt = lookup_vpn_import_rt(eval);
+		if (!irt)
+			continue;
+
+		for (ALL_LIST_ELEMENTS_RO(irt->vrfs, node, bgp)) {
+			if (!listnode_lookup(vrfs, bgp))
+				listnode_add(vrfs, bgp);
+		}
+	}
+}
+
 static bool labels_same(struct bgp_path_info *bpi, mpls_label_t *label,
 			uint32_t n)
 {
@@ -1229,7 +1399,8 @@ vpn_leak_to_vrf_update_onevrf(struct bgp *bgp_vrf,	    /* to */
 void vpn_leak_to_vrf_update(struct bgp *bgp_vpn,	    /* from */
 			    struct bgp_path_info *path_vpn) /* route */
 {
-	struct listnode *mnode, *mnnode;
+	struct listnode *mnode;
+	struct list *vrfs;
 	struct bgp *bgp;
 
 	int debug = BGP_DEBUG(vpn, VPN_LEAK_TO_VRF);
@@ -1237,14 +1408,17 @@ void vpn_leak_to_vrf_update(struct bgp *bgp_vpn,	    /* from */
 	if (debug)
 		zlog_debug("%s: start (path_vpn=%p)", __func__, path_vpn);
 
-	/* Loop over VRFs */
-	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp)) {
+	/* Loop over the VRFs subscribed to one of the route's RTs */
+	vrfs = list_new();
+	vpn_rt_subscribers(path_vpn->attr->ecommunity, vrfs);
+	for (ALL_LIST_ELEMENTS_RO(vrfs, mnode, bgp)) {
 
 		if (!path_vpn->extra
 		    || path_vpn->extra->bgp_orig != bgp) { /* no loop */
 			vpn_leak_to_vrf_update_onevrf(bgp, bgp_vpn, path_vpn);
 		}
 	}
+	list_delete(&vrfs);
 }
 
 void vpn_leak_to_vrf_withdraw(struct bgp *bgp_vpn,	    /* from */
@@ -1254,7 +1428,8 @@ void vpn_leak_to_vrf_withdraw(struct bgp *bgp_vpn,	    /* from */
 	afi_t afi;
 	safi_t safi = SAFI_UNICAST;
 	struct bgp *bgp;
-	struct listnode *mnode, *mnnode;
+	struct listnode *mnode;
+	struct list *vrfs;
 	struct bgp_node *bn;
 	struct bgp_path_info *bpi;
 	const char *debugmsg;
@@ -1290,8 +1465,10 @@ void vpn_leak_to_vrf_withdraw(struct bgp *bgp_vpn,	    /* from */
 	p = &path_vpn->net->p;
 	afi = family2afi(p->family);
 
-	/* Loop over VRFs */
-	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp)) {
+	/* Loop over the VRFs subscribed to one of the route's RTs */
+	vrfs = list_new();
+	vpn_rt_subscribers(path_vpn->attr->ecommunity, vrfs);
+	for (ALL_LIST_ELEMENTS_RO(vrfs, mnode, bgp)) {
 		if (!vpn_leak_from_vpn_active(bgp, afi, &debugmsg)) {
 			if (debug)
 				zlog_debug("%s: skipping: %s", __func__,
@@ -1332,6 +1509,7 @@ void vpn_leak_to_vrf_withdraw(struct bgp *bgp_vpn,	    /* from */
 		}
 		bgp_unlock_node(bn);
 	}
+	list_delete(&vrfs);
 }
 
 void vpn_leak_to_vrf_withdraw_all(struct bgp *bgp_vrf, /* to */
@@ -2229,6 +2407,10 @@ DEFUN (show_ip_bgp_vpn_rd_neighbor_advertised_routes,
 
 void bgp_mplsvpn_init(void)
 {
+	vpn_import_rt_hash =
+		hash_create(vpn_import_rt_hash_key_make, vpn_import_rt_hash_cmp,
+			    "BGP VPN Import RT Hash");
+
 	install_element(BGP_VPNV4_NODE, &vpnv4_network_cmd);
 	install_element(BGP_VPNV4_NODE, &vpnv4_network_route_map_cmd);
 	install_element(BGP_VPNV4_NODE, &no_vpnv4_network_cmd);
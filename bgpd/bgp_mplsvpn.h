@@ -75,6 +75,9 @@ extern void vpn_leak_to_vrf_update(struct bgp *bgp_vpn,
 extern void vpn_leak_to_vrf_withdraw(struct bgp *bgp_vpn,
 				     struct bgp_path_info *path_vpn);
 
+extern void vpn_rt_subscriber_sync(struct bgp *bgp_vrf);
+extern void vpn_rt_subscriber_remove(struct bgp *bgp_vrf);
+
 extern void vpn_leak_zebra_vrf_label_update(struct bgp *bgp, afi_t afi);
 extern void vpn_leak_zebra_vrf_label_withdraw(struct bgp *bgp, afi_t afi);
 extern int vpn_leak_label_callback(mpls_label_t label, void *lblid, bool alloc);
@@ -212,8 +215,10 @@ static inline void vpn_leak_postchange(vpn_policy_direction_t direction,
 	if (!bgp_vpn)
 		return;
 
-	if (direction == BGP_VPN_POLICY_DIR_FROMVPN)
+	if (direction == BGP_VPN_POLICY_DIR_FROMVPN) {
+		vpn_rt_subscriber_sync(bgp_vrf);
 		vpn_leak_to_vrf_update_all(bgp_vrf, bgp_vpn, afi);
+	}
 	if (direction == BGP_VPN_POLICY_DIR_TOVPN) {
 
 		if (bgp_vrf->vpn_policy[afi].tovpn_label !=
@@ -21,6 +21,7 @@
 #include <zebra.h>
 
 #include "thread.h"
+#include "frr_pthread.h"
 #include "sockunion.h"
 #include "sockopt.h"
 #include "memory.h"
@@ -51,14 +52,39 @@ extern struct zebra_privs_t bgpd_privs;
 
 static char *bgp_get_bound_name(struct peer *peer);
 
-/* BGP listening socket. */
+/* BGP listening socket.
+ *
+ * Accept events run on the I/O pool member recorded in ->fpt; with more
+ * than one I/O pthread, each listen address gets one SO_REUSEPORT
+ * socket per pool member (see bgp_listeners_shard()) so the kernel
+ * spreads incoming connections across the pool.
+ */
 struct bgp_listener {
 	int fd;
 	union sockunion su;
 	struct thread *thread;
 	struct bgp *bgp;
+	/* I/O pool member whose event loop owns the accept thread */
+	struct frr_pthread *fpt;
+	/* SO_REUSEPORT siblings exist (or this is one of them) */
+	bool sharded;
+	/* creation context, kept so shard siblings can be cloned */
+	vrf_id_t vrf_id;
+	char bindname[VRF_NAMSIZ + 1];
 };
 
+/* Connection accepted on an I/O pthread, queued to the main thread for
+ * peer matching and session setup. */
+struct bgp_accept_conn {
+	int fd;
+	union sockunion su;
+	/* VRF of the listener, when it was bound to a specific instance */
+	vrf_id_t vrf_id;
+	bool bgp_bound;
+};
+
+static int bgp_accept_process(struct thread *thread);
+
 /*
  * Set MD5 key for the socket, for the given IPv4 peer address.
  * If the password is NULL or zero-length, the option will be disabled.
@@ -117,14 +143,15 @@ static int bgp_md5_set_password(struct peer *peer, const char *password)
 	frr_elevate_privs(&bgpd_privs) {
 	/* Set or unset the password on the listen socket(s). Outbound
 	 * connections are taken care of in bgp_connect() below.
+	 * With a sharded listener setup the connection may arrive on any
+	 * of the sockets for the address family, so all of them need the
+	 * option.
 	 */
 		for (ALL_LIST_ELEMENTS_RO(bm->listen_sockets, node, listener))
 			if (listener->su.sa.sa_family
-			    == peer->su.sa.sa_family) {
+			    == peer->su.sa.sa_family)
 				ret = bgp_md5_set_socket(listener->fd,
 							 &peer->su, password);
-				break;
-			}
 	}
 	return ret;
 }
@@ -264,17 +291,18 @@ static int bgp_get_instance_for_inc_conn(int sock, struct bgp **bgp_inst)
 #endif
 }
 
-/* Accept bgp connection. */
+/*
+ * Accept bgp connection.  Runs on the I/O pool member owning the listen
+ * socket, so accept storms never wake the main thread once per SYN;
+ * only connections that survive the syscall stage are queued to it.
+ */
 static int bgp_accept(struct thread *thread)
 {
 	int bgp_sock;
 	int accept_sock;
 	union sockunion su;
 	struct bgp_listener *listener = THREAD_ARG(thread);
-	struct peer *peer;
-	struct peer *peer1;
-	char buf[SU_ADDRSTRLEN];
-	struct bgp *bgp = NULL;
+	struct bgp_accept_conn *conn;
 
 	sockunion_init(&su);
 
@@ -287,8 +315,8 @@ static int bgp_accept(struct thread *thread)
 	}
 	listener->thread = NULL;
 
-	thread_add_read(bm->master, bgp_accept, listener, accept_sock,
-			&listener->thread);
+	thread_add_read(listener->fpt->master, bgp_accept, listener,
+			accept_sock, &listener->thread);
 
 	/* Accept client connection. */
 	bgp_sock = sockunion_accept(accept_sock, &su);
@@ -300,24 +328,59 @@ static int bgp_accept(struct thread *thread)
 	}
 	set_nonblocking(bgp_sock);
 
+	/* Set socket send buffer size */
+	setsockopt_so_sendbuf(bgp_sock, BGP_SOCKET_SNDBUF_SIZE);
+
+	/*
+	 * Peer matching and session creation touch main-thread state;
+	 * hand the connected socket over.  The listener itself is not
+	 * passed along because it can be freed before the event runs.
+	 */
+	conn = XCALLOC(MTYPE_BGP_LISTENER, sizeof(*conn));
+	conn->fd = bgp_sock;
+	conn->su = su;
+	conn->bgp_bound = (listener->bgp != NULL);
+	conn->vrf_id = listener->bgp ? listener->bgp->vrf_id : VRF_DEFAULT;
+	thread_add_event(bm->master, bgp_accept_process, conn, 0, NULL);
+
+	return 0;
+}
+
+/* Second stage of connection acceptance, on the main thread: find the
+ * peer this connection belongs to and set the session up. */
+static int bgp_accept_process(struct thread *thread)
+{
+	struct bgp_accept_conn *conn = THREAD_ARG(thread);
+	int bgp_sock = conn->fd;
+	union sockunion su = conn->su;
+	struct peer *peer;
+	struct peer *peer1;
+	char buf[SU_ADDRSTRLEN];
+	struct bgp *bgp = NULL;
+
 	/* Obtain BGP instance this connection is meant for.
-	 * - if it is a VRF netns sock, then BGP is in listener structure
+	 * - if it came in on a VRF netns sock, look the instance back up
 	 * - otherwise, the bgp instance need to be demultiplexed
 	 */
-	if (listener->bgp)
-		bgp = listener->bgp;
-	else if (bgp_get_instance_for_inc_conn(bgp_sock, &bgp)) {
-		if (bgp_debug_neighbor_events(NULL))
-			zlog_debug(
-				"[Event] Could not get instance for incoming conn from %s",
-				inet_sutop(&su, buf));
-		close(bgp_sock);
-		return -1;
+	if (conn->bgp_bound) {
+		bgp = bgp_lookup_by_vrf_id(conn->vrf_id);
+		XFREE(MTYPE_BGP_LISTENER, conn);
+		if (!bgp) {
+			close(bgp_sock);
+			return -1;
+		}
+	} else {
+		XFREE(MTYPE_BGP_LISTENER, conn);
+		if (bgp_get_instance_for_inc_conn(bgp_sock, &bgp)) {
+			if (bgp_debug_neighbor_events(NULL))
+				zlog_debug(
+					"[Event] Could not get instance for incoming conn from %s",
+					inet_sutop(&su, buf));
+			close(bgp_sock);
+			return -1;
+		}
 	}
 
-	/* Set socket send buffer size */
-	setsockopt_so_sendbuf(bgp_sock, BGP_SOCKET_SNDBUF_SIZE);
-
 	/* Check remote IP address */
 	peer1 = peer_lookup(bgp, &su);
 
@@ -673,15 +736,132 @@ static int bgp_listener(int sock, struct sockaddr *sa, socklen_t salen,
 	if (bgp->vrf_id != VRF_DEFAULT && vrf_is_backend_netns())
 		listener->bgp = bgp;
 
+	/* remember how the socket was made so shard siblings can be
+	 * cloned with the same VRF binding */
+	listener->vrf_id = bgp->vrf_id;
+	if (bgp->inst_type == BGP_INSTANCE_TYPE_VRF)
+		strlcpy(listener->bindname, bgp->name,
+			sizeof(listener->bindname));
+
 	memcpy(&listener->su, sa, salen);
 	listener->thread = NULL;
-	thread_add_read(bm->master, bgp_accept, listener, sock,
+	listener->fpt = bgp_pth_io_pool[0];
+	thread_add_read(listener->fpt->master, bgp_accept, listener, sock,
 			&listener->thread);
 	listnode_add(bm->listen_sockets, listener);
 
 	return 0;
 }
 
+/*
+ * Clone an SO_REUSEPORT sibling of an existing listener onto the given
+ * I/O pool member.  Existing MD5 keys are replayed onto the new socket
+ * since an incoming connection may land on any sibling.
+ */
+static int bgp_listener_clone(struct bgp_listener *src,
+			      struct frr_pthread *fpt)
+{
+	socklen_t salen = (src->su.sa.sa_family == AF_INET)
+				  ? sizeof(struct sockaddr_in)
+				  : sizeof(struct sockaddr_in6);
+	struct bgp_listener *listener;
+	struct listnode *bnode;
+	struct peer *peer;
+	struct bgp *bgp;
+	int sock, ret, en;
+
+	frr_elevate_privs(&bgpd_privs) {
+		sock = vrf_socket(src->su.sa.sa_family, SOCK_STREAM, 0,
+				  src->vrf_id,
+				  src->bindname[0] ? src->bindname : NULL);
+	}
+	if (sock < 0) {
+		flog_err_sys(EC_LIB_SOCKET, "socket: %s", safe_strerror(errno));
+		return -1;
+	}
+
+	sockopt_ttl(src->su.sa.sa_family, sock, MAXTTL);
+	sockopt_reuseaddr(sock);
+	sockopt_reuseport(sock);
+
+	frr_elevate_privs(&bgpd_privs) {
+#ifdef IPTOS_PREC_INTERNETCONTROL
+		if (src->su.sa.sa_family == AF_INET)
+			setsockopt_ipv4_tos(sock, IPTOS_PREC_INTERNETCONTROL);
+		else if (src->su.sa.sa_family == AF_INET6)
+			setsockopt_ipv6_tclass(sock,
+					       IPTOS_PREC_INTERNETCONTROL);
+#endif
+		sockopt_v6only(src->su.sa.sa_family, sock);
+
+		ret = bind(sock, &src->su.sa, salen);
+		en = errno;
+
+		if (ret >= 0)
+			for (ALL_LIST_ELEMENTS_RO(bm->bgp, bnode, bgp))
+				frr_each (bgp_peers, &bgp->peer, peer)
+					if (peer->password
+					    && peer->su.sa.sa_family
+						       == src->su.sa.sa_family)
+						bgp_md5_set_socket(
+							sock, &peer->su,
+							peer->password);
+	}
+
+	if (ret < 0) {
+		flog_err_sys(EC_LIB_SOCKET, "bind: %s", safe_strerror(en));
+		close(sock);
+		return ret;
+	}
+
+	ret = listen(sock, SOMAXCONN);
+	if (ret < 0) {
+		flog_err_sys(EC_LIB_SOCKET, "listen: %s", safe_strerror(errno));
+		close(sock);
+		return ret;
+	}
+
+	listener = XCALLOC(MTYPE_BGP_LISTENER, sizeof(*listener));
+	listener->fd = sock;
+	listener->bgp = src->bgp;
+	listener->sharded = true;
+	listener->vrf_id = src->vrf_id;
+	strlcpy(listener->bindname, src->bindname, sizeof(listener->bindname));
+	listener->su = src->su;
+	listener->fpt = fpt;
+	thread_add_read(fpt->master, bgp_accept, listener, sock,
+			&listener->thread);
+	listnode_add(bm->listen_sockets, listener);
+
+	return 0;
+}
+
+/*
+ * Give every listen address one socket per I/O pool member; the kernel
+ * balances incoming connections across SO_REUSEPORT siblings, so accept
+ * load shards over the pool.  Called once the pool size is final, and
+ * from bgp_socket() for listeners created at runtime; listeners already
+ * sharded are left alone.
+ */
+void bgp_listeners_shard(void)
+{
+	struct listnode *node, *nnode;
+	struct bgp_listener *listener;
+	uint32_t i;
+
+	if (bgp_io_nthreads < 2)
+		return;
+
+	for (ALL_LIST_ELEMENTS(bm->listen_sockets, node, nnode, listener)) {
+		if (listener->sharded)
+			continue;
+		listener->sharded = true;
+
+		for (i = 1; i < bgp_io_nthreads; i++)
+			bgp_listener_clone(listener, bgp_pth_io_pool[i]);
+	}
+}
+
 /* IPv6 supported version of BGP server socket setup.  */
 int bgp_socket(struct bgp *bgp, unsigned short port, const char *address)
 {
@@ -745,6 +925,10 @@ int bgp_socket(struct bgp *bgp, unsigned short port, const char *address)
 			close(sock);
 	}
 	freeaddrinfo(ainfo_save);
+
+	/* no-op until the I/O pool has been sized */
+	bgp_listeners_shard();
+
 	if (count == 0 && bgp->inst_type != BGP_INSTANCE_TYPE_VRF) {
 		flog_err(
 			EC_LIB_SOCKET,
@@ -774,7 +958,9 @@ void bgp_close_vrf_socket(struct bgp *bgp)
 
 	for (ALL_LIST_ELEMENTS(bm->listen_sockets, node, next, listener)) {
 		if (listener->bgp == bgp) {
-			thread_cancel(listener->thread);
+			/* the accept thread lives on an I/O pthread */
+			thread_cancel_async(listener->fpt->master,
+					    &listener->thread, NULL);
 			close(listener->fd);
 			listnode_delete(bm->listen_sockets, listener);
 			XFREE(MTYPE_BGP_LISTENER, listener);
@@ -795,7 +981,9 @@ void bgp_close(void)
 	for (ALL_LIST_ELEMENTS(bm->listen_sockets, node, next, listener)) {
 		if (listener->bgp)
 			continue;
-		thread_cancel(listener->thread);
+		/* the accept thread lives on an I/O pthread */
+		thread_cancel_async(listener->fpt->master, &listener->thread,
+				    NULL);
 		close(listener->fd);
 		listnode_delete(bm->listen_sockets, listener);
 		XFREE(MTYPE_BGP_LISTENER, listener);
@@ -25,6 +25,7 @@
 
 extern int bgp_socket(struct bgp *bgp, unsigned short port,
 		      const char *address);
+extern void bgp_listeners_shard(void);
 extern void bgp_close_vrf_socket(struct bgp *bgp);
 extern void bgp_close(void);
 extern int bgp_connect(struct peer *);
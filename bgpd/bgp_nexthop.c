@@ -333,11 +333,12 @@ void bgp_connected_add(struct bgp *bgp, struct connected *ifc)
 	struct prefix *addr;
 	struct bgp_node *rn;
 	struct bgp_connected_ref *bc;
-	struct listnode *node, *nnode;
 	struct peer *peer;
 
 	addr = ifc->address;
 
+	bgp->connected_table_gen++;
+
 	p = *(CONNECTED_PREFIX(ifc));
 	if (addr->family == AF_INET) {
 		apply_mask_ipv4((struct prefix_ipv4 *)&p);
@@ -359,7 +360,7 @@ void bgp_connected_add(struct bgp *bgp, struct connected *ifc)
 			bgp_node_set_bgp_connected_ref_info(rn, bc);
 		}
 
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 			if (peer->conf_if
 			    && (strcmp(peer->conf_if, ifc->ifp->name) == 0)
 			    && peer->status != Established
@@ -403,6 +404,8 @@ void bgp_connected_delete(struct bgp *bgp, struct connected *ifc)
 
 	addr = ifc->address;
 
+	bgp->connected_table_gen++;
+
 	p = *(CONNECTED_PREFIX(ifc));
 	apply_mask(&p);
 	if (addr->family == AF_INET) {
@@ -472,74 +475,79 @@ int bgp_nexthop_self(struct bgp *bgp, struct in_addr nh_addr)
 	return 0;
 }
 
-int bgp_multiaccess_check_v4(struct in_addr nexthop, struct peer *peer)
+/*
+ * Longest match of the peer's session address in the instance's
+ * connected table, via the per-peer mirror.  The cached pointer is
+ * revalidated against bgp->connected_table_gen and the address it was
+ * computed for, so the checks below never walk the table for a peer
+ * whose subnet hasn't changed - they run once per path evaluation.
+ *
+ * The result is compare-only: no reference is held and a stale pointer
+ * is discarded on the generation check before it could be dereferenced.
+ * Workers applying announce batches must find the cache warm (the
+ * dispatcher refreshes it on the main thread before forking).
+ */
+struct bgp_node *bgp_peer_connected_match(struct peer *peer)
 {
-	struct bgp_node *rn1;
-	struct bgp_node *rn2;
+	struct bgp *bgp = peer->bgp;
 	struct prefix p;
-	int ret;
+
+	if (peer->connected_rn_set
+	    && peer->connected_rn_gen == bgp->connected_table_gen
+	    && sockunion_same(&peer->connected_rn_su, &peer->su))
+		return peer->connected_rn;
 
 	p.family = AF_INET;
 	p.prefixlen = IPV4_MAX_BITLEN;
-	p.u.prefix4 = nexthop;
+	p.u.prefix4 = peer->su.sin.sin_addr;
 
-	rn1 = bgp_node_match(peer->bgp->connected_table[AFI_IP], &p);
-	if (!rn1)
-		return 0;
+	peer->connected_rn =
+		bgp_node_match_nolock(bgp->connected_table[AFI_IP], &p);
+	peer->connected_rn_su = peer->su;
+	peer->connected_rn_gen = bgp->connected_table_gen;
+	peer->connected_rn_set = true;
+
+	return peer->connected_rn;
+}
+
+int bgp_multiaccess_check_v4(struct in_addr nexthop, struct peer *peer)
+{
+	struct bgp_node *rn1;
+	struct prefix p;
 
 	p.family = AF_INET;
 	p.prefixlen = IPV4_MAX_BITLEN;
-	p.u.prefix4 = peer->su.sin.sin_addr;
+	p.u.prefix4 = nexthop;
 
-	rn2 = bgp_node_match(peer->bgp->connected_table[AFI_IP], &p);
-	if (!rn2) {
-		bgp_unlock_node(rn1);
+	rn1 = bgp_node_match_nolock(peer->bgp->connected_table[AFI_IP], &p);
+	if (!rn1)
 		return 0;
-	}
-
-	ret = (rn1 == rn2) ? 1 : 0;
 
-	bgp_unlock_node(rn1);
-	bgp_unlock_node(rn2);
-
-	return (ret);
+	return (rn1 == bgp_peer_connected_match(peer)) ? 1 : 0;
 }
 
 int bgp_subgrp_multiaccess_check_v4(struct in_addr nexthop,
 				    struct update_subgroup *subgrp)
 {
-	struct bgp_node *rn1, *rn2;
+	struct bgp_node *rn1;
 	struct peer_af *paf;
-	struct prefix p, np;
+	struct prefix np;
 	struct bgp *bgp;
 
 	np.family = AF_INET;
 	np.prefixlen = IPV4_MAX_BITLEN;
 	np.u.prefix4 = nexthop;
 
-	p.family = AF_INET;
-	p.prefixlen = IPV4_MAX_BITLEN;
-
 	bgp = SUBGRP_INST(subgrp);
-	rn1 = bgp_node_match(bgp->connected_table[AFI_IP], &np);
+	rn1 = bgp_node_match_nolock(bgp->connected_table[AFI_IP], &np);
 	if (!rn1)
 		return 0;
 
 	SUBGRP_FOREACH_PEER (subgrp, paf) {
-		p.u.prefix4 = paf->peer->su.sin.sin_addr;
-
-		rn2 = bgp_node_match(bgp->connected_table[AFI_IP], &p);
-		if (rn1 == rn2) {
-			bgp_unlock_node(rn1);
-			bgp_unlock_node(rn2);
+		if (rn1 == bgp_peer_connected_match(paf->peer))
 			return 1;
-		}
-
-		if (rn2)
-			bgp_unlock_node(rn2);
 	}
 
-	bgp_unlock_node(rn1);
 	return 0;
 }
 
@@ -741,6 +749,11 @@ void bgp_scan_init(struct bgp *bgp)
 			bgp_table_init(bgp, afi, SAFI_UNICAST);
 		bgp->connected_table[afi] = bgp_table_init(bgp, afi,
 			SAFI_UNICAST);
+		/* matched against for every EBGP nexthop / multiaccess
+		 * check; v4 lookups dominate, so index them */
+		if (afi == AFI_IP)
+			route_table_use_dindex(
+				bgp->connected_table[afi]->route_table);
 		bgp->import_check_table[afi] =
 			bgp_table_init(bgp, afi, SAFI_UNICAST);
 	}
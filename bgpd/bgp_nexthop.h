@@ -54,6 +54,7 @@ struct bgp_nexthop_cache {
 #define BGP_STATIC_ROUTE              (1 << 4)
 #define BGP_STATIC_ROUTE_EXACT_MATCH  (1 << 5)
 #define BGP_NEXTHOP_LABELED_VALID     (1 << 6)
+#define BGP_NEXTHOP_EVAL_PENDING      (1 << 7)
 
 	uint16_t change_flags;
 
@@ -79,6 +80,11 @@ extern void bgp_connected_delete(struct bgp *bgp, struct connected *c);
 extern int bgp_subgrp_multiaccess_check_v4(struct in_addr nexthop,
 					   struct update_subgroup *subgrp);
 extern int bgp_multiaccess_check_v4(struct in_addr, struct peer *);
+/* Cached connected-subnet match for the peer's address; compare-only
+ * result, see bgp_nexthop.c.  Dispatchers that run the multiaccess
+ * checks on worker threads call this up front to warm the cache.
+ */
+extern struct bgp_node *bgp_peer_connected_match(struct peer *peer);
 extern int bgp_config_write_scan_time(struct vty *);
 extern int bgp_nexthop_self(struct bgp *, struct in_addr);
 extern struct bgp_nexthop_cache *bnc_new(void);
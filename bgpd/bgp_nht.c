@@ -325,6 +325,40 @@ void bgp_delete_connected_nexthop(afi_t afi, struct peer *peer)
 	}
 }
 
+/* Run the consolidated evaluation over one nexthop cache table. */
+static void bgp_nht_eval_table(struct bgp_table *table)
+{
+	struct bgp_nexthop_cache *bnc;
+	struct bgp_node *rn;
+
+	for (rn = bgp_table_top(table); rn; rn = bgp_route_next(rn)) {
+		bnc = bgp_node_get_bgp_nexthop_info(rn);
+		if (!bnc || !CHECK_FLAG(bnc->flags, BGP_NEXTHOP_EVAL_PENDING))
+			continue;
+
+		UNSET_FLAG(bnc->flags, BGP_NEXTHOP_EVAL_PENDING);
+		evaluate_paths(bnc);
+	}
+}
+
+/*
+ * Fires when the next-hop dampening window closes: every nexthop
+ * flagged while it was open gets one evaluate_paths() pass, however
+ * many zebra updates (or flaps) it saw in the meantime.
+ */
+static int bgp_nht_eval_timer(struct thread *thread)
+{
+	struct bgp *bgp = THREAD_ARG(thread);
+	afi_t afi;
+
+	for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+		bgp_nht_eval_table(bgp->nexthop_cache_table[afi]);
+		bgp_nht_eval_table(bgp->import_check_table[afi]);
+	}
+
+	return 0;
+}
+
 void bgp_parse_nexthop_update(int command, vrf_id_t vrf_id)
 {
 	struct bgp_node *rn = NULL;
@@ -387,7 +421,13 @@ void bgp_parse_nexthop_update(int command, vrf_id_t vrf_id)
 
 	bgp_unlock_node(rn);
 	bnc->last_update = bgp_clock();
-	bnc->change_flags = 0;
+
+	/* If an evaluation of this nexthop is already pending, keep the
+	 * change flags accumulated so far so a flap within the dampening
+	 * window is still seen as a change by the consolidated pass.
+	 */
+	if (!CHECK_FLAG(bnc->flags, BGP_NEXTHOP_EVAL_PENDING))
+		bnc->change_flags = 0;
 
 	/* debug print the input */
 	if (BGP_DEBUG(nht, NHT)) {
@@ -492,7 +532,19 @@ void bgp_parse_nexthop_update(int command, vrf_id_t vrf_id)
 		bnc->nexthop = NULL;
 	}
 
-	evaluate_paths(bnc);
+	/* During IGP convergence zebra delivers updates in bursts; with a
+	 * dampening window configured, mark the nexthop and let one
+	 * consolidated pass handle the whole batch when the window
+	 * closes.  Without one, evaluate immediately as before.
+	 */
+	if (bgp->nht_eval_delay) {
+		SET_FLAG(bnc->flags, BGP_NEXTHOP_EVAL_PENDING);
+		if (!bgp->t_nht_eval)
+			thread_add_timer_msec(bm->master, bgp_nht_eval_timer,
+					      bgp, bgp->nht_eval_delay,
+					      &bgp->t_nht_eval);
+	} else
+		evaluate_paths(bnc);
 }
 
 /*
@@ -735,6 +787,7 @@ static void evaluate_paths(struct bgp_nexthop_cache *bnc)
 		 */
 
 		int bnc_is_valid_nexthop = 0;
+		int path_valid_changed = 0;
 
 		if (safi == SAFI_UNICAST &&
 			path->sub_type == BGP_ROUTE_IMPORTED &&
@@ -757,8 +810,10 @@ static void evaluate_paths(struct bgp_nexthop_cache *bnc)
 				(bnc_is_valid_nexthop ? "" : "not "));
 		}
 
-		if ((CHECK_FLAG(path->flags, BGP_PATH_VALID) ? 1 : 0)
-		    != bnc_is_valid_nexthop) {
+		path_valid_changed = (CHECK_FLAG(path->flags, BGP_PATH_VALID)
+				      ? 1 : 0) != bnc_is_valid_nexthop;
+
+		if (path_valid_changed) {
 			if (CHECK_FLAG(path->flags, BGP_PATH_VALID)) {
 				bgp_aggregate_decrement(bgp_path, &rn->p,
 							path, afi, safi);
@@ -784,6 +839,20 @@ static void evaluate_paths(struct bgp_nexthop_cache *bnc)
 		    || CHECK_FLAG(bnc->change_flags, BGP_NEXTHOP_CHANGED))
 			SET_FLAG(path->flags, BGP_PATH_IGP_CHANGED);
 
+		/*
+		 * If neither the path's validity nor anything the nexthop
+		 * contributes to it (resolved nexthops, IGP metric,
+		 * connectedness) changed, best-path selection for this net
+		 * cannot come to a different conclusion - don't queue it.
+		 */
+		if (!path_valid_changed
+		    && !CHECK_FLAG(bnc->change_flags, BGP_NEXTHOP_CHANGED)
+		    && !CHECK_FLAG(bnc->change_flags,
+				   BGP_NEXTHOP_METRIC_CHANGED)
+		    && !CHECK_FLAG(bnc->change_flags,
+				   BGP_NEXTHOP_CONNECTED_CHANGED))
+			continue;
+
 		bgp_process(bgp_path, rn, afi, safi);
 	}
 
@@ -58,10 +58,12 @@
 #include "bgpd/bgp_advertise.h"
 #include "bgpd/bgp_vty.h"
 #include "bgpd/bgp_updgrp.h"
+#include "bgpd/bgp_bestpath.h"
 #include "bgpd/bgp_label.h"
 #include "bgpd/bgp_io.h"
 #include "bgpd/bgp_keepalives.h"
 #include "bgpd/bgp_flowspec.h"
+#include "bgpd/bgp_arena.h"
 
 /**
  * Sets marker and type fields for a BGP message.
@@ -164,7 +166,6 @@ static struct stream *bgp_update_packet_eor(struct peer *peer, afi_t afi,
  * peer. Ends the update-delay if all expected peers are done with EORs. */
 void bgp_check_update_delay(struct bgp *bgp)
 {
-	struct listnode *node, *nnode;
 	struct peer *peer = NULL;
 
 	if (bgp_debug_neighbor_events(peer))
@@ -182,7 +183,7 @@ void bgp_check_update_delay(struct bgp *bgp)
 		 */
 		if (bgp->t_establish_wait
 		    || (bgp->v_establish_wait == bgp->v_update_delay))
-			for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+			frr_each_safe (bgp_peers, &bgp->peer, peer) {
 				if (CHECK_FLAG(peer->flags,
 					       PEER_FLAG_CONFIG_NODE)
 				    && !CHECK_FLAG(peer->flags,
@@ -325,6 +326,16 @@ static void bgp_write_proceed_actions(struct peer *peer)
 	struct bpacket *next_pkt;
 	struct update_subgroup *subgrp;
 
+	/*
+	 * If the peer already has a full write quantum staged, let the
+	 * I/O thread work that off first; it restarts packet generation
+	 * as soon as the output queue drains (bgp_process_writes).
+	 */
+	if (stream_fifo_count_safe(peer->obuf)
+	    >= atomic_load_explicit(&peer->bgp->wpkt_quanta,
+				    memory_order_relaxed))
+		return;
+
 	FOREACH_AFI_SAFI (afi, safi) {
 		paf = peer_af_find(peer, afi, safi);
 		if (!paf)
@@ -335,8 +346,22 @@ static void bgp_write_proceed_actions(struct peer *peer)
 
 		next_pkt = paf->next_pkt_to_send;
 		if (next_pkt && next_pkt->buffer) {
-			BGP_TIMER_ON(peer->t_generate_updgrp_packets,
-				     bgp_generate_updgrp_packets, 0);
+			/*
+			 * If the pacing engine throttled this member,
+			 * come back when its bucket has earned another
+			 * token rather than immediately.
+			 */
+			uint32_t wait = subgroup_pacing_wait_msec(paf);
+
+			if (wait && peer->status != Deleted)
+				thread_add_timer_msec(
+					bm->master,
+					bgp_generate_updgrp_packets, peer,
+					wait,
+					&peer->t_generate_updgrp_packets);
+			else
+				BGP_TIMER_ON(peer->t_generate_updgrp_packets,
+					     bgp_generate_updgrp_packets, 0);
 			return;
 		}
 
@@ -397,6 +422,27 @@ int bgp_generate_updgrp_packets(struct thread *thread)
 	if (peer->bgp->main_peers_update_hold)
 		return 0;
 
+	/*
+	 * Don't stage a fresh quantum of per-peer packet copies while the
+	 * output queue still holds one.  The encoded packet stays shared
+	 * on the subgroup packet queue in the meantime, so a slow peer
+	 * keeps a cursor into that queue rather than a private copy of
+	 * everything still to be sent - this is what bounds the memory
+	 * used for staging during a full-table announce.
+	 */
+	if (stream_fifo_count_safe(peer->obuf) >= wpq)
+		return 0;
+
+	/*
+	 * Pre-build the instance's pending subgroup packets on the
+	 * worker pool before draining; the loop below - and every peer
+	 * scheduled behind this one - then mostly just reformats
+	 * finished streams onto obufs.  Without workers, packets are
+	 * built on demand below as before.
+	 */
+	if (bgp_bestpath_pool_active())
+		subgroup_build_packets_parallel(peer->bgp);
+
 	do {
 		s = NULL;
 		FOREACH_AFI_SAFI (afi, safi) {
@@ -451,6 +497,15 @@ int bgp_generate_updgrp_packets(struct thread *thread)
 			}
 
 
+			/*
+			 * Ask the subgroup pacing engine whether this
+			 * member may emit now; a depleted bucket defers
+			 * the packet and bgp_write_proceed_actions()
+			 * reschedules us for when the bucket refills.
+			 */
+			if (!subgroup_pacing_take(paf, 1))
+				continue;
+
 			/* Found a packet template to send, overwrite
 			 * packet with appropriate attributes from peer
 			 * and advance peer */
@@ -1418,11 +1473,17 @@ static int bgp_update_receive(struct peer *peer, bgp_size_t size)
 	s = peer->curr;
 	end = stream_pnt(s) + size;
 
+	/* The I/O pthread vets the framing of most UPDATEs as it
+	 * assembles them; re-checking the section lengths here would be
+	 * pure overhead for those.
+	 */
+	bool prevalidated = CHECK_FLAG(s->flags, BGP_PACKET_PREVALIDATED);
+
 	/* RFC1771 6.3 If the Unfeasible Routes Length or Total Attribute
 	   Length is too large (i.e., if Unfeasible Routes Length + Total
 	   Attribute Length + 23 exceeds the message Length), then the Error
 	   Subcode is set to Malformed Attribute List.  */
-	if (stream_pnt(s) + 2 > end) {
+	if (!prevalidated && stream_pnt(s) + 2 > end) {
 		flog_err(EC_BGP_UPDATE_RCV,
 			 "%s [Error] Update packet error"
 			 " (packet length is short for unfeasible length)",
@@ -1436,7 +1497,7 @@ static int bgp_update_receive(struct peer *peer, bgp_size_t size)
 	withdraw_len = stream_getw(s);
 
 	/* Unfeasible Route Length check. */
-	if (stream_pnt(s) + withdraw_len > end) {
+	if (!prevalidated && stream_pnt(s) + withdraw_len > end) {
 		flog_err(EC_BGP_UPDATE_RCV,
 			 "%s [Error] Update packet error"
 			 " (packet unfeasible length overflow %d)",
@@ -1456,7 +1517,7 @@ static int bgp_update_receive(struct peer *peer, bgp_size_t size)
 	}
 
 	/* Attribute total length check. */
-	if (stream_pnt(s) + 2 > end) {
+	if (!prevalidated && stream_pnt(s) + 2 > end) {
 		flog_warn(
 			EC_BGP_UPDATE_PACKET_SHORT,
 			"%s [Error] Packet Error (update packet is short for attribute length)",
@@ -1470,7 +1531,7 @@ static int bgp_update_receive(struct peer *peer, bgp_size_t size)
 	attribute_len = stream_getw(s);
 
 	/* Attribute length check. */
-	if (stream_pnt(s) + attribute_len > end) {
+	if (!prevalidated && stream_pnt(s) + attribute_len > end) {
 		flog_warn(
 			EC_BGP_UPDATE_PACKET_LONG,
 			"%s [Error] Packet Error (update packet attribute length overflow %d)",
@@ -1639,7 +1700,7 @@ static int bgp_update_receive(struct peer *peer, bgp_size_t size)
 	peer->update_time = bgp_clock();
 
 	/* Rearm holdtime timer */
-	BGP_TIMER_OFF(peer->t_holdtime);
+	bgp_fsm_timer_off(&peer->ft_holdtime);
 	bgp_timer_set(peer);
 
 	return Receive_UPDATE_message;
@@ -1739,8 +1800,6 @@ static int bgp_route_refresh_receive(struct peer *peer, bgp_size_t size)
 	safi_t safi;
 	struct stream *s;
 	struct peer_af *paf;
-	struct update_group *updgrp;
-	struct peer *updgrp_peer;
 
 	/* If peer does not have the capability, send notification. */
 	if (!CHECK_FLAG(peer->cap, PEER_CAP_REFRESH_ADV)) {
@@ -1835,6 +1894,12 @@ static int bgp_route_refresh_receive(struct peer *peer, bgp_size_t size)
 				sprintf(name, "%s.%d.%d", peer->host, afi,
 					safi);
 
+				/* The received list is about to be modified or
+				 * destroyed; our update group's conf peer may
+				 * reference it and must let go first.
+				 */
+				update_group_orf_plist_detach(peer, afi, safi);
+
 				while (p_pnt < p_end) {
 					/* If the ORF entry is malformed, want
 					 * to read as much of it
@@ -1975,13 +2040,14 @@ static int bgp_route_refresh_receive(struct peer *peer, bgp_size_t size)
 
 	paf = peer_af_find(peer, afi, safi);
 	if (paf && paf->subgroup) {
-		if (peer->orf_plist[afi][safi]) {
-			updgrp = PAF_UPDGRP(paf);
-			updgrp_peer = UPDGRP_PEER(updgrp);
-			updgrp_peer->orf_plist[afi][safi] =
-				peer->orf_plist[afi][safi];
-		}
+		/* The ORF filter content is part of the peer's update-group
+		 * membership; a changed filter may move it into a group of
+		 * peers that sent the same entries.
+		 */
+		update_group_adjust_peer(paf);
+	}
 
+	if (paf && paf->subgroup) {
 		/* If the peer is configured for default-originate clear the
 		 * SUBGRP_STATUS_DEFAULT_ORIGINATE flag so that we will
 		 * re-advertise the
@@ -1994,7 +2060,7 @@ static int bgp_route_refresh_receive(struct peer *peer, bgp_size_t size)
 	}
 
 	/* Perform route refreshment to the peer */
-	bgp_announce_route(peer, afi, safi);
+	bgp_announce_route(peer, afi, safi, true);
 
 	/* No FSM action necessary */
 	return BGP_PACKET_NOOP;
@@ -2092,7 +2158,7 @@ static int bgp_capability_msg_parse(struct peer *peer, uint8_t *pnt,
 				peer->afc_recv[afi][safi] = 1;
 				if (peer->afc[afi][safi]) {
 					peer->afc_nego[afi][safi] = 1;
-					bgp_announce_route(peer, afi, safi);
+					bgp_announce_route(peer, afi, safi, false);
 				}
 			} else {
 				peer->afc_recv[afi][safi] = 0;
@@ -2192,6 +2258,11 @@ int bgp_process_packet(struct thread *thread)
 
 	unsigned int processed = 0;
 
+	/* Parse-time temporaries for the whole burst come from the arena
+	 * and are recycled in one go once the quantum is drained.
+	 */
+	bgp_parse_arena_begin();
+
 	while (processed < rpkt_quanta_old) {
 		uint8_t type = 0;
 		bgp_size_t size;
@@ -2203,8 +2274,10 @@ int bgp_process_packet(struct thread *thread)
 		}
 		pthread_mutex_unlock(&peer->io_mtx);
 
-		if (peer->curr == NULL) // no packets to process, hmm...
+		if (peer->curr == NULL) { // no packets to process, hmm...
+			bgp_parse_arena_end();
 			return 0;
+		}
 
 		/* skip the marker and copy the packet length */
 		stream_forward_getp(peer->curr, BGP_MARKER_SIZE);
@@ -2237,6 +2310,8 @@ int bgp_process_packet(struct thread *thread)
 			atomic_fetch_add_explicit(&peer->update_in, 1,
 						  memory_order_relaxed);
 			peer->readtime = monotime(NULL);
+			/* refund the I/O thread's pre-parse NLRI estimate */
+			bgp_io_nlri_dequeue(peer, peer->curr);
 			mprc = bgp_update_receive(peer, size);
 			if (mprc == BGP_Stop)
 				flog_err(
@@ -2316,6 +2391,8 @@ int bgp_process_packet(struct thread *thread)
 			break;
 	}
 
+	bgp_parse_arena_end();
+
 	if (fsm_update_result != FSM_PEER_TRANSFERRED
 	    && fsm_update_result != FSM_PEER_STOPPED) {
 		pthread_mutex_lock(&peer->io_mtx);
@@ -25,6 +25,13 @@
 #define BGP_TOTAL_ATTR_LEN    2U
 #define BGP_UNFEASIBLE_LEN    2U
 
+/* Stream flag set by the I/O pthread on UPDATEs whose framing (section
+ * lengths, attribute boundaries and flag octets, IPv4-unicast NLRI
+ * walk) already passed pre-validation; lets the main thread skip those
+ * checks.
+ */
+#define BGP_PACKET_PREVALIDATED (1 << 0)
+
 /* When to refresh */
 #define REFRESH_IMMEDIATE 1
 #define REFRESH_DEFER     2 
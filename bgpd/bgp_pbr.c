@@ -699,11 +699,39 @@ int bgp_pbr_build_and_validate_entry(struct prefix *p,
 	afi_t afi = AFI_IP;
 	struct bgp_pbr_entry_action *api_action_redirect_ip = NULL;
 
-	/* extract match from flowspec entries */
-	ret = bgp_flowspec_match_rules_fill((uint8_t *)p->u.prefix_flowspec.ptr,
-				     p->u.prefix_flowspec.prefixlen, api);
-	if (ret < 0)
-		return -1;
+	/* extract match from flowspec entries.  The match rules only
+	 * depend on the prefix, so the decoded form is cached on the path
+	 * and reused whenever the path is re-policied or displayed.
+	 */
+	if (path && path->extra && path->extra->bgp_fs_entry) {
+		/* afi/safi/vrf_id are filled in by the caller, not by the
+		 * decode; carry them over the cached copy.
+		 */
+		afi_t api_afi = api->afi;
+		safi_t api_safi = api->safi;
+		vrf_id_t vrf_id = api->vrf_id;
+
+		memcpy(api, path->extra->bgp_fs_entry, sizeof(*api));
+		api->afi = api_afi;
+		api->safi = api_safi;
+		api->vrf_id = vrf_id;
+	} else {
+		ret = bgp_flowspec_match_rules_fill(
+				(uint8_t *)p->u.prefix_flowspec.ptr,
+				p->u.prefix_flowspec.prefixlen, api);
+		if (ret < 0)
+			return -1;
+		if (path) {
+			struct bgp_path_info_extra *extra =
+				bgp_path_info_extra_get(path);
+
+			if (!extra->bgp_fs_entry)
+				extra->bgp_fs_entry = XCALLOC(
+					MTYPE_BGP_FLOWSPEC_COMPILED,
+					sizeof(*api));
+			memcpy(extra->bgp_fs_entry, api, sizeof(*api));
+		}
+	}
 	/* extract actiosn from flowspec ecom list */
 	if (path && path->attr && path->attr->ecommunity) {
 		ecom = path->attr->ecommunity;
@@ -0,0 +1,657 @@
+/* BGP MRT replay harness
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* Feeds a captured MRT file (the output of "dump bgp all" / "dump bgp
+ * routes-mrt", see bgp_dump.c) straight into the RIB via the same
+ * bgp_attr_parse()/bgp_nlri_parse() path that live sessions use, bypassing
+ * the socket layer entirely.  Updates are attributed to synthetic peers so
+ * that entries from different dump peers keep distinct paths; convergence
+ * is measured from the start of the feed to the last bestpath run after
+ * the process queue drains.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "log.h"
+#include "memory.h"
+#include "prefix.h"
+#include "sockunion.h"
+#include "stream.h"
+#include "thread.h"
+#include "workqueue.h"
+#include "linklist.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_dump.h"
+#include "bgpd/bgp_memory.h"
+#include "bgpd/bgp_packet.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_vty.h"
+#include "bgpd/bgp_replay.h"
+
+DEFINE_MTYPE_STATIC(BGPD, BGP_REPLAY, "BGP replay state")
+
+/* MRT record types fed by this module; the full list lives in
+ * enum MRT_MSG_TYPES in bgp_dump.c (and bgp_btoa.c) */
+#define MRT_MSG_TABLE_DUMP    12
+#define MRT_MSG_TABLE_DUMP_V2 13
+
+bool bgp_replay_active;
+
+struct bgp_replay_stats {
+	char path[MAXPATHLEN];
+
+	struct timeval start;
+	struct timeval feed_done;
+	struct timeval first_bestpath;
+	struct timeval last_bestpath;
+
+	unsigned long records;
+	unsigned long msgs;
+	unsigned long rib_entries;
+	unsigned long withdraw_msgs;
+	unsigned long skipped;
+	unsigned long errors;
+	unsigned long bestpaths;
+
+	unsigned long attrs_before;
+	unsigned long attrs_after;
+	long maxrss_before; /* kB, getrusage() */
+	long maxrss_after;
+
+	bool feeding_done;
+	bool complete;
+};
+
+static struct bgp_replay_stats replay;
+
+/* synthetic peers, keyed by (address, AS); kept across replays and never
+ * deleted - deleting one would withdraw everything it fed */
+static struct list *replay_peers;
+
+/* peers by index from the most recent TABLE_DUMP_V2 peer index table */
+static struct peer **replay_pit;
+static uint16_t replay_pit_count;
+
+static struct peer *bgp_replay_peer(struct bgp *bgp, union sockunion *su,
+				    as_t as, bool as4)
+{
+	struct listnode *node;
+	struct peer *peer;
+	char buf[SU_ADDRSTRLEN];
+	char host[SU_ADDRSTRLEN + 8];
+
+	for (ALL_LIST_ELEMENTS_RO(replay_peers, node, peer))
+		if (peer->as == as && sockunion_same(&peer->su, su))
+			break;
+
+	if (!peer) {
+		peer = peer_create_accept(bgp);
+		peer->su = *su;
+		peer->as = as;
+		peer->as_type = AS_SPECIFIED;
+		peer->local_as = bgp->as;
+		peer->local_id = bgp->router_id;
+		peer->status = Established;
+		peer->afc[AFI_IP][SAFI_UNICAST] = 1;
+		peer->afc[AFI_IP6][SAFI_UNICAST] = 1;
+		peer->afc_nego[AFI_IP][SAFI_UNICAST] = 1;
+		peer->afc_nego[AFI_IP6][SAFI_UNICAST] = 1;
+
+		sockunion2str(su, buf, sizeof(buf));
+		snprintf(host, sizeof(host), "replay:%s", buf);
+		peer->host = XSTRDUP(MTYPE_BGP_PEER_HOST, host);
+
+		listnode_add(replay_peers, peer);
+	}
+
+	/* AS path encoding follows the record, not the peer's history */
+	if (as4)
+		SET_FLAG(peer->cap, PEER_CAP_AS4_RCV | PEER_CAP_AS4_ADV);
+	else
+		UNSET_FLAG(peer->cap, PEER_CAP_AS4_RCV | PEER_CAP_AS4_ADV);
+
+	return peer;
+}
+
+static void bgp_replay_finish(void)
+{
+	struct rusage ru;
+
+	replay.attrs_after = attr_count();
+	if (!getrusage(RUSAGE_SELF, &ru))
+		replay.maxrss_after = ru.ru_maxrss;
+
+	replay.complete = true;
+	bgp_replay_active = false;
+
+	zlog_info(
+		"replay of %s complete: %lu records, %lu bestpath runs, %lu attrs interned",
+		replay.path, replay.records, replay.bestpaths,
+		replay.attrs_after - replay.attrs_before);
+}
+
+void bgp_replay_bestpath_tick(void)
+{
+	if (!bgp_replay_active)
+		return;
+
+	replay.bestpaths++;
+	if (!timerisset(&replay.first_bestpath))
+		monotime(&replay.first_bestpath);
+	monotime(&replay.last_bestpath);
+}
+
+void bgp_replay_queue_drained(void)
+{
+	if (!bgp_replay_active || !replay.feeding_done)
+		return;
+
+	bgp_replay_finish();
+}
+
+/* parse one BGP UPDATE body the way bgp_update_receive() does; s is
+ * positioned at the withdrawn-routes length, end bounds the message */
+static void bgp_replay_feed_update(struct peer *peer, struct stream *s,
+				   size_t end)
+{
+	bgp_size_t withdraw_len, attribute_len, update_len;
+	struct bgp_nlri withdraw, update, mp_update, mp_withdraw;
+	struct attr attr;
+	bgp_attr_parse_ret_t ret = BGP_ATTR_PARSE_PROCEED;
+
+	memset(&withdraw, 0, sizeof(withdraw));
+	memset(&update, 0, sizeof(update));
+	memset(&mp_update, 0, sizeof(mp_update));
+	memset(&mp_withdraw, 0, sizeof(mp_withdraw));
+	memset(&attr, 0, sizeof(attr));
+	attr.label_index = BGP_INVALID_LABEL_INDEX;
+	attr.label = MPLS_INVALID_LABEL;
+
+	withdraw_len = stream_getw(s);
+	if (withdraw_len) {
+		withdraw.afi = AFI_IP;
+		withdraw.safi = SAFI_UNICAST;
+		withdraw.nlri = stream_pnt(s);
+		withdraw.length = withdraw_len;
+		stream_forward_getp(s, withdraw_len);
+	}
+
+	attribute_len = stream_getw(s);
+	if (attribute_len) {
+		size_t attr_start = stream_get_getp(s);
+
+		peer->curr = s;
+		ret = bgp_attr_parse(peer, &attr, attribute_len, &mp_update,
+				     &mp_withdraw);
+		peer->curr = NULL;
+		stream_set_getp(s, attr_start + attribute_len);
+
+		if (ret == BGP_ATTR_PARSE_ERROR) {
+			replay.errors++;
+			bgp_attr_unintern_sub(&attr);
+			return;
+		}
+	}
+
+	update_len = end - stream_get_getp(s);
+	if (update_len) {
+		update.afi = AFI_IP;
+		update.safi = SAFI_UNICAST;
+		update.nlri = stream_pnt(s);
+		update.length = update_len;
+		stream_forward_getp(s, update_len);
+	}
+
+	if (withdraw.length)
+		bgp_nlri_parse(peer, NULL, &withdraw, 1);
+	if (mp_withdraw.length)
+		bgp_nlri_parse(peer, NULL, &mp_withdraw, 1);
+	if (withdraw.length || mp_withdraw.length)
+		replay.withdraw_msgs++;
+
+	if (ret != BGP_ATTR_PARSE_WITHDRAW) {
+		if (update.length && attribute_len)
+			bgp_nlri_parse(peer, &attr, &update, 0);
+		if (mp_update.length)
+			bgp_nlri_parse(peer, &attr, &mp_update, 0);
+	}
+
+	bgp_attr_unintern_sub(&attr);
+	replay.msgs++;
+}
+
+static void bgp_replay_bgp4mp(struct bgp *bgp, struct stream *s, int subtype)
+{
+	bool as4 = (subtype == BGP4MP_MESSAGE_AS4);
+	union sockunion su;
+	as_t peer_as;
+	uint16_t af;
+	uint8_t type;
+	size_t end;
+	bgp_size_t size;
+	struct peer *peer;
+
+	if (subtype != BGP4MP_MESSAGE && subtype != BGP4MP_MESSAGE_AS4) {
+		replay.skipped++;
+		return;
+	}
+
+	memset(&su, 0, sizeof(su));
+
+	peer_as = as4 ? stream_getl(s) : stream_getw(s);
+	as4 ? stream_getl(s) : stream_getw(s); /* local AS */
+	stream_getw(s);			       /* ifindex */
+	af = stream_getw(s);
+
+	if (af == AFI_IP) {
+		su.sin.sin_family = AF_INET;
+		su.sin.sin_addr.s_addr = stream_get_ipv4(s);
+		stream_forward_getp(s, IPV4_MAX_BYTELEN); /* local addr */
+	} else if (af == AFI_IP6) {
+		su.sin6.sin6_family = AF_INET6;
+		stream_get(&su.sin6.sin6_addr, s, IPV6_MAX_BYTELEN);
+		stream_forward_getp(s, IPV6_MAX_BYTELEN); /* local addr */
+	} else {
+		replay.skipped++;
+		return;
+	}
+
+	/* the raw BGP message: marker, size, type */
+	end = stream_get_getp(s);
+	stream_forward_getp(s, BGP_MARKER_SIZE);
+	size = stream_getw(s);
+	type = stream_getc(s);
+	end += size;
+
+	if (type != BGP_MSG_UPDATE) {
+		replay.skipped++;
+		return;
+	}
+
+	peer = bgp_replay_peer(bgp, &su, peer_as, as4);
+	bgp_replay_feed_update(peer, s, end);
+}
+
+/* TABLE_DUMP_V2 peer index table: maps the peer indices used by the RIB
+ * records of this dump onto synthetic peers */
+static void bgp_replay_peer_index(struct bgp *bgp, struct stream *s)
+{
+	union sockunion su;
+	uint16_t viewname_len, count, i;
+	uint8_t type;
+	as_t as;
+
+	stream_getl(s); /* collector BGP identifier */
+	viewname_len = stream_getw(s);
+	stream_forward_getp(s, viewname_len);
+	count = stream_getw(s);
+
+	if (replay_pit)
+		XFREE(MTYPE_BGP_REPLAY, replay_pit);
+	replay_pit = XCALLOC(MTYPE_BGP_REPLAY, count * sizeof(*replay_pit));
+	replay_pit_count = count;
+
+	for (i = 0; i < count; i++) {
+		type = stream_getc(s);
+		stream_getl(s); /* peer BGP identifier */
+
+		memset(&su, 0, sizeof(su));
+		if (CHECK_FLAG(type, TABLE_DUMP_V2_PEER_INDEX_TABLE_IP6)) {
+			su.sin6.sin6_family = AF_INET6;
+			stream_get(&su.sin6.sin6_addr, s, IPV6_MAX_BYTELEN);
+		} else {
+			su.sin.sin_family = AF_INET;
+			su.sin.sin_addr.s_addr = stream_get_ipv4(s);
+		}
+
+		if (CHECK_FLAG(type, TABLE_DUMP_V2_PEER_INDEX_TABLE_AS4))
+			as = stream_getl(s);
+		else
+			as = stream_getw(s);
+
+		replay_pit[i] = bgp_replay_peer(
+			bgp, &su, as,
+			CHECK_FLAG(type, TABLE_DUMP_V2_PEER_INDEX_TABLE_AS4));
+	}
+}
+
+static void bgp_replay_rib_v2(struct bgp *bgp, struct stream *s, int subtype)
+{
+	afi_t afi = (subtype == TABLE_DUMP_V2_RIB_IPV4_UNICAST) ? AFI_IP
+								: AFI_IP6;
+	struct prefix p;
+	struct peer *peer;
+	struct bgp_nlri mp_update, mp_withdraw;
+	struct attr attr;
+	bgp_attr_parse_ret_t ret;
+	uint16_t count, i, peer_index;
+	bgp_size_t attrlen;
+	size_t attr_start;
+
+	memset(&p, 0, sizeof(p));
+	stream_getl(s); /* sequence number */
+	p.prefixlen = stream_getc(s);
+	p.family = afi2family(afi);
+	stream_get(&p.u.prefix, s, PSIZE(p.prefixlen));
+
+	count = stream_getw(s);
+	for (i = 0; i < count; i++) {
+		peer_index = stream_getw(s);
+		stream_getl(s); /* originated time */
+		attrlen = stream_getw(s);
+		attr_start = stream_get_getp(s);
+
+		peer = (peer_index < replay_pit_count)
+			       ? replay_pit[peer_index]
+			       : NULL;
+		if (!peer) {
+			stream_forward_getp(s, attrlen);
+			replay.skipped++;
+			continue;
+		}
+
+		memset(&mp_update, 0, sizeof(mp_update));
+		memset(&mp_withdraw, 0, sizeof(mp_withdraw));
+		memset(&attr, 0, sizeof(attr));
+		attr.label_index = BGP_INVALID_LABEL_INDEX;
+		attr.label = MPLS_INVALID_LABEL;
+
+		peer->curr = s;
+		ret = bgp_attr_parse(peer, &attr, attrlen, &mp_update,
+				     &mp_withdraw);
+		peer->curr = NULL;
+		stream_set_getp(s, attr_start + attrlen);
+
+		if (ret == BGP_ATTR_PARSE_ERROR) {
+			replay.errors++;
+			bgp_attr_unintern_sub(&attr);
+			continue;
+		}
+
+		/* bgp_dump carries the IPv6 next hop in a full MP_REACH
+		 * attribute (NLRI included), so the prefix arrives through
+		 * mp_update; IPv4 entries take the plain path */
+		if (mp_update.length)
+			bgp_nlri_parse(peer, &attr, &mp_update, 0);
+		else
+			bgp_update(peer, &p, 0, &attr, afi, SAFI_UNICAST,
+				   ZEBRA_ROUTE_BGP, BGP_ROUTE_NORMAL, NULL,
+				   NULL, 0, 0, NULL);
+
+		bgp_attr_unintern_sub(&attr);
+		replay.rib_entries++;
+	}
+}
+
+/* original TABLE_DUMP format: one RIB entry per record, subtype is the AFI */
+static void bgp_replay_rib_v1(struct bgp *bgp, struct stream *s, int subtype)
+{
+	union sockunion su;
+	struct prefix p;
+	struct peer *peer;
+	struct bgp_nlri mp_update, mp_withdraw;
+	struct attr attr;
+	as_t as;
+	bgp_size_t attrlen;
+	size_t attr_start;
+
+	if (subtype != AFI_IP && subtype != AFI_IP6) {
+		replay.skipped++;
+		return;
+	}
+
+	memset(&p, 0, sizeof(p));
+	memset(&su, 0, sizeof(su));
+
+	stream_getw(s); /* view number */
+	stream_getw(s); /* sequence number */
+
+	if (subtype == AFI_IP) {
+		p.family = AF_INET;
+		p.u.prefix4.s_addr = stream_get_ipv4(s);
+	} else {
+		p.family = AF_INET6;
+		stream_get(&p.u.prefix6, s, IPV6_MAX_BYTELEN);
+	}
+	p.prefixlen = stream_getc(s);
+
+	stream_getc(s); /* status */
+	stream_getl(s); /* originated time */
+
+	if (subtype == AFI_IP) {
+		su.sin.sin_family = AF_INET;
+		su.sin.sin_addr.s_addr = stream_get_ipv4(s);
+	} else {
+		su.sin6.sin6_family = AF_INET6;
+		stream_get(&su.sin6.sin6_addr, s, IPV6_MAX_BYTELEN);
+	}
+	as = stream_getw(s);
+	attrlen = stream_getw(s);
+	attr_start = stream_get_getp(s);
+
+	peer = bgp_replay_peer(bgp, &su, as, false);
+
+	memset(&mp_update, 0, sizeof(mp_update));
+	memset(&mp_withdraw, 0, sizeof(mp_withdraw));
+	memset(&attr, 0, sizeof(attr));
+	attr.label_index = BGP_INVALID_LABEL_INDEX;
+	attr.label = MPLS_INVALID_LABEL;
+
+	peer->curr = s;
+	if (bgp_attr_parse(peer, &attr, attrlen, &mp_update, &mp_withdraw)
+	    == BGP_ATTR_PARSE_ERROR) {
+		peer->curr = NULL;
+		stream_set_getp(s, attr_start + attrlen);
+		replay.errors++;
+		bgp_attr_unintern_sub(&attr);
+		return;
+	}
+	peer->curr = NULL;
+	stream_set_getp(s, attr_start + attrlen);
+
+	bgp_update(peer, &p, 0, &attr, subtype == AFI_IP ? AFI_IP : AFI_IP6,
+		   SAFI_UNICAST, ZEBRA_ROUTE_BGP, BGP_ROUTE_NORMAL, NULL, NULL,
+		   0, 0, NULL);
+
+	bgp_attr_unintern_sub(&attr);
+	replay.rib_entries++;
+}
+
+static int bgp_replay_file(struct vty *vty, struct bgp *bgp, const char *path)
+{
+	struct stream *s;
+	struct rusage ru;
+	int fd, type, subtype;
+	size_t len;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		vty_out(vty, "%% Cannot open %s: %s\n", path,
+			safe_strerror(errno));
+		return CMD_WARNING;
+	}
+
+	memset(&replay, 0, sizeof(replay));
+	strlcpy(replay.path, path, sizeof(replay.path));
+	replay.attrs_before = attr_count();
+	if (!getrusage(RUSAGE_SELF, &ru))
+		replay.maxrss_before = ru.ru_maxrss;
+
+	bgp_replay_active = true;
+	monotime(&replay.start);
+
+	s = stream_new(BGP_MAX_PACKET_SIZE);
+
+	while (1) {
+		stream_reset(s);
+
+		/* MRT common header */
+		if (stream_read(s, fd, BGP_DUMP_HEADER_SIZE)
+		    != BGP_DUMP_HEADER_SIZE)
+			break;
+
+		stream_getl(s); /* timestamp */
+		type = stream_getw(s);
+		subtype = stream_getw(s);
+		len = stream_getl(s);
+
+		if (len > STREAM_SIZE(s) - BGP_DUMP_HEADER_SIZE)
+			stream_resize_inplace(&s, len + BGP_DUMP_HEADER_SIZE);
+
+		if (stream_read(s, fd, len) != (int)len) {
+			zlog_warn("%s: truncated MRT record in %s", __func__,
+				  path);
+			replay.errors++;
+			break;
+		}
+
+		replay.records++;
+
+		switch (type) {
+		case MSG_PROTOCOL_BGP4MP_ET:
+			stream_getl(s); /* microseconds */
+			/* fallthru */
+		case MSG_PROTOCOL_BGP4MP:
+			bgp_replay_bgp4mp(bgp, s, subtype);
+			break;
+		case MRT_MSG_TABLE_DUMP:
+			bgp_replay_rib_v1(bgp, s, subtype);
+			break;
+		case MRT_MSG_TABLE_DUMP_V2:
+			if (subtype == TABLE_DUMP_V2_PEER_INDEX_TABLE)
+				bgp_replay_peer_index(bgp, s);
+			else if (subtype == TABLE_DUMP_V2_RIB_IPV4_UNICAST
+				 || subtype == TABLE_DUMP_V2_RIB_IPV6_UNICAST)
+				bgp_replay_rib_v2(bgp, s, subtype);
+			else
+				replay.skipped++;
+			break;
+		default:
+			replay.skipped++;
+			break;
+		}
+	}
+
+	stream_free(s);
+	close(fd);
+
+	monotime(&replay.feed_done);
+	replay.feeding_done = true;
+
+	/* bestpath runs from the process queue; if nothing was queued
+	 * (empty or all-skipped file) there is no drain event coming */
+	if (!bm->process_main_queue
+	    || !work_queue_item_count(bm->process_main_queue))
+		bgp_replay_finish();
+
+	vty_out(vty,
+		"Fed %lu MRT records (%lu updates, %lu RIB entries, %lu skipped, %lu errors)\n",
+		replay.records, replay.msgs, replay.rib_entries,
+		replay.skipped, replay.errors);
+	vty_out(vty, "Convergence runs in the background; see \"show bgp replay\"\n");
+
+	return CMD_SUCCESS;
+}
+
+static double bgp_replay_seconds(const struct timeval *tv)
+{
+	struct timeval delta;
+
+	timersub(tv, &replay.start, &delta);
+	return delta.tv_sec + delta.tv_usec / 1e6;
+}
+
+DEFUN (bgp_replay,
+       bgp_replay_cmd,
+       "bgp replay PATH",
+       BGP_STR
+       "Replay an MRT dump into the BGP RIB\n"
+       "Name of the MRT file to replay\n")
+{
+	struct bgp *bgp;
+
+	if (bgp_replay_active) {
+		vty_out(vty, "%% Replay already in progress\n");
+		return CMD_WARNING;
+	}
+
+	bgp = bgp_get_default();
+	if (!bgp) {
+		vty_out(vty, "%% No BGP process is configured\n");
+		return CMD_WARNING;
+	}
+
+	return bgp_replay_file(vty, bgp, argv[2]->arg);
+}
+
+DEFUN (show_bgp_replay,
+       show_bgp_replay_cmd,
+       "show bgp replay",
+       SHOW_STR
+       BGP_STR
+       "MRT replay statistics\n")
+{
+	if (!replay.path[0]) {
+		vty_out(vty, "%% No replay has been run\n");
+		return CMD_WARNING;
+	}
+
+	vty_out(vty, "Replay of %s (%s)\n", replay.path,
+		replay.complete ? "complete"
+				: bgp_replay_active ? "in progress"
+						    : "feeding");
+	vty_out(vty, "  MRT records read:     %lu (%lu skipped, %lu errors)\n",
+		replay.records, replay.skipped, replay.errors);
+	vty_out(vty, "  Update messages fed:  %lu (%lu carried withdraws)\n",
+		replay.msgs, replay.withdraw_msgs);
+	vty_out(vty, "  RIB entries fed:      %lu\n", replay.rib_entries);
+	vty_out(vty, "  Replay peers:         %u\n",
+		listcount(replay_peers));
+	vty_out(vty, "  Feed time:            %.3f s\n",
+		bgp_replay_seconds(&replay.feed_done));
+
+	if (timerisset(&replay.first_bestpath))
+		vty_out(vty, "  First bestpath:       %.3f s\n",
+			bgp_replay_seconds(&replay.first_bestpath));
+	if (timerisset(&replay.last_bestpath))
+		vty_out(vty, "  Last bestpath:        %.3f s (%lu runs)\n",
+			bgp_replay_seconds(&replay.last_bestpath),
+			replay.bestpaths);
+
+	vty_out(vty, "  Interned attributes:  %lu -> %lu\n",
+		replay.attrs_before,
+		replay.complete ? replay.attrs_after : attr_count());
+	if (replay.complete)
+		vty_out(vty, "  Max RSS:              %ld kB -> %ld kB\n",
+			replay.maxrss_before, replay.maxrss_after);
+
+	return CMD_SUCCESS;
+}
+
+void bgp_replay_init(void)
+{
+	replay_peers = list_new();
+
+	install_element(ENABLE_NODE, &bgp_replay_cmd);
+	install_element(VIEW_NODE, &show_bgp_replay_cmd);
+}
@@ -0,0 +1,35 @@
+/* BGP MRT replay harness
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _QUAGGA_BGP_REPLAY_H
+#define _QUAGGA_BGP_REPLAY_H
+
+/* true while a replay is feeding or waiting for bestpath to settle;
+ * checked inline in the bestpath hot path, so kept as a plain bool */
+extern bool bgp_replay_active;
+
+extern void bgp_replay_init(void);
+
+/* called from bgp_route.c: one bestpath run finished / process queue
+ * drained */
+extern void bgp_replay_bestpath_tick(void);
+extern void bgp_replay_queue_drained(void);
+
+#endif /* _QUAGGA_BGP_REPLAY_H */
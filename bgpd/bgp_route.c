@@ -36,9 +36,12 @@
 #include "thread.h"
 #include "workqueue.h"
 #include "queue.h"
+#include "hash.h"
+#include "jhash.h"
 #include "memory.h"
 #include "lib/json.h"
 #include "lib_errors.h"
+#include "libfrr.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_table.h"
@@ -67,6 +70,8 @@
 #include "bgpd/bgp_label.h"
 #include "bgpd/bgp_addpath.h"
 #include "bgpd/bgp_mac.h"
+#include "bgpd/bgp_bestpath.h"
+#include "bgpd/bgp_replay.h"
 
 #if ENABLE_BGP_VNC
 #include "bgpd/rfapi/rfapi_backend.h"
@@ -224,6 +229,8 @@ void bgp_path_info_extra_free(struct bgp_path_info_extra **extra)
 		list_delete(&((*extra)->bgp_fs_iprule));
 	if ((*extra)->bgp_fs_pbr)
 		list_delete(&((*extra)->bgp_fs_pbr));
+	if ((*extra)->bgp_fs_entry)
+		XFREE(MTYPE_BGP_FLOWSPEC_COMPILED, (*extra)->bgp_fs_entry);
 	XFREE(MTYPE_BGP_ROUTE_EXTRA, *extra);
 
 	*extra = NULL;
@@ -1196,6 +1203,155 @@ static int bgp_cluster_filter(struct peer *peer, struct attr *attr)
 	return 0;
 }
 
+/* Inbound policy result cache.
+ *
+ * Soft reconfiguration and policy changes re-run the inbound route-map
+ * over the whole Adj-RIB-In, where thousands of prefixes typically
+ * share a handful of interned attribute sets.  When the incoming attr
+ * is one of those shared, interned attrs and every match clause of the
+ * route-map looks only at the attr or the peer (never the prefix), the
+ * outcome of bgp_input_modifier() is identical for every prefix
+ * carrying that attr, so memoize { route-map, peer, attr } -> verdict
+ * plus the post-policy attr and skip the route-map entirely on repeat.
+ *
+ * Entries hold references on the attrs they store.  The cache is
+ * flushed whenever BGP processes a route-map change and whenever a
+ * peer is deleted (keys compare peer pointers, which could otherwise
+ * be recycled for a new peer).
+ */
+struct bgp_rmap_in_cache {
+	struct route_map *map;
+	struct peer *peer;
+	struct attr *in_attr;  /* interned pre-policy attr (the key) */
+	struct attr *out_attr; /* interned post-policy attr; NULL on deny */
+	int ret;	       /* RMAP_PERMIT or RMAP_DENY */
+};
+
+static struct hash *bgp_rmap_in_hash;
+
+/* Crude size bound; reaching it just empties the cache. */
+#define BGP_RMAP_IN_CACHE_MAX 16384
+
+static unsigned int bgp_rmap_in_cache_key(void *p)
+{
+	struct bgp_rmap_in_cache *entry = p;
+
+	return jhash_3words((uintptr_t)entry->map, (uintptr_t)entry->peer,
+			    (uintptr_t)entry->in_attr, 0x5f2ca1e3);
+}
+
+static bool bgp_rmap_in_cache_cmp(const void *p1, const void *p2)
+{
+	const struct bgp_rmap_in_cache *e1 = p1;
+	const struct bgp_rmap_in_cache *e2 = p2;
+
+	return e1->map == e2->map && e1->peer == e2->peer
+	       && e1->in_attr == e2->in_attr;
+}
+
+static void bgp_rmap_in_cache_free(void *p)
+{
+	struct bgp_rmap_in_cache *entry = p;
+
+	bgp_attr_unintern(&entry->in_attr);
+	if (entry->out_attr)
+		bgp_attr_unintern(&entry->out_attr);
+	XFREE(MTYPE_BGP_RMAP_CACHE, entry);
+}
+
+void bgp_rmap_in_cache_flush(void)
+{
+	if (bgp_rmap_in_hash)
+		hash_clean(bgp_rmap_in_hash, bgp_rmap_in_cache_free);
+}
+
+/* Match commands whose result depends only on the attr and the peer,
+ * both of which are part of the cache key.  Anything else - prefix
+ * matches most importantly, but also e.g. "probability" - makes the
+ * route-map's outcome vary per prefix and thus uncacheable.
+ */
+static void bgp_rmap_in_cacheable_walker(const char *cmd_name,
+					 const char *cmd_arg, void *arg)
+{
+	static const char *const attr_only[] = {
+		"as-path",	  "community",	"extcommunity",
+		"large-community", "metric",	"local-preference",
+		"origin",	  "tag",	"ip next-hop",
+		"ipv6 next-hop",   "peer",	NULL,
+	};
+	bool *cacheable = arg;
+	int i;
+
+	for (i = 0; attr_only[i]; i++)
+		if (strcmp(cmd_name, attr_only[i]) == 0)
+			return;
+
+	*cacheable = false;
+}
+
+static bool bgp_rmap_in_cacheable(struct route_map *map)
+{
+	struct route_map_index *index;
+	bool cacheable = true;
+
+	for (index = map->head; index; index = index->next) {
+		/* A called route-map would need the same analysis;
+		 * just punt on "call". */
+		if (index->nextrm)
+			return false;
+
+		route_map_rule_walk(&index->match_list,
+				    bgp_rmap_in_cacheable_walker, &cacheable);
+		if (!cacheable)
+			return false;
+	}
+
+	return true;
+}
+
+static struct bgp_rmap_in_cache *
+bgp_rmap_in_cache_find(struct route_map *map, struct peer *peer,
+		       struct attr *attr)
+{
+	struct bgp_rmap_in_cache ref;
+
+	if (!bgp_rmap_in_hash)
+		return NULL;
+
+	ref.map = map;
+	ref.peer = peer;
+	ref.in_attr = attr;
+
+	return hash_lookup(bgp_rmap_in_hash, &ref);
+}
+
+/* Both attrs are handed over already interned; the entry owns those
+ * references until the cache is flushed.
+ */
+static void bgp_rmap_in_cache_add(struct route_map *map, struct peer *peer,
+				  struct attr *in_attr, struct attr *out_attr,
+				  int ret)
+{
+	struct bgp_rmap_in_cache *entry;
+
+	if (!bgp_rmap_in_hash)
+		bgp_rmap_in_hash = hash_create(bgp_rmap_in_cache_key,
+					       bgp_rmap_in_cache_cmp,
+					       "BGP inbound route-map cache");
+
+	if (bgp_rmap_in_hash->count >= BGP_RMAP_IN_CACHE_MAX)
+		bgp_rmap_in_cache_flush();
+
+	entry = XCALLOC(MTYPE_BGP_RMAP_CACHE, sizeof(*entry));
+	entry->map = map;
+	entry->peer = peer;
+	entry->in_attr = in_attr;
+	entry->out_attr = out_attr;
+	entry->ret = ret;
+
+	(void)hash_get(bgp_rmap_in_hash, entry, hash_alloc_intern);
+}
+
 static int bgp_input_modifier(struct peer *peer, struct prefix *p,
 			      struct attr *attr, afi_t afi, safi_t safi,
 			      const char *rmap_name)
@@ -1575,14 +1731,24 @@ int subgroup_announce_check(struct bgp_node *rn, struct bgp_path_info *pi,
 		return 0;
 	}
 
-	/* ORF prefix-list filter check */
+	/* ORF prefix-list filter check.  All members of a shared subgroup
+	 * sent content-identical filters (see updgrp_hash_cmp), so a live
+	 * member's list stands in for the whole group; the conf peer's
+	 * reference could outlive the member it was taken from.
+	 */
 	if (CHECK_FLAG(peer->af_cap[afi][safi], PEER_CAP_ORF_PREFIX_RM_ADV)
 	    && (CHECK_FLAG(peer->af_cap[afi][safi], PEER_CAP_ORF_PREFIX_SM_RCV)
 		|| CHECK_FLAG(peer->af_cap[afi][safi],
-			      PEER_CAP_ORF_PREFIX_SM_OLD_RCV)))
-		if (peer->orf_plist[afi][safi]) {
-			if (prefix_list_apply(peer->orf_plist[afi][safi], p)
-			    == PREFIX_DENY) {
+			      PEER_CAP_ORF_PREFIX_SM_OLD_RCV))) {
+		struct peer_af *orf_paf = SUBGRP_PFIRST(subgrp);
+		struct prefix_list *orf_plist =
+			onlypeer ? onlypeer->orf_plist[afi][safi]
+				 : (orf_paf ? orf_paf->peer
+						      ->orf_plist[afi][safi]
+					    : NULL);
+
+		if (orf_plist) {
+			if (prefix_list_apply(orf_plist, p) == PREFIX_DENY) {
 				if (bgp_debug_update(NULL, p,
 						     subgrp->update_group, 0))
 					zlog_debug(
@@ -1593,6 +1759,7 @@ int subgroup_announce_check(struct bgp_node *rn, struct bgp_path_info *pi,
 				return 0;
 			}
 		}
+	}
 
 	/* Output filter check. */
 	if (bgp_output_filter(peer, p, piattr, afi, safi) == FILTER_DENY) {
@@ -1655,6 +1822,32 @@ int subgroup_announce_check(struct bgp_node *rn, struct bgp_path_info *pi,
 		}
 	}
 
+	/* Route-server pass-through. Between route-server clients the
+	 * attribute is advertised untouched, so when nothing below can
+	 * modify it either (no outbound policy, no AS mangling, plain v4
+	 * unicast where the nexthop machinery is a no-op) hand the path's
+	 * attribute through as-is. bgp_adj_out_set_subgroup() interns it,
+	 * so every client view without modifying policy ends up holding a
+	 * reference to the same storage as the RIB; only views whose
+	 * policy actually rewrites something get their own copy below.
+	 */
+	if (transparent && peer->sort == BGP_PEER_EBGP
+	    && p->family == AF_INET && safi == SAFI_UNICAST
+	    && !peer_cap_enhe(peer, afi, safi)
+	    && !ROUTE_MAP_OUT_NAME(filter)
+	    && !(pi->extra && pi->extra->suppress)
+	    && !CHECK_FLAG(peer->af_flags[afi][safi],
+			   PEER_FLAG_REMOVE_PRIVATE_AS
+				   | PEER_FLAG_REMOVE_PRIVATE_AS_ALL
+				   | PEER_FLAG_REMOVE_PRIVATE_AS_REPLACE
+				   | PEER_FLAG_REMOVE_PRIVATE_AS_ALL_REPLACE
+				   | PEER_FLAG_AS_OVERRIDE)
+	    && peer->bgp->ebgp_requires_policy != DEFAULT_EBGP_POLICY_ENABLED
+	    && !bgp_flag_check(bgp, BGP_FLAG_GRACEFUL_SHUTDOWN)) {
+		bgp_attr_dup(attr, piattr);
+		return 1;
+	}
+
 	/* For modify attribute, copy it to temporary structure. */
 	bgp_attr_dup(attr, piattr);
 
@@ -1900,6 +2093,12 @@ int subgroup_announce_check(struct bgp_node *rn, struct bgp_path_info *pi,
 	return 1;
 }
 
+/* Set by the best-path pool around a parallel selection run; while
+ * true, bgp_best_selection() must not reap - the pool does it serially
+ * after the join.  Only ever written by the main thread.
+ */
+bool bgp_best_selection_defer_reap;
+
 void bgp_best_selection(struct bgp *bgp, struct bgp_node *rn,
 			struct bgp_maxpaths_cfg *mpath_cfg,
 			struct bgp_path_info_pair *result, afi_t afi,
@@ -1916,6 +2115,9 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_node *rn,
 	char pfx_buf[PREFIX2STR_BUFFER];
 	char path_buf[PATH_ADDPATH_STR_BUFFER];
 
+	atomic_fetch_add_explicit(&bgp->bestpath_runs, 1,
+				  memory_order_relaxed);
+
 	bgp_mp_list_init(&mp_list);
 	do_mpath =
 		(mpath_cfg->maxpaths_ebgp > 1 || mpath_cfg->maxpaths_ibgp > 1);
@@ -2010,9 +2212,16 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_node *rn,
 		if (BGP_PATH_HOLDDOWN(pi)) {
 			/* reap REMOVED routes, if needs be
 			 * selected route must stay for a while longer though
+			 *
+			 * Reaping releases peer, nexthop-cache and addpath
+			 * references, none of which is safe to touch from
+			 * the best-path workers; while they run, reaping
+			 * is deferred to the serial phase after the join
+			 * (see bgp_bestpath_select()).
 			 */
 			if (CHECK_FLAG(pi->flags, BGP_PATH_REMOVED)
-			    && (pi != old_select))
+			    && (pi != old_select)
+			    && !bgp_best_selection_defer_reap)
 				bgp_path_info_reap(rn, pi);
 
 			if (debug)
@@ -2256,46 +2465,19 @@ struct bgp_process_queue {
  * if (old_select && !new_select)
  *     We have no eligible route that we can announce or the rn
  *     is being removed.
+ *
+ * This is the serialized "apply" half of node processing; the selection
+ * in old_and_new may have been computed on a best-path worker pthread.
  */
-static void bgp_process_main_one(struct bgp *bgp, struct bgp_node *rn,
-				 afi_t afi, safi_t safi)
+static void bgp_process_main_one_apply(struct bgp *bgp, struct bgp_node *rn,
+				       afi_t afi, safi_t safi,
+				       struct bgp_path_info_pair *old_and_new)
 {
-	struct bgp_path_info *new_select;
-	struct bgp_path_info *old_select;
-	struct bgp_path_info_pair old_and_new;
-	char pfx_buf[PREFIX2STR_BUFFER];
-	int debug = 0;
-
-	/* Is it end of initial update? (after startup) */
-	if (!rn) {
-		quagga_timestamp(3, bgp->update_delay_zebra_resume_time,
-				 sizeof(bgp->update_delay_zebra_resume_time));
-
-		bgp->main_zebra_update_hold = 0;
-		FOREACH_AFI_SAFI (afi, safi) {
-			if (bgp_fibupd_safi(safi))
-				bgp_zebra_announce_table(bgp, afi, safi);
-		}
-		bgp->main_peers_update_hold = 0;
-
-		bgp_start_routeadv(bgp);
-		return;
-	}
-
+	struct bgp_path_info *new_select = old_and_new->new;
+	struct bgp_path_info *old_select = old_and_new->old;
 	struct prefix *p = &rn->p;
-
-	debug = bgp_debug_bestpath(&rn->p);
-	if (debug) {
-		prefix2str(&rn->p, pfx_buf, sizeof(pfx_buf));
-		zlog_debug("%s: p=%s afi=%s, safi=%s start", __func__, pfx_buf,
-			   afi2str(afi), safi2str(safi));
-	}
-
-	/* Best path selection. */
-	bgp_best_selection(bgp, rn, &bgp->maxpaths[afi][safi], &old_and_new,
-			   afi, safi);
-	old_select = old_and_new.old;
-	new_select = old_and_new.new;
+	char pfx_buf[PREFIX2STR_BUFFER];
+	int debug = bgp_debug_bestpath(&rn->p);
 
 	/* Do we need to allocate or free labels?
 	 * Right now, since we only deal with per-prefix labels, it is not
@@ -2400,6 +2582,7 @@ static void bgp_process_main_one(struct bgp *bgp, struct bgp_node *rn,
 	/* bestpath has changed; bump version */
 	if (old_select || new_select) {
 		bgp_bump_version(rn);
+		bgp_table_change_record(rn, new_select == NULL);
 
 		if (!bgp->t_rmap_def_originate_eval) {
 			bgp_lock(bgp);
@@ -2516,6 +2699,46 @@ static void bgp_process_main_one(struct bgp *bgp, struct bgp_node *rn,
 	return;
 }
 
+static void bgp_process_main_one(struct bgp *bgp, struct bgp_node *rn,
+				 afi_t afi, safi_t safi)
+{
+	struct bgp_path_info_pair old_and_new;
+	char pfx_buf[PREFIX2STR_BUFFER];
+	int debug = 0;
+
+	/* Is it end of initial update? (after startup) */
+	if (!rn) {
+		quagga_timestamp(3, bgp->update_delay_zebra_resume_time,
+				 sizeof(bgp->update_delay_zebra_resume_time));
+
+		bgp->main_zebra_update_hold = 0;
+		FOREACH_AFI_SAFI (afi, safi) {
+			if (bgp_fibupd_safi(safi))
+				bgp_zebra_announce_table(bgp, afi, safi);
+		}
+		bgp->main_peers_update_hold = 0;
+
+		bgp_start_routeadv(bgp);
+		return;
+	}
+
+	debug = bgp_debug_bestpath(&rn->p);
+	if (debug) {
+		prefix2str(&rn->p, pfx_buf, sizeof(pfx_buf));
+		zlog_debug("%s: p=%s afi=%s, safi=%s start", __func__, pfx_buf,
+			   afi2str(afi), safi2str(safi));
+	}
+
+	/* Best path selection. */
+	bgp_best_selection(bgp, rn, &bgp->maxpaths[afi][safi], &old_and_new,
+			   afi, safi);
+
+	bgp_process_main_one_apply(bgp, rn, afi, safi, &old_and_new);
+
+	if (bgp_replay_active)
+		bgp_replay_bestpath_tick();
+}
+
 static wq_item_status bgp_process_wq(struct work_queue *wq, void *data)
 {
 	struct bgp_process_queue *pqnode = data;
@@ -2531,6 +2754,46 @@ static wq_item_status bgp_process_wq(struct work_queue *wq, void *data)
 		return WQ_SUCCESS;
 	}
 
+	/* Large batches can run selection sharded across the best-path
+	 * worker pool; the apply phase (peer and zebra announcements)
+	 * stays serialized here.
+	 */
+	if (bgp_bestpath_pool_active()
+	    && pqnode->queued >= BGP_BESTPATH_PARALLEL_MIN) {
+		struct bgp_bestpath_result *results;
+		uint32_t i, n = 0;
+
+		results = XCALLOC(MTYPE_BGP_PROCESS_QUEUE,
+				  pqnode->queued * sizeof(*results));
+
+		while (!STAILQ_EMPTY(&pqnode->pqueue)) {
+			rn = STAILQ_FIRST(&pqnode->pqueue);
+			STAILQ_REMOVE_HEAD(&pqnode->pqueue, pq);
+			STAILQ_NEXT(rn, pq) = NULL; /* complete unlink */
+			results[n++].rn = rn;
+		}
+
+		bgp_bestpath_select(bgp, results, n);
+
+		for (i = 0; i < n; i++) {
+			rn = results[i].rn;
+			table = bgp_node_table(rn);
+			/* note, new RNs may be added as part of processing */
+			bgp_process_main_one_apply(bgp, rn, table->afi,
+						   table->safi,
+						   &results[i].old_and_new);
+
+			if (bgp_replay_active)
+				bgp_replay_bestpath_tick();
+
+			bgp_unlock_node(rn);
+			bgp_table_unlock(table);
+		}
+
+		XFREE(MTYPE_BGP_PROCESS_QUEUE, results);
+		return WQ_SUCCESS;
+	}
+
 	while (!STAILQ_EMPTY(&pqnode->pqueue)) {
 		rn = STAILQ_FIRST(&pqnode->pqueue);
 		STAILQ_REMOVE_HEAD(&pqnode->pqueue, pq);
@@ -2546,6 +2809,12 @@ static wq_item_status bgp_process_wq(struct work_queue *wq, void *data)
 	return WQ_SUCCESS;
 }
 
+static void bgp_processq_complete(struct work_queue *wq)
+{
+	if (bgp_replay_active)
+		bgp_replay_queue_drained();
+}
+
 static void bgp_processq_del(struct work_queue *wq, void *data)
 {
 	struct bgp_process_queue *pqnode = data;
@@ -2563,6 +2832,7 @@ void bgp_process_queue_init(void)
 
 	bm->process_main_queue->spec.workfunc = &bgp_process_wq;
 	bm->process_main_queue->spec.del_item_data = &bgp_processq_del;
+	bm->process_main_queue->spec.completion_func = &bgp_processq_complete;
 	bm->process_main_queue->spec.max_retries = 0;
 	bm->process_main_queue->spec.hold = 50;
 	/* Use a higher yield value of 50ms for main queue processing */
@@ -2964,6 +3234,9 @@ int bgp_update(struct peer *peer, struct prefix *p, uint32_t addpath_id,
 	struct bgp_path_info *pi;
 	struct bgp_path_info *new;
 	struct bgp_path_info_extra *extra;
+	struct route_map *rmap_in;
+	struct bgp_rmap_in_cache *rmap_cache;
+	bool rmap_cacheable;
 	const char *reason;
 	char pfx_buf[BGP_PRD_PATH_STRLEN];
 	int connected = 0;
@@ -3056,17 +3329,52 @@ int bgp_update(struct peer *peer, struct prefix *p, uint32_t addpath_id,
 
 	bgp_attr_dup(&new_attr, attr);
 
+	/* When the incoming attr is an interned, shared one (soft
+	 * reconfiguration walking the Adj-RIB-In) and the inbound
+	 * route-map never looks at the prefix, the policy result is the
+	 * same for every prefix carrying this attr - look it up instead
+	 * of re-running the route-map.  The per-peer weight is applied
+	 * inside bgp_input_modifier(), so a configured weight disables
+	 * the shortcut rather than being re-modelled here.
+	 */
+	rmap_in = ROUTE_MAP_IN_NAME(&peer->filter[afi][safi])
+			  ? ROUTE_MAP_IN(&peer->filter[afi][safi])
+			  : NULL;
+	rmap_cacheable = rmap_in && attr->refcnt && !peer->weight[afi][safi]
+			 && bgp_rmap_in_cacheable(rmap_in);
+	rmap_cache = rmap_cacheable
+			     ? bgp_rmap_in_cache_find(rmap_in, peer, attr)
+			     : NULL;
+
 	/* Apply incoming route-map.
 	 * NB: new_attr may now contain newly allocated values from route-map
 	 * "set"
 	 * commands, so we need bgp_attr_flush in the error paths, until we
 	 * intern
 	 * the attr (which takes over the memory references) */
-	if (bgp_input_modifier(peer, p, &new_attr, afi, safi, NULL)
-	    == RMAP_DENY) {
+	if (rmap_cache) {
+		if (rmap_cache->ret == RMAP_DENY) {
+			reason = "route-map;";
+			bgp_attr_flush(&new_attr);
+			goto filtered;
+		}
+		bgp_attr_dup(&new_attr, rmap_cache->out_attr);
+	} else if (bgp_input_modifier(peer, p, &new_attr, afi, safi, NULL)
+		   == RMAP_DENY) {
+		if (rmap_cacheable)
+			bgp_rmap_in_cache_add(rmap_in, peer,
+					      bgp_attr_intern(attr), NULL,
+					      RMAP_DENY);
 		reason = "route-map;";
 		bgp_attr_flush(&new_attr);
 		goto filtered;
+	} else if (rmap_cacheable) {
+		/* Interning new_attr here also swaps its value pointers
+		 * for the interned copies, which the rest of this
+		 * function handles exactly as it does un-interned ones.
+		 */
+		bgp_rmap_in_cache_add(rmap_in, peer, bgp_attr_intern(attr),
+				      bgp_attr_intern(&new_attr), RMAP_PERMIT);
 	}
 
 	if (peer->sort == BGP_PEER_EBGP) {
@@ -3756,8 +4064,13 @@ static int bgp_announce_route_timer_expired(struct thread *t)
  * bgp_announce_route
  *
  * *Triggers* announcement of routes of a given AFI/SAFI to a peer.
+ *
+ * if force is true, every prefix will be re-sent to the peer even if
+ * its advertised attributes are unchanged; policy-change triggered
+ * announcements pass false and only generate UPDATEs for prefixes
+ * whose advertised state actually differs.
  */
-void bgp_announce_route(struct peer *peer, afi_t afi, safi_t safi)
+void bgp_announce_route(struct peer *peer, afi_t afi, safi_t safi, bool force)
 {
 	struct peer_af *paf;
 	struct update_subgroup *subgrp;
@@ -3767,11 +4080,15 @@ void bgp_announce_route(struct peer *peer, afi_t afi, safi_t safi)
 		return;
 	subgrp = PAF_SUBGRP(paf);
 
-	/*
-	 * Ignore if subgroup doesn't exist (implies AF is not negotiated)
-	 * or a refresh has already been triggered.
-	 */
-	if (!subgrp || paf->t_announce_route)
+	/* Ignore if subgroup doesn't exist (implies AF is not negotiated) */
+	if (!subgrp)
+		return;
+
+	if (force)
+		SET_FLAG(subgrp->sflags, SUBGRP_STATUS_FORCE_UPDATES);
+
+	/* Ignore if a refresh has already been triggered */
+	if (paf->t_announce_route)
 		return;
 
 	/*
@@ -3802,7 +4119,7 @@ void bgp_announce_route_all(struct peer *peer)
 	safi_t safi;
 
 	FOREACH_AFI_SAFI (afi, safi)
-		bgp_announce_route(peer, afi, safi);
+		bgp_announce_route(peer, afi, safi, false);
 }
 
 static void bgp_soft_reconfig_table(struct peer *peer, afi_t afi, safi_t safi,
@@ -3880,8 +4197,98 @@ void bgp_soft_reconfig_in(struct peer *peer, afi_t afi, safi_t safi)
 
 struct bgp_clear_node_queue {
 	struct bgp_node *rn;
+
+	/*
+	 * rn == NULL: chunked table-walk item.  Clears up to
+	 * BGP_CLEAR_ROUTE_CHUNK nodes of 'nodes' per work queue cycle,
+	 * resuming at 'pos'; holds a reference on the table and on the
+	 * walk array for the lifetime of the item.
+	 */
+	struct bgp_table *table;
+	struct bgp_node **nodes;
+	unsigned int count;
+	unsigned int pos;
 };
 
+/*
+ * Nodes examined per invocation of a chunked clearing item; bounds how
+ * long session teardown of a full-table peer can hold the event loop
+ * in a single work queue cycle.
+ */
+#define BGP_CLEAR_ROUTE_CHUNK 2048
+
+static wq_item_status bgp_clear_route_chunk(struct work_queue *wq,
+					    struct bgp_clear_node_queue *cnq)
+{
+	struct peer *peer = wq->spec.data;
+	struct bgp *bgp = peer->bgp;
+	unsigned int budget = BGP_CLEAR_ROUTE_CHUNK;
+
+	while (cnq->pos < cnq->count && budget--) {
+		struct bgp_node *rn = bgp_table_walk_next(cnq->nodes,
+							  cnq->count,
+							  cnq->pos++);
+		afi_t afi = bgp_node_table(rn)->afi;
+		safi_t safi = bgp_node_table(rn)->safi;
+		struct bgp_adj_in *ain;
+		struct bgp_adj_in *ain_next;
+		struct bgp_path_info *pi;
+
+		ain = rn->adj_in;
+		while (ain) {
+			ain_next = ain->next;
+
+			if (ain->peer == peer) {
+				bgp_adj_in_remove(rn, ain);
+				bgp_unlock_node(rn);
+			}
+
+			ain = ain_next;
+		}
+
+		/* It is possible that we have multiple paths for a prefix
+		 * from a peer if that peer is using AddPath.
+		 */
+		for (pi = bgp_node_get_bgp_path_info(rn); pi; pi = pi->next) {
+			if (pi->peer != peer)
+				continue;
+
+			/* graceful restart STALE flag set. */
+			if (CHECK_FLAG(peer->sflags, PEER_STATUS_NSF_WAIT)
+			    && peer->nsf[afi][safi]
+			    && !CHECK_FLAG(pi->flags, BGP_PATH_STALE)
+			    && !CHECK_FLAG(pi->flags, BGP_PATH_UNUSEABLE))
+				bgp_path_info_set_flag(rn, pi,
+						       BGP_PATH_STALE);
+			else {
+				/* If this is an EVPN route, process for
+				 * un-import. */
+				if (safi == SAFI_EVPN)
+					bgp_evpn_unimport_route(bgp, afi, safi,
+								&rn->p, pi);
+				/* Handle withdraw for VRF route-leaking and
+				 * L3VPN */
+				if (SAFI_UNICAST == safi
+				    && (bgp->inst_type == BGP_INSTANCE_TYPE_VRF
+					|| bgp->inst_type
+						   == BGP_INSTANCE_TYPE_DEFAULT)) {
+					vpn_leak_from_vrf_withdraw(
+						bgp_get_default(), bgp, pi);
+				}
+				if (SAFI_MPLS_VPN == safi
+				    && bgp->inst_type
+					       == BGP_INSTANCE_TYPE_DEFAULT) {
+					vpn_leak_to_vrf_withdraw(bgp, pi);
+				}
+
+				bgp_rib_remove(rn, pi, peer, afi, safi);
+			}
+		}
+	}
+
+	return cnq->pos < cnq->count ? WQ_REQUEUE : WQ_SUCCESS;
+}
+
 static wq_item_status bgp_clear_route_node(struct work_queue *wq, void *data)
 {
 	struct bgp_clear_node_queue *cnq = data;
@@ -3889,8 +4296,14 @@ static wq_item_status bgp_clear_route_node(struct work_queue *wq, void *data)
 	struct peer *peer = wq->spec.data;
 	struct bgp_path_info *pi;
 	struct bgp *bgp;
-	afi_t afi = bgp_node_table(rn)->afi;
-	safi_t safi = bgp_node_table(rn)->safi;
+	afi_t afi;
+	safi_t safi;
+
+	if (!rn)
+		return bgp_clear_route_chunk(wq, cnq);
+
+	afi = bgp_node_table(rn)->afi;
+	safi = bgp_node_table(rn)->safi;
 
 	assert(rn && peer);
 	bgp = peer->bgp;
@@ -3935,11 +4348,16 @@ static wq_item_status bgp_clear_route_node(struct work_queue *wq, void *data)
 static void bgp_clear_node_queue_del(struct work_queue *wq, void *data)
 {
 	struct bgp_clear_node_queue *cnq = data;
-	struct bgp_node *rn = cnq->rn;
-	struct bgp_table *table = bgp_node_table(rn);
 
-	bgp_unlock_node(rn);
-	bgp_table_unlock(table);
+	if (cnq->rn) {
+		struct bgp_table *table = bgp_node_table(cnq->rn);
+
+		bgp_unlock_node(cnq->rn);
+		bgp_table_unlock(table);
+	} else {
+		bgp_table_walk_release(cnq->table);
+		bgp_table_unlock(cnq->table);
+	}
 	XFREE(MTYPE_BGP_CLEAR_NODE_QUEUE, cnq);
 }
 
@@ -3975,8 +4393,7 @@ static void bgp_clear_node_queue_init(struct peer *peer)
 static void bgp_clear_route_table(struct peer *peer, afi_t afi, safi_t safi,
 				  struct bgp_table *table)
 {
-	struct bgp_node *rn;
-	int force = bm->process_main_queue ? 0 : 1;
+	struct bgp_clear_node_queue *cnq;
 
 	if (!table)
 		table = peer->bgp->rib[afi][safi];
@@ -3985,81 +4402,60 @@ static void bgp_clear_route_table(struct peer *peer, afi_t afi, safi_t safi,
 	if (!table)
 		return;
 
-	for (rn = bgp_table_top(table); rn; rn = bgp_route_next(rn)) {
-		struct bgp_path_info *pi, *next;
-		struct bgp_adj_in *ain;
-		struct bgp_adj_in *ain_next;
-
-		/* XXX:TODO: This is suboptimal, every non-empty route_node is
-		 * queued for every clearing peer, regardless of whether it is
-		 * relevant to the peer at hand.
-		 *
-		 * Overview: There are 3 different indices which need to be
-		 * scrubbed, potentially, when a peer is removed:
-		 *
-		 * 1 peer's routes visible via the RIB (ie accepted routes)
-		 * 2 peer's routes visible by the (optional) peer's adj-in index
-		 * 3 other routes visible by the peer's adj-out index
-		 *
-		 * 3 there is no hurry in scrubbing, once the struct peer is
-		 * removed from bgp->peer, we could just GC such deleted peer's
-		 * adj-outs at our leisure.
-		 *
-		 * 1 and 2 must be 'scrubbed' in some way, at least made
-		 * invisible via RIB index before peer session is allowed to be
-		 * brought back up. So one needs to know when such a 'search' is
-		 * complete.
-		 *
-		 * Ideally:
-		 *
-		 * - there'd be a single global queue or a single RIB walker
-		 * - rather than tracking which route_nodes still need to be
-		 *   examined on a peer basis, we'd track which peers still
-		 *   aren't cleared
-		 *
-		 * Given that our per-peer prefix-counts now should be reliable,
-		 * this may actually be achievable. It doesn't seem to be a huge
-		 * problem at this time,
-		 *
-		 * It is possible that we have multiple paths for a prefix from
-		 * a peer
-		 * if that peer is using AddPath.
-		 */
-		ain = rn->adj_in;
-		while (ain) {
-			ain_next = ain->next;
+	/*
+	 * At shutdown there is no process queue to hand paths over to;
+	 * reap everything synchronously.
+	 */
+	if (!bm->process_main_queue) {
+		struct bgp_node **nodes;
+		unsigned int count;
+		unsigned int i;
+
+		nodes = bgp_table_walk_acquire(table, &count);
+		for (i = 0; i < count; i++) {
+			struct bgp_node *rn =
+				bgp_table_walk_next(nodes, count, i);
+			struct bgp_path_info *pi, *next;
+			struct bgp_adj_in *ain;
+			struct bgp_adj_in *ain_next;
+
+			ain = rn->adj_in;
+			while (ain) {
+				ain_next = ain->next;
+
+				if (ain->peer == peer) {
+					bgp_adj_in_remove(rn, ain);
+					bgp_unlock_node(rn);
+				}
 
-			if (ain->peer == peer) {
-				bgp_adj_in_remove(rn, ain);
-				bgp_unlock_node(rn);
+				ain = ain_next;
 			}
 
-			ain = ain_next;
-		}
-
-		for (pi = bgp_node_get_bgp_path_info(rn); pi; pi = next) {
-			next = pi->next;
-			if (pi->peer != peer)
-				continue;
-
-			if (force)
-				bgp_path_info_reap(rn, pi);
-			else {
-				struct bgp_clear_node_queue *cnq;
-
-				/* both unlocked in bgp_clear_node_queue_del */
-				bgp_table_lock(bgp_node_table(rn));
-				bgp_lock_node(rn);
-				cnq = XCALLOC(
-					MTYPE_BGP_CLEAR_NODE_QUEUE,
-					sizeof(struct bgp_clear_node_queue));
-				cnq->rn = rn;
-				work_queue_add(peer->clear_node_queue, cnq);
-				break;
+			for (pi = bgp_node_get_bgp_path_info(rn); pi;
+			     pi = next) {
+				next = pi->next;
+				if (pi->peer == peer)
+					bgp_path_info_reap(rn, pi);
 			}
 		}
+		bgp_table_walk_release(table);
+		return;
 	}
-	return;
+
+	/*
+	 * Hand the whole table walk to the clear-node work queue as a
+	 * single chunked item: bgp_clear_route_chunk() scrubs a budget of
+	 * nodes per cycle and requeues itself, so dropping a full-table
+	 * peer never holds the event loop for the duration of the walk.
+	 * The table and walk array references are dropped in
+	 * bgp_clear_node_queue_del() when the item retires.
+	 */
+	bgp_table_lock(table);
+	cnq = XCALLOC(MTYPE_BGP_CLEAR_NODE_QUEUE,
+		      sizeof(struct bgp_clear_node_queue));
+	cnq->table = table;
+	cnq->nodes = bgp_table_walk_acquire(table, &cnq->count);
+	work_queue_add(peer->clear_node_queue, cnq);
 }
 
 void bgp_clear_route(struct peer *peer, afi_t afi, safi_t safi)
@@ -4193,6 +4589,263 @@ void bgp_clear_stale_route(struct peer *peer, afi_t afi, safi_t safi)
 	}
 }
 
+/*
+ * Local RIB persistence across restarts ("rib cache").
+ *
+ * When graceful-restart is configured, the essentials of every valid
+ * learned path (peer, prefix and the attributes that matter for best
+ * path selection) are written to a per-instance cache file on shutdown
+ * and loaded back on startup, marked stale.  The regular graceful
+ * restart machinery then reconciles the pre-populated tables against
+ * refreshed peer data: re-received paths shed the stale flag in
+ * bgp_update(), the remainder is swept at End-of-RIB or, for peers
+ * that did not negotiate restart, at session establishment.  The work
+ * to converge after a restart is thus bounded by the diff against the
+ * cached table rather than by the table size.
+ */
+
+#define BGP_RIB_CACHE_MAGIC "BGPRIBCACHE"
+#define BGP_RIB_CACHE_VERSION 1
+
+static void bgp_rib_cache_path(struct bgp *bgp, char *buf, size_t size)
+{
+	snprintf(buf, size, "%s/bgp-%s.ribcache", frr_vtydir,
+		 bgp->name ? bgp->name : VRF_DEFAULT_NAME);
+}
+
+void bgp_rib_cache_write(struct bgp *bgp)
+{
+	char path[MAXPATHLEN];
+	char pfx[PREFIX_STRLEN];
+	char su[SU_ADDRSTRLEN];
+	char nh[INET6_ADDRSTRLEN];
+	struct bgp_node *rn;
+	struct bgp_path_info *pi;
+	unsigned long written = 0;
+	afi_t afi;
+	safi_t safi;
+	FILE *fp;
+
+	if (!bgp_flag_check(bgp, BGP_FLAG_GRACEFUL_RESTART))
+		return;
+
+	bgp_rib_cache_path(bgp, path, sizeof(path));
+	fp = fopen(path, "w");
+	if (!fp) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL,
+			     "%s: cannot write rib cache %s: %s", __func__,
+			     path, safe_strerror(errno));
+		return;
+	}
+
+	fprintf(fp, "%s %d\n", BGP_RIB_CACHE_MAGIC, BGP_RIB_CACHE_VERSION);
+
+	FOREACH_AFI_SAFI (afi, safi) {
+		struct bgp_table *table = bgp->rib[afi][safi];
+
+		/* Nested and labeled tables are re-learned the usual way. */
+		if (safi != SAFI_UNICAST && safi != SAFI_MULTICAST)
+			continue;
+		if (!table)
+			continue;
+
+		for (rn = bgp_table_top(table); rn; rn = bgp_route_next(rn))
+			for (pi = bgp_node_get_bgp_path_info(rn); pi;
+			     pi = pi->next) {
+				struct attr *a = pi->attr;
+
+				if (pi->type != ZEBRA_ROUTE_BGP
+				    || pi->sub_type != BGP_ROUTE_NORMAL)
+					continue;
+				if (pi->peer == bgp->peer_self)
+					continue;
+				if (!CHECK_FLAG(pi->flags, BGP_PATH_VALID))
+					continue;
+				if (pi->addpath_rx_id)
+					continue;
+
+				if (afi == AFI_IP)
+					inet_ntop(AF_INET, &a->nexthop, nh,
+						  sizeof(nh));
+				else
+					inet_ntop(AF_INET6,
+						  &a->mp_nexthop_global, nh,
+						  sizeof(nh));
+
+				fprintf(fp,
+					"%u|%u|%s|%s|%" PRIu64
+					"|%u|%u|%u|%s|%s|%s\n",
+					afi, safi,
+					sockunion2str(&pi->peer->su, su,
+						      sizeof(su)),
+					prefix2str(&rn->p, pfx, sizeof(pfx)),
+					a->flag, a->origin, a->med,
+					a->local_pref, nh,
+					a->aspath ? a->aspath->str : "",
+					a->community
+						? community_str(a->community,
+								false)
+						: "");
+				written++;
+			}
+	}
+
+	fclose(fp);
+	zlog_info("%s: wrote %lu paths to rib cache %s", bgp->name_pretty,
+		  written, path);
+}
+
+/*
+ * Backstop for peers that never came back after a cache-primed restart:
+ * established sessions reconcile their stale paths at End-of-RIB or at
+ * session establishment, so only paths of still-down peers are left.
+ */
+static int bgp_rib_cache_stale_expire(struct thread *thread)
+{
+	struct bgp *bgp = THREAD_ARG(thread);
+	struct peer *peer;
+	afi_t afi;
+	safi_t safi;
+
+	bgp->t_rib_cache_stale = NULL;
+
+	frr_each (bgp_peers, &bgp->peer, peer) {
+		if (peer->status == Established)
+			continue;
+		FOREACH_AFI_SAFI (afi, safi)
+			if (peer->nsf[afi][safi])
+				bgp_clear_stale_route(peer, afi, safi);
+	}
+
+	return 0;
+}
+
+void bgp_rib_cache_read(struct bgp *bgp)
+{
+	char path[MAXPATHLEN];
+	char line[BUFSIZ];
+	unsigned long loaded = 0;
+	FILE *fp;
+
+	if (!bgp_flag_check(bgp, BGP_FLAG_GRACEFUL_RESTART))
+		return;
+
+	bgp_rib_cache_path(bgp, path, sizeof(path));
+	fp = fopen(path, "r");
+	if (!fp)
+		return;
+
+	/* A cache is good for exactly one restart. */
+	unlink(path);
+
+	if (!fgets(line, sizeof(line), fp)
+	    || strncmp(line, BGP_RIB_CACHE_MAGIC,
+		       strlen(BGP_RIB_CACHE_MAGIC))) {
+		zlog_warn("%s: rib cache %s has a bad header, ignoring",
+			  __func__, path);
+		fclose(fp);
+		return;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		char *fld[11];
+		char *cp = line;
+		int nfld = 0;
+		union sockunion su;
+		struct prefix p;
+		struct peer *peer;
+		struct bgp_node *rn;
+		struct bgp_path_info *new;
+		struct attr attr;
+		struct attr *interned;
+		afi_t afi;
+		safi_t safi;
+
+		cp[strcspn(cp, "\n")] = '\0';
+		while (nfld < 11 && cp) {
+			fld[nfld++] = cp;
+			cp = strchr(cp, '|');
+			if (cp)
+				*cp++ = '\0';
+		}
+		if (nfld != 11)
+			continue;
+
+		afi = atoi(fld[0]);
+		safi = atoi(fld[1]);
+		if (afi >= AFI_MAX || safi >= SAFI_MAX || !bgp->rib[afi][safi])
+			continue;
+		if (str2sockunion(fld[2], &su) < 0 || !str2prefix(fld[3], &p))
+			continue;
+
+		peer = peer_lookup(bgp, &su);
+		if (!peer)
+			continue;
+
+		memset(&attr, 0, sizeof(attr));
+		attr.label_index = BGP_INVALID_LABEL_INDEX;
+		attr.label = MPLS_INVALID_LABEL;
+		attr.flag = strtoull(fld[4], NULL, 10);
+		/* The cache line persists the full flag mask but only the
+		 * attributes below are rehydrated; a surviving bit for an
+		 * unrestored pointer attribute (cluster list, extended or
+		 * large communities, ...) would send bgp_packet_attribute()
+		 * through a NULL pointer on the first advertisement.
+		 */
+		attr.flag &= ATTR_FLAG_BIT(BGP_ATTR_ORIGIN)
+			     | ATTR_FLAG_BIT(BGP_ATTR_AS_PATH)
+			     | ATTR_FLAG_BIT(BGP_ATTR_NEXT_HOP)
+			     | ATTR_FLAG_BIT(BGP_ATTR_MULTI_EXIT_DISC)
+			     | ATTR_FLAG_BIT(BGP_ATTR_LOCAL_PREF)
+			     | ATTR_FLAG_BIT(BGP_ATTR_COMMUNITIES);
+		attr.origin = atoi(fld[5]);
+		attr.med = strtoul(fld[6], NULL, 10);
+		attr.local_pref = strtoul(fld[7], NULL, 10);
+		if (afi == AFI_IP)
+			inet_pton(AF_INET, fld[8], &attr.nexthop);
+		else {
+			inet_pton(AF_INET6, fld[8], &attr.mp_nexthop_global);
+			attr.mp_nexthop_len = BGP_ATTR_NHLEN_IPV6_GLOBAL;
+		}
+		attr.aspath = aspath_str2aspath(fld[9]);
+		if (!attr.aspath)
+			continue;
+		if (fld[10][0])
+			attr.community = community_str2com(fld[10]);
+		if (!attr.community)
+			attr.flag &= ~ATTR_FLAG_BIT(BGP_ATTR_COMMUNITIES);
+
+		interned = bgp_attr_intern(&attr);
+
+		rn = bgp_node_get(bgp->rib[afi][safi], &p);
+		new = info_make(ZEBRA_ROUTE_BGP, BGP_ROUTE_NORMAL, 0, peer,
+				interned, rn);
+		bgp_path_info_set_flag(rn, new, BGP_PATH_VALID);
+		bgp_path_info_add(rn, new);
+		bgp_path_info_set_flag(rn, new, BGP_PATH_STALE);
+		bgp_unlock_node(rn);
+		bgp_process(bgp, rn, afi, safi);
+
+		/*
+		 * Let the graceful restart machinery reconcile this peer's
+		 * stale paths once it refreshes us.
+		 */
+		peer->nsf[afi][safi] = 1;
+
+		loaded++;
+	}
+
+	fclose(fp);
+
+	if (loaded) {
+		zlog_info("%s: pre-populated %lu paths from rib cache %s",
+			  bgp->name_pretty, loaded, path);
+		thread_add_timer(bm->master, bgp_rib_cache_stale_expire, bgp,
+				 bgp->stalepath_time,
+				 &bgp->t_rib_cache_stale);
+	}
+}
+
 int bgp_outbound_policy_exists(struct peer *peer, struct bgp_filter *filter)
 {
 	if (peer->sort == BGP_PEER_EBGP
@@ -5938,11 +6591,17 @@ static void bgp_add_route_to_aggregate(struct bgp *bgp, struct prefix *aggr_p,
 				       struct bgp_aggregate *aggregate)
 {
 	uint8_t origin;
+	uint8_t origin_before;
 	struct aspath *aspath = NULL;
+	struct aspath *aspath_before = aggregate->aspath;
 	uint8_t atomic_aggregate = 0;
 	struct community *community = NULL;
+	struct community *community_before = aggregate->community;
 	struct ecommunity *ecommunity = NULL;
+	struct ecommunity *ecommunity_before = aggregate->ecommunity;
 	struct lcommunity *lcommunity = NULL;
+	struct lcommunity *lcommunity_before = aggregate->lcommunity;
+	bool first = (aggregate->count == 0);
 
 	/* ORIGIN attribute: If at least one route among routes that are
 	 * aggregated has ORIGIN with the value INCOMPLETE, then the
@@ -5955,6 +6614,12 @@ static void bgp_add_route_to_aggregate(struct bgp *bgp, struct prefix *aggr_p,
 	 */
 	origin = BGP_ORIGIN_IGP;
 
+	origin_before = BGP_ORIGIN_IGP;
+	if (aggregate->incomplete_origin_count > 0)
+		origin_before = BGP_ORIGIN_INCOMPLETE;
+	else if (aggregate->egp_origin_count > 0)
+		origin_before = BGP_ORIGIN_EGP;
+
 	aggregate->count++;
 
 	if (aggregate->summary_only)
@@ -6004,7 +6669,22 @@ static void bgp_add_route_to_aggregate(struct bgp *bgp, struct prefix *aggr_p,
 			bgp_compute_aggregate_lcommunity(
 					aggregate,
 					pinew->attr->lcommunity);
+	}
+
+	/* The compute helpers above only swap the aggregate's attribute
+	 * pointers when a new distinct value joins the as-set; if none of
+	 * them did and the derived origin is unchanged, this component
+	 * cannot alter the installed aggregate and the re-install (with
+	 * its attribute duplication and RIB lookup) can be skipped.
+	 */
+	if (!first && origin == origin_before
+	    && aggregate->aspath == aspath_before
+	    && aggregate->community == community_before
+	    && aggregate->ecommunity == ecommunity_before
+	    && aggregate->lcommunity == lcommunity_before)
+		return;
 
+	if (aggregate->as_set) {
 		/* Retrieve aggregate route's as-path.
 		 */
 		if (aggregate->aspath)
@@ -6038,16 +6718,27 @@ static void bgp_remove_route_from_aggregate(struct bgp *bgp, afi_t afi,
 					    struct prefix *aggr_p)
 {
 	uint8_t origin;
+	uint8_t origin_before;
 	struct aspath *aspath = NULL;
+	struct aspath *aspath_before = aggregate->aspath;
 	uint8_t atomic_aggregate = 0;
 	struct community *community = NULL;
+	struct community *community_before = aggregate->community;
 	struct ecommunity *ecommunity = NULL;
+	struct ecommunity *ecommunity_before = aggregate->ecommunity;
 	struct lcommunity *lcommunity = NULL;
+	struct lcommunity *lcommunity_before = aggregate->lcommunity;
 	unsigned long match = 0;
 
 	if (BGP_PATH_HOLDDOWN(pi))
 		return;
 
+	origin_before = BGP_ORIGIN_IGP;
+	if (aggregate->incomplete_origin_count > 0)
+		origin_before = BGP_ORIGIN_INCOMPLETE;
+	else if (aggregate->egp_origin_count > 0)
+		origin_before = BGP_ORIGIN_EGP;
+
 	if (pi->sub_type == BGP_ROUTE_AGGREGATE)
 		return;
 
@@ -6109,6 +6800,18 @@ static void bgp_remove_route_from_aggregate(struct bgp *bgp, afi_t afi,
 	else if (aggregate->egp_origin_count > 0)
 		origin = BGP_ORIGIN_EGP;
 
+	/* As on the add side: if no as-set contribution pointer moved and
+	 * the derived origin is the same, the installed aggregate is
+	 * untouched by this removal (the withdraw when the last component
+	 * goes still runs, since the count is then zero).
+	 */
+	if (aggregate->count > 0 && origin == origin_before
+	    && aggregate->aspath == aspath_before
+	    && aggregate->community == community_before
+	    && aggregate->ecommunity == ecommunity_before
+	    && aggregate->lcommunity == lcommunity_before)
+		return;
+
 	if (aggregate->as_set) {
 		/* Retrieve aggregate route's as-path.
 		 */
@@ -7834,7 +8537,6 @@ void route_vty_out_detail(struct vty *vty, struct bgp *bgp, struct prefix *p,
 	json_object *json_string = NULL;
 	json_object *json_adv_to = NULL;
 	int first = 0;
-	struct listnode *node, *nnode;
 	struct peer *peer;
 	int addpath_capable;
 	int has_adj;
@@ -8592,7 +9294,7 @@ void route_vty_out_detail(struct vty *vty, struct bgp *bgp, struct prefix *p,
 		if (bgp_addpath_is_addpath_used(&bgp->tx_addpath, afi, safi)) {
 			first = 1;
 
-			for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+			frr_each_safe (bgp_peers, &bgp->peer, peer) {
 				addpath_capable =
 					bgp_addpath_encode_tx(peer, afi, safi);
 				has_adj = bgp_adj_out_lookup(
@@ -8693,6 +9395,11 @@ void route_vty_out_detail(struct vty *vty, struct bgp *bgp, struct prefix *p,
 #define BGP_SHOW_DAMP_HEADER "   Network          From             Reuse    Path\n"
 #define BGP_SHOW_FLAP_HEADER "   Network          From            Flaps Duration Reuse    Path\n"
 
+/* Hand buffered output to the session every so many displayed prefixes
+ * so that table-scale walks do not accumulate the whole output in the
+ * vty obuf (see vty_out_flush). */
+#define BGP_SHOW_FLUSH_INTERVAL 1024
+
 static int bgp_show_prefix_list(struct vty *vty, struct bgp *bgp,
 				const char *prefix_list_str, afi_t afi,
 				safi_t safi, enum bgp_show_type type);
@@ -8952,6 +9659,8 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 
 		if (display) {
 			output_count++;
+			if ((output_count % BGP_SHOW_FLUSH_INTERVAL) == 0)
+				vty_out_flush(vty);
 			if (!use_json)
 				continue;
 
@@ -9153,7 +9862,6 @@ void route_vty_out_detail_header(struct vty *vty, struct bgp *bgp,
 	struct bgp_path_info *pi;
 	struct prefix *p;
 	struct peer *peer;
-	struct listnode *node, *nnode;
 	char buf1[RD_ADDRSTRLEN];
 	char buf2[INET6_ADDRSTRLEN];
 	char buf3[EVPN_ROUTE_STRLEN];
@@ -9320,7 +10028,7 @@ void route_vty_out_detail_header(struct vty *vty, struct bgp *bgp,
 	 * addpath
 	 * though then we must display Advertised to on a path-by-path basis. */
 	if (!bgp_addpath_is_addpath_used(&bgp->tx_addpath, afi, safi)) {
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 			if (bgp_adj_out_lookup(peer, rn, 0)) {
 				if (json && !json_adv_to)
 					json_adv_to = json_object_new_object();
@@ -151,6 +151,11 @@ struct bgp_path_info_extra {
 	struct list *bgp_fs_pbr;
 	/* presence of FS pbr iprule based entry */
 	struct list *bgp_fs_iprule;
+	/* FS only: decoded form of the NLRI match rules, filled on first
+	 * use.  The decode depends only on the prefix, which never changes
+	 * for a path, so the cache is valid for the path's lifetime.
+	 */
+	struct bgp_pbr_entry_main *bgp_fs_entry;
 };
 
 struct bgp_path_info {
@@ -416,7 +421,7 @@ extern void bgp_process_queue_init(void);
 extern void bgp_route_init(void);
 extern void bgp_route_finish(void);
 extern void bgp_cleanup_routes(struct bgp *);
-extern void bgp_announce_route(struct peer *, afi_t, safi_t);
+extern void bgp_announce_route(struct peer *, afi_t, safi_t, bool);
 extern void bgp_stop_announce_route_timer(struct peer_af *paf);
 extern void bgp_announce_route_all(struct peer *);
 extern void bgp_default_originate(struct peer *, afi_t, safi_t, int);
@@ -425,6 +430,9 @@ extern void bgp_clear_route(struct peer *, afi_t, safi_t);
 extern void bgp_clear_route_all(struct peer *);
 extern void bgp_clear_adj_in(struct peer *, afi_t, safi_t);
 extern void bgp_clear_stale_route(struct peer *, afi_t, safi_t);
+extern void bgp_rib_cache_write(struct bgp *bgp);
+extern void bgp_rib_cache_read(struct bgp *bgp);
+extern void bgp_rmap_in_cache_flush(void);
 extern int bgp_outbound_policy_exists(struct peer *, struct bgp_filter *);
 extern int bgp_inbound_policy_exists(struct peer *, struct bgp_filter *);
 
@@ -560,6 +568,9 @@ extern void bgp_best_selection(struct bgp *bgp, struct bgp_node *rn,
 			       struct bgp_maxpaths_cfg *mpath_cfg,
 			       struct bgp_path_info_pair *result, afi_t afi,
 			       safi_t safi);
+/* Suppresses reaping inside bgp_best_selection() during a parallel run;
+ * owned by bgp_bestpath.c */
+extern bool bgp_best_selection_defer_reap;
 extern void bgp_zebra_clear_route_change_flags(struct bgp_node *rn);
 extern int bgp_zebra_has_route_changed(struct bgp_node *rn,
 				       struct bgp_path_info *selected);
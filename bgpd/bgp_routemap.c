@@ -39,6 +39,7 @@
 #include "hash.h"
 #include "queue.h"
 #include "frrstr.h"
+#include "libfrr.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_table.h"
@@ -428,6 +429,56 @@ struct route_map_rule_cmd route_match_command_cmd = {
 };
 #endif
 
+/* Compiled list reference: the list name plus the resolved object
+ * pointer, revalidated against the route-map configuration generation
+ * so the name lookup happens once per config change instead of on
+ * every apply. */
+struct bgp_rmap_list_ref {
+	char *name;
+	void *list;
+	uint64_t gen;
+};
+
+static void *route_match_list_ref_compile(const char *arg)
+{
+	struct bgp_rmap_list_ref *ref;
+
+	ref = XCALLOC(MTYPE_ROUTE_MAP_COMPILED,
+		      sizeof(struct bgp_rmap_list_ref));
+	ref->name = XSTRDUP(MTYPE_ROUTE_MAP_COMPILED, arg);
+	return ref;
+}
+
+static void route_match_list_ref_free(void *rule)
+{
+	struct bgp_rmap_list_ref *ref = rule;
+
+	XFREE(MTYPE_ROUTE_MAP_COMPILED, ref->name);
+	XFREE(MTYPE_ROUTE_MAP_COMPILED, ref);
+}
+
+static struct access_list *route_match_access_list_ref(void *rule, afi_t afi)
+{
+	struct bgp_rmap_list_ref *ref = rule;
+
+	if (ref->gen != route_map_config_generation()) {
+		ref->list = access_list_lookup(afi, ref->name);
+		ref->gen = route_map_config_generation();
+	}
+	return ref->list;
+}
+
+static struct prefix_list *route_match_prefix_list_ref(void *rule, afi_t afi)
+{
+	struct bgp_rmap_list_ref *ref = rule;
+
+	if (ref->gen != route_map_config_generation()) {
+		ref->list = prefix_list_lookup(afi, ref->name);
+		ref->gen = route_map_config_generation();
+	}
+	return ref->list;
+}
+
 /* `match ip address IP_ACCESS_LIST' */
 
 /* Match function should return 1 if match is success else return
@@ -440,7 +491,7 @@ static route_map_result_t route_match_ip_address(void *rule,
 	struct access_list *alist;
 
 	if (type == RMAP_BGP && prefix->family == AF_INET) {
-		alist = access_list_lookup(AFI_IP, (char *)rule);
+		alist = route_match_access_list_ref(rule, AFI_IP);
 		if (alist == NULL)
 			return RMAP_NOMATCH;
 
@@ -455,13 +506,13 @@ static route_map_result_t route_match_ip_address(void *rule,
    access-list name. */
 static void *route_match_ip_address_compile(const char *arg)
 {
-	return XSTRDUP(MTYPE_ROUTE_MAP_COMPILED, arg);
+	return route_match_list_ref_compile(arg);
 }
 
 /* Free route map's compiled `ip address' value. */
 static void route_match_ip_address_free(void *rule)
 {
-	XFREE(MTYPE_ROUTE_MAP_COMPILED, rule);
+	route_match_list_ref_free(rule);
 }
 
 /* Route map commands for ip address matching. */
@@ -578,7 +629,7 @@ route_match_ip_address_prefix_list(void *rule, const struct prefix *prefix,
 	struct prefix_list *plist;
 
 	if (type == RMAP_BGP && prefix->family == AF_INET) {
-		plist = prefix_list_lookup(AFI_IP, (char *)rule);
+		plist = route_match_prefix_list_ref(rule, AFI_IP);
 		if (plist == NULL)
 			return RMAP_NOMATCH;
 
@@ -591,12 +642,12 @@ route_match_ip_address_prefix_list(void *rule, const struct prefix *prefix,
 
 static void *route_match_ip_address_prefix_list_compile(const char *arg)
 {
-	return XSTRDUP(MTYPE_ROUTE_MAP_COMPILED, arg);
+	return route_match_list_ref_compile(arg);
 }
 
 static void route_match_ip_address_prefix_list_free(void *rule)
 {
-	XFREE(MTYPE_ROUTE_MAP_COMPILED, rule);
+	route_match_list_ref_free(rule);
 }
 
 struct route_map_rule_cmd route_match_ip_address_prefix_list_cmd = {
@@ -1878,7 +1929,6 @@ static route_map_result_t route_set_lcommunity(void *rule,
 	struct attr *attr;
 	struct lcommunity *new = NULL;
 	struct lcommunity *old;
-	struct lcommunity *merge;
 
 	if (type == RMAP_BGP) {
 		rcs = rule;
@@ -1899,11 +1949,12 @@ static route_map_result_t route_set_lcommunity(void *rule,
 		}
 
 		if (rcs->additive && old) {
-			merge = lcommunity_merge(lcommunity_dup(old),
-						 rcs->lcom);
+			struct lcommunity_builder b;
 
-			new = lcommunity_uniq_sort(merge);
-			lcommunity_free(&merge);
+			lcommunity_builder_init(&b);
+			lcommunity_builder_add(&b, old);
+			lcommunity_builder_add(&b, rcs->lcom);
+			new = lcommunity_builder_finish(&b);
 		} else
 			new = lcommunity_dup(rcs->lcom);
 
@@ -2446,7 +2497,7 @@ static route_map_result_t route_match_ipv6_address(void *rule,
 	struct access_list *alist;
 
 	if (type == RMAP_BGP && prefix->family == AF_INET6) {
-		alist = access_list_lookup(AFI_IP6, (char *)rule);
+		alist = route_match_access_list_ref(rule, AFI_IP6);
 		if (alist == NULL)
 			return RMAP_NOMATCH;
 
@@ -2459,12 +2510,12 @@ static route_map_result_t route_match_ipv6_address(void *rule,
 
 static void *route_match_ipv6_address_compile(const char *arg)
 {
-	return XSTRDUP(MTYPE_ROUTE_MAP_COMPILED, arg);
+	return route_match_list_ref_compile(arg);
 }
 
 static void route_match_ipv6_address_free(void *rule)
 {
-	XFREE(MTYPE_ROUTE_MAP_COMPILED, rule);
+	route_match_list_ref_free(rule);
 }
 
 /* Route map commands for ip address matching. */
@@ -2533,7 +2584,7 @@ route_match_ipv6_address_prefix_list(void *rule, const struct prefix *prefix,
 	struct prefix_list *plist;
 
 	if (type == RMAP_BGP && prefix->family == AF_INET6) {
-		plist = prefix_list_lookup(AFI_IP6, (char *)rule);
+		plist = route_match_prefix_list_ref(rule, AFI_IP6);
 		if (plist == NULL)
 			return RMAP_NOMATCH;
 
@@ -2546,12 +2597,12 @@ route_match_ipv6_address_prefix_list(void *rule, const struct prefix *prefix,
 
 static void *route_match_ipv6_address_prefix_list_compile(const char *arg)
 {
-	return XSTRDUP(MTYPE_ROUTE_MAP_COMPILED, arg);
+	return route_match_list_ref_compile(arg);
 }
 
 static void route_match_ipv6_address_prefix_list_free(void *rule)
 {
-	XFREE(MTYPE_ROUTE_MAP_COMPILED, rule);
+	route_match_list_ref_free(rule);
 }
 
 struct route_map_rule_cmd route_match_ipv6_address_prefix_list_cmd = {
@@ -3028,7 +3079,8 @@ static int bgp_route_match_add(struct vty *vty, const char *command,
 		break;
 	case RMAP_COMPILE_SUCCESS:
 		if (type != RMAP_EVENT_MATCH_ADDED) {
-			route_map_upd8_dependency(type, arg, index->map->name);
+			route_map_upd8_dependency(type, arg, index->map->name,
+						  index);
 		}
 		break;
 	}
@@ -3072,7 +3124,8 @@ static int bgp_route_match_delete(struct vty *vty, const char *command,
 		break;
 	case RMAP_COMPILE_SUCCESS:
 		if (type != RMAP_EVENT_MATCH_DELETED && dep_name)
-			route_map_upd8_dependency(type, dep_name, rmap_name);
+			route_map_upd8_dependency(type, dep_name, rmap_name,
+						  index);
 		break;
 	}
 
@@ -3235,13 +3288,16 @@ static void bgp_route_map_process_update(struct bgp *bgp, const char *rmap_name,
 	struct peer *peer;
 	struct bgp_node *bn;
 	struct bgp_static *bgp_static;
-	struct listnode *node, *nnode;
+	struct listnode *node;
 	struct route_map *map;
 	char buf[INET6_ADDRSTRLEN];
 
+	/* Memoized inbound policy results may be stale now. */
+	bgp_rmap_in_cache_flush();
+
 	map = route_map_lookup_by_name(rmap_name);
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 
 		/* Ignore dummy peer-group structure */
 		if (CHECK_FLAG(peer->sflags, PEER_STATUS_GROUP))
@@ -3403,6 +3459,14 @@ int bgp_route_map_update_timer(struct thread *thread)
 
 static void bgp_route_map_mark_update(const char *rmap_name)
 {
+	/* While the startup configuration loads, the names collected by
+	 * route_map_mark_updated() are left on the library's update list;
+	 * the end-of-load hook flushes it in one consolidated pass instead
+	 * of a timer (and per-group signalling) per config line.
+	 */
+	if (frr_config_read_in_progress())
+		return;
+
 	if (bm->t_rmap_update == NULL) {
 		struct listnode *node, *nnode;
 		struct bgp *bgp;
@@ -3455,6 +3519,24 @@ static void bgp_route_map_event(route_map_event_t event, const char *rmap_name)
 	route_map_notify_dependencies(rmap_name, RMAP_EVENT_MATCH_ADDED);
 }
 
+/* A referenced list changed; mark only the route-maps whose clauses
+ * actually use it, from the clause set the library hands us. */
+static void bgp_route_map_dep_clauses(route_map_event_t event,
+				      const char *dep_name,
+				      struct list *clauses)
+{
+	struct route_map_index *index;
+	struct listnode *node;
+
+	for (ALL_LIST_ELEMENTS_RO(clauses, node, index)) {
+		if (route_map_mark_updated(index->map->name) == 0)
+			bgp_route_map_mark_update(index->map->name);
+
+		route_map_notify_dependencies(index->map->name,
+					      RMAP_EVENT_MATCH_ADDED);
+	}
+}
+
 DEFUN (match_mac_address,
        match_mac_address_cmd,
        "match mac address WORD",
@@ -4949,6 +5031,7 @@ void bgp_route_map_init(void)
 	route_map_add_hook(bgp_route_map_add);
 	route_map_delete_hook(bgp_route_map_delete);
 	route_map_event_hook(bgp_route_map_event);
+	route_map_dep_clause_hook(bgp_route_map_dep_clauses);
 
 	route_map_match_interface_hook(generic_match_add);
 	route_map_no_match_interface_hook(generic_match_delete);
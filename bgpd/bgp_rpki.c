@@ -375,9 +375,8 @@ static int bgpd_sync_callback(struct thread *thread)
 
 	for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp)) {
 		struct peer *peer;
-		struct listnode *peer_listnode;
 
-		for (ALL_LIST_ELEMENTS_RO(bgp->peer, peer_listnode, peer)) {
+		frr_each (bgp_peers, &bgp->peer, peer) {
 			safi_t safi;
 
 			for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++) {
@@ -444,9 +443,8 @@ static void revalidate_all_routes(void)
 
 	for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp)) {
 		struct peer *peer;
-		struct listnode *peer_listnode;
 
-		for (ALL_LIST_ELEMENTS_RO(bgp->peer, peer_listnode, peer)) {
+		frr_each (bgp_peers, &bgp->peer, peer) {
 
 			for (size_t i = 0; i < 2; i++) {
 				safi_t safi;
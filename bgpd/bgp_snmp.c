@@ -355,13 +355,12 @@ static struct peer *peer_lookup_addr_ipv4(struct in_addr *src)
 {
 	struct bgp *bgp;
 	struct peer *peer;
-	struct listnode *node;
 
 	bgp = bgp_get_default();
 	if (!bgp)
 		return NULL;
 
-	for (ALL_LIST_ELEMENTS_RO(bgp->peer, node, peer)) {
+	frr_each (bgp_peers, &bgp->peer, peer) {
 		if (sockunion_family(&peer->su) != AF_INET)
 			continue;
 
@@ -377,13 +376,12 @@ static struct peer *bgp_peer_lookup_next(struct in_addr *src)
 	struct bgp *bgp;
 	struct peer *peer;
 	struct peer *next_peer = NULL;
-	struct listnode *node;
 
 	bgp = bgp_get_default();
 	if (!bgp)
 		return NULL;
 
-	for (ALL_LIST_ELEMENTS_RO(bgp->peer, node, peer)) {
+	frr_each (bgp_peers, &bgp->peer, peer) {
 		if (sockunion_family(&peer->su) != AF_INET)
 			continue;
 		if (ntohl(sockunion2ip(&peer->su)) <= ntohl(src->s_addr))
@@ -0,0 +1,302 @@
+/* BGP active/standby state sync
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* Mirrors BGP session state onto a hot standby over the lib/statesync
+ * change feed.  The active publishes every FSM transition (and the TCP
+ * endpoints of established sessions); the standby keeps a mirror table
+ * it can use to prioritize session bring-up at failover, instead of
+ * discovering the peer set cold.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "linklist.h"
+#include "log.h"
+#include "memory.h"
+#include "sockunion.h"
+#include "statesync.h"
+#include "stream.h"
+#include "thread.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_debug.h"
+#include "bgpd/bgp_memory.h"
+#include "bgpd/bgp_vty.h"
+#include "bgpd/bgp_statesync.h"
+
+DEFINE_MTYPE_STATIC(BGPD, BGP_SYNC_PEER, "BGP synced peer state")
+
+/* statesync message types owned by bgpd */
+#define BGP_SYNC_PEER_STATE  1
+#define BGP_SYNC_TCP_SESSION 2
+
+static struct statesync *bgp_ss;
+
+/* standby: mirror of the active's session table */
+static struct list *bgp_sync_peers;
+
+struct bgp_sync_peer {
+	union sockunion su;
+	as_t as;
+	uint8_t status;
+
+	/* TCP endpoints of the established session on the active; what a
+	 * full socket handoff would need to checkpoint at switchover */
+	union sockunion su_local;
+	union sockunion su_remote;
+	bool session_valid;
+};
+
+static struct bgp_sync_peer *bgp_sync_peer_get(union sockunion *su, as_t as)
+{
+	struct bgp_sync_peer *sp;
+	struct listnode *node;
+
+	for (ALL_LIST_ELEMENTS_RO(bgp_sync_peers, node, sp))
+		if (sp->as == as && sockunion_same(&sp->su, su))
+			return sp;
+
+	sp = XCALLOC(MTYPE_BGP_SYNC_PEER, sizeof(struct bgp_sync_peer));
+	sp->su = *su;
+	sp->as = as;
+	listnode_add(bgp_sync_peers, sp);
+
+	return sp;
+}
+
+static void bgp_sync_put_su(struct stream *s, const union sockunion *su)
+{
+	if (su && sockunion_family(su) == AF_INET6) {
+		stream_putc(s, AF_INET6);
+		stream_put(s, &su->sin6.sin6_addr, IPV6_MAX_BYTELEN);
+		stream_putw(s, ntohs(su->sin6.sin6_port));
+	} else if (su && sockunion_family(su) == AF_INET) {
+		stream_putc(s, AF_INET);
+		stream_put_ipv4(s, su->sin.sin_addr.s_addr);
+		stream_putw(s, ntohs(su->sin.sin_port));
+	} else {
+		stream_putc(s, AF_UNSPEC);
+	}
+}
+
+static int bgp_sync_get_su(struct stream *s, union sockunion *su)
+{
+	uint8_t family = stream_getc(s);
+
+	memset(su, 0, sizeof(*su));
+	switch (family) {
+	case AF_INET:
+		su->sin.sin_family = AF_INET;
+		su->sin.sin_addr.s_addr = stream_get_ipv4(s);
+		su->sin.sin_port = htons(stream_getw(s));
+		return 0;
+	case AF_INET6:
+		su->sin6.sin6_family = AF_INET6;
+		stream_get(&su->sin6.sin6_addr, s, IPV6_MAX_BYTELEN);
+		su->sin6.sin6_port = htons(stream_getw(s));
+		return 0;
+	case AF_UNSPEC:
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+static void bgp_sync_send_peer(struct peer *peer)
+{
+	struct stream *s;
+
+	s = stream_new(STATESYNC_MAX_PACKET_SIZE);
+	bgp_sync_put_su(s, &peer->su);
+	stream_putl(s, peer->as);
+	stream_putc(s, peer->status);
+	statesync_send(bgp_ss, BGP_SYNC_PEER_STATE, s);
+	stream_free(s);
+
+	/* endpoint record for established sessions; cleared otherwise */
+	s = stream_new(STATESYNC_MAX_PACKET_SIZE);
+	bgp_sync_put_su(s, &peer->su);
+	stream_putl(s, peer->as);
+	if (peer->status == Established) {
+		stream_putc(s, 1);
+		bgp_sync_put_su(s, peer->su_local);
+		bgp_sync_put_su(s, peer->su_remote);
+	} else {
+		stream_putc(s, 0);
+	}
+	statesync_send(bgp_ss, BGP_SYNC_TCP_SESSION, s);
+	stream_free(s);
+}
+
+void bgp_statesync_peer_state(struct peer *peer)
+{
+	if (!bgp_ss || bgp_ss->role != STATESYNC_ACTIVE
+	    || !statesync_connected(bgp_ss))
+		return;
+
+	bgp_sync_send_peer(peer);
+}
+
+/* active: replay the whole session table to a fresh standby */
+static void bgp_sync_dump(struct statesync *ss)
+{
+	struct listnode *node;
+	struct peer *peer;
+	struct bgp *bgp;
+
+	for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp))
+		frr_each (bgp_peers, &bgp->peer, peer)
+			bgp_sync_send_peer(peer);
+}
+
+static int bgp_sync_apply_peer_state(struct statesync *ss, struct stream *s,
+				     size_t len)
+{
+	struct bgp_sync_peer *sp;
+	union sockunion su;
+	as_t as;
+
+	if (bgp_sync_get_su(s, &su) < 0)
+		return -1;
+	as = stream_getl(s);
+
+	sp = bgp_sync_peer_get(&su, as);
+	sp->status = stream_getc(s);
+
+	return 0;
+}
+
+static int bgp_sync_apply_tcp_session(struct statesync *ss, struct stream *s,
+				      size_t len)
+{
+	struct bgp_sync_peer *sp;
+	union sockunion su;
+	as_t as;
+
+	if (bgp_sync_get_su(s, &su) < 0)
+		return -1;
+	as = stream_getl(s);
+
+	sp = bgp_sync_peer_get(&su, as);
+	sp->session_valid = stream_getc(s);
+	if (sp->session_valid) {
+		if (bgp_sync_get_su(s, &sp->su_local) < 0
+		    || bgp_sync_get_su(s, &sp->su_remote) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+DEFUN (bgp_state_sync_active,
+       bgp_state_sync_active_cmd,
+       "bgp state-sync active (1024-65535)",
+       BGP_STR
+       "Active/standby state synchronization\n"
+       "Act as the active, feeding a standby\n"
+       "TCP port to listen on for the standby\n")
+{
+	if (statesync_active_start(bgp_ss, strtoul(argv[3]->arg, NULL, 10))
+	    < 0) {
+		vty_out(vty, "%% Cannot listen on port %s\n", argv[3]->arg);
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (bgp_state_sync_standby,
+       bgp_state_sync_standby_cmd,
+       "bgp state-sync standby <A.B.C.D|X:X::X:X> (1024-65535)",
+       BGP_STR
+       "Active/standby state synchronization\n"
+       "Act as the standby, mirroring from the active\n"
+       "IPv4 address of the active\n"
+       "IPv6 address of the active\n"
+       "State-sync TCP port on the active\n")
+{
+	if (statesync_standby_start(bgp_ss, argv[3]->arg,
+				    strtoul(argv[4]->arg, NULL, 10))
+	    < 0) {
+		vty_out(vty, "%% Invalid active address %s\n", argv[3]->arg);
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_bgp_state_sync,
+       no_bgp_state_sync_cmd,
+       "no bgp state-sync",
+       NO_STR
+       BGP_STR
+       "Active/standby state synchronization\n")
+{
+	statesync_stop(bgp_ss);
+	list_delete_all_node(bgp_sync_peers);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (show_bgp_state_sync,
+       show_bgp_state_sync_cmd,
+       "show bgp state-sync",
+       SHOW_STR
+       BGP_STR
+       "Active/standby state synchronization\n")
+{
+	struct bgp_sync_peer *sp;
+	struct listnode *node;
+	char buf[SU_ADDRSTRLEN];
+
+	statesync_show(vty, bgp_ss);
+
+	if (bgp_ss->role != STATESYNC_STANDBY
+	    || !listcount(bgp_sync_peers))
+		return CMD_SUCCESS;
+
+	vty_out(vty, "\nMirrored sessions:\n");
+	vty_out(vty, "%-24s %10s %-12s %s\n", "Peer", "AS", "State",
+		"Session");
+	for (ALL_LIST_ELEMENTS_RO(bgp_sync_peers, node, sp))
+		vty_out(vty, "%-24s %10u %-12s %s\n",
+			sockunion2str(&sp->su, buf, sizeof(buf)), sp->as,
+			lookup_msg(bgp_status_msg, sp->status, "?"),
+			sp->session_valid ? "established" : "-");
+
+	return CMD_SUCCESS;
+}
+
+void bgp_statesync_init(void)
+{
+	bgp_ss = statesync_new(bm->master);
+	bgp_sync_peers = list_new();
+
+	statesync_register(bgp_ss, BGP_SYNC_PEER_STATE, "bgp-peer-state",
+			   bgp_sync_dump, bgp_sync_apply_peer_state);
+	statesync_register(bgp_ss, BGP_SYNC_TCP_SESSION, "bgp-tcp-session",
+			   NULL, bgp_sync_apply_tcp_session);
+
+	install_element(ENABLE_NODE, &bgp_state_sync_active_cmd);
+	install_element(ENABLE_NODE, &bgp_state_sync_standby_cmd);
+	install_element(ENABLE_NODE, &no_bgp_state_sync_cmd);
+	install_element(VIEW_NODE, &show_bgp_state_sync_cmd);
+}
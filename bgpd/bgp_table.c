@@ -36,6 +36,12 @@ void bgp_table_lock(struct bgp_table *rt)
 	rt->lock++;
 }
 
+static void bgp_table_walk_flush(struct bgp_table *rt)
+{
+	XFREE(MTYPE_BGP_TABLE_WALK, rt->walk_nodes);
+	rt->walk_count = 0;
+}
+
 void bgp_table_unlock(struct bgp_table *rt)
 {
 	assert(rt->lock > 0);
@@ -45,6 +51,10 @@ void bgp_table_unlock(struct bgp_table *rt)
 		return;
 	}
 
+	assert(rt->walk_refs == 0);
+	bgp_table_walk_flush(rt);
+	bgp_table_change_feed_disable(rt);
+
 	route_table_finish(rt->route_table);
 	rt->route_table = NULL;
 
@@ -66,6 +76,11 @@ static struct route_node *bgp_node_create(route_table_delegate_t *delegate,
 					  struct route_table *table)
 {
 	struct bgp_node *node;
+	struct bgp_table *rt = table->info;
+
+	if (rt)
+		rt->node_gen++;
+
 	node = XCALLOC(MTYPE_BGP_NODE, sizeof(struct bgp_node));
 
 	RB_INIT(bgp_adj_out_rb, &node->adj_out);
@@ -83,6 +98,8 @@ static void bgp_node_destroy(route_table_delegate_t *delegate,
 	bgp_node = bgp_node_from_rnode(node);
 	rt = table->info;
 
+	rt->node_gen++;
+
 	if (rt->bgp) {
 		bgp_addpath_free_node_data(&rt->bgp->tx_addpath,
 					 &bgp_node->tx_addpath,
@@ -127,6 +144,160 @@ struct bgp_table *bgp_table_init(struct bgp *bgp, afi_t afi, safi_t safi)
 	return rt;
 }
 
+/*
+ * bgp_table_walk_acquire
+ *
+ * Returns a flat array of every node in the table, for linear iteration
+ * by full-table walkers.  Each entry is locked, so the pointers stay
+ * valid even if routes are withdrawn mid-walk (a walker may still find
+ * an entry empty of path info and must handle that, just as with a trie
+ * walk).  The array is cached on the table and rebuilt lazily, only
+ * after nodes have been created or destroyed since it was last built.
+ * Must be paired with bgp_table_walk_release().
+ */
+struct bgp_node **bgp_table_walk_acquire(struct bgp_table *rt,
+					 unsigned int *count)
+{
+	struct bgp_node *rn;
+	unsigned int i;
+
+	if (rt->walk_refs == 0) {
+		if (rt->walk_nodes && rt->walk_gen != rt->node_gen)
+			bgp_table_walk_flush(rt);
+
+		if (!rt->walk_nodes) {
+			rt->walk_count = bgp_table_count(rt);
+			rt->walk_gen = rt->node_gen;
+			if (rt->walk_count) {
+				rt->walk_nodes = XMALLOC(
+					MTYPE_BGP_TABLE_WALK,
+					rt->walk_count
+						* sizeof(struct bgp_node *));
+				i = 0;
+				for (rn = bgp_table_top(rt); rn;
+				     rn = bgp_route_next(rn))
+					rt->walk_nodes[i++] = rn;
+				assert(i == rt->walk_count);
+			}
+		}
+
+		/* Pin the entries for the duration of the walk(s). */
+		for (i = 0; i < rt->walk_count; i++)
+			bgp_lock_node(rt->walk_nodes[i]);
+	}
+
+	rt->walk_refs++;
+	*count = rt->walk_count;
+	return rt->walk_nodes;
+}
+
+/*
+ * bgp_table_walk_release
+ *
+ * Drops the node references taken by bgp_table_walk_acquire().  The
+ * array itself is kept for the next full walk.
+ */
+void bgp_table_walk_release(struct bgp_table *rt)
+{
+	unsigned int i;
+
+	assert(rt->walk_refs > 0);
+	if (--rt->walk_refs == 0)
+		for (i = 0; i < rt->walk_count; i++)
+			bgp_unlock_node(rt->walk_nodes[i]);
+}
+
+/*
+ * bgp_table_change_feed_enable
+ *
+ * Start recording bestpath changes for this table into a ring of 'size'
+ * records (0 picks a default).  Until this is called the feed costs one
+ * branch per version bump; an existing ring is discarded, so consumers
+ * must resynchronize with bgp_table_change_feed_tell() afterwards.
+ */
+void bgp_table_change_feed_enable(struct bgp_table *rt, uint32_t size)
+{
+	bgp_table_change_feed_disable(rt);
+
+	if (size == 0)
+		size = BGP_TABLE_CHANGE_FEED_DEFAULT;
+
+	rt->change_ring = XCALLOC(MTYPE_BGP_TABLE_CHANGE,
+				  size * sizeof(struct bgp_table_change));
+	rt->change_ring_size = size;
+	rt->change_head = 0;
+}
+
+void bgp_table_change_feed_disable(struct bgp_table *rt)
+{
+	XFREE(MTYPE_BGP_TABLE_CHANGE, rt->change_ring);
+	rt->change_ring_size = 0;
+	rt->change_head = 0;
+}
+
+/*
+ * bgp_table_change_record
+ *
+ * Append one record to the table's change feed; called right after the
+ * node's version has been bumped for a bestpath change.
+ */
+void bgp_table_change_record(struct bgp_node *rn, int withdraw)
+{
+	struct bgp_table *rt = bgp_node_table(rn);
+	struct bgp_table_change *rec;
+
+	if (!rt->change_ring)
+		return;
+
+	rec = &rt->change_ring[rt->change_head % rt->change_ring_size];
+	prefix_copy(&rec->p, &rn->p);
+	rec->version = rn->version;
+	rec->op = withdraw ? BGP_TABLE_CHANGE_WITHDRAW
+			   : BGP_TABLE_CHANGE_UPDATE;
+	rt->change_head++;
+}
+
+/*
+ * bgp_table_change_feed_tell
+ *
+ * Current head of the feed; the position a consumer should start from
+ * after a full dump.
+ */
+uint64_t bgp_table_change_feed_tell(struct bgp_table *rt)
+{
+	return rt->change_head;
+}
+
+/*
+ * bgp_table_change_feed_read
+ *
+ * Copy out up to 'max' records starting at *feed_next (a position
+ * previously obtained from this function or from _tell()) and advance
+ * *feed_next past them.  Returns the number of records copied, or -1 if
+ * the ring has wrapped past the consumer's position -- the consumer
+ * fell too far behind and must re-dump the table, then resume from
+ * bgp_table_change_feed_tell().
+ */
+int bgp_table_change_feed_read(struct bgp_table *rt, uint64_t *feed_next,
+			       struct bgp_table_change *buf, int max)
+{
+	int n = 0;
+
+	if (!rt->change_ring || *feed_next > rt->change_head)
+		return -1;
+
+	/* Overrun: the oldest retained record is newer than requested. */
+	if (rt->change_head - *feed_next > rt->change_ring_size)
+		return -1;
+
+	while (*feed_next < rt->change_head && n < max) {
+		buf[n++] = rt->change_ring[*feed_next % rt->change_ring_size];
+		(*feed_next)++;
+	}
+
+	return n;
+}
+
 static struct bgp_node *
 bgp_route_next_until_maxlen(struct bgp_node *node, const struct bgp_node *limit,
 			    const uint8_t maxlen)
@@ -28,6 +28,21 @@
 #include "bgpd.h"
 #include "bgp_advertise.h"
 
+/* One slot of a table's change feed: the prefix whose bestpath changed,
+ * the table version stamped on it and whether the change was an update
+ * or a withdraw of the bestpath.
+ */
+struct bgp_table_change {
+	struct prefix p;
+	uint64_t version;
+	uint8_t op;
+#define BGP_TABLE_CHANGE_UPDATE   0
+#define BGP_TABLE_CHANGE_WITHDRAW 1
+};
+
+/* Default ring size for bgp_table_change_feed_enable(0). */
+#define BGP_TABLE_CHANGE_FEED_DEFAULT 8192
+
 struct bgp_table {
 	/* table belongs to this instance */
 	struct bgp *bgp;
@@ -40,6 +55,32 @@ struct bgp_table {
 
 	struct route_table *route_table;
 	uint64_t version;
+
+	/*
+	 * Generation-stamped side-array of all nodes in the table, enabling
+	 * linear (prefetch-friendly) iteration for full-table walks instead
+	 * of chasing pointers through the radix trie.
+	 *
+	 * @see bgp_table_walk_acquire
+	 */
+	struct bgp_node **walk_nodes;
+	unsigned int walk_count;
+	unsigned int walk_refs;
+	uint64_t node_gen;
+	uint64_t walk_gen;
+
+	/*
+	 * Ring buffer of version-stamped change records, fed from the
+	 * bestpath version bump and drained by monitoring exporters so
+	 * they can stream deltas instead of re-dumping the table.  NULL
+	 * (and zero cost beyond one branch per bump) until a consumer
+	 * enables it.
+	 *
+	 * @see bgp_table_change_feed_enable
+	 */
+	struct bgp_table_change *change_ring;
+	uint32_t change_ring_size;
+	uint64_t change_head;
 };
 
 struct bgp_node {
@@ -88,6 +129,17 @@ extern struct bgp_table *bgp_table_init(struct bgp *bgp, afi_t, safi_t);
 extern void bgp_table_lock(struct bgp_table *);
 extern void bgp_table_unlock(struct bgp_table *);
 extern void bgp_table_finish(struct bgp_table **);
+extern struct bgp_node **bgp_table_walk_acquire(struct bgp_table *table,
+						unsigned int *count);
+extern void bgp_table_walk_release(struct bgp_table *table);
+extern void bgp_table_change_feed_enable(struct bgp_table *table,
+					 uint32_t size);
+extern void bgp_table_change_feed_disable(struct bgp_table *table);
+extern void bgp_table_change_record(struct bgp_node *node, int withdraw);
+extern uint64_t bgp_table_change_feed_tell(struct bgp_table *table);
+extern int bgp_table_change_feed_read(struct bgp_table *table,
+				      uint64_t *feed_next,
+				      struct bgp_table_change *buf, int max);
 
 
 /*
@@ -216,6 +268,18 @@ static inline struct bgp_node *bgp_node_match(const struct bgp_table *table,
 	return bgp_node_from_rnode(route_node_match(table->route_table, p));
 }
 
+/*
+ * bgp_node_match_nolock
+ *
+ * No reference is taken on the result; compare-only callers.
+ */
+static inline struct bgp_node *
+bgp_node_match_nolock(const struct bgp_table *table, struct prefix *p)
+{
+	return bgp_node_from_rnode(
+		route_node_match_nolock(table->route_table, p));
+}
+
 /*
  * bgp_node_match_ipv4
  */
@@ -241,6 +305,21 @@ static inline unsigned long bgp_table_count(const struct bgp_table *const table)
 	return route_table_count(table->route_table);
 }
 
+/*
+ * bgp_table_walk_next
+ *
+ * Returns entry 'idx' of an array obtained from bgp_table_walk_acquire(),
+ * prefetching a few entries ahead to hide the node loads of a linear walk.
+ */
+static inline struct bgp_node *bgp_table_walk_next(struct bgp_node **nodes,
+						   unsigned int count,
+						   unsigned int idx)
+{
+	if (idx + 8 < count)
+		__builtin_prefetch(nodes[idx + 8]);
+	return nodes[idx];
+}
+
 /*
  * bgp_table_get_next
  */
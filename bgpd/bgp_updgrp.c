@@ -373,15 +373,24 @@ static unsigned int updgrp_hash_key_make(void *p)
 	/*
 	 * There are certain peers that must get their own update-group:
 	 * - lonesoul peers
-	 * - peers that negotiated ORF
 	 */
-	if (CHECK_FLAG(peer->flags, PEER_FLAG_LONESOUL)
-	    || CHECK_FLAG(peer->af_cap[afi][safi], PEER_CAP_ORF_PREFIX_SM_RCV)
-	    || CHECK_FLAG(peer->af_cap[afi][safi],
-			  PEER_CAP_ORF_PREFIX_SM_OLD_RCV))
+	if (CHECK_FLAG(peer->flags, PEER_FLAG_LONESOUL))
 		key = jhash_1word(jhash(peer->host, strlen(peer->host), SEED2),
 				  key);
 
+	/*
+	 * Peers that negotiated ORF are keyed on the content of the filter
+	 * they sent rather than their identity, so peers pushing identical
+	 * filters (or none yet) share adj-out and packet formation. The
+	 * ORF capability flags are already part of the af_cap word above.
+	 */
+	if (CHECK_FLAG(peer->af_cap[afi][safi], PEER_CAP_ORF_PREFIX_SM_RCV)
+	    || CHECK_FLAG(peer->af_cap[afi][safi],
+			  PEER_CAP_ORF_PREFIX_SM_OLD_RCV))
+		key = jhash_1word(
+			prefix_list_content_hash(peer->orf_plist[afi][safi]),
+			key);
+
 	return key;
 }
 
@@ -493,11 +502,19 @@ static bool updgrp_hash_cmp(const void *p1, const void *p2)
 	if ((afi == AFI_IP6) && (pe1->shared_network != pe2->shared_network))
 		return false;
 
-	if ((CHECK_FLAG(pe1->flags, PEER_FLAG_LONESOUL)
-	     || CHECK_FLAG(pe1->af_cap[afi][safi], PEER_CAP_ORF_PREFIX_SM_RCV)
+	if (CHECK_FLAG(pe1->flags, PEER_FLAG_LONESOUL)
+	    && !sockunion_same(&pe1->su, &pe2->su))
+		return false;
+
+	/* ORF peers share an update-group iff their received filters would
+	 * permit and deny exactly the same prefixes (the capability flags
+	 * themselves were compared above).
+	 */
+	if ((CHECK_FLAG(pe1->af_cap[afi][safi], PEER_CAP_ORF_PREFIX_SM_RCV)
 	     || CHECK_FLAG(pe1->af_cap[afi][safi],
 			   PEER_CAP_ORF_PREFIX_SM_OLD_RCV))
-	    && !sockunion_same(&pe1->su, &pe2->su))
+	    && prefix_list_content_cmp(pe1->orf_plist[afi][safi],
+				       pe2->orf_plist[afi][safi]))
 		return false;
 
 	return true;
@@ -620,6 +637,8 @@ static int update_group_show_walkcb(struct update_group *updgrp, void *arg)
 			subgroup_total_packets_enqueued(subgrp));
 		vty_out(vty, "    Packet queue high watermark: %d\n",
 			bpacket_queue_hwm_length(SUBGRP_PKTQ(subgrp)));
+		vty_out(vty, "    Packets deferred by pacing: %u\n",
+			subgrp->pace_defers);
 		vty_out(vty, "    Adj-out list count: %u\n", subgrp->adj_count);
 		vty_out(vty, "    Advertise list: %s\n",
 			advertise_list_is_empty(subgrp) ? "empty"
@@ -1668,6 +1687,42 @@ void update_group_adjust_peer(struct peer_af *paf)
 	return;
 }
 
+/*
+ * update_group_orf_plist_detach
+ *
+ * The conf peer of a peer's update group may hold a reference to that
+ * peer's received ORF prefix list (copied at group creation or carried
+ * over from the hash key). Call this before the list's contents are
+ * changed or the list is destroyed; the reference is repointed at a
+ * surviving member's (content-identical) list, or cleared.
+ */
+void update_group_orf_plist_detach(struct peer *peer, afi_t afi, safi_t safi)
+{
+	struct peer_af *paf, *mpaf;
+	struct update_group *updgrp;
+	struct update_subgroup *subgrp;
+	struct peer *conf;
+
+	paf = peer_af_find(peer, afi, safi);
+	if (!paf || !PAF_SUBGRP(paf))
+		return;
+
+	updgrp = PAF_UPDGRP(paf);
+	conf = UPDGRP_PEER(updgrp);
+	if (conf->orf_plist[afi][safi] != peer->orf_plist[afi][safi])
+		return;
+
+	conf->orf_plist[afi][safi] = NULL;
+	UPDGRP_FOREACH_SUBGRP (updgrp, subgrp)
+		SUBGRP_FOREACH_PEER (subgrp, mpaf)
+			if (mpaf->peer != peer
+			    && mpaf->peer->orf_plist[afi][safi]) {
+				conf->orf_plist[afi][safi] =
+					mpaf->peer->orf_plist[afi][safi];
+				return;
+			}
+}
+
 int update_group_adjust_soloness(struct peer *peer, int set)
 {
 	struct peer_group *group;
@@ -51,6 +51,17 @@
 #define BGP_MAX_SUBGROUP_COALESCE_TIME 10000
 #define BGP_PEER_ADJUST_SUBGROUP_COALESCE_TIME 50
 
+/*
+ * UPDATE pacing.  When a member's backlog on the subgroup packet queue
+ * exceeds one write quantum, emission for that member is smoothed over
+ * its MRAI window by a per-peer token bucket instead of being drained
+ * as fast as the I/O thread can write it.  The rate floor keeps a huge
+ * backlog over a short window from overshooting the window, and the
+ * burst cap bounds how many packets an idle bucket can bank up.
+ */
+#define SUBGRP_PACING_MIN_RATE		20 /* packets per second */
+#define SUBGRP_PACING_BURST_QUANTA	2  /* burst cap, in write quanta */
+
 #define PEER_UPDGRP_FLAGS                                                      \
 	(PEER_FLAG_LOCAL_AS_NO_PREPEND | PEER_FLAG_LOCAL_AS_REPLACE_AS)
 
@@ -248,6 +259,9 @@ struct update_subgroup {
 	uint32_t split_events;
 	uint32_t merge_checks_triggered;
 
+	/* number of times UPDATE emission was deferred by pacing */
+	uint32_t pace_defers;
+
 	uint64_t id;
 
 	uint16_t sflags;
@@ -264,6 +278,13 @@ struct update_subgroup {
 
 #define SUBGRP_STATUS_DEFAULT_ORIGINATE   (1 << 0)
 
+/*
+ * This refresh must resend every prefix, even ones whose advertised
+ * attributes are unchanged - set when the peer asked for the routes
+ * (route-refresh/ORF) or the operator issued a soft clear.
+ */
+#define SUBGRP_STATUS_FORCE_UPDATES       (1 << 1)
+
 /*
  * Add the given value to the specified counter on a subgroup and its
  * parent structures.
@@ -366,6 +387,8 @@ extern void update_group_show(struct bgp *bgp, afi_t afi, safi_t safi,
 			      struct vty *vty, uint64_t subgrp_id);
 extern void update_group_show_stats(struct bgp *bgp, struct vty *vty);
 extern void update_group_adjust_peer(struct peer_af *paf);
+extern void update_group_orf_plist_detach(struct peer *peer, afi_t afi,
+					  safi_t safi);
 extern int update_group_adjust_soloness(struct peer *peer, int set);
 
 extern void update_subgroup_remove_peer(struct update_subgroup *,
@@ -408,10 +431,13 @@ extern void bpacket_queue_advance_peer(struct peer_af *paf);
 extern void bpacket_queue_remove_peer(struct peer_af *paf);
 extern void bpacket_add_peer(struct bpacket *pkt, struct peer_af *paf);
 unsigned int bpacket_queue_virtual_length(struct peer_af *paf);
+extern uint32_t subgroup_pacing_take(struct peer_af *paf, uint32_t want);
+extern uint32_t subgroup_pacing_wait_msec(struct peer_af *paf);
 extern void bpacket_queue_show_vty(struct bpacket_queue *q, struct vty *vty);
 int subgroup_packets_to_build(struct update_subgroup *subgrp);
 extern struct bpacket *subgroup_update_packet(struct update_subgroup *s);
 extern struct bpacket *subgroup_withdraw_packet(struct update_subgroup *s);
+extern void subgroup_build_packets_parallel(struct bgp *bgp);
 extern struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 						struct peer_af *paf);
 extern void bpacket_attr_vec_arr_reset(struct bpacket_attr_vec_arr *vecarr);
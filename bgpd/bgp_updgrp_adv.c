@@ -50,6 +50,8 @@
 #include "bgpd/bgp_updgrp.h"
 #include "bgpd/bgp_advertise.h"
 #include "bgpd/bgp_addpath.h"
+#include "bgpd/bgp_bestpath.h"
+#include "bgpd/bgp_nexthop.h"
 
 
 /********************
@@ -317,39 +319,240 @@ static void updgrp_show_adj(struct bgp *bgp, afi_t afi, safi_t safi,
 	update_group_af_walk(bgp, afi, safi, updgrp_show_adj_walkcb, &ctx);
 }
 
-static int subgroup_coalesce_timer(struct thread *thread)
+/*
+ * True while per-AFI/SAFI announce items run on the worker pool.
+ * Workers may not touch the MRAI timers (timer cancellation is
+ * main-thread only), so bgp_adj_out_set_subgroup() skips the
+ * adjustment and the dispatcher performs it after the join, and
+ * subgroup_announce_table() skips default-originate, which the
+ * dispatcher runs up front.
+ */
+static bool announce_batch_active;
+
+/*
+ * One work item per AFI/SAFI.  Subgroups of the same AFI/SAFI share
+ * route nodes (their adj-out trees hang off the common table), so they
+ * stay serialized within one item; different AFI/SAFIs walk disjoint
+ * bgp->rib tables and may proceed in parallel.
+ */
+struct announce_batch_item {
+	struct update_subgroup **subgrps;
+	unsigned int count;
+	unsigned int size;
+};
+
+struct announce_batch {
+	struct announce_batch_item items[AFI_MAX][SAFI_MAX];
+	struct update_subgroup *first; /* subgroup whose timer fired */
+};
+
+static void announce_batch_add(struct announce_batch *batch,
+			       struct update_subgroup *subgrp)
 {
+	struct announce_batch_item *item =
+		&batch->items[SUBGRP_AFI(subgrp)][SUBGRP_SAFI(subgrp)];
+
+	if (item->count == item->size) {
+		item->size = item->size ? item->size * 2 : 4;
+		item->subgrps = XREALLOC(MTYPE_TMP, item->subgrps,
+					 item->size * sizeof(*item->subgrps));
+	}
+	item->subgrps[item->count++] = subgrp;
+}
+
+/*
+ * Sweep one update group for subgroups whose coalesce timers are still
+ * pending; they would have fired back to back on the main thread, so
+ * pull them into the batch instead.
+ */
+static int announce_batch_collect_cb(struct update_group *updgrp, void *arg)
+{
+	struct announce_batch *batch = arg;
 	struct update_subgroup *subgrp;
 
-	subgrp = THREAD_ARG(thread);
-	if (bgp_debug_update(NULL, NULL, subgrp->update_group, 0))
-		zlog_debug("u%" PRIu64 ":s%" PRIu64
-			   " announcing routes upon coalesce timer expiry",
-			   (SUBGRP_UPDGRP(subgrp))->id, subgrp->id);
-	subgrp->t_coalesce = NULL;
-	subgrp->v_coalesce = 0;
-	subgroup_announce_route(subgrp);
+	UPDGRP_FOREACH_SUBGRP (updgrp, subgrp) {
+		if (subgrp == batch->first) {
+			announce_batch_add(batch, subgrp);
+			continue;
+		}
+
+		if (!subgrp->t_coalesce)
+			continue;
+
+		THREAD_TIMER_OFF(subgrp->t_coalesce);
+		subgrp->v_coalesce = 0;
+		announce_batch_add(batch, subgrp);
+	}
+
+	return UPDWALK_CONTINUE;
+}
+
+static void announce_batch_item_fn(void *arg)
+{
+	struct announce_batch_item *item = arg;
+	unsigned int i;
 
+	for (i = 0; i < item->count; i++)
+		subgroup_announce_route(item->subgrps[i]);
+}
 
-	/* While the announce_route() may kick off the route advertisement timer
-	 * for
-	 * the members of the subgroup, we'd like to send the initial updates
-	 * much
-	 * faster (i.e., without enforcing MRAI). Also, if there were no routes
-	 * to
-	 * announce, this is the method currently employed to trigger the EOR.
+/*
+ * The non-walk part of the announce stays on the main thread:
+ * default-originate builds and queues packets through code that was
+ * never audited for worker use.  Mirrors the conditions that
+ * subgroup_announce_route()/_table() apply.
+ */
+static void announce_batch_prepare(struct update_subgroup *subgrp)
+{
+	struct peer *peer = SUBGRP_PEER(subgrp);
+	struct peer *onlypeer;
+	struct peer_af *paf;
+	afi_t afi = SUBGRP_AFI(subgrp);
+	safi_t safi = SUBGRP_SAFI(subgrp);
+
+	/* Warm the connected-match mirrors so the workers' multiaccess
+	 * checks hit the cache read-only.
 	 */
+	SUBGRP_FOREACH_PEER (subgrp, paf)
+		bgp_peer_connected_match(PAF_PEER(paf));
+
+	onlypeer = ((SUBGRP_PCOUNT(subgrp) == 1) ? (SUBGRP_PFIRST(subgrp))->peer
+						 : NULL);
+	if (onlypeer
+	    && CHECK_FLAG(onlypeer->af_sflags[afi][safi],
+			  PEER_STATUS_ORF_WAIT_REFRESH))
+		return;
+
+	if (safi == SAFI_LABELED_UNICAST)
+		safi = SAFI_UNICAST;
+
+	if (safi != SAFI_MPLS_VPN && safi != SAFI_ENCAP && safi != SAFI_EVPN
+	    && CHECK_FLAG(peer->af_flags[afi][safi],
+			  PEER_FLAG_DEFAULT_ORIGINATE))
+		subgroup_default_originate(subgrp, 0);
+}
+
+/* Post-announce work for a subgroup whose coalesce timer was handled.
+ *
+ * While the announce_route() may kick off the route advertisement timer
+ * for the members of the subgroup, we'd like to send the initial
+ * updates much faster (i.e., without enforcing MRAI). Also, if there
+ * were no routes to announce, this is the method currently employed to
+ * trigger the EOR.
+ */
+static void subgroup_coalesce_done(struct update_subgroup *subgrp)
+{
 	if (!bgp_update_delay_active(SUBGRP_INST(subgrp))) {
 		struct peer_af *paf;
 		struct peer *peer;
 
 		SUBGRP_FOREACH_PEER (subgrp, paf) {
 			peer = PAF_PEER(paf);
-			BGP_TIMER_OFF(peer->t_routeadv);
-			BGP_TIMER_ON(peer->t_routeadv, bgp_routeadv_timer, 0);
+			bgp_routeadv_on(peer, 0);
+		}
+	}
+}
+
+/*
+ * Run the initial announce for every subgroup of the instance whose
+ * coalesce timer is pending as per-AFI/SAFI work items on the best-path
+ * worker pool, overlapping e.g. the VPNv4 and EVPN table walks that
+ * otherwise run back to back.  Returns false (leaving all timers and
+ * state untouched except the caller's) when the pool is down.
+ */
+static bool subgroup_announce_batch(struct update_subgroup *first)
+{
+	struct announce_batch batch;
+	void *items[AFI_MAX * SAFI_MAX];
+	unsigned int nitems = 0;
+	unsigned int nsubgrps = 0;
+	unsigned int i, j;
+	afi_t afi;
+	safi_t safi;
+
+	if (!bgp_bestpath_pool_active())
+		return false;
+
+	memset(&batch, 0, sizeof(batch));
+	batch.first = first;
+	update_group_walk(SUBGRP_INST(first), announce_batch_collect_cb,
+			  &batch);
+
+	FOREACH_AFI_SAFI (afi, safi) {
+		if (batch.items[afi][safi].count) {
+			items[nitems++] = &batch.items[afi][safi];
+			nsubgrps += batch.items[afi][safi].count;
+		}
+	}
+
+	if (nitems >= 2) {
+		if (bgp_debug_update(NULL, NULL, NULL, 0))
+			zlog_debug(
+				"announcing %u subgroups as %u parallel AFI/SAFI work items",
+				nsubgrps, nitems);
+
+		for (i = 0; i < nitems; i++) {
+			struct announce_batch_item *item = items[i];
+
+			for (j = 0; j < item->count; j++)
+				announce_batch_prepare(item->subgrps[j]);
+		}
+
+		/* Lazy route-map recompiles must not race between
+		 * workers; take them now.
+		 */
+		route_map_compile_all();
+
+		announce_batch_active = true;
+		bgp_bestpath_pool_run(items, nitems, announce_batch_item_fn);
+		announce_batch_active = false;
+	}
+
+	for (i = 0; i < nitems; i++) {
+		struct announce_batch_item *item = items[i];
+
+		for (j = 0; j < item->count; j++) {
+			struct update_subgroup *subgrp = item->subgrps[j];
+
+			if (nitems < 2) {
+				/* not worth forking - announce in place */
+				subgroup_announce_route(subgrp);
+			} else if (!BGP_ADV_FIFO_EMPTY(&subgrp->sync->update)) {
+				/* MRAI adjustment the workers skipped */
+				struct peer_af *paf;
+
+				SUBGRP_FOREACH_PEER (subgrp, paf)
+					bgp_adjust_routeadv(PAF_PEER(paf));
+			}
+
+			subgroup_coalesce_done(subgrp);
 		}
+
+		XFREE(MTYPE_TMP, item->subgrps);
 	}
 
+	return true;
+}
+
+static int subgroup_coalesce_timer(struct thread *thread)
+{
+	struct update_subgroup *subgrp;
+
+	subgrp = THREAD_ARG(thread);
+	if (bgp_debug_update(NULL, NULL, subgrp->update_group, 0))
+		zlog_debug("u%" PRIu64 ":s%" PRIu64
+			   " announcing routes upon coalesce timer expiry",
+			   (SUBGRP_UPDGRP(subgrp))->id, subgrp->id);
+	subgrp->t_coalesce = NULL;
+	subgrp->v_coalesce = 0;
+
+	/* Overlap the per-AFI/SAFI walks on the worker pool when possible. */
+	if (subgroup_announce_batch(subgrp))
+		return 0;
+
+	subgroup_announce_route(subgrp);
+	subgroup_coalesce_done(subgrp);
+
 	return 0;
 }
 
@@ -484,6 +687,21 @@ void bgp_adj_out_set_subgroup(struct bgp_node *rn,
 			return;
 	}
 
+	/*
+	 * If the attributes we are about to advertise are identical to
+	 * what has already been sent for this prefix and nothing is in
+	 * flight, the peers have exactly this state; re-enqueueing it
+	 * would only produce a duplicate UPDATE. This turns the full
+	 * table walk after a policy change into an incremental one that
+	 * only revisits prefixes whose advertised state can differ.
+	 */
+	if (adj->attr && !adj->adv && attr
+	    && !CHECK_FLAG(subgrp->sflags, SUBGRP_STATUS_FORCE_UPDATES)
+	    && attrhash_cmp(adj->attr, attr)) {
+		subgrp->version = max(subgrp->version, rn->version);
+		return;
+	}
+
 	if (adj->adv)
 		bgp_advertise_clean_subgroup(subgrp, adj);
 	adj->adv = bgp_advertise_new();
@@ -505,9 +723,12 @@ void bgp_adj_out_set_subgroup(struct bgp_node *rn,
 
 	/*
 	 * If the update adv list is empty, trigger the member peers'
-	 * mrai timers so the socket writes can happen.
+	 * mrai timers so the socket writes can happen.  Not from a
+	 * worker, though - timer manipulation is main-thread only, so
+	 * the batch dispatcher adjusts the timers after the join.
 	 */
-	if (BGP_ADV_FIFO_EMPTY(&subgrp->sync->update)) {
+	if (!announce_batch_active
+	    && BGP_ADV_FIFO_EMPTY(&subgrp->sync->update)) {
 		struct peer_af *paf;
 
 		SUBGRP_FOREACH_PEER (subgrp, paf) {
@@ -606,6 +827,9 @@ void subgroup_clear_table(struct update_subgroup *subgrp)
 void subgroup_announce_table(struct update_subgroup *subgrp,
 			     struct bgp_table *table)
 {
+	struct bgp_node **nodes;
+	unsigned int count;
+	unsigned int i;
 	struct bgp_node *rn;
 	struct bgp_path_info *ri;
 	struct attr attr;
@@ -625,12 +849,19 @@ void subgroup_announce_table(struct update_subgroup *subgrp,
 	if (!table)
 		table = peer->bgp->rib[afi][safi];
 
-	if (safi != SAFI_MPLS_VPN && safi != SAFI_ENCAP && safi != SAFI_EVPN
+	/* In a parallel batch the dispatcher has already default-originated
+	 * on the main thread.
+	 */
+	if (!announce_batch_active && safi != SAFI_MPLS_VPN
+	    && safi != SAFI_ENCAP && safi != SAFI_EVPN
 	    && CHECK_FLAG(peer->af_flags[afi][safi],
 			  PEER_FLAG_DEFAULT_ORIGINATE))
 		subgroup_default_originate(subgrp, 0);
 
-	for (rn = bgp_table_top(table); rn; rn = bgp_route_next(rn))
+	nodes = bgp_table_walk_acquire(table, &count);
+	for (i = 0; i < count; i++) {
+		rn = bgp_table_walk_next(nodes, count, i);
+
 		for (ri = bgp_node_get_bgp_path_info(rn); ri; ri = ri->next)
 
 			if (CHECK_FLAG(ri->flags, BGP_PATH_SELECTED)
@@ -649,6 +880,8 @@ void subgroup_announce_table(struct update_subgroup *subgrp,
 							peer, afi, safi,
 							&ri->tx_addpath));
 			}
+	}
+	bgp_table_walk_release(table);
 
 	/*
 	 * We walked through the whole table -- make sure our version number
@@ -703,6 +936,9 @@ void subgroup_announce_route(struct update_subgroup *subgrp)
 				continue;
 			subgroup_announce_table(subgrp, table);
 		}
+
+	/* A forced refresh is complete; revert to incremental behavior. */
+	UNSET_FLAG(subgrp->sflags, SUBGRP_STATUS_FORCE_UPDATES);
 }
 
 void subgroup_default_originate(struct update_subgroup *subgrp, int withdraw)
@@ -57,6 +57,8 @@
 #include "bgpd/bgp_mplsvpn.h"
 #include "bgpd/bgp_label.h"
 #include "bgpd/bgp_addpath.h"
+#include "bgpd/bgp_bestpath.h"
+#include "bgpd/bgp_memory.h"
 
 /********************
  * PRIVATE FUNCTIONS
@@ -362,6 +364,98 @@ unsigned int bpacket_queue_virtual_length(struct peer_af *paf)
 	return (UINT_MAX - pkt->ver + 1) + last->ver;
 }
 
+/*
+ * The pacing rate for a member with 'pending' packets queued behind its
+ * cursor: just enough to drain the backlog within the peer's MRAI
+ * window, floored so a near-expired window cannot stall the queue.
+ * Returns 0 if the peer runs without an MRAI, i.e. unpaced.
+ */
+static uint32_t subgroup_pacing_rate(struct peer_af *paf, uint32_t pending)
+{
+	uint32_t window = paf->peer->v_routeadv;
+
+	if (!window)
+		return 0;
+
+	return MAX(pending / window, SUBGRP_PACING_MIN_RATE);
+}
+
+/*
+ * Ask the pacing engine for permission to emit up to 'want' packets for
+ * the given member.  Returns how many may be emitted now.
+ *
+ * Members whose backlog fits within one write quantum are never paced -
+ * steady-state incremental updates go out immediately, exactly as
+ * before.  Only when a member falls behind by more than a quantum (full
+ * table announce, route refresh, policy change) does the token bucket
+ * engage, metering the drain over the MRAI window so that a subgroup
+ * full of peers whose routeadv timers expired on the same tick emits a
+ * flat, sustained stream rather than one synchronized burst per peer.
+ */
+uint32_t subgroup_pacing_take(struct peer_af *paf, uint32_t want)
+{
+	uint32_t pending, rate, grant, wpq;
+
+	pending = bpacket_queue_virtual_length(paf);
+	wpq = atomic_load_explicit(&paf->peer->bgp->wpkt_quanta,
+				   memory_order_relaxed);
+
+	if (pending <= wpq) {
+		/* Backlog drained (or small); disarm the bucket. */
+		paf->pace_armed = false;
+		return want;
+	}
+
+	rate = subgroup_pacing_rate(paf, pending);
+	if (!rate)
+		return want;
+
+	if (!paf->pace_armed) {
+		/* Arming: the bucket starts full, so the initial burst
+		 * allowance goes out unpaced before metering begins.
+		 */
+		token_bucket_init(&paf->pace_bucket, rate,
+				  wpq * SUBGRP_PACING_BURST_QUANTA);
+		paf->pace_armed = true;
+	} else {
+		/* Retarget to the current backlog; the rate tracks the
+		 * queue as it drains or refills mid-window.
+		 */
+		paf->pace_bucket.rate = rate;
+	}
+
+	grant = token_bucket_take(&paf->pace_bucket, want);
+
+	if (grant < want && paf->subgroup)
+		paf->subgroup->pace_defers++;
+
+	return grant;
+}
+
+/*
+ * How long (in milliseconds) before the member's bucket earns its next
+ * token.  Zero means the member is not being paced and the caller may
+ * reschedule immediately.
+ */
+uint32_t subgroup_pacing_wait_msec(struct peer_af *paf)
+{
+	uint32_t pending, wpq;
+
+	if (!paf->pace_armed)
+		return 0;
+
+	pending = bpacket_queue_virtual_length(paf);
+	wpq = atomic_load_explicit(&paf->peer->bgp->wpkt_quanta,
+				   memory_order_relaxed);
+	if (pending <= wpq)
+		return 0;
+
+	if (!subgroup_pacing_rate(paf, pending))
+		return 0;
+
+	return token_bucket_wait_msec(&paf->pace_bucket, 1);
+}
+
 /*
  * Dump the bpacket queue
  */
@@ -1075,6 +1169,89 @@ struct bpacket *subgroup_withdraw_packet(struct update_subgroup *subgrp)
 	return NULL;
 }
 
+/*
+ * Worker-side build loop for one subgroup: drain the advertise FIFOs
+ * into the subgroup packet queue until either is exhausted.  Safe off
+ * the main thread because everything it mutates - work/scratch streams,
+ * sync FIFOs, the baa hash, the packet queue - belongs to this one
+ * subgroup, and attribute encoding is pure given an interned attr (the
+ * intern/unintern refcounting itself is covered by the locking in
+ * bgp_attr.c).
+ */
+static void subgroup_build_packets_fn(void *arg)
+{
+	struct update_subgroup *subgrp = arg;
+
+	while (subgroup_packets_to_build(subgrp)) {
+		if (!subgroup_withdraw_packet(subgrp)
+		    && !subgroup_update_packet(subgrp))
+			break;
+	}
+}
+
+/* growable batch of subgroups with packets to build */
+struct subgrp_build_vec {
+	void **items;
+	uint32_t count;
+	uint32_t size;
+};
+
+static int subgroup_build_collect_cb(struct update_group *updgrp, void *ctx)
+{
+	struct subgrp_build_vec *vec = ctx;
+	struct update_subgroup *subgrp;
+
+	UPDGRP_FOREACH_SUBGRP (updgrp, subgrp) {
+		struct peer_af *paf;
+
+		if (!subgroup_packets_to_build(subgrp)
+		    || bpacket_queue_is_full(SUBGRP_INST(subgrp),
+					     SUBGRP_PKTQ(subgrp)))
+			continue;
+
+		/* Warm the connected-match mirrors so the workers'
+		 * multiaccess checks hit the cache read-only.
+		 */
+		SUBGRP_FOREACH_PEER (subgrp, paf)
+			bgp_peer_connected_match(PAF_PEER(paf));
+
+		if (vec->count == vec->size) {
+			vec->size *= 2;
+			vec->items = XREALLOC(MTYPE_BGP_PACKET, vec->items,
+					      vec->size * sizeof(void *));
+		}
+		vec->items[vec->count++] = subgrp;
+	}
+
+	return UPDWALK_CONTINUE;
+}
+
+/*
+ * Pre-build pending packets for every subgroup of the instance on the
+ * best-path worker pool, one subgroup per work item.  After this runs,
+ * peers draining their queues mostly just reformat finished streams
+ * onto their obufs on the main thread.  No-op when nothing is pending;
+ * callers fall back to on-demand serial builds when the pool is down.
+ */
+void subgroup_build_packets_parallel(struct bgp *bgp)
+{
+	struct subgrp_build_vec vec;
+
+	vec.count = 0;
+	vec.size = 32;
+	vec.items = XMALLOC(MTYPE_BGP_PACKET, vec.size * sizeof(void *));
+
+	update_group_walk(bgp, subgroup_build_collect_cb, &vec);
+
+	if (vec.count == 1)
+		subgroup_build_packets_fn(vec.items[0]);
+	else if (vec.count)
+		bgp_bestpath_pool_run(vec.items, vec.count,
+				      subgroup_build_packets_fn);
+
+	XFREE(MTYPE_BGP_PACKET, vec.items);
+}
+
 void subgroup_default_update_packet(struct update_subgroup *subgrp,
 				    struct attr *attr, struct peer *from)
 {
@@ -36,6 +36,7 @@
 #include "queue.h"
 #include "filter.h"
 #include "frrstr.h"
+#include "frr_pthread.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_attr_evpn.h"
@@ -65,6 +66,7 @@
 #include "bgpd/bgp_evpn.h"
 #include "bgpd/bgp_addpath.h"
 #include "bgpd/bgp_mac.h"
+#include "bgpd/bgp_bestpath.h"
 
 static struct peer_group *listen_range_exists(struct bgp *bgp,
 					      struct prefix *range, int exact);
@@ -575,22 +577,23 @@ static int bgp_clear(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
 {
 	int ret;
 	bool found = false;
-	struct peer *peer;
+	struct peer *peer, *npeer;
 	struct listnode *node, *nnode;
 
 	/* Clear all neighbors. */
 	/*
-	 * Pass along pointer to next node to peer_clear() when walking all
-	 * nodes on the BGP instance as that may get freed if it is a
+	 * Pass along pointer to the next peer to peer_clear() when walking
+	 * all peers on the BGP instance as that may get freed if it is a
 	 * doppelganger
 	 */
 	if (sort == clear_all) {
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		for (peer = bgp_peers_first(&bgp->peer); peer; peer = npeer) {
+			npeer = bgp_peers_next_safe(&bgp->peer, peer);
 			if (!peer->afc[afi][safi])
 				continue;
 
 			if (stype == BGP_CLEAR_SOFT_NONE)
-				ret = peer_clear(peer, &nnode);
+				ret = peer_clear(peer, &npeer);
 			else
 				ret = peer_clear_soft(peer, afi, safi, stype);
 
@@ -686,7 +689,8 @@ static int bgp_clear(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
 
 	/* Clear all external (eBGP) neighbors. */
 	if (sort == clear_external) {
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		for (peer = bgp_peers_first(&bgp->peer); peer; peer = npeer) {
+			npeer = bgp_peers_next_safe(&bgp->peer, peer);
 			if (peer->sort == BGP_PEER_IBGP)
 				continue;
 
@@ -694,7 +698,7 @@ static int bgp_clear(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
 				continue;
 
 			if (stype == BGP_CLEAR_SOFT_NONE)
-				ret = peer_clear(peer, &nnode);
+				ret = peer_clear(peer, &npeer);
 			else
 				ret = peer_clear_soft(peer, afi, safi, stype);
 
@@ -716,14 +720,15 @@ static int bgp_clear(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
 	if (sort == clear_as) {
 		as_t as = strtoul(arg, NULL, 10);
 
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		for (peer = bgp_peers_first(&bgp->peer); peer; peer = npeer) {
+			npeer = bgp_peers_next_safe(&bgp->peer, peer);
 			if (peer->as != as)
 				continue;
 
 			if (!peer->afc[afi][safi])
 				ret = BGP_ERR_AF_UNCONFIGURED;
 			else if (stype == BGP_CLEAR_SOFT_NONE)
-				ret = peer_clear(peer, &nnode);
+				ret = peer_clear(peer, &npeer);
 			else
 				ret = peer_clear_soft(peer, afi, safi, stype);
 
@@ -1609,6 +1614,42 @@ DEFUN (no_bgp_rpkt_quanta,
 	return bgp_rpkt_quanta_config_vty(vty, argv[idx_number]->arg, 0);
 }
 
+void bgp_config_write_read_rate_limit(struct vty *vty, struct bgp *bgp)
+{
+	uint32_t pps =
+		atomic_load_explicit(&bgp->io_read_pps, memory_order_relaxed);
+	if (pps)
+		vty_out(vty, " read-rate-limit %u\n", pps);
+}
+
+DEFUN (bgp_read_rate_limit,
+       bgp_read_rate_limit_cmd,
+       "read-rate-limit (100-1000000)",
+       "Maximum packets to read from each peer per second\n"
+       "Packets per second\n")
+{
+	VTY_DECLVAR_CONTEXT(bgp, bgp);
+	int idx_number = 1;
+
+	atomic_store_explicit(&bgp->io_read_pps,
+			      strtoul(argv[idx_number]->arg, NULL, 10),
+			      memory_order_relaxed);
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_bgp_read_rate_limit,
+       no_bgp_read_rate_limit_cmd,
+       "no read-rate-limit [(100-1000000)]",
+       NO_STR
+       "Maximum packets to read from each peer per second\n"
+       "Packets per second\n")
+{
+	VTY_DECLVAR_CONTEXT(bgp, bgp);
+
+	atomic_store_explicit(&bgp->io_read_pps, 0, memory_order_relaxed);
+	return CMD_SUCCESS;
+}
+
 void bgp_config_write_coalesce_time(struct vty *vty, struct bgp *bgp)
 {
 	if (!bgp->heuristic_coalesce)
@@ -1645,6 +1686,35 @@ DEFUN (no_bgp_coalesce_time,
 	return CMD_SUCCESS;
 }
 
+DEFUN (bgp_nht_eval_delay,
+       bgp_nht_eval_delay_cmd,
+       "bgp nexthop-eval-delay (0-60000)",
+       "BGP specific commands\n"
+       "Batch zebra next-hop updates before re-evaluating paths\n"
+       "Dampening window (in ms, 0 evaluates immediately)\n")
+{
+	VTY_DECLVAR_CONTEXT(bgp, bgp);
+
+	int idx = 0;
+	argv_find(argv, argc, "(0-60000)", &idx);
+	bgp->nht_eval_delay = strtoul(argv[idx]->arg, NULL, 10);
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_bgp_nht_eval_delay,
+       no_bgp_nht_eval_delay_cmd,
+       "no bgp nexthop-eval-delay [(0-60000)]",
+       NO_STR
+       "BGP specific commands\n"
+       "Batch zebra next-hop updates before re-evaluating paths\n"
+       "Dampening window (in ms, 0 evaluates immediately)\n")
+{
+	VTY_DECLVAR_CONTEXT(bgp, bgp);
+
+	bgp->nht_eval_delay = 0;
+	return CMD_SUCCESS;
+}
+
 /* Maximum-paths configuration */
 DEFUN (bgp_maxpaths,
        bgp_maxpaths_cmd,
@@ -1912,12 +1982,11 @@ DEFUN (no_bgp_deterministic_med,
 	afi_t afi;
 	safi_t safi;
 	struct peer *peer;
-	struct listnode *node, *nnode;
 
 	if (bgp_flag_check(bgp, BGP_FLAG_DETERMINISTIC_MED)) {
 		bestpath_per_as_used = 0;
 
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 			FOREACH_AFI_SAFI (afi, safi)
 				if (bgp_addpath_dmed_required(
 					peer->addpath_type[afi][safi])) {
@@ -5367,6 +5436,77 @@ DEFUN (no_bgp_set_route_map_delay_timer,
 	return CMD_SUCCESS;
 }
 
+/* Number of pthreads used for parallel best-path selection */
+DEFUN (bgp_bestpath_workers,
+       bgp_bestpath_workers_cmd,
+       "bgp bestpath-workers (2-16)",
+       BGP_STR
+       "Run best-path selection on worker pthreads\n"
+       "Number of worker pthreads\n")
+{
+	int idx_number = 2;
+
+	bm->bestpath_workers = strtoul(argv[idx_number]->arg, NULL, 10);
+	bgp_bestpath_pool_apply();
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_bgp_bestpath_workers,
+       no_bgp_bestpath_workers_cmd,
+       "no bgp bestpath-workers [(2-16)]",
+       NO_STR
+       BGP_STR
+       "Run best-path selection on worker pthreads\n"
+       "Number of worker pthreads\n")
+{
+	bm->bestpath_workers = 0;
+	bgp_bestpath_pool_apply();
+
+	return CMD_SUCCESS;
+}
+
+/* Number of pthreads used for peer socket I/O.  Unlike the best-path
+ * workers, the pool size is fixed once the daemon is up: peers are
+ * pinned to a pool member for their lifetime.
+ */
+DEFUN (bgp_io_threads,
+       bgp_io_threads_cmd,
+       "bgp io-threads (1-8)",
+       BGP_STR
+       "Number of pthreads handling peer socket I/O\n"
+       "Number of I/O pthreads\n")
+{
+	int idx_number = 2;
+
+	bm->io_nthreads = strtoul(argv[idx_number]->arg, NULL, 10);
+	if (bm->io_nthreads != bgp_io_nthreads
+	    && atomic_load_explicit(&bgp_pth_io_pool[0]->running,
+				    memory_order_relaxed))
+		vty_out(vty,
+			"%% I/O thread count change takes effect on restart\n");
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_bgp_io_threads,
+       no_bgp_io_threads_cmd,
+       "no bgp io-threads [(1-8)]",
+       NO_STR
+       BGP_STR
+       "Number of pthreads handling peer socket I/O\n"
+       "Number of I/O pthreads\n")
+{
+	bm->io_nthreads = 1;
+	if (bm->io_nthreads != bgp_io_nthreads
+	    && atomic_load_explicit(&bgp_pth_io_pool[0]->running,
+				    memory_order_relaxed))
+		vty_out(vty,
+			"%% I/O thread count change takes effect on restart\n");
+
+	return CMD_SUCCESS;
+}
+
 
 /* neighbor interface */
 static int peer_interface_vty(struct vty *vty, const char *ip_str,
@@ -7516,7 +7656,6 @@ DEFUN (show_bgp_vrfs,
 	for (ALL_LIST_ELEMENTS_RO(inst, node, bgp)) {
 		const char *name, *type;
 		struct peer *peer;
-		struct listnode *node2, *nnode2;
 		int peers_cfg, peers_estb;
 		json_object *json_vrf = NULL;
 
@@ -7536,7 +7675,7 @@ DEFUN (show_bgp_vrfs,
 			json_vrf = json_object_new_object();
 
 
-		for (ALL_LIST_ELEMENTS(bgp->peer, node2, nnode2, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 			if (!CHECK_FLAG(peer->flags, PEER_FLAG_CONFIG_NODE))
 				continue;
 			peers_cfg++;
@@ -7600,6 +7739,131 @@ DEFUN (show_bgp_vrfs,
 	return CMD_SUCCESS;
 }
 
+/* Compact per-peer counters for external scrapers.  Everything shown
+ * here is either an atomic peer counter or a lock-free fifo depth, so
+ * sampling it is cheap even at high peer counts - unlike the full
+ * "show bgp neighbors" output.
+ */
+DEFUN (show_bgp_statistics_all,
+       show_bgp_statistics_all_cmd,
+       "show [ip] bgp statistics-all [json]",
+       SHOW_STR
+       IP_STR
+       BGP_STR
+       "Per-peer message and queue counters for all instances\n"
+       JSON_STR)
+{
+	struct listnode *node;
+	struct bgp *bgp;
+	struct peer *peer;
+	bool uj = use_json(argc, argv);
+	json_object *json = NULL;
+	json_object *json_vrfs = NULL;
+	afi_t afi;
+	safi_t safi;
+
+	if (uj) {
+		json = json_object_new_object();
+		json_vrfs = json_object_new_object();
+	}
+
+	for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp)) {
+		const char *name = (bgp->inst_type == BGP_INSTANCE_TYPE_DEFAULT)
+					   ? VRF_DEFAULT_NAME
+					   : bgp->name;
+		json_object *json_vrf = NULL;
+		json_object *json_peers = NULL;
+
+		if (uj) {
+			json_vrf = json_object_new_object();
+			json_peers = json_object_new_object();
+			json_object_int_add(
+				json_vrf, "bestpathRuns",
+				atomic_load_explicit(&bgp->bestpath_runs,
+						     memory_order_relaxed));
+		} else {
+			vty_out(vty, "Instance %s (bestpath runs %u):\n", name,
+				atomic_load_explicit(&bgp->bestpath_runs,
+						     memory_order_relaxed));
+			vty_out(vty, "%-24s %8s %8s %8s %8s %10s %10s %6s %6s\n",
+				"Neighbor", "MsgRcvd", "MsgSent", "UpdRcvd",
+				"UpdSent", "PfxRcvd", "PfxSent", "InQ",
+				"OutQ");
+		}
+
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
+			unsigned long pfx_rcvd = 0, pfx_sent = 0;
+			json_object *json_peer = NULL;
+
+			if (!CHECK_FLAG(peer->flags, PEER_FLAG_CONFIG_NODE))
+				continue;
+
+			FOREACH_AFI_SAFI (afi, safi) {
+				pfx_rcvd += peer->pcount[afi][safi];
+				pfx_sent += peer->scount[afi][safi];
+			}
+
+			if (uj) {
+				json_peer = json_object_new_object();
+				json_object_int_add(json_peer, "msgsRcvd",
+						    PEER_TOTAL_RX(peer));
+				json_object_int_add(json_peer, "msgsSent",
+						    PEER_TOTAL_TX(peer));
+				json_object_int_add(
+					json_peer, "updatesRcvd",
+					atomic_load_explicit(
+						&peer->update_in,
+						memory_order_relaxed));
+				json_object_int_add(
+					json_peer, "updatesSent",
+					atomic_load_explicit(
+						&peer->update_out,
+						memory_order_relaxed));
+				json_object_int_add(json_peer, "prefixesRcvd",
+						    pfx_rcvd);
+				json_object_int_add(json_peer, "prefixesSent",
+						    pfx_sent);
+				json_object_int_add(
+					json_peer, "inputQueueDepth",
+					stream_fifo_count_safe(peer->ibuf));
+				json_object_int_add(
+					json_peer, "outputQueueDepth",
+					stream_fifo_count_safe(peer->obuf));
+				json_object_object_add(json_peers, peer->host,
+						       json_peer);
+			} else
+				vty_out(vty,
+					"%-24s %8u %8u %8u %8u %10lu %10lu %6zu %6zu\n",
+					peer->host, PEER_TOTAL_RX(peer),
+					PEER_TOTAL_TX(peer),
+					atomic_load_explicit(
+						&peer->update_in,
+						memory_order_relaxed),
+					atomic_load_explicit(
+						&peer->update_out,
+						memory_order_relaxed),
+					pfx_rcvd, pfx_sent,
+					stream_fifo_count_safe(peer->ibuf),
+					stream_fifo_count_safe(peer->obuf));
+		}
+
+		if (uj) {
+			json_object_object_add(json_vrf, "peers", json_peers);
+			json_object_object_add(json_vrfs, name, json_vrf);
+		} else
+			vty_out(vty, "\n");
+	}
+
+	if (uj) {
+		json_object_object_add(json, "vrfs", json_vrfs);
+		vty_out(vty, "%s\n", json_object_to_json_string_ext(
+					     json, JSON_C_TO_STRING_PRETTY));
+		json_object_free(json);
+	}
+
+	return CMD_SUCCESS;
+}
+
 DEFUN (show_bgp_mac_hash,
        show_bgp_mac_hash_cmd,
        "show bgp mac hash",
@@ -7720,10 +7984,10 @@ DEFUN (show_bgp_memory,
 				     count * sizeof(struct bgp_nexthop_cache)));
 
 	if ((count = mtype_stats_alloc(MTYPE_BGP_DAMP_INFO)))
-		vty_out(vty, "%ld Dampening entries, using %s of memory\n",
-			count,
+		vty_out(vty, "%ld Dampening slabs, using %s of memory\n", count,
 			mtype_memstr(memstrbuf, sizeof(memstrbuf),
-				     count * sizeof(struct bgp_damp_info)));
+				     count * BGP_DAMP_POOL_CHUNK
+					     * sizeof(struct bgp_damp_info)));
 
 	/* Attributes */
 	count = attr_count();
@@ -7833,7 +8097,6 @@ static int bgp_show_summary(struct vty *vty, struct bgp *bgp, int afi, int safi,
 			    bool use_json, json_object *json)
 {
 	struct peer *peer;
-	struct listnode *node, *nnode;
 	unsigned int count = 0, dn_count = 0;
 	char timebuf[BGP_UPTIME_LEN], dn_flag[2];
 	char neighbor_buf[VTY_BUFSIZ];
@@ -7864,7 +8127,7 @@ static int bgp_show_summary(struct vty *vty, struct bgp *bgp, int afi, int safi,
 		 * how many
 		 * characters are needed for the Neighbor column
 		 */
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 			if (!CHECK_FLAG(peer->flags, PEER_FLAG_CONFIG_NODE))
 				continue;
 
@@ -7897,7 +8160,7 @@ static int bgp_show_summary(struct vty *vty, struct bgp *bgp, int afi, int safi,
 			max_neighbor_width = neighbor_col_default_width;
 	}
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (!CHECK_FLAG(peer->flags, PEER_FLAG_CONFIG_NODE))
 			continue;
 
@@ -8031,7 +8294,7 @@ static int bgp_show_summary(struct vty *vty, struct bgp *bgp, int afi, int safi,
 					json, "ribMemory",
 					ents * sizeof(struct bgp_node));
 
-				ents = listcount(bgp->peer);
+				ents = bgp_peers_count(&bgp->peer);
 				json_object_int_add(json, "peerCount", ents);
 				json_object_int_add(json, "peerMemory",
 						    ents * sizeof(struct peer));
@@ -8071,7 +8334,7 @@ static int bgp_show_summary(struct vty *vty, struct bgp *bgp, int afi, int safi,
 								   bgp_node)));
 
 				/* Peer related usage */
-				ents = listcount(bgp->peer);
+				ents = bgp_peers_count(&bgp->peer);
 				vty_out(vty, "Peers %ld, using %s of memory\n",
 					ents,
 					mtype_memstr(
@@ -10864,18 +11127,16 @@ static void bgp_show_peer(struct vty *vty, struct peer *p, bool use_json,
 			json_object_int_add(
 				json_neigh, "nextStartTimerDueInMsecs",
 				thread_timer_remain_second(p->t_start) * 1000);
-		if (p->t_connect)
+		if (p->ft_connect.due)
 			json_object_int_add(
 				json_neigh, "nextConnectTimerDueInMsecs",
-				thread_timer_remain_second(p->t_connect)
-					* 1000);
-		if (p->t_routeadv) {
+				bgp_fsm_timer_remain(&p->ft_connect) * 1000);
+		if (p->ft_routeadv.due) {
 			json_object_int_add(json_neigh, "mraiInterval",
 					    p->v_routeadv);
 			json_object_int_add(
 				json_neigh, "mraiTimerExpireInMsecs",
-				thread_timer_remain_second(p->t_routeadv)
-					* 1000);
+				bgp_fsm_timer_remain(&p->ft_routeadv) * 1000);
 		}
 		if (p->password)
 			json_object_int_add(json_neigh, "authenticationEnabled",
@@ -10900,14 +11161,14 @@ static void bgp_show_peer(struct vty *vty, struct peer *p, bool use_json,
 		if (p->t_start)
 			vty_out(vty, "Next start timer due in %ld seconds\n",
 				thread_timer_remain_second(p->t_start));
-		if (p->t_connect)
+		if (p->ft_connect.due)
 			vty_out(vty, "Next connect timer due in %ld seconds\n",
-				thread_timer_remain_second(p->t_connect));
-		if (p->t_routeadv)
+				bgp_fsm_timer_remain(&p->ft_connect));
+		if (p->ft_routeadv.due)
 			vty_out(vty,
 				"MRAI (interval %u) timer expires in %ld seconds\n",
 				p->v_routeadv,
-				thread_timer_remain_second(p->t_routeadv));
+				bgp_fsm_timer_remain(&p->ft_routeadv));
 		if (p->password)
 			vty_out(vty, "Peer Authentication Enabled\n");
 
@@ -10941,12 +11202,11 @@ static int bgp_show_neighbor(struct vty *vty, struct bgp *bgp,
 			     const char *conf_if, bool use_json,
 			     json_object *json)
 {
-	struct listnode *node, *nnode;
 	struct peer *peer;
 	int find = 0;
 	bool nbr_output = false;
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (!CHECK_FLAG(peer->flags, PEER_FLAG_CONFIG_NODE))
 			continue;
 
@@ -12682,10 +12942,10 @@ static void bgp_ac_neighbor(vector comps, struct cmd_token *token)
 {
 	struct bgp *bgp;
 	struct peer *peer;
-	struct listnode *lnbgp, *lnpeer;
+	struct listnode *lnbgp;
 
 	for (ALL_LIST_ELEMENTS_RO(bm->bgp, lnbgp, bgp)) {
-		for (ALL_LIST_ELEMENTS_RO(bgp->peer, lnpeer, peer)) {
+		frr_each (bgp_peers, &bgp->peer, peer) {
 			/* only provide suggestions on the appropriate input
 			 * token type,
 			 * they'll otherwise show up multiple times */
@@ -12782,6 +13042,14 @@ void bgp_vty_init(void)
 	install_element(CONFIG_NODE, &bgp_set_route_map_delay_timer_cmd);
 	install_element(CONFIG_NODE, &no_bgp_set_route_map_delay_timer_cmd);
 
+	/* bgp bestpath-workers commands. */
+	install_element(CONFIG_NODE, &bgp_bestpath_workers_cmd);
+	install_element(CONFIG_NODE, &no_bgp_bestpath_workers_cmd);
+
+	/* bgp io-threads commands. */
+	install_element(CONFIG_NODE, &bgp_io_threads_cmd);
+	install_element(CONFIG_NODE, &no_bgp_io_threads_cmd);
+
 	/* Dummy commands (Currently not supported) */
 	install_element(BGP_NODE, &no_synchronization_cmd);
 	install_element(BGP_NODE, &no_auto_summary_cmd);
@@ -12828,10 +13096,15 @@ void bgp_vty_init(void)
 	install_element(BGP_NODE, &no_bgp_wpkt_quanta_cmd);
 	install_element(BGP_NODE, &bgp_rpkt_quanta_cmd);
 	install_element(BGP_NODE, &no_bgp_rpkt_quanta_cmd);
+	install_element(BGP_NODE, &bgp_read_rate_limit_cmd);
+	install_element(BGP_NODE, &no_bgp_read_rate_limit_cmd);
 
 	install_element(BGP_NODE, &bgp_coalesce_time_cmd);
 	install_element(BGP_NODE, &no_bgp_coalesce_time_cmd);
 
+	install_element(BGP_NODE, &bgp_nht_eval_delay_cmd);
+	install_element(BGP_NODE, &no_bgp_nht_eval_delay_cmd);
+
 	/* "maximum-paths" commands. */
 	install_element(BGP_NODE, &bgp_maxpaths_hidden_cmd);
 	install_element(BGP_NODE, &no_bgp_maxpaths_hidden_cmd);
@@ -13917,6 +14190,7 @@ void bgp_vty_init(void)
 
 	/* "show [ip] bgp vrfs" commands. */
 	install_element(VIEW_NODE, &show_bgp_vrfs_cmd);
+	install_element(VIEW_NODE, &show_bgp_statistics_all_cmd);
 
 	/* Community-list. */
 	community_list_vty();
@@ -122,10 +122,9 @@ static int bgp_read_import_check_update(int command, struct zclient *zclient,
 static void bgp_update_interface_nbrs(struct bgp *bgp, struct interface *ifp,
 				      struct interface *upd_ifp)
 {
-	struct listnode *node, *nnode;
 	struct peer *peer;
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (peer->conf_if && (strcmp(peer->conf_if, ifp->name) == 0)) {
 			if (upd_ifp) {
 				peer->ifp = upd_ifp;
@@ -147,10 +146,9 @@ static int bgp_read_fec_update(int command, struct zclient *zclient,
 
 static void bgp_start_interface_nbrs(struct bgp *bgp, struct interface *ifp)
 {
-	struct listnode *node, *nnode;
 	struct peer *peer;
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (peer->conf_if && (strcmp(peer->conf_if, ifp->name) == 0)
 		    && peer->status != Established) {
 			if (peer_active(peer))
@@ -186,11 +184,10 @@ static void bgp_nbr_connected_add(struct bgp *bgp, struct nbr_connected *ifc)
 static void bgp_nbr_connected_delete(struct bgp *bgp, struct nbr_connected *ifc,
 				     int del)
 {
-	struct listnode *node, *nnode;
 	struct peer *peer;
 	struct interface *ifp;
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (peer->conf_if
 		    && (strcmp(peer->conf_if, ifc->ifp->name) == 0)) {
 			peer->last_reset = PEER_DOWN_NBR_ADDR_DEL;
@@ -325,7 +322,7 @@ static int bgp_interface_down(int command, struct zclient *zclient,
 	/* Fast external-failover */
 	if (!CHECK_FLAG(bgp->flags, BGP_FLAG_NO_FAST_EXT_FAILOVER)) {
 
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 #if defined(HAVE_CUMULUS)
 			/* Take down directly connected EBGP peers as well as
 			 * 1-hop BFD
@@ -507,7 +504,7 @@ static int bgp_interface_vrf_update(int command, struct zclient *zclient,
 
 		/* Fast external-failover */
 		if (!CHECK_FLAG(bgp->flags, BGP_FLAG_NO_FAST_EXT_FAILOVER)) {
-			for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+			frr_each_safe (bgp_peers, &bgp->peer, peer) {
 				if ((peer->ttl != 1) && (peer->gtsm_hops != 1))
 					continue;
 
@@ -2576,49 +2573,62 @@ static int bgp_zebra_process_local_macip(int command, struct zclient *zclient,
 	uint8_t flags = 0;
 	uint32_t seqnum = 0;
 	int state = 0;
-
-	memset(&ip, 0, sizeof(ip));
-	s = zclient->ibuf;
-	vni = stream_getl(s);
-	stream_get(&mac.octet, s, ETH_ALEN);
-	ipa_len = stream_getl(s);
-	if (ipa_len != 0 && ipa_len != IPV4_MAX_BYTELEN
-	    && ipa_len != IPV6_MAX_BYTELEN) {
-		flog_err(EC_BGP_MACIP_LEN,
-			 "%u:Recv MACIP %s with invalid IP addr length %d",
-			 vrf_id, (command == ZEBRA_MACIP_ADD) ? "Add" : "Del",
-			 ipa_len);
-		return -1;
-	}
-
-	if (ipa_len) {
-		ip.ipa_type =
-			(ipa_len == IPV4_MAX_BYTELEN) ? IPADDR_V4 : IPADDR_V6;
-		stream_get(&ip.ip.addr, s, ipa_len);
-	}
-	if (command == ZEBRA_MACIP_ADD) {
-		flags = stream_getc(s);
-		seqnum = stream_getl(s);
-	} else {
-		state = stream_getl(s);
-	}
+	size_t l = 0;
 
 	bgp = bgp_lookup_by_vrf_id(vrf_id);
 	if (!bgp)
 		return 0;
 
-	if (BGP_DEBUG(zebra, ZEBRA))
-		zlog_debug("%u:Recv MACIP %s flags 0x%x MAC %s IP %s VNI %u seq %u state %d",
-			   vrf_id, (command == ZEBRA_MACIP_ADD) ? "Add" : "Del",
-			   flags, prefix_mac2str(&mac, buf, sizeof(buf)),
-			   ipaddr2str(&ip, buf1, sizeof(buf1)), vni, seqnum,
-			   state);
-
-	if (command == ZEBRA_MACIP_ADD)
-		return bgp_evpn_local_macip_add(bgp, vni, &mac, &ip,
-						flags, seqnum);
-	else
-		return bgp_evpn_local_macip_del(bgp, vni, &mac, &ip, state);
+	s = zclient->ibuf;
+
+	/* The message may carry multiple batched MACIP records. */
+	while (l < length) {
+		memset(&ip, 0, sizeof(ip));
+		vni = stream_getl(s);
+		stream_get(&mac.octet, s, ETH_ALEN);
+		ipa_len = stream_getl(s);
+		if (ipa_len != 0 && ipa_len != IPV4_MAX_BYTELEN
+		    && ipa_len != IPV6_MAX_BYTELEN) {
+			flog_err(EC_BGP_MACIP_LEN,
+				 "%u:Recv MACIP %s with invalid IP addr length %d",
+				 vrf_id,
+				 (command == ZEBRA_MACIP_ADD) ? "Add" : "Del",
+				 ipa_len);
+			return -1;
+		}
+		l += 4 + ETH_ALEN + 4;
+
+		if (ipa_len) {
+			ip.ipa_type = (ipa_len == IPV4_MAX_BYTELEN) ? IPADDR_V4
+								    : IPADDR_V6;
+			stream_get(&ip.ip.addr, s, ipa_len);
+			l += ipa_len;
+		}
+		if (command == ZEBRA_MACIP_ADD) {
+			flags = stream_getc(s);
+			seqnum = stream_getl(s);
+			l += 1 + 4;
+		} else {
+			state = stream_getl(s);
+			l += 4;
+		}
+
+		if (BGP_DEBUG(zebra, ZEBRA))
+			zlog_debug("%u:Recv MACIP %s flags 0x%x MAC %s IP %s VNI %u seq %u state %d",
+				   vrf_id,
+				   (command == ZEBRA_MACIP_ADD) ? "Add" : "Del",
+				   flags, prefix_mac2str(&mac, buf, sizeof(buf)),
+				   ipaddr2str(&ip, buf1, sizeof(buf1)), vni,
+				   seqnum, state);
+
+		if (command == ZEBRA_MACIP_ADD)
+			bgp_evpn_local_macip_add(bgp, vni, &mac, &ip, flags,
+						 seqnum);
+		else
+			bgp_evpn_local_macip_del(bgp, vni, &mac, &ip, state);
+	}
+
+	return 0;
 }
 
 static void bgp_zebra_process_local_ip_prefix(int cmd, struct zclient *zclient,
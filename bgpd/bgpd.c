@@ -45,12 +45,15 @@
 #include "lib/json.h"
 #include "frr_pthread.h"
 #include "bitfield.h"
+#include "libfrr.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_table.h"
 #include "bgpd/bgp_aspath.h"
 #include "bgpd/bgp_route.h"
 #include "bgpd/bgp_dump.h"
+#include "bgpd/bgp_replay.h"
+#include "bgpd/bgp_statesync.h"
 #include "bgpd/bgp_debug.h"
 #include "bgpd/bgp_errors.h"
 #include "bgpd/bgp_community.h"
@@ -81,6 +84,7 @@
 #include "bgpd/bgp_evpn_vty.h"
 #include "bgpd/bgp_keepalives.h"
 #include "bgpd/bgp_io.h"
+#include "bgpd/bgp_bestpath.h"
 #include "bgpd/bgp_ecommunity.h"
 #include "bgpd/bgp_flowspec.h"
 #include "bgpd/bgp_labelpool.h"
@@ -141,25 +145,17 @@ void bgp_session_reset(struct peer *peer)
 }
 
 /*
- * During session reset, we may delete the doppelganger peer, which would
- * be the next node to the current node. If the session reset was invoked
- * during walk of peer list, we would end up accessing the freed next
- * node. This function moves the next node along.
+ * During session reset, we may delete the doppelganger peer, which may
+ * be the caller's saved next peer in a walk of the peer list. This
+ * function moves the saved next peer along before it is freed.
  */
-static void bgp_session_reset_safe(struct peer *peer, struct listnode **nnode)
+static void bgp_session_reset_safe(struct peer *peer, struct peer **npeer)
 {
-	struct listnode *n;
-	struct peer *npeer;
-
-	n = (nnode) ? *nnode : NULL;
-	npeer = (n) ? listgetdata(n) : NULL;
-
 	if (peer->doppelganger && (peer->doppelganger->status != Deleted)
 	    && !(CHECK_FLAG(peer->doppelganger->flags,
 			    PEER_FLAG_CONFIG_NODE))) {
-		if (peer->doppelganger == npeer)
-			/* nnode and *nnode are confirmed to be non-NULL here */
-			*nnode = (*nnode)->next;
+		if (npeer && peer->doppelganger == *npeer)
+			*npeer = bgp_peers_next_safe(&peer->bgp->peer, *npeer);
 		peer_delete(peer->doppelganger);
 	}
 
@@ -244,7 +240,6 @@ static int bgp_config_check(struct bgp *bgp, int config)
 static int bgp_router_id_set(struct bgp *bgp, const struct in_addr *id)
 {
 	struct peer *peer;
-	struct listnode *node, *nnode;
 
 	if (IPV4_ADDR_SAME(&bgp->router_id, id))
 		return 0;
@@ -256,7 +251,7 @@ static int bgp_router_id_set(struct bgp *bgp, const struct in_addr *id)
 	IPV4_ADDR_COPY(&bgp->router_id, id);
 
 	/* Set all peer's local identifier with this value. */
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		IPV4_ADDR_COPY(&peer->local_id, id);
 
 		if (BGP_IS_VALID_STATE_FOR_NOTIF(peer->status)) {
@@ -341,7 +336,6 @@ int bgp_router_id_static_set(struct bgp *bgp, struct in_addr id)
 int bgp_cluster_id_set(struct bgp *bgp, struct in_addr *cluster_id)
 {
 	struct peer *peer;
-	struct listnode *node, *nnode;
 
 	if (bgp_config_check(bgp, BGP_CONFIG_CLUSTER_ID)
 	    && IPV4_ADDR_SAME(&bgp->cluster_id, cluster_id))
@@ -351,7 +345,7 @@ int bgp_cluster_id_set(struct bgp *bgp, struct in_addr *cluster_id)
 	bgp_config_set(bgp, BGP_CONFIG_CLUSTER_ID);
 
 	/* Clear all IBGP peer. */
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (peer->sort != BGP_PEER_IBGP)
 			continue;
 
@@ -367,7 +361,6 @@ int bgp_cluster_id_set(struct bgp *bgp, struct in_addr *cluster_id)
 int bgp_cluster_id_unset(struct bgp *bgp)
 {
 	struct peer *peer;
-	struct listnode *node, *nnode;
 
 	if (!bgp_config_check(bgp, BGP_CONFIG_CLUSTER_ID))
 		return 0;
@@ -376,7 +369,7 @@ int bgp_cluster_id_unset(struct bgp *bgp)
 	bgp_config_unset(bgp, BGP_CONFIG_CLUSTER_ID);
 
 	/* Clear all IBGP peer. */
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (peer->sort != BGP_PEER_IBGP)
 			continue;
 
@@ -421,8 +414,7 @@ int bgp_timers_unset(struct bgp *bgp)
 /* BGP confederation configuration.  */
 int bgp_confederation_id_set(struct bgp *bgp, as_t as)
 {
-	struct peer *peer;
-	struct listnode *node, *nnode;
+	struct peer *peer, *npeer;
 	int already_confed;
 
 	if (as == 0)
@@ -436,7 +428,8 @@ int bgp_confederation_id_set(struct bgp *bgp, as_t as)
 	/* If we were doing confederation already, this is just an external
 	   AS change.  Just Reset EBGP sessions, not CONFED sessions.  If we
 	   were not doing confederation before, reset all EBGP sessions.  */
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	for (peer = bgp_peers_first(&bgp->peer); peer; peer = npeer) {
+		npeer = bgp_peers_next_safe(&bgp->peer, peer);
 		/* We're looking for peers who's AS is not local or part of our
 		   confederation.  */
 		if (already_confed) {
@@ -450,7 +443,7 @@ int bgp_confederation_id_set(struct bgp *bgp, as_t as)
 						peer, BGP_NOTIFY_CEASE,
 						BGP_NOTIFY_CEASE_CONFIG_CHANGE);
 				} else
-					bgp_session_reset_safe(peer, &nnode);
+					bgp_session_reset_safe(peer, &npeer);
 			}
 		} else {
 			/* Not doign confederation before, so reset every
@@ -468,7 +461,7 @@ int bgp_confederation_id_set(struct bgp *bgp, as_t as)
 						peer, BGP_NOTIFY_CEASE,
 						BGP_NOTIFY_CEASE_CONFIG_CHANGE);
 				} else
-					bgp_session_reset_safe(peer, &nnode);
+					bgp_session_reset_safe(peer, &npeer);
 			}
 		}
 	}
@@ -477,13 +470,13 @@ int bgp_confederation_id_set(struct bgp *bgp, as_t as)
 
 int bgp_confederation_id_unset(struct bgp *bgp)
 {
-	struct peer *peer;
-	struct listnode *node, *nnode;
+	struct peer *peer, *npeer;
 
 	bgp->confed_id = 0;
 	bgp_config_unset(bgp, BGP_CONFIG_CONFEDERATION);
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	for (peer = bgp_peers_first(&bgp->peer); peer; peer = npeer) {
+		npeer = bgp_peers_next_safe(&bgp->peer, peer);
 		/* We're looking for peers who's AS is not local */
 		if (peer_sort(peer) != BGP_PEER_IBGP) {
 			peer->local_as = bgp->as;
@@ -494,7 +487,7 @@ int bgp_confederation_id_unset(struct bgp *bgp)
 			}
 
 			else
-				bgp_session_reset_safe(peer, &nnode);
+				bgp_session_reset_safe(peer, &npeer);
 		}
 	}
 	return 0;
@@ -518,8 +511,7 @@ int bgp_confederation_peers_check(struct bgp *bgp, as_t as)
 /* Add an AS to the confederation set.  */
 int bgp_confederation_peers_add(struct bgp *bgp, as_t as)
 {
-	struct peer *peer;
-	struct listnode *node, *nnode;
+	struct peer *peer, *npeer;
 
 	if (!bgp)
 		return BGP_ERR_INVALID_BGP;
@@ -543,7 +535,9 @@ int bgp_confederation_peers_add(struct bgp *bgp, as_t as)
 	bgp->confed_peers_cnt++;
 
 	if (bgp_config_check(bgp, BGP_CONFIG_CONFEDERATION)) {
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		for (peer = bgp_peers_first(&bgp->peer); peer;
+		     peer = npeer) {
+			npeer = bgp_peers_next_safe(&bgp->peer, peer);
 			if (peer->as == as) {
 				peer->local_as = bgp->as;
 				if (BGP_IS_VALID_STATE_FOR_NOTIF(
@@ -554,7 +548,7 @@ int bgp_confederation_peers_add(struct bgp *bgp, as_t as)
 						peer, BGP_NOTIFY_CEASE,
 						BGP_NOTIFY_CEASE_CONFIG_CHANGE);
 				} else
-					bgp_session_reset_safe(peer, &nnode);
+					bgp_session_reset_safe(peer, &npeer);
 			}
 		}
 	}
@@ -566,8 +560,7 @@ int bgp_confederation_peers_remove(struct bgp *bgp, as_t as)
 {
 	int i;
 	int j;
-	struct peer *peer;
-	struct listnode *node, *nnode;
+	struct peer *peer, *npeer;
 
 	if (!bgp)
 		return -1;
@@ -594,7 +587,9 @@ int bgp_confederation_peers_remove(struct bgp *bgp, as_t as)
 	/* Now reset any peer who's remote AS has just been removed from the
 	   CONFED */
 	if (bgp_config_check(bgp, BGP_CONFIG_CONFEDERATION)) {
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		for (peer = bgp_peers_first(&bgp->peer); peer;
+		     peer = npeer) {
+			npeer = bgp_peers_next_safe(&bgp->peer, peer);
 			if (peer->as == as) {
 				peer->local_as = bgp->confed_id;
 				if (BGP_IS_VALID_STATE_FOR_NOTIF(
@@ -605,7 +600,7 @@ int bgp_confederation_peers_remove(struct bgp *bgp, as_t as)
 						peer, BGP_NOTIFY_CEASE,
 						BGP_NOTIFY_CEASE_CONFIG_CHANGE);
 				} else
-					bgp_session_reset_safe(peer, &nnode);
+					bgp_session_reset_safe(peer, &npeer);
 			}
 		}
 	}
@@ -1558,13 +1553,13 @@ struct peer *peer_create(union sockunion *su, const char *conf_if,
 
 	peer = peer_lock(peer); /* bgp peer list reference */
 	peer->group = group;
-	listnode_add_sort(bgp->peer, peer);
+	bgp_peers_add(&bgp->peer, peer);
 	hash_get(bgp->peerhash, peer, hash_alloc_intern);
 
 	/* Adjust update-group coalesce timer heuristics for # peers. */
 	if (bgp->heuristic_coalesce) {
 		long ct = BGP_DEFAULT_SUBGROUP_COALESCE_TIME
-			  + (bgp->peer->count
+			  + (bgp_peers_count(&bgp->peer)
 			     * BGP_PEER_ADJUST_SUBGROUP_COALESCE_TIME);
 		bgp->coalesce_time = MIN(BGP_MAX_SUBGROUP_COALESCE_TIME, ct);
 	}
@@ -1602,7 +1597,7 @@ struct peer *peer_create_accept(struct bgp *bgp)
 	peer = peer_new(bgp);
 
 	peer = peer_lock(peer); /* bgp peer list reference */
-	listnode_add_sort(bgp->peer, peer);
+	bgp_peers_add(&bgp->peer, peer);
 
 	return peer;
 }
@@ -1612,10 +1607,9 @@ struct peer *peer_create_accept(struct bgp *bgp)
  */
 int bgp_afi_safi_peer_exists(struct bgp *bgp, afi_t afi, safi_t safi)
 {
-	struct listnode *node;
 	struct peer *peer;
 
-	for (ALL_LIST_ELEMENTS_RO(bgp->peer, node, peer)) {
+	frr_each (bgp_peers, &bgp->peer, peer) {
 		if (!CHECK_FLAG(peer->flags, PEER_FLAG_CONFIG_NODE))
 			continue;
 
@@ -1957,7 +1951,7 @@ static int peer_activate_af(struct peer *peer, afi_t afi, safi_t safi)
 						    CAPABILITY_ACTION_SET);
 				if (peer->afc_recv[afi][safi]) {
 					peer->afc_nego[afi][safi] = 1;
-					bgp_announce_route(peer, afi, safi);
+					bgp_announce_route(peer, afi, safi, false);
 				}
 			} else {
 				peer->last_reset = PEER_DOWN_AF_ACTIVATE;
@@ -2219,6 +2213,10 @@ int peer_delete(struct peer *peer)
 
 	SET_FLAG(peer->flags, PEER_FLAG_DELETE);
 
+	/* The inbound policy cache keys on peer pointers, which may be
+	 * recycled once this peer is freed. */
+	bgp_rmap_in_cache_flush();
+
 	/* If this peer belongs to peer group, clear up the
 	   relationship.  */
 	if (peer->group) {
@@ -2266,9 +2264,8 @@ int peer_delete(struct peer *peer)
 
 	/* Delete from all peer list. */
 	if (!CHECK_FLAG(peer->sflags, PEER_STATUS_GROUP)
-	    && (pn = listnode_lookup(bgp->peer, peer))) {
+	    && bgp_peers_del(&bgp->peer, peer)) {
 		peer_unlock(peer); /* bgp peer list reference */
-		list_delete_node(bgp->peer, pn);
 		hash_release(bgp->peerhash, peer);
 	}
 
@@ -2744,10 +2741,10 @@ int peer_group_bind(struct bgp *bgp, union sockunion *su, struct peer *peer,
 		if (peer->group) {
 			assert(group && peer->group == group);
 		} else {
-			listnode_delete(bgp->peer, peer);
+			bgp_peers_del(&bgp->peer, peer);
 
 			peer->group = group;
-			listnode_add_sort(bgp->peer, peer);
+			bgp_peers_add(&bgp->peer, peer);
 
 			peer = peer_lock(peer); /* group->peer list reference */
 			listnode_add(group->peer, peer);
@@ -2896,8 +2893,7 @@ static struct bgp *bgp_create(as_t *as, const char *name,
 	if (cmd_domainname_get())
 		bgp->peer_self->domainname =
 			XSTRDUP(MTYPE_BGP_PEER_HOST, cmd_domainname_get());
-	bgp->peer = list_new();
-	bgp->peer->cmp = (int (*)(void *, void *))peer_cmp;
+	bgp_peers_init(&bgp->peer);
 	bgp->peerhash = hash_create(peer_hash_key_make, peer_hash_same,
 				    "BGP Peer Hash");
 	bgp->peerhash->max_size = BGP_PEER_MAX_HASH_SIZE;
@@ -3198,13 +3194,12 @@ int bgp_get(struct bgp **bgp_val, as_t *as, const char *name,
 void bgp_instance_up(struct bgp *bgp)
 {
 	struct peer *peer;
-	struct listnode *node, *next;
 
 	/* Register with zebra. */
 	bgp_zebra_instance_register(bgp);
 
 	/* Kick off any peers that may have been configured. */
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, next, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (!BGP_PEER_START_SUPPRESSED(peer))
 			BGP_EVENT_ADD(peer, BGP_Start);
 	}
@@ -3220,8 +3215,6 @@ void bgp_instance_up(struct bgp *bgp)
 void bgp_instance_down(struct bgp *bgp)
 {
 	struct peer *peer;
-	struct listnode *node;
-	struct listnode *next;
 
 	/* Stop timers. */
 	if (bgp->t_rmap_def_originate_eval) {
@@ -3229,9 +3222,10 @@ void bgp_instance_down(struct bgp *bgp)
 		bgp_unlock(bgp); /* TODO - This timer is started with a lock -
 				    why? */
 	}
+	BGP_TIMER_OFF(bgp->t_nht_eval);
 
 	/* Bring down peers, so corresponding routes are purged. */
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, next, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (BGP_IS_VALID_STATE_FOR_NOTIF(peer->status))
 			bgp_notify_send(peer, BGP_NOTIFY_CEASE,
 					BGP_NOTIFY_CEASE_ADMIN_SHUTDOWN);
@@ -3261,6 +3255,7 @@ int bgp_delete(struct bgp *bgp)
 	THREAD_OFF(bgp->t_maxmed_onstartup);
 	THREAD_OFF(bgp->t_update_delay);
 	THREAD_OFF(bgp->t_establish_wait);
+	THREAD_OFF(bgp->t_rib_cache_stale);
 
 	if (BGP_DEBUG(zebra, ZEBRA)) {
 		if (bgp->inst_type == BGP_INSTANCE_TYPE_DEFAULT)
@@ -3286,9 +3281,10 @@ int bgp_delete(struct bgp *bgp)
 		bgp_unlock(bgp); /* TODO - This timer is started with a lock -
 				    why? */
 	}
+	BGP_TIMER_OFF(bgp->t_nht_eval);
 
 	/* Inform peers we're going down. */
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, next, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		if (BGP_IS_VALID_STATE_FOR_NOTIF(peer->status))
 			bgp_notify_send(peer, BGP_NOTIFY_CEASE,
 					BGP_NOTIFY_CEASE_ADMIN_SHUTDOWN);
@@ -3307,7 +3303,7 @@ int bgp_delete(struct bgp *bgp)
 	for (ALL_LIST_ELEMENTS(bgp->group, node, next, group))
 		peer_group_delete(group);
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, next, peer))
+	frr_each_safe (bgp_peers, &bgp->peer, peer)
 		peer_delete(peer);
 
 	if (bgp->peer_self) {
@@ -3371,7 +3367,7 @@ void bgp_free(struct bgp *bgp)
 	QOBJ_UNREG(bgp);
 
 	list_delete(&bgp->group);
-	list_delete(&bgp->peer);
+	bgp_peers_fini(&bgp->peer);
 
 	if (bgp->peerhash) {
 		hash_free(bgp->peerhash);
@@ -3409,6 +3405,9 @@ void bgp_free(struct bgp *bgp)
 	bgp_pbr_cleanup(bgp);
 	XFREE(MTYPE_BGP_EVPN_INFO, bgp->evpn_info);
 
+	/* Drop this instance from the VPN import RT index */
+	vpn_rt_subscriber_remove(bgp);
+
 	for (afi = AFI_IP; afi < AFI_MAX; afi++) {
 		vpn_policy_direction_t dir;
 
@@ -3434,13 +3433,12 @@ void bgp_free(struct bgp *bgp)
 struct peer *peer_lookup_by_conf_if(struct bgp *bgp, const char *conf_if)
 {
 	struct peer *peer;
-	struct listnode *node, *nnode;
 
 	if (!conf_if)
 		return NULL;
 
 	if (bgp != NULL) {
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer))
+		frr_each_safe (bgp_peers, &bgp->peer, peer)
 			if (peer->conf_if && !strcmp(peer->conf_if, conf_if)
 			    && !CHECK_FLAG(peer->sflags,
 					   PEER_STATUS_ACCEPT_PEER))
@@ -3449,7 +3447,7 @@ struct peer *peer_lookup_by_conf_if(struct bgp *bgp, const char *conf_if)
 		struct listnode *bgpnode, *nbgpnode;
 
 		for (ALL_LIST_ELEMENTS(bm->bgp, bgpnode, nbgpnode, bgp))
-			for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer))
+			frr_each_safe (bgp_peers, &bgp->peer, peer)
 				if (peer->conf_if
 				    && !strcmp(peer->conf_if, conf_if)
 				    && !CHECK_FLAG(peer->sflags,
@@ -3462,13 +3460,12 @@ struct peer *peer_lookup_by_conf_if(struct bgp *bgp, const char *conf_if)
 struct peer *peer_lookup_by_hostname(struct bgp *bgp, const char *hostname)
 {
 	struct peer *peer;
-	struct listnode *node, *nnode;
 
 	if (!hostname)
 		return NULL;
 
 	if (bgp != NULL) {
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer))
+		frr_each_safe (bgp_peers, &bgp->peer, peer)
 			if (peer->hostname && !strcmp(peer->hostname, hostname)
 			    && !CHECK_FLAG(peer->sflags,
 					   PEER_STATUS_ACCEPT_PEER))
@@ -3477,7 +3474,7 @@ struct peer *peer_lookup_by_hostname(struct bgp *bgp, const char *hostname)
 		struct listnode *bgpnode, *nbgpnode;
 
 		for (ALL_LIST_ELEMENTS(bm->bgp, bgpnode, nbgpnode, bgp))
-			for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer))
+			frr_each_safe (bgp_peers, &bgp->peer, peer)
 				if (peer->hostname
 				    && !strcmp(peer->hostname, hostname)
 				    && !CHECK_FLAG(peer->sflags,
@@ -3774,7 +3771,7 @@ void peer_change_action(struct peer *peer, afi_t afi, safi_t safi,
 		}
 	} else if (type == peer_change_reset_out) {
 		update_group_adjust_peer(peer_af_find(peer, afi, safi));
-		bgp_announce_route(peer, afi, safi);
+		bgp_announce_route(peer, afi, safi, false);
 	}
 }
 
@@ -4604,7 +4601,7 @@ int peer_default_originate_set(struct peer *peer, afi_t afi, safi_t safi,
 		if (peer->status == Established && peer->afc_nego[afi][safi]) {
 			update_group_adjust_peer(peer_af_find(peer, afi, safi));
 			bgp_default_originate(peer, afi, safi, 0);
-			bgp_announce_route(peer, afi, safi);
+			bgp_announce_route(peer, afi, safi, false);
 		}
 
 		/* Skip peer-group mechanics for regular peers. */
@@ -4642,7 +4639,7 @@ int peer_default_originate_set(struct peer *peer, afi_t afi, safi_t safi,
 			update_group_adjust_peer(
 				peer_af_find(member, afi, safi));
 			bgp_default_originate(member, afi, safi, 0);
-			bgp_announce_route(member, afi, safi);
+			bgp_announce_route(member, afi, safi, false);
 		}
 	}
 
@@ -4681,7 +4678,7 @@ int peer_default_originate_unset(struct peer *peer, afi_t afi, safi_t safi)
 		if (peer->status == Established && peer->afc_nego[afi][safi]) {
 			update_group_adjust_peer(peer_af_find(peer, afi, safi));
 			bgp_default_originate(peer, afi, safi, 1);
-			bgp_announce_route(peer, afi, safi);
+			bgp_announce_route(peer, afi, safi, false);
 		}
 
 		/* Skip peer-group mechanics for regular peers. */
@@ -4712,7 +4709,7 @@ int peer_default_originate_unset(struct peer *peer, afi_t afi, safi_t safi)
 		if (peer->status == Established && peer->afc_nego[afi][safi]) {
 			update_group_adjust_peer(peer_af_find(peer, afi, safi));
 			bgp_default_originate(peer, afi, safi, 1);
-			bgp_announce_route(peer, afi, safi);
+			bgp_announce_route(peer, afi, safi, false);
 		}
 	}
 
@@ -4742,7 +4739,7 @@ static void peer_on_policy_change(struct peer *peer, afi_t afi, safi_t safi,
 	if (outbound) {
 		update_group_adjust_peer(peer_af_find(peer, afi, safi));
 		if (peer->status == Established)
-			bgp_announce_route(peer, afi, safi);
+			bgp_announce_route(peer, afi, safi, false);
 	} else {
 		if (peer->status != Established)
 			return;
@@ -5663,6 +5660,16 @@ int peer_distribute_unset(struct peer *peer, afi_t afi, safi_t safi, int direct)
 }
 
 /* Update distribute list. */
+/* Filter-update work put off while the startup configuration loads;
+ * each handler below runs its full peer walk once per referenced list
+ * when called per-line, which with tens of thousands of config lines
+ * dominates load time.  One pass at end-of-load covers them all.
+ */
+static unsigned int bgp_config_load_deferred;
+#define BGP_CFG_DEFER_DISTRIBUTE  (1 << 0)
+#define BGP_CFG_DEFER_PREFIX_LIST (1 << 1)
+#define BGP_CFG_DEFER_ASLIST      (1 << 2)
+
 static void peer_distribute_update(struct access_list *access)
 {
 	afi_t afi;
@@ -5675,11 +5682,16 @@ static void peer_distribute_update(struct access_list *access)
 	struct peer_group *group;
 	struct bgp_filter *filter;
 
+	if (frr_config_read_in_progress()) {
+		bgp_config_load_deferred |= BGP_CFG_DEFER_DISTRIBUTE;
+		return;
+	}
+
 	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp)) {
-		if (access->name)
+		if (access && access->name)
 			update_group_policy_update(bgp, BGP_POLICY_FILTER_LIST,
 						   access->name, 0, 0);
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 			FOREACH_AFI_SAFI (afi, safi) {
 				filter = &peer->filter[afi][safi];
 
@@ -5860,6 +5872,11 @@ static void peer_prefix_list_update(struct prefix_list *plist)
 	safi_t safi;
 	int direct;
 
+	if (frr_config_read_in_progress()) {
+		bgp_config_load_deferred |= BGP_CFG_DEFER_PREFIX_LIST;
+		return;
+	}
+
 	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp)) {
 
 		/*
@@ -5869,7 +5886,7 @@ static void peer_prefix_list_update(struct prefix_list *plist)
 			bgp, BGP_POLICY_PREFIX_LIST,
 			plist ? prefix_list_name(plist) : NULL, 0, 0);
 
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 			FOREACH_AFI_SAFI (afi, safi) {
 				filter = &peer->filter[afi][safi];
 
@@ -6042,11 +6059,16 @@ static void peer_aslist_update(const char *aslist_name)
 	struct peer_group *group;
 	struct bgp_filter *filter;
 
+	if (frr_config_read_in_progress()) {
+		bgp_config_load_deferred |= BGP_CFG_DEFER_ASLIST;
+		return;
+	}
+
 	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp)) {
 		update_group_policy_update(bgp, BGP_POLICY_FILTER_LIST,
 					   aslist_name, 0, 0);
 
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 			FOREACH_AFI_SAFI (afi, safi) {
 				filter = &peer->filter[afi][safi];
 
@@ -6096,6 +6118,30 @@ static void peer_aslist_del(const char *aslist_name)
 	route_map_notify_dependencies(aslist_name, RMAP_EVENT_ASLIST_DELETED);
 }
 
+/*
+ * End-of-load pass for everything the filter-update handlers deferred
+ * while the startup configuration was being read.  The handlers refresh
+ * every reference by name lookup regardless of which list changed, so
+ * running each of them once covers all the per-line invocations that
+ * were skipped.  Route-maps keep their own update list; flush it now
+ * instead of waiting out the update timer.
+ */
+static int bgp_config_read_done(struct thread_master *tm)
+{
+	if (bgp_config_load_deferred & BGP_CFG_DEFER_DISTRIBUTE)
+		peer_distribute_update(NULL);
+	if (bgp_config_load_deferred & BGP_CFG_DEFER_PREFIX_LIST)
+		peer_prefix_list_update(NULL);
+	if (bgp_config_load_deferred & BGP_CFG_DEFER_ASLIST)
+		peer_aslist_update(NULL);
+	bgp_config_load_deferred = 0;
+
+	BGP_TIMER_OFF(bm->t_rmap_update);
+	bgp_route_map_update_timer(NULL);
+
+	return 0;
+}
+
 
 int peer_route_map_set(struct peer *peer, afi_t afi, safi_t safi, int direct,
 		       const char *name, struct route_map *route_map)
@@ -6633,7 +6679,7 @@ int peer_ttl_security_hops_unset(struct peer *peer)
  * Pass along additional parameter which can be updated if next node
  * is freed; only required when walking the peer list on BGP instance.
  */
-int peer_clear(struct peer *peer, struct listnode **nnode)
+int peer_clear(struct peer *peer, struct peer **npeer)
 {
 	if (!CHECK_FLAG(peer->flags, PEER_FLAG_SHUTDOWN)) {
 		if (CHECK_FLAG(peer->sflags, PEER_STATUS_PREFIX_OVERFLOW)) {
@@ -6654,7 +6700,7 @@ int peer_clear(struct peer *peer, struct listnode **nnode)
 			bgp_notify_send(peer, BGP_NOTIFY_CEASE,
 					BGP_NOTIFY_CEASE_ADMIN_RESET);
 		else
-			bgp_session_reset_safe(peer, nnode);
+			bgp_session_reset_safe(peer, npeer);
 	}
 	return 0;
 }
@@ -6681,7 +6727,7 @@ int peer_clear_soft(struct peer *peer, afi_t afi, safi_t safi,
 			UNSET_FLAG(paf->subgroup->sflags,
 				   SUBGRP_STATUS_DEFAULT_ORIGINATE);
 
-		bgp_announce_route(peer, afi, safi);
+		bgp_announce_route(peer, afi, safi, true);
 	}
 
 	if (stype == BGP_CLEAR_SOFT_IN_ORF_PREFIX) {
@@ -7428,7 +7474,7 @@ static void bgp_config_write_family(struct vty *vty, struct bgp *bgp, afi_t afi,
 	for (ALL_LIST_ELEMENTS(bgp->group, node, nnode, group))
 		bgp_config_write_peer_af(vty, bgp, group->conf, afi, safi);
 
-	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+	frr_each_safe (bgp_peers, &bgp->peer, peer) {
 		/* Skip dynamic neighbors. */
 		if (peer_dynamic_neighbor(peer))
 			continue;
@@ -7504,6 +7550,13 @@ int bgp_config_write(struct vty *vty)
 		vty_out(vty, "bgp route-map delay-timer %u\n",
 			bm->rmap_update_timer);
 
+	if (bm->bestpath_workers)
+		vty_out(vty, "bgp bestpath-workers %u\n",
+			bm->bestpath_workers);
+
+	if (bm->io_nthreads > 1)
+		vty_out(vty, "bgp io-threads %u\n", bm->io_nthreads);
+
 	if (write)
 		vty_out(vty, "!\n");
 
@@ -7518,7 +7571,7 @@ int bgp_config_write(struct vty *vty)
 		 * config to 'neighbor * enforce-first-as' configs
 		 */
 		if (bgp_flag_check(bgp, BGP_FLAG_ENFORCE_FIRST_AS)) {
-			for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer))
+			frr_each_safe (bgp_peers, &bgp->peer, peer)
 				peer_flag_set(peer, PEER_FLAG_ENFORCE_FIRST_AS);
 			bgp_flag_unset(bgp, BGP_FLAG_ENFORCE_FIRST_AS);
 		}
@@ -7654,10 +7707,17 @@ int bgp_config_write(struct vty *vty)
 		bgp_config_write_wpkt_quanta(vty, bgp);
 		/* read quanta */
 		bgp_config_write_rpkt_quanta(vty, bgp);
+		/* per-peer read rate limit */
+		bgp_config_write_read_rate_limit(vty, bgp);
 
 		/* coalesce time */
 		bgp_config_write_coalesce_time(vty, bgp);
 
+		/* next-hop evaluation dampening window */
+		if (bgp->nht_eval_delay)
+			vty_out(vty, " bgp nexthop-eval-delay %u\n",
+				bgp->nht_eval_delay);
+
 		/* BGP graceful-restart. */
 		if (bgp->stalepath_time != BGP_DEFAULT_STALEPATH_TIME)
 			vty_out(vty,
@@ -7736,7 +7796,7 @@ int bgp_config_write(struct vty *vty)
 		}
 
 		/* Normal neighbor configuration. */
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
+		frr_each_safe (bgp_peers, &bgp->peer, peer) {
 			if (CHECK_FLAG(peer->flags, PEER_FLAG_CONFIG_NODE))
 				bgp_config_write_peer_global(vty, bgp, peer);
 		}
@@ -7821,6 +7881,8 @@ void bgp_master_init(struct thread_master *master)
 	bm->start_time = bgp_clock();
 	bm->t_rmap_update = NULL;
 	bm->rmap_update_timer = RMAP_DEFAULT_UPDATE_TIMER;
+	bm->bestpath_workers = 0;
+	bm->io_nthreads = 1;
 	bm->terminating = false;
 
 	bgp_process_queue_init();
@@ -7887,13 +7949,16 @@ static const struct cmd_variable_handler bgp_viewvrf_var_handlers[] = {
 	{.completions = NULL},
 };
 
-struct frr_pthread *bgp_pth_io;
+struct frr_pthread *bgp_pth_io_pool[BGP_IO_PTHREADS_MAX];
+uint32_t bgp_io_nthreads = 1;
 struct frr_pthread *bgp_pth_ka;
+struct frr_pthread *bgp_pth_dump;
 
 static void bgp_pthreads_init(void)
 {
-	assert(!bgp_pth_io);
+	assert(!bgp_pth_io_pool[0]);
 	assert(!bgp_pth_ka);
+	assert(!bgp_pth_dump);
 
 	frr_pthread_init();
 
@@ -7905,18 +7970,59 @@ static void bgp_pthreads_init(void)
 		.start = bgp_keepalives_start,
 		.stop = bgp_keepalives_stop,
 	};
-	bgp_pth_io = frr_pthread_new(&io, "BGP I/O thread", "bgpd_io");
+	struct frr_pthread_attr dump = {
+		.start = bgp_dump_pthread_start,
+		.stop = bgp_dump_pthread_stop,
+	};
+	/* Additional I/O pthreads are created in bgp_pthreads_run(), once
+	 * "bgp io-threads" has been read from the configuration.
+	 */
+	bgp_pth_io_pool[0] = frr_pthread_new(&io, "BGP I/O thread", "bgpd_io");
 	bgp_pth_ka = frr_pthread_new(&ka, "BGP Keepalives thread", "bgpd_ka");
+	bgp_pth_dump = frr_pthread_new(&dump, "BGP MRT dump thread", "bgpd_dump");
 }
 
 void bgp_pthreads_run(void)
 {
-	frr_pthread_run(bgp_pth_io, NULL);
+	struct frr_pthread_attr io = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+	char name[32], os_name[16];
+	uint32_t i;
+
+	/* The pool size is fixed for the daemon's lifetime: peers are
+	 * pinned to a member and there is no way to migrate their events.
+	 */
+	bgp_io_nthreads = bm->io_nthreads;
+	if (bgp_io_nthreads < 1)
+		bgp_io_nthreads = 1;
+	if (bgp_io_nthreads > BGP_IO_PTHREADS_MAX)
+		bgp_io_nthreads = BGP_IO_PTHREADS_MAX;
+
+	for (i = 1; i < bgp_io_nthreads; i++) {
+		snprintf(name, sizeof(name), "BGP I/O thread %u", i);
+		snprintf(os_name, sizeof(os_name), "bgpd_io%u", i);
+		bgp_pth_io_pool[i] = frr_pthread_new(&io, name, os_name);
+	}
+
+	for (i = 0; i < bgp_io_nthreads; i++)
+		frr_pthread_run(bgp_pth_io_pool[i], NULL);
 	frr_pthread_run(bgp_pth_ka, NULL);
+	frr_pthread_run(bgp_pth_dump, NULL);
 
 	/* Wait until threads are ready. */
-	frr_pthread_wait_running(bgp_pth_io);
+	for (i = 0; i < bgp_io_nthreads; i++)
+		frr_pthread_wait_running(bgp_pth_io_pool[i]);
 	frr_pthread_wait_running(bgp_pth_ka);
+	frr_pthread_wait_running(bgp_pth_dump);
+
+	/* best-path workers configured before the daemon forked */
+	bgp_bestpath_pool_apply();
+
+	/* give listeners created during config read their SO_REUSEPORT
+	 * siblings, now that the pool size is known */
+	bgp_listeners_shard();
 }
 
 void bgp_pthreads_finish(void)
@@ -7948,6 +8054,12 @@ void bgp_init(unsigned short instance)
 	bgp_attr_init();
 	bgp_debug_init();
 	bgp_dump_init();
+
+	/* MRT replay. */
+	bgp_replay_init();
+
+	/* Active/standby state sync. */
+	bgp_statesync_init();
 	bgp_route_init();
 	bgp_route_map_init();
 	bgp_scan_vty_init();
@@ -7958,6 +8070,11 @@ void bgp_init(unsigned short instance)
 	bgp_ethernetvpn_init();
 	bgp_flowspec_vty_init();
 
+	/* Run deferred filter/route-map reprocessing once the startup
+	 * configuration has been fully read.
+	 */
+	hook_register(frr_config_read_done, bgp_config_read_done);
+
 	/* Access list initialize. */
 	access_list_init();
 	access_list_add_hook(peer_distribute_update);
@@ -7986,7 +8103,6 @@ void bgp_terminate(void)
 {
 	struct bgp *bgp;
 	struct peer *peer;
-	struct listnode *node, *nnode;
 	struct listnode *mnode, *mnnode;
 
 	QOBJ_UNREG(bm);
@@ -8004,7 +8120,7 @@ void bgp_terminate(void)
 		list_delete(&bm->listen_sockets);
 
 	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp))
-		for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer))
+		frr_each_safe (bgp_peers, &bgp->peer, peer)
 			if (peer->status == Established
 			    || peer->status == OpenSent
 			    || peer->status == OpenConfirm)
@@ -34,12 +34,14 @@
 #include "sockunion.h"
 #include "routemap.h"
 #include "linklist.h"
+#include "typesafe.h"
 #include "defaults.h"
 #include "bgp_memory.h"
 #include "bitfield.h"
 #include "vxlan.h"
 #include "bgp_labelpool.h"
 #include "bgp_addpath_types.h"
+#include "tokenbucket.h"
 
 #define BGP_MAX_HOSTNAME 64	/* Linux max, is larger than most other sys */
 #define BGP_PEER_MAX_HASH_SIZE 16384
@@ -99,8 +101,15 @@ enum bgp_af_index {
 	for (afi = AFI_IP; afi < AFI_MAX; afi++)                               \
 		for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
 
-extern struct frr_pthread *bgp_pth_io;
+/* I/O pthread pool.  Each peer is pinned to one member for its whole
+ * lifetime (see bgp_io.c), so a peer's ibuf/obuf keep a single I/O-side
+ * writer and the per-peer io_mtx scheme is unchanged.
+ */
+#define BGP_IO_PTHREADS_MAX 8
+extern struct frr_pthread *bgp_pth_io_pool[BGP_IO_PTHREADS_MAX];
+extern uint32_t bgp_io_nthreads;
 extern struct frr_pthread *bgp_pth_ka;
+extern struct frr_pthread *bgp_pth_dump;
 
 /* BGP master for system wide configurations and variables.  */
 struct bgp_master {
@@ -144,6 +153,12 @@ struct bgp_master {
 	uint32_t rmap_update_timer;   /* Route map update timer */
 #define RMAP_DEFAULT_UPDATE_TIMER 5 /* disabled by default */
 
+	/* pthreads for parallel best-path selection, 0 disables */
+	uint32_t bestpath_workers;
+
+	/* number of I/O pthreads; fixed once the pool is running */
+	uint32_t io_nthreads;
+
 	/* Id space for automatic RD derivation for an EVI/VRF */
 	bitfield_t rd_idspace;
 
@@ -223,6 +238,11 @@ enum bgp_instance_type {
 	BGP_INSTANCE_TYPE_VIEW
 };
 
+/* Sorted intrusive list of the instance's peers; the linkage lives in
+ * struct peer itself, so membership costs no listnode allocation.
+ */
+PREDECL_SORTLIST_NONUNIQ(bgp_peers)
+
 /* BGP instance structure.  */
 struct bgp {
 	/* AS number of this BGP instance.  */
@@ -243,7 +263,7 @@ struct bgp {
 	struct peer *peer_self;
 
 	/* BGP peer. */
-	struct list *peer;
+	struct bgp_peers_head peer;
 	struct hash *peerhash;
 
 	/* BGP peer group.  */
@@ -317,6 +337,7 @@ struct bgp {
 	/* BGP update delay on startup */
 	struct thread *t_update_delay;
 	struct thread *t_establish_wait;
+	struct thread *t_rib_cache_stale;
 	uint8_t update_delay_over;
 	uint8_t main_zebra_update_hold;
 	uint8_t main_peers_update_hold;
@@ -330,6 +351,10 @@ struct bgp {
 	uint32_t restarted_peers;
 	uint32_t implicit_eors;
 	uint32_t explicit_eors;
+
+	/* Number of best-path selections run on this instance; bumped
+	 * lock-free from the route processing path for telemetry. */
+	_Atomic uint32_t bestpath_runs;
 #define BGP_UPDATE_DELAY_DEF              0
 #define BGP_UPDATE_DELAY_MIN              0
 #define BGP_UPDATE_DELAY_MAX              3600
@@ -382,6 +407,12 @@ struct bgp {
 
 	struct bgp_table *connected_table[AFI_MAX];
 
+	/* Bumped whenever connected_table[] contents change; validates
+	 * the per-peer cached connected-subnet match (see
+	 * bgp_peer_connected_match()).
+	 */
+	uint64_t connected_table_gen;
+
 	struct hash *address_hash;
 
 	/* DB for all local tunnel-ips - used mainly for martian checks
@@ -460,12 +491,21 @@ struct bgp {
 
 	_Atomic uint32_t wpkt_quanta; // max # packets to write per i/o cycle
 	_Atomic uint32_t rpkt_quanta; // max # packets to read per i/o cycle
+	_Atomic uint32_t io_read_pps; // per-peer read rate limit, pkts/sec
+				      // (0 = off)
 
 	/* Automatic coalesce adjust on/off */
 	bool heuristic_coalesce;
 	/* Actual coalesce time */
 	uint32_t coalesce_time;
 
+	/* Dampening window (milliseconds) for batching zebra next-hop
+	 * updates; 0 re-evaluates dependent paths on every update as it
+	 * arrives.
+	 */
+	uint32_t nht_eval_delay;
+	struct thread *t_nht_eval;
+
 	/* Auto-shutdown new peers */
 	bool autoshutdown;
 
@@ -695,16 +735,39 @@ struct peer_af {
 	 */
 	struct thread *t_announce_route;
 
+	/*
+	 * Token bucket (in packets) for paced UPDATE emission.  Armed
+	 * only while a large backlog sits on the subgroup packet queue;
+	 * see subgroup_pacing_take().
+	 */
+	struct token_bucket pace_bucket;
+	bool pace_armed;
+
 	afi_t afi;
 	safi_t safi;
 	int afid;
 };
 
+/* One-shot FSM timer, slotted into the timer wheel in bgp_fsm.c.
+ * Embedded in struct peer; 'due' is the absolute expiry second and is
+ * zero while the timer is idle.
+ */
+struct bgp_fsm_timer {
+	struct peer *peer;
+	time_t due;
+	void (*handler)(struct peer *peer);
+	struct bgp_fsm_timer *next;
+	struct bgp_fsm_timer **pprev;
+};
+
 /* BGP neighbor structure. */
 struct peer {
 	/* BGP structure.  */
 	struct bgp *bgp;
 
+	/* linkage on the parent instance's sorted peer list */
+	struct bgp_peers_item plistitm;
+
 	/* reference count, primarily to allow bgp_process'ing of route_node's
 	 * to be done after a struct peer is deleted.
 	 *
@@ -742,9 +805,21 @@ struct peer {
 	struct stream_fifo *ibuf; // packets waiting to be processed
 	struct stream_fifo *obuf; // packets waiting to be written
 
+	/* I/O pthread this peer is pinned to; assigned on first use and
+	 * never changed so all socket events stay on one event loop.
+	 */
+	struct frr_pthread *io_fpt;
+
 	struct ringbuf *ibuf_work; // WiP buffer used by bgp_read() only
 	struct stream *obuf_work;  // WiP buffer used to construct packets
 
+	/* Approximate count of announced NLRI sitting unprocessed on ibuf,
+	 * maintained by the I/O pthread and drained as the main thread
+	 * consumes packets; used to trip maximum-prefix before parse
+	 * (see bgp_io.c).
+	 */
+	_Atomic uint32_t ibuf_nlri_pending[AFI_MAX][SAFI_MAX];
+
 	struct stream *curr; // the current packet being parsed
 
 	/* We use a separate stream to encode MP_REACH_NLRI for efficient
@@ -780,6 +855,16 @@ struct peer {
 	char *host;	  /* Printable address of the peer. */
 	union sockunion su;  /* Sockunion address of the peer. */
 #define BGP_PEER_SU_UNSPEC(peer) (peer->su.sa.sa_family == AF_UNSPEC)
+
+	/* Cached longest match of the session address in the instance's
+	 * connected table, revalidated against bgp->connected_table_gen
+	 * and the address it was computed for.  Compare-only - no node
+	 * reference is held, and the pointer is never dereferenced.
+	 */
+	struct bgp_node *connected_rn;
+	union sockunion connected_rn_su;
+	uint64_t connected_rn_gen;
+	bool connected_rn_set;
 	time_t uptime;       /* Last Up/Down time */
 	time_t readtime;     /* Last read time */
 	time_t resettime;    /* Last reset time */
@@ -1007,15 +1092,25 @@ struct peer {
 	_Atomic uint32_t v_pmax_restart;
 	_Atomic uint32_t v_gr_restart;
 
+	/* Read-side token bucket for bgp->io_read_pps; owned by the I/O
+	 * thread handling this peer (see bgp_process_reads()). */
+	struct token_bucket read_limit;
+
 	/* Threads. */
 	struct thread *t_read;
 	struct thread *t_write;
 	struct thread *t_start;
 	struct thread *t_connect_check_r;
 	struct thread *t_connect_check_w;
-	struct thread *t_connect;
-	struct thread *t_holdtime;
-	struct thread *t_routeadv;
+
+	/* Connect, holdtime and routeadv (MRAI) timers are multiplexed
+	 * onto a single wheel in bgp_fsm.c rather than holding one
+	 * lib/thread timer apiece; see bgp_fsm_timer_on().
+	 */
+	struct bgp_fsm_timer ft_connect;
+	struct bgp_fsm_timer ft_holdtime;
+	struct bgp_fsm_timer ft_routeadv;
+
 	struct thread *t_pmax_restart;
 	struct thread *t_gr_restart;
 	struct thread *t_gr_stale;
@@ -1197,6 +1292,16 @@ struct peer {
 };
 DECLARE_QOBJ_TYPE(peer)
 
+extern int peer_cmp(struct peer *p1, struct peer *p2);
+
+/* const shim for the typesafe sortlist; peer_cmp predates it and feeds
+ * the peer names through if_cmp_name_func, which takes non-const args */
+static inline int peer_sort_cmp(const struct peer *p1, const struct peer *p2)
+{
+	return peer_cmp((struct peer *)p1, (struct peer *)p2);
+}
+DECLARE_SORTLIST_NONUNIQ(bgp_peers, struct peer, plistitm, peer_sort_cmp)
+
 /* Inherit peer attribute from peer-group. */
 #define PEER_ATTR_INHERIT(peer, group, attr)                                   \
 	((peer)->attr = (group)->conf->attr)
@@ -1696,7 +1801,7 @@ extern int peer_maximum_prefix_set(struct peer *, afi_t, safi_t, uint32_t,
 				   uint8_t, int, uint16_t);
 extern int peer_maximum_prefix_unset(struct peer *, afi_t, safi_t);
 
-extern int peer_clear(struct peer *, struct listnode **);
+extern int peer_clear(struct peer *, struct peer **);
 extern int peer_clear_soft(struct peer *, afi_t, safi_t, enum bgp_clear_type);
 
 extern int peer_ttl_security_hops_set(struct peer *, int);
@@ -1708,8 +1813,6 @@ extern int peer_tx_shutdown_message_unset(struct peer *);
 extern int bgp_route_map_update_timer(struct thread *thread);
 extern void bgp_route_map_terminate(void);
 
-extern int peer_cmp(struct peer *p1, struct peer *p2);
-
 extern int bgp_map_afi_safi_iana2int(iana_afi_t pkt_afi, iana_safi_t pkt_safi,
 				     afi_t *afi, safi_t *safi);
 extern int bgp_map_afi_safi_int2iana(afi_t afi, safi_t safi,
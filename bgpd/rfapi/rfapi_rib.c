@@ -116,6 +116,25 @@ static void rfapiRibShowRibSl(void *stream, struct prefix *pfx,
  *			rfapi_info STRUCTS IN THE node->info LIST.
  */
 
+/*
+ * rfapi_info structs churn with every RFP response: a large NVA serves
+ * hundreds of thousands of registrations, so they are carved out of
+ * slab chunks and recycled through a free list instead of hitting the
+ * allocator per route (same scheme as bgpd's dampening info pool).
+ * Chunks are kept for the life of the process; the pool's high-water
+ * mark tracks the peak number of RIB entries.
+ */
+#define RFAPI_INFO_POOL_CHUNK 128
+
+struct rfapi_info_pool_chunk {
+	struct rfapi_info_pool_chunk *next;
+	struct rfapi_info slots[RFAPI_INFO_POOL_CHUNK];
+};
+
+static struct rfapi_info_pool_chunk *rfapi_info_pool_chunks;
+static struct rfapi_info *rfapi_info_pool_free; /* via ->pool_next */
+static uint32_t rfapi_info_live; /* allocated and not yet released */
+
 /*
  * iterate over RIB to count responses, compare with running counters
  */
@@ -216,15 +235,37 @@ void rfapiRibCheckCounts(
 	}
 
 	/*
-	 * Check against memory allocation count
+	 * Check against the pool's live object count; MTYPE_RFAPI_INFO
+	 * is accounted in slab chunks, not individual rfapi_infos
 	 */
-	alloc_count = mtype_stats_alloc(MTYPE_RFAPI_INFO);
+	alloc_count = rfapi_info_live;
 	assert(t_ri_active + t_ri_deleted + t_ri_pend + offset == alloc_count);
 }
 
 static struct rfapi_info *rfapi_info_new(void)
 {
-	return XCALLOC(MTYPE_RFAPI_INFO, sizeof(struct rfapi_info));
+	struct rfapi_info *ri;
+
+	if (!rfapi_info_pool_free) {
+		struct rfapi_info_pool_chunk *chunk;
+		int i;
+
+		chunk = XCALLOC(MTYPE_RFAPI_INFO, sizeof(*chunk));
+		chunk->next = rfapi_info_pool_chunks;
+		rfapi_info_pool_chunks = chunk;
+
+		for (i = 0; i < RFAPI_INFO_POOL_CHUNK; i++) {
+			chunk->slots[i].pool_next = rfapi_info_pool_free;
+			rfapi_info_pool_free = &chunk->slots[i];
+		}
+	}
+
+	ri = rfapi_info_pool_free;
+	rfapi_info_pool_free = ri->pool_next;
+	memset(ri, 0, sizeof(*ri));
+	rfapi_info_live++;
+
+	return ri;
 }
 
 void rfapiFreeRfapiUnOptionChain(struct rfapi_un_option *p)
@@ -273,7 +314,10 @@ static void rfapi_info_free(struct rfapi_info *goner)
 			XFREE(MTYPE_RFAPI_RECENT_DELETE, tcb);
 			goner->timer = NULL;
 		}
-		XFREE(MTYPE_RFAPI_INFO, goner);
+		/* back on the pool free list, not to the allocator */
+		goner->pool_next = rfapi_info_pool_free;
+		rfapi_info_pool_free = goner;
+		rfapi_info_live--;
 	}
 }
 
@@ -1104,9 +1148,15 @@ static void process_pending_node(struct bgp *bgp, struct rfapi_descriptor *rfd,
 				ori->un = ri->un;
 				ori->cost = ri->cost;
 				ori->lifetime = ri->lifetime;
+				/*
+				 * The response callback below frees the
+				 * pending ri's tea option chain rather than
+				 * transferring it, so move it here instead
+				 * of duplicating it.
+				 */
 				rfapiFreeBgpTeaOptionChain(ori->tea_options);
-				ori->tea_options =
-					rfapiOptionsDup(ri->tea_options);
+				ori->tea_options = ri->tea_options;
+				ri->tea_options = NULL;
 				ori->last_sent_time = rfapi_time(NULL);
 
 				rfapiFreeRfapiVnOptionChain(ori->vn_options);
@@ -1131,8 +1181,9 @@ static void process_pending_node(struct bgp *bgp, struct rfapi_descriptor *rfd,
 				ori->un = ri->un;
 				ori->cost = ri->cost;
 				ori->lifetime = ri->lifetime;
-				ori->tea_options =
-					rfapiOptionsDup(ri->tea_options);
+				/* moved, not duplicated; see above */
+				ori->tea_options = ri->tea_options;
+				ri->tea_options = NULL;
 				ori->last_sent_time = rfapi_time(NULL);
 				ori->vn_options =
 					rfapiVnOptionsDup(ri->vn_options);
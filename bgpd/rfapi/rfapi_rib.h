@@ -75,6 +75,9 @@ struct rfapi_info {
 	struct rfapi_un_option *un_options;
 	struct rfapi_vn_option *vn_options;
 	struct thread *timer;
+
+	/* slab pool free-list link; only meaningful while unallocated */
+	struct rfapi_info *pool_next;
 };
 
 /*
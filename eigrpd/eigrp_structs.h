@@ -449,6 +449,11 @@ enum GR_type { EIGRP_GR_MANUAL, EIGRP_GR_FILTER };
 /* EIGRP Topology table node structure */
 struct eigrp_prefix_entry {
 	struct list *entries, *rij;
+	/* Cached successor set, kept in distance order.  Rebuilt by
+	 * eigrp_topology_update_node_flags() whenever a reported distance
+	 * changes, so successor lookups during diffusing computations do
+	 * not rescan the whole entry list. */
+	struct list *successors;
 	uint32_t fdistance;		      // FD
 	uint32_t rdistance;		      // RD
 	uint32_t distance;		      // D
@@ -77,7 +77,9 @@ struct eigrp_prefix_entry *eigrp_prefix_entry_new(void)
 		      sizeof(struct eigrp_prefix_entry));
 	new->entries = list_new();
 	new->rij = list_new();
+	new->successors = list_new();
 	new->entries->cmp = (int (*)(void *, void *))eigrp_nexthop_entry_cmp;
+	new->successors->cmp = (int (*)(void *, void *))eigrp_nexthop_entry_cmp;
 	new->distance = new->fdistance = new->rdistance = EIGRP_MAX_METRIC;
 	new->destination = NULL;
 
@@ -161,6 +163,11 @@ void eigrp_nexthop_entry_add(struct eigrp_prefix_entry *node,
 		listnode_add_sort(node->entries, entry);
 		entry->prefix = node;
 
+		/* Entries marked up front (connected routes, first entry of
+		 * a new prefix) go straight into the successor cache. */
+		if (entry->flags & EIGRP_NEXTHOP_ENTRY_SUCCESSOR_FLAG)
+			listnode_add_sort(node->successors, entry);
+
 		eigrp_zebra_route_add(node->destination, l, node->fdistance);
 	}
 
@@ -195,6 +202,7 @@ void eigrp_prefix_entry_delete(struct route_table *table,
 		eigrp_nexthop_entry_delete(pe, ne);
 	list_delete(&pe->entries);
 	list_delete(&pe->rij);
+	list_delete(&pe->successors);
 	eigrp_zebra_route_delete(pe->destination);
 	prefix_free(pe->destination);
 
@@ -212,6 +220,7 @@ void eigrp_nexthop_entry_delete(struct eigrp_prefix_entry *node,
 {
 	if (listnode_lookup(node->entries, entry) != NULL) {
 		listnode_delete(node->entries, entry);
+		listnode_delete(node->successors, entry);
 		eigrp_zebra_route_delete(node->destination);
 		XFREE(MTYPE_EIGRP_NEXTHOP_ENTRY, entry);
 	}
@@ -254,33 +263,19 @@ eigrp_topology_table_lookup_ipv4(struct route_table *table,
 }
 
 /*
- * For a future optimization, put the successor list into it's
- * own separate list from the full list?
- *
- * That way we can clean up all the list_new and list_delete's
- * that we are doing.  DBS
+ * The successor set is cached on the prefix entry and rebuilt by
+ * eigrp_topology_update_node_flags(), so this no longer rescans the
+ * full entry list.  Callers still own (and delete) the returned list.
  */
 struct list *eigrp_topology_get_successor(struct eigrp_prefix_entry *table_node)
 {
-	struct list *successors = list_new();
-	struct eigrp_nexthop_entry *data;
-	struct listnode *node1, *node2;
-
-	for (ALL_LIST_ELEMENTS(table_node->entries, node1, node2, data)) {
-		if (data->flags & EIGRP_NEXTHOP_ENTRY_SUCCESSOR_FLAG) {
-			listnode_add(successors, data);
-		}
-	}
-
 	/*
 	 * If we have no successors return NULL
 	 */
-	if (!successors->count) {
-		list_delete(&successors);
-		successors = NULL;
-	}
+	if (!table_node->successors->count)
+		return NULL;
 
-	return successors;
+	return list_dup(table_node->successors);
 }
 
 struct list *
@@ -438,6 +433,10 @@ void eigrp_topology_update_node_flags(struct eigrp_prefix_entry *dest)
 
 	assert(eigrp);
 
+	list_delete_all_node(dest->successors);
+
+	/* Entries are kept in distance order, so the successor cache
+	 * rebuilt here inherits that order. */
 	for (ALL_LIST_ELEMENTS_RO(dest->entries, node, entry)) {
 		if (entry->reported_distance < dest->fdistance) {
 			// is feasible successor, can be successor
@@ -450,6 +449,7 @@ void eigrp_topology_update_node_flags(struct eigrp_prefix_entry *dest)
 					EIGRP_NEXTHOP_ENTRY_SUCCESSOR_FLAG;
 				entry->flags &=
 					~EIGRP_NEXTHOP_ENTRY_FSUCCESSOR_FLAG;
+				listnode_add(dest->successors, entry);
 			} else {
 				// is feasible successor only
 				entry->flags |=
@@ -18,6 +18,7 @@
 #include "zebra.h"
 #include "zassert.h"
 #include "memory.h"
+#include "jhash.h"
 #include "isis_memory.h"
 #include "dict.h"
 
@@ -40,6 +41,8 @@
 #define key dict_key
 #define data dict_data
 
+#define hnext dict_hnext
+
 #define nilnode dict_nilnode
 #define nodecount dict_nodecount
 #define maxcount dict_maxcount
@@ -48,6 +51,9 @@
 #define freenode dict_freenode
 #define context dict_context
 #define dupes dict_dupes
+#define keylen dict_keylen
+#define htable dict_htable
+#define hsize dict_hsize
 
 #define dictptr dict_dictptr
 
@@ -274,6 +280,91 @@ void dict_set_allocator(dict_t *dict, dnode_alloc_t al, dnode_free_t fr,
 	dict->context = context;
 }
 
+/*
+ * Optional hash index over fixed-size keys.  The red-black tree stays
+ * authoritative and keeps providing ordered traversal; the index makes
+ * dict_lookup() O(1).  It can only be enabled on an empty dictionary
+ * that does not allow duplicate keys.
+ */
+
+#define DICT_HINDEX_INITIAL_SIZE 256
+
+static unsigned int dict_key_hash(dict_t *dict, const void *key)
+{
+	return jhash(key, dict->keylen, 0x55aa5a5a);
+}
+
+static void hindex_grow(dict_t *dict)
+{
+	dictcount_t newsize = dict->hsize * 2;
+	dnode_t **newtable = XCALLOC(MTYPE_ISIS_DICT_INDEX,
+				     newsize * sizeof(dnode_t *));
+	dnode_t *node, *next;
+	unsigned int bucket;
+	dictcount_t i;
+
+	for (i = 0; i < dict->hsize; i++) {
+		for (node = dict->htable[i]; node; node = next) {
+			next = node->hnext;
+			bucket = dict_key_hash(dict, node->key) & (newsize - 1);
+			node->hnext = newtable[bucket];
+			newtable[bucket] = node;
+		}
+	}
+
+	XFREE(MTYPE_ISIS_DICT_INDEX, dict->htable);
+	dict->htable = newtable;
+	dict->hsize = newsize;
+}
+
+static void hindex_insert(dict_t *dict, dnode_t *node)
+{
+	unsigned int bucket;
+
+	if (!dict->htable)
+		return;
+
+	if (dict->nodecount > dict->hsize)
+		hindex_grow(dict);
+
+	bucket = dict_key_hash(dict, node->key) & (dict->hsize - 1);
+	node->hnext = dict->htable[bucket];
+	dict->htable[bucket] = node;
+}
+
+static void hindex_delete(dict_t *dict, dnode_t *node)
+{
+	dnode_t **prev;
+
+	if (!dict->htable)
+		return;
+
+	prev = &dict->htable[dict_key_hash(dict, node->key)
+			     & (dict->hsize - 1)];
+	while (*prev != node)
+		prev = &(*prev)->hnext;
+	*prev = node->hnext;
+	node->hnext = NULL;
+}
+
+static void hindex_clear(dict_t *dict)
+{
+	if (dict->htable)
+		memset(dict->htable, 0, dict->hsize * sizeof(dnode_t *));
+}
+
+void dict_enable_hash_index(dict_t *dict, size_t keylength)
+{
+	assert(dict_isempty(dict));
+	assert(!dict->dupes);
+	assert(keylength > 0);
+
+	dict->keylen = keylength;
+	dict->hsize = DICT_HINDEX_INITIAL_SIZE;
+	dict->htable = XCALLOC(MTYPE_ISIS_DICT_INDEX,
+			       dict->hsize * sizeof(dnode_t *));
+}
+
 /*
  * Free a dynamically allocated dictionary object. Removing the nodes
  * from the tree before deleting it is required.
@@ -282,6 +373,8 @@ void dict_set_allocator(dict_t *dict, dnode_alloc_t al, dnode_free_t fr,
 void dict_destroy(dict_t *dict)
 {
 	assert(dict_isempty(dict));
+	if (dict->htable)
+		XFREE(MTYPE_ISIS_DICT_INDEX, dict->htable);
 	XFREE(MTYPE_ISIS_DICT, dict);
 }
 
@@ -294,6 +387,7 @@ void dict_free_nodes(dict_t *dict)
 {
 	dnode_t *nil = dict_nil(dict), *root = dict_root(dict);
 	free_nodes(dict, root, nil);
+	hindex_clear(dict);
 	dict->nodecount = 0;
 	dict->nilnode.left = &dict->nilnode;
 	dict->nilnode.right = &dict->nilnode;
@@ -325,6 +419,9 @@ dict_t *dict_init(dict_t *dict, dictcount_t maxcount, dict_comp_t comp)
 	dict->nilnode.parent = &dict->nilnode;
 	dict->nilnode.color = dnode_black;
 	dict->dupes = 0;
+	dict->keylen = 0;
+	dict->htable = NULL;
+	dict->hsize = 0;
 	return dict;
 }
 
@@ -345,6 +442,9 @@ void dict_init_like(dict_t *dict, const dict_t *template)
 	dict->nilnode.parent = &dict->nilnode;
 	dict->nilnode.color = dnode_black;
 	dict->dupes = template->dupes;
+	dict->keylen = 0;
+	dict->htable = NULL;
+	dict->hsize = 0;
 
 	assert(dict_similar(dict, template));
 }
@@ -355,6 +455,7 @@ void dict_init_like(dict_t *dict, const dict_t *template)
 
 static void dict_clear(dict_t *dict)
 {
+	hindex_clear(dict);
 	dict->nodecount = 0;
 	dict->nilnode.left = &dict->nilnode;
 	dict->nilnode.right = &dict->nilnode;
@@ -436,6 +537,15 @@ dnode_t *dict_lookup(dict_t *dict, const void *key)
 	dnode_t *saved;
 	int result;
 
+	if (dict->htable) {
+		for (saved = dict->htable[dict_key_hash(dict, key)
+					  & (dict->hsize - 1)];
+		     saved; saved = saved->hnext)
+			if (dict->compare(key, saved->key) == 0)
+				return saved;
+		return NULL;
+	}
+
 	/* simple binary search adapted for trees that contain duplicate keys */
 
 	while (root != nil) {
@@ -575,6 +685,9 @@ void dict_insert(dict_t *dict, dnode_t *node, const void *key)
 
 	dict->nodecount++;
 
+	/* index before the red-black fixup below reassigns ``node'' */
+	hindex_insert(dict, node);
+
 	/* red black adjustments */
 
 	node->color = dnode_red;
@@ -645,6 +758,8 @@ dnode_t *dict_delete(dict_t *dict, dnode_t *delete)
 	assert(!dict_isempty(dict));
 	assert(dict_contains(dict, delete));
 
+	hindex_delete(dict, delete);
+
 	/*
 	 * If the node being deleted has two children, then we replace it with
 	 * its
@@ -960,14 +1075,36 @@ int dict_contains(dict_t *dict, dnode_t *node)
 	return verify_dict_has_node(dict_nil(dict), dict_root(dict), node);
 }
 
+/* The LSP DB churns nodes on every flooding event, so the default
+ * allocator keeps a bounded free list instead of going through the
+ * heap each time. */
+#define DNODE_POOL_MAX 1024
+
+static dnode_t *dnode_pool;
+static unsigned int dnode_pool_count;
+
 static dnode_t *dnode_alloc(void *context)
 {
+	dnode_t *node = dnode_pool;
+
+	if (node) {
+		dnode_pool = node->left;
+		dnode_pool_count--;
+		memset(node, 0, sizeof(*node));
+		return node;
+	}
+
 	return XCALLOC(MTYPE_ISIS_DICT_NODE, sizeof(dnode_t));
 }
 
 static void dnode_free(dnode_t *node, void *context)
 {
-	XFREE(MTYPE_ISIS_DICT_NODE, node);
+	if (dnode_pool_count < DNODE_POOL_MAX) {
+		node->left = dnode_pool;
+		dnode_pool = node;
+		dnode_pool_count++;
+	} else
+		XFREE(MTYPE_ISIS_DICT_NODE, node);
 }
 
 dnode_t *dnode_create(void *data)
@@ -1066,6 +1203,8 @@ void dict_load_next(dict_load_t *load, dnode_t *newnode, const void *key)
 	nil->right = newnode;
 	newnode->left = nil;
 	dict->nodecount++;
+
+	hindex_insert(dict, newnode);
 }
 
 void dict_load_end(dict_load_t *load)
@@ -42,6 +42,7 @@ typedef struct dnode_t {
 	struct dnode_t *dict_left;
 	struct dnode_t *dict_right;
 	struct dnode_t *dict_parent;
+	struct dnode_t *dict_hnext; /* hash index bucket chain */
 	dnode_color_t dict_color;
 	const void *dict_key;
 	void *dict_data;
@@ -60,6 +61,11 @@ typedef struct dict_t {
 	dnode_free_t dict_freenode;
 	void *dict_context;
 	int dict_dupes;
+	/* Optional hash index over fixed-size keys; see
+	 * dict_enable_hash_index(). */
+	size_t dict_keylen;
+	struct dnode_t **dict_htable;
+	dictcount_t dict_hsize;
 } dict_t;
 
 typedef void (*dnode_process_t)(dict_t *, dnode_t *, void *);
@@ -71,6 +77,7 @@ typedef struct dict_load_t {
 
 extern dict_t *dict_create(dictcount_t, dict_comp_t);
 extern void dict_set_allocator(dict_t *, dnode_alloc_t, dnode_free_t, void *);
+extern void dict_enable_hash_index(dict_t *, size_t);
 extern void dict_destroy(dict_t *);
 extern void dict_free_nodes(dict_t *);
 extern void dict_free(dict_t *);
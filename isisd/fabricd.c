@@ -68,6 +68,10 @@ struct fabricd {
 
 	int csnp_delay;
 	bool always_send_csnp;
+	/* spftree/neighbors/neighbors_neighbors reflect the current
+	 * physical topology and need not be recomputed for leaf-only
+	 * changes */
+	bool topology_valid;
 };
 
 /* Code related to maintaining the neighbor lists */
@@ -477,9 +481,18 @@ void fabricd_run_spf(struct isis_area *area)
 	if (!f)
 		return;
 
+	/* Every event since the last run was classified as leaf-only by
+	 * the LSP update path (see isis_spf_schedule_hint_leaf_only()),
+	 * so the flooding topology is unchanged and the cached hopcount
+	 * tree and neighbor sets stay valid. */
+	if (f->topology_valid
+	    && area->spf_pending_leaf_only[ISIS_LEVEL2 - 1])
+		return;
+
 	isis_run_hopcount_spf(area, isis->sysid, f->spftree);
 	neighbors_neighbors_update(f);
 	fabricd_bump_tier_calculation_timer(f);
+	f->topology_valid = true;
 }
 
 struct isis_spftree *fabricd_spftree(struct isis_area *area)
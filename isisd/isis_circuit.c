@@ -138,6 +138,9 @@ struct isis_circuit *isis_circuit_new(void)
 
 	circuit->mtc = mpls_te_circuit_new();
 
+	circuit->ssn_pending[0] = list_new();
+	circuit->ssn_pending[1] = list_new();
+
 	circuit_mt_init(circuit);
 
 	QOBJ_REG(circuit, isis_circuit);
@@ -156,6 +159,9 @@ void isis_circuit_del(struct isis_circuit *circuit)
 
 	circuit_mt_finish(circuit);
 
+	list_delete(&circuit->ssn_pending[0]);
+	list_delete(&circuit->ssn_pending[1]);
+
 	/* and lastly the circuit itself */
 	XFREE(MTYPE_ISIS_CIRCUIT, circuit);
 
@@ -727,6 +733,15 @@ void isis_circuit_down(struct isis_circuit *circuit)
 	/* Clear the flags for all the lsps of the circuit. */
 	isis_circuit_update_all_srmflags(circuit, 0);
 
+	/* Likewise for the SSN flags, so that the pending lists do not
+	 * keep references to LSPs across a down/up cycle. */
+	for (int level = 0; level < 2; level++) {
+		struct isis_lsp *lsp;
+
+		while ((lsp = listnode_head(circuit->ssn_pending[level])))
+			isis_lsp_ssn_clear(lsp, circuit);
+	}
+
 	if (circuit->circ_type == CIRCUIT_T_BROADCAST) {
 		/* destroy neighbour lists */
 		if (circuit->u.bc.lan_neighs[0]) {
@@ -87,6 +87,7 @@ struct isis_circuit {
 	struct thread *t_send_csnp[2];
 	struct thread *t_send_psnp[2];
 	struct isis_tx_queue *tx_queue;
+	struct list *ssn_pending[2]; /* LSPs with SSN flag set for us */
 	struct isis_circuit_arg level_arg[2]; /* used as argument for threads */
 
 	/* there is no real point in two streams, just for programming kicker */
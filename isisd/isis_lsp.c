@@ -68,11 +68,45 @@ int lsp_id_cmp(uint8_t *id1, uint8_t *id2)
 	return memcmp(id1, id2, ISIS_SYS_ID_LEN + 2);
 }
 
+/* The SSN flag bitmaps are mirrored by per-circuit pending lists so
+ * that send_psnp() only has to look at LSPs with actual work instead of
+ * scanning the whole LSP DB; always change them through these
+ * helpers. */
+void isis_lsp_ssn_set(struct isis_lsp *lsp, struct isis_circuit *circuit)
+{
+	if (ISIS_CHECK_FLAG(lsp->SSNflags, circuit))
+		return;
+
+	ISIS_SET_FLAG(lsp->SSNflags, circuit);
+	listnode_add(circuit->ssn_pending[lsp->level - 1], lsp);
+}
+
+void isis_lsp_ssn_clear(struct isis_lsp *lsp, struct isis_circuit *circuit)
+{
+	if (!ISIS_CHECK_FLAG(lsp->SSNflags, circuit))
+		return;
+
+	ISIS_CLEAR_FLAG(lsp->SSNflags, circuit);
+	listnode_delete(circuit->ssn_pending[lsp->level - 1], lsp);
+}
+
+void isis_lsp_ssn_clear_all(struct isis_lsp *lsp)
+{
+	struct listnode *node;
+	struct isis_circuit *circuit;
+
+	for (ALL_LIST_ELEMENTS_RO(lsp->area->circuit_list, node, circuit))
+		isis_lsp_ssn_clear(lsp, circuit);
+
+	ISIS_FLAGS_CLEAR_ALL(lsp->SSNflags);
+}
+
 dict_t *lsp_db_init(void)
 {
 	dict_t *dict;
 
 	dict = dict_create(DICTCOUNT_T_MAX, (dict_comp_t)lsp_id_cmp);
+	dict_enable_hash_index(dict, ISIS_SYS_ID_LEN + 2);
 
 	return dict;
 }
@@ -107,6 +141,7 @@ static void lsp_clear_data(struct isis_lsp *lsp)
 
 	isis_free_tlvs(lsp->tlvs);
 	lsp->tlvs = NULL;
+	lsp->pdu_packed = false;
 }
 
 static void lsp_remove_frags(struct list *frags, dict_t *lspdb);
@@ -119,8 +154,10 @@ static void lsp_destroy(struct isis_lsp *lsp)
 	if (!lsp)
 		return;
 
-	for (ALL_LIST_ELEMENTS_RO(lsp->area->circuit_list, cnode, circuit))
+	for (ALL_LIST_ELEMENTS_RO(lsp->area->circuit_list, cnode, circuit)) {
 		isis_tx_queue_del(circuit->tx_queue, lsp);
+		isis_lsp_ssn_clear(lsp, circuit);
+	}
 
 	ISIS_FLAGS_CLEAR_ALL(lsp->SSNflags);
 
@@ -344,6 +381,7 @@ static void lsp_pack_pdu(struct isis_lsp *lsp)
 	lsp->hdr.checksum =
 		ntohs(fletcher_checksum(STREAM_DATA(lsp->pdu) + 12,
 					stream_get_endp(lsp->pdu) - 12, 12));
+	lsp->pdu_packed = true;
 }
 
 void lsp_inc_seqno(struct isis_lsp *lsp, uint32_t seqno)
@@ -366,7 +404,20 @@ void lsp_inc_seqno(struct isis_lsp *lsp, uint32_t seqno)
 
 	lsp->hdr.seqno = newseq;
 
-	lsp_pack_pdu(lsp);
+	if (lsp->pdu_packed && lsp->tlvs) {
+		/* The TLV area of lsp->pdu is still the current pack of
+		 * lsp->tlvs: rewrite the header with the new sequence
+		 * number, refresh the authentication digest at its
+		 * recorded offset and recompute the checksum, instead of
+		 * running a full isis_pack_tlvs() pass. */
+		put_lsp_hdr(lsp, NULL, true);
+		isis_tlvs_update_auth(lsp->tlvs, lsp->pdu, true);
+		lsp->hdr.checksum = ntohs(
+			fletcher_checksum(STREAM_DATA(lsp->pdu) + 12,
+					  stream_get_endp(lsp->pdu) - 12, 12));
+	} else
+		lsp_pack_pdu(lsp);
+
 	isis_spf_schedule(lsp->area, lsp->level);
 }
 
@@ -455,6 +506,7 @@ static void lsp_update_data(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
 	if (lsp->pdu != NULL)
 		stream_free(lsp->pdu);
 	lsp->pdu = stream_dup(stream);
+	lsp->pdu_packed = false;
 
 	memcpy(&lsp->hdr, hdr, sizeof(lsp->hdr));
 	lsp->area = area;
@@ -489,10 +541,84 @@ static void lsp_link_fragment(struct isis_lsp *lsp, struct isis_lsp *lsp0)
 	}
 }
 
+/* TLVs that only describe prefix reachability - leaves of the SPT.  The
+ * authentication TLV is included because it changes with every new
+ * sequence number and says nothing about the topology. */
+static bool lsp_tlv_is_leaf_only(uint8_t type)
+{
+	switch (type) {
+	case ISIS_TLV_AUTH:
+	case ISIS_TLV_OLDSTYLE_IP_REACH:
+	case ISIS_TLV_OLDSTYLE_IP_REACH_EXT:
+	case ISIS_TLV_EXTENDED_IP_REACH:
+	case ISIS_TLV_MT_IP_REACH:
+	case ISIS_TLV_IPV6_REACH:
+	case ISIS_TLV_MT_IPV6_REACH:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Advance *pos past any leaf-only TLVs.  After a true return, *pos is
+ * either len or the offset of a bounds-checked structural TLV.  Returns
+ * false if the TLV area is malformed. */
+static bool lsp_skip_leaf_tlvs(const uint8_t *buf, size_t len, size_t *pos)
+{
+	while (*pos < len) {
+		if (*pos + 2 > len || *pos + 2 + buf[*pos + 1] > len)
+			return false;
+		if (!lsp_tlv_is_leaf_only(buf[*pos]))
+			return true;
+		*pos += 2 + buf[*pos + 1];
+	}
+	return true;
+}
+
+/*
+ * Check whether two versions of an LSP differ in their prefix
+ * reachability TLVs only, in which case a leaf-only SPF run is
+ * sufficient.  The remaining TLVs must match byte for byte and in
+ * order; anything malformed counts as a structural change.
+ */
+static bool lsp_diff_is_leaf_only(struct stream *old_pdu, uint16_t old_len,
+				  struct stream *new_pdu, uint16_t new_len)
+{
+	size_t tlv_start = ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN;
+	const uint8_t *obuf, *nbuf;
+	size_t opos, olen, npos, nlen;
+
+	if (old_len < tlv_start || old_len > stream_get_endp(old_pdu))
+		return false;
+	if (new_len < tlv_start || new_len > stream_get_endp(new_pdu))
+		return false;
+
+	obuf = STREAM_DATA(old_pdu);
+	nbuf = STREAM_DATA(new_pdu);
+	olen = old_len;
+	nlen = new_len;
+	opos = npos = tlv_start;
+
+	while (1) {
+		if (!lsp_skip_leaf_tlvs(obuf, olen, &opos)
+		    || !lsp_skip_leaf_tlvs(nbuf, nlen, &npos))
+			return false;
+		if (opos == olen || npos == nlen)
+			return opos == olen && npos == nlen;
+		if (obuf[opos + 1] != nbuf[npos + 1]
+		    || memcmp(obuf + opos, nbuf + npos, 2 + obuf[opos + 1]))
+			return false;
+		opos += 2 + obuf[opos + 1];
+		npos += 2 + nbuf[npos + 1];
+	}
+}
+
 void lsp_update(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
 		struct isis_tlvs *tlvs, struct stream *stream,
 		struct isis_area *area, int level, bool confusion)
 {
+	bool leaf_only = false;
+
 	if (lsp->own_lsp) {
 		flog_err(
 			EC_LIB_DEVELOPMENT,
@@ -505,6 +631,11 @@ void lsp_update(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
 	if (confusion) {
 		lsp_purge(lsp, level, NULL);
 	} else {
+		if (lsp->pdu && stream)
+			leaf_only = lsp_diff_is_leaf_only(lsp->pdu,
+							  lsp->hdr.pdu_len,
+							  stream,
+							  hdr->pdu_len);
 		lsp_update_data(lsp, hdr, tlvs, stream, area, level);
 	}
 
@@ -519,8 +650,11 @@ void lsp_update(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
 			lsp_link_fragment(lsp, lsp0);
 	}
 
-	if (lsp->hdr.seqno)
+	if (lsp->hdr.seqno) {
+		if (leaf_only)
+			isis_spf_schedule_hint_leaf_only(lsp->area, lsp->level);
 		isis_spf_schedule(lsp->area, lsp->level);
+	}
 }
 
 /* creation of LSP directly from what we received */
@@ -547,6 +681,7 @@ static void lsp_adjust_stream(struct isis_lsp *lsp)
 	}
 
 	lsp->pdu = stream_new(LLC_LEN + lsp->area->lsp_mtu);
+	lsp->pdu_packed = false;
 }
 
 struct isis_lsp *lsp_new(struct isis_area *area, uint8_t *lsp_id,
@@ -43,6 +43,10 @@ struct isis_lsp {
 	time_t installed;
 	time_t last_generated;
 	int own_lsp;
+	/* pdu holds the current pack of tlvs; lsp_inc_seqno() can then
+	 * refresh header, auth digest and checksum in place instead of
+	 * repacking */
+	bool pdu_packed;
 	/* used for 60 second counting when rem_lifetime is zero */
 	int age_out;
 	struct isis_area *area;
@@ -55,6 +59,9 @@ struct isis_lsp {
 };
 
 dict_t *lsp_db_init(void);
+void isis_lsp_ssn_set(struct isis_lsp *lsp, struct isis_circuit *circuit);
+void isis_lsp_ssn_clear(struct isis_lsp *lsp, struct isis_circuit *circuit);
+void isis_lsp_ssn_clear_all(struct isis_lsp *lsp);
 void lsp_db_destroy(dict_t *lspdb);
 int lsp_tick(struct thread *thread);
 
@@ -42,6 +42,7 @@ DEFINE_MTYPE(ISISD, ISIS_NEXTHOP, "ISIS nexthop")
 DEFINE_MTYPE(ISISD, ISIS_NEXTHOP6, "ISIS nexthop6")
 DEFINE_MTYPE(ISISD, ISIS_DICT, "ISIS dictionary")
 DEFINE_MTYPE(ISISD, ISIS_DICT_NODE, "ISIS dictionary node")
+DEFINE_MTYPE(ISISD, ISIS_DICT_INDEX, "ISIS dictionary index")
 DEFINE_MTYPE(ISISD, ISIS_EXT_ROUTE, "ISIS redistributed route")
 DEFINE_MTYPE(ISISD, ISIS_EXT_INFO, "ISIS redistributed route info")
 DEFINE_MTYPE(ISISD, ISIS_MPLS_TE, "ISIS MPLS_TE parameters")
@@ -41,6 +41,7 @@ DECLARE_MTYPE(ISIS_NEXTHOP)
 DECLARE_MTYPE(ISIS_NEXTHOP6)
 DECLARE_MTYPE(ISIS_DICT)
 DECLARE_MTYPE(ISIS_DICT_NODE)
+DECLARE_MTYPE(ISIS_DICT_INDEX)
 DECLARE_MTYPE(ISIS_EXT_ROUTE)
 DECLARE_MTYPE(ISIS_EXT_INFO)
 DECLARE_MTYPE(ISIS_MPLS_TE)
@@ -879,7 +879,21 @@ static int process_lsp(uint8_t pdu_type, struct isis_circuit *circuit,
 
 	/* Checksum sanity check - FIXME: move to correct place */
 	/* 12 = sysid+pdu+remtime */
-	if (iso_csum_verify(STREAM_DATA(circuit->rcv_stream) + 12,
+	/* If the database already holds a copy with the same seqno, checksum
+	 * and zero/nonzero remaining lifetime, this is a flooding duplicate
+	 * of an LSP whose checksum was verified when it was first accepted.
+	 * Skip the fletcher computation over the body for those; a corrupted
+	 * duplicate is still caught by TLV parsing and authentication below.
+	 */
+	struct isis_lsp *lsp =
+		lsp_search(hdr.lsp_id, circuit->area->lspdb[level - 1]);
+	bool csum_checked = lsp && lsp->hdr.seqno == hdr.seqno
+			    && lsp->hdr.checksum == hdr.checksum
+			    && (lsp->hdr.rem_lifetime != 0)
+				       == (hdr.rem_lifetime != 0);
+
+	if (!csum_checked
+	    && iso_csum_verify(STREAM_DATA(circuit->rcv_stream) + 12,
 			    hdr.pdu_len - 12, hdr.checksum, 12)) {
 		zlog_debug(
 			"ISIS-Upd (%s): LSP %s invalid LSP checksum 0x%04" PRIx16,
@@ -956,10 +970,8 @@ static int process_lsp(uint8_t pdu_type, struct isis_circuit *circuit,
 		goto out;
 	}
 
-	/* Find the LSP in our database and compare it to this Link State header
-	 */
-	struct isis_lsp *lsp =
-		lsp_search(hdr.lsp_id, circuit->area->lspdb[level - 1]);
+	/* Compare the LSP found in our database above to this Link State
+	 * header */
 	int comp = 0;
 	if (lsp)
 		comp = lsp_compare(circuit->area->area_tag, lsp, hdr.seqno,
@@ -1049,11 +1061,8 @@ dontcheckadj:
 					lsp_flood_or_update(lsp, NULL,
 							    circuit_scoped);
 					/* v */
-					ISIS_FLAGS_CLEAR_ALL(
-						lsp->SSNflags); /* FIXME:
-								   OTHER
-								   than c
-								   */
+					/* FIXME: OTHER than c */
+					isis_lsp_ssn_clear_all(lsp);
 
 					/* For the case of lsp confusion, flood
 					 * the purge back to its
@@ -1068,9 +1077,8 @@ dontcheckadj:
 						/* iv */
 						if (circuit->circ_type
 						    != CIRCUIT_T_BROADCAST)
-							ISIS_SET_FLAG(
-								lsp->SSNflags,
-								circuit);
+							isis_lsp_ssn_set(
+								lsp, circuit);
 					}
 				} /* 7.3.16.4 b) 2) */
 				else if (comp == LSP_EQUAL) {
@@ -1080,13 +1088,13 @@ dontcheckadj:
 					/* ii */
 					if (circuit->circ_type
 					    != CIRCUIT_T_BROADCAST)
-						ISIS_SET_FLAG(lsp->SSNflags,
-							      circuit);
+						isis_lsp_ssn_set(lsp,
+								 circuit);
 				} /* 7.3.16.4 b) 3) */
 				else {
 					isis_tx_queue_add(circuit->tx_queue,
 							  lsp, TX_LSP_NORMAL);
-					ISIS_CLEAR_FLAG(lsp->SSNflags, circuit);
+					isis_lsp_ssn_clear(lsp, circuit);
 				}
 			} else if (lsp->hdr.rem_lifetime != 0) {
 				/* our own LSP -> 7.3.16.4 c) */
@@ -1107,7 +1115,7 @@ dontcheckadj:
 				} else {
 					isis_tx_queue_add(circuit->tx_queue,
 							  lsp, TX_LSP_NORMAL);
-					ISIS_CLEAR_FLAG(lsp->SSNflags, circuit);
+					isis_lsp_ssn_clear(lsp, circuit);
 				}
 				if (isis->debugs & DEBUG_UPDATE_PACKETS)
 					zlog_debug(
@@ -1164,11 +1172,11 @@ dontcheckadj:
 		} else if (comp == LSP_EQUAL) {
 			isis_tx_queue_del(circuit->tx_queue, lsp);
 			if (circuit->circ_type != CIRCUIT_T_BROADCAST)
-				ISIS_SET_FLAG(lsp->SSNflags, circuit);
+				isis_lsp_ssn_set(lsp, circuit);
 		} else {
 			isis_tx_queue_add(circuit->tx_queue, lsp,
 					  TX_LSP_NORMAL);
-			ISIS_CLEAR_FLAG(lsp->SSNflags, circuit);
+			isis_lsp_ssn_clear(lsp, circuit);
 		}
 	} else {
 		/* 7.3.15.1 e) - This lsp originated on another system */
@@ -1211,7 +1219,7 @@ dontcheckadj:
 
 			/* iv */
 			if (circuit->circ_type != CIRCUIT_T_BROADCAST)
-				ISIS_SET_FLAG(lsp->SSNflags, circuit);
+				isis_lsp_ssn_set(lsp, circuit);
 			/* FIXME: v) */
 		}
 		/* 7.3.15.1 e) 2) LSP equal to the one in db */
@@ -1221,13 +1229,13 @@ dontcheckadj:
 				   circuit->area, level, false);
 			tlvs = NULL;
 			if (circuit->circ_type != CIRCUIT_T_BROADCAST)
-				ISIS_SET_FLAG(lsp->SSNflags, circuit);
+				isis_lsp_ssn_set(lsp, circuit);
 		}
 		/* 7.3.15.1 e) 3) LSP older than the one in db */
 		else {
 			isis_tx_queue_add(circuit->tx_queue, lsp,
 					  TX_LSP_NORMAL);
-			ISIS_CLEAR_FLAG(lsp->SSNflags, circuit);
+			isis_lsp_ssn_clear(lsp, circuit);
 		}
 	}
 
@@ -1432,7 +1440,7 @@ static int process_snp(uint8_t pdu_type, struct isis_circuit *circuit,
 			/* 7.3.15.2 b) 3) if it is older, clear SSN and set SRM
 			   */
 			else if (cmp == LSP_OLDER) {
-				ISIS_CLEAR_FLAG(lsp->SSNflags, circuit);
+				isis_lsp_ssn_clear(lsp, circuit);
 				isis_tx_queue_add(circuit->tx_queue, lsp,
 						  TX_LSP_NORMAL);
 			}
@@ -1444,7 +1452,7 @@ static int process_snp(uint8_t pdu_type, struct isis_circuit *circuit,
 					isis_tx_queue_add(circuit->tx_queue, lsp,
 							TX_LSP_NORMAL);
 				} else {
-					ISIS_SET_FLAG(lsp->SSNflags, circuit);
+					isis_lsp_ssn_set(lsp, circuit);
 					/* if (circuit->circ_type !=
 					 * CIRCUIT_T_BROADCAST) */
 					isis_tx_queue_del(circuit->tx_queue, lsp);
@@ -1481,7 +1489,7 @@ static int process_snp(uint8_t pdu_type, struct isis_circuit *circuit,
 					   circuit->area->lspdb[level - 1]);
 
 				lsp_set_all_srmflags(lsp, false);
-				ISIS_SET_FLAG(lsp->SSNflags, circuit);
+				isis_lsp_ssn_set(lsp, circuit);
 				resync_needed = true;
 			}
 		}
@@ -1711,11 +1719,22 @@ int isis_handle_pdu(struct isis_circuit *circuit, uint8_t *ssnpa)
 	return retval;
 }
 
+/* Reading more than one PDU per ready event saves a trip through the
+ * event loop for every packet of a flooding burst.  Only the pf_packet
+ * method reads without blocking, so only there can we safely try for
+ * more than one.
+ */
+#if ISIS_METHOD == ISIS_METHOD_PFPACKET
+#define ISIS_READ_BATCH 16
+#else
+#define ISIS_READ_BATCH 1
+#endif
+
 int isis_receive(struct thread *thread)
 {
 	struct isis_circuit *circuit;
 	uint8_t ssnpa[ETH_ALEN];
-	int retval;
+	int retval = ISIS_OK;
 
 	/*
 	 * Get the circuit
@@ -1725,15 +1744,20 @@ int isis_receive(struct thread *thread)
 
 	circuit->t_read = NULL;
 
-	isis_circuit_stream(circuit, &circuit->rcv_stream);
+	for (int count = 0; count < ISIS_READ_BATCH; count++) {
+		isis_circuit_stream(circuit, &circuit->rcv_stream);
 
-	retval = circuit->rx(circuit, ssnpa);
+		retval = circuit->rx(circuit, ssnpa);
 
 #if ISIS_METHOD != ISIS_METHOD_BPF
-	if (retval == ISIS_OK)
-		retval = isis_handle_pdu(circuit, ssnpa);
+		if (retval == ISIS_OK)
+			retval = isis_handle_pdu(circuit, ssnpa);
 #endif //ISIS_METHOD != ISIS_METHOD_BPF
 
+		if (retval != ISIS_OK)
+			break;
+	}
+
 	/*
 	 * prepare for next packet.
 	 */
@@ -2222,6 +2246,9 @@ static int send_psnp(int level, struct isis_circuit *circuit)
 	if (!circuit->snd_stream)
 		return ISIS_ERROR;
 
+	if (list_isempty(circuit->ssn_pending[level - 1]))
+		return ISIS_OK;
+
 	uint8_t pdu_type = (level == ISIS_LEVEL1) ? L1_PARTIAL_SEQ_NUM
 						  : L2_PARTIAL_SEQ_NUM;
 
@@ -2258,14 +2285,12 @@ static int send_psnp(int level, struct isis_circuit *circuit)
 		if (CHECK_FLAG(passwd->snp_auth, SNP_AUTH_SEND))
 			isis_tlvs_add_auth(tlvs, passwd);
 
-		for (dnode_t *dnode =
-			     dict_first(circuit->area->lspdb[level - 1]);
-		     dnode; dnode = dict_next(circuit->area->lspdb[level - 1],
-					      dnode)) {
-			struct isis_lsp *lsp = dnode_get(dnode);
+		struct listnode *node;
+		struct isis_lsp *lsp;
 
-			if (ISIS_CHECK_FLAG(lsp->SSNflags, circuit))
-				isis_tlvs_add_lsp_entry(tlvs, lsp);
+		for (ALL_LIST_ELEMENTS_RO(circuit->ssn_pending[level - 1],
+					  node, lsp)) {
+			isis_tlvs_add_lsp_entry(tlvs, lsp);
 
 			if (tlvs->lsp_entries.count == num_lsps)
 				break;
@@ -2316,7 +2341,7 @@ static int send_psnp(int level, struct isis_circuit *circuit)
 		entry_head = (struct isis_lsp_entry *)tlvs->lsp_entries.head;
 		for (struct isis_lsp_entry *entry = entry_head; entry;
 		     entry = entry->next)
-			ISIS_CLEAR_FLAG(entry->lsp->SSNflags, circuit);
+			isis_lsp_ssn_clear(entry->lsp, circuit);
 		isis_free_tlvs(tlvs);
 	}
 
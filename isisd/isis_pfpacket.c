@@ -230,9 +230,13 @@ int isis_recv_pdu_bcast(struct isis_circuit *circuit, uint8_t *ssnpa)
 
 	memset(&s_addr, 0, sizeof(struct sockaddr_ll));
 
-	bytesread =
-		recvfrom(circuit->fd, (void *)&llc, LLC_LEN, MSG_PEEK,
-			 (struct sockaddr *)&s_addr, (socklen_t *)&addr_len);
+	bytesread = recvfrom(circuit->fd, (void *)&llc, LLC_LEN,
+			     MSG_PEEK | MSG_DONTWAIT, (struct sockaddr *)&s_addr,
+			     (socklen_t *)&addr_len);
+
+	/* batched reads try one packet too many; not an error */
+	if (bytesread < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return ISIS_WARNING;
 
 	if ((bytesread < 0)
 	    || (s_addr.sll_ifindex != (int)circuit->interface->ifindex)) {
@@ -305,9 +309,17 @@ int isis_recv_pdu_p2p(struct isis_circuit *circuit, uint8_t *ssnpa)
 	addr_len = sizeof(s_addr);
 
 	/* we can read directly to the stream */
-	(void)stream_recvfrom(
-		circuit->rcv_stream, circuit->fd, circuit->interface->mtu, 0,
-		(struct sockaddr *)&s_addr, (socklen_t *)&addr_len);
+	bytesread = stream_recvfrom(
+		circuit->rcv_stream, circuit->fd, circuit->interface->mtu,
+		MSG_DONTWAIT, (struct sockaddr *)&s_addr,
+		(socklen_t *)&addr_len);
+
+	if (bytesread < 0) {
+		/* batched reads try one packet too many; not an error */
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+			zlog_warn("isis_recv_pdu_p2p(): recvfrom() failed");
+		return ISIS_WARNING;
+	}
 
 	if (s_addr.sll_pkttype == PACKET_OUTGOING) {
 		/*  Read the packet into discard buff */
@@ -756,66 +756,84 @@ lspfragloop:
 	return ISIS_OK;
 }
 
+static bool isis_spf_circuit_eligible(struct isis_spftree *spftree,
+				      struct isis_circuit *circuit)
+{
+	struct isis_circuit_mt_setting *circuit_mt;
+
+	circuit_mt = circuit_lookup_mt_setting(circuit, spftree->mtid);
+	if (circuit_mt && !circuit_mt->enabled)
+		return false;
+	if (circuit->state != C_STATE_UP)
+		return false;
+	if (!(circuit->is_type & spftree->level))
+		return false;
+	if (spftree->family == AF_INET && !circuit->ip_router)
+		return false;
+	if (spftree->family == AF_INET6 && !circuit->ipv6_router)
+		return false;
+	return true;
+}
+
+/*
+ * Add IP(v6) addresses of this circuit
+ */
+static void isis_spf_add_local_prefixes(struct isis_spftree *spftree,
+					struct isis_circuit *circuit,
+					struct isis_vertex *parent)
+{
+	struct listnode *ipnode;
+	struct prefix_ipv4 *ipv4;
+	struct prefix_ipv6 *ipv6;
+	struct prefix_pair ip_info;
+
+	if (spftree->hopcount_metric)
+		return;
+
+	if (spftree->family == AF_INET) {
+		memset(&ip_info, 0, sizeof(ip_info));
+		ip_info.dest.family = AF_INET;
+		for (ALL_LIST_ELEMENTS_RO(circuit->ip_addrs, ipnode, ipv4)) {
+			ip_info.dest.u.prefix4 = ipv4->prefix;
+			ip_info.dest.prefixlen = ipv4->prefixlen;
+			apply_mask(&ip_info.dest);
+			isis_spf_add_local(spftree, VTYPE_IPREACH_INTERNAL,
+					   &ip_info, NULL, 0, parent);
+		}
+	}
+	if (spftree->family == AF_INET6) {
+		memset(&ip_info, 0, sizeof(ip_info));
+		ip_info.dest.family = AF_INET6;
+		for (ALL_LIST_ELEMENTS_RO(circuit->ipv6_non_link, ipnode,
+					  ipv6)) {
+			ip_info.dest.u.prefix6 = ipv6->prefix;
+			ip_info.dest.prefixlen = ipv6->prefixlen;
+			apply_mask(&ip_info.dest);
+			isis_spf_add_local(spftree, VTYPE_IP6REACH_INTERNAL,
+					   &ip_info, NULL, 0, parent);
+		}
+	}
+}
+
 static int isis_spf_preload_tent(struct isis_spftree *spftree,
 				 uint8_t *root_sysid,
 				 struct isis_vertex *parent)
 {
 	struct isis_circuit *circuit;
-	struct listnode *cnode, *anode, *ipnode;
+	struct listnode *cnode, *anode;
 	struct isis_adjacency *adj;
 	struct isis_lsp *lsp;
 	struct list *adj_list;
 	struct list *adjdb;
-	struct prefix_ipv4 *ipv4;
-	struct prefix_pair ip_info;
 	int retval = ISIS_OK;
 	uint8_t lsp_id[ISIS_SYS_ID_LEN + 2];
 	static uint8_t null_lsp_id[ISIS_SYS_ID_LEN + 2];
-	struct prefix_ipv6 *ipv6;
-	struct isis_circuit_mt_setting *circuit_mt;
 
 	for (ALL_LIST_ELEMENTS_RO(spftree->area->circuit_list, cnode,
 				  circuit)) {
-		circuit_mt = circuit_lookup_mt_setting(circuit, spftree->mtid);
-		if (circuit_mt && !circuit_mt->enabled)
-			continue;
-		if (circuit->state != C_STATE_UP)
-			continue;
-		if (!(circuit->is_type & spftree->level))
+		if (!isis_spf_circuit_eligible(spftree, circuit))
 			continue;
-		if (spftree->family == AF_INET && !circuit->ip_router)
-			continue;
-		if (spftree->family == AF_INET6 && !circuit->ipv6_router)
-			continue;
-		/*
-		 * Add IP(v6) addresses of this circuit
-		 */
-		if (spftree->family == AF_INET && !spftree->hopcount_metric) {
-			memset(&ip_info, 0, sizeof(ip_info));
-			ip_info.dest.family = AF_INET;
-			for (ALL_LIST_ELEMENTS_RO(circuit->ip_addrs, ipnode,
-						  ipv4)) {
-				ip_info.dest.u.prefix4 = ipv4->prefix;
-				ip_info.dest.prefixlen = ipv4->prefixlen;
-				apply_mask(&ip_info.dest);
-				isis_spf_add_local(spftree,
-						   VTYPE_IPREACH_INTERNAL,
-						   &ip_info, NULL, 0, parent);
-			}
-		}
-		if (spftree->family == AF_INET6 && !spftree->hopcount_metric) {
-			memset(&ip_info, 0, sizeof(ip_info));
-			ip_info.dest.family = AF_INET6;
-			for (ALL_LIST_ELEMENTS_RO(circuit->ipv6_non_link,
-						  ipnode, ipv6)) {
-				ip_info.dest.u.prefix6 = ipv6->prefix;
-				ip_info.dest.prefixlen = ipv6->prefixlen;
-				apply_mask(&ip_info.dest);
-				isis_spf_add_local(spftree,
-						   VTYPE_IP6REACH_INTERNAL,
-						   &ip_info, NULL, 0, parent);
-			}
-		}
+		isis_spf_add_local_prefixes(spftree, circuit, parent);
 		if (circuit->circ_type == CIRCUIT_T_BROADCAST) {
 			/*
 			 * Add the adjacencies
@@ -1037,6 +1055,7 @@ static void init_spt(struct isis_spftree *spftree, int mtid, int level,
 {
 	isis_vertex_queue_clear(&spftree->tents);
 	isis_vertex_queue_clear(&spftree->paths);
+	spftree->tree_valid = false;
 
 	spftree->mtid = mtid;
 	spftree->level = level;
@@ -1078,6 +1097,79 @@ static void isis_spf_loop(struct isis_spftree *spftree,
 	}
 }
 
+/*
+ * Recompute only the IP leaves of the previously computed SPT.  The IS
+ * topology is untouched: every IS vertex keeps its distance, depth and
+ * nexthops.  The prefix vertices are dropped and re-derived from the
+ * local circuits and from the reachability TLVs of the LSPs already on
+ * the tree.  Returns false if the retained tree cannot be reused and a
+ * full run is needed instead.
+ */
+static bool isis_partial_spf_run(struct isis_spftree *spftree, uint8_t *sysid)
+{
+	struct isis_vertex *vertex, *root;
+	struct listnode *node, *nnode, *cnode;
+	struct isis_circuit *circuit;
+	struct isis_lsp *lsp;
+
+	if (!spftree->tree_valid)
+		return false;
+
+	if (list_isempty(spftree->paths.l.list))
+		return false;
+
+	/* The root IS is always the first element of PATHS. */
+	root = listgetdata(listhead(spftree->paths.l.list));
+	if (!VTYPE_IS(root->type) || root->d_N != 0
+	    || memcmp(root->N.id, sysid, ISIS_SYS_ID_LEN))
+		return false;
+
+	/* The tree is only replayable if every IS vertex on it still has
+	 * its LSP. */
+	for (ALL_QUEUE_ELEMENTS_RO(&spftree->paths, node, vertex)) {
+		if (vertex == root || !VTYPE_IS(vertex->type))
+			continue;
+		if (!lsp_for_vertex(spftree, vertex))
+			return false;
+	}
+
+	/* Drop all IP leaves; they are re-derived below.  IP vertices are
+	 * never parents of other vertices, so the remaining tree stays
+	 * consistent. */
+	for (ALL_LIST_ELEMENTS(spftree->paths.l.list, node, nnode, vertex)) {
+		if (!VTYPE_IP(vertex->type))
+			continue;
+		hash_release(spftree->paths.hash, vertex);
+		list_delete_node(spftree->paths.l.list, node);
+		isis_vertex_del(vertex);
+	}
+
+	/* Local prefixes first, as in isis_spf_preload_tent(), so that
+	 * they shadow any remote advertisement of the same prefix... */
+	for (ALL_LIST_ELEMENTS_RO(spftree->area->circuit_list, cnode,
+				  circuit)) {
+		if (!isis_spf_circuit_eligible(spftree, circuit))
+			continue;
+		isis_spf_add_local_prefixes(spftree, circuit, root);
+	}
+
+	/* ...then the reachability TLVs of every LSP on the tree.  The IS
+	 * neighbors visited by isis_spf_process_lsp() are already on
+	 * PATHS and get skipped in process_N(); only prefixes enter
+	 * TENT. */
+	for (ALL_QUEUE_ELEMENTS_RO(&spftree->paths, node, vertex)) {
+		if (vertex == root || !VTYPE_IS(vertex->type))
+			continue;
+		lsp = lsp_for_vertex(spftree, vertex);
+		isis_spf_process_lsp(spftree, lsp, vertex->d_N, vertex->depth,
+				     sysid, vertex);
+	}
+
+	isis_spf_loop(spftree, sysid);
+
+	return true;
+}
+
 struct isis_spftree *isis_run_hopcount_spf(struct isis_area *area,
 					   uint8_t *sysid,
 					   struct isis_spftree *spftree)
@@ -1139,6 +1231,19 @@ static int isis_run_spf(struct isis_area *area, int level,
 	assert(spftree);
 	assert(sysid);
 
+	/* If every LSP change since the last run only touched prefix
+	 * reachability, replace just the IP leaves on the retained tree
+	 * instead of recomputing the whole SPT. */
+	if (area->spf_pending_leaf_only[level - 1] && spftree->mtid == mtid
+	    && spftree->family == family
+	    && isis_partial_spf_run(spftree, sysid)) {
+		if (isis->debugs & DEBUG_SPF_EVENTS)
+			zlog_debug(
+				"ISIS-Spf (%s) L%d leaf-only changes, did partial SPF",
+				area->area_tag, level);
+		goto out;
+	}
+
 	/*
 	 * C.2.5 Step 0
 	 */
@@ -1164,6 +1269,8 @@ static int isis_run_spf(struct isis_area *area, int level,
 
 	isis_spf_loop(spftree, sysid);
 out:
+	if (retval == ISIS_OK)
+		spftree->tree_valid = true;
 	spftree->runcount++;
 	spftree->last_run_timestamp = time(NULL);
 	spftree->last_run_monotime = monotime(&time_now);
@@ -1235,6 +1342,10 @@ static int isis_run_spf_cb(struct thread *thread)
 
 	fabricd_run_spf(area);
 
+	/* Everything scheduled so far has been computed; until the next
+	 * structural event a leaf-only run will do. */
+	area->spf_pending_leaf_only[level - 1] = true;
+
 	return retval;
 }
 
@@ -1248,6 +1359,14 @@ static struct isis_spf_run *isis_run_spf_arg(struct isis_area *area, int level)
 	return run;
 }
 
+/* Mark the next isis_spf_schedule() call as covering a change to prefix
+ * reachability only, making the scheduled run eligible for a leaf-only
+ * recomputation. */
+void isis_spf_schedule_hint_leaf_only(struct isis_area *area, int level)
+{
+	area->spf_hint_leaf_only[level - 1] = true;
+}
+
 int _isis_spf_schedule(struct isis_area *area, int level,
 		       const char *func, const char *file, int line)
 {
@@ -1258,6 +1377,12 @@ int _isis_spf_schedule(struct isis_area *area, int level,
 	assert(diff >= 0);
 	assert(area->is_type & level);
 
+	/* A leaf-only hint covers just the event that raised it; any
+	 * unhinted schedule invalidates a pending partial run. */
+	if (!area->spf_hint_leaf_only[level - 1])
+		area->spf_pending_leaf_only[level - 1] = false;
+	area->spf_hint_leaf_only[level - 1] = false;
+
 	if (isis->debugs & DEBUG_SPF_EVENTS) {
 		zlog_debug(
 			"ISIS-Spf (%s) L%d SPF schedule called, lastrun %d sec ago"
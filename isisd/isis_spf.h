@@ -39,6 +39,7 @@ void spftree_area_adj_del(struct isis_area *area, struct isis_adjacency *adj);
 			   __FILE__, __LINE__)
 int _isis_spf_schedule(struct isis_area *area, int level,
 		       const char *func, const char *file, int line);
+void isis_spf_schedule_hint_leaf_only(struct isis_area *area, int level);
 void isis_spf_cmds_init(void);
 void isis_spf_print(struct isis_spftree *spftree, struct vty *vty);
 struct isis_spftree *isis_run_hopcount_spf(struct isis_area *area,
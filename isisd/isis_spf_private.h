@@ -308,6 +308,9 @@ struct isis_spftree {
 	int level;
 	enum spf_tree_id tree_id;
 	bool hopcount_metric;
+	/* PATHS holds a completed run and may be reused for a leaf-only
+	 * recomputation */
+	bool tree_valid;
 };
 
 __attribute__((__unused__))
@@ -2772,6 +2772,15 @@ static void update_auth(struct isis_tlvs *tlvs, struct stream *s, bool is_lsp)
 	}
 }
 
+/* Refresh the authentication TLV digest in an already packed PDU.  Only
+ * valid if the stream was produced by isis_pack_tlvs() with these TLVs,
+ * so that the offsets recorded in the auth items still match. */
+void isis_tlvs_update_auth(struct isis_tlvs *tlvs, struct stream *stream,
+			   bool is_lsp)
+{
+	update_auth(tlvs, stream, is_lsp);
+}
+
 static int handle_pack_entry(struct pack_order_entry *pe,
 			     struct isis_tlvs *tlvs, struct stream *stream,
 			     struct isis_tlvs **fragment_tlvs,
@@ -178,6 +178,14 @@ struct isis_area {
 							    parameters*/
 	struct thread *spf_timer[ISIS_LEVELS];
 
+	/* Every LSP change since the last SPF run only touched prefix
+	 * reachability, so a leaf-only recomputation on the retained
+	 * tree is sufficient.  The hint is a one-shot flag raised by the
+	 * LSP update path just before isis_spf_schedule() and consumed
+	 * there; any unhinted schedule clears the pending flag. */
+	bool spf_pending_leaf_only[ISIS_LEVELS];
+	bool spf_hint_leaf_only[ISIS_LEVELS];
+
 	struct lsp_refresh_arg lsp_refresh_arg[ISIS_LEVELS];
 
 	pdu_counter_t pdu_tx_counters;
@@ -227,12 +227,57 @@ lde_imsg_compose_parent_sync(int type, pid_t pid, void *data, uint16_t datalen)
 	imsg_flush(&iev_main_sync->ibuf);
 }
 
+/*
+ * Per-FEC label messages dominate the imsg traffic during a session sync.
+ * Batch consecutive struct map payloads of the same type for the same
+ * neighbor into a single imsg, so the imsg header, buffer allocation and
+ * write are paid once per batch instead of once per FEC.  Any other
+ * message to ldpe flushes the pending batch first to preserve ordering.
+ */
+#define LDE_MAP_BATCH_MAX \
+	((MAX_IMSGSIZE - IMSG_HEADER_SIZE) / sizeof(struct map))
+
+static struct map	 map_batch[LDE_MAP_BATCH_MAX];
+static size_t		 map_batch_count;
+static int		 map_batch_type;
+static uint32_t		 map_batch_peerid;
+
+static void
+lde_imsg_flush_maps(void)
+{
+	if (map_batch_count == 0)
+		return;
+
+	imsg_compose_event(iev_ldpe, map_batch_type, map_batch_peerid, 0, -1,
+	    map_batch, map_batch_count * sizeof(struct map));
+	map_batch_count = 0;
+}
+
+void
+lde_imsg_compose_ldpe_map(int type, uint32_t peerid, struct map *map)
+{
+	if (iev_ldpe->ibuf.fd == -1)
+		return;
+
+	if (map_batch_count > 0
+	    && (type != map_batch_type || peerid != map_batch_peerid))
+		lde_imsg_flush_maps();
+
+	map_batch_type = type;
+	map_batch_peerid = peerid;
+	map_batch[map_batch_count++] = *map;
+
+	if (map_batch_count == LDE_MAP_BATCH_MAX)
+		lde_imsg_flush_maps();
+}
+
 int
 lde_imsg_compose_ldpe(int type, uint32_t peerid, pid_t pid, void *data,
     uint16_t datalen)
 {
 	if (iev_ldpe->ibuf.fd == -1)
 		return (0);
+	lde_imsg_flush_maps();
 	return (imsg_compose_event(iev_ldpe, type, peerid, pid,
 	     -1, data, datalen));
 }
@@ -976,8 +1021,7 @@ lde_send_labelmapping(struct lde_nbr *ln, struct fec_node *fn, int single)
 	}
 
 	/* SL.4: send label mapping */
-	lde_imsg_compose_ldpe(IMSG_MAPPING_ADD, ln->peerid, 0,
-	    &map, sizeof(map));
+	lde_imsg_compose_ldpe_map(IMSG_MAPPING_ADD, ln->peerid, &map);
 	if (single)
 		lde_imsg_compose_ldpe(IMSG_MAPPING_ADD_END, ln->peerid, 0,
 		    NULL, 0);
@@ -1031,8 +1075,7 @@ lde_send_labelwithdraw(struct lde_nbr *ln, struct fec_node *fn,
 	}
 
 	/* SWd.1: send label withdraw. */
-	lde_imsg_compose_ldpe(IMSG_WITHDRAW_ADD, ln->peerid, 0,
- 	    &map, sizeof(map));
+	lde_imsg_compose_ldpe_map(IMSG_WITHDRAW_ADD, ln->peerid, &map);
 	lde_imsg_compose_ldpe(IMSG_WITHDRAW_ADD_END, ln->peerid, 0, NULL, 0);
 
 	/* SWd.2: record label withdraw. */
@@ -1145,8 +1188,7 @@ lde_send_labelrelease(struct lde_nbr *ln, struct fec_node *fn,
 		memcpy(&map, wcard, sizeof(map));
 	map.label = label;
 
-	lde_imsg_compose_ldpe(IMSG_RELEASE_ADD, ln->peerid, 0,
-	    &map, sizeof(map));
+	lde_imsg_compose_ldpe_map(IMSG_RELEASE_ADD, ln->peerid, &map);
 	lde_imsg_compose_ldpe(IMSG_RELEASE_ADD_END, ln->peerid, 0, NULL, 0);
 }
 
@@ -1383,14 +1425,29 @@ lde_map_compare(const struct lde_map *a, const struct lde_map *b)
 	    (union ldpd_addr *)&b->nexthop->id));
 }
 
+#define LDE_MAP_POOL_MAX	4096
+
+static struct fec	*lde_map_pool;
+static size_t		 lde_map_pool_count;
+
 struct lde_map *
 lde_map_add(struct lde_nbr *ln, struct fec_node *fn, int sent)
 {
 	struct lde_map  *me;
 
-	me = calloc(1, sizeof(*me));
-	if (me == NULL)
-		fatal(__func__);
+	/* like the fec_node pool in lde_lib.c: mapping entries churn with
+	 * every label message, so recycle them through a bounded free list
+	 * chained via fec.hnext */
+	if (lde_map_pool) {
+		me = (struct lde_map *)lde_map_pool;
+		lde_map_pool = lde_map_pool->hnext;
+		lde_map_pool_count--;
+		memset(me, 0, sizeof(*me));
+	} else {
+		me = calloc(1, sizeof(*me));
+		if (me == NULL)
+			fatal(__func__);
+	}
 
 	me->fec = fn->fec;
 	me->nexthop = ln;
@@ -1430,7 +1487,13 @@ lde_map_free(void *ptr)
 	struct lde_map	*map = ptr;
 
 	RB_REMOVE(lde_map_head, map->head, map);
-	free(map);
+
+	if (lde_map_pool_count < LDE_MAP_POOL_MAX) {
+		map->fec.hnext = lde_map_pool;
+		lde_map_pool = &map->fec;
+		lde_map_pool_count++;
+	} else
+		free(map);
 }
 
 struct fec *
@@ -1653,14 +1716,17 @@ lde_del_label_chunk(void *val)
 	free(val);
 }
 
+static uint32_t	 label_chunk_size = CHUNK_SIZE;
+
 static int
 lde_get_label_chunk(void)
 {
 	int		 ret;
 	uint32_t	 start, end;
 
-	debug_labels("getting label chunk (size %u)", CHUNK_SIZE);
-	ret = lm_get_label_chunk(zclient_sync, 0, CHUNK_SIZE, &start, &end);
+	debug_labels("getting label chunk (size %u)", label_chunk_size);
+	ret = lm_get_label_chunk(zclient_sync, 0, label_chunk_size, &start,
+	    &end);
 	if (ret < 0) {
 		log_warnx("Error getting label chunk!");
 		return -1;
@@ -1699,7 +1765,7 @@ on_get_label_chunk_response(uint32_t start, uint32_t end)
 
 	new_label_chunk->start = start;
 	new_label_chunk->end = end;
-	new_label_chunk->used_mask = 0;
+	new_label_chunk->used = 0;
 
 	listnode_add(label_chunk_list, (void *)new_label_chunk);
 
@@ -1712,8 +1778,6 @@ static uint32_t
 lde_get_next_label(void)
 {
 	struct label_chunk	*label_chunk;
-	uint32_t		 i, size;
-	uint64_t		 pos;
 	uint32_t		 label = NO_LABEL;
 
 	while (current_label_chunk) {
@@ -1721,14 +1785,12 @@ lde_get_next_label(void)
 		if (!label_chunk)
 			goto end;
 
-		/* try to get next free label in currently used label chunk */
-		size = label_chunk->end - label_chunk->start + 1;
-		for (i = 0, pos = 1; i < size; i++, pos <<= 1) {
-			if (!(pos & label_chunk->used_mask)) {
-				label_chunk->used_mask |= pos;
-				label = label_chunk->start + i;
-				goto end;
-			}
+		/* labels are never handed back, so a cursor into the chunk
+		   is all the bookkeeping needed */
+		if (label_chunk->start + label_chunk->used <=
+		    label_chunk->end) {
+			label = label_chunk->start + label_chunk->used++;
+			goto end;
 		}
 		current_label_chunk = listnextnode(current_label_chunk);
 	}
@@ -1739,6 +1801,13 @@ end:
 	if (!current_label_chunk ||
 	    current_label_chunk == listtail(label_chunk_list) ||
 	    label == NO_LABEL) {
+		/* sustained demand: double the prefetch so the zapi
+		   round trip is paid once per chunk, not per 64 labels */
+		if (label_chunk_size < CHUNK_SIZE_MAX) {
+			label_chunk_size *= 2;
+			if (label_chunk_size > CHUNK_SIZE_MAX)
+				label_chunk_size = CHUNK_SIZE_MAX;
+		}
 		if (lde_get_label_chunk() != 0)
 			log_warn("%s: Error getting label chunk!", __func__);
 
@@ -33,6 +33,9 @@ enum fec_type {
 
 struct fec {
 	RB_ENTRY(fec)		entry;
+	/* hash index bucket chain; only maintained for entries of the
+	 * global LIB tree (see fec_insert()) */
+	struct fec		*hnext;
 	enum fec_type		type;
 	union {
 		struct {
@@ -126,10 +129,14 @@ struct fec_node {
 };
 
 #define CHUNK_SIZE		64
+/* every exhausted chunk doubles the next request up to this size, so a
+ * large LIB population quickly stops round-tripping to the label
+ * manager for every 64 labels */
+#define CHUNK_SIZE_MAX		16384
 struct label_chunk {
 	uint32_t		 start;
 	uint32_t		 end;
-	uint64_t		 used_mask;
+	uint32_t		 used;
 };
 
 #define LDE_GC_INTERVAL 300
@@ -145,6 +152,7 @@ void		 lde_init(struct ldpd_init *);
 int		 lde_imsg_compose_parent(int, pid_t, void *, uint16_t);
 void		 lde_imsg_compose_parent_sync(int, pid_t, void *, uint16_t);
 int		 lde_imsg_compose_ldpe(int, uint32_t, pid_t, void *, uint16_t);
+void		 lde_imsg_compose_ldpe_map(int, uint32_t, struct map *);
 int		 lde_acl_check(char *, int, union ldpd_addr *, uint8_t);
 uint32_t	 lde_update_label(struct fec_node *);
 void		 lde_send_change_klabel(struct fec_node *, struct fec_nh *);
@@ -23,6 +23,7 @@
 #include "lde.h"
 #include "log.h"
 
+#include "jhash.h"
 #include "mpls.h"
 
 static __inline int	 fec_compare(const struct fec *, const struct fec *);
@@ -46,6 +47,95 @@ fec_init(struct fec_tree *fh)
 	RB_INIT(fec_tree, fh);
 }
 
+/*
+ * Exact-match hash index in front of the global LIB tree.  Almost every
+ * lookup against ft is an exact match, and with hundreds of thousands of
+ * FECs the red-black tree walk dominates; the index answers those in one
+ * bucket probe.  The per-neighbor trees keep using the plain tree.  The
+ * table grows by doubling and entries are chained through fec->hnext.
+ */
+#define FT_HINDEX_INITIAL_SIZE	512
+
+static struct fec	**ft_htable;
+static size_t		  ft_hsize;
+static size_t		  ft_hcount;
+
+static uint32_t
+fec_hash(const struct fec *fec)
+{
+	switch (fec->type) {
+	case FEC_TYPE_IPV4:
+		return (jhash_2words(fec->u.ipv4.prefix.s_addr,
+		    fec->u.ipv4.prefixlen, 0x55aa5a5a));
+	case FEC_TYPE_IPV6:
+		return (jhash2((const uint32_t *)&fec->u.ipv6.prefix,
+		    sizeof(struct in6_addr) / sizeof(uint32_t),
+		    fec->u.ipv6.prefixlen));
+	case FEC_TYPE_PWID:
+		return (jhash_3words(fec->u.pwid.type, fec->u.pwid.pwid,
+		    fec->u.pwid.lsr_id.s_addr, 0x55aa5a5a));
+	}
+
+	return (0);
+}
+
+static void
+ft_hindex_grow(void)
+{
+	struct fec	**htable;
+	struct fec	 *f, *next;
+	size_t		  hsize, i;
+
+	hsize = ft_htable ? ft_hsize * 2 : FT_HINDEX_INITIAL_SIZE;
+	htable = calloc(hsize, sizeof(*htable));
+	if (htable == NULL)
+		fatal(__func__);
+
+	for (i = 0; i < ft_hsize; i++) {
+		for (f = ft_htable[i]; f; f = next) {
+			next = f->hnext;
+			f->hnext = htable[fec_hash(f) & (hsize - 1)];
+			htable[fec_hash(f) & (hsize - 1)] = f;
+		}
+	}
+
+	free(ft_htable);
+	ft_htable = htable;
+	ft_hsize = hsize;
+}
+
+static void
+ft_hindex_insert(struct fec *f)
+{
+	size_t		 i;
+
+	if (ft_hcount >= ft_hsize)
+		ft_hindex_grow();
+
+	i = fec_hash(f) & (ft_hsize - 1);
+	f->hnext = ft_htable[i];
+	ft_htable[i] = f;
+	ft_hcount++;
+}
+
+static void
+ft_hindex_remove(struct fec *f)
+{
+	struct fec	**prev;
+
+	for (prev = &ft_htable[fec_hash(f) & (ft_hsize - 1)]; *prev;
+	    prev = &(*prev)->hnext) {
+		if (*prev == f) {
+			*prev = f->hnext;
+			f->hnext = NULL;
+			ft_hcount--;
+			return;
+		}
+	}
+
+	log_warnx("%s failed for %s", __func__, log_fec(f));
+}
+
 static __inline int
 fec_compare(const struct fec *a, const struct fec *b)
 {
@@ -103,6 +193,16 @@ fec_compare(const struct fec *a, const struct fec *b)
 struct fec *
 fec_find(struct fec_tree *fh, struct fec *f)
 {
+	struct fec	*entry;
+
+	if (fh == &ft && ft_htable) {
+		for (entry = ft_htable[fec_hash(f) & (ft_hsize - 1)]; entry;
+		    entry = entry->hnext)
+			if (fec_compare(f, entry) == 0)
+				return (entry);
+		return (NULL);
+	}
+
 	return (RB_FIND(fec_tree, fh, f));
 }
 
@@ -111,6 +211,8 @@ fec_insert(struct fec_tree *fh, struct fec *f)
 {
 	if (RB_INSERT(fec_tree, fh, f) != NULL)
 		return (-1);
+	if (fh == &ft)
+		ft_hindex_insert(f);
 	return (0);
 }
 
@@ -121,6 +223,8 @@ fec_remove(struct fec_tree *fh, struct fec *f)
 		log_warnx("%s failed for %s", __func__, log_fec(f));
 		return (-1);
 	}
+	if (fh == &ft)
+		ft_hindex_remove(f);
 	return (0);
 }
 
@@ -225,6 +329,17 @@ fec_snap(struct lde_nbr *ln)
 	lde_imsg_compose_ldpe(IMSG_MAPPING_ADD_END, ln->peerid, 0, NULL, 0);
 }
 
+/*
+ * Session resets churn through the whole LIB; recycle fec_node
+ * allocations through a bounded free list (chained via fec.hnext, which
+ * is unused while a node is out of the tree) instead of hitting malloc
+ * for every FEC.
+ */
+#define FEC_NODE_POOL_MAX	4096
+
+static struct fec	*fec_node_pool;
+static size_t		 fec_node_pool_count;
+
 static void
 fec_free(void *arg)
 {
@@ -242,7 +357,12 @@ fec_free(void *arg)
 		log_warnx("%s: fec %s upstream list not empty", __func__,
 		    log_fec(&fn->fec));
 
-	free(fn);
+	if (fec_node_pool_count < FEC_NODE_POOL_MAX) {
+		fn->fec.hnext = fec_node_pool;
+		fec_node_pool = &fn->fec;
+		fec_node_pool_count++;
+	} else
+		free(fn);
 }
 
 void
@@ -256,9 +376,16 @@ fec_add(struct fec *fec)
 {
 	struct fec_node	*fn;
 
-	fn = calloc(1, sizeof(*fn));
-	if (fn == NULL)
-		fatal(__func__);
+	if (fec_node_pool) {
+		fn = (struct fec_node *)fec_node_pool;
+		fec_node_pool = fec_node_pool->hnext;
+		fec_node_pool_count--;
+		memset(fn, 0, sizeof(*fn));
+	} else {
+		fn = calloc(1, sizeof(*fn));
+		if (fn == NULL)
+			fatal(__func__);
+	}
 
 	fn->fec = *fec;
 	fn->local_label = NO_LABEL;
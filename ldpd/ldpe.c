@@ -564,6 +564,11 @@ ldpe_dispatch_main(struct thread *thread)
 	return (0);
 }
 
+/* Upper bound on imsgs handled per dispatch, so that a large label dump
+ * from lde cannot hold the event loop long enough to starve the hello
+ * and keepalive timers. */
+#define LDPE_IMSG_MAX_BATCH	128
+
 /* ARGSUSED */
 static int
 ldpe_dispatch_lde(struct thread *thread)
@@ -574,7 +579,8 @@ ldpe_dispatch_lde(struct thread *thread)
 	struct map		*map;
 	struct notify_msg	*nm;
 	struct nbr		*nbr;
-	int			 n, shut = 0;
+	size_t			 len;
+	int			 n, count = 0, shut = 0;
 
 	iev->ev_read = NULL;
 
@@ -583,7 +589,7 @@ ldpe_dispatch_lde(struct thread *thread)
 	if (n == 0)	/* connection closed */
 		shut = 1;
 
-	for (;;) {
+	while (count++ < LDPE_IMSG_MAX_BATCH) {
 		if ((n = imsg_get(ibuf, &imsg)) == -1)
 			fatal("ldpe_dispatch_lde: imsg_get error");
 		if (n == 0)
@@ -594,10 +600,11 @@ ldpe_dispatch_lde(struct thread *thread)
 		case IMSG_RELEASE_ADD:
 		case IMSG_REQUEST_ADD:
 		case IMSG_WITHDRAW_ADD:
-			if (imsg.hdr.len - IMSG_HEADER_SIZE !=
-			    sizeof(struct map))
+			/* lde batches consecutive maps of the same type and
+			 * neighbor into a single imsg */
+			len = imsg.hdr.len - IMSG_HEADER_SIZE;
+			if (len == 0 || len % sizeof(struct map) != 0)
 				fatalx("invalid size of map request");
-			map = imsg.data;
 
 			nbr = nbr_find_peerid(imsg.hdr.peerid);
 			if (nbr == NULL) {
@@ -608,19 +615,26 @@ ldpe_dispatch_lde(struct thread *thread)
 			if (nbr->state != NBR_STA_OPER)
 				break;
 
-			switch (imsg.hdr.type) {
-			case IMSG_MAPPING_ADD:
-				mapping_list_add(&nbr->mapping_list, map);
-				break;
-			case IMSG_RELEASE_ADD:
-				mapping_list_add(&nbr->release_list, map);
-				break;
-			case IMSG_REQUEST_ADD:
-				mapping_list_add(&nbr->request_list, map);
-				break;
-			case IMSG_WITHDRAW_ADD:
-				mapping_list_add(&nbr->withdraw_list, map);
-				break;
+			for (map = imsg.data; len >= sizeof(struct map);
+			    len -= sizeof(struct map), map++) {
+				switch (imsg.hdr.type) {
+				case IMSG_MAPPING_ADD:
+					mapping_list_add(&nbr->mapping_list,
+					    map);
+					break;
+				case IMSG_RELEASE_ADD:
+					mapping_list_add(&nbr->release_list,
+					    map);
+					break;
+				case IMSG_REQUEST_ADD:
+					mapping_list_add(&nbr->request_list,
+					    map);
+					break;
+				case IMSG_WITHDRAW_ADD:
+					mapping_list_add(&nbr->withdraw_list,
+					    map);
+					break;
+				}
 			}
 			break;
 		case IMSG_MAPPING_ADD_END:
@@ -688,9 +702,22 @@ ldpe_dispatch_lde(struct thread *thread)
 		}
 		imsg_free(&imsg);
 	}
-	if (!shut)
-		imsg_event_add(iev);
-	else {
+	if (!shut) {
+		if (count > LDPE_IMSG_MAX_BATCH) {
+			/* The batch limit was hit with more imsgs already
+			 * buffered.  Yield through the event queue instead of
+			 * re-adding the read event so hello and keepalive
+			 * timers get to run before the next batch; a large
+			 * label dump would otherwise monopolize the loop and
+			 * flap adjacencies. */
+			thread_add_event(master, iev->handler_read, iev, 0,
+			    &iev->ev_read);
+			if (iev->handler_write && iev->ibuf.w.queued)
+				thread_add_write(master, iev->handler_write,
+				    iev, iev->ibuf.fd, &iev->ev_write);
+		} else
+			imsg_event_add(iev);
+	} else {
 		/* this pipe is dead, so remove the event handlers and exit */
 		THREAD_READ_OFF(iev->ev_read);
 		THREAD_WRITE_OFF(iev->ev_write);
@@ -62,7 +62,74 @@ struct buffer_data {
    next page boundery. */
 #define BUFFER_SIZE_DEFAULT		4096
 
-#define BUFFER_DATA_FREE(D) XFREE(MTYPE_BUFFER_DATA, (D))
+/*
+ * Recycled chunk pools.  vty and zserv output allocate and free
+ * buffer_data chunks at a very high rate, nearly always in the same
+ * couple of sizes (one per buffer "size" in use), so freed chunks are
+ * parked on a small per-thread, per-size free list and handed back out
+ * by buffer_add() instead of round-tripping through the allocator.
+ * The caches are thread-local: a buffer is only ever used from one
+ * thread, so no locking is needed and no cache line bounces between
+ * threads.  A cache that is full (or a size class beyond the table)
+ * just falls through to XFREE as before.
+ */
+#define BUFFER_POOL_CLASSES 4  /* distinct chunk sizes cached per thread */
+#define BUFFER_POOL_DEPTH 32   /* chunks cached per size class */
+
+struct buffer_pool {
+	size_t size; /* chunk data size this class holds; 0 = unused */
+	unsigned int count;
+	struct buffer_data *free; /* chained through ->next */
+};
+
+static __thread struct buffer_pool buffer_pool[BUFFER_POOL_CLASSES];
+
+static struct buffer_data *buffer_data_new(size_t size)
+{
+	struct buffer_pool *pool;
+
+	for (pool = buffer_pool; pool < buffer_pool + BUFFER_POOL_CLASSES;
+	     pool++)
+		if (pool->size == size && pool->free) {
+			struct buffer_data *d = pool->free;
+
+			pool->free = d->next;
+			pool->count--;
+			return d;
+		}
+
+	return XMALLOC(MTYPE_BUFFER_DATA,
+		       offsetof(struct buffer_data, data) + size);
+}
+
+static void buffer_data_free(struct buffer *b, struct buffer_data *d)
+{
+	struct buffer_pool *pool, *unused = NULL;
+
+	for (pool = buffer_pool; pool < buffer_pool + BUFFER_POOL_CLASSES;
+	     pool++) {
+		if (pool->size == b->size) {
+			if (pool->count < BUFFER_POOL_DEPTH) {
+				d->next = pool->free;
+				pool->free = d;
+				pool->count++;
+				return;
+			}
+			break;
+		}
+		if (!pool->size && !unused)
+			unused = pool;
+	}
+	if (pool == buffer_pool + BUFFER_POOL_CLASSES && unused) {
+		unused->size = b->size;
+		d->next = NULL;
+		unused->free = d;
+		unused->count = 1;
+		return;
+	}
+
+	XFREE(MTYPE_BUFFER_DATA, d);
+}
 
 /* Make new buffer. */
 struct buffer *buffer_new(size_t size)
@@ -128,7 +195,7 @@ void buffer_reset(struct buffer *b)
 
 	for (data = b->head; data; data = next) {
 		next = data->next;
-		BUFFER_DATA_FREE(data);
+		buffer_data_free(b, data);
 	}
 	b->head = b->tail = NULL;
 }
@@ -138,8 +205,7 @@ static struct buffer_data *buffer_add(struct buffer *b)
 {
 	struct buffer_data *d;
 
-	d = XMALLOC(MTYPE_BUFFER_DATA,
-		    offsetof(struct buffer_data, data) + b->size);
+	d = buffer_data_new(b->size);
 	d->cp = d->sp = 0;
 	d->next = NULL;
 
@@ -228,28 +294,95 @@ void buffer_put_crlf(struct buffer *b, const void *origp, size_t origsize)
 	}
 }
 
+/* Flush the whole chunk chain with as few syscalls as possible: the
+   iovec is built once over every queued chunk and handed to writev() in
+   IOV_MAX-sized slices, resuming mid-vector after partial writes
+   instead of rebuilding it from the head each round.  Stops on error or
+   when the operation would block. */
+buffer_status_t buffer_writev(struct buffer *b, int fd)
+{
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+	struct iovec small_iov[16];
+	struct iovec *iov = small_iov, *cur;
+	struct buffer_data *d;
+	size_t niov = 0, left;
+	buffer_status_t ret = BUFFER_ERROR;
+
+	if (fd < 0)
+		return BUFFER_ERROR;
+
+	for (d = b->head; d; d = d->next)
+		niov++;
+	if (!niov)
+		return BUFFER_EMPTY;
+
+	if (niov > array_size(small_iov))
+		iov = XMALLOC(MTYPE_TMP, niov * sizeof(*iov));
+	niov = 0;
+	for (d = b->head; d; d = d->next) {
+		iov[niov].iov_base = d->data + d->sp;
+		iov[niov++].iov_len = d->cp - d->sp;
+	}
+
+	cur = iov;
+	left = niov;
+	while (left) {
+		ssize_t written;
+
+		written = writev(fd, cur,
+				 (left > IOV_MAX) ? IOV_MAX : (int)left);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			if (ERRNO_IO_RETRY(errno)) {
+				/* Kernel buffer full; caller retries later. */
+				ret = BUFFER_PENDING;
+				goto out;
+			}
+			flog_err(EC_LIB_SOCKET, "%s: writev to fd %d failed: %s",
+				 __func__, fd, safe_strerror(errno));
+			goto out;
+		}
+
+		/* Consume written data off the chain and the vector in
+		   lockstep; iovec entries map 1:1 onto chunks. */
+		while (written > 0) {
+			if (cur->iov_len <= (size_t)written) {
+				written -= cur->iov_len;
+				cur++;
+				left--;
+
+				d = b->head;
+				if (!(b->head = d->next))
+					b->tail = NULL;
+				buffer_data_free(b, d);
+			} else {
+				cur->iov_base =
+					(char *)cur->iov_base + written;
+				cur->iov_len -= written;
+				b->head->sp += written;
+				written = 0;
+			}
+		}
+	}
+	ret = b->head ? BUFFER_PENDING : BUFFER_EMPTY;
+
+out:
+	if (iov != small_iov)
+		XFREE(MTYPE_TMP, iov);
+	return ret;
+}
+
 /* Keep flushing data to the fd until the buffer is empty or an error is
    encountered or the operation would block. */
 buffer_status_t buffer_flush_all(struct buffer *b, int fd)
 {
-	buffer_status_t ret;
-	struct buffer_data *head;
-	size_t head_sp;
-
 	if (!b->head)
 		return BUFFER_EMPTY;
-	head_sp = (head = b->head)->sp;
-	/* Flush all data. */
-	while ((ret = buffer_flush_available(b, fd)) == BUFFER_PENDING) {
-		if ((b->head == head) && (head_sp == head->sp)
-		    && (errno != EINTR))
-			/* No data was flushed, so kernel buffer must be full.
-			 */
-			return ret;
-		head_sp = (head = b->head)->sp;
-	}
 
-	return ret;
+	return buffer_writev(b, fd);
 }
 
 /* Flush enough data to fill a terminal window of the given scene (used only
@@ -387,7 +520,7 @@ buffer_status_t buffer_flush_window(struct buffer *b, int fd, int width,
 		struct buffer_data *del;
 		if (!(b->head = (del = b->head)->next))
 			b->tail = NULL;
-		BUFFER_DATA_FREE(del);
+		buffer_data_free(b, del);
 	}
 
 	if (iov != small_iov)
@@ -461,7 +594,7 @@ in one shot. */
 		written -= (d->cp - d->sp);
 		if (!(b->head = d->next))
 			b->tail = NULL;
-		BUFFER_DATA_FREE(d);
+		buffer_data_free(b, d);
 	}
 
 	return b->head ? BUFFER_PENDING : BUFFER_EMPTY;
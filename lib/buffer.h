@@ -81,6 +81,12 @@ extern buffer_status_t buffer_write(struct buffer *, int fd, const void *,
    the queued data to the given file descriptor. */
 extern buffer_status_t buffer_flush_available(struct buffer *, int fd);
 
+/* Flush the entire queued chain in as few writev() syscalls as possible
+   (at most one per IOV_MAX chunks), resuming after partial writes
+   without rebuilding the io-vector.  Stops on error or when the
+   operation would block. */
+extern buffer_status_t buffer_writev(struct buffer *, int fd);
+
 /* The following 2 functions (buffer_flush_all and buffer_flush_window)
    are for use in lib/vty.c only.  They should not be used elsewhere. */
 
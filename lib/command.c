@@ -44,6 +44,7 @@
 #include "defaults.h"
 #include "libfrr.h"
 #include "jhash.h"
+#include "frr_pthread.h"
 #include "hook.h"
 #include "lib_errors.h"
 #include "northbound_cli.h"
@@ -577,6 +578,9 @@ static int config_write_host(struct vty *vty)
 			vty_out(vty, "log timestamp precision %d\n",
 				zlog_default->timestamp_precision);
 
+		if (zlog_async_get())
+			vty_out(vty, "log async\n");
+
 		if (host.advanced)
 			vty_out(vty, "service advanced-vty\n");
 
@@ -1056,6 +1060,12 @@ static int cmd_execute_command_real(vector vline, enum cmd_filter_type filter,
 		vty->num_cfg_changes = 0;
 		memset(&vty->cfg_changes, 0, sizeof(vty->cfg_changes));
 
+		/* Any command run from a configuration node may change
+		 * what the config callbacks emit; invalidate the cached
+		 * running-config sections. */
+		if (vty->node >= CONFIG_NODE)
+			cmd_config_gen_bump();
+
 		ret = matched_element->func(matched_element, vty, argc, argv);
 	}
 
@@ -1688,6 +1698,59 @@ DEFUN_HIDDEN(show_cli_graph,
 	return CMD_SUCCESS;
 }
 
+/* Generation counter the section cache is keyed by; bumped whenever
+ * configuration may have changed. */
+static uint64_t cmd_config_gen = 1;
+
+void cmd_config_gen_bump(void)
+{
+	cmd_config_gen++;
+}
+
+/* Emit one node's running-config section, served from the per-node
+ * cache when no configuration command has run since it was rendered.
+ * Sections are independent text, so a save on a box with hundreds of
+ * VRFs degenerates to one buffer copy per unchanged node instead of a
+ * full state walk.  The callbacks may branch on the session type, so a
+ * cache entry is only reused for the type it was rendered for; types
+ * whose vty_out() transforms the text (terminal CRLF expansion, the
+ * vtysh stdout shortcut) bypass the cache entirely.
+ */
+static int vty_write_config_node(struct vty *vty, struct cmd_node *node)
+{
+	struct vty *render;
+	int ret;
+
+	if (vty->type != VTY_SHELL_SERV && vty->type != VTY_FILE)
+		return (*node->func)(vty);
+
+	if (node->config_cache && node->config_cache_gen == cmd_config_gen
+	    && node->config_cache_type == (int)vty->type) {
+		if (node->config_cache[0] != '\0')
+			vty_out(vty, "%s", node->config_cache);
+		return node->config_cache_ret;
+	}
+
+	render = vty_new();
+	render->type = vty->type;
+	render->node = vty->node;
+
+	ret = (*node->func)(render);
+
+	XFREE(MTYPE_TMP, node->config_cache);
+	node->config_cache = buffer_getstr(render->obuf);
+	node->config_cache_gen = cmd_config_gen;
+	node->config_cache_type = vty->type;
+	node->config_cache_ret = ret;
+
+	buffer_reset(render->obuf);
+	vty_close(render);
+
+	if (node->config_cache[0] != '\0')
+		vty_out(vty, "%s", node->config_cache);
+	return ret;
+}
+
 static int vty_write_config(struct vty *vty)
 {
 	size_t i;
@@ -1708,7 +1771,7 @@ static int vty_write_config(struct vty *vty)
 	for (i = 0; i < vector_active(cmdvec); i++)
 		if ((node = vector_slot(cmdvec, i)) && node->func
 		    && (node->vtysh || vty->type != VTY_SHELL)) {
-			if ((*node->func)(vty))
+			if (vty_write_config_node(vty, node))
 				vty_out(vty, "!\n");
 		}
 
@@ -2610,6 +2673,27 @@ DEFUN (no_config_log_timestamp_precision,
 	return CMD_SUCCESS;
 }
 
+DEFUN (config_log_async,
+       config_log_async_cmd,
+       "log async",
+       "Logging control\n"
+       "Buffer logfile writes per thread and flush from a background thread\n")
+{
+	zlog_async_set(true);
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_config_log_async,
+       no_config_log_async_cmd,
+       "no log async",
+       NO_STR
+       "Logging control\n"
+       "Write the logfile synchronously from the logging thread\n")
+{
+	zlog_async_set(false);
+	return CMD_SUCCESS;
+}
+
 DEFUN (debug_memstats,
        debug_memstats_cmd,
        "[no] debug memstats-at-exit",
@@ -2827,6 +2911,7 @@ void cmd_init(int terminal)
 		thread_cmd_init();
 		workqueue_cmd_init();
 		hash_cmd_init();
+		frr_pthread_cmd_init();
 	}
 
 	install_element(CONFIG_NODE, &hostname_cmd);
@@ -2859,6 +2944,8 @@ void cmd_init(int terminal)
 				&config_log_timestamp_precision_cmd);
 		install_element(CONFIG_NODE,
 				&no_config_log_timestamp_precision_cmd);
+		install_element(CONFIG_NODE, &config_log_async_cmd);
+		install_element(CONFIG_NODE, &no_config_log_async_cmd);
 		install_element(CONFIG_NODE, &service_password_encrypt_cmd);
 		install_element(CONFIG_NODE, &no_service_password_encrypt_cmd);
 		install_element(CONFIG_NODE, &banner_motd_default_cmd);
@@ -2892,6 +2979,7 @@ void cmd_terminate(void)
 				hash_clean(cmd_node->cmd_hash, NULL);
 				hash_free(cmd_node->cmd_hash);
 				cmd_node->cmd_hash = NULL;
+				XFREE(MTYPE_TMP, cmd_node->config_cache);
 			}
 
 		vector_free(cmdvec);
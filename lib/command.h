@@ -177,6 +177,14 @@ struct cmd_node {
 
 	/* Hashed index of command node list, for de-dupping primarily */
 	struct hash *cmd_hash;
+
+	/* Cached running-config section: the text "func" rendered, the
+	 * global config generation it was rendered at and the vty type
+	 * it was rendered for.  See vty_write_config(). */
+	char *config_cache;
+	uint64_t config_cache_gen;
+	int config_cache_type;
+	int config_cache_ret;
 };
 
 /* Return value of the commands. */
@@ -462,6 +470,11 @@ extern void cmd_terminate(void);
 extern void cmd_exit(struct vty *vty);
 extern int cmd_list_cmds(struct vty *vty, int do_permute);
 
+/* Invalidate the cached running-config sections.  Commands executed
+ * from configuration nodes do this implicitly; subsystems that change
+ * configuration behind the CLI's back must call it themselves. */
+extern void cmd_config_gen_bump(void);
+
 extern int cmd_domainname_set(const char *domainname);
 extern int cmd_hostname_set(const char *hostname);
 extern const char *cmd_hostname_get(void);
@@ -31,6 +31,9 @@ DEFINE_MTYPE_STATIC(LIB, CMD_DESC, "Command Token Text")
 DEFINE_MTYPE_STATIC(LIB, CMD_TEXT, "Command Token Help")
 DEFINE_MTYPE(LIB, CMD_ARG, "Command Argument")
 DEFINE_MTYPE_STATIC(LIB, CMD_VAR, "Command Argument Name")
+DEFINE_MTYPE_STATIC(LIB, CMD_TOKEN_INDEX, "Command dispatch index")
+
+static void cmd_token_index_free(struct cmd_token *token);
 
 struct cmd_token *cmd_token_new(enum cmd_token_type type, uint8_t attr,
 				const char *text, const char *desc)
@@ -54,6 +57,8 @@ void cmd_token_del(struct cmd_token *token)
 	if (!token)
 		return;
 
+	cmd_token_index_free(token);
+
 	XFREE(MTYPE_CMD_TEXT, token->text);
 	XFREE(MTYPE_CMD_DESC, token->desc);
 	XFREE(MTYPE_CMD_ARG, token->arg);
@@ -102,6 +107,108 @@ void cmd_token_varname_set(struct cmd_token *token, const char *varname)
 	token->varname[len] = '\0';
 }
 
+static void cmd_token_index_free(struct cmd_token *token)
+{
+	if (!token->idx)
+		return;
+
+	vector_free(token->idx->words);
+	vector_free(token->idx->others);
+	XFREE(MTYPE_CMD_TOKEN_INDEX, token->idx);
+	token->idx = NULL;
+}
+
+/* collect the nodes reachable by one parser hop, treating plumbing
+ * tokens as transparent - same rule as the matcher's add_nexthops() */
+static void cmd_index_first_hops(struct cmd_token_index *idx,
+				 struct graph_node *node)
+{
+	for (unsigned int i = 0; i < vector_active(node->to); i++) {
+		struct graph_node *child = vector_slot(node->to, i);
+		struct cmd_token *tok = child->data;
+
+		if (tok->type >= SPECIAL_TKN && tok->type != END_TKN)
+			cmd_index_first_hops(idx, child);
+		else if (tok->type == WORD_TKN)
+			vector_set(idx->words, child);
+		else
+			vector_set(idx->others, child);
+	}
+}
+
+static int cmd_index_word_cmp(const void *a, const void *b)
+{
+	const struct graph_node *ga = *(const struct graph_node *const *)a;
+	const struct graph_node *gb = *(const struct graph_node *const *)b;
+	const struct cmd_token *ta = ga->data, *tb = gb->data;
+
+	return strcmp(ta->text, tb->text);
+}
+
+struct cmd_token_index *cmd_token_index_get(struct graph_node *start)
+{
+	struct cmd_token *token = start->data;
+	struct cmd_token_index *idx = token->idx;
+
+	assert(token->type == START_TKN);
+
+	if (idx)
+		return idx;
+
+	idx = XCALLOC(MTYPE_CMD_TOKEN_INDEX, sizeof(struct cmd_token_index));
+	idx->words = vector_init(VECTOR_MIN_SIZE);
+	idx->others = vector_init(VECTOR_MIN_SIZE);
+	cmd_index_first_hops(idx, start);
+	qsort(idx->words->index, vector_active(idx->words), sizeof(void *),
+	      cmd_index_word_cmp);
+
+	token->idx = idx;
+	return idx;
+}
+
+void cmd_token_index_range(const struct cmd_token_index *idx, const char *word,
+			   unsigned int *first, unsigned int *last)
+{
+	size_t len = strlen(word);
+	unsigned int lo, hi, mid;
+	struct cmd_token *tok;
+
+	/* lower bound: first entry >= word.  Entries with word as a strict
+	 * prefix are longer and thus sort behind it, so none are skipped. */
+	lo = 0;
+	hi = vector_active(idx->words);
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		tok = ((struct graph_node *)vector_slot(idx->words, mid))
+			      ->data;
+		if (strcmp(tok->text, word) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	*first = lo;
+
+	/* upper bound: first entry whose leading strlen(word) characters
+	 * already sort behind word (prefix comparison is monotonic over
+	 * the sorted array) */
+	hi = vector_active(idx->words);
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		tok = ((struct graph_node *)vector_slot(idx->words, mid))
+			      ->data;
+		if (strncmp(tok->text, word, len) <= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	*last = lo;
+}
+
+void cmd_token_index_invalidate(struct graph_node *start)
+{
+	cmd_token_index_free(start->data);
+}
+
 static bool cmd_nodes_link(struct graph_node *from, struct graph_node *to)
 {
 	for (size_t i = 0; i < vector_active(from->to); i++)
@@ -353,6 +460,9 @@ void cmd_graph_merge(struct graph *old, struct graph *new, int direction)
 	assert(vector_active(old->nodes) >= 1);
 	assert(vector_active(new->nodes) >= 1);
 
+	/* the first hops are about to change; drop the dispatch index */
+	cmd_token_index_invalidate(vector_slot(old->nodes, 0));
+
 	cmd_merge_nodes(old, new, vector_slot(old->nodes, 0),
 			vector_slot(new->nodes, 0), direction);
 }
@@ -90,8 +90,35 @@ struct cmd_token {
 	char *varname;
 
 	struct graph_node *forkjoin; // paired FORK/JOIN for JOIN/FORK
+
+	struct cmd_token_index *idx; // first-word dispatch for START_TKN
 };
 
+/**
+ * First-word dispatch index for a command graph.
+ *
+ * Hung off the START_TKN token of a graph and built lazily by the
+ * matcher.  The start node fans out into every command installed on the
+ * node (several hundred on the bigger ones); the index narrows the
+ * first input token down to the handful of first hops that can actually
+ * match it.  WORD_TKN hops are kept sorted by text so both exact words
+ * and abbreviations resolve with a binary search; the remaining hops
+ * (variables, numbers, addresses) always have to be tried and sit in
+ * "others".  Any change to the graph throws the index away.
+ */
+struct cmd_token_index {
+	vector words;  /* WORD_TKN first hops, sorted by token text */
+	vector others; /* remaining first hops */
+};
+
+extern struct cmd_token_index *cmd_token_index_get(struct graph_node *start);
+/* [*first, *last) spans the entries in idx->words whose text has "word"
+ * as a prefix, i.e. the set match_word() can score better than no_match */
+extern void cmd_token_index_range(const struct cmd_token_index *idx,
+				  const char *word, unsigned int *first,
+				  unsigned int *last);
+extern void cmd_token_index_invalidate(struct graph_node *start);
+
 /* Structure of command element. */
 struct cmd_element {
 	const char *string; /* Command specification by string. */
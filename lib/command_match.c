@@ -248,7 +248,23 @@ static enum matcher_rv command_match_r(struct graph_node *start, vector vline,
 
 	// get all possible nexthops
 	struct list *next = list_new();
-	add_nexthops(next, start, NULL, 0);
+
+	/* first-word dispatch: the start node fans out into every command
+	 * installed on the node; ask the index for the few first hops the
+	 * next input token can actually match instead of trying them all */
+	if (token->type == START_TKN && n + 1 < vector_active(vline)
+	    && vector_slot(vline, n + 1)) {
+		struct cmd_token_index *cidx = cmd_token_index_get(start);
+		unsigned int first, last, i;
+
+		cmd_token_index_range(cidx, vector_slot(vline, n + 1), &first,
+				      &last);
+		for (i = first; i < last; i++)
+			listnode_add(next, vector_slot(cidx->words, i));
+		for (i = 0; i < vector_active(cidx->others); i++)
+			listnode_add(next, vector_slot(cidx->others, i));
+	} else
+		add_nexthops(next, start, NULL, 0);
 
 	// determine the best match
 	for (ALL_LIST_ELEMENTS_RO(next, ln, gn)) {
@@ -363,7 +379,28 @@ enum matcher_rv command_complete(struct graph *graph, vector vline,
 
 	// add all children of start node to list
 	struct graph_node *start = vector_slot(graph->nodes, 0);
-	add_nexthops(next, start, &start, 0);
+	char *first_word = vector_active(vline) ? vector_slot(vline, 0) : NULL;
+
+	if (first_word) {
+		/* first-word dispatch, same as in command_match_r() */
+		struct cmd_token_index *cidx = cmd_token_index_get(start);
+		unsigned int first, last, i;
+
+		cmd_token_index_range(cidx, first_word, &first, &last);
+		for (i = first; i < last; i++) {
+			newstack = XMALLOC(MTYPE_CMD_MATCHSTACK,
+					   sizeof(struct graph_node *));
+			newstack[0] = vector_slot(cidx->words, i);
+			listnode_add(next, newstack);
+		}
+		for (i = 0; i < vector_active(cidx->others); i++) {
+			newstack = XMALLOC(MTYPE_CMD_MATCHSTACK,
+					   sizeof(struct graph_node *));
+			newstack[0] = vector_slot(cidx->others, i);
+			listnode_add(next, newstack);
+		}
+	} else
+		add_nexthops(next, start, &start, 0);
 
 	unsigned int idx;
 	for (idx = 0; idx < vector_active(vline) && next->count > 0; idx++) {
@@ -387,6 +387,10 @@ cmd_graph_parse (struct graph *graph, struct cmd_element *cmd)
   // parse command into DFA
   cmd_yyparse (&ctx);
 
+  /* graph changed; drop the matcher's first-word dispatch index
+   * (grammar sandbox parses straight into a live graph) */
+  cmd_token_index_invalidate (vector_slot (graph->nodes, 0));
+
   /* cleanup lexer */
   cleanup_lexer (&ctx.scanner);
 
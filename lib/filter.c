@@ -33,6 +33,7 @@
 DEFINE_MTYPE_STATIC(LIB, ACCESS_LIST, "Access List")
 DEFINE_MTYPE_STATIC(LIB, ACCESS_LIST_STR, "Access List Str")
 DEFINE_MTYPE_STATIC(LIB, ACCESS_FILTER, "Access Filter")
+DEFINE_MTYPE_STATIC(LIB, ACCESS_COMPILED, "Access List compiled")
 
 struct filter_cisco {
 	/* Cisco access-list */
@@ -155,15 +156,39 @@ static const char *filter_type_str(struct filter *filter)
 	}
 }
 
+/*
+ * Compiled form of an access-list.  The filter chain is flattened into
+ * a contiguous array with the per-entry match data copied inline, so
+ * the hot access_list_apply() walk reads sequential memory instead of
+ * chasing list pointers through individually allocated filters.  It is
+ * (re)built lazily on the first apply after a change; every entry
+ * add/delete bumps the list's generation so stale compilations are
+ * detected.
+ */
+struct access_compiled_entry {
+	enum filter_type type;
+	int cisco;
+
+	union {
+		struct filter_cisco cfilter;
+		struct filter_zebra zfilter;
+	} u;
+};
+
+struct access_compiled {
+	unsigned int generation; /* access->generation this was built at */
+	size_t nentries;
+	struct access_compiled_entry entries[];
+};
+
 /* If filter match to the prefix then return 1. */
-static int filter_match_cisco(struct filter *mfilter, const struct prefix *p)
+static int filter_match_cisco(const struct filter_cisco *filter,
+			      const struct prefix *p)
 {
-	struct filter_cisco *filter;
 	struct in_addr mask;
 	uint32_t check_addr;
 	uint32_t check_mask;
 
-	filter = &mfilter->u.cfilter;
 	check_addr = p->u.prefix4.s_addr & ~filter->addr_mask.s_addr;
 
 	if (filter->extended) {
@@ -180,12 +205,9 @@ static int filter_match_cisco(struct filter *mfilter, const struct prefix *p)
 }
 
 /* If filter match to the prefix then return 1. */
-static int filter_match_zebra(struct filter *mfilter, const struct prefix *p)
+static int filter_match_zebra(const struct filter_zebra *filter,
+			      const struct prefix *p)
 {
-	struct filter_zebra *filter = NULL;
-
-	filter = &mfilter->u.zfilter;
-
 	if (filter->prefix.family == p->family) {
 		if (filter->exact) {
 			if (filter->prefix.prefixlen == p->prefixlen)
@@ -198,6 +220,35 @@ static int filter_match_zebra(struct filter *mfilter, const struct prefix *p)
 		return 0;
 }
 
+static void access_list_compile(struct access_list *access)
+{
+	struct access_compiled *comp;
+	struct filter *filter;
+	size_t n = 0;
+
+	for (filter = access->head; filter; filter = filter->next)
+		n++;
+
+	XFREE(MTYPE_ACCESS_COMPILED, access->compiled);
+	comp = XMALLOC(MTYPE_ACCESS_COMPILED,
+		       sizeof(*comp) + n * sizeof(comp->entries[0]));
+	comp->generation = access->generation;
+	comp->nentries = n;
+
+	n = 0;
+	for (filter = access->head; filter; filter = filter->next) {
+		comp->entries[n].type = filter->type;
+		comp->entries[n].cisco = filter->cisco;
+		if (filter->cisco)
+			comp->entries[n].u.cfilter = filter->u.cfilter;
+		else
+			comp->entries[n].u.zfilter = filter->u.zfilter;
+		n++;
+	}
+
+	access->compiled = comp;
+}
+
 /* Allocate new access list structure. */
 static struct access_list *access_list_new(void)
 {
@@ -244,6 +295,8 @@ static void access_list_delete(struct access_list *access)
 
 	XFREE(MTYPE_TMP, access->remark);
 
+	XFREE(MTYPE_ACCESS_COMPILED, access->compiled);
+
 	access_list_free(access);
 }
 
@@ -371,19 +424,24 @@ static struct access_list *access_list_get(afi_t afi, const char *name)
 enum filter_type access_list_apply(struct access_list *access,
 				   const void *object)
 {
-	struct filter *filter;
+	const struct access_compiled_entry *ent, *end;
 	const struct prefix *p = (const struct prefix *)object;
 
 	if (access == NULL)
 		return FILTER_DENY;
 
-	for (filter = access->head; filter; filter = filter->next) {
-		if (filter->cisco) {
-			if (filter_match_cisco(filter, p))
-				return filter->type;
+	if (!access->compiled
+	    || access->compiled->generation != access->generation)
+		access_list_compile(access);
+
+	end = access->compiled->entries + access->compiled->nentries;
+	for (ent = access->compiled->entries; ent < end; ent++) {
+		if (ent->cisco) {
+			if (filter_match_cisco(&ent->u.cfilter, p))
+				return ent->type;
 		} else {
-			if (filter_match_zebra(filter, p))
-				return filter->type;
+			if (filter_match_zebra(&ent->u.zfilter, p))
+				return ent->type;
 		}
 	}
 
@@ -419,6 +477,8 @@ static void access_list_filter_add(struct access_list *access,
 		access->head = filter;
 	access->tail = filter;
 
+	access->generation++;
+
 	/* Run hook function. */
 	if (access->master->add_hook)
 		(*access->master->add_hook)(access);
@@ -453,6 +513,8 @@ static void access_list_filter_delete(struct access_list *access,
 	else
 		access->head = filter->next;
 
+	access->generation++;
+
 	filter_free(filter);
 
 	route_map_notify_dependencies(access->name, RMAP_EVENT_FILTER_DELETED);
@@ -55,6 +55,11 @@ struct access_list {
 
 	struct filter *head;
 	struct filter *tail;
+
+	/* Compiled (flattened) form used by access_list_apply(); rebuilt
+	   lazily whenever generation says the entry chain has changed. */
+	struct access_compiled *compiled;
+	unsigned int generation;
 };
 
 /* Prototypes for access-list. */
@@ -27,6 +27,7 @@
 #include "frr_pthread.h"
 #include "memory.h"
 #include "linklist.h"
+#include "command.h"
 
 DEFINE_MTYPE(LIB, FRR_PTHREAD, "FRR POSIX Thread");
 DEFINE_MTYPE(LIB, PTHREAD_PRIM, "POSIX synchronization primitives");
@@ -76,6 +77,8 @@ struct frr_pthread *frr_pthread_new(struct frr_pthread_attr *attr,
 	fpt = XCALLOC(MTYPE_FRR_PTHREAD, sizeof(struct frr_pthread));
 	/* initialize mutex */
 	pthread_mutex_init(&fpt->mtx, NULL);
+	/* no CPU or scheduler overrides until configured */
+	fpt->sched_policy = -1;
 	/* create new thread master */
 	fpt->master = thread_master_create(name);
 	/* set attributes */
@@ -133,6 +136,89 @@ int frr_pthread_set_name(struct frr_pthread *fpt)
 	return ret;
 }
 
+/* Applies the stored affinity mask, if any. Requires: mtx */
+static int frr_pthread_apply_affinity(struct frr_pthread *fpt)
+{
+#ifdef GNU_LINUX
+	cpu_set_t cpuset;
+	unsigned int i;
+
+	CPU_ZERO(&cpuset);
+	for (i = 0; i < 8 * sizeof(fpt->cpumask); i++)
+		if (!fpt->cpumask || fpt->cpumask & (1ULL << i))
+			CPU_SET(i, &cpuset);
+
+	return pthread_setaffinity_np(fpt->thread, sizeof(cpuset), &cpuset);
+#else
+	return fpt->cpumask ? ENOTSUP : 0;
+#endif
+}
+
+/* Applies the stored scheduling settings, if any. Requires: mtx */
+static int frr_pthread_apply_sched(struct frr_pthread *fpt)
+{
+	struct sched_param param = {0};
+	int policy = SCHED_OTHER;
+
+	if (fpt->sched_policy != -1) {
+		policy = fpt->sched_policy;
+		param.sched_priority = fpt->sched_priority;
+	}
+
+	return pthread_setschedparam(fpt->thread, policy, &param);
+}
+
+int frr_pthread_set_affinity(struct frr_pthread *fpt, uint64_t cpumask)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&fpt->mtx);
+	{
+		fpt->cpumask = cpumask;
+		if (atomic_load_explicit(&fpt->running, memory_order_relaxed))
+			ret = frr_pthread_apply_affinity(fpt);
+	}
+	pthread_mutex_unlock(&fpt->mtx);
+
+	return ret;
+}
+
+int frr_pthread_set_sched(struct frr_pthread *fpt, int policy, int priority)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&fpt->mtx);
+	{
+		fpt->sched_policy = policy;
+		fpt->sched_priority = priority;
+		if (atomic_load_explicit(&fpt->running, memory_order_relaxed))
+			ret = frr_pthread_apply_sched(fpt);
+	}
+	pthread_mutex_unlock(&fpt->mtx);
+
+	return ret;
+}
+
+struct frr_pthread *frr_pthread_lookup_name(const char *name)
+{
+	struct frr_pthread *fpt, *found = NULL;
+	struct listnode *n;
+
+	pthread_mutex_lock(&frr_pthread_list_mtx);
+	{
+		for (ALL_LIST_ELEMENTS_RO(frr_pthread_list, n, fpt)) {
+			if (strcmp(fpt->name, name) == 0
+			    || strcmp(fpt->os_name, name) == 0) {
+				found = fpt;
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&frr_pthread_list_mtx);
+
+	return found;
+}
+
 int frr_pthread_run(struct frr_pthread *fpt, const pthread_attr_t *attr)
 {
 	int ret;
@@ -143,8 +229,20 @@ int frr_pthread_run(struct frr_pthread *fpt, const pthread_attr_t *attr)
 	 * Per pthread_create(3), the contents of fpt->thread are undefined if
 	 * pthread_create() did not succeed. Reset this value to zero.
 	 */
-	if (ret < 0)
+	if (ret < 0) {
 		memset(&fpt->thread, 0x00, sizeof(fpt->thread));
+		return ret;
+	}
+
+	/* reapply any placement/scheduling settings from an earlier run */
+	pthread_mutex_lock(&fpt->mtx);
+	{
+		if (fpt->cpumask)
+			frr_pthread_apply_affinity(fpt);
+		if (fpt->sched_policy != -1)
+			frr_pthread_apply_sched(fpt);
+	}
+	pthread_mutex_unlock(&fpt->mtx);
 
 	return ret;
 }
@@ -189,6 +287,201 @@ void frr_pthread_stop_all(void)
 	pthread_mutex_unlock(&frr_pthread_list_mtx);
 }
 
+/*
+ * ----------------------------------------------------------------------------
+ * CLI
+ * ----------------------------------------------------------------------------
+ */
+
+/* Parses a CPU list of the form "0,2-4" into a bitmask. */
+static int frr_pthread_parse_cpulist(const char *str, uint64_t *maskp)
+{
+	uint64_t mask = 0;
+	unsigned long first, last, i;
+	char *end;
+
+	while (*str) {
+		first = strtoul(str, &end, 10);
+		if (end == str || first >= 8 * sizeof(mask))
+			return -1;
+		last = first;
+		if (*end == '-') {
+			str = end + 1;
+			last = strtoul(str, &end, 10);
+			if (end == str || last >= 8 * sizeof(mask)
+			    || last < first)
+				return -1;
+		}
+		for (i = first; i <= last; i++)
+			mask |= 1ULL << i;
+		if (*end == ',')
+			end++;
+		else if (*end != '\0')
+			return -1;
+		str = end;
+	}
+
+	if (!mask)
+		return -1;
+
+	*maskp = mask;
+	return 0;
+}
+
+DEFUN (thread_pthread_affinity,
+       thread_pthread_affinity_cmd,
+       "thread pthread NAME affinity CPULIST",
+       "Thread information\n"
+       "POSIX thread settings\n"
+       "Thread name (see \"show thread pthread\")\n"
+       "Restrict the thread to a set of CPUs\n"
+       "CPU list (e.g. 0,2-4)\n")
+{
+	struct frr_pthread *fpt = frr_pthread_lookup_name(argv[2]->arg);
+	uint64_t mask;
+	int ret;
+
+	if (!fpt) {
+		vty_out(vty, "%% No pthread named \"%s\"\n", argv[2]->arg);
+		return CMD_WARNING;
+	}
+	if (frr_pthread_parse_cpulist(argv[4]->arg, &mask) < 0) {
+		vty_out(vty, "%% Malformed CPU list \"%s\"\n", argv[4]->arg);
+		return CMD_WARNING;
+	}
+
+	ret = frr_pthread_set_affinity(fpt, mask);
+	if (ret) {
+		vty_out(vty, "%% Failed to set affinity: %s\n",
+			safe_strerror(ret));
+		return CMD_WARNING;
+	}
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_thread_pthread_affinity,
+       no_thread_pthread_affinity_cmd,
+       "no thread pthread NAME affinity [CPULIST]",
+       NO_STR
+       "Thread information\n"
+       "POSIX thread settings\n"
+       "Thread name (see \"show thread pthread\")\n"
+       "Restrict the thread to a set of CPUs\n"
+       "CPU list (e.g. 0,2-4)\n")
+{
+	struct frr_pthread *fpt = frr_pthread_lookup_name(argv[3]->arg);
+
+	if (!fpt) {
+		vty_out(vty, "%% No pthread named \"%s\"\n", argv[3]->arg);
+		return CMD_WARNING;
+	}
+
+	frr_pthread_set_affinity(fpt, 0);
+	return CMD_SUCCESS;
+}
+
+DEFUN (thread_pthread_priority,
+       thread_pthread_priority_cmd,
+       "thread pthread NAME priority (1-99)",
+       "Thread information\n"
+       "POSIX thread settings\n"
+       "Thread name (see \"show thread pthread\")\n"
+       "Run the thread under the SCHED_FIFO realtime scheduler\n"
+       "Realtime priority\n")
+{
+	struct frr_pthread *fpt = frr_pthread_lookup_name(argv[2]->arg);
+	int ret;
+
+	if (!fpt) {
+		vty_out(vty, "%% No pthread named \"%s\"\n", argv[2]->arg);
+		return CMD_WARNING;
+	}
+
+	ret = frr_pthread_set_sched(fpt, SCHED_FIFO, atoi(argv[4]->arg));
+	if (ret) {
+		vty_out(vty, "%% Failed to set scheduler: %s\n",
+			safe_strerror(ret));
+		return CMD_WARNING;
+	}
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_thread_pthread_priority,
+       no_thread_pthread_priority_cmd,
+       "no thread pthread NAME priority [(1-99)]",
+       NO_STR
+       "Thread information\n"
+       "POSIX thread settings\n"
+       "Thread name (see \"show thread pthread\")\n"
+       "Run the thread under the SCHED_FIFO realtime scheduler\n"
+       "Realtime priority\n")
+{
+	struct frr_pthread *fpt = frr_pthread_lookup_name(argv[3]->arg);
+	int ret;
+
+	if (!fpt) {
+		vty_out(vty, "%% No pthread named \"%s\"\n", argv[3]->arg);
+		return CMD_WARNING;
+	}
+
+	ret = frr_pthread_set_sched(fpt, -1, 0);
+	if (ret) {
+		vty_out(vty, "%% Failed to reset scheduler: %s\n",
+			safe_strerror(ret));
+		return CMD_WARNING;
+	}
+	return CMD_SUCCESS;
+}
+
+DEFUN (show_thread_pthread,
+       show_thread_pthread_cmd,
+       "show thread pthread",
+       SHOW_STR
+       "Thread information\n"
+       "POSIX threads\n")
+{
+	struct frr_pthread *fpt;
+	struct listnode *n;
+
+	vty_out(vty, "%-32s %-16s %-8s %-18s %s\n", "Name", "OS name",
+		"Running", "Affinity", "Scheduler");
+
+	pthread_mutex_lock(&frr_pthread_list_mtx);
+	{
+		for (ALL_LIST_ELEMENTS_RO(frr_pthread_list, n, fpt)) {
+			char affinity[24] = "-", sched[24] = "default";
+
+			pthread_mutex_lock(&fpt->mtx);
+			if (fpt->cpumask)
+				snprintf(affinity, sizeof(affinity),
+					 "0x%" PRIx64, fpt->cpumask);
+			if (fpt->sched_policy != -1)
+				snprintf(sched, sizeof(sched), "fifo/%d",
+					 fpt->sched_priority);
+			vty_out(vty, "%-32s %-16s %-8s %-18s %s\n", fpt->name,
+				fpt->os_name,
+				atomic_load_explicit(&fpt->running,
+						     memory_order_relaxed)
+					? "yes"
+					: "no",
+				affinity, sched);
+			pthread_mutex_unlock(&fpt->mtx);
+		}
+	}
+	pthread_mutex_unlock(&frr_pthread_list_mtx);
+
+	return CMD_SUCCESS;
+}
+
+void frr_pthread_cmd_init(void)
+{
+	install_element(VIEW_NODE, &show_thread_pthread_cmd);
+	install_element(ENABLE_NODE, &thread_pthread_affinity_cmd);
+	install_element(ENABLE_NODE, &no_thread_pthread_affinity_cmd);
+	install_element(ENABLE_NODE, &thread_pthread_priority_cmd);
+	install_element(ENABLE_NODE, &no_thread_pthread_priority_cmd);
+}
+
 /*
  * ----------------------------------------------------------------------------
  * Default Event Loop
@@ -97,6 +97,20 @@ struct frr_pthread {
 
 	/* Used in pthread_set_name max 16 characters */
 	char os_name[OS_THREAD_NAMELEN];
+
+	/*
+	 * CPU placement and scheduling settings.  Applied when the pthread
+	 * starts and adjustable at runtime with the "thread pthread" vty
+	 * commands.  A zero cpumask leaves the kernel's placement alone;
+	 * a sched_policy of -1 leaves the scheduler settings alone.
+	 * Pinning a thread to the CPUs of one socket is also the way to get
+	 * NUMA-local memory for its allocations.
+	 *
+	 * Requires: mtx
+	 */
+	uint64_t cpumask;
+	int sched_policy;
+	int sched_priority;
 };
 
 extern struct frr_pthread_attr frr_pthread_attr_default;
@@ -175,6 +189,44 @@ void frr_pthread_destroy(struct frr_pthread *fpt);
  */
 int frr_pthread_run(struct frr_pthread *fpt, const pthread_attr_t *attr);
 
+/*
+ * Restricts the CPUs an frr_pthread may run on.
+ *
+ * The mask has one bit per CPU; a mask of zero removes the restriction.
+ * Takes effect immediately if the pthread is running, and is reapplied
+ * automatically if it is restarted.
+ *
+ * @param fpt - the frr_pthread to pin
+ * @param cpumask - bitmask of allowed CPUs
+ * @return 0 on success, otherwise an error number
+ */
+int frr_pthread_set_affinity(struct frr_pthread *fpt, uint64_t cpumask);
+
+/*
+ * Sets the scheduling policy and priority of an frr_pthread.
+ *
+ * A policy of -1 reverts to the system default. Takes effect immediately
+ * if the pthread is running, and is reapplied automatically if it is
+ * restarted.
+ *
+ * @param fpt - the frr_pthread to adjust
+ * @param policy - SCHED_FIFO, SCHED_RR, SCHED_OTHER or -1
+ * @param priority - priority within the policy (see sched(7))
+ * @return 0 on success, otherwise an error number
+ */
+int frr_pthread_set_sched(struct frr_pthread *fpt, int policy, int priority);
+
+/*
+ * Looks up a registered frr_pthread by its human-readable or OS name.
+ *
+ * @param name - the name to look for
+ * @return the frr_pthread, or NULL if no such thread exists
+ */
+struct frr_pthread *frr_pthread_lookup_name(const char *name);
+
+/* Registers the "thread pthread" vty commands. Called from cmd_init(). */
+void frr_pthread_cmd_init(void);
+
 /*
  * Waits until the specified pthread has finished setting up and is ready to
  * begin work.
@@ -81,6 +81,8 @@ typedef std::atomic<uint_fast32_t>	atomic_uint_fast32_t;
 					      mem2)                            \
 	__atomic_compare_exchange_n(atom, expect, desire, 1, mem1, mem2)
 
+#define atomic_thread_fence(mem) __atomic_thread_fence(mem)
+
 /* gcc 4.1 and newer,
  * clang 3.3 (possibly older)
  *
@@ -197,6 +199,8 @@ typedef std::atomic<uint_fast32_t>	atomic_uint_fast32_t;
 		rval;                                                          \
 	})
 
+#define atomic_thread_fence(mem) __sync_synchronize()
+
 #define atomic_and_fetch_explicit(ptr, val, mem)                               \
 	({                                                                     \
 		__sync_synchronize();                                          \
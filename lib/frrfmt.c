@@ -0,0 +1,409 @@
+/*
+ * snprintf with FRR format extensions and fast address formatters.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "frrfmt.h"
+#include "prefix.h"
+
+/* Decimal 0..255 without division; used octet-wise for IPv4. */
+static char *frr_put_dec8(char *p, uint8_t num)
+{
+	if (num >= 100) {
+		*p++ = '0' + num / 100;
+		num %= 100;
+		*p++ = '0' + num / 10;
+		*p++ = '0' + num % 10;
+	} else if (num >= 10) {
+		*p++ = '0' + num / 10;
+		*p++ = '0' + num % 10;
+	} else {
+		*p++ = '0' + num;
+	}
+	return p;
+}
+
+char *frr_inet4_ntop(const struct in_addr *addr, char *buf, size_t size)
+{
+	const uint8_t *b = (const uint8_t *)addr;
+	char tmp[INET_ADDRSTRLEN];
+	char *p = tmp;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		if (i)
+			*p++ = '.';
+		p = frr_put_dec8(p, b[i]);
+	}
+	*p = '\0';
+
+	strlcpy(buf, tmp, size);
+	return buf;
+}
+
+static char *frr_put_hex16(char *p, uint16_t num)
+{
+	static const char hexch[] = "0123456789abcdef";
+	int shift;
+	bool sig = false;
+
+	for (shift = 12; shift >= 0; shift -= 4) {
+		uint8_t nib = (num >> shift) & 0xf;
+
+		if (nib || sig || shift == 0) {
+			*p++ = hexch[nib];
+			sig = true;
+		}
+	}
+	return p;
+}
+
+char *frr_inet6_ntop(const struct in6_addr *addr, char *buf, size_t size)
+{
+	char tmp[INET6_ADDRSTRLEN];
+	char *p = tmp;
+	uint16_t group[8];
+	int best_base = -1, best_len = 0;
+	int base = -1, len = 0;
+	int i;
+
+	for (i = 0; i < 8; i++)
+		group[i] = ((uint16_t)addr->s6_addr[i * 2] << 8)
+			   | addr->s6_addr[i * 2 + 1];
+
+	/* RFC 5952: compress the longest run of two or more zero
+	 * groups, the leftmost one on a tie. */
+	for (i = 0; i < 8; i++) {
+		if (group[i] == 0) {
+			if (base < 0)
+				base = i;
+			len++;
+		} else {
+			if (len > best_len) {
+				best_base = base;
+				best_len = len;
+			}
+			base = -1;
+			len = 0;
+		}
+	}
+	if (len > best_len) {
+		best_base = base;
+		best_len = len;
+	}
+	if (best_len < 2)
+		best_base = -1;
+
+	for (i = 0; i < 8; i++) {
+		if (best_base >= 0 && i >= best_base
+		    && i < best_base + best_len) {
+			if (i == best_base) {
+				*p++ = ':';
+				*p++ = ':';
+			}
+			continue;
+		}
+		if (i && p[-1] != ':')
+			*p++ = ':';
+
+		/* v4-mapped / v4-compatible tail in dotted quad */
+		if (i == 6 && best_base == 0
+		    && (best_len == 6 || (best_len == 5 && group[5] == 0xffff))) {
+			struct in_addr v4;
+
+			memcpy(&v4, &addr->s6_addr[12], sizeof(v4));
+			frr_inet4_ntop(&v4, p, sizeof(tmp) - (p - tmp));
+			p += strlen(p);
+			break;
+		}
+		p = frr_put_hex16(p, group[i]);
+	}
+	*p = '\0';
+
+	strlcpy(buf, tmp, size);
+	return buf;
+}
+
+/* Append src, keeping vsnprintf()-style "would have written" count. */
+static void frr_fmt_puts(char *buf, size_t size, size_t *outlen,
+			 const char *src)
+{
+	size_t done = *outlen;
+
+	while (*src) {
+		if (done + 1 < size)
+			buf[done] = *src;
+		done++;
+		src++;
+	}
+	*outlen = done;
+}
+
+static void frr_fmt_putc(char *buf, size_t size, size_t *outlen, char c)
+{
+	if (*outlen + 1 < size)
+		buf[*outlen] = c;
+	(*outlen)++;
+}
+
+/* Pad-and-append helper for the %p extensions: only '-' and a field
+ * width apply to string output. */
+static void frr_fmt_pad(char *buf, size_t size, size_t *outlen,
+			const char *str, int width, bool left)
+{
+	int slen = strlen(str);
+
+	if (!left)
+		for (; width > slen; width--)
+			frr_fmt_putc(buf, size, outlen, ' ');
+	frr_fmt_puts(buf, size, outlen, str);
+	if (left)
+		for (; width > slen; width--)
+			frr_fmt_putc(buf, size, outlen, ' ');
+}
+
+int frr_vsnprintf(char *buf, size_t size, const char *format, va_list args)
+{
+	size_t outlen = 0;
+
+	while (*format) {
+		/* every specifier gets re-emitted through snprintf()
+		 * with its value fetched per the length modifier */
+		char subfmt[64];
+		char tmp[512];
+		const char *start = format;
+		char lenmod[3] = "";
+		char flags[8] = "";
+		char conv;
+		int width = -1, prec = -1, nflags = 0;
+		bool left = false;
+		size_t sublen;
+
+		if (*format != '%') {
+			frr_fmt_putc(buf, size, &outlen, *format++);
+			continue;
+		}
+
+		format++;
+		if (*format == '%') {
+			frr_fmt_putc(buf, size, &outlen, '%');
+			format++;
+			continue;
+		}
+
+		/* flags */
+		while (*format && strchr("-+ #0'", *format)) {
+			if (*format == '-')
+				left = true;
+			if (nflags < (int)sizeof(flags) - 1)
+				flags[nflags++] = *format;
+			format++;
+		}
+		/* field width */
+		if (*format == '*') {
+			width = va_arg(args, int);
+			if (width < 0) {
+				left = true;
+				width = -width;
+				if (nflags < (int)sizeof(flags) - 1)
+					flags[nflags++] = '-';
+			}
+			format++;
+		} else
+			while (isdigit((unsigned char)*format)) {
+				if (width < 0)
+					width = 0;
+				width = width * 10 + (*format++ - '0');
+			}
+		/* precision */
+		if (*format == '.') {
+			format++;
+			prec = 0;
+			if (*format == '*') {
+				prec = va_arg(args, int);
+				format++;
+			} else
+				while (isdigit((unsigned char)*format))
+					prec = prec * 10 + (*format++ - '0');
+		}
+		/* length modifier */
+		if (*format == 'h' || *format == 'l') {
+			lenmod[0] = *format++;
+			if (*format == lenmod[0])
+				lenmod[1] = *format++;
+		} else if (*format && strchr("jzt L", *format)
+			   && *format != ' ')
+			lenmod[0] = *format++;
+
+		conv = *format++;
+		if (!conv)
+			break;
+
+		/* FRR extensions: %pFX, %pI4, %pI6 */
+		if (conv == 'p' && !lenmod[0]) {
+			const void *ptr;
+
+			if (format[0] == 'F' && format[1] == 'X') {
+				char pbuf[PREFIX_STRLEN];
+
+				format += 2;
+				ptr = va_arg(args, void *);
+				if (ptr)
+					prefix2str(ptr, pbuf, sizeof(pbuf));
+				else
+					strlcpy(pbuf, "(null)", sizeof(pbuf));
+				frr_fmt_pad(buf, size, &outlen, pbuf, width,
+					    left);
+				continue;
+			}
+			if (format[0] == 'I'
+			    && (format[1] == '4' || format[1] == '6')) {
+				char abuf[INET6_ADDRSTRLEN];
+
+				ptr = va_arg(args, void *);
+				if (!ptr)
+					strlcpy(abuf, "(null)", sizeof(abuf));
+				else if (format[1] == '4')
+					frr_inet4_ntop(ptr, abuf,
+						       sizeof(abuf));
+				else
+					frr_inet6_ntop(ptr, abuf,
+						       sizeof(abuf));
+				format += 2;
+				frr_fmt_pad(buf, size, &outlen, abuf, width,
+					    left);
+				continue;
+			}
+		}
+
+		/* rebuild the specifier with parsed width/precision */
+		sublen = (size_t)(format - start);
+		if (sublen >= sizeof(subfmt))
+			sublen = sizeof(subfmt) - 1;
+		memcpy(subfmt, start, sublen);
+		subfmt[sublen] = '\0';
+		/* '*' was consumed from args above; substitute values */
+		if (strchr(subfmt, '*')) {
+			char widthstr[16] = "", precstr[16] = "";
+
+			if (width > 0)
+				snprintf(widthstr, sizeof(widthstr), "%d",
+					 width);
+			if (prec >= 0)
+				snprintf(precstr, sizeof(precstr), ".%d",
+					 prec);
+			snprintf(subfmt, sizeof(subfmt), "%%%s%s%s%s%c",
+				 flags, widthstr, precstr, lenmod, conv);
+		}
+
+		switch (conv) {
+		case 'd':
+		case 'i':
+			if (lenmod[1] == 'l')
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, long long));
+			else if (lenmod[0] == 'l')
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, long));
+			else if (lenmod[0] == 'j')
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, intmax_t));
+			else if (lenmod[0] == 'z' || lenmod[0] == 't')
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, ssize_t));
+			else
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, int));
+			break;
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			if (lenmod[1] == 'l')
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, unsigned long long));
+			else if (lenmod[0] == 'l')
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, unsigned long));
+			else if (lenmod[0] == 'j')
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, uintmax_t));
+			else if (lenmod[0] == 'z' || lenmod[0] == 't')
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, size_t));
+			else
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, unsigned int));
+			break;
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'F':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			if (lenmod[0] == 'L')
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, long double));
+			else
+				snprintf(tmp, sizeof(tmp), subfmt,
+					 va_arg(args, double));
+			break;
+		case 'c':
+			snprintf(tmp, sizeof(tmp), subfmt, va_arg(args, int));
+			break;
+		case 's':
+			snprintf(tmp, sizeof(tmp), subfmt,
+				 va_arg(args, const char *));
+			break;
+		case 'p':
+			snprintf(tmp, sizeof(tmp), subfmt,
+				 va_arg(args, void *));
+			break;
+		case 'n':
+			/* unsupported in log formats; swallow the arg */
+			(void)va_arg(args, void *);
+			tmp[0] = '\0';
+			break;
+		default:
+			/* unknown conversion; emit it verbatim */
+			snprintf(tmp, sizeof(tmp), "%.*s",
+				 (int)(format - start), start);
+			break;
+		}
+
+		frr_fmt_puts(buf, size, &outlen, tmp);
+	}
+
+	if (size > 0)
+		buf[outlen < size ? outlen : size - 1] = '\0';
+	return (int)outlen;
+}
+
+int frr_snprintf(char *buf, size_t size, const char *format, ...)
+{
+	va_list args;
+	int len;
+
+	va_start(args, format);
+	len = frr_vsnprintf(buf, size, format, args);
+	va_end(args);
+	return len;
+}
@@ -0,0 +1,78 @@
+/*
+ * snprintf with FRR format extensions and fast address formatters.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _ZEBRA_FRRFMT_H
+#define _ZEBRA_FRRFMT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef PRINTF_ATTRIBUTE
+#ifdef __GNUC__
+#define PRINTF_ATTRIBUTE(a, b)                                                 \
+	__attribute__((__format__(__printf__, a, b)))
+#else
+#define PRINTF_ATTRIBUTE(a, b)
+#endif /* __GNUC__ */
+#endif /* PRINTF_ATTRIBUTE */
+
+struct in_addr;
+struct in6_addr;
+
+/*
+ * vsnprintf()-compatible formatter that additionally understands FRR's
+ * own conversions, all piggybacked on %p so -Wformat checking of
+ * callers keeps working:
+ *
+ *   %pFX - const struct prefix *,   rendered as prefix2str()
+ *   %pI4 - const struct in_addr *,  rendered as dotted quad
+ *   %pI6 - const struct in6_addr *, rendered per RFC 5952
+ *
+ * Standard conversions are passed through to snprintf() one specifier
+ * at a time, so flags/width/precision behave as usual.  Return value
+ * and truncation semantics match vsnprintf().
+ *
+ * vzlog() renders through this, so zlog callers can hand a prefix or
+ * address straight to the format string and pay for the string
+ * conversion only when some log destination actually emits the line.
+ */
+extern int frr_vsnprintf(char *buf, size_t size, const char *format,
+			 va_list args);
+extern int frr_snprintf(char *buf, size_t size, const char *format, ...)
+	PRINTF_ATTRIBUTE(3, 4);
+
+/*
+ * Direct replacements for inet_ntop(AF_INET/AF_INET6, ...) without the
+ * address-family dispatch and locale machinery; buf must hold at least
+ * INET_ADDRSTRLEN resp. INET6_ADDRSTRLEN bytes.  Both return buf.
+ */
+extern char *frr_inet4_ntop(const struct in_addr *addr, char *buf,
+			    size_t size);
+extern char *frr_inet6_ntop(const struct in6_addr *addr, char *buf,
+			    size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ZEBRA_FRRFMT_H */
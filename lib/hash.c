@@ -82,28 +82,48 @@ void *hash_alloc_intern(void *arg)
 	atomic_fetch_add_explicit(&hz->stats.ssq, (new + old) * (new - old),   \
 				  memory_order_relaxed);
 
-/* Expand hash if the chain length exceeds the threshold. */
-static void hash_expand(struct hash *hash)
+/* Begin an incremental rehash into a table of new_size buckets.  The
+ * current bucket array is set aside and drained a few slots at a time
+ * by hash_rehash_step(), so the cost of a resize is spread over the
+ * operations that follow instead of being paid in one pass by whichever
+ * caller happened to trip the threshold (on bgpd's attrhash at a
+ * million entries that pass is a multi-millisecond stall). */
+static void hash_rehash_start(struct hash *hash, unsigned int new_size)
 {
-	unsigned int i, new_size;
-	struct hash_bucket *hb, *hbnext, **new_index;
+	hash->old_index = hash->index;
+	hash->old_size = hash->size;
+	hash->rehash_pos = 0;
 
-	new_size = hash->size * 2;
+	hash->index = XCALLOC(MTYPE_HASH_INDEX,
+			      sizeof(struct hash_bucket *) * new_size);
+	hash->size = new_size;
 
-	if (hash->max_size && new_size > hash->max_size)
-		return;
+	/* distribution stats restart from the empty new table; chains
+	 * still parked in the old one are counted back in as they
+	 * migrate over the next few thousand operations */
+	hash->stats.empty = new_size;
+	hash->stats.ssq = 0;
+}
 
-	new_index = XCALLOC(MTYPE_HASH_INDEX,
-			    sizeof(struct hash_bucket *) * new_size);
+/* old-table slots migrated per modifying hash operation */
+#define HASH_REHASH_SLOTS 8
 
-	hash->stats.empty = new_size;
+static void hash_maybe_shrink(struct hash *hash);
 
-	for (i = 0; i < hash->size; i++)
-		for (hb = hash->index[i]; hb; hb = hbnext) {
-			unsigned int h = hb->key & (new_size - 1);
+static void hash_rehash_step(struct hash *hash)
+{
+	unsigned int budget = HASH_REHASH_SLOTS;
+	struct hash_bucket *hb, *hbnext;
+
+	if (!hash->old_index || hash->iterating)
+		return;
+
+	while (budget-- && hash->rehash_pos < hash->old_size) {
+		for (hb = hash->old_index[hash->rehash_pos]; hb; hb = hbnext) {
+			unsigned int h = hb->key & (hash->size - 1);
 
 			hbnext = hb->next;
-			hb->next = new_index[h];
+			hb->next = hash->index[h];
 
 			int oldlen = hb->next ? hb->next->len : 0;
 			int newlen = oldlen + 1;
@@ -117,13 +137,20 @@ static void hash_expand(struct hash *hash)
 
 			hash_update_ssq(hash, oldlen, newlen);
 
-			new_index[h] = hb;
+			hash->index[h] = hb;
 		}
+		hash->old_index[hash->rehash_pos++] = NULL;
+	}
 
-	/* Switch to new table */
-	XFREE(MTYPE_HASH_INDEX, hash->index);
-	hash->size = new_size;
-	hash->index = new_index;
+	if (hash->rehash_pos >= hash->old_size) {
+		XFREE(MTYPE_HASH_INDEX, hash->old_index);
+		hash->old_index = NULL;
+		hash->old_size = 0;
+
+		/* heavy churn may call for more than one halving; each
+		 * completed step re-checks so the cascade continues */
+		hash_maybe_shrink(hash);
+	}
 }
 
 void *hash_get(struct hash *hash, void *data, void *(*alloc_func)(void *))
@@ -136,6 +163,10 @@ void *hash_get(struct hash *hash, void *data, void *(*alloc_func)(void *))
 	if (!alloc_func && !hash->count)
 		return NULL;
 
+	/* keep plain lookups read-only; inserts pull their weight */
+	if (alloc_func)
+		hash_rehash_step(hash);
+
 	key = (*hash->hash_key)(data);
 	index = key & (hash->size - 1);
 
@@ -145,14 +176,28 @@ void *hash_get(struct hash *hash, void *data, void *(*alloc_func)(void *))
 			return bucket->data;
 	}
 
+	/* not yet migrated entries live in the old table */
+	if (hash->old_index)
+		for (bucket = hash->old_index[key & (hash->old_size - 1)];
+		     bucket != NULL; bucket = bucket->next) {
+			if (bucket->key == key
+			    && (*hash->hash_cmp)(bucket->data, data))
+				return bucket->data;
+		}
+
 	if (alloc_func) {
 		newdata = (*alloc_func)(data);
 		if (newdata == NULL)
 			return NULL;
 
-		if (HASH_THRESHOLD(hash->count + 1, hash->size)) {
-			hash_expand(hash);
-			index = key & (hash->size - 1);
+		if (!hash->old_index && !hash->iterating
+		    && HASH_THRESHOLD(hash->count + 1, hash->size)) {
+			unsigned int new_size = hash->size * 2;
+
+			if (!hash->max_size || new_size <= hash->max_size) {
+				hash_rehash_start(hash, new_size);
+				index = key & (hash->size - 1);
+			}
 		}
 
 		bucket = XCALLOC(MTYPE_HASH_BACKET, sizeof(struct hash_bucket));
@@ -194,6 +239,19 @@ unsigned int string_hash_make(const char *str)
 	return hash;
 }
 
+/* halve the table if churn has left it mostly empty */
+static void hash_maybe_shrink(struct hash *hash)
+{
+	if (hash->old_index || hash->iterating)
+		return;
+	if (hash->size <= HASH_INITIAL_SIZE)
+		return;
+	if (!HASH_SHRINK_THRESHOLD(hash->count, hash->size))
+		return;
+
+	hash_rehash_start(hash, hash->size / 2);
+}
+
 void *hash_release(struct hash *hash, void *data)
 {
 	void *ret;
@@ -202,6 +260,8 @@ void *hash_release(struct hash *hash, void *data)
 	struct hash_bucket *bucket;
 	struct hash_bucket *pp;
 
+	hash_rehash_step(hash);
+
 	key = (*hash->hash_key)(data);
 	index = key & (hash->size - 1);
 
@@ -226,10 +286,36 @@ void *hash_release(struct hash *hash, void *data)
 			ret = bucket->data;
 			XFREE(MTYPE_HASH_BACKET, bucket);
 			hash->count--;
+			hash_maybe_shrink(hash);
 			return ret;
 		}
 		pp = bucket;
 	}
+
+	/* old-table chains are not part of the distribution stats (they
+	 * were reset when the rehash started), so removal there is just
+	 * an unlink */
+	if (hash->old_index) {
+		index = key & (hash->old_size - 1);
+
+		for (bucket = pp = hash->old_index[index]; bucket;
+		     bucket = bucket->next) {
+			if (bucket->key == key
+			    && (*hash->hash_cmp)(bucket->data, data)) {
+				if (bucket == pp)
+					hash->old_index[index] = bucket->next;
+				else
+					pp->next = bucket->next;
+
+				ret = bucket->data;
+				XFREE(MTYPE_HASH_BACKET, bucket);
+				hash->count--;
+				return ret;
+			}
+			pp = bucket;
+		}
+	}
+
 	return NULL;
 }
 
@@ -240,6 +326,10 @@ void hash_iterate(struct hash *hash, void (*func)(struct hash_bucket *, void *),
 	struct hash_bucket *hb;
 	struct hash_bucket *hbnext;
 
+	/* pause migration: (*func) may call hash_release, and entries
+	 * hopping between the arrays would be visited twice or skipped */
+	hash->iterating++;
+
 	for (i = 0; i < hash->size; i++)
 		for (hb = hash->index[i]; hb; hb = hbnext) {
 			/* get pointer to next hash bucket here, in case (*func)
@@ -248,6 +338,14 @@ void hash_iterate(struct hash *hash, void (*func)(struct hash_bucket *, void *),
 			hbnext = hb->next;
 			(*func)(hb, arg);
 		}
+
+	for (i = hash->rehash_pos; hash->old_index && i < hash->old_size; i++)
+		for (hb = hash->old_index[i]; hb; hb = hbnext) {
+			hbnext = hb->next;
+			(*func)(hb, arg);
+		}
+
+	hash->iterating--;
 }
 
 void hash_walk(struct hash *hash, int (*func)(struct hash_bucket *, void *),
@@ -258,6 +356,9 @@ void hash_walk(struct hash *hash, int (*func)(struct hash_bucket *, void *),
 	struct hash_bucket *hbnext;
 	int ret = HASHWALK_CONTINUE;
 
+	/* see hash_iterate() */
+	hash->iterating++;
+
 	for (i = 0; i < hash->size; i++) {
 		for (hb = hash->index[i]; hb; hb = hbnext) {
 			/* get pointer to next hash bucket here, in case (*func)
@@ -266,9 +367,21 @@ void hash_walk(struct hash *hash, int (*func)(struct hash_bucket *, void *),
 			hbnext = hb->next;
 			ret = (*func)(hb, arg);
 			if (ret == HASHWALK_ABORT)
-				return;
+				goto done;
+		}
+	}
+
+	for (i = hash->rehash_pos; hash->old_index && i < hash->old_size; i++) {
+		for (hb = hash->old_index[i]; hb; hb = hbnext) {
+			hbnext = hb->next;
+			ret = (*func)(hb, arg);
+			if (ret == HASHWALK_ABORT)
+				goto done;
 		}
 	}
+
+done:
+	hash->iterating--;
 }
 
 void hash_clean(struct hash *hash, void (*free_func)(void *))
@@ -290,6 +403,23 @@ void hash_clean(struct hash *hash, void (*free_func)(void *))
 		hash->index[i] = NULL;
 	}
 
+	/* emptying the table also ends any rehash in progress */
+	if (hash->old_index) {
+		for (i = hash->rehash_pos; i < hash->old_size; i++)
+			for (hb = hash->old_index[i]; hb; hb = next) {
+				next = hb->next;
+
+				if (free_func)
+					(*free_func)(hb->data);
+
+				XFREE(MTYPE_HASH_BACKET, hb);
+				hash->count--;
+			}
+		XFREE(MTYPE_HASH_INDEX, hash->old_index);
+		hash->old_index = NULL;
+		hash->old_size = 0;
+	}
+
 	hash->stats.ssq = 0;
 	hash->stats.empty = hash->size;
 }
@@ -325,6 +455,7 @@ void hash_free(struct hash *hash)
 	XFREE(MTYPE_HASH, hash->name);
 
 	XFREE(MTYPE_HASH_INDEX, hash->index);
+	XFREE(MTYPE_HASH_INDEX, hash->old_index);
 	XFREE(MTYPE_HASH, hash);
 }
 
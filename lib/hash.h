@@ -35,6 +35,10 @@ DECLARE_MTYPE(HASH_BACKET)
 #define HASH_INITIAL_SIZE 256
 /* Expansion threshold */
 #define HASH_THRESHOLD(used, size) ((used) > (size))
+/* Shrink threshold: a table under 1/8 full after churn is halved, one
+ * step at a time.  The gap to the expansion threshold gives hysteresis.
+ */
+#define HASH_SHRINK_THRESHOLD(used, size) ((used) < ((size) / 8))
 
 #define HASHWALK_CONTINUE 0
 #define HASHWALK_ABORT -1
@@ -75,6 +79,22 @@ struct hash {
 	/* Hash table size. Must be power of 2 */
 	unsigned int size;
 
+	/* Previous bucket array while an incremental rehash is in
+	 * progress, NULL otherwise.  Lookups check both arrays; each
+	 * modifying operation migrates a few slots over to index, so a
+	 * resize is amortized instead of stalling whoever tripped the
+	 * threshold. */
+	struct hash_bucket **old_index;
+	unsigned int old_size;
+
+	/* next old_index slot to migrate */
+	unsigned int rehash_pos;
+
+	/* nonzero while a walk is in progress; pauses migration so that
+	 * deletions from within the walk stay safe and every entry is
+	 * visited exactly once */
+	unsigned int iterating;
+
 	/* If max_size is 0 there is no limit */
 	unsigned int max_size;
 
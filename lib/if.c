@@ -44,6 +44,7 @@ DEFINE_MTYPE_STATIC(LIB, CONNECTED, "Connected")
 DEFINE_MTYPE_STATIC(LIB, NBR_CONNECTED, "Neighbor Connected")
 DEFINE_MTYPE(LIB, CONNECTED_LABEL, "Connected interface label")
 DEFINE_MTYPE_STATIC(LIB, IF_LINK_PARAMS, "Informational Link Parameters")
+DEFINE_MTYPE_STATIC(LIB, IF_INDEX_PAGE, "Interface index lookup page")
 
 static int if_cmp_func(const struct interface *, const struct interface *);
 static int if_cmp_index_func(const struct interface *ifp1,
@@ -161,6 +162,60 @@ struct interface *if_create(const char *name, vrf_id_t vrf_id)
 	return ifp;
 }
 
+/* Direct-mapped mirror of the per-VRF ifindex tree: pages of
+ * IF_INDEX_PAGE_SIZE slots, allocated only for index ranges that are
+ * actually populated, so high ifindexes don't cost a huge flat array.
+ * The mirror is updated wherever the RB tree is, making
+ * if_lookup_by_index() a constant-time load. */
+#define IF_INDEX_PAGE_SHIFT 10
+#define IF_INDEX_PAGE_SIZE  (1U << IF_INDEX_PAGE_SHIFT)
+#define IF_INDEX_PAGE_MASK  (IF_INDEX_PAGE_SIZE - 1)
+
+static void if_index_array_set(struct vrf *vrf, ifindex_t ifindex,
+			       struct interface *ifp)
+{
+	uint32_t page;
+
+	if (ifindex <= 0)
+		return;
+
+	page = (uint32_t)ifindex >> IF_INDEX_PAGE_SHIFT;
+	if (page >= vrf->if_index_npages) {
+		uint32_t npages = page + 1;
+
+		if (!ifp)
+			return;
+		vrf->if_index_pages =
+			XREALLOC(MTYPE_IF_INDEX_PAGE, vrf->if_index_pages,
+				 npages * sizeof(struct interface **));
+		memset(&vrf->if_index_pages[vrf->if_index_npages], 0,
+		       (npages - vrf->if_index_npages)
+			       * sizeof(struct interface **));
+		vrf->if_index_npages = npages;
+	}
+
+	if (!vrf->if_index_pages[page]) {
+		if (!ifp)
+			return;
+		vrf->if_index_pages[page] = XCALLOC(
+			MTYPE_IF_INDEX_PAGE,
+			IF_INDEX_PAGE_SIZE * sizeof(struct interface *));
+	}
+
+	vrf->if_index_pages[page][(uint32_t)ifindex & IF_INDEX_PAGE_MASK] =
+		ifp;
+}
+
+static void if_index_array_free(struct vrf *vrf)
+{
+	uint32_t i;
+
+	for (i = 0; i < vrf->if_index_npages; i++)
+		XFREE(MTYPE_IF_INDEX_PAGE, vrf->if_index_pages[i]);
+	XFREE(MTYPE_IF_INDEX_PAGE, vrf->if_index_pages);
+	vrf->if_index_npages = 0;
+}
+
 /* Create new interface structure. */
 void if_update_to_new_vrf(struct interface *ifp, vrf_id_t vrf_id)
 {
@@ -170,16 +225,20 @@ void if_update_to_new_vrf(struct interface *ifp, vrf_id_t vrf_id)
 	old_vrf = vrf_lookup_by_id(ifp->vrf_id);
 	if (old_vrf) {
 		IFNAME_RB_REMOVE(old_vrf, ifp);
-		if (ifp->ifindex != IFINDEX_INTERNAL)
+		if (ifp->ifindex != IFINDEX_INTERNAL) {
 			IFINDEX_RB_REMOVE(old_vrf, ifp);
+			if_index_array_set(old_vrf, ifp->ifindex, NULL);
+		}
 	}
 
 	ifp->vrf_id = vrf_id;
 	vrf = vrf_get(ifp->vrf_id, NULL);
 
 	IFNAME_RB_INSERT(vrf, ifp);
-	if (ifp->ifindex != IFINDEX_INTERNAL)
+	if (ifp->ifindex != IFINDEX_INTERNAL) {
 		IFINDEX_RB_INSERT(vrf, ifp);
+		if_index_array_set(vrf, ifp->ifindex, ifp);
+	}
 
 	/*
 	 * HACK: Change the interface VRF in the running configuration directly,
@@ -224,8 +283,10 @@ void if_delete(struct interface *ifp)
 	assert(vrf);
 
 	IFNAME_RB_REMOVE(vrf, ifp);
-	if (ifp->ifindex != IFINDEX_INTERNAL)
+	if (ifp->ifindex != IFINDEX_INTERNAL) {
 		IFINDEX_RB_REMOVE(vrf, ifp);
+		if_index_array_set(vrf, ifp->ifindex, NULL);
+	}
 
 	if_delete_retain(ifp);
 
@@ -244,11 +305,23 @@ struct interface *if_lookup_by_index(ifindex_t ifindex, vrf_id_t vrf_id)
 {
 	struct vrf *vrf;
 	struct interface if_tmp;
+	uint32_t page;
 
 	vrf = vrf_lookup_by_id(vrf_id);
 	if (!vrf)
 		return NULL;
 
+	/* The direct-mapped mirror is authoritative for real indexes;
+	 * only kernel-less interfaces (IFINDEX_INTERNAL) fall back to
+	 * the tree, which they are not part of either. */
+	if (ifindex > 0) {
+		page = (uint32_t)ifindex >> IF_INDEX_PAGE_SHIFT;
+		if (page < vrf->if_index_npages && vrf->if_index_pages[page])
+			return vrf->if_index_pages[page]
+				[(uint32_t)ifindex & IF_INDEX_PAGE_MASK];
+		return NULL;
+	}
+
 	if_tmp.ifindex = ifindex;
 	return RB_FIND(if_index_head, &vrf->ifaces_by_index, &if_tmp);
 }
@@ -428,13 +501,17 @@ void if_set_index(struct interface *ifp, ifindex_t ifindex)
 	if (ifp->ifindex == ifindex)
 		return;
 
-	if (ifp->ifindex != IFINDEX_INTERNAL)
+	if (ifp->ifindex != IFINDEX_INTERNAL) {
 		IFINDEX_RB_REMOVE(vrf, ifp)
+		if_index_array_set(vrf, ifp->ifindex, NULL);
+	}
 
 	ifp->ifindex = ifindex;
 
-	if (ifp->ifindex != IFINDEX_INTERNAL)
+	if (ifp->ifindex != IFINDEX_INTERNAL) {
 		IFINDEX_RB_INSERT(vrf, ifp)
+		if_index_array_set(vrf, ifp->ifindex, ifp);
+	}
 }
 
 /* Does interface up ? */
@@ -967,6 +1044,8 @@ void if_terminate(struct vrf *vrf)
 		}
 		if_delete(ifp);
 	}
+
+	if_index_array_free(vrf);
 }
 
 const char *if_link_type_str(enum zebra_link_type llt)
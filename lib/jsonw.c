@@ -0,0 +1,381 @@
+/*
+ * Streaming JSON/CBOR writer.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "buffer.h"
+#include "memory.h"
+#include "vty.h"
+#include "jsonw.h"
+
+DEFINE_MTYPE_STATIC(LIB, JSONW, "Streaming JSON writer")
+
+/* deep enough for any of our show commands; jsonw_start_* asserts */
+#define JSONW_MAX_DEPTH 64
+
+struct json_writer {
+	struct vty *vty;
+	enum jsonw_encoding enc;
+
+	/* number of currently open containers */
+	unsigned int depth;
+	/* bit N set: nothing written yet into the container at depth N */
+	uint64_t first;
+	/* JSON only: jsonw_name() already placed the separators */
+	bool pending_key;
+
+	size_t len;
+	char buf[4096];
+};
+
+static void jsonw_flush(struct json_writer *jw)
+{
+	if (!jw->len)
+		return;
+
+	if (jw->enc == JSONW_CBOR) {
+		/* binary output cannot go through vty_out(); hand it to
+		 * the vty buffering layer (or stdout for vtysh) as-is */
+		if (jw->vty->type == VTY_SHELL) {
+			fwrite(jw->buf, 1, jw->len, jw->vty->of);
+			fflush(jw->vty->of);
+		} else
+			buffer_put(jw->vty->obuf, jw->buf, jw->len);
+	} else
+		vty_out(jw->vty, "%.*s", (int)jw->len, jw->buf);
+
+	jw->len = 0;
+}
+
+static void jsonw_put(struct json_writer *jw, const void *data, size_t len)
+{
+	const char *p = data;
+	size_t chunk;
+
+	while (len) {
+		if (jw->len == sizeof(jw->buf))
+			jsonw_flush(jw);
+
+		chunk = MIN(len, sizeof(jw->buf) - jw->len);
+		memcpy(jw->buf + jw->len, p, chunk);
+		jw->len += chunk;
+		p += chunk;
+		len -= chunk;
+	}
+}
+
+static void jsonw_putc(struct json_writer *jw, char c)
+{
+	jsonw_put(jw, &c, 1);
+}
+
+/* comma/newline/indent bookkeeping before each key or value; matches the
+ * json-c pretty printer so converted commands keep their output. */
+static void jsonw_elem(struct json_writer *jw)
+{
+	unsigned int i;
+
+	if (jw->enc != JSONW_JSON)
+		return;
+
+	if (jw->pending_key) {
+		jw->pending_key = false;
+		return;
+	}
+
+	if (!jw->depth)
+		return;
+
+	if (jw->first & (1ULL << jw->depth))
+		jw->first &= ~(1ULL << jw->depth);
+	else
+		jsonw_putc(jw, ',');
+
+	jsonw_putc(jw, '\n');
+	for (i = 0; i < jw->depth; i++)
+		jsonw_put(jw, "  ", 2);
+}
+
+/* quoted JSON string; same escape set as json-c's default, which
+ * includes the forward slash (see the NOSLASHESCAPE note in json.h) */
+static void jsonw_puts_json(struct json_writer *jw, const char *s)
+{
+	char esc[8];
+
+	jsonw_putc(jw, '"');
+	for (; *s; s++) {
+		switch (*s) {
+		case '"':
+			jsonw_put(jw, "\\\"", 2);
+			break;
+		case '\\':
+			jsonw_put(jw, "\\\\", 2);
+			break;
+		case '/':
+			jsonw_put(jw, "\\/", 2);
+			break;
+		case '\b':
+			jsonw_put(jw, "\\b", 2);
+			break;
+		case '\f':
+			jsonw_put(jw, "\\f", 2);
+			break;
+		case '\n':
+			jsonw_put(jw, "\\n", 2);
+			break;
+		case '\r':
+			jsonw_put(jw, "\\r", 2);
+			break;
+		case '\t':
+			jsonw_put(jw, "\\t", 2);
+			break;
+		default:
+			if ((unsigned char)*s < 0x20) {
+				snprintf(esc, sizeof(esc), "\\u%04x",
+					 (unsigned char)*s);
+				jsonw_put(jw, esc, 6);
+			} else
+				jsonw_putc(jw, *s);
+			break;
+		}
+	}
+	jsonw_putc(jw, '"');
+}
+
+/* CBOR item head: major type plus length/value (RFC 7049 section 2.1) */
+static void jsonw_cbor_head(struct json_writer *jw, uint8_t major,
+			    uint64_t val)
+{
+	uint8_t head[9];
+	size_t len;
+
+	if (val < 24) {
+		head[0] = major | val;
+		len = 1;
+	} else if (val <= 0xff) {
+		head[0] = major | 24;
+		head[1] = val;
+		len = 2;
+	} else if (val <= 0xffff) {
+		head[0] = major | 25;
+		head[1] = val >> 8;
+		head[2] = val;
+		len = 3;
+	} else if (val <= 0xffffffffULL) {
+		head[0] = major | 26;
+		head[1] = val >> 24;
+		head[2] = val >> 16;
+		head[3] = val >> 8;
+		head[4] = val;
+		len = 5;
+	} else {
+		head[0] = major | 27;
+		head[1] = val >> 56;
+		head[2] = val >> 48;
+		head[3] = val >> 40;
+		head[4] = val >> 32;
+		head[5] = val >> 24;
+		head[6] = val >> 16;
+		head[7] = val >> 8;
+		head[8] = val;
+		len = 9;
+	}
+	jsonw_put(jw, head, len);
+}
+
+static void jsonw_puts_cbor(struct json_writer *jw, const char *s)
+{
+	size_t len = strlen(s);
+
+	jsonw_cbor_head(jw, 0x60, len); /* text string */
+	jsonw_put(jw, s, len);
+}
+
+struct json_writer *jsonw_new(struct vty *vty, enum jsonw_encoding enc)
+{
+	struct json_writer *jw;
+
+	jw = XCALLOC(MTYPE_JSONW, sizeof(struct json_writer));
+	jw->vty = vty;
+	jw->enc = enc;
+
+	return jw;
+}
+
+void jsonw_destroy(struct json_writer **jw)
+{
+	assert((*jw)->depth == 0);
+
+	if ((*jw)->enc == JSONW_JSON)
+		jsonw_putc(*jw, '\n');
+	jsonw_flush(*jw);
+
+	XFREE(MTYPE_JSONW, *jw);
+}
+
+static void jsonw_start(struct json_writer *jw, char brace, uint8_t cbor)
+{
+	jsonw_elem(jw);
+
+	assert(jw->depth < JSONW_MAX_DEPTH - 1);
+	if (jw->enc == JSONW_CBOR)
+		jsonw_putc(jw, cbor);
+	else
+		jsonw_putc(jw, brace);
+
+	jw->depth++;
+	jw->first |= 1ULL << jw->depth;
+}
+
+static void jsonw_end(struct json_writer *jw, char brace)
+{
+	bool had_children;
+	unsigned int i;
+
+	assert(jw->depth > 0);
+	had_children = !(jw->first & (1ULL << jw->depth));
+	jw->first &= ~(1ULL << jw->depth);
+	jw->depth--;
+
+	if (jw->enc == JSONW_CBOR) {
+		jsonw_putc(jw, (char)0xff); /* "break" */
+		return;
+	}
+
+	if (had_children) {
+		jsonw_putc(jw, '\n');
+		for (i = 0; i < jw->depth; i++)
+			jsonw_put(jw, "  ", 2);
+	}
+	jsonw_putc(jw, brace);
+}
+
+void jsonw_start_object(struct json_writer *jw)
+{
+	jsonw_start(jw, '{', 0xbf); /* indefinite-length map */
+}
+
+void jsonw_end_object(struct json_writer *jw)
+{
+	jsonw_end(jw, '}');
+}
+
+void jsonw_start_array(struct json_writer *jw)
+{
+	jsonw_start(jw, '[', 0x9f); /* indefinite-length array */
+}
+
+void jsonw_end_array(struct json_writer *jw)
+{
+	jsonw_end(jw, ']');
+}
+
+void jsonw_name(struct json_writer *jw, const char *name)
+{
+	jsonw_elem(jw);
+
+	if (jw->enc == JSONW_CBOR) {
+		jsonw_puts_cbor(jw, name);
+		return;
+	}
+
+	jsonw_puts_json(jw, name);
+	jsonw_putc(jw, ':');
+	jw->pending_key = true;
+}
+
+void jsonw_string(struct json_writer *jw, const char *val)
+{
+	jsonw_elem(jw);
+
+	if (jw->enc == JSONW_CBOR)
+		jsonw_puts_cbor(jw, val);
+	else
+		jsonw_puts_json(jw, val);
+}
+
+void jsonw_int(struct json_writer *jw, int64_t val)
+{
+	char num[24];
+
+	jsonw_elem(jw);
+
+	if (jw->enc == JSONW_CBOR) {
+		if (val < 0)
+			jsonw_cbor_head(jw, 0x20, -1 - (uint64_t)val);
+		else
+			jsonw_cbor_head(jw, 0x00, val);
+		return;
+	}
+
+	jsonw_put(jw, num, snprintf(num, sizeof(num), "%" PRId64, val));
+}
+
+void jsonw_uint(struct json_writer *jw, uint64_t val)
+{
+	char num[24];
+
+	jsonw_elem(jw);
+
+	if (jw->enc == JSONW_CBOR) {
+		jsonw_cbor_head(jw, 0x00, val);
+		return;
+	}
+
+	jsonw_put(jw, num, snprintf(num, sizeof(num), "%" PRIu64, val));
+}
+
+void jsonw_bool(struct json_writer *jw, bool val)
+{
+	jsonw_elem(jw);
+
+	if (jw->enc == JSONW_CBOR) {
+		jsonw_putc(jw, (char)(val ? 0xf5 : 0xf4));
+		return;
+	}
+
+	if (val)
+		jsonw_put(jw, "true", 4);
+	else
+		jsonw_put(jw, "false", 5);
+}
+
+void jsonw_string_add(struct json_writer *jw, const char *key, const char *val)
+{
+	jsonw_name(jw, key);
+	jsonw_string(jw, val);
+}
+
+void jsonw_int_add(struct json_writer *jw, const char *key, int64_t val)
+{
+	jsonw_name(jw, key);
+	jsonw_int(jw, val);
+}
+
+void jsonw_boolean_true_add(struct json_writer *jw, const char *key)
+{
+	jsonw_name(jw, key);
+	jsonw_bool(jw, true);
+}
+
+void jsonw_boolean_false_add(struct json_writer *jw, const char *key)
+{
+	jsonw_name(jw, key);
+	jsonw_bool(jw, false);
+}
@@ -0,0 +1,91 @@
+/*
+ * Streaming JSON/CBOR writer.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _ZEBRA_JSONW_H
+#define _ZEBRA_JSONW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vty;
+
+/*
+ * Push-style encoder that writes structured output straight into the
+ * vty output buffer, as opposed to the lib/json.h wrappers which build
+ * a full json-c object tree first.  On large tables (e.g. a full BGP
+ * feed in zebra) the tree costs one allocation per key and value and
+ * is only freed after the dump completes; the writer keeps memory use
+ * constant no matter how big the output is.
+ *
+ * The JSON encoding matches what json-c produces for
+ * JSON_C_TO_STRING_PRETTY, including the escaped forward slashes, so
+ * converting a command does not change its output.  CBOR (RFC 7049) is
+ * available for machine consumers that would rather not parse text;
+ * containers use the indefinite-length encoding since the writer does
+ * not know element counts up front.
+ *
+ * The caller is responsible for well-formedness: every value except
+ * the outermost one must be preceded by jsonw_name() when the
+ * enclosing container is an object, and start/end calls must balance
+ * by the time jsonw_destroy() runs.
+ */
+
+enum jsonw_encoding {
+	JSONW_JSON = 0,
+	JSONW_CBOR,
+};
+
+struct json_writer;
+
+#define CBOR_STR "Concise Binary Object Representation output\n"
+
+extern struct json_writer *jsonw_new(struct vty *vty, enum jsonw_encoding enc);
+/* flushes remaining output; for JSON also emits the trailing newline */
+extern void jsonw_destroy(struct json_writer **jw);
+
+extern void jsonw_start_object(struct json_writer *jw);
+extern void jsonw_end_object(struct json_writer *jw);
+extern void jsonw_start_array(struct json_writer *jw);
+extern void jsonw_end_array(struct json_writer *jw);
+
+/* key of the next value inside an object */
+extern void jsonw_name(struct json_writer *jw, const char *name);
+
+extern void jsonw_string(struct json_writer *jw, const char *val);
+extern void jsonw_int(struct json_writer *jw, int64_t val);
+extern void jsonw_uint(struct json_writer *jw, uint64_t val);
+extern void jsonw_bool(struct json_writer *jw, bool val);
+
+/* key/value shorthands mirroring the json_object_*_add() wrappers */
+extern void jsonw_string_add(struct json_writer *jw, const char *key,
+			     const char *val);
+extern void jsonw_int_add(struct json_writer *jw, const char *key,
+			  int64_t val);
+extern void jsonw_boolean_true_add(struct json_writer *jw, const char *key);
+extern void jsonw_boolean_false_add(struct json_writer *jw, const char *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ZEBRA_JSONW_H */
@@ -82,6 +82,7 @@ enum lib_log_refs {
 	EC_LIB_LIBSYSREPO,
 	EC_LIB_ID_CONSISTENCY,
 	EC_LIB_ID_EXHAUST,
+	EC_LIB_RESOLVER,
 };
 
 extern void lib_error_init(void);
@@ -40,6 +40,7 @@
 #include "northbound_cli.h"
 
 DEFINE_HOOK(frr_late_init, (struct thread_master * tm), (tm))
+DEFINE_HOOK(frr_config_read_done, (struct thread_master * tm), (tm))
 DEFINE_KOOH(frr_early_fini, (), ())
 DEFINE_KOOH(frr_fini, (), ())
 
@@ -808,8 +809,17 @@ static void frr_daemonize(void)
  * to read the config in after thread execution starts, so that
  * we can match this behavior.
  */
+static bool config_read_active;
+
+bool frr_config_read_in_progress(void)
+{
+	return config_read_active;
+}
+
 static int frr_config_read_in(struct thread *t)
 {
+	config_read_active = true;
+
 	if (!vty_read_config(NULL, di->config_file, config_default) &&
 	    di->backup_config_file) {
 		char *orig = XSTRDUP(MTYPE_TMP, host_config_get());
@@ -822,6 +832,9 @@ static int frr_config_read_in(struct thread *t)
 		XFREE(MTYPE_TMP, orig);
 	}
 
+	config_read_active = false;
+	hook_call(frr_config_read_done, master);
+
 	/*
 	 * Update the shared candidate after reading the startup configuration.
 	 */
@@ -129,7 +129,14 @@ extern const char *frr_get_progname(void);
 extern enum frr_cli_mode frr_get_cli_mode(void);
 
 DECLARE_HOOK(frr_late_init, (struct thread_master * tm), (tm))
+/* Fired after the startup (or backup) configuration has been fully read
+ * in, so daemons can run in one pass what they deferred while
+ * frr_config_read_in_progress() was true.
+ */
+DECLARE_HOOK(frr_config_read_done, (struct thread_master * tm), (tm))
 extern void frr_config_fork(void);
+/* True while the startup configuration file is being read in. */
+extern bool frr_config_read_in_progress(void);
 
 extern void frr_run(struct thread_master *master);
 extern void frr_detach(void);
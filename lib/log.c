@@ -26,6 +26,7 @@
 #include "zclient.h"
 #include "log.h"
 #include "log_int.h"
+#include "frrfmt.h"
 #include "memory.h"
 #include "command.h"
 #include "lib_errors.h"
@@ -119,40 +120,41 @@ const char *lookup_msg(const struct message *mz, int kz, const char *nf)
 	return rz;
 }
 
-/* For time string format. */
-size_t quagga_timestamp(int timestamp_precision, char *buf, size_t buflen)
-{
-	static struct {
-		time_t last;
-		size_t len;
-		char buf[28];
-	} cache;
-	struct timeval clock;
-
-	gettimeofday(&clock, NULL);
+struct ts_cache {
+	time_t last;
+	size_t len;
+	char buf[28];
+};
 
+/* Render a given wall-clock time; the per-second strftime() result is
+ * memoized in the caller-owned cache, so each caller must pass its own
+ * if it runs outside the log mutex. */
+static size_t timestamp_render(struct ts_cache *cache, struct timeval clock,
+			       int timestamp_precision, char *buf,
+			       size_t buflen)
+{
 	/* first, we update the cache if the time has changed */
-	if (cache.last != clock.tv_sec) {
+	if (cache->last != clock.tv_sec) {
 		struct tm *tm;
-		cache.last = clock.tv_sec;
-		tm = localtime(&cache.last);
-		cache.len = strftime(cache.buf, sizeof(cache.buf),
-				     "%Y/%m/%d %H:%M:%S", tm);
+		cache->last = clock.tv_sec;
+		tm = localtime(&cache->last);
+		cache->len = strftime(cache->buf, sizeof(cache->buf),
+				      "%Y/%m/%d %H:%M:%S", tm);
 	}
 	/* note: it's not worth caching the subsecond part, because
 	   chances are that back-to-back calls are not sufficiently close
 	   together
 	   for the clock not to have ticked forward */
 
-	if (buflen > cache.len) {
-		memcpy(buf, cache.buf, cache.len);
+	if (buflen > cache->len) {
+		memcpy(buf, cache->buf, cache->len);
 		if ((timestamp_precision > 0)
-		    && (buflen > cache.len + 1 + timestamp_precision)) {
+		    && (buflen > cache->len + 1 + timestamp_precision)) {
 			/* should we worry about locale issues? */
 			static const int divisor[] = {0,   100000, 10000, 1000,
 						      100, 10,     1};
 			int prec;
-			char *p = buf + cache.len + 1
+			char *p = buf + cache->len + 1
 				  + (prec = timestamp_precision);
 			*p-- = '\0';
 			while (prec > 6)
@@ -167,16 +169,27 @@ size_t quagga_timestamp(int timestamp_precision, char *buf, size_t buflen)
 				clock.tv_usec /= 10;
 			} while (--prec > 0);
 			*p = '.';
-			return cache.len + 1 + timestamp_precision;
+			return cache->len + 1 + timestamp_precision;
 		}
-		buf[cache.len] = '\0';
-		return cache.len;
+		buf[cache->len] = '\0';
+		return cache->len;
 	}
 	if (buflen > 0)
 		buf[0] = '\0';
 	return 0;
 }
 
+/* For time string format. */
+size_t quagga_timestamp(int timestamp_precision, char *buf, size_t buflen)
+{
+	static struct ts_cache cache;
+	struct timeval clock;
+
+	gettimeofday(&clock, NULL);
+	return timestamp_render(&cache, clock, timestamp_precision, buf,
+				buflen);
+}
+
 /* Utility routine for current time printing. */
 static void time_print(FILE *fp, struct timestamp_control *ctl)
 {
@@ -191,86 +204,428 @@ static void time_print(FILE *fp, struct timestamp_control *ctl)
 
 static void vzlog_file(struct zlog *zl, struct timestamp_control *tsctl,
 		       const char *proto_str, int record_priority, int priority,
-		       FILE *fp, const char *format, va_list args)
+		       FILE *fp, const char *msg)
 {
-	va_list ac;
-
 	time_print(fp, tsctl);
 	if (record_priority)
 		fprintf(fp, "%s: ", zlog_priority[priority]);
 
-	fprintf(fp, "%s", proto_str);
+	fprintf(fp, "%s%s\n", proto_str, msg);
+	fflush(fp);
+}
+
+/*
+ * Render a log message through frr_vsnprintf(), so FRR's own
+ * conversions (%pFX and friends) work in any zlog format string.
+ * Returns stackbuf, or a MTYPE_TMP allocation when the message did not
+ * fit; the caller frees via vzlog_render_free().
+ */
+static char *vzlog_render(char *stackbuf, size_t size, const char *format,
+			  va_list args)
+{
+	char *msg = stackbuf;
+	va_list ac;
+	int len;
+
 	va_copy(ac, args);
-	vfprintf(fp, format, ac);
+	len = frr_vsnprintf(stackbuf, size, format, ac);
 	va_end(ac);
-	fprintf(fp, "\n");
-	fflush(fp);
+
+	if (len >= (int)size) {
+		msg = XMALLOC(MTYPE_TMP, (size_t)len + 1);
+		va_copy(ac, args);
+		frr_vsnprintf(msg, (size_t)len + 1, format, ac);
+		va_end(ac);
+	}
+	return msg;
+}
+
+static void vzlog_render_free(char *stackbuf, char *msg)
+{
+	if (msg != stackbuf)
+		XFREE(MTYPE_TMP, msg);
+}
+
+/* vty_log() takes a format + va_list; hand it the finished string. */
+static void vty_log_str(const char *level, const char *proto_str,
+			struct timestamp_control *tsctl, const char *format,
+			...) PRINTF_ATTRIBUTE(4, 5);
+static void vty_log_str(const char *level, const char *proto_str,
+			struct timestamp_control *tsctl, const char *format,
+			...)
+{
+	va_list ap;
+
+	va_start(ap, format);
+	vty_log(level, proto_str, format, tsctl, ap);
+	va_end(ap);
+}
+
+/*
+ * Asynchronous logging backend ("log async").
+ *
+ * When enabled, file-destined messages are appended as binary records
+ * (timestamp + priority + rendered text) to a per-pthread single
+ * producer / single consumer byte ring, and a dedicated flusher pthread
+ * renders them to text and writes the logfile.  Logging threads thus
+ * neither contend on the log mutex nor block on disk I/O; syslog,
+ * stdout/stderr and terminal-monitor output stay synchronous since they
+ * are either cheap or rare.
+ *
+ * Each ring is owned by exactly one producer thread (found via a
+ * pthread key) and drained only by the flusher, so head/tail are plain
+ * acquire/release atomics and no locking is involved on the log path.
+ * Rings are registered on a prepend-only list; they are never freed, so
+ * the flusher can walk a snapshot of the list head without holding the
+ * registration mutex.  A full ring drops the message and bumps a
+ * counter which the flusher reports into the logfile.
+ */
+
+#define ZLOG_ASYNC_BUFSZ (1 << 17) /* 128KiB per logging pthread */
+
+/* record header on the ring, followed by len bytes of message text */
+struct zlog_async_rec {
+	struct timeval tv;
+	uint16_t len;
+	uint8_t priority;
+};
+
+struct zlog_async_buf {
+	struct zlog_async_buf *next;
+
+	_Atomic uint32_t head;	  /* read position, owned by flusher */
+	_Atomic uint32_t tail;	  /* write position, owned by producer */
+	_Atomic uint32_t dropped; /* messages lost to a full ring */
+
+	char data[ZLOG_ASYNC_BUFSZ];
+};
+
+static pthread_mutex_t zlog_async_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct zlog_async_buf *zlog_async_bufs; /* under zlog_async_mtx */
+static pthread_key_t zlog_async_key;
+static pthread_t zlog_async_flusher;
+static bool zlog_async_started; /* flusher running, under zlog_async_mtx */
+
+/* producers check this alone on the fast path */
+static _Atomic bool zlog_async_on;
+/* tells the flusher to drain once more and exit */
+static _Atomic bool zlog_async_stop;
+
+static void zlog_async_copyin(struct zlog_async_buf *b, uint32_t pos,
+			      const void *src, size_t n)
+{
+	uint32_t off = pos & (ZLOG_ASYNC_BUFSZ - 1);
+	size_t first = MIN(n, (size_t)(ZLOG_ASYNC_BUFSZ - off));
+
+	memcpy(b->data + off, src, first);
+	if (n > first)
+		memcpy(b->data, (const char *)src + first, n - first);
+}
+
+static void zlog_async_copyout(struct zlog_async_buf *b, uint32_t pos,
+			       void *dst, size_t n)
+{
+	uint32_t off = pos & (ZLOG_ASYNC_BUFSZ - 1);
+	size_t first = MIN(n, (size_t)(ZLOG_ASYNC_BUFSZ - off));
+
+	memcpy(dst, b->data + off, first);
+	if (n > first)
+		memcpy((char *)dst + first, b->data, n - first);
+}
+
+/*
+ * Queue one rendered message onto the calling thread's ring.  Returns
+ * false when the backend is off (caller writes the file synchronously
+ * as before); a full ring counts as consumed so the message is not
+ * written twice.
+ */
+static bool zlog_async_enqueue(int priority, const char *msg)
+{
+	struct zlog_async_buf *b;
+	struct zlog_async_rec rec;
+	uint32_t head, tail;
+	size_t len, need;
+
+	if (!atomic_load_explicit(&zlog_async_on, memory_order_acquire))
+		return false;
+
+	b = pthread_getspecific(zlog_async_key);
+	if (!b) {
+		/* raw calloc: an MTYPE allocation failure would try to
+		 * log, i.e. recurse right back in here */
+		b = calloc(1, sizeof(*b));
+		if (!b)
+			return false;
+		pthread_setspecific(zlog_async_key, b);
+
+		pthread_mutex_lock(&zlog_async_mtx);
+		b->next = zlog_async_bufs;
+		zlog_async_bufs = b;
+		pthread_mutex_unlock(&zlog_async_mtx);
+	}
+
+	len = strlen(msg);
+	if (len > UINT16_MAX)
+		len = UINT16_MAX;
+	need = sizeof(rec) + len;
+
+	head = atomic_load_explicit(&b->head, memory_order_acquire);
+	tail = atomic_load_explicit(&b->tail, memory_order_relaxed);
+	if (ZLOG_ASYNC_BUFSZ - (tail - head) < need) {
+		atomic_fetch_add_explicit(&b->dropped, 1,
+					  memory_order_relaxed);
+		return true;
+	}
+
+	gettimeofday(&rec.tv, NULL);
+	rec.len = len;
+	rec.priority = priority;
+	zlog_async_copyin(b, tail, &rec, sizeof(rec));
+	zlog_async_copyin(b, tail + sizeof(rec), msg, len);
+	atomic_store_explicit(&b->tail, tail + (uint32_t)need,
+			      memory_order_release);
+	return true;
+}
+
+/* Write one dequeued record; called with loglock held. */
+static void zlog_async_emit(struct zlog *zl, struct ts_cache *cache,
+			    const struct zlog_async_rec *rec, const char *text)
+{
+	char tsbuf[40];
+
+	timestamp_render(cache, rec->tv, zl->timestamp_precision, tsbuf,
+			 sizeof(tsbuf));
+	fprintf(zl->fp, "%s ", tsbuf);
+	if (zl->record_priority)
+		fprintf(zl->fp, "%s: ", zlog_priority[rec->priority]);
+	if (zl->instance)
+		fprintf(zl->fp, "%s[%d]: %s\n", zl->protoname, zl->instance,
+			text);
+	else
+		fprintf(zl->fp, "%s: %s\n", zl->protoname, text);
+}
+
+/* Drain every registered ring into the logfile. */
+static void zlog_async_drain(void)
+{
+	/* only the flusher renders queued timestamps */
+	static struct ts_cache cache;
+	struct zlog_async_buf *b;
+
+	pthread_mutex_lock(&zlog_async_mtx);
+	b = zlog_async_bufs;
+	pthread_mutex_unlock(&zlog_async_mtx);
+
+	for (; b; b = b->next) {
+		uint32_t head, tail, dropped;
+		bool wrote = false;
+
+		head = atomic_load_explicit(&b->head, memory_order_relaxed);
+		tail = atomic_load_explicit(&b->tail, memory_order_acquire);
+		if (head == tail
+		    && !atomic_load_explicit(&b->dropped,
+					     memory_order_relaxed))
+			continue;
+
+		pthread_mutex_lock(&loglock);
+		while (head != tail) {
+			struct zlog_async_rec rec;
+			char text[UINT16_MAX + 1];
+
+			zlog_async_copyout(b, head, &rec, sizeof(rec));
+			zlog_async_copyout(b, head + sizeof(rec), text,
+					   rec.len);
+			text[rec.len] = '\0';
+			head += sizeof(rec) + rec.len;
+
+			/* discard (but still consume) if the logfile went
+			 * away meanwhile */
+			if (zlog_default && zlog_default->fp) {
+				zlog_async_emit(zlog_default, &cache, &rec,
+						text);
+				wrote = true;
+			}
+		}
+		dropped = atomic_exchange_explicit(&b->dropped, 0,
+						   memory_order_relaxed);
+		if (dropped && zlog_default && zlog_default->fp) {
+			fprintf(zlog_default->fp,
+				"%s: async log buffer overflow, %u messages dropped\n",
+				zlog_default->protoname, dropped);
+			wrote = true;
+		}
+		if (wrote)
+			fflush(zlog_default->fp);
+		pthread_mutex_unlock(&loglock);
+
+		atomic_store_explicit(&b->head, head, memory_order_release);
+	}
+}
+
+static void *zlog_async_flush_thread(void *arg)
+{
+	struct timespec wait = {.tv_sec = 0, .tv_nsec = 20 * 1000 * 1000};
+
+	while (!atomic_load_explicit(&zlog_async_stop, memory_order_relaxed)) {
+		nanosleep(&wait, NULL);
+		zlog_async_drain();
+	}
+	/* final drain so shutdown doesn't lose queued messages */
+	zlog_async_drain();
+	return NULL;
+}
+
+void zlog_async_set(bool enable)
+{
+	pthread_mutex_lock(&zlog_async_mtx);
+	if (enable && !zlog_async_started) {
+		pthread_key_create(&zlog_async_key, NULL);
+		atomic_store_explicit(&zlog_async_stop, false,
+				      memory_order_relaxed);
+		if (pthread_create(&zlog_async_flusher, NULL,
+				   zlog_async_flush_thread, NULL)
+		    == 0)
+			zlog_async_started = true;
+	}
+	/* Disabling just reroutes producers back to synchronous writes;
+	 * the flusher stays around to drain whatever is still queued. */
+	atomic_store_explicit(&zlog_async_on, enable && zlog_async_started,
+			      memory_order_release);
+	pthread_mutex_unlock(&zlog_async_mtx);
+}
+
+bool zlog_async_get(void)
+{
+	return atomic_load_explicit(&zlog_async_on, memory_order_relaxed);
+}
+
+/* Stop the flusher (draining first); called from closezlog(). */
+static void zlog_async_finish(void)
+{
+	bool started;
+
+	pthread_mutex_lock(&zlog_async_mtx);
+	started = zlog_async_started;
+	zlog_async_started = false;
+	pthread_mutex_unlock(&zlog_async_mtx);
+
+	if (!started)
+		return;
+
+	atomic_store_explicit(&zlog_async_on, false, memory_order_release);
+	atomic_store_explicit(&zlog_async_stop, true, memory_order_relaxed);
+	pthread_join(zlog_async_flusher, NULL);
 }
 
 /* va_list version of zlog. */
 void vzlog(int priority, const char *format, va_list args)
 {
-	pthread_mutex_lock(&loglock);
-
 	char proto_str[32];
+	char msgbuf[1024];
+	char *msg;
 	int original_errno = errno;
 	struct timestamp_control tsctl;
 	tsctl.already_rendered = 0;
 	struct zlog *zl = zlog_default;
+	bool startup_stderr = false;
+	bool file_dest = false, file_queued = false;
+
+	/* The level checks and the message rendering run without the log
+	 * mutex: the maxlvl fields are plain ints only changed from config
+	 * processing, so the worst case around a transition is one message
+	 * rendered needlessly or missed.  Keeping the formatting out of
+	 * the critical section is what lets concurrently logging pthreads
+	 * scale. */
+	if (zl != NULL) {
+		startup_stderr =
+			zlog_startup_stderr && priority <= LOG_WARNING;
+
+		/* Nobody will emit this message; skip the formatting
+		 * work entirely. */
+		if (priority > zl->maxlvl[ZLOG_DEST_SYSLOG]
+		    && (priority > zl->maxlvl[ZLOG_DEST_FILE] || !zl->fp)
+		    && !startup_stderr
+		    && priority > zl->maxlvl[ZLOG_DEST_STDOUT]
+		    && priority > zl->maxlvl[ZLOG_DEST_MONITOR]) {
+			errno = original_errno;
+			return;
+		}
+	}
+
+	/* Render once; every destination below takes the finished
+	 * string. */
+	msg = vzlog_render(msgbuf, sizeof(msgbuf), format, args);
 
 	/* call external hook */
 	hook_call(zebra_ext_log, priority, format, args);
 
 	/* When zlog_default is also NULL, use stderr for logging. */
 	if (zl == NULL) {
+		pthread_mutex_lock(&loglock);
 		tsctl.precision = 0;
 		time_print(stderr, &tsctl);
-		fprintf(stderr, "%s: ", "unknown");
-		vfprintf(stderr, format, args);
-		fprintf(stderr, "\n");
+		fprintf(stderr, "%s: %s\n", "unknown", msg);
 		fflush(stderr);
+		pthread_mutex_unlock(&loglock);
+		vzlog_render_free(msgbuf, msg);
 
 		/* In this case we return at here. */
 		errno = original_errno;
-		pthread_mutex_unlock(&loglock);
 		return;
 	}
 	tsctl.precision = zl->timestamp_precision;
 
-	/* Syslog output */
-	if (priority <= zl->maxlvl[ZLOG_DEST_SYSLOG]) {
-		va_list ac;
-		va_copy(ac, args);
-		vsyslog(priority | zlog_default->facility, format, ac);
-		va_end(ac);
+	/* File output goes through the per-thread ring when "log async"
+	 * is on; a queued (or dropped-on-overflow) message must not also
+	 * be written synchronously below. */
+	file_dest = (priority <= zl->maxlvl[ZLOG_DEST_FILE]) && zl->fp;
+	if (file_dest)
+		file_queued = zlog_async_enqueue(priority, msg);
+
+	/* If the file was the only destination and it is queued, we are
+	 * done without ever taking the log mutex. */
+	if (file_queued && priority > zl->maxlvl[ZLOG_DEST_SYSLOG]
+	    && !startup_stderr && priority > zl->maxlvl[ZLOG_DEST_STDOUT]
+	    && priority > zl->maxlvl[ZLOG_DEST_MONITOR]) {
+		vzlog_render_free(msgbuf, msg);
+		errno = original_errno;
+		return;
 	}
 
+	pthread_mutex_lock(&loglock);
+
+	/* Syslog output */
+	if (priority <= zl->maxlvl[ZLOG_DEST_SYSLOG])
+		syslog(priority | zlog_default->facility, "%s", msg);
+
 	if (zl->instance)
 		sprintf(proto_str, "%s[%d]: ", zl->protoname, zl->instance);
 	else
 		sprintf(proto_str, "%s: ", zl->protoname);
 
 	/* File output. */
-	if ((priority <= zl->maxlvl[ZLOG_DEST_FILE]) && zl->fp)
+	if (file_dest && !file_queued)
 		vzlog_file(zl, &tsctl, proto_str, zl->record_priority, priority,
-			   zl->fp, format, args);
+			   zl->fp, msg);
 
 	/* fixed-config logging to stderr while we're stating up & haven't
 	 * daemonized / reached mainloop yet
 	 *
 	 * note the "else" on stdout output -- we don't want to print the same
 	 * message to both stderr and stdout. */
-	if (zlog_startup_stderr && priority <= LOG_WARNING)
-		vzlog_file(zl, &tsctl, proto_str, 1, priority, stderr, format,
-			   args);
+	if (startup_stderr)
+		vzlog_file(zl, &tsctl, proto_str, 1, priority, stderr, msg);
 	else if (priority <= zl->maxlvl[ZLOG_DEST_STDOUT])
 		vzlog_file(zl, &tsctl, proto_str, zl->record_priority, priority,
-			   stdout, format, args);
+			   stdout, msg);
 
 	/* Terminal monitor. */
 	if (priority <= zl->maxlvl[ZLOG_DEST_MONITOR])
-		vty_log((zl->record_priority ? zlog_priority[priority] : NULL),
-			proto_str, format, &tsctl, args);
+		vty_log_str((zl->record_priority ? zlog_priority[priority]
+						 : NULL),
+			    proto_str, &tsctl, "%s", msg);
+
+	vzlog_render_free(msgbuf, msg);
 
 	errno = original_errno;
 	pthread_mutex_unlock(&loglock);
@@ -843,6 +1198,10 @@ void openzlog(const char *progname, const char *protoname,
 
 void closezlog(void)
 {
+	/* drain queued messages and stop the flusher before the logfile
+	 * goes away */
+	zlog_async_finish();
+
 	pthread_mutex_lock(&loglock);
 	struct zlog *zl = zlog_default;
 
@@ -1058,6 +1417,11 @@ static const struct zebra_desc_table command_types[] = {
 	DESC_ENTRY(ZEBRA_IPSET_ENTRY_ADD),
 	DESC_ENTRY(ZEBRA_IPSET_ENTRY_DELETE),
 	DESC_ENTRY(ZEBRA_VXLAN_FLOOD_CONTROL),
+	DESC_ENTRY(ZEBRA_ROUTE_ADD_BULK),
+	DESC_ENTRY(ZEBRA_SHM_HELLO),
+	DESC_ENTRY(ZEBRA_SHM_SWITCH),
+	DESC_ENTRY(ZEBRA_SHM_STRTAB_GET),
+	DESC_ENTRY(ZEBRA_SHM_STRTAB_ADD),
 };
 #undef DESC_ENTRY
 
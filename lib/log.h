@@ -120,6 +120,11 @@ extern int zlog_reset_file(void);
 /* Rotate log. */
 extern int zlog_rotate(void);
 
+/* Enable/disable the asynchronous (per-thread buffered) file logging
+   backend; disabling leaves already-queued messages to be flushed. */
+extern void zlog_async_set(bool enable);
+extern bool zlog_async_get(void);
+
 const char *lookup_msg(const struct message *mz, int kz, const char *nf);
 
 /* Safe version of strerror -- never returns NULL. */
@@ -133,7 +133,8 @@ void md5_init(md5_ctxt *ctxt)
 	ctxt->md5_stb = MD5_B0;
 	ctxt->md5_stc = MD5_C0;
 	ctxt->md5_std = MD5_D0;
-	memset(ctxt->md5_buf, 0, sizeof(ctxt->md5_buf));
+	/* no need to clear md5_buf: bytes are always written (by
+	 * md5_loop or md5_pad) before they are ever read */
 }
 
 void md5_loop(md5_ctxt *ctxt, const void *vinput, uint len)
@@ -145,10 +146,18 @@ void md5_loop(md5_ctxt *ctxt, const void *vinput, uint len)
 	gap = MD5_BUFLEN - ctxt->md5_i;
 
 	if (len >= gap) {
-		memcpy(ctxt->md5_buf + ctxt->md5_i, input, gap);
-		md5_calc(ctxt->md5_buf, ctxt);
-
-		for (i = gap; i + MD5_BUFLEN <= len; i += MD5_BUFLEN) {
+		/* finish a partial block from earlier input; with an
+		 * empty buffer (the common whole-packet case) full
+		 * blocks are hashed straight from the input instead of
+		 * being copied first */
+		if (ctxt->md5_i) {
+			memcpy(ctxt->md5_buf + ctxt->md5_i, input, gap);
+			md5_calc(ctxt->md5_buf, ctxt);
+			i = gap;
+		} else
+			i = 0;
+
+		for (; i + MD5_BUFLEN <= len; i += MD5_BUFLEN) {
 			md5_calc((input + i), ctxt);
 		}
 
@@ -61,7 +61,9 @@ static inline void mt_count_alloc(struct memtype *mt, size_t size, void *ptr)
 				      memory_order_relaxed);
 
 #ifdef HAVE_MALLOC_USABLE_SIZE
-	size_t mallocsz = malloc_usable_size(ptr);
+	/* pooled objects aren't malloc pointers;  their callers pass
+	 * ptr == NULL and the requested size is accounted instead. */
+	size_t mallocsz = ptr ? malloc_usable_size(ptr) : size;
 
 	current = mallocsz + atomic_fetch_add_explicit(&mt->total, mallocsz,
 						       memory_order_relaxed);
@@ -75,13 +77,13 @@ static inline void mt_count_alloc(struct memtype *mt, size_t size, void *ptr)
 #endif
 }
 
-static inline void mt_count_free(struct memtype *mt, void *ptr)
+static inline void mt_count_free(struct memtype *mt, void *ptr, size_t size)
 {
 	assert(mt->n_alloc);
 	atomic_fetch_sub_explicit(&mt->n_alloc, 1, memory_order_relaxed);
 
 #ifdef HAVE_MALLOC_USABLE_SIZE
-	size_t mallocsz = malloc_usable_size(ptr);
+	size_t mallocsz = ptr ? malloc_usable_size(ptr) : size;
 
 	atomic_fetch_sub_explicit(&mt->total, mallocsz, memory_order_relaxed);
 #endif
@@ -100,32 +102,176 @@ static inline void *mt_checkalloc(struct memtype *mt, void *ptr, size_t size)
 	return ptr;
 }
 
+/* slab pool backend (DEFINE_MTYPE_POOL)
+ *
+ * Every allocation on a pooled memtype - slab-carved or fallback - is
+ * prefixed with this header so qfree() can tell where to return it.
+ * 16 bytes on LP64, which keeps the payload suitably aligned.
+ */
+struct mempool_hdr {
+	struct mempool *pool;	/* NULL: plain malloc fallback */
+	size_t size;		/* requested payload size */
+};
+
+#define MEMPOOL_ALIGN	16U
+/* target chunk payload size;  amortizes the system allocator's
+ * per-block overhead across a few hundred objects */
+#define MEMPOOL_CHUNK	65536U
+
+/* carve another chunk into mp->free_list.  caller holds mp->lock. */
+static bool mempool_grow(struct mempool *mp)
+{
+	char *chunk, *obj;
+	size_t i;
+
+	chunk = malloc(MEMPOOL_ALIGN + mp->chunk_objs * mp->obj_size);
+	if (!chunk)
+		return false;
+
+	/* first MEMPOOL_ALIGN bytes chain the chunks for accounting */
+	*(void **)chunk = mp->chunks;
+	mp->chunks = chunk;
+	mp->n_chunks++;
+
+	obj = chunk + MEMPOOL_ALIGN;
+	for (i = 0; i < mp->chunk_objs; i++, obj += mp->obj_size) {
+		*(void **)obj = mp->free_list;
+		mp->free_list = obj;
+	}
+	mp->n_free += mp->chunk_objs;
+	return true;
+}
+
+static void *mempool_alloc(struct mempool *mp, size_t size)
+{
+	struct mempool_hdr *h = NULL;
+	size_t need = sizeof(struct mempool_hdr) + size;
+
+	pthread_mutex_lock(&mp->lock);
+	/* the first allocation locks in the object size;  it may still be
+	 * bumped by a larger request as long as no chunk was carved yet */
+	if (need > mp->obj_size && !mp->n_chunks) {
+		mp->obj_size = (need + MEMPOOL_ALIGN - 1) & ~(MEMPOOL_ALIGN - 1);
+		mp->chunk_objs = MEMPOOL_CHUNK / mp->obj_size;
+		if (mp->chunk_objs < 16)
+			mp->chunk_objs = 16;
+	}
+	if (need <= mp->obj_size) {
+		if (!mp->free_list)
+			mempool_grow(mp);
+		if (mp->free_list) {
+			h = mp->free_list;
+			mp->free_list = *(void **)h;
+			mp->n_free--;
+		}
+	}
+	pthread_mutex_unlock(&mp->lock);
+
+	if (h) {
+		h->pool = mp;
+	} else {
+		/* oversized for this pool, or chunk allocation failed */
+		h = malloc(need);
+		if (!h)
+			return NULL;
+		h->pool = NULL;
+	}
+	h->size = size;
+	return h + 1;
+}
+
+static void mempool_release(struct mempool_hdr *h)
+{
+	struct mempool *mp = h->pool;
+
+	if (!mp) {
+		free(h);
+		return;
+	}
+	pthread_mutex_lock(&mp->lock);
+	*(void **)h = mp->free_list;
+	mp->free_list = h;
+	mp->n_free++;
+	pthread_mutex_unlock(&mp->lock);
+}
+
+void qmem_pool_stats(struct mempool *mp, size_t *obj_size, size_t *n_free,
+		     size_t *n_chunks)
+{
+	pthread_mutex_lock(&mp->lock);
+	*obj_size = mp->obj_size;
+	*n_free = mp->n_free;
+	*n_chunks = mp->n_chunks;
+	pthread_mutex_unlock(&mp->lock);
+}
+
 void *qmalloc(struct memtype *mt, size_t size)
 {
+	if (mt->pool) {
+		void *ptr = mempool_alloc(mt->pool, size);
+
+		if (__builtin_expect(ptr == NULL, 0)) {
+			if (size)
+				memory_oom(size, mt->name);
+			return NULL;
+		}
+		/* NULL ptr: slab objects have no malloc_usable_size() */
+		mt_count_alloc(mt, size, NULL);
+		return ptr;
+	}
 	return mt_checkalloc(mt, malloc(size), size);
 }
 
 void *qcalloc(struct memtype *mt, size_t size)
 {
+	if (mt->pool)
+		return memset(qmalloc(mt, size), 0, size);
 	return mt_checkalloc(mt, calloc(size, 1), size);
 }
 
 void *qrealloc(struct memtype *mt, void *ptr, size_t size)
 {
+	if (mt->pool) {
+		struct mempool_hdr *h;
+		void *new;
+
+		if (!ptr)
+			return qmalloc(mt, size);
+		h = (struct mempool_hdr *)ptr - 1;
+		new = qmalloc(mt, size);
+		memcpy(new, ptr, MIN(size, h->size));
+		qfree(mt, ptr);
+		return new;
+	}
 	if (ptr)
-		mt_count_free(mt, ptr);
+		mt_count_free(mt, ptr, 0);
 	return mt_checkalloc(mt, ptr ? realloc(ptr, size) : malloc(size), size);
 }
 
 void *qstrdup(struct memtype *mt, const char *str)
 {
+	if (mt->pool) {
+		size_t len;
+		if (!str)
+			return NULL;
+		len = strlen(str) + 1;
+		return memcpy(qmalloc(mt, len), str, len);
+	}
 	return str ? mt_checkalloc(mt, strdup(str), strlen(str) + 1) : NULL;
 }
 
 void qfree(struct memtype *mt, void *ptr)
 {
-	if (ptr)
-		mt_count_free(mt, ptr);
+	if (!ptr)
+		return;
+	if (mt->pool) {
+		struct mempool_hdr *h = (struct mempool_hdr *)ptr - 1;
+
+		mt_count_free(mt, NULL, h->size);
+		mempool_release(h);
+		return;
+	}
+	mt_count_free(mt, ptr, 0);
 	free(ptr);
 }
 
@@ -19,6 +19,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <pthread.h>
 #include <frratomic.h>
 #include "compiler.h"
 
@@ -34,9 +35,29 @@ extern "C" {
 #endif
 
 #define SIZE_VAR ~0UL
+
+/* slab/pool backend for a memtype, opted into with DEFINE_MTYPE_POOL.
+ * Objects are carved out of larger chunks grabbed from the system
+ * allocator in bulk and recycled through a free list, so high-churn
+ * fixed-size types don't grind the system heap into fragments.  The
+ * object size is locked in by the first allocation;  requests that
+ * don't fit fall back to plain malloc transparently.
+ */
+struct mempool {
+	pthread_mutex_t lock;
+
+	void *free_list;	/* LIFO of recycled objects */
+	void *chunks;		/* chain of chunks, for accounting */
+	size_t obj_size;	/* object size incl. header, 0 = unsized */
+	size_t chunk_objs;	/* objects carved per chunk */
+	size_t n_free;		/* objects sitting on the free list */
+	size_t n_chunks;
+};
+
 struct memtype {
 	struct memtype *next, **ref;
 	const char *name;
+	struct mempool *pool;	/* NULL for plain malloc-backed types */
 	atomic_size_t n_alloc;
 	atomic_size_t n_max;
 	atomic_size_t size;
@@ -108,7 +129,7 @@ struct memgroup {
 	extern struct memtype _mt_##name;                                      \
 	static struct memtype *const MTYPE_##name = &_mt_##name;
 
-#define DEFINE_MTYPE_ATTR(group, mname, attr, desc)                            \
+#define DEFINE_MTYPE_ATTR(group, mname, attr, desc, ...)                       \
 	attr struct memtype _mt_##mname                                        \
 		__attribute__((section(".data.mtypes"))) = {                   \
 			.name = desc,                                          \
@@ -116,6 +137,7 @@ struct memgroup {
 			.n_alloc = 0,                                          \
 			.size = 0,                                             \
 			.ref = NULL,                                           \
+			__VA_ARGS__                                            \
 	};                                                                     \
 	static void _mtinit_##mname(void) __attribute__((_CONSTRUCTOR(1001))); \
 	static void _mtinit_##mname(void)                                      \
@@ -139,6 +161,22 @@ struct memgroup {
 	DEFINE_MTYPE_ATTR(group, name, static, desc)                           \
 	static struct memtype *const MTYPE_##name = &_mt_##name;
 
+/* as DEFINE_MTYPE, but allocations are served from a per-type slab pool.
+ * Use for high-churn fixed-size types;  XFREE'd objects are recycled in
+ * O(1) instead of being handed back to the system allocator.
+ */
+#define DEFINE_MTYPE_POOL_ATTR(group, mname, attr, desc)                       \
+	static struct mempool _mp_##mname = {                                  \
+		.lock = PTHREAD_MUTEX_INITIALIZER,                             \
+	};                                                                     \
+	DEFINE_MTYPE_ATTR(group, mname, attr, desc, .pool = &_mp_##mname, )
+
+#define DEFINE_MTYPE_POOL(group, name, desc)                                   \
+	DEFINE_MTYPE_POOL_ATTR(group, name, , desc)
+#define DEFINE_MTYPE_POOL_STATIC(group, name, desc)                            \
+	DEFINE_MTYPE_POOL_ATTR(group, name, static, desc)                      \
+	static struct memtype *const MTYPE_##name = &_mt_##name;
+
 DECLARE_MGROUP(LIB)
 DECLARE_MTYPE(TMP)
 
@@ -168,6 +206,10 @@ static inline size_t mtype_stats_alloc(struct memtype *mt)
 	return mt->n_alloc;
 }
 
+/* snapshot of a pooled memtype's slab state, for "show memory" */
+extern void qmem_pool_stats(struct mempool *mp, size_t *obj_size,
+			    size_t *n_free, size_t *n_chunks);
+
 /* NB: calls are ordered by memgroup; and there is a call with mt == NULL for
  * each memgroup (so that a header can be printed, and empty memgroups show)
  *
@@ -114,6 +114,15 @@ static int qmem_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 				TARG,
 				mt->n_max
 				TARG2);
+			if (mt->pool) {
+				size_t objsz, nfree, nchunks;
+
+				qmem_pool_stats(mt->pool, &objsz, &nfree,
+						&nchunks);
+				vty_out(vty,
+					"%-30s: %8zu free cached, %zu byte objects, %zu chunks\n",
+					"  `- pool", nfree, objsz, nchunks);
+			}
 		}
 	}
 	return 0;
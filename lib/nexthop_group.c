@@ -25,6 +25,8 @@
 #include <nexthop_group.h>
 #include <vty.h>
 #include <command.h>
+#include <hash.h>
+#include <jhash.h>
 
 #ifndef VTYSH_EXTRACT_PL
 #include "lib/nexthop_group_clippy.c"
@@ -80,6 +82,134 @@ void nexthop_group_delete(struct nexthop_group **nhg)
 	XFREE(MTYPE_NEXTHOP_GROUP, *nhg);
 }
 
+bool nexthop_group_equal(const struct nexthop_group *nhg1,
+			 const struct nexthop_group *nhg2)
+{
+	const struct nexthop *nh1 = nhg1->nexthop;
+	const struct nexthop *nh2 = nhg2->nexthop;
+
+	while (nh1 && nh2) {
+		if (!nexthop_same(nh1, nh2))
+			return false;
+
+		nh1 = nh1->next;
+		nh2 = nh2->next;
+	}
+
+	return nh1 == NULL && nh2 == NULL;
+}
+
+/*
+ * Hash over exactly the fields nexthop_same() compares, so the value is
+ * consistent with nexthop_group_equal().  Member order matters: groups
+ * with the same nexthops in a different order are different groups.
+ */
+uint32_t nexthop_group_hash(const struct nexthop_group *nhg)
+{
+	const struct nexthop *nh;
+	uint32_t key = 0x55aa5a5a;
+
+	for (nh = nhg->nexthop; nh; nh = nh->next) {
+		key = jhash_2words(nh->vrf_id, nh->type, key);
+		switch (nh->type) {
+		case NEXTHOP_TYPE_IFINDEX:
+			key = jhash_1word(nh->ifindex, key);
+			break;
+		case NEXTHOP_TYPE_IPV4:
+			key = jhash_1word(nh->gate.ipv4.s_addr, key);
+			break;
+		case NEXTHOP_TYPE_IPV4_IFINDEX:
+			key = jhash_2words(nh->gate.ipv4.s_addr, nh->ifindex,
+					   key);
+			break;
+		case NEXTHOP_TYPE_IPV6:
+			key = jhash(&nh->gate.ipv6, sizeof(nh->gate.ipv6),
+				    key);
+			break;
+		case NEXTHOP_TYPE_IPV6_IFINDEX:
+			key = jhash(&nh->gate.ipv6, sizeof(nh->gate.ipv6),
+				    key);
+			key = jhash_1word(nh->ifindex, key);
+			break;
+		case NEXTHOP_TYPE_BLACKHOLE:
+			key = jhash_1word(nh->bh_type, key);
+			break;
+		}
+	}
+
+	return key;
+}
+
+/* Canonical interning ------------------------------------------------------
+ *
+ * Identical nexthop groups show up once per route using them; interning
+ * collapses them into one refcounted canonical copy so consumers can
+ * share and compare them by pointer instead of deep-walking the chains.
+ */
+
+struct nhg_interned {
+	struct nexthop_group nhg; /* must be first (container cast) */
+	uint32_t refcnt;
+};
+
+static struct hash *nhg_intern_table;
+
+static unsigned int nhg_intern_hash_key(void *arg)
+{
+	const struct nhg_interned *intern = arg;
+
+	return nexthop_group_hash(&intern->nhg);
+}
+
+static bool nhg_intern_hash_equal(const void *arg1, const void *arg2)
+{
+	const struct nhg_interned *intern1 = arg1;
+	const struct nhg_interned *intern2 = arg2;
+
+	return nexthop_group_equal(&intern1->nhg, &intern2->nhg);
+}
+
+struct nexthop_group *nexthop_group_intern(const struct nexthop_group *nhg)
+{
+	struct nhg_interned lookup, *intern;
+
+	if (!nhg_intern_table)
+		nhg_intern_table =
+			hash_create_size(8, nhg_intern_hash_key,
+					 nhg_intern_hash_equal,
+					 "Interned nexthop groups");
+
+	lookup.nhg = *nhg;
+	intern = hash_lookup(nhg_intern_table, &lookup);
+	if (!intern) {
+		intern = XCALLOC(MTYPE_NEXTHOP_GROUP, sizeof(*intern));
+		copy_nexthops(&intern->nhg.nexthop, nhg->nexthop, NULL);
+		hash_get(nhg_intern_table, intern, hash_alloc_intern);
+	}
+	intern->refcnt++;
+
+	return &intern->nhg;
+}
+
+void nexthop_group_unintern(struct nexthop_group **nhg)
+{
+	struct nhg_interned *intern;
+
+	if (!*nhg)
+		return;
+
+	intern = (struct nhg_interned *)*nhg;
+	*nhg = NULL;
+
+	assert(intern->refcnt > 0);
+	if (--intern->refcnt > 0)
+		return;
+
+	hash_release(nhg_intern_table, intern);
+	nexthops_free(intern->nhg.nexthop);
+	XFREE(MTYPE_NEXTHOP_GROUP, intern);
+}
+
 /* Add nexthop to the end of a nexthop list.  */
 void nexthop_add(struct nexthop **target, struct nexthop *nexthop)
 {
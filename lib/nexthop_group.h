@@ -42,6 +42,24 @@ struct nexthop_group {
 struct nexthop_group *nexthop_group_new(void);
 void nexthop_group_delete(struct nexthop_group **nhg);
 
+/*
+ * Order-sensitive comparison and hash over the same nexthop fields
+ * nexthop_same() looks at; the two are consistent and suitable for use
+ * as hash table callbacks.
+ */
+bool nexthop_group_equal(const struct nexthop_group *nhg1,
+			 const struct nexthop_group *nhg2);
+uint32_t nexthop_group_hash(const struct nexthop_group *nhg);
+
+/*
+ * Canonical interning.  nexthop_group_intern() returns a refcounted,
+ * shared copy of the group (allocating one on first use);
+ * nexthop_group_unintern() drops a reference and NULLs the caller's
+ * pointer, freeing the shared copy when the last reference goes away.
+ */
+struct nexthop_group *nexthop_group_intern(const struct nexthop_group *nhg);
+void nexthop_group_unintern(struct nexthop_group **nhg);
+
 void nexthop_add(struct nexthop **target, struct nexthop *nexthop);
 void nexthop_del(struct nexthop_group *nhg, struct nexthop *nexthop);
 void copy_nexthops(struct nexthop **tnh, struct nexthop *nh,
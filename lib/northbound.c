@@ -24,6 +24,7 @@
 #include "lib_errors.h"
 #include "command.h"
 #include "db.h"
+#include "monotime.h"
 #include "northbound.h"
 #include "northbound_cli.h"
 #include "northbound_db.h"
@@ -40,6 +41,13 @@ struct nb_config *running_config;
  */
 static bool transaction_in_progress;
 
+/*
+ * Names of YANG modules whose data contains declared cross-module
+ * references (see nb_validate_dependency_add). Touching any of them
+ * disables incremental per-module validation for the candidate.
+ */
+static struct list *nb_validate_deps;
+
 static int nb_configuration_callback(const enum nb_event event,
 				     struct nb_config_change *change);
 static struct nb_transaction *nb_transaction_new(struct nb_config *config,
@@ -232,6 +240,66 @@ static int nb_node_validate(const struct lys_node *snode, void *arg)
 	return YANG_ITER_CONTINUE;
 }
 
+static void nb_config_dirty_free(void *module)
+{
+	XFREE(MTYPE_TMP, module);
+}
+
+static bool nb_module_list_find(const struct list *modules, const char *name)
+{
+	struct listnode *node;
+	char *module;
+
+	for (ALL_LIST_ELEMENTS_RO(modules, node, module))
+		if (strmatch(module, name))
+			return true;
+
+	return false;
+}
+
+/* Reset the dirty-module tracking; the configuration is a clean baseline. */
+static void nb_config_dirty_reset(struct nb_config *config)
+{
+	list_delete_all_node(config->dirty_modules);
+	config->dirty_all = false;
+}
+
+static void nb_config_dirty_copy(struct nb_config *config_dst,
+				 const struct nb_config *config_src)
+{
+	struct listnode *node;
+	char *module;
+
+	list_delete_all_node(config_dst->dirty_modules);
+	config_dst->dirty_all = config_src->dirty_all;
+	for (ALL_LIST_ELEMENTS_RO(config_src->dirty_modules, node, module))
+		listnode_add(config_dst->dirty_modules,
+			     XSTRDUP(MTYPE_TMP, module));
+}
+
+/* Record the module owning the given xpath as edited in this candidate. */
+static void nb_config_dirty_add(struct nb_config *config, const char *xpath)
+{
+	char module[XPATH_MAXLEN];
+	char *colon;
+
+	if (config->dirty_all)
+		return;
+
+	/* xpaths are always absolute and prefixed: "/module:node/...". */
+	strlcpy(module, xpath + 1, sizeof(module));
+	colon = strchr(module, ':');
+	if (!colon) {
+		config->dirty_all = true;
+		return;
+	}
+	*colon = '\0';
+
+	if (!nb_module_list_find(config->dirty_modules, module))
+		listnode_add(config->dirty_modules,
+			     XSTRDUP(MTYPE_TMP, module));
+}
+
 struct nb_config *nb_config_new(struct lyd_node *dnode)
 {
 	struct nb_config *config;
@@ -242,6 +310,10 @@ struct nb_config *nb_config_new(struct lyd_node *dnode)
 	else
 		config->dnode = yang_dnode_new(ly_native_ctx, true);
 	config->version = 0;
+	config->dirty_modules = list_new();
+	config->dirty_modules->del = nb_config_dirty_free;
+	/* unknown provenance - assume everything needs validation */
+	config->dirty_all = true;
 
 	return config;
 }
@@ -250,6 +322,7 @@ void nb_config_free(struct nb_config *config)
 {
 	if (config->dnode)
 		yang_dnode_free(config->dnode);
+	list_delete(&config->dirty_modules);
 	XFREE(MTYPE_NB_CONFIG, config);
 }
 
@@ -260,6 +333,9 @@ struct nb_config *nb_config_dup(const struct nb_config *config)
 	dup = XCALLOC(MTYPE_NB_CONFIG, sizeof(*dup));
 	dup->dnode = yang_dnode_dup(config->dnode);
 	dup->version = config->version;
+	dup->dirty_modules = list_new();
+	dup->dirty_modules->del = nb_config_dirty_free;
+	nb_config_dirty_copy(dup, config);
 
 	return dup;
 }
@@ -273,6 +349,9 @@ int nb_config_merge(struct nb_config *config_dst, struct nb_config *config_src,
 	if (ret != 0)
 		flog_warn(EC_LIB_LIBYANG, "%s: lyd_merge() failed", __func__);
 
+	/* the merge bypasses per-module change tracking */
+	config_dst->dirty_all = true;
+
 	if (!preserve_source)
 		nb_config_free(config_src);
 
@@ -286,6 +365,9 @@ void nb_config_replace(struct nb_config *config_dst,
 	if (config_src->version != 0)
 		config_dst->version = config_src->version;
 
+	/* Update dirty-module tracking. */
+	nb_config_dirty_copy(config_dst, config_src);
+
 	/* Update dnode. */
 	if (config_dst->dnode)
 		yang_dnode_free(config_dst->dnode);
@@ -456,6 +538,10 @@ int nb_candidate_edit(struct nb_config *candidate,
 		return NB_ERR;
 	}
 
+	/* Record the edited module for incremental validation (marking is
+	 * conservative: failed edits only cost a spurious revalidation). */
+	nb_config_dirty_add(candidate, xpath);
+
 	/* Use special notation for leaf-lists (RFC 6020, section 9.13.5). */
 	if (nb_node->snode->nodetype == LYS_LEAFLIST)
 		snprintf(xpath_edit, sizeof(xpath_edit), "%s[.='%s']", xpath,
@@ -561,18 +647,90 @@ static void nb_candidate_restore_priv_pointers(struct nb_config *candidate)
 	}
 }
 
+/*
+ * Return the set of modules whose subtrees need to be revalidated for the
+ * given candidate, or NULL when the whole candidate must be validated
+ * (unknown provenance, or an edited module has declared cross-module
+ * references that per-subtree validation can't resolve).
+ */
+static const struct list *nb_validate_set(const struct nb_config *candidate)
+{
+	struct listnode *node;
+	char *module;
+
+	if (candidate->dirty_all)
+		return NULL;
+
+	if (nb_validate_deps)
+		for (ALL_LIST_ELEMENTS_RO(candidate->dirty_modules, node,
+					  module))
+			if (nb_module_list_find(nb_validate_deps, module))
+				return NULL;
+
+	return candidate->dirty_modules;
+}
+
+static bool nb_validate_set_contains(const struct list *vset,
+				     const struct lyd_node *root)
+{
+	return nb_module_list_find(vset, lys_node_module(root->schema)->name);
+}
+
+void nb_validate_dependency_add(const char *module, const char *depends)
+{
+	if (!nb_validate_deps) {
+		nb_validate_deps = list_new();
+		nb_validate_deps->del = nb_config_dirty_free;
+	}
+	if (!nb_module_list_find(nb_validate_deps, module))
+		listnode_add(nb_validate_deps, XSTRDUP(MTYPE_TMP, module));
+	if (!nb_module_list_find(nb_validate_deps, depends))
+		listnode_add(nb_validate_deps, XSTRDUP(MTYPE_TMP, depends));
+}
+
 /*
  * Perform YANG syntactic and semantic validation.
  *
+ * When the candidate tracked its edits, only the subtrees of the edited
+ * modules are validated - the rest is identical to the running
+ * configuration, which was validated when it was committed.
+ *
  * WARNING: lyd_validate() can change the configuration as part of the
  * validation process.
  */
 static int nb_candidate_validate_yang(struct nb_config *candidate)
 {
-	if (lyd_validate(&candidate->dnode, LYD_OPT_STRICT | LYD_OPT_CONFIG,
-			 ly_native_ctx)
-	    != 0)
-		return NB_ERR_VALIDATION;
+	const struct list *vset = nb_validate_set(candidate);
+	struct lyd_node *root, *next;
+
+	if (!vset) {
+		if (lyd_validate(&candidate->dnode,
+				 LYD_OPT_STRICT | LYD_OPT_CONFIG,
+				 ly_native_ctx)
+		    != 0)
+			return NB_ERR_VALIDATION;
+
+		return NB_OK;
+	}
+
+	LY_TREE_FOR_SAFE (candidate->dnode, next, root) {
+		struct lyd_node *tree = root;
+		bool first = (root == candidate->dnode);
+
+		if (!nb_validate_set_contains(vset, root))
+			continue;
+
+		if (lyd_validate(&tree,
+				 LYD_OPT_STRICT | LYD_OPT_CONFIG
+					 | LYD_OPT_NOSIBLINGS,
+				 ly_native_ctx)
+		    != 0)
+			return NB_ERR_VALIDATION;
+
+		/* validation may replace the head of the subtree */
+		if (first && tree != root)
+			candidate->dnode = tree;
+	}
 
 	return NB_OK;
 }
@@ -665,6 +823,10 @@ void nb_candidate_commit_apply(struct nb_transaction *transaction,
 	transaction->config->version++;
 	nb_config_replace(running_config, transaction->config, true);
 
+	/* The new running configuration is a clean baseline; candidates
+	 * duplicated from it track their edits from scratch. */
+	nb_config_dirty_reset(running_config);
+
 	/* Record transaction. */
 	if (save_transaction
 	    && nb_db_transaction_save(transaction, transaction_id) != NB_OK)
@@ -1201,8 +1363,10 @@ static int nb_oper_data_iter_node(const struct lys_node *snode,
 	return ret;
 }
 
-int nb_oper_data_iterate(const char *xpath, struct yang_translator *translator,
-			 uint32_t flags, nb_oper_data_cb cb, void *arg)
+static int nb_oper_data_iterate_uncached(const char *xpath,
+					 struct yang_translator *translator,
+					 uint32_t flags, nb_oper_data_cb cb,
+					 void *arg)
 {
 	struct nb_node *nb_node;
 	const void *list_entry = NULL;
@@ -1311,6 +1475,172 @@ int nb_oper_data_iterate(const char *xpath, struct yang_translator *translator,
 	return ret;
 }
 
+/* Cached result of an operational data iteration (see
+ * nb_oper_data_cache_enable). */
+struct nb_oper_cache {
+	char xpath[XPATH_MAXLEN];
+	uint32_t ttl;
+	time_t expires;
+	bool valid;
+	struct list *entries; /* of struct nb_oper_cache_entry */
+};
+
+struct nb_oper_cache_entry {
+	const struct lys_node *snode;
+	char xpath[XPATH_MAXLEN];
+	char *value;
+};
+
+static struct list *nb_oper_caches;
+
+static void nb_oper_cache_entry_free(void *arg)
+{
+	struct nb_oper_cache_entry *entry = arg;
+
+	XFREE(MTYPE_TMP, entry->value);
+	XFREE(MTYPE_TMP, entry);
+}
+
+static void nb_oper_cache_invalidate(struct nb_oper_cache *cache)
+{
+	list_delete_all_node(cache->entries);
+	cache->valid = false;
+}
+
+static struct nb_oper_cache *nb_oper_cache_find(const char *xpath)
+{
+	struct listnode *node;
+	struct nb_oper_cache *cache;
+
+	if (!nb_oper_caches)
+		return NULL;
+
+	for (ALL_LIST_ELEMENTS_RO(nb_oper_caches, node, cache))
+		if (strmatch(cache->xpath, xpath))
+			return cache;
+
+	return NULL;
+}
+
+void nb_oper_data_cache_enable(const char *xpath, uint32_t ttl)
+{
+	struct nb_oper_cache *cache;
+
+	if (nb_oper_cache_find(xpath))
+		return;
+
+	if (!nb_oper_caches)
+		nb_oper_caches = list_new();
+
+	cache = XCALLOC(MTYPE_TMP, sizeof(*cache));
+	strlcpy(cache->xpath, xpath, sizeof(cache->xpath));
+	cache->ttl = ttl;
+	cache->entries = list_new();
+	cache->entries->del = nb_oper_cache_entry_free;
+	listnode_add(nb_oper_caches, cache);
+}
+
+void nb_oper_data_cache_flush(const char *xpath)
+{
+	struct listnode *node;
+	struct nb_oper_cache *cache;
+
+	if (!nb_oper_caches)
+		return;
+
+	for (ALL_LIST_ELEMENTS_RO(nb_oper_caches, node, cache)) {
+		if (xpath
+		    && strncmp(cache->xpath, xpath, strlen(xpath)) != 0
+		    && strncmp(xpath, cache->xpath, strlen(cache->xpath)) != 0)
+			continue;
+		nb_oper_cache_invalidate(cache);
+	}
+}
+
+/* Tee callback: record each data node into the cache while forwarding it
+ * to the real consumer. */
+struct nb_oper_cache_fill {
+	struct nb_oper_cache *cache;
+	nb_oper_data_cb cb;
+	void *arg;
+};
+
+static int nb_oper_data_cache_fill_cb(const struct lys_node *snode,
+				      struct yang_translator *translator,
+				      struct yang_data *data, void *arg)
+{
+	struct nb_oper_cache_fill *fill = arg;
+	struct nb_oper_cache_entry *entry;
+
+	entry = XCALLOC(MTYPE_TMP, sizeof(*entry));
+	entry->snode = snode;
+	strlcpy(entry->xpath, data->xpath, sizeof(entry->xpath));
+	if (data->value)
+		entry->value = XSTRDUP(MTYPE_TMP, data->value);
+	listnode_add(fill->cache->entries, entry);
+
+	return (*fill->cb)(snode, translator, data, fill->arg);
+}
+
+static int nb_oper_data_cache_replay(struct nb_oper_cache *cache,
+				     nb_oper_data_cb cb, void *arg)
+{
+	struct listnode *node;
+	struct nb_oper_cache_entry *entry;
+
+	for (ALL_LIST_ELEMENTS_RO(cache->entries, node, entry)) {
+		struct yang_data *data;
+		int ret;
+
+		data = yang_data_new(entry->xpath, entry->value);
+		ret = (*cb)(entry->snode, NULL, data, arg);
+		if (ret != NB_OK)
+			return ret;
+	}
+
+	return NB_OK;
+}
+
+int nb_oper_data_iterate(const char *xpath, struct yang_translator *translator,
+			 uint32_t flags, nb_oper_data_cb cb, void *arg)
+{
+	struct nb_oper_cache *cache;
+	struct nb_oper_cache_fill fill;
+	int ret;
+
+	/* Translated or flag-modified walks produce different results;
+	 * serve them directly. */
+	if (translator || flags)
+		return nb_oper_data_iterate_uncached(xpath, translator, flags,
+						     cb, arg);
+
+	cache = nb_oper_cache_find(xpath);
+	if (!cache)
+		return nb_oper_data_iterate_uncached(xpath, translator, flags,
+						     cb, arg);
+
+	if (cache->valid && monotime(NULL) < cache->expires)
+		return nb_oper_data_cache_replay(cache, cb, arg);
+
+	/* Stale or empty: walk the callbacks and re-record the result. */
+	nb_oper_cache_invalidate(cache);
+	fill.cache = cache;
+	fill.cb = cb;
+	fill.arg = arg;
+	ret = nb_oper_data_iterate_uncached(xpath, translator, flags,
+					    nb_oper_data_cache_fill_cb, &fill);
+	if (ret != NB_OK) {
+		/* don't serve partial results */
+		nb_oper_cache_invalidate(cache);
+		return ret;
+	}
+
+	cache->valid = true;
+	cache->expires = monotime(NULL) + cache->ttl;
+
+	return NB_OK;
+}
+
 bool nb_operation_is_valid(enum nb_operation operation,
 			   const struct lys_node *snode)
 {
@@ -1625,6 +1955,7 @@ void nb_init(struct thread_master *tm,
 
 	/* Create an empty running configuration. */
 	running_config = nb_config_new(NULL);
+	nb_config_dirty_reset(running_config);
 
 	/* Initialize the northbound CLI. */
 	nb_cli_init(tm);
@@ -1640,4 +1971,18 @@ void nb_terminate(void)
 
 	/* Delete the running configuration. */
 	nb_config_free(running_config);
+
+	if (nb_validate_deps)
+		list_delete(&nb_validate_deps);
+
+	if (nb_oper_caches) {
+		struct listnode *node, *nnode;
+		struct nb_oper_cache *cache;
+
+		for (ALL_LIST_ELEMENTS(nb_oper_caches, node, nnode, cache)) {
+			list_delete(&cache->entries);
+			XFREE(MTYPE_TMP, cache);
+		}
+		list_delete(&nb_oper_caches);
+	}
 }
@@ -422,6 +422,18 @@ enum nb_client {
 struct nb_config {
 	struct lyd_node *dnode;
 	uint32_t version;
+
+	/*
+	 * Names of the YANG modules edited since this configuration was
+	 * duplicated from the running configuration. Commits validate only
+	 * these subtrees instead of the whole candidate. When the
+	 * configuration was changed without going through
+	 * nb_candidate_edit() (e.g. a merge or an externally provided data
+	 * tree), dirty_all is set and the whole candidate is validated as
+	 * before.
+	 */
+	struct list *dirty_modules;
+	bool dirty_all;
 };
 
 /* Northbound configuration callback. */
@@ -624,6 +636,21 @@ extern int nb_candidate_update(struct nb_config *candidate);
  */
 extern int nb_candidate_validate(struct nb_config *candidate);
 
+/*
+ * Declare that data instances of one YANG module contain cross-references
+ * (leafrefs, must/when expressions) into another module. Subtrees of such
+ * modules can't be validated in isolation, so any candidate that touches
+ * either module falls back to whole-tree validation instead of the
+ * incremental per-module validation.
+ *
+ * module
+ *    Name of the module containing the references.
+ *
+ * depends
+ *    Name of the referenced module.
+ */
+extern void nb_validate_dependency_add(const char *module, const char *depends);
+
 /*
  * Create a new configuration transaction but do not commit it yet. Only
  * validate the candidate and prepare all resources required to apply the
@@ -749,6 +776,38 @@ extern int nb_oper_data_iterate(const char *xpath,
 				struct yang_translator *translator,
 				uint32_t flags, nb_oper_data_cb cb, void *arg);
 
+/*
+ * Cache the results of nb_oper_data_iterate() for the given subtree.
+ *
+ * While a cached result is fresh, repeated iterations over the same
+ * xpath replay the recorded data nodes instead of walking the get_elem/
+ * get_next callbacks again - useful for telemetry polls of mostly-static
+ * subtrees (interface config, VRF lists). The cache only serves plain
+ * iterations (no translator, no flags); everything else goes through the
+ * normal walk.
+ *
+ * xpath
+ *    Data path of the subtree to cache. Must match the xpath passed to
+ *    nb_oper_data_iterate() exactly.
+ *
+ * ttl
+ *    Number of seconds a recorded result stays fresh.
+ */
+extern void nb_oper_data_cache_enable(const char *xpath, uint32_t ttl);
+
+/*
+ * Invalidate cached operational data.
+ *
+ * Daemons should call this when the state backing a cached subtree
+ * changes and the staleness allowed by the TTL is not acceptable.
+ *
+ * xpath
+ *    Data path whose caches should be flushed. Every cache whose root is
+ *    an ancestor or a descendant of this path is invalidated. NULL
+ *    flushes everything.
+ */
+extern void nb_oper_data_cache_flush(const char *xpath);
+
 /*
  * Validate if the northbound operation is valid for the given node.
  *
@@ -22,6 +22,7 @@
 
 #include "prefix.h"
 #include "command.h"
+#include "jhash.h"
 #include "memory.h"
 #include "plist.h"
 #include "sockunion.h"
@@ -45,6 +46,9 @@ DEFINE_MTYPE_STATIC(LIB, PREFIX_LIST_TRIE, "Prefix List Trie Table")
 #define PLC_MAXLEVELV6	4	/* /48 for IPv6 */
 #define PLC_MAXLEVEL	4	/* max(v4,v6) */
 
+/* one bit per prefix length, 0..128 inclusive */
+#define PLC_LEN_WORDS	((IPV6_MAX_BITLEN + 1 + 63) / 64)
+
 struct pltrie_entry {
 	union {
 		struct pltrie_table *next_table;
@@ -52,6 +56,12 @@ struct pltrie_entry {
 	};
 
 	struct prefix_list_entry *up_chain;
+
+	/* union of the prefix lengths the chains' entries can match, per
+	 * le/ge semantics.  Lets apply skip a chain when the looked-up
+	 * prefix's length cannot possibly match any entry on it. */
+	uint64_t final_lens[PLC_LEN_WORDS];
+	uint64_t up_lens[PLC_LEN_WORDS];
 };
 
 struct pltrie_table {
@@ -364,6 +374,56 @@ prefix_list_entry_make(struct prefix *prefix, enum prefix_list_type type,
 	return pentry;
 }
 
+/* While a bulk load is open, the per-entry hooks and route-map
+ * dependency notifications are deferred; changed lists are flagged and
+ * notified once on commit.  Pushing a 25k-entry list otherwise triggers
+ * a full dependency update per line. */
+static bool prefix_bulk_load;
+
+static void prefix_bulk_commit_list(struct prefix_master *master,
+				    struct prefix_list_list *list)
+{
+	struct prefix_list *plist;
+
+	for (plist = list->head; plist; plist = plist->next) {
+		if (!plist->bulk_dirty)
+			continue;
+
+		plist->bulk_dirty = false;
+		if (master->add_hook)
+			(*master->add_hook)(plist);
+		route_map_notify_dependencies(plist->name,
+					      RMAP_EVENT_PLIST_ADDED);
+	}
+}
+
+void prefix_list_bulk_begin(void)
+{
+	prefix_bulk_load = true;
+}
+
+void prefix_list_bulk_commit(void)
+{
+	afi_t afi;
+	int orf;
+
+	if (!prefix_bulk_load)
+		return;
+
+	prefix_bulk_load = false;
+
+	for (afi = AFI_IP; afi <= AFI_IP6; afi++)
+		for (orf = 0; orf <= 1; orf++) {
+			struct prefix_master *master =
+				prefix_master_get(afi, orf);
+
+			if (!master)
+				continue;
+			prefix_bulk_commit_list(master, &master->num);
+			prefix_bulk_commit_list(master, &master->str);
+		}
+}
+
 /* Add hook function. */
 void prefix_list_add_hook(void (*func)(struct prefix_list *plist))
 {
@@ -433,33 +493,68 @@ prefix_list_entry_lookup(struct prefix_list *plist, struct prefix *prefix,
 	return NULL;
 }
 
+/* Set the bits for every prefix length object can match, following
+ * prefix_list_entry_match(): an exact-match entry covers only its own
+ * length, le/ge widen that to an interval. */
+static void trie_lens_add(uint64_t *lens, struct prefix_list_entry *object)
+{
+	int lo = object->prefix.prefixlen, hi = lo, i;
+
+	if (object->le || object->ge) {
+		if (object->ge > lo)
+			lo = object->ge;
+		hi = object->le ? object->le
+				: (object->prefix.family == AF_INET6
+					   ? IPV6_MAX_BITLEN
+					   : IPV4_MAX_BITLEN);
+	}
+
+	for (i = lo; i <= hi; i++)
+		lens[i / 64] |= 1ULL << (i % 64);
+}
+
+static bool trie_lens_match(const uint64_t *lens, size_t prefixlen)
+{
+	return lens[prefixlen / 64] & (1ULL << (prefixlen % 64));
+}
+
 static void trie_walk_affected(size_t validbits, struct pltrie_table *table,
 			       uint8_t byte, struct prefix_list_entry *object,
 			       void (*fn)(struct prefix_list_entry *object,
-					  struct prefix_list_entry **updptr))
+					  struct prefix_list_entry **updptr,
+					  uint64_t *lens))
 {
 	uint8_t mask;
 	uint16_t bwalk;
 
 	if (validbits > PLC_BITS) {
-		fn(object, &table->entries[byte].final_chain);
+		fn(object, &table->entries[byte].final_chain,
+		   table->entries[byte].final_lens);
 		return;
 	}
 
 	mask = (1 << (8 - validbits)) - 1;
 	for (bwalk = byte & ~mask; bwalk <= byte + mask; bwalk++) {
-		fn(object, &table->entries[bwalk].up_chain);
+		fn(object, &table->entries[bwalk].up_chain,
+		   table->entries[bwalk].up_lens);
 	}
 }
 
 static void trie_uninstall_fn(struct prefix_list_entry *object,
-			      struct prefix_list_entry **updptr)
+			      struct prefix_list_entry **updptr, uint64_t *lens)
 {
+	struct prefix_list_entry **head = updptr, *walk;
+
 	for (; *updptr; updptr = &(*updptr)->next_best)
 		if (*updptr == object) {
 			*updptr = object->next_best;
 			break;
 		}
+
+	/* rebuild the length bitmap from the entries still chained */
+	memset(lens, 0, PLC_LEN_WORDS * sizeof(uint64_t));
+	for (walk = *head; walk; walk = walk->next_best)
+		trie_lens_add(lens, walk);
 }
 
 static int trie_table_empty(struct pltrie_table *table)
@@ -524,10 +619,14 @@ static void prefix_list_entry_delete(struct prefix_list *plist,
 	plist->count--;
 
 	if (update_list) {
-		route_map_notify_dependencies(plist->name,
-					      RMAP_EVENT_PLIST_DELETED);
-		if (plist->master->delete_hook)
-			(*plist->master->delete_hook)(plist);
+		if (prefix_bulk_load && plist->head)
+			plist->bulk_dirty = true;
+		else {
+			route_map_notify_dependencies(plist->name,
+						      RMAP_EVENT_PLIST_DELETED);
+			if (plist->master->delete_hook)
+				(*plist->master->delete_hook)(plist);
+		}
 
 		if (plist->head == NULL && plist->tail == NULL
 		    && plist->desc == NULL)
@@ -538,8 +637,10 @@ static void prefix_list_entry_delete(struct prefix_list *plist,
 }
 
 static void trie_install_fn(struct prefix_list_entry *object,
-			    struct prefix_list_entry **updptr)
+			    struct prefix_list_entry **updptr, uint64_t *lens)
 {
+	trie_lens_add(lens, object);
+
 	while (*updptr) {
 		if (*updptr == object)
 			return;
@@ -632,11 +733,16 @@ static void prefix_list_entry_add(struct prefix_list *plist,
 	/* Increment count. */
 	plist->count++;
 
-	/* Run hook function. */
-	if (plist->master->add_hook)
-		(*plist->master->add_hook)(plist);
+	/* Run hook function, unless a bulk load defers it. */
+	if (prefix_bulk_load) {
+		plist->bulk_dirty = true;
+	} else {
+		if (plist->master->add_hook)
+			(*plist->master->add_hook)(plist);
 
-	route_map_notify_dependencies(plist->name, RMAP_EVENT_PLIST_ADDED);
+		route_map_notify_dependencies(plist->name,
+					      RMAP_EVENT_PLIST_ADDED);
+	}
 	plist->master->recent = plist;
 }
 
@@ -709,13 +815,15 @@ enum prefix_list_type prefix_list_apply_which_prefix(
 	depth = plist->master->trie_depth;
 	table = plist->trie;
 	while (1) {
-		for (pentry = table->entries[*byte].up_chain; pentry;
-		     pentry = pentry->next_best) {
-			if (pbest && pbest->seq < pentry->seq)
-				continue;
-			if (prefix_list_entry_match(pentry, p))
-				pbest = pentry;
-		}
+		if (trie_lens_match(table->entries[*byte].up_lens,
+				    p->prefixlen))
+			for (pentry = table->entries[*byte].up_chain; pentry;
+			     pentry = pentry->next_best) {
+				if (pbest && pbest->seq < pentry->seq)
+					continue;
+				if (prefix_list_entry_match(pentry, p))
+					pbest = pentry;
+			}
 
 		if (validbits <= PLC_BITS)
 			break;
@@ -730,13 +838,15 @@ enum prefix_list_type prefix_list_apply_which_prefix(
 			continue;
 		}
 
-		for (pentry = table->entries[*byte].final_chain; pentry;
-		     pentry = pentry->next_best) {
-			if (pbest && pbest->seq < pentry->seq)
-				continue;
-			if (prefix_list_entry_match(pentry, p))
-				pbest = pentry;
-		}
+		if (trie_lens_match(table->entries[*byte].final_lens,
+				    p->prefixlen))
+			for (pentry = table->entries[*byte].final_chain;
+			     pentry; pentry = pentry->next_best) {
+				if (pbest && pbest->seq < pentry->seq)
+					continue;
+				if (prefix_list_entry_match(pentry, p))
+					pbest = pentry;
+			}
 		break;
 	}
 
@@ -753,6 +863,62 @@ enum prefix_list_type prefix_list_apply_which_prefix(
 	return pbest->type;
 }
 
+/* Hash over the entries of a prefix list, walked in sequence order.  Lets
+ * callers group pointer-distinct lists that filter identically (e.g. BGP
+ * ORF filters received from different peers); prefix_list_content_cmp()
+ * is the matching equality test.
+ */
+uint32_t prefix_list_content_hash(const struct prefix_list *plist)
+{
+	struct prefix_list_entry *pentry;
+	uint32_t key = 0;
+
+	if (plist == NULL)
+		return 0;
+
+	for (pentry = plist->head; pentry; pentry = pentry->next) {
+		key = jhash_3words((uint32_t)pentry->seq,
+				   (pentry->type << 1) | pentry->any,
+				   (pentry->ge << 16) | pentry->le, key);
+		key = jhash_2words(pentry->prefix.family,
+				   pentry->prefix.prefixlen, key);
+		key = jhash(pentry->prefix.u.val,
+			    PSIZE(pentry->prefix.prefixlen), key);
+	}
+
+	return key;
+}
+
+/* Return 0 if the two prefix lists would permit and deny exactly the same
+ * prefixes, nonzero otherwise.  Either argument may be NULL; only two NULL
+ * lists compare equal, matching prefix_list_apply()'s deny-on-NULL rule.
+ */
+int prefix_list_content_cmp(const struct prefix_list *plist1,
+			    const struct prefix_list *plist2)
+{
+	struct prefix_list_entry *pe1, *pe2;
+
+	if (plist1 == plist2)
+		return 0;
+
+	if (plist1 == NULL || plist2 == NULL)
+		return 1;
+
+	if (plist1->count != plist2->count)
+		return 1;
+
+	for (pe1 = plist1->head, pe2 = plist2->head; pe1 && pe2;
+	     pe1 = pe1->next, pe2 = pe2->next) {
+		if (pe1->seq != pe2->seq || pe1->type != pe2->type
+		    || pe1->any != pe2->any || pe1->ge != pe2->ge
+		    || pe1->le != pe2->le
+		    || !prefix_same(&pe1->prefix, &pe2->prefix))
+			return 1;
+	}
+
+	return 0;
+}
+
 static void __attribute__((unused)) prefix_list_print(struct prefix_list *plist)
 {
 	struct prefix_list_entry *pentry;
@@ -2109,12 +2275,37 @@ static void prefix_list_init_ipv6(void)
 	install_element(ENABLE_NODE, &clear_ipv6_prefix_list_cmd);
 }
 
+DEFUN (prefix_list_bulk_load_begin,
+       prefix_list_bulk_load_begin_cmd,
+       "prefix-list bulk-load begin",
+       PREFIX_LIST_STR
+       "Bulk configuration load\n"
+       "Defer dependency updates until commit\n")
+{
+	prefix_list_bulk_begin();
+	return CMD_SUCCESS;
+}
+
+DEFUN (prefix_list_bulk_load_commit,
+       prefix_list_bulk_load_commit_cmd,
+       "prefix-list bulk-load commit",
+       PREFIX_LIST_STR
+       "Bulk configuration load\n"
+       "Apply deferred dependency updates\n")
+{
+	prefix_list_bulk_commit();
+	return CMD_SUCCESS;
+}
+
 void prefix_list_init(void)
 {
 	cmd_variable_handler_register(plist_var_handlers);
 
 	prefix_list_init_ipv4();
 	prefix_list_init_ipv6();
+
+	install_element(CONFIG_NODE, &prefix_list_bulk_load_begin_cmd);
+	install_element(CONFIG_NODE, &prefix_list_bulk_load_commit_cmd);
 }
 
 void prefix_list_reset(void)
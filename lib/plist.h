@@ -51,6 +51,12 @@ extern void prefix_list_reset(void);
 extern void prefix_list_add_hook(void (*func)(struct prefix_list *));
 extern void prefix_list_delete_hook(void (*func)(struct prefix_list *));
 
+/* Bulk configuration load: between begin and commit, per-entry hook and
+ * dependency notifications are deferred and coalesced to one per
+ * changed list. */
+extern void prefix_list_bulk_begin(void);
+extern void prefix_list_bulk_commit(void);
+
 extern const char *prefix_list_name(struct prefix_list *);
 extern afi_t prefix_list_afi(struct prefix_list *);
 extern struct prefix_list *prefix_list_lookup(afi_t, const char *);
@@ -70,6 +76,15 @@ prefix_list_apply_which_prefix(struct prefix_list *plist,
 			       const void *object);
 #define prefix_list_apply(A, B) prefix_list_apply_which_prefix((A), NULL, (B))
 
+/*
+ * Content-based hash and equality over a prefix list's entries, for
+ * grouping pointer-distinct lists with identical filtering behavior.
+ * NULL is a valid argument to both; cmp returns 0 on equality.
+ */
+extern uint32_t prefix_list_content_hash(const struct prefix_list *plist);
+extern int prefix_list_content_cmp(const struct prefix_list *plist1,
+				   const struct prefix_list *plist2);
+
 extern struct prefix_list *prefix_bgp_orf_lookup(afi_t, const char *);
 extern struct stream *prefix_bgp_orf_entry(struct stream *,
 					   struct prefix_list *, uint8_t,
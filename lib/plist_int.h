@@ -46,6 +46,9 @@ struct prefix_list {
 
 	struct pltrie_table *trie;
 
+	/* changed during a bulk load; hooks run deferred on commit */
+	bool bulk_dirty;
+
 	struct prefix_list *next;
 	struct prefix_list *prev;
 };
@@ -22,6 +22,7 @@
 #include <zebra.h>
 
 #include "prefix.h"
+#include "frrfmt.h"
 #include "vty.h"
 #include "sockunion.h"
 #include "memory.h"
@@ -579,10 +580,7 @@ int prefix_match(const struct prefix *n, const struct prefix *p)
 
 		offset = n->u.prefix_flowspec.prefixlen;
 
-		while (offset--)
-			if (np[offset] != pp[offset])
-				return 0;
-		return 1;
+		return memcmp(np, pp, offset) == 0;
 	}
 
 	/* Set both prefix's head pointer. */
@@ -596,10 +594,8 @@ int prefix_match(const struct prefix *n, const struct prefix *p)
 		if (maskbit[shift] & (np[offset] ^ pp[offset]))
 			return 0;
 
-	while (offset--)
-		if (np[offset] != pp[offset])
-			return 0;
-	return 1;
+	/* memcmp picks up the platform's vectorized comparison */
+	return memcmp(np, pp, offset) == 0;
 }
 
 /* If n includes p then return 1 else return 0. Prefix mask is not considered */
@@ -621,10 +617,7 @@ int prefix_match_network_statement(const struct prefix *n,
 		if (maskbit[shift] & (np[offset] ^ pp[offset]))
 			return 0;
 
-	while (offset--)
-		if (np[offset] != pp[offset])
-			return 0;
-	return 1;
+	return memcmp(np, pp, offset) == 0;
 }
 
 void prefix_copy(struct prefix *dest, const struct prefix *src)
@@ -1332,9 +1325,13 @@ const char *prefix2str(union prefixconstptr pu, char *str, int size)
 	switch (p->family) {
 	case AF_INET:
 	case AF_INET6:
-		snprintf(str, size, "%s/%d", inet_ntop(p->family, &p->u.prefix,
-						       buf, PREFIX2STR_BUFFER),
-			 p->prefixlen);
+		/* hand-rolled converters; inet_ntop() shows up in
+		 * profiles when debugs pre-format prefixes */
+		if (p->family == AF_INET)
+			frr_inet4_ntop(&p->u.prefix4, buf, sizeof(buf));
+		else
+			frr_inet6_ntop(&p->u.prefix6, buf, sizeof(buf));
+		snprintf(str, size, "%s/%d", buf, p->prefixlen);
 		break;
 
 	case AF_ETHERNET:
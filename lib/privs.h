@@ -134,6 +134,24 @@ extern void _zprivs_lower(struct zebra_privs_t **privs);
 					  _zprivs_raise(privs, __func__);      \
 	     _once == NULL; _once = (void *)1)
 
+/*
+ * Batch elevation: keep privileges raised across an entire batch
+ * operation.  Elevation is refcounted, so any frr_elevate_privs()
+ * blocks executed while the batch is pinned only bump the refcount
+ * instead of issuing a capset()/seteuid() pair per call.
+ *
+ * Use this when the elevated section spans multiple functions or loop
+ * iterations (e.g. packing and flushing a batch of kernel messages);
+ * prefer frr_elevate_privs() whenever a single lexical scope suffices.
+ * Calls must be strictly paired, including on error paths.
+ */
+#define frr_privs_batch_enter(privs) ((void)_zprivs_raise(privs, __func__))
+#define frr_privs_batch_exit(privs)                                            \
+	do {                                                                   \
+		struct zebra_privs_t *_batch_privs = (privs);                  \
+		_zprivs_lower(&_batch_privs);                                  \
+	} while (0)
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,4 @@
-/* C-Ares integration to Quagga mainloop
+/* C-Ares integration to FRR event loop
  * Copyright (c) 2014-2015 Timo Teräs
  *
  * This file is free software: you may copy, redistribute and/or modify
@@ -17,12 +17,11 @@
 #include "vector.h"
 #include "thread.h"
 #include "lib_errors.h"
-
-#include "nhrpd.h"
-#include "nhrp_errors.h"
+#include "resolver.h"
 
 struct resolver_state {
 	ares_channel channel;
+	struct thread_master *master;
 	struct thread *timeout;
 	vector read_threads, write_threads;
 };
@@ -54,7 +53,8 @@ static int resolver_cb_socket_readable(struct thread *t)
 	ares_process_fd(r->channel, fd, ARES_SOCKET_BAD);
 	if (vector_lookup(r->read_threads, fd) == THREAD_RUNNING) {
 		t = NULL;
-		thread_add_read(master, resolver_cb_socket_readable, r, fd, &t);
+		thread_add_read(r->master, resolver_cb_socket_readable, r, fd,
+				&t);
 		vector_set_index(r->read_threads, fd, t);
 	}
 	resolver_update_timeouts(r);
@@ -71,7 +71,7 @@ static int resolver_cb_socket_writable(struct thread *t)
 	ares_process_fd(r->channel, ARES_SOCKET_BAD, fd);
 	if (vector_lookup(r->write_threads, fd) == THREAD_RUNNING) {
 		t = NULL;
-		thread_add_write(master, resolver_cb_socket_writable, r, fd,
+		thread_add_write(r->master, resolver_cb_socket_writable, r, fd,
 				 &t);
 		vector_set_index(r->write_threads, fd, t);
 	}
@@ -91,8 +91,8 @@ static void resolver_update_timeouts(struct resolver_state *r)
 	tv = ares_timeout(r->channel, NULL, &tvbuf);
 	if (tv) {
 		unsigned int timeoutms = tv->tv_sec * 1000 + tv->tv_usec / 1000;
-		thread_add_timer_msec(master, resolver_cb_timeout, r, timeoutms,
-				      &r->timeout);
+		thread_add_timer_msec(r->master, resolver_cb_timeout, r,
+				      timeoutms, &r->timeout);
 	}
 }
 
@@ -105,8 +105,8 @@ static void ares_socket_cb(void *data, ares_socket_t fd, int readable,
 	if (readable) {
 		t = vector_lookup_ensure(r->read_threads, fd);
 		if (!t) {
-			thread_add_read(master, resolver_cb_socket_readable, r,
-					fd, &t);
+			thread_add_read(r->master, resolver_cb_socket_readable,
+					r, fd, &t);
 			vector_set_index(r->read_threads, fd, t);
 		}
 	} else {
@@ -122,8 +122,8 @@ static void ares_socket_cb(void *data, ares_socket_t fd, int readable,
 	if (writable) {
 		t = vector_lookup_ensure(r->write_threads, fd);
 		if (!t) {
-			thread_add_read(master, resolver_cb_socket_writable, r,
-					fd, &t);
+			thread_add_read(r->master, resolver_cb_socket_writable,
+					r, fd, &t);
 			vector_set_index(r->write_threads, fd, t);
 		}
 	} else {
@@ -137,10 +137,11 @@ static void ares_socket_cb(void *data, ares_socket_t fd, int readable,
 	}
 }
 
-void resolver_init(void)
+void resolver_init(struct thread_master *tm)
 {
 	struct ares_options ares_opts;
 
+	state.master = tm;
 	state.read_threads = vector_init(1);
 	state.write_threads = vector_init(1);
 
@@ -165,7 +166,7 @@ static void ares_address_cb(void *arg, int status, int timeouts,
 	size_t i;
 
 	if (status != ARES_SUCCESS) {
-		debugf(NHRP_DEBUG_COMMON, "[%p] Resolving failed", query);
+		zlog_debug("[%p] Resolving failed", query);
 		query->callback(query, -1, NULL);
 		query->callback = NULL;
 		return;
@@ -186,8 +187,7 @@ static void ares_address_cb(void *arg, int status, int timeouts,
 		}
 	}
 
-	debugf(NHRP_DEBUG_COMMON, "[%p] Resolved with %d results", query,
-	       (int)i);
+	zlog_debug("[%p] Resolved with %d results", query, (int)i);
 	query->callback(query, i, &addr[0]);
 	query->callback = NULL;
 }
@@ -199,13 +199,13 @@ void resolver_resolve(struct resolver_query *query, int af,
 {
 	if (query->callback != NULL) {
 		flog_err(
-			EC_NHRP_RESOLVER,
+			EC_LIB_RESOLVER,
 			"Trying to resolve '%s', but previous query was not finished yet",
 			hostname);
 		return;
 	}
 
-	debugf(NHRP_DEBUG_COMMON, "[%p] Resolving '%s'", query, hostname);
+	zlog_debug("[%p] Resolving '%s'", query, hostname);
 
 	query->callback = callback;
 	ares_gethostbyname(state.channel, hostname, af, ares_address_cb, query);
@@ -131,3 +131,115 @@ void ringbuf_wipe(struct ringbuf *buf)
 	memset(buf->data, 0x00, buf->size);
 	ringbuf_reset(buf);
 }
+
+/* Lock-free multi-producer / single-consumer pointer ring ----------------- */
+
+struct ringbuf_mp *ringbuf_mp_new(size_t size)
+{
+	struct ringbuf_mp *buf =
+		XCALLOC(MTYPE_RINGBUFFER, sizeof(struct ringbuf_mp));
+	uint32_t sz;
+
+	for (sz = 1; sz < size; sz <<= 1)
+		;
+
+	buf->size = sz;
+	buf->slots = XCALLOC(MTYPE_RINGBUFFER,
+			     sizeof(struct ringbuf_mp_slot) * sz);
+	for (uint32_t i = 0; i < sz; i++)
+		atomic_store_explicit(&buf->slots[i].seq, i,
+				      memory_order_relaxed);
+	return buf;
+}
+
+void ringbuf_mp_del(struct ringbuf_mp *buf)
+{
+	XFREE(MTYPE_RINGBUFFER, buf->slots);
+	XFREE(MTYPE_RINGBUFFER, buf);
+}
+
+size_t ringbuf_mp_put_batch(struct ringbuf_mp *buf, void **items, size_t count)
+{
+	struct ringbuf_mp_slot *slot;
+	uint32_t pos, m;
+
+	if (count == 0)
+		return 0;
+	if (count > buf->size)
+		count = buf->size;
+
+	pos = atomic_load_explicit(&buf->head, memory_order_relaxed);
+	for (;;) {
+		/* The consumer retires slots in order, so if the last
+		 * slot of the batch is reservable, all of them are;
+		 * shrink the batch until that holds. */
+		for (m = count; m > 0; m--) {
+			slot = &buf->slots[(pos + m - 1) & (buf->size - 1)];
+			if ((int32_t)(atomic_load_explicit(
+					      &slot->seq, memory_order_acquire)
+				      - (pos + m - 1))
+			    == 0)
+				break;
+		}
+		if (m == 0) {
+			/* ring is full at pos; if head has moved on,
+			 * reassess from the new position */
+			if (atomic_load_explicit(&buf->head,
+						 memory_order_relaxed)
+			    == pos)
+				return 0;
+			pos = atomic_load_explicit(&buf->head,
+						   memory_order_relaxed);
+			continue;
+		}
+		if (atomic_compare_exchange_weak_explicit(
+			    &buf->head, &pos, pos + m, memory_order_relaxed,
+			    memory_order_relaxed))
+			break;
+		/* lost the race; pos was reloaded by the CAS */
+	}
+
+	/* Slots [pos, pos + m) are ours; fill and publish them in order.
+	 * The consumer blocks at the first unpublished slot, so a batch
+	 * is always seen contiguously. */
+	for (uint32_t i = 0; i < m; i++) {
+		slot = &buf->slots[(pos + i) & (buf->size - 1)];
+		slot->item = items[i];
+		atomic_store_explicit(&slot->seq, pos + i + 1,
+				      memory_order_release);
+	}
+
+	return m;
+}
+
+bool ringbuf_mp_put(struct ringbuf_mp *buf, void *item)
+{
+	return ringbuf_mp_put_batch(buf, &item, 1) == 1;
+}
+
+size_t ringbuf_mp_get_batch(struct ringbuf_mp *buf, void **items, size_t count)
+{
+	struct ringbuf_mp_slot *slot;
+	size_t n = 0;
+
+	while (n < count) {
+		slot = &buf->slots[buf->tail & (buf->size - 1)];
+		if (atomic_load_explicit(&slot->seq, memory_order_acquire)
+		    != buf->tail + 1)
+			break;
+
+		items[n++] = slot->item;
+		atomic_store_explicit(&slot->seq, buf->tail + buf->size,
+				      memory_order_release);
+		buf->tail++;
+	}
+
+	return n;
+}
+
+void *ringbuf_mp_get(struct ringbuf_mp *buf)
+{
+	void *item;
+
+	return ringbuf_mp_get_batch(buf, &item, 1) == 1 ? item : NULL;
+}
@@ -24,6 +24,7 @@
 #include <stdint.h>
 
 #include "memory.h"
+#include "frratomic.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -126,6 +127,88 @@ void ringbuf_reset(struct ringbuf *buf);
  */
 void ringbuf_wipe(struct ringbuf *buf);
 
+
+/*
+ * Lock-free multi-producer / single-consumer ring of pointers, for
+ * cross-pthread handoffs.  Any number of pthreads may put; exactly one
+ * pthread may get.  The ring is bounded: puts fail when it is full, so
+ * callers need an overload strategy (typically falling back to a locked
+ * queue, as lib/thread.c does for cross-thread events).
+ *
+ * Slot sequence numbers follow the bounded MPMC design (Vyukov): slot i
+ * starts with seq == i; a producer that reserved position pos publishes
+ * with seq = pos + 1; the consumer retires the slot with
+ * seq = pos + size, making it reservable one lap later.
+ */
+struct ringbuf_mp_slot {
+	_Atomic uint32_t seq;
+	void *item;
+};
+
+struct ringbuf_mp {
+	struct ringbuf_mp_slot *slots;
+	uint32_t size; /* power of two */
+
+	/* next position to reserve; producers CAS this */
+	_Atomic uint32_t head;
+	/* next position to consume; consumer pthread only */
+	uint32_t tail;
+};
+
+/*
+ * Create a new multi-producer ring.
+ *
+ * @param size	number of pointer slots; rounded up to a power of two
+ * @return the newly created ring
+ */
+struct ringbuf_mp *ringbuf_mp_new(size_t size);
+
+/*
+ * Delete a multi-producer ring and free all associated resources.
+ * The ring must be drained first; queued items are not freed.
+ *
+ * @param buf	the ring to destroy
+ */
+void ringbuf_mp_del(struct ringbuf_mp *buf);
+
+/*
+ * Put one item into the ring.  Safe from any pthread.
+ *
+ * @param item	the pointer to hand off; must not be NULL
+ * @return true on success, false if the ring is full
+ */
+bool ringbuf_mp_put(struct ringbuf_mp *buf, void *item);
+
+/*
+ * Put a batch of items into the ring with a single slot reservation.
+ * The items are published contiguously: the consumer sees them in
+ * order, with nothing else interleaved.  Safe from any pthread.
+ *
+ * @param items	array of pointers to hand off
+ * @param count	how many of items to put in
+ * @return number of items enqueued; less than count (possibly 0) if the
+ * ring filled up
+ */
+size_t ringbuf_mp_put_batch(struct ringbuf_mp *buf, void **items,
+			    size_t count);
+
+/*
+ * Take the oldest item off the ring.  Consumer pthread only.
+ *
+ * @return the item, or NULL if the ring is empty
+ */
+void *ringbuf_mp_get(struct ringbuf_mp *buf);
+
+/*
+ * Take up to count items off the ring.  Consumer pthread only.
+ *
+ * @param items	where to put the items
+ * @param count	capacity of items
+ * @return number of items dequeued; less than count if the ring ran dry
+ */
+size_t ringbuf_mp_get_batch(struct ringbuf_mp *buf, void **items,
+			    size_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -39,6 +39,7 @@ DEFINE_MTYPE(LIB, ROUTE_MAP_RULE, "Route map rule")
 DEFINE_MTYPE_STATIC(LIB, ROUTE_MAP_RULE_STR, "Route map rule str")
 DEFINE_MTYPE(LIB, ROUTE_MAP_COMPILED, "Route map compiled")
 DEFINE_MTYPE_STATIC(LIB, ROUTE_MAP_DEP, "Route map dependency")
+DEFINE_MTYPE_STATIC(LIB, ROUTE_MAP_OPS, "Route map compiled ops")
 
 DEFINE_QOBJ_TYPE(route_map_index)
 DEFINE_QOBJ_TYPE(route_map)
@@ -479,7 +480,8 @@ int generic_match_add(struct vty *vty, struct route_map_index *index,
 	switch (ret) {
 	case RMAP_COMPILE_SUCCESS:
 		if (type != RMAP_EVENT_MATCH_ADDED) {
-			route_map_upd8_dependency(type, arg, index->map->name);
+			route_map_upd8_dependency(type, arg, index->map->name,
+						  index);
 		}
 		break;
 	case RMAP_RULE_MISSING:
@@ -534,7 +536,8 @@ int generic_match_delete(struct vty *vty, struct route_map_index *index,
 		break;
 	case RMAP_COMPILE_SUCCESS:
 		if (type != RMAP_EVENT_MATCH_DELETED && dep_name)
-			route_map_upd8_dependency(type, dep_name, rmap_name);
+			route_map_upd8_dependency(type, dep_name, rmap_name,
+						  index);
 		break;
 	}
 
@@ -617,10 +620,21 @@ struct route_map_list {
 	void (*add_hook)(const char *);
 	void (*delete_hook)(const char *);
 	void (*event_hook)(route_map_event_t, const char *);
+	void (*dep_clause_hook)(route_map_event_t, const char *, struct list *);
 };
 
 /* Master list of route map. */
-static struct route_map_list route_map_master = {NULL, NULL, NULL, NULL, NULL};
+static struct route_map_list route_map_master = {NULL, NULL, NULL,
+						 NULL, NULL, NULL};
+
+/* Bumped on every route-map or referenced list change; compiled index
+ * programs and cached object pointers are revalidated against it. */
+static uint64_t rmap_config_gen = 1;
+
+uint64_t route_map_config_generation(void)
+{
+	return rmap_config_gen;
+}
 struct hash *route_map_master_hash = NULL;
 
 static unsigned int route_map_hash_key_make(void *p)
@@ -668,6 +682,10 @@ struct route_map_dep {
 	char *dep_name;
 	struct hash *dep_rmap_hash;
 	struct hash *this_hash; /* ptr to the hash structure this is part of */
+
+	/* the exact clauses (struct route_map_index *) referencing this
+	 * list, for the finer-grained dep_clause_hook */
+	struct list *dep_clauses;
 };
 
 /* Hashes maintaining dependency between various sublists used by route maps */
@@ -675,6 +693,7 @@ struct hash *route_map_dep_hash[ROUTE_MAP_DEP_MAX];
 
 static unsigned int route_map_dep_hash_make_key(void *p);
 static void route_map_clear_all_references(char *rmap_name);
+static void route_map_purge_clause_references(struct route_map_index *index);
 static void route_map_rule_delete(struct route_map_rule_list *,
 				  struct route_map_rule *);
 static int rmap_debug = 0;
@@ -701,6 +720,7 @@ static struct route_map *route_map_add(const char *name)
 
 	map = route_map_new(name);
 	list = &route_map_master;
+	rmap_config_gen++;
 
 	/* Add map to the hash */
 	hash_get(route_map_master_hash, map, hash_alloc_intern);
@@ -761,6 +781,7 @@ static void route_map_free_map(struct route_map *map)
 		list->head = map->next;
 
 	hash_release(route_map_master_hash, map);
+	XFREE(MTYPE_ROUTE_MAP_OPS, map->jump_table);
 	XFREE(MTYPE_ROUTE_MAP_NAME, map->name);
 	XFREE(MTYPE_ROUTE_MAP, map);
 }
@@ -771,6 +792,8 @@ static void route_map_delete(struct route_map *map)
 	struct route_map_index *index;
 	char *name;
 
+	rmap_config_gen++;
+
 	while ((index = map->head) != NULL)
 		route_map_index_delete(index, 0);
 
@@ -1051,6 +1074,7 @@ static void route_map_index_delete(struct route_map_index *index, int notify)
 {
 	struct route_map_rule *rule;
 
+	rmap_config_gen++;
 	QOBJ_UNREG(index);
 
 	/* Free route match. */
@@ -1075,6 +1099,12 @@ static void route_map_index_delete(struct route_map_index *index, int notify)
 	/* Free 'char *nextrm' if not NULL */
 	XFREE(MTYPE_ROUTE_MAP_NAME, index->nextrm);
 
+	XFREE(MTYPE_ROUTE_MAP_OPS, index->match_ops);
+	XFREE(MTYPE_ROUTE_MAP_OPS, index->set_ops);
+
+	/* Clause references would otherwise dangle. */
+	route_map_purge_clause_references(index);
+
 	/* Execute event hook. */
 	if (route_map_master.event_hook && notify) {
 		(*route_map_master.event_hook)(RMAP_EVENT_INDEX_DELETED,
@@ -1107,6 +1137,7 @@ route_map_index_add(struct route_map *map, enum route_map_type type, int pref)
 	struct route_map_index *point;
 
 	/* Allocate new route map inex. */
+	rmap_config_gen++;
 	index = route_map_index_new();
 	index->map = map;
 	index->type = type;
@@ -1212,6 +1243,8 @@ static struct route_map_rule_cmd *route_map_lookup_set(const char *name)
 static void route_map_rule_add(struct route_map_rule_list *list,
 			       struct route_map_rule *rule)
 {
+	rmap_config_gen++;
+
 	rule->next = NULL;
 	rule->prev = list->tail;
 	if (list->tail)
@@ -1225,6 +1258,8 @@ static void route_map_rule_add(struct route_map_rule_list *list,
 static void route_map_rule_delete(struct route_map_rule_list *list,
 				  struct route_map_rule *rule)
 {
+	rmap_config_gen++;
+
 	if (rule->cmd->func_free)
 		(*rule->cmd->func_free)(rule->value);
 
@@ -1503,20 +1538,19 @@ int route_map_delete_set(struct route_map_index *index, const char *set_name,
 */
 
 static route_map_result_t
-route_map_apply_match(struct route_map_rule_list *match_list,
+route_map_apply_match(struct route_map_index *index,
 		      const struct prefix *prefix, route_map_object_t type,
 		      void *object)
 {
 	route_map_result_t ret = RMAP_NOMATCH;
-	struct route_map_rule *match;
-
+	unsigned int i;
 
 	/* Check all match rule and if there is no match rule, go to the
 	   set statement. */
-	if (!match_list->head)
+	if (!index->n_match_ops)
 		ret = RMAP_MATCH;
 	else {
-		for (match = match_list->head; match; match = match->next) {
+		for (i = 0; i < index->n_match_ops; i++) {
 			/* Try each match statement in turn, If any do not
 			   return
 			   RMAP_MATCH, return, otherwise continue on to next
@@ -1524,8 +1558,9 @@ route_map_apply_match(struct route_map_rule_list *match_list,
 			   statement. All match statements must match for
 			   end-result
 			   to be a match. */
-			ret = (*match->cmd->func_apply)(match->value, prefix,
-							type, object);
+			ret = (*index->match_ops[i].func_apply)(
+				index->match_ops[i].value, prefix, type,
+				object);
 			if (ret != RMAP_MATCH)
 				return ret;
 		}
@@ -1533,15 +1568,108 @@ route_map_apply_match(struct route_map_rule_list *match_list,
 	return ret;
 }
 
+/* (Re)build the flattened op arrays and resolved call target for an
+ * index.  Runs at most once per configuration change, from the first
+ * route_map_apply() after it. */
+static void route_map_index_compile(struct route_map_index *index)
+{
+	struct route_map_rule *rule;
+	unsigned int n;
+
+	XFREE(MTYPE_ROUTE_MAP_OPS, index->match_ops);
+	XFREE(MTYPE_ROUTE_MAP_OPS, index->set_ops);
+	index->n_match_ops = 0;
+	index->n_set_ops = 0;
+
+	for (rule = index->match_list.head; rule; rule = rule->next)
+		index->n_match_ops++;
+	if (index->n_match_ops) {
+		index->match_ops = XCALLOC(MTYPE_ROUTE_MAP_OPS,
+					   index->n_match_ops
+						   * sizeof(struct route_map_op));
+		n = 0;
+		for (rule = index->match_list.head; rule; rule = rule->next) {
+			index->match_ops[n].func_apply = rule->cmd->func_apply;
+			index->match_ops[n].value = rule->value;
+			n++;
+		}
+	}
+
+	for (rule = index->set_list.head; rule; rule = rule->next)
+		index->n_set_ops++;
+	if (index->n_set_ops) {
+		index->set_ops = XCALLOC(MTYPE_ROUTE_MAP_OPS,
+					 index->n_set_ops
+						 * sizeof(struct route_map_op));
+		n = 0;
+		for (rule = index->set_list.head; rule; rule = rule->next) {
+			index->set_ops[n].func_apply = rule->cmd->func_apply;
+			index->set_ops[n].value = rule->value;
+			n++;
+		}
+	}
+
+	index->next_rm = index->nextrm
+				 ? route_map_lookup_by_name(index->nextrm)
+				 : NULL;
+	index->compiled_gen = rmap_config_gen;
+}
+
+/* (Re)build the map's pref-ordered jump table so "on-match goto" can
+ * binary-search its target instead of walking the tail of the map. */
+static void route_map_jump_compile(struct route_map *map)
+{
+	struct route_map_index *index;
+	unsigned int n = 0;
+
+	for (index = map->head; index; index = index->next)
+		n++;
+
+	XFREE(MTYPE_ROUTE_MAP_OPS, map->jump_table);
+	map->index_count = n;
+	if (n)
+		map->jump_table = XCALLOC(
+			MTYPE_ROUTE_MAP_OPS,
+			n * sizeof(struct route_map_index *));
+
+	n = 0;
+	for (index = map->head; index; index = index->next) {
+		index->jump_pos = n;
+		map->jump_table[n++] = index;
+	}
+
+	map->jump_gen = rmap_config_gen;
+}
+
+/* Bring every map's compiled form up to date.  Callers that apply
+ * route-maps from worker threads run this on the main thread first, so
+ * the lazy rebuilds (which free and reallocate the compiled arrays)
+ * cannot race between workers.
+ */
+void route_map_compile_all(void)
+{
+	struct route_map *map;
+	struct route_map_index *index;
+
+	for (map = route_map_master.head; map; map = map->next) {
+		for (index = map->head; index; index = index->next)
+			if (index->compiled_gen != rmap_config_gen)
+				route_map_index_compile(index);
+		if (map->jump_gen != rmap_config_gen)
+			route_map_jump_compile(map);
+	}
+}
+
 /* Apply route map to the object. */
 route_map_result_t route_map_apply(struct route_map *map,
 				   const struct prefix *prefix,
 				   route_map_object_t type, void *object)
 {
-	static int recursion = 0;
+	/* thread-local: route-maps may be applied from worker threads */
+	static __thread int recursion;
 	int ret = 0;
 	struct route_map_index *index;
-	struct route_map_rule *set;
+	unsigned int i;
 
 	if (recursion > RMAP_RECURSION_LIMIT) {
 		flog_warn(
@@ -1559,8 +1687,9 @@ route_map_result_t route_map_apply(struct route_map *map,
 	for (index = map->head; index; index = index->next) {
 		/* Apply this index. */
 		index->applied++;
-		ret = route_map_apply_match(&index->match_list, prefix, type,
-					    object);
+		if (index->compiled_gen != rmap_config_gen)
+			route_map_index_compile(index);
+		ret = route_map_apply_match(index, prefix, type, object);
 
 		/* Now we apply the matrix from above */
 		if (ret == RMAP_NOMATCH)
@@ -1572,17 +1701,15 @@ route_map_result_t route_map_apply(struct route_map *map,
 			/* 'action' */
 			{
 				/* permit+match must execute sets */
-				for (set = index->set_list.head; set;
-				     set = set->next)
-					ret = (*set->cmd->func_apply)(
-						set->value, prefix, type,
-						object);
+				for (i = 0; i < index->n_set_ops; i++)
+					ret = (*index->set_ops[i].func_apply)(
+						index->set_ops[i].value,
+						prefix, type, object);
 
 				/* Call another route-map if available */
 				if (index->nextrm) {
 					struct route_map *nextrm =
-						route_map_lookup_by_name(
-							index->nextrm);
+						index->next_rm;
 
 					if (nextrm) /* Target route-map found,
 						       jump to it */
@@ -1605,19 +1732,32 @@ route_map_result_t route_map_apply(struct route_map *map,
 				case RMAP_NEXT:
 					continue;
 				case RMAP_GOTO: {
-					/* Find the next clause to jump to */
-					struct route_map_index *next =
-						index->next;
-					int nextpref = index->nextpref;
-
-					while (next && next->pref < nextpref) {
-						index = next;
-						next = next->next;
+					/* Binary-search the first clause with
+					 * pref >= nextpref; the loop header
+					 * then steps onto it.  Jumping
+					 * backwards stays impossible. */
+					unsigned int lo, hi, mid;
+
+					if (map->jump_gen != rmap_config_gen)
+						route_map_jump_compile(map);
+
+					lo = 0;
+					hi = map->index_count;
+					while (lo < hi) {
+						mid = (lo + hi) / 2;
+						if (map->jump_table[mid]->pref
+						    < index->nextpref)
+							lo = mid + 1;
+						else
+							hi = mid;
 					}
-					if (next == NULL) {
+					if (lo <= index->jump_pos)
+						lo = index->jump_pos + 1;
+					if (lo >= map->index_count) {
 						/* No clauses match! */
 						return ret;
 					}
+					index = map->jump_table[lo - 1];
 				}
 				}
 			} else if (index->type == RMAP_DENY)
@@ -1631,6 +1771,17 @@ route_map_result_t route_map_apply(struct route_map *map,
 	return RMAP_DENYMATCH;
 }
 
+void route_map_rule_walk(const struct route_map_rule_list *list,
+			 void (*fn)(const char *cmd_name, const char *cmd_arg,
+				    void *arg),
+			 void *arg)
+{
+	struct route_map_rule *rule;
+
+	for (rule = list->head; rule; rule = rule->next)
+		(*fn)(rule->cmd->str, rule->rule_str, arg);
+}
+
 void route_map_add_hook(void (*func)(const char *))
 {
 	route_map_master.add_hook = func;
@@ -1646,6 +1797,13 @@ void route_map_event_hook(void (*func)(route_map_event_t, const char *))
 	route_map_master.event_hook = func;
 }
 
+void route_map_dep_clause_hook(void (*func)(route_map_event_t event,
+					    const char *dep_name,
+					    struct list *clauses))
+{
+	route_map_master.dep_clause_hook = func;
+}
+
 /* Routines for route map dependency lists and dependency processing */
 static bool route_map_rmap_hash_cmp(const void *p1, const void *p2)
 {
@@ -1675,6 +1833,7 @@ static void route_map_clear_reference(struct hash_bucket *bucket, void *arg)
 			dep = hash_release(dep->this_hash,
 					   (void *)dep->dep_name);
 			hash_free(dep->dep_rmap_hash);
+			list_delete(&dep->dep_clauses);
 			XFREE(MTYPE_ROUTE_MAP_NAME, dep->dep_name);
 			XFREE(MTYPE_ROUTE_MAP_DEP, dep);
 		}
@@ -1691,6 +1850,28 @@ static void route_map_clear_all_references(char *rmap_name)
 	}
 }
 
+static void route_map_purge_clause(struct hash_bucket *bucket, void *arg)
+{
+	struct route_map_dep *dep = (struct route_map_dep *)bucket->data;
+	struct listnode *node;
+
+	while ((node = listnode_lookup(dep->dep_clauses, arg)) != NULL)
+		list_delete_node(dep->dep_clauses, node);
+}
+
+/* Drop all clause references to an index that is going away. */
+static void route_map_purge_clause_references(struct route_map_index *index)
+{
+	int i;
+
+	for (i = 1; i < ROUTE_MAP_DEP_MAX; i++) {
+		if (!route_map_dep_hash[i])
+			continue;
+		hash_iterate(route_map_dep_hash[i], route_map_purge_clause,
+			     (void *)index);
+	}
+}
+
 static void *route_map_dep_hash_alloc(void *p)
 {
 	char *dep_name = (char *)p;
@@ -1701,6 +1882,7 @@ static void *route_map_dep_hash_alloc(void *p)
 	dep_entry->dep_rmap_hash =
 		hash_create_size(8, route_map_dep_hash_make_key,
 				 route_map_rmap_hash_cmp, "Route Map Dep Hash");
+	dep_entry->dep_clauses = list_new();
 	dep_entry->this_hash = NULL;
 
 	return ((void *)dep_entry);
@@ -1726,9 +1908,12 @@ static void route_map_print_dependency(struct hash_bucket *bucket, void *data)
 }
 
 static int route_map_dep_update(struct hash *dephash, const char *dep_name,
-				const char *rmap_name, route_map_event_t type)
+				const char *rmap_name, route_map_event_t type,
+				struct route_map_index *index)
 {
 	struct route_map_dep *dep = NULL;
+	struct route_map_index *walk;
+	struct listnode *node;
 	char *ret_map_name;
 	char *dname, *rname;
 	int ret = 0;
@@ -1758,6 +1943,8 @@ static int route_map_dep_update(struct hash *dephash, const char *dep_name,
 			dep->this_hash = dephash;
 
 		hash_get(dep->dep_rmap_hash, rname, route_map_name_hash_alloc);
+		if (index)
+			listnode_add(dep->dep_clauses, index);
 		break;
 	case RMAP_EVENT_PLIST_DELETED:
 	case RMAP_EVENT_CLIST_DELETED:
@@ -1774,12 +1961,24 @@ static int route_map_dep_update(struct hash *dephash, const char *dep_name,
 			goto out;
 		}
 
-		ret_map_name = (char *)hash_release(dep->dep_rmap_hash, rname);
-		XFREE(MTYPE_ROUTE_MAP_NAME, ret_map_name);
+		if (index)
+			listnode_delete(dep->dep_clauses, index);
+
+		/* keep the name reference while other clauses of the same
+		 * route-map still use this list */
+		for (ALL_LIST_ELEMENTS_RO(dep->dep_clauses, node, walk))
+			if (strcmp(walk->map->name, rmap_name) == 0)
+				break;
+		if (!node) {
+			ret_map_name = (char *)hash_release(dep->dep_rmap_hash,
+							    rname);
+			XFREE(MTYPE_ROUTE_MAP_NAME, ret_map_name);
+		}
 
 		if (!dep->dep_rmap_hash->count) {
 			dep = hash_release(dephash, dname);
 			hash_free(dep->dep_rmap_hash);
+			list_delete(&dep->dep_clauses);
 			XFREE(MTYPE_ROUTE_MAP_NAME, dep->dep_name);
 			XFREE(MTYPE_ROUTE_MAP_DEP, dep);
 			dep = NULL;
@@ -1854,12 +2053,15 @@ static void route_map_process_dependency(struct hash_bucket *bucket, void *data)
 }
 
 void route_map_upd8_dependency(route_map_event_t type, const char *arg,
-			       const char *rmap_name)
+			       const char *rmap_name,
+			       struct route_map_index *index)
 {
 	struct hash *upd8_hash = NULL;
 
+	rmap_config_gen++;
+
 	if ((upd8_hash = route_map_get_dep_hash(type))) {
-		route_map_dep_update(upd8_hash, arg, rmap_name, type);
+		route_map_dep_update(upd8_hash, arg, rmap_name, type, index);
 
 		if (type == RMAP_EVENT_CALL_ADDED) {
 			/* Execute hook. */
@@ -1880,6 +2082,8 @@ void route_map_notify_dependencies(const char *affected_name,
 	struct hash *upd8_hash;
 	char *name;
 
+	rmap_config_gen++;
+
 	if (!affected_name)
 		return;
 
@@ -1895,8 +2099,14 @@ void route_map_notify_dependencies(const char *affected_name,
 		if (!dep->this_hash)
 			dep->this_hash = upd8_hash;
 
-		hash_iterate(dep->dep_rmap_hash, route_map_process_dependency,
-			     (void *)event);
+		if (route_map_master.dep_clause_hook
+		    && listcount(dep->dep_clauses))
+			(*route_map_master.dep_clause_hook)(event, name,
+							    dep->dep_clauses);
+		else
+			hash_iterate(dep->dep_rmap_hash,
+				     route_map_process_dependency,
+				     (void *)event);
 	}
 
 	XFREE(MTYPE_ROUTE_MAP_NAME, name);
@@ -2805,14 +3015,15 @@ DEFUN (rmap_call,
 
 	if (index->nextrm) {
 		route_map_upd8_dependency(RMAP_EVENT_CALL_DELETED,
-					  index->nextrm, index->map->name);
+					  index->nextrm, index->map->name,
+					  index);
 		XFREE(MTYPE_ROUTE_MAP_NAME, index->nextrm);
 	}
 	index->nextrm = XSTRDUP(MTYPE_ROUTE_MAP_NAME, rmap);
 
 	/* Execute event hook. */
 	route_map_upd8_dependency(RMAP_EVENT_CALL_ADDED, index->nextrm,
-				  index->map->name);
+				  index->map->name, index);
 	return CMD_SUCCESS;
 }
 
@@ -2826,7 +3037,8 @@ DEFUN (no_rmap_call,
 
 	if (index->nextrm) {
 		route_map_upd8_dependency(RMAP_EVENT_CALL_DELETED,
-					  index->nextrm, index->map->name);
+					  index->nextrm, index->map->name,
+					  index);
 		XFREE(MTYPE_ROUTE_MAP_NAME, index->nextrm);
 		index->nextrm = NULL;
 	}
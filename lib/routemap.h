@@ -25,6 +25,7 @@
 #include "memory.h"
 #include "qobj.h"
 #include "vty.h"
+#include "linklist.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -103,6 +104,18 @@ struct route_map_rule_cmd {
 	void (*func_free)(void *);
 };
 
+/* One flattened match/set operation of an index's compiled program:
+ * just the apply function and its compiled value, laid out
+ * contiguously so route_map_apply() runs a tight dispatch loop instead
+ * of chasing rule list nodes. */
+struct route_map_op {
+	route_map_result_t (*func_apply)(void *rule,
+					 const struct prefix *prefix,
+					 route_map_object_t type,
+					 void *object);
+	void *value;
+};
+
 /* Route map apply error. */
 enum { RMAP_COMPILE_SUCCESS,
 
@@ -149,6 +162,19 @@ struct route_map_index {
 	/* Keep track how many times we've try to apply */
 	uint64_t applied;
 
+	/* Compiled form of this index: the match/set rules flattened
+	 * into op arrays and the call target resolved to a pointer.
+	 * Rebuilt lazily once the configuration generation moves on. */
+	struct route_map_op *match_ops;
+	struct route_map_op *set_ops;
+	unsigned int n_match_ops;
+	unsigned int n_set_ops;
+	struct route_map *next_rm;
+	uint64_t compiled_gen;
+
+	/* Position in the map's jump table (see route_map_jump_compile) */
+	unsigned int jump_pos;
+
 	QOBJ_FIELDS
 };
 DECLARE_QOBJ_TYPE(route_map_index)
@@ -176,6 +202,13 @@ struct route_map {
 	/* Counter to track active usage of this route-map */
 	uint16_t use_count;
 
+	/* All indexes in pref order, so "on-match goto" can binary-search
+	 * its target instead of walking the tail of the map.  Rebuilt
+	 * lazily alongside the per-index compiled form. */
+	struct route_map_index **jump_table;
+	unsigned int index_count;
+	uint64_t jump_gen;
+
 	QOBJ_FIELDS
 };
 DECLARE_QOBJ_TYPE(route_map)
@@ -230,19 +263,49 @@ extern struct route_map *route_map_lookup_by_name(const char *name);
 /* Simple helper to warn if route-map does not exist. */
 struct route_map *route_map_lookup_warn_noexist(struct vty *vty, const char *name);
 
+/* Bring every map's compiled form up to date.  Must be called on the
+ * main thread before route_map_apply() may run on worker threads, so
+ * the lazy recompiles cannot race.
+ */
+extern void route_map_compile_all(void);
+
 /* Apply route map to the object. */
 extern route_map_result_t route_map_apply(struct route_map *map,
 					  const struct prefix *prefix,
 					  route_map_object_t object_type,
 					  void *object);
 
+/* Walk every rule in `list', handing each rule's command name and
+ * argument string to `fn'.  `struct route_map_rule' is private to
+ * routemap.c; this lets daemons reason about what a clause depends on
+ * (e.g. whether all matches look only at the object, not the prefix)
+ * without exposing the rule internals.
+ */
+extern void route_map_rule_walk(const struct route_map_rule_list *list,
+				void (*fn)(const char *cmd_name,
+					   const char *cmd_arg, void *arg),
+				void *arg);
+
 extern void route_map_add_hook(void (*func)(const char *));
 extern void route_map_delete_hook(void (*func)(const char *));
 extern void route_map_event_hook(void (*func)(route_map_event_t, const char *));
+/* Finer-grained alternative to the event hook for list changes: called
+ * once per changed list with the exact set of referencing route-map
+ * clauses (list of struct route_map_index *), instead of one event per
+ * dependent route-map name.  When registered, it replaces the per-name
+ * walk in route_map_notify_dependencies(). */
+extern void route_map_dep_clause_hook(void (*func)(route_map_event_t event,
+						   const char *dep_name,
+						   struct list *clauses));
 extern int route_map_mark_updated(const char *name);
+/* Configuration generation, bumped on every route-map or referenced
+ * list change.  Lets rule implementations cache resolved object
+ * pointers and revalidate them with a single comparison per apply. */
+extern uint64_t route_map_config_generation(void);
 extern void route_map_walk_update_list(void (*update_fn)(char *name));
 extern void route_map_upd8_dependency(route_map_event_t type, const char *arg,
-				      const char *rmap_name);
+				      const char *rmap_name,
+				      struct route_map_index *index);
 extern void route_map_notify_dependencies(const char *affected_name,
 					  route_map_event_t event);
 
@@ -265,11 +265,15 @@ void SHA256_Update(SHA256_CTX *ctx, const void *in, size_t len)
 		return;
 	}
 
-	/* Finish the current block */
-	memcpy(&ctx->buf[r], src, 64 - r);
-	SHA256_Transform(ctx->state, ctx->buf);
-	src += 64 - r;
-	len -= 64 - r;
+	/* Finish the current block; when the buffer is empty (the common
+	 * whole-message case) full blocks are transformed straight from
+	 * the input below instead of being copied first */
+	if (r) {
+		memcpy(&ctx->buf[r], src, 64 - r);
+		SHA256_Transform(ctx->state, ctx->buf);
+		src += 64 - r;
+		len -= 64 - r;
+	}
 
 	/* Perform complete blocks */
 	while (len >= 64) {
@@ -334,6 +338,19 @@ void HMAC__SHA256_Init(HMAC_SHA256_CTX *ctx, const void *_K, size_t Klen)
 	memset(khash, 0, 32);
 }
 
+/*
+ * Start an HMAC-SHA256 operation from a previously keyed context.  A
+ * freshly initialized context contains only the hashed inner/outer key
+ * pads, so a caller authenticating many messages under the same key can
+ * run HMAC__SHA256_Init() once, keep the result as a template, and copy
+ * it per message instead of redoing the two key-pad transforms.
+ */
+void HMAC__SHA256_Init_keyed(HMAC_SHA256_CTX *ctx,
+			     const HMAC_SHA256_CTX *keyed)
+{
+	memcpy(ctx, keyed, sizeof(*ctx));
+}
+
 /* Add bytes to the HMAC-SHA256 operation. */
 void HMAC__SHA256_Update(HMAC_SHA256_CTX *ctx, const void *in, size_t len)
 {
@@ -48,6 +48,9 @@ void SHA256_Init(SHA256_CTX *);
 void SHA256_Update(SHA256_CTX *, const void *, size_t);
 void SHA256_Final(unsigned char[32], SHA256_CTX *);
 void HMAC__SHA256_Init(HMAC_SHA256_CTX *, const void *, size_t);
+/* start from a keyed context kept as a per-key template, skipping the
+   key-pad transforms of HMAC__SHA256_Init() */
+void HMAC__SHA256_Init_keyed(HMAC_SHA256_CTX *, const HMAC_SHA256_CTX *);
 void HMAC__SHA256_Update(HMAC_SHA256_CTX *, const void *, size_t);
 void HMAC__SHA256_Final(unsigned char[32], HMAC_SHA256_CTX *);
 
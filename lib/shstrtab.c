@@ -0,0 +1,201 @@
+/*
+ * Shared-memory read-mostly string intern table.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include <sys/mman.h>
+
+#include "shstrtab.h"
+#include "jhash.h"
+#include "memory.h"
+#include "log.h"
+
+DEFINE_MTYPE_STATIC(LIB, SHSTRTAB, "Shared string table")
+
+/* Keep the probe sequences short; insertion stops at 3/4 occupancy. */
+#define SHSTRTAB_MAX_LOAD(slots) ((slots) / 4 * 3)
+
+static uint32_t shstrtab_pow2(uint32_t val)
+{
+	uint32_t size = 2;
+
+	while (size < val && size != 0)
+		size <<= 1;
+	return size ? size : (1u << 31);
+}
+
+static struct shstrtab *shstrtab_map(int fd, size_t maplen, bool writer)
+{
+	struct shstrtab *st;
+	void *base;
+
+	base = mmap(NULL, maplen,
+		    writer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+		    fd, 0);
+	if (base == MAP_FAILED)
+		return NULL;
+
+	st = XCALLOC(MTYPE_SHSTRTAB, sizeof(struct shstrtab));
+	st->base = base;
+	st->hdr = base;
+	st->slots = (_Atomic uint32_t *)(st->base
+					 + sizeof(struct shstrtab_hdr));
+	st->maplen = maplen;
+	st->fd = fd;
+	st->writer = writer;
+	return st;
+}
+
+struct shstrtab *shstrtab_create(const char *name, uint32_t size)
+{
+	struct shstrtab *st;
+	uint32_t hash_slots;
+	int fd;
+
+	if (size < sizeof(struct shstrtab_hdr) + 4096)
+		size = SHSTRTAB_DEFAULT_SIZE;
+
+	/* Budget roughly one slot per 32 bytes of string space. */
+	hash_slots = shstrtab_pow2(size / 32);
+
+	/* clear out a stale segment from a previous run */
+	shm_unlink(name);
+
+	fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) {
+		zlog_warn("%s: shm_open(%s): %s", __func__, name,
+			  safe_strerror(errno));
+		return NULL;
+	}
+	if (ftruncate(fd, size) < 0) {
+		zlog_warn("%s: ftruncate(%s): %s", __func__, name,
+			  safe_strerror(errno));
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	st = shstrtab_map(fd, size, true);
+	if (!st) {
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	st->hdr->size = size;
+	st->hdr->hash_slots = hash_slots;
+	st->hdr->next = sizeof(struct shstrtab_hdr)
+			+ hash_slots * sizeof(uint32_t);
+	st->hdr->version = SHSTRTAB_VERSION;
+	st->hdr->magic = SHSTRTAB_MAGIC;
+	return st;
+}
+
+struct shstrtab *shstrtab_open(const char *name)
+{
+	struct shstrtab *st;
+	struct stat stat;
+	int fd;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &stat) < 0
+	    || stat.st_size < (off_t)sizeof(struct shstrtab_hdr)) {
+		close(fd);
+		return NULL;
+	}
+
+	st = shstrtab_map(fd, stat.st_size, false);
+	if (!st) {
+		close(fd);
+		return NULL;
+	}
+
+	if (st->hdr->magic != SHSTRTAB_MAGIC
+	    || st->hdr->version != SHSTRTAB_VERSION
+	    || st->hdr->size != (uint32_t)stat.st_size
+	    || st->hdr->hash_slots == 0
+	    || (st->hdr->hash_slots & (st->hdr->hash_slots - 1))) {
+		shstrtab_close(st);
+		return NULL;
+	}
+	return st;
+}
+
+void shstrtab_close(struct shstrtab *st)
+{
+	if (!st)
+		return;
+
+	munmap(st->base, st->maplen);
+	close(st->fd);
+	XFREE(MTYPE_SHSTRTAB, st);
+}
+
+const char *shstrtab_lookup(struct shstrtab *st, const char *str)
+{
+	uint32_t mask = st->hdr->hash_slots - 1;
+	uint32_t i = jhash(str, strlen(str), 0) & mask;
+	uint32_t off, probes;
+
+	for (probes = 0; probes <= mask; probes++, i = (i + 1) & mask) {
+		off = atomic_load_explicit(&st->slots[i],
+					   memory_order_acquire);
+		if (off == 0)
+			return NULL;
+		if (strcmp(st->base + off, str) == 0)
+			return st->base + off;
+	}
+	return NULL;
+}
+
+const char *shstrtab_insert(struct shstrtab *st, const char *str)
+{
+	uint32_t mask = st->hdr->hash_slots - 1;
+	uint32_t i = jhash(str, strlen(str), 0) & mask;
+	size_t len = strlen(str) + 1;
+	uint32_t off;
+
+	assert(st->writer);
+
+	for (;; i = (i + 1) & mask) {
+		off = atomic_load_explicit(&st->slots[i],
+					   memory_order_relaxed);
+		if (off == 0)
+			break;
+		if (strcmp(st->base + off, str) == 0)
+			return st->base + off;
+	}
+
+	if (st->hdr->count >= SHSTRTAB_MAX_LOAD(st->hdr->hash_slots)
+	    || st->hdr->next + len > st->hdr->size)
+		return NULL;
+
+	off = st->hdr->next;
+	memcpy(st->base + off, str, len);
+	st->hdr->next += len;
+
+	/* publish: string bytes must be visible before the slot is */
+	atomic_store_explicit(&st->slots[i], off, memory_order_release);
+	atomic_fetch_add_explicit(&st->hdr->count, 1, memory_order_relaxed);
+
+	return st->base + off;
+}
@@ -0,0 +1,94 @@
+/*
+ * Shared-memory read-mostly string intern table.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _ZEBRA_SHSTRTAB_H
+#define _ZEBRA_SHSTRTAB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "frratomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A fixed-size string table in a named POSIX shared-memory segment.  One
+ * writer process (zebra) appends strings; any number of reader processes
+ * map the same segment read-only, so identical strings interned by many
+ * daemons occupy one set of physical pages instead of one heap copy per
+ * process.
+ *
+ * The segment is append-only: a string, once inserted, is never moved or
+ * removed, so pointers returned by lookup/insert stay valid for the
+ * lifetime of the mapping.  Writer and readers synchronize only through
+ * the hash slots, which the writer fills with release stores after the
+ * string bytes are in place.
+ */
+
+struct shstrtab_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;       /* total segment size in bytes */
+	uint32_t hash_slots; /* power of two */
+	_Atomic uint32_t count; /* strings present */
+	uint32_t next;		/* append offset; writer only */
+};
+
+struct shstrtab {
+	struct shstrtab_hdr *hdr;
+	_Atomic uint32_t *slots; /* string offset from segment start, or 0 */
+	char *base;		 /* segment start */
+	size_t maplen;
+	int fd;
+	bool writer;
+};
+
+#define SHSTRTAB_MAGIC 0x53545242 /* "STRB" */
+#define SHSTRTAB_VERSION 1
+
+/* Default segment name and size used by zebra. */
+#define SHSTRTAB_DEFAULT_NAME "/frr-strtab"
+#define SHSTRTAB_DEFAULT_SIZE (32 * 1024 * 1024)
+
+/* Create a fresh segment of 'size' bytes under the given shm name,
+ * replacing any stale segment with that name.  Writer side.  Returns
+ * NULL on failure. */
+extern struct shstrtab *shstrtab_create(const char *name, uint32_t size);
+
+/* Map an existing segment read-only.  Validates the header.  Returns
+ * NULL if the segment does not exist or is malformed. */
+extern struct shstrtab *shstrtab_open(const char *name);
+
+/* Unmap and close; the writer also unlinks the segment name. */
+extern void shstrtab_close(struct shstrtab *st);
+
+/* Intern a string (writer only).  Returns the shared copy, or NULL if
+ * the segment is full. Idempotent. */
+extern const char *shstrtab_insert(struct shstrtab *st, const char *str);
+
+/* Find a string's shared copy, or NULL if it has not been interned. */
+extern const char *shstrtab_lookup(struct shstrtab *st, const char *str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ZEBRA_SHSTRTAB_H */
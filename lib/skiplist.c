@@ -64,12 +64,42 @@
 
 DEFINE_MTYPE_STATIC(LIB, SKIP_LIST, "Skip List")
 DEFINE_MTYPE_STATIC(LIB, SKIP_LIST_NODE, "Skip Node")
+DEFINE_MTYPE_POOL_STATIC(LIB, SKIP_LIST_SHORT_NODE, "Skip Node (pooled)")
 
 #define BitsInRandom 31
 
 #define MaxNumberOfLevels 16
 #define MaxLevel (MaxNumberOfLevels-1)
-#define newNodeOfLevel(l) XCALLOC(MTYPE_SKIP_LIST_NODE, sizeof(struct skiplistnode)+(l)*sizeof(struct skiplistnode *))
+
+/* With p = 0.25, nodes of level <= 3 make up ~99.6% of any list; those
+ * come from a fixed-size slab pool, only the rare tall node (and the
+ * header) goes to the system allocator individually. */
+#define SkiplistPoolLevels 4
+
+static struct skiplistnode *newNodeOfLevel(int level)
+{
+	struct skiplistnode *new;
+
+	if (level < SkiplistPoolLevels)
+		new = XCALLOC(MTYPE_SKIP_LIST_SHORT_NODE,
+			      sizeof(struct skiplistnode)
+				      + (SkiplistPoolLevels - 1)
+						* sizeof(struct skiplistnode *));
+	else
+		new = XCALLOC(MTYPE_SKIP_LIST_NODE,
+			      sizeof(struct skiplistnode)
+				      + level * sizeof(struct skiplistnode *));
+	new->level = level;
+	return new;
+}
+
+static void freeNode(struct skiplistnode *node)
+{
+	if (node->level < SkiplistPoolLevels)
+		XFREE(MTYPE_SKIP_LIST_SHORT_NODE, node);
+	else
+		XFREE(MTYPE_SKIP_LIST_NODE, node);
+}
 
 static int randomsLeft;
 static int randomBits;
@@ -163,19 +193,80 @@ void skiplist_free(struct skiplist *l)
 		q = p->forward[0];
 		if (l->del && p != l->header)
 			(*l->del)(p->value);
-		XFREE(MTYPE_SKIP_LIST_NODE, p);
+		freeNode(p);
 		p = q;
 	} while (p);
 
-	XFREE(MTYPE_SKIP_LIST_NODE, l->stats);
+	freeNode(l->stats);
 	XFREE(MTYPE_SKIP_LIST, l);
 }
 
+struct skiplist *skiplist_new_sorted(int flags,
+				     int (*cmp)(void *key1, void *key2),
+				     void (*del)(void *val), void **keys,
+				     void **values, unsigned int count)
+{
+	struct skiplist *l;
+	struct skiplistnode *tails[MaxNumberOfLevels], *q;
+	unsigned int i;
+	int k, j;
+
+	l = skiplist_new(flags, cmp, del);
+
+	for (k = 0; k < MaxNumberOfLevels; k++)
+		tails[k] = l->header;
+
+	for (i = 0; i < count; i++) {
+		if (i > 0) {
+			int rc = (*l->cmp)(keys[i], keys[i - 1]);
+
+			if (rc < 0
+			    || (rc == 0
+				&& !(l->flags
+				     & SKIPLIST_FLAG_ALLOW_DUPLICATES))) {
+				flog_err(EC_LIB_DEVELOPMENT,
+					 "%s: input not sorted at %u",
+					 __func__, i);
+				l->del = NULL; /* ownership stays with caller */
+				skiplist_free(l);
+				return NULL;
+			}
+		}
+
+		/* deterministic stand-in for randomLevel(): promote every
+		 * 4th node one level, matching p = 0.25 exactly */
+		k = 0;
+		for (j = i + 1; (j & 3) == 0 && k < MaxLevel; j >>= 2)
+			k++;
+
+		q = newNodeOfLevel(k);
+		q->key = keys[i];
+		q->value = values ? values[i] : keys[i];
+#if SKIPLIST_0TIMER_DEBUG
+		q->flags = SKIPLIST_NODE_FLAG_INSERTED;
+#endif
+
+		if (k > l->level)
+			l->level = k;
+		++(l->stats->forward[k]);
+
+		for (j = 0; j <= k; j++) {
+			tails[j]->forward[j] = q;
+			tails[j] = q;
+		}
+		l->last = q;
+		++(l->count);
+	}
+
+	CHECKLAST(l);
+	return l;
+}
+
 
 int skiplist_insert(register struct skiplist *l, register void *key,
 		    register void *value)
 {
-	register int k;
+	register int k, m;
 	struct skiplistnode *update[MaxNumberOfLevels];
 	register struct skiplistnode *p, *q;
 
@@ -221,11 +312,13 @@ int skiplist_insert(register struct skiplist *l, register void *key,
 		   l->stats->forward[k] - (struct skiplistnode *)NULL);
 #endif
 
-	do {
-		p = update[k];
-		q->forward[k] = p->forward[k];
-		p->forward[k] = q;
-	} while (--k >= 0);
+	/* Fill in all of the new node's forwards before linking it, and
+	 * link bottom level first: a reader descending through the new
+	 * node then never sees a partially initialized one. */
+	for (m = 0; m <= k; m++)
+		q->forward[m] = update[m]->forward[m];
+	for (m = 0; m <= k; m++)
+		update[m]->forward[m] = q;
 
 	/*
 	 * If this is the last item in the list, update the "last" pointer
@@ -308,7 +401,7 @@ int skiplist_delete(register struct skiplist *l, register void *key,
 #endif
 			if (l->del)
 				(*l->del)(q->value);
-			XFREE(MTYPE_SKIP_LIST_NODE, q);
+			freeNode(q);
 			while (l->header->forward[m] == NULL && m > 0)
 				m--;
 			l->level = m;
@@ -570,7 +663,7 @@ int skiplist_delete_first(register struct skiplist *l)
 	if (l->del)
 		(*l->del)(q->value);
 
-	XFREE(MTYPE_SKIP_LIST_NODE, q);
+	freeNode(q);
 
 	CHECKLAST(l);
 
@@ -663,4 +756,38 @@ void skiplist_test(struct vty *vty)
 	}
 
 	skiplist_free(l);
+
+	/* bulk-load path: build from sorted keys, then verify lookups
+	 * and in-order traversal */
+	zlog_debug("%s: testing skiplist_new_sorted", __func__);
+
+	for (k = 0; k < sampleSize; k++)
+		keys[k] = (void *)(uintptr_t)(k + 1);
+
+	l = skiplist_new_sorted(0, NULL, NULL, keys, keys, sampleSize);
+	if (!l) {
+		zlog_debug("error in skiplist_new_sorted");
+		return;
+	}
+	if (skiplist_count(l) != sampleSize)
+		zlog_debug("new_sorted: wrong count");
+
+	for (k = 0; k < sampleSize; k++) {
+		if (skiplist_search(l, keys[k], &v))
+			zlog_debug("new_sorted: error in search #%d", k);
+		if (v != keys[k])
+			zlog_debug("new_sorted: search returned wrong value");
+	}
+
+	v = NULL;
+	if (skiplist_last(l, &v, NULL) || v != keys[sampleSize - 1])
+		zlog_debug("new_sorted: wrong last element");
+
+	/* the list must behave normally afterwards */
+	if (skiplist_delete(l, keys[17], keys[17]))
+		zlog_debug("new_sorted: error in delete");
+	if (skiplist_insert(l, keys[17], keys[17]))
+		zlog_debug("new_sorted: error in insert");
+
+	skiplist_free(l);
 }
@@ -48,6 +48,8 @@ struct skiplistnode {
 	int flags;
 #define SKIPLIST_NODE_FLAG_INSERTED 0x00000001
 #endif
+	int level; /* this node's top level; selects the allocation size
+		      class so short nodes can come from a slab pool */
 
 	struct skiplistnode *forward[1]; /* variable sized */
 };
@@ -86,6 +88,19 @@ skiplist_new(/* encouraged: set list.del callback on new lists */
 
 extern void skiplist_free(struct skiplist *);
 
+/*
+ * Build a skiplist from keys already sorted ascending per cmp, in O(n).
+ * Node levels are assigned deterministically (every 4th node is
+ * promoted a level), so the resulting list is perfectly balanced
+ * instead of probabilistically so.  Returns NULL if the input is found
+ * not to be sorted, or contains duplicate keys without
+ * SKIPLIST_FLAG_ALLOW_DUPLICATES.
+ */
+extern struct skiplist *
+skiplist_new_sorted(int flags, int (*cmp)(void *key1, void *key2),
+		    void (*del)(void *val), void **keys, void **values,
+		    unsigned int count);
+
 extern int skiplist_insert(register struct skiplist *l, register void *key,
 			   register void *value);
 
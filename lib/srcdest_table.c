@@ -37,6 +37,14 @@ struct srcdest_rnode {
 	ROUTE_NODE_FIELDS;
 
 	struct route_table *src_table;
+
+	/* Inline cache of the first few source nodes.  Most SADR
+	 * destinations only carry a handful of source prefixes, so an
+	 * exact-match hit here skips the second lookup through src_table
+	 * entirely.  Slots hold borrowed pointers; they are invalidated
+	 * from srcdest_srcnode_destroy(), so a hit is always current.
+	 */
+	struct route_node *src_inline[SRCDEST_SRC_INLINE];
 };
 
 static struct srcdest_rnode *srcdest_rnode_from_rnode(struct route_node *rn)
@@ -100,10 +108,16 @@ static void srcdest_srcnode_destroy(route_table_delegate_t *delegate,
 				    struct route_node *rn)
 {
 	struct srcdest_rnode *srn;
-
-	XFREE(MTYPE_ROUTE_SRC_NODE, rn);
+	int i;
 
 	srn = route_table_get_info(table);
+
+	/* drop the node from the inline cache before it is freed */
+	for (i = 0; i < SRCDEST_SRC_INLINE; i++)
+		if (srn->src_inline[i] == rn)
+			srn->src_inline[i] = NULL;
+
+	XFREE(MTYPE_ROUTE_SRC_NODE, rn);
 	if (srn->src_table && route_table_count(srn->src_table) == 0) {
 		/* deleting the route_table from inside destroy_node is ONLY
 		 * permitted IF table->count is 0!  see lib/table.c
@@ -125,11 +139,45 @@ route_table_delegate_t _srcdest_srcnode_delegate = {
 	.create_node = srcdest_srcnode_create,
 	.destroy_node = srcdest_srcnode_destroy};
 
+/* look for an exact source-prefix match in the inline cache.  a miss
+ * just means we fall back to the src_table lookup; callers passing an
+ * unmasked prefix miss here and get masked on the slow path. */
+static struct route_node *
+srcdest_src_inline_find(struct srcdest_rnode *srn,
+			const struct prefix_ipv6 *src_p)
+{
+	int i;
+
+	for (i = 0; i < SRCDEST_SRC_INLINE; i++)
+		if (srn->src_inline[i]
+		    && prefix_same(&srn->src_inline[i]->p,
+				   (const struct prefix *)src_p))
+			return srn->src_inline[i];
+
+	return NULL;
+}
+
+static void srcdest_src_inline_add(struct srcdest_rnode *srn,
+				   struct route_node *rn)
+{
+	int i;
+
+	for (i = 0; i < SRCDEST_SRC_INLINE; i++) {
+		if (srn->src_inline[i] == rn)
+			return;
+		if (!srn->src_inline[i]) {
+			srn->src_inline[i] = rn;
+			return;
+		}
+	}
+}
+
 /* NB: read comments in code for refcounting before using! */
 static struct route_node *srcdest_srcnode_get(struct route_node *rn,
 					      const struct prefix_ipv6 *src_p)
 {
 	struct srcdest_rnode *srn;
+	struct route_node *srcnode;
 
 	if (!src_p || src_p->prefixlen == 0)
 		return rn;
@@ -156,9 +204,17 @@ static struct route_node *srcdest_srcnode_get(struct route_node *rn,
 		 * holding
 		 * another reference, so this won't free rn */
 		route_unlock_node(rn);
+
+		/* hot path: the source node is already known, no need to
+		 * walk src_table again */
+		srcnode = srcdest_src_inline_find(srn, src_p);
+		if (srcnode)
+			return route_lock_node(srcnode);
 	}
 
-	return route_node_get(srn->src_table, (const struct prefix *)src_p);
+	srcnode = route_node_get(srn->src_table, (const struct prefix *)src_p);
+	srcdest_src_inline_add(srn, srcnode);
+	return srcnode;
 }
 
 static struct route_node *srcdest_srcnode_lookup(
@@ -166,6 +222,7 @@ static struct route_node *srcdest_srcnode_lookup(
 	const struct prefix_ipv6 *src_p)
 {
 	struct srcdest_rnode *srn;
+	struct route_node *srcnode;
 
 	if (!rn || !src_p || src_p->prefixlen == 0)
 		return rn;
@@ -181,6 +238,12 @@ static struct route_node *srcdest_srcnode_lookup(
 	if (!srn->src_table)
 		return NULL;
 
+	/* hot path: match route_node_lookup()'s behaviour of not returning
+	 * info-less nodes */
+	srcnode = srcdest_src_inline_find(srn, src_p);
+	if (srcnode)
+		return srcnode->info ? route_lock_node(srcnode) : NULL;
+
 	return route_node_lookup(srn->src_table, (const struct prefix *)src_p);
 }
 
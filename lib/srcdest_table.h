@@ -52,6 +52,9 @@ extern "C" {
 
 #define SRCDEST2STR_BUFFER (2*PREFIX2STR_BUFFER + sizeof(" from "))
 
+/* number of source nodes cached inline on each destination node */
+#define SRCDEST_SRC_INLINE 4
+
 /* extended route node for IPv6 srcdest routing */
 struct srcdest_rnode;
 
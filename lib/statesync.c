@@ -0,0 +1,392 @@
+/*
+ * Active/standby state-sync framework.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "buffer.h"
+#include "log.h"
+#include "memory.h"
+#include "network.h"
+#include "sockopt.h"
+#include "sockunion.h"
+#include "vty.h"
+#include "statesync.h"
+
+DEFINE_MTYPE_STATIC(LIB, STATESYNC, "State sync session")
+
+#define STATESYNC_RECONNECT_SECS 2
+
+static int statesync_read(struct thread *thread);
+static int statesync_connect(struct thread *thread);
+
+static void statesync_close_feed(struct statesync *ss)
+{
+	THREAD_OFF(ss->t_read);
+	THREAD_OFF(ss->t_write);
+
+	if (ss->fd >= 0) {
+		close(ss->fd);
+		ss->fd = -1;
+		ss->drops++;
+	}
+
+	buffer_reset(ss->obuf);
+	stream_reset(ss->ibuf);
+
+	/* the standby keeps trying to reach the active */
+	if (ss->role == STATESYNC_STANDBY)
+		thread_add_timer(ss->master, statesync_connect, ss,
+				 STATESYNC_RECONNECT_SECS, &ss->t_connect);
+}
+
+static int statesync_write(struct thread *thread)
+{
+	struct statesync *ss = THREAD_ARG(thread);
+
+	ss->t_write = NULL;
+
+	if (ss->fd < 0)
+		return 0;
+
+	if (buffer_flush_available(ss->obuf, ss->fd) == BUFFER_ERROR) {
+		zlog_warn("statesync: write to %s failed: %s",
+			  ss->role == STATESYNC_ACTIVE ? "standby" : "active",
+			  safe_strerror(errno));
+		statesync_close_feed(ss);
+		return 0;
+	}
+
+	if (!buffer_empty(ss->obuf))
+		thread_add_write(ss->master, statesync_write, ss, ss->fd,
+				 &ss->t_write);
+
+	return 0;
+}
+
+void statesync_send(struct statesync *ss, uint8_t type, struct stream *s)
+{
+	uint8_t header[STATESYNC_HEADER_SIZE];
+	size_t len = stream_get_endp(s);
+
+	if (!ss || ss->fd < 0)
+		return;
+
+	header[0] = (len + STATESYNC_HEADER_SIZE) >> 8;
+	header[1] = (len + STATESYNC_HEADER_SIZE) & 0xff;
+	header[2] = STATESYNC_VERSION;
+	header[3] = type;
+
+	buffer_put(ss->obuf, header, sizeof(header));
+	buffer_put(ss->obuf, STREAM_DATA(s), len);
+	ss->msgs_sent++;
+
+	thread_add_write(ss->master, statesync_write, ss, ss->fd,
+			 &ss->t_write);
+}
+
+/* dispatch every complete message sitting in the input stream */
+static int statesync_parse(struct statesync *ss)
+{
+	struct stream *s = ss->ibuf;
+	size_t msgstart, have, len;
+	uint8_t version, type;
+
+	while ((have = stream_get_endp(s) - stream_get_getp(s))
+	       >= STATESYNC_HEADER_SIZE) {
+		msgstart = stream_get_getp(s);
+		len = stream_getw(s);
+		version = stream_getc(s);
+		type = stream_getc(s);
+
+		if (version != STATESYNC_VERSION
+		    || len < STATESYNC_HEADER_SIZE
+		    || len > STATESYNC_MAX_PACKET_SIZE) {
+			zlog_warn(
+				"statesync: bad message (version %u, length %zu)",
+				version, len);
+			return -1;
+		}
+
+		if (have < len) {
+			/* partial message; wait for the rest */
+			stream_set_getp(s, msgstart);
+			break;
+		}
+
+		if (type < STATESYNC_TYPE_MAX && ss->handlers[type].apply) {
+			if (ss->handlers[type].apply(
+				    ss, s, len - STATESYNC_HEADER_SIZE)) {
+				zlog_warn(
+					"statesync: apply failed for type %s",
+					ss->handlers[type].name);
+				return -1;
+			}
+		}
+
+		/* skip anything the handler did not consume */
+		stream_set_getp(s, msgstart + len);
+		ss->msgs_rcvd++;
+	}
+
+	/* compact consumed data out of the front of the buffer */
+	if (stream_get_getp(s)) {
+		have = stream_get_endp(s) - stream_get_getp(s);
+		memmove(STREAM_DATA(s), stream_pnt(s), have);
+		stream_set_getp(s, 0);
+		stream_set_endp(s, have);
+	}
+
+	return 0;
+}
+
+static int statesync_read(struct thread *thread)
+{
+	struct statesync *ss = THREAD_ARG(thread);
+	ssize_t nbytes;
+
+	ss->t_read = NULL;
+
+	nbytes = stream_read_try(ss->ibuf, ss->fd,
+				 STREAM_WRITEABLE(ss->ibuf));
+	if (nbytes == 0 || (nbytes == -1 && errno != EAGAIN)) {
+		zlog_info("statesync: connection closed");
+		statesync_close_feed(ss);
+		return 0;
+	}
+
+	if (nbytes > 0 && statesync_parse(ss) < 0) {
+		statesync_close_feed(ss);
+		return 0;
+	}
+
+	thread_add_read(ss->master, statesync_read, ss, ss->fd, &ss->t_read);
+	return 0;
+}
+
+static void statesync_feed_start(struct statesync *ss, int fd)
+{
+	/* only one feed at a time; a fresh connection supersedes */
+	if (ss->fd >= 0)
+		statesync_close_feed(ss);
+
+	set_nonblocking(fd);
+	setsockopt_so_sendbuf(fd, 1024 * 1024);
+
+	ss->fd = fd;
+	ss->connects++;
+
+	thread_add_read(ss->master, statesync_read, ss, ss->fd, &ss->t_read);
+}
+
+static int statesync_accept(struct thread *thread)
+{
+	struct statesync *ss = THREAD_ARG(thread);
+	union sockunion su;
+	char buf[SU_ADDRSTRLEN];
+	int fd, i;
+
+	ss->t_accept = NULL;
+	thread_add_read(ss->master, statesync_accept, ss, ss->listen_fd,
+			&ss->t_accept);
+
+	memset(&su, 0, sizeof(su));
+	fd = sockunion_accept(ss->listen_fd, &su);
+	if (fd < 0) {
+		zlog_warn("statesync: accept failed: %s",
+			  safe_strerror(errno));
+		return 0;
+	}
+
+	zlog_info("statesync: standby connected from %s",
+		  sockunion2str(&su, buf, sizeof(buf)));
+
+	statesync_feed_start(ss, fd);
+
+	/* bring the fresh standby level: replay all registered state */
+	for (i = 0; i < STATESYNC_TYPE_MAX; i++)
+		if (ss->handlers[i].dump)
+			ss->handlers[i].dump(ss);
+
+	return 0;
+}
+
+static int statesync_connect(struct thread *thread)
+{
+	struct statesync *ss = THREAD_ARG(thread);
+	union sockunion su;
+	int fd;
+
+	ss->t_connect = NULL;
+
+	if (str2sockunion(ss->peer, &su) < 0)
+		return 0;
+
+	fd = sockunion_socket(&su);
+	if (fd < 0)
+		return 0;
+
+	if (sockunion_connect(fd, &su, htons(ss->port), 0)
+	    == connect_error) {
+		close(fd);
+		thread_add_timer(ss->master, statesync_connect, ss,
+				 STATESYNC_RECONNECT_SECS, &ss->t_connect);
+		return 0;
+	}
+
+	zlog_info("statesync: connected to active %s port %u", ss->peer,
+		  ss->port);
+	statesync_feed_start(ss, fd);
+
+	return 0;
+}
+
+struct statesync *statesync_new(struct thread_master *master)
+{
+	struct statesync *ss;
+
+	ss = XCALLOC(MTYPE_STATESYNC, sizeof(struct statesync));
+	ss->master = master;
+	ss->listen_fd = -1;
+	ss->fd = -1;
+	ss->obuf = buffer_new(0);
+	ss->ibuf = stream_new(STATESYNC_MAX_PACKET_SIZE * 2);
+
+	return ss;
+}
+
+void statesync_free(struct statesync **ss)
+{
+	if (!*ss)
+		return;
+
+	statesync_stop(*ss);
+	buffer_free((*ss)->obuf);
+	stream_free((*ss)->ibuf);
+	XFREE(MTYPE_STATESYNC, *ss);
+}
+
+void statesync_register(struct statesync *ss, uint8_t type, const char *name,
+			void (*dump)(struct statesync *ss),
+			int (*apply)(struct statesync *ss, struct stream *s,
+				     size_t len))
+{
+	assert(type < STATESYNC_TYPE_MAX);
+
+	ss->handlers[type].name = name;
+	ss->handlers[type].dump = dump;
+	ss->handlers[type].apply = apply;
+}
+
+int statesync_active_start(struct statesync *ss, uint16_t port)
+{
+	union sockunion su;
+	int fd;
+
+	statesync_stop(ss);
+
+	memset(&su, 0, sizeof(su));
+	su.sin.sin_family = AF_INET;
+
+	fd = sockunion_socket(&su);
+	if (fd < 0)
+		return -1;
+
+	sockopt_reuseaddr(fd);
+	if (sockunion_bind(fd, &su, port, NULL) < 0 || listen(fd, 1) < 0) {
+		zlog_warn("statesync: cannot listen on port %u: %s", port,
+			  safe_strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	ss->role = STATESYNC_ACTIVE;
+	ss->port = port;
+	ss->listen_fd = fd;
+	thread_add_read(ss->master, statesync_accept, ss, ss->listen_fd,
+			&ss->t_accept);
+
+	return 0;
+}
+
+int statesync_standby_start(struct statesync *ss, const char *host,
+			    uint16_t port)
+{
+	union sockunion su;
+
+	if (str2sockunion(host, &su) < 0)
+		return -1;
+
+	statesync_stop(ss);
+
+	ss->role = STATESYNC_STANDBY;
+	ss->port = port;
+	strlcpy(ss->peer, host, sizeof(ss->peer));
+
+	thread_add_event(ss->master, statesync_connect, ss, 0,
+			 &ss->t_connect);
+
+	return 0;
+}
+
+void statesync_stop(struct statesync *ss)
+{
+	THREAD_OFF(ss->t_accept);
+	THREAD_OFF(ss->t_connect);
+
+	if (ss->listen_fd >= 0) {
+		close(ss->listen_fd);
+		ss->listen_fd = -1;
+	}
+
+	statesync_close_feed(ss);
+	THREAD_OFF(ss->t_connect); /* close_feed rearms on standby */
+	ss->role = STATESYNC_NONE;
+}
+
+bool statesync_connected(const struct statesync *ss)
+{
+	return ss && ss->fd >= 0;
+}
+
+void statesync_show(struct vty *vty, const struct statesync *ss)
+{
+	int i;
+
+	if (!ss || ss->role == STATESYNC_NONE) {
+		vty_out(vty, "State sync is not configured\n");
+		return;
+	}
+
+	if (ss->role == STATESYNC_ACTIVE)
+		vty_out(vty, "Active, listening on port %u, standby %s\n",
+			ss->port,
+			ss->fd >= 0 ? "connected" : "not connected");
+	else
+		vty_out(vty, "Standby, active %s port %u, %s\n", ss->peer,
+			ss->port, ss->fd >= 0 ? "connected" : "connecting");
+
+	vty_out(vty, "  %lu messages sent, %lu received, %lu connects, %lu drops\n",
+		ss->msgs_sent, ss->msgs_rcvd, ss->connects, ss->drops);
+
+	vty_out(vty, "  Registered state types:");
+	for (i = 0; i < STATESYNC_TYPE_MAX; i++)
+		if (ss->handlers[i].name)
+			vty_out(vty, " %s", ss->handlers[i].name);
+	vty_out(vty, "\n");
+}
@@ -0,0 +1,128 @@
+/*
+ * Active/standby state-sync framework.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _ZEBRA_STATESYNC_H
+#define _ZEBRA_STATESYNC_H
+
+#include "stream.h"
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Incremental state replication between an active daemon and a hot
+ * standby on the other RP.  The active listens on a TCP socket; a
+ * standby connects and first receives a full dump of every registered
+ * state type, then an incremental change feed as the active publishes
+ * updates.  Message payloads are opaque to the framework - each daemon
+ * registers its state types with a dump callback (active side, replays
+ * current state to a fresh standby) and an apply callback (standby
+ * side, consumes one message).
+ *
+ * Wire format per message: length (2, includes header), version (1),
+ * type (1), payload.
+ */
+
+#define STATESYNC_HEADER_SIZE 4
+#define STATESYNC_VERSION 1
+#define STATESYNC_MAX_PACKET_SIZE 4096
+
+/* state types are small integers, allocated by the owning daemon */
+#define STATESYNC_TYPE_MAX 32
+
+enum statesync_role {
+	STATESYNC_NONE = 0,
+	STATESYNC_ACTIVE,
+	STATESYNC_STANDBY,
+};
+
+struct statesync;
+
+struct statesync_handler {
+	const char *name;
+
+	/* active: replay current state to a newly connected standby */
+	void (*dump)(struct statesync *ss);
+
+	/* standby: apply one change-feed message; nonzero on decode
+	 * error (connection is dropped) */
+	int (*apply)(struct statesync *ss, struct stream *s, size_t len);
+};
+
+struct statesync {
+	struct thread_master *master;
+	enum statesync_role role;
+
+	char peer[64]; /* standby: active's address */
+	uint16_t port;
+
+	int listen_fd; /* active */
+	int fd;	/* connected feed, either role */
+
+	struct buffer *obuf;
+	struct stream *ibuf;
+
+	struct thread *t_accept;
+	struct thread *t_read;
+	struct thread *t_write;
+	struct thread *t_connect;
+
+	struct statesync_handler handlers[STATESYNC_TYPE_MAX];
+
+	/* stats */
+	unsigned long msgs_sent;
+	unsigned long msgs_rcvd;
+	unsigned long connects;
+	unsigned long drops;
+};
+
+extern struct statesync *statesync_new(struct thread_master *master);
+extern void statesync_free(struct statesync **ss);
+
+extern void statesync_register(struct statesync *ss, uint8_t type,
+			       const char *name,
+			       void (*dump)(struct statesync *ss),
+			       int (*apply)(struct statesync *ss,
+					    struct stream *s, size_t len));
+
+/* active: accept standby connections on the given port */
+extern int statesync_active_start(struct statesync *ss, uint16_t port);
+
+/* standby: connect (and reconnect) to the active */
+extern int statesync_standby_start(struct statesync *ss, const char *host,
+				   uint16_t port);
+
+extern void statesync_stop(struct statesync *ss);
+
+extern bool statesync_connected(const struct statesync *ss);
+
+/* active: queue one change-feed message; s starts at the payload, the
+ * framework adds the header.  No-op unless a standby is connected. */
+extern void statesync_send(struct statesync *ss, uint8_t type,
+			   struct stream *s);
+
+extern void statesync_show(struct vty *vty, const struct statesync *ss);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ZEBRA_STATESYNC_H */
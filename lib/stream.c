@@ -106,17 +106,56 @@ struct stream *stream_new(size_t size)
 
 	s->getp = s->endp = 0;
 	s->next = NULL;
+	s->parent = NULL;
+	s->refcnt = 1;
 	s->size = size;
+	s->flags = 0;
+	s->data = (unsigned char *)(s + 1);
 	return s;
 }
 
-/* Free it now. */
+/* Free it now - or, on a shared stream, drop one reference. */
 void stream_free(struct stream *s)
 {
+	struct stream *parent;
+
 	if (!s)
 		return;
 
+	if (atomic_fetch_sub_explicit(&s->refcnt, 1, memory_order_acq_rel)
+	    > 1)
+		return;
+
+	parent = s->parent;
 	XFREE(MTYPE_STREAM, s);
+	if (parent)
+		stream_free(parent);
+}
+
+struct stream *stream_ref(struct stream *s)
+{
+	atomic_fetch_add_explicit(&s->refcnt, 1, memory_order_relaxed);
+	return s;
+}
+
+struct stream *stream_slice(struct stream *s, size_t from, size_t to)
+{
+	struct stream *new;
+
+	STREAM_VERIFY_SANE(s);
+	assert(from <= to && to <= s->endp);
+
+	new = XMALLOC(MTYPE_STREAM, sizeof(struct stream));
+
+	new->getp = 0;
+	new->endp = new->size = to - from;
+	new->next = NULL;
+	/* slices of slices share the one backing stream */
+	new->parent = stream_ref(s->parent ? s->parent : s);
+	new->refcnt = 1;
+	new->flags = s->flags;
+	new->data = s->data + from;
+	return new;
 }
 
 struct stream *stream_copy(struct stream *new, struct stream *src)
@@ -128,6 +167,7 @@ struct stream *stream_copy(struct stream *new, struct stream *src)
 
 	new->endp = src->endp;
 	new->getp = src->getp;
+	new->flags = src->flags;
 
 	memcpy(new->data, src->data, src->endp);
 
@@ -171,8 +211,12 @@ size_t stream_resize_inplace(struct stream **sptr, size_t newsize)
 
 	STREAM_VERIFY_SANE(orig);
 
+	/* moving the buffer under a slice or co-owner would be fatal */
+	assert(orig->parent == NULL && orig->refcnt == 1);
+
 	orig = XREALLOC(MTYPE_STREAM, orig, sizeof(struct stream) + newsize);
 
+	orig->data = (unsigned char *)(orig + 1);
 	orig->size = newsize;
 
 	if (orig->endp > orig->size)
@@ -1222,6 +1266,43 @@ size_t stream_fifo_count_safe(struct stream_fifo *fifo)
 	return atomic_load_explicit(&fifo->count, memory_order_acquire);
 }
 
+/* gather at most this many streams into one writev() */
+#define STREAM_FIFO_WRITEV_IOVS 64
+
+ssize_t stream_fifo_writev(struct stream_fifo *fifo, int fd)
+{
+	struct iovec iov[STREAM_FIFO_WRITEV_IOVS];
+	struct stream *s;
+	ssize_t written;
+	size_t niov = 0, left;
+
+	for (s = fifo->head; s && niov < array_size(iov); s = s->next) {
+		iov[niov].iov_base = s->data + s->getp;
+		iov[niov].iov_len = STREAM_READABLE(s);
+		niov++;
+	}
+
+	if (niov == 0)
+		return 0;
+
+	written = writev(fd, iov, niov);
+	if (written < 0)
+		return written;
+
+	/* pop what went out in full, step the partial head forward */
+	left = written;
+	while ((s = stream_fifo_head(fifo)) != NULL) {
+		if (left < STREAM_READABLE(s)) {
+			stream_forward_getp(s, left);
+			break;
+		}
+		left -= STREAM_READABLE(s);
+		stream_free(stream_fifo_pop(fifo));
+	}
+
+	return written;
+}
+
 void stream_fifo_free(struct stream_fifo *fifo)
 {
 	stream_fifo_clean(fifo);
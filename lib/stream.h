@@ -107,10 +107,17 @@ struct stream {
 	 * direct access is frowned upon!
 	 * Use the appropriate functions/macros
 	 */
+	struct stream *parent; /* backing stream for slices, NULL else */
+	atomic_size_t refcnt;  /* lifetime references (stream_ref) */
 	size_t getp;	       /* next get position */
 	size_t endp;	       /* last valid data position */
 	size_t size;	       /* size of data segment */
-	unsigned char data[0]; /* data pointer */
+	uint8_t flags;	       /* not interpreted by the stream code; lets
+				  applications tag buffers in flight
+				  (e.g. producer-side validation state) */
+	unsigned char *data;   /* data; trails the struct for ordinary
+				  streams, points into the parent's buffer
+				  for slices */
 };
 
 /* First in first out queue structure. */
@@ -153,6 +160,24 @@ extern void stream_free(struct stream *);
 extern struct stream *stream_copy(struct stream *, struct stream *src);
 extern struct stream *stream_dup(struct stream *);
 
+/*
+ * Take an additional reference on a stream.  Each reference must be
+ * dropped with stream_free(); the buffer is only released with the last
+ * one.  A stream with more than one reference must be treated as
+ * read-only by all holders.
+ */
+extern struct stream *stream_ref(struct stream *s);
+
+/*
+ * Create a read-only view of bytes [from, to) of s, sharing the backing
+ * buffer instead of copying it.  The slice holds a reference on s and
+ * may outlive the caller's own; it has no write room and must not be
+ * written through.  Free with stream_free() as usual.  Because each
+ * slice is a distinct stream, the same message data can sit on several
+ * output fifos at once.
+ */
+extern struct stream *stream_slice(struct stream *s, size_t from, size_t to);
+
 #if CONFDATE > 20190821
 CPP_NOTICE("lib: time to remove stream_resize_orig")
 #endif
@@ -335,6 +360,26 @@ extern void stream_fifo_clean_safe(struct stream_fifo *fifo);
  */
 extern size_t stream_fifo_count_safe(struct stream_fifo *fifo);
 
+/*
+ * Write as much of the fifo to a file descriptor as one writev() will
+ * take, directly from the queued streams' buffers - no intermediate
+ * copy.  Fully written streams are popped and freed; a partially
+ * written head has its getp advanced so the next call resumes there.
+ *
+ * This is an unsafe (unlocked) operation; like stream_fifo_pop, the
+ * caller must own the fifo or hold its lock.
+ *
+ * fifo
+ *    the stream_fifo to write from
+ *
+ * fd
+ *    file descriptor to write to
+ *
+ * Returns:
+ *    number of bytes written, or -1 with errno set (fifo unchanged)
+ */
+extern ssize_t stream_fifo_writev(struct stream_fifo *fifo, int fd);
+
 /*
  * Free a stream_fifo.
  *
@@ -30,6 +30,7 @@
 
 DEFINE_MTYPE(LIB, ROUTE_TABLE, "Route table")
 DEFINE_MTYPE(LIB, ROUTE_NODE, "Route node")
+DEFINE_MTYPE_STATIC(LIB, ROUTE_DINDEX, "Route table direct index")
 
 static void route_table_free(struct route_table *);
 
@@ -99,9 +100,21 @@ static void route_table_free(struct route_table *rt)
 	if (rt == NULL)
 		return;
 
+	/* Nobody may be reading a table that is being torn down; release
+	 * any nodes whose destruction was deferred on behalf of readers.
+	 */
+	assert(rt->epoch_readers == 0);
+	while (rt->deferred_free) {
+		tmp_node = rt->deferred_free;
+		rt->deferred_free = tmp_node->parent;
+		route_node_free(rt, tmp_node);
+	}
+
 	hash_clean(rt->hash, NULL);
 	hash_free(rt->hash);
 
+	XFREE(MTYPE_ROUTE_DINDEX, rt->dindex);
+
 	node = rt->top;
 
 	/* Bulk deletion of nodes remaining in this table.  This function is not
@@ -191,14 +204,179 @@ static void set_link(struct route_node *node, struct route_node *new)
 	new->parent = node;
 }
 
+/* Direct index ------------------------------------------------------------- */
+
+/* Like the exact-match hash above, this is an auxiliary structure kept
+ * in parallel with the radix tree, here to compress the bit-by-bit
+ * descent of route_node_match() for IPv4.  One array slot per /16 block
+ * replaces the top 16 levels of the walk with a single indexed load:
+ *
+ * - sub[]:   the topmost node with prefixlen >= 16 inside the block.
+ *            Any two such nodes share at least their first 16 bits, so
+ *            their common radix ancestor is also inside the block -
+ *            all of them form a single subtree, and a match can start
+ *            its descent at its root.
+ * - cover[]: the deepest node with prefixlen < 16 whose prefix contains
+ *            the block (always an ancestor of sub[], when both exist).
+ *            If the subtree yields no match, the longest shorter match
+ *            is found by walking this node's parent chain.
+ *
+ * Updates are O(1) for prefixes of /16 and longer; a shorter prefix
+ * touches one slot per /16 block it spans (2^(16-len), i.e. a default
+ * route rewrites all 65536 once).  Fine for the intended users - tables
+ * that resolve nexthops - which see few short prefixes and are lookup
+ * dominated.
+ */
+
+#define DINDEX_BLOCKS (1 << 16)
+
+struct route_dindex {
+	struct route_node *sub[DINDEX_BLOCKS];
+	struct route_node *cover[DINDEX_BLOCKS];
+};
+
+/* the /16 block a v4 prefix starts in */
+static inline uint32_t dindex_block(const struct prefix *p)
+{
+	return ntohl(p->u.prefix4.s_addr) >> 16;
+}
+
+static void route_dindex_insert(struct route_table *table,
+				struct route_node *node)
+{
+	struct route_dindex *di = table->dindex;
+	uint32_t block, span;
+
+	if (!di || node->p.family != AF_INET)
+		return;
+
+	block = dindex_block(&node->p);
+
+	if (node->p.prefixlen >= 16) {
+		/* a shorter prefix roots the block's subtree; internal
+		 * (glue) nodes count, they are on the descent path */
+		if (!di->sub[block]
+		    || node->p.prefixlen < di->sub[block]->p.prefixlen)
+			di->sub[block] = node;
+		return;
+	}
+
+	span = 1u << (16 - node->p.prefixlen);
+	for (uint32_t i = block; i < block + span; i++)
+		if (!di->cover[i]
+		    || node->p.prefixlen > di->cover[i]->p.prefixlen)
+			di->cover[i] = node;
+}
+
+/* "child" is the at most one child the deleted node is replaced by */
+static void route_dindex_remove(struct route_table *table,
+				struct route_node *node,
+				struct route_node *child)
+{
+	struct route_dindex *di = table->dindex;
+	uint32_t block, span;
+
+	if (!di || node->p.family != AF_INET)
+		return;
+
+	block = dindex_block(&node->p);
+
+	if (node->p.prefixlen >= 16) {
+		/* all other >= /16 nodes of the block sit below the
+		 * single child, which becomes the new subtree root */
+		if (di->sub[block] == node)
+			di->sub[block] = child;
+		return;
+	}
+
+	/* the next shorter cover is the parent: anything deeper that
+	 * still contained the block would already own the slot */
+	span = 1u << (16 - node->p.prefixlen);
+	for (uint32_t i = block; i < block + span; i++)
+		if (di->cover[i] == node)
+			di->cover[i] = node->parent;
+}
+
+/* route_node_match(), direct-indexed flavor */
+static struct route_node *route_dindex_match(const struct route_table *table,
+					     const struct prefix *p)
+{
+	const struct route_dindex *di = table->dindex;
+	uint32_t block = dindex_block(p);
+	struct route_node *node = di->sub[block];
+	struct route_node *matched = NULL;
+
+	/* all candidates of /16 and longer live in the block's subtree;
+	 * same descent as route_node_match(), minus the top 16 levels */
+	while (node && node->p.prefixlen <= p->prefixlen
+	       && prefix_match(&node->p, p)) {
+		if (node->info)
+			matched = node;
+
+		if (node->p.prefixlen == p->prefixlen)
+			break;
+
+		node = node->link[prefix_bit(&p->u.prefix, node->p.prefixlen)];
+	}
+
+	if (matched)
+		return matched;
+
+	/* no match there: the shorter covering prefixes are the parent
+	 * chain above the subtree, deepest first */
+	node = di->sub[block] ? di->sub[block]->parent : di->cover[block];
+	for (; node; node = node->parent)
+		if (node->info)
+			return node;
+
+	return NULL;
+}
+
+void route_table_use_dindex(struct route_table *table)
+{
+	struct route_node *node;
+
+	if (table->dindex)
+		return;
+
+	table->dindex = XCALLOC(MTYPE_ROUTE_DINDEX,
+				sizeof(struct route_dindex));
+
+	/* index whatever the table already holds */
+	node = table->top;
+	while (node) {
+		route_dindex_insert(table, node);
+
+		if (node->l_left) {
+			node = node->l_left;
+			continue;
+		}
+		if (node->l_right) {
+			node = node->l_right;
+			continue;
+		}
+		while (node) {
+			if (node->parent && node->parent->l_left == node
+			    && node->parent->l_right) {
+				node = node->parent->l_right;
+				break;
+			}
+			node = node->parent;
+		}
+	}
+}
+
 /* Find matched prefix. */
-struct route_node *route_node_match(const struct route_table *table,
-				    union prefixconstptr pu)
+struct route_node *route_node_match_nolock(const struct route_table *table,
+					   union prefixconstptr pu)
 {
 	const struct prefix *p = pu.p;
 	struct route_node *node;
 	struct route_node *matched;
 
+	if (table->dindex && p->family == AF_INET && p->prefixlen >= 16)
+		return route_dindex_match(table, p);
+
 	matched = NULL;
 	node = table->top;
 
@@ -215,6 +393,16 @@ struct route_node *route_node_match(const struct route_table *table,
 		node = node->link[prefix_bit(&p->u.prefix, node->p.prefixlen)];
 	}
 
+	return matched;
+}
+
+struct route_node *route_node_match(const struct route_table *table,
+				    union prefixconstptr pu)
+{
+	struct route_node *matched;
+
+	matched = route_node_match_nolock(table, pu);
+
 	/* If matched route found, return it. */
 	if (matched)
 		return route_lock_node(matched);
@@ -308,6 +496,7 @@ struct route_node *route_node_get(struct route_table *const table,
 			set_link(match, new);
 		else
 			table->top = new;
+		route_dindex_insert(table, new);
 	} else {
 		new = route_node_new(table);
 		route_common(&node->p, p, &new->p);
@@ -321,20 +510,57 @@ struct route_node *route_node_get(struct route_table *const table,
 			set_link(match, new);
 		else
 			table->top = new;
+		route_dindex_insert(table, new);
 
 		if (new->p.prefixlen != p->prefixlen) {
 			match = new;
 			new = route_node_set(table, p);
 			set_link(match, new);
 			table->count++;
+			route_dindex_insert(table, new);
 		}
 	}
 	table->count++;
+	table->version++;
 	route_lock_node(new);
 
 	return new;
 }
 
+/*
+ * route_table_epoch_enter
+ *
+ * Open a read-side critical section on the table.  While at least one
+ * reader is inside an epoch, nodes removed from the table are unlinked
+ * but their destruction is deferred, so an iteration that is already
+ * under way never touches freed memory.  Must be balanced by a call to
+ * route_table_epoch_exit().
+ */
+void route_table_epoch_enter(struct route_table *table)
+{
+	table->epoch_readers++;
+}
+
+/*
+ * route_table_epoch_exit
+ *
+ * Close a read-side critical section.  When the last reader leaves,
+ * nodes whose destruction was deferred are released.
+ */
+void route_table_epoch_exit(struct route_table *table)
+{
+	struct route_node *node;
+
+	assert(table->epoch_readers > 0);
+	if (--table->epoch_readers > 0)
+		return;
+
+	while ((node = table->deferred_free) != NULL) {
+		table->deferred_free = node->parent;
+		route_node_free(table, node);
+	}
+}
+
 /* Delete node from the routing table. */
 void route_node_delete(struct route_node *node)
 {
@@ -352,6 +578,8 @@ void route_node_delete(struct route_node *node)
 	else
 		child = node->l_right;
 
+	route_dindex_remove(node->table, node, child);
+
 	parent = node->parent;
 
 	if (child)
@@ -366,6 +594,7 @@ void route_node_delete(struct route_node *node)
 		node->table->top = child;
 
 	node->table->count--;
+	node->table->version++;
 
 	hash_release(node->table->hash, node);
 
@@ -379,7 +608,19 @@ void route_node_delete(struct route_node *node)
 	 *
 	 * cf. srcdest_srcnode_destroy() in zebra/zebra_rib.c */
 
-	route_node_free(node->table, node);
+	if (node->table->epoch_readers) {
+		/* A reader holds this table in an epoch; the node is off
+		 * the trie and the hash, but destroying it now could pull
+		 * memory out from under an iteration in progress.  Park it
+		 * on the deferred list instead - since the node is
+		 * unlinked, its parent pointer is free to chain the list.
+		 * Downward links are left intact so a reader standing on
+		 * the node can still reach its (re-parented, live) child.
+		 */
+		node->parent = node->table->deferred_free;
+		node->table->deferred_free = node;
+	} else
+		route_node_free(node->table, node);
 
 	/* If parent node is stub then delete it also. */
 	if (parent && parent->lock == 0)
@@ -38,6 +38,7 @@ DECLARE_MTYPE(ROUTE_NODE)
  */
 struct route_node;
 struct route_table;
+struct route_dindex;
 
 /*
  * route_table_delegate_t
@@ -64,6 +65,13 @@ struct route_table {
 	struct route_node *top;
 	struct hash *hash;
 
+	/*
+	 * Optional stride-16 direct index over the radix tree, for tables
+	 * whose load is dominated by IPv4 longest-prefix-match lookups.
+	 * See route_table_use_dindex().
+	 */
+	struct route_dindex *dindex;
+
 	/*
 	 * Delegate that performs certain functions for this table.
 	 */
@@ -72,6 +80,22 @@ struct route_table {
 
 	unsigned long count;
 
+	/*
+	 * Epoch-based read protection. While one or more readers hold
+	 * the table in an epoch, deleted nodes are unlinked from the
+	 * trie as usual but their destruction is deferred until the
+	 * last reader leaves, so a walk in progress never touches freed
+	 * memory even if route processing runs concurrently.
+	 */
+	unsigned int epoch_readers;
+	struct route_node *deferred_free;
+
+	/*
+	 * Incremented on every structural change; lets readers detect
+	 * that the table changed underneath a paused walk.
+	 */
+	uint64_t version;
+
 	/*
 	 * User data.
 	 */
@@ -184,6 +208,15 @@ route_table_init_with_delegate(route_table_delegate_t *delegate);
 
 extern route_table_delegate_t *route_table_get_default_delegate(void);
 
+/* Attach a stride-16 direct index to the table, trading ~1MB of memory
+ * for near-constant-time IPv4 route_node_match().  Worth it only for
+ * tables that are looked up far more often than they are walked or
+ * modified (nexthop resolution); no effect on IPv6 lookups, which keep
+ * the plain radix walk.  The index is maintained incrementally from
+ * here on and dropped with the table.
+ */
+extern void route_table_use_dindex(struct route_table *table);
+
 static inline void *route_table_get_info(struct route_table *table)
 {
 	return table->info;
@@ -208,6 +241,14 @@ route_node_lookup_maynull(const struct route_table *table,
 			  union prefixconstptr pu);
 extern struct route_node *route_node_match(const struct route_table *table,
 					   union prefixconstptr pu);
+/* As route_node_match(), but no reference is taken on the result.  Only
+ * for callers that compare or inspect the node without keeping it, on
+ * tables that cannot change underneath them; unlike route_node_match()
+ * this mutates nothing and so is safe concurrently from several threads.
+ */
+extern struct route_node *
+route_node_match_nolock(const struct route_table *table,
+			union prefixconstptr pu);
 extern struct route_node *route_node_match_ipv4(const struct route_table *table,
 						const struct in_addr *addr);
 extern struct route_node *route_node_match_ipv6(const struct route_table *table,
@@ -230,6 +271,12 @@ extern int route_table_prefix_iter_cmp(const struct prefix *p1,
 /*
  * Iterator functions.
  */
+/*
+ * Epoch (read-side critical section) functions.
+ */
+extern void route_table_epoch_enter(struct route_table *table);
+extern void route_table_epoch_exit(struct route_table *table);
+
 extern void route_table_iter_init(route_table_iter_t *iter,
 				  struct route_table *table);
 extern void route_table_iter_pause(route_table_iter_t *iter);
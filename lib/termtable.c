@@ -89,11 +89,54 @@ struct ttable_style ttable_styles[] = {
 };
 /* clang-format on */
 
+/*
+ * Cell text is bump-allocated out of arena blocks owned by the table,
+ * so a large table costs one allocation per ~4K of text instead of one
+ * strdup per cell; everything is released at once by ttable_del().
+ */
+#define TTABLE_ARENA_BLOCK 4096
+
+struct ttable_arena {
+	struct ttable_arena *next;
+	size_t used;
+	size_t size;
+	char data[];
+};
+
+static char *ttable_arena_strdup(struct ttable *tt, const char *text,
+				 size_t len)
+{
+	struct ttable_arena *a = tt->arena;
+	char *p;
+
+	if (!a || a->size - a->used < len + 1) {
+		size_t bsz = MAX((size_t)TTABLE_ARENA_BLOCK, len + 1);
+
+		a = XMALLOC(MTYPE_TTABLE, sizeof(*a) + bsz);
+		a->next = tt->arena;
+		a->used = 0;
+		a->size = bsz;
+		tt->arena = a;
+	}
+	p = a->data + a->used;
+	memcpy(p, text, len + 1);
+	a->used += len + 1;
+
+	return p;
+}
+
 void ttable_del(struct ttable *tt)
 {
+	struct ttable_arena *a, *next;
+
 	for (int i = tt->nrows - 1; i >= 0; i--)
 		ttable_del_row(tt, i);
 
+	for (a = tt->arena; a; a = next) {
+		next = a->next;
+		XFREE(MTYPE_TTABLE, a);
+	}
+
 	XFREE(MTYPE_TTABLE, tt->table);
 	XFREE(MTYPE_TTABLE, tt);
 }
@@ -165,7 +208,9 @@ static struct ttable_cell *ttable_insert_row_va(struct ttable *tt, int i,
 
 	while (res && col < tt->ncols) {
 		section = strsep(&res, "|");
-		row[col].text = XSTRDUP(MTYPE_TTABLE, section);
+		row[col].width = strlen(section);
+		row[col].text =
+			ttable_arena_strdup(tt, section, row[col].width);
 		row[col].style = tt->style.cell;
 		col++;
 	}
@@ -215,9 +260,7 @@ void ttable_del_row(struct ttable *tt, unsigned int i)
 {
 	assert((int)i < tt->nrows);
 
-	for (int j = 0; j < tt->ncols; j++)
-		XFREE(MTYPE_TTABLE, tt->table[i][j].text);
-
+	/* cell text lives in the arena and is freed with the table */
 	XFREE(MTYPE_TTABLE, tt->table[i]);
 
 	memmove(&tt->table[i], &tt->table[i + 1],
@@ -319,14 +362,16 @@ char *ttable_dump(struct ttable *tt, const char *newline)
 
 	nl_len = strlen(newline);
 
-	/* calculate width of each column */
+	/* calculate width of each column; text widths were cached at
+	 * insertion, so this is one pass over the cells without any
+	 * rescanning of the strings */
 	memset(cw, 0x00, sizeof(int) * tt->ncols);
 
 	for (int j = 0; j < tt->ncols; j++)
 		for (int i = 0, cellw = 0; i < tt->nrows; i++) {
 			cell = &tt->table[i][j];
 			cellw = 0;
-			cellw += (int)strlen(cell->text);
+			cellw += cell->width;
 			cellw += cell->style.lpad;
 			cellw += cell->style.rpad;
 			if (j != 0)
@@ -433,14 +478,20 @@ char *ttable_dump(struct ttable *tt, const char *newline)
 			if (j != tt->ncols - 1)
 				abspad -= row[j].style.border.right_on ? 1 : 0;
 
-			/* print text */
-			const char *fmt;
-			if (row[j].style.align == LEFT)
-				fmt = "%-*s";
-			else
-				fmt = "%*s";
-
-			pos += sprintf(&buf[pos], fmt, abspad, row[j].text);
+			/* print text; emitted with memcpy + space fill
+			 * rather than sprintf("%*s"), which would scan
+			 * the string again */
+			if (row[j].style.align == LEFT) {
+				memcpy(&buf[pos], row[j].text, row[j].width);
+				memset(&buf[pos + row[j].width], ' ',
+				       abspad - row[j].width);
+			} else {
+				memset(&buf[pos], ' ',
+				       abspad - row[j].width);
+				memcpy(&buf[pos + abspad - row[j].width],
+				       row[j].text, row[j].width);
+			}
+			pos += abspad;
 
 			/* print right padding */
 			for (int k = 0; k < row[j].style.rpad; k++)
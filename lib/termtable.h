@@ -54,7 +54,8 @@ struct ttable_cellstyle {
 };
 
 struct ttable_cell {
-	char *text;
+	char *text; /* owned by the table's arena */
+	int width;  /* cached strlen(text) */
 	struct ttable_cellstyle style;
 };
 
@@ -74,6 +75,7 @@ struct ttable {
 	struct ttable_cell **table; /* table, row x col */
 	size_t size;		    /* size */
 	struct ttable_style style;  /* style */
+	struct ttable_arena *arena; /* bump allocator for cell text */
 };
 
 /* some predefined styles */
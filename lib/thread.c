@@ -22,6 +22,9 @@
 
 #include <zebra.h>
 #include <sys/resource.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
 
 #include "thread.h"
 #include "memory.h"
@@ -39,6 +42,7 @@ DEFINE_MTYPE_STATIC(LIB, THREAD, "Thread")
 DEFINE_MTYPE_STATIC(LIB, THREAD_MASTER, "Thread master")
 DEFINE_MTYPE_STATIC(LIB, THREAD_POLL, "Thread Poll Info")
 DEFINE_MTYPE_STATIC(LIB, THREAD_STATS, "Thread stats")
+DEFINE_MTYPE_STATIC(LIB, THREAD_TRACE, "Thread trace records")
 
 #if defined(__APPLE__)
 #include <mach/mach.h>
@@ -58,7 +62,15 @@ pthread_key_t thread_current;
 pthread_mutex_t masters_mtx = PTHREAD_MUTEX_INITIALIZER;
 static struct list *masters;
 
+/* Default ring size for "thread trace"; also applied to masters created
+ * after tracing was turned on. */
+#define THREAD_TRACE_SIZE_DFLT 65536
+static bool thread_trace_deflt_on;
+static uint32_t thread_trace_deflt_size = THREAD_TRACE_SIZE_DFLT;
+
 static void thread_free(struct thread_master *master, struct thread *thread);
+static void thread_mpsc_create(struct thread_master *m);
+static void thread_mpsc_free(struct thread_master *m);
 
 /* CLI start ---------------------------------------------------------------- */
 static unsigned int cpu_record_hash_key(struct cpu_thread_history *a)
@@ -367,11 +379,454 @@ DEFUN (clear_thread_cpu,
 	return CMD_SUCCESS;
 }
 
+/* Enable (or resize and restart) the trace ring of one master.  The
+ * caller must hold m->mtx, unless the master is not yet shared. */
+static void thread_trace_start(struct thread_master *m, uint32_t size)
+{
+	if (!m->trace)
+		m->trace = XCALLOC(MTYPE_THREAD_TRACE, sizeof(*m->trace));
+
+	if (m->trace->size != size) {
+		XFREE(MTYPE_THREAD_TRACE, m->trace->ents);
+		m->trace->ents =
+			XCALLOC(MTYPE_THREAD_TRACE,
+				sizeof(struct thread_trace_entry) * size);
+		m->trace->size = size;
+	}
+
+	m->trace->next = 0;
+	m->trace->total = 0;
+	m->trace->on = true;
+}
+
+/* Letter for a trace entry's add_type, same alphabet as the 'show
+ * thread cpu' filter. */
+static char thread_trace_type_char(uint8_t type)
+{
+	switch (type) {
+	case THREAD_READ:
+		return 'R';
+	case THREAD_WRITE:
+		return 'W';
+	case THREAD_TIMER:
+		return 'T';
+	case THREAD_EVENT:
+		return 'E';
+	case THREAD_EXECUTE:
+		return 'X';
+	default:
+		return '?';
+	}
+}
+
+static void show_thread_trace_helper(struct vty *vty, struct thread_master *m)
+{
+	const char *name = m->name ? m->name : "main";
+	struct thread_trace *tr = m->trace;
+	uint32_t count, pos, i;
+
+	vty_out(vty, "\nEvent trace for pthread %s: ", name);
+	if (!tr) {
+		vty_out(vty, "not enabled\n");
+		return;
+	}
+
+	count = (tr->total < tr->size) ? (uint32_t)tr->total : tr->size;
+	vty_out(vty, "%s, %lu recorded, showing last %u\n",
+		tr->on ? "running" : "stopped", tr->total, count);
+	if (!count)
+		return;
+
+	vty_out(vty, "%16s Type %9s %9s %9s  Thread\n", "Start(monotime)",
+		"Queue uS", "Real uS", "CPU uS");
+
+	pos = (tr->total < tr->size) ? 0 : tr->next;
+	for (i = 0; i < count; i++) {
+		struct thread_trace_entry *e =
+			&tr->ents[(pos + i) % tr->size];
+
+		vty_out(vty, "%9lld.%06ld    %c %9lu %9lu %9lu  %s\n",
+			(long long)e->start.tv_sec, (long)e->start.tv_usec,
+			thread_trace_type_char(e->type), e->queue_us,
+			e->real_us, e->cpu_us, e->funcname);
+	}
+}
+
+/*
+ * Folded-stack dump: one "<pthread>;<handler> <total real uS>" line per
+ * handler, directly consumable by flamegraph.pl (--countname us).
+ */
+static void show_thread_trace_folded_helper(struct vty *vty,
+					    struct thread_master *m)
+{
+	const char *name = m->name ? m->name : "main";
+	struct thread_trace *tr = m->trace;
+	struct trace_fold {
+		const char *funcname;
+		unsigned long real_us;
+	} *folds;
+	uint32_t count, pos, nfolds = 0, alloced = 64;
+	uint32_t i, j;
+
+	if (!tr)
+		return;
+
+	count = (tr->total < tr->size) ? (uint32_t)tr->total : tr->size;
+	if (!count)
+		return;
+
+	folds = XCALLOC(MTYPE_THREAD_TRACE, sizeof(*folds) * alloced);
+
+	pos = (tr->total < tr->size) ? 0 : tr->next;
+	for (i = 0; i < count; i++) {
+		struct thread_trace_entry *e =
+			&tr->ents[(pos + i) % tr->size];
+
+		for (j = 0; j < nfolds; j++)
+			if (folds[j].funcname == e->funcname
+			    || !strcmp(folds[j].funcname, e->funcname))
+				break;
+
+		if (j == nfolds) {
+			if (nfolds == alloced) {
+				alloced *= 2;
+				folds = XREALLOC(MTYPE_THREAD_TRACE, folds,
+						 sizeof(*folds) * alloced);
+			}
+			folds[j].funcname = e->funcname;
+			folds[j].real_us = 0;
+			nfolds++;
+		}
+		folds[j].real_us += e->real_us;
+	}
+
+	for (j = 0; j < nfolds; j++)
+		vty_out(vty, "%s;%s %lu\n", name, folds[j].funcname,
+			folds[j].real_us);
+
+	XFREE(MTYPE_THREAD_TRACE, folds);
+}
+
+/*
+ * Event-loop latency watchdog.
+ *
+ * With a budget configured, every handler invocation arms a per-pthread
+ * timer before dispatch.  A handler that overruns its budget gets the
+ * timer signal delivered to the stalled pthread itself, and a backtrace
+ * is written to the log from the signal handler - re-sampled at every
+ * budget interval until the handler returns - so the offending call
+ * chain is visible while it is still on-CPU.  "show thread cpu" totals
+ * can only show the damage afterwards.  The completion path in
+ * thread_call() logs the offender by name and feeds the per-pthread
+ * max-latency gauge reported by "show thread latency".
+ */
+static _Atomic unsigned long thread_watchdog_budget; /* usec, 0 = off */
+static _Atomic unsigned long thread_watchdog_samples;
+
+#if defined(GNU_LINUX) && defined(SIGEV_THREAD_ID)
+
+#include <sys/syscall.h>
+
+#define THREAD_WATCHDOG_SIG SIGURG
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+static void thread_watchdog_handler(int signo)
+{
+	struct thread *thread = pthread_getspecific(thread_current);
+
+	atomic_fetch_add_explicit(&thread_watchdog_samples, 1,
+				  memory_order_relaxed);
+	zlog_backtrace_sigsafe(LOG_WARNING,
+			       thread ? (void *)thread->func : NULL);
+}
+
+static void thread_watchdog_arm(struct thread_master *m, unsigned long budget)
+{
+	struct itimerspec its;
+	static __thread pid_t my_tid;
+
+	if (!my_tid)
+		my_tid = syscall(__NR_gettid);
+
+	/* master driven by a different pthread than last time */
+	if (m->watchdog_created && m->watchdog_tid != my_tid) {
+		timer_delete(m->watchdog_timer);
+		m->watchdog_created = false;
+	}
+
+	if (!m->watchdog_created) {
+		struct sigevent sev;
+		struct sigaction sa;
+		sigset_t unblock;
+
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_handler = thread_watchdog_handler;
+		sigaction(THREAD_WATCHDOG_SIG, &sa, NULL);
+
+		/* worker pthreads run with signals blocked */
+		sigemptyset(&unblock);
+		sigaddset(&unblock, THREAD_WATCHDOG_SIG);
+		pthread_sigmask(SIG_UNBLOCK, &unblock, NULL);
+
+		memset(&sev, 0, sizeof(sev));
+		sev.sigev_notify = SIGEV_THREAD_ID;
+		sev.sigev_signo = THREAD_WATCHDOG_SIG;
+		sev.sigev_notify_thread_id = my_tid;
+		if (timer_create(CLOCK_MONOTONIC, &sev, &m->watchdog_timer))
+			return;
+
+		m->watchdog_created = true;
+		m->watchdog_tid = my_tid;
+	}
+
+	its.it_value.tv_sec = budget / 1000000;
+	its.it_value.tv_nsec = (budget % 1000000) * 1000;
+	/* keep sampling for as long as the handler stays on-CPU */
+	its.it_interval = its.it_value;
+	timer_settime(m->watchdog_timer, 0, &its, NULL);
+}
+
+static void thread_watchdog_disarm(struct thread_master *m)
+{
+	struct itimerspec its;
+
+	if (!m->watchdog_created)
+		return;
+
+	memset(&its, 0, sizeof(its));
+	timer_settime(m->watchdog_timer, 0, &its, NULL);
+}
+
+#else /* !GNU_LINUX || !SIGEV_THREAD_ID */
+
+/* no per-pthread timer signals; the budget overrun is still logged from
+ * thread_call(), just without the in-flight stack capture */
+static void thread_watchdog_arm(struct thread_master *m, unsigned long budget)
+{
+}
+
+static void thread_watchdog_disarm(struct thread_master *m)
+{
+}
+
+#endif
+
+DEFUN (thread_watchdog,
+       thread_watchdog_cmd,
+       "thread watchdog (10-60000)",
+       "Thread information\n"
+       "Enable the event-loop latency watchdog\n"
+       "Per-handler wall-time budget, in milliseconds\n")
+{
+	atomic_store_explicit(&thread_watchdog_budget,
+			      strtoul(argv[2]->arg, NULL, 10) * 1000,
+			      memory_order_relaxed);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_thread_watchdog,
+       no_thread_watchdog_cmd,
+       "no thread watchdog [(10-60000)]",
+       NO_STR
+       "Thread information\n"
+       "Enable the event-loop latency watchdog\n"
+       "Per-handler wall-time budget, in milliseconds\n")
+{
+	atomic_store_explicit(&thread_watchdog_budget, 0,
+			      memory_order_relaxed);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (show_thread_latency,
+       show_thread_latency_cmd,
+       "show thread latency",
+       SHOW_STR
+       "Thread information\n"
+       "Max handler latency per pthread\n")
+{
+	unsigned long budget, max;
+	struct thread_master *m;
+	struct listnode *ln;
+
+	budget = atomic_load_explicit(&thread_watchdog_budget,
+				      memory_order_relaxed);
+	if (budget)
+		vty_out(vty, "Watchdog budget %lu ms, %lu stack samples\n",
+			budget / 1000,
+			atomic_load_explicit(&thread_watchdog_samples,
+					     memory_order_relaxed));
+	else
+		vty_out(vty, "Watchdog disabled\n");
+
+	vty_out(vty, "%30s %18s\n", "Pthread", "Max latency (ms)");
+	pthread_mutex_lock(&masters_mtx);
+	{
+		for (ALL_LIST_ELEMENTS_RO(masters, ln, m)) {
+			max = atomic_load_explicit(&m->latency_max,
+						   memory_order_relaxed);
+			vty_out(vty, "%30s %14lu.%03lu\n",
+				m->name ? m->name : "main", max / 1000,
+				max % 1000);
+		}
+	}
+	pthread_mutex_unlock(&masters_mtx);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (clear_thread_latency,
+       clear_thread_latency_cmd,
+       "clear thread latency",
+       "Clear stored data in all pthreads\n"
+       "Thread information\n"
+       "Max handler latency per pthread\n")
+{
+	struct thread_master *m;
+	struct listnode *ln;
+
+	pthread_mutex_lock(&masters_mtx);
+	{
+		for (ALL_LIST_ELEMENTS_RO(masters, ln, m))
+			atomic_store_explicit(&m->latency_max, 0,
+					      memory_order_relaxed);
+	}
+	pthread_mutex_unlock(&masters_mtx);
+	atomic_store_explicit(&thread_watchdog_samples, 0,
+			      memory_order_relaxed);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (thread_trace,
+       thread_trace_cmd,
+       "thread trace [(1024-1048576)]",
+       "Thread information\n"
+       "Record a per-event trace into a ring buffer\n"
+       "Ring buffer size, in events\n")
+{
+	uint32_t size = THREAD_TRACE_SIZE_DFLT;
+	struct thread_master *m;
+	struct listnode *ln;
+	int idx = 0;
+
+	if (argv_find(argv, argc, "(1024-1048576)", &idx))
+		size = strtoul(argv[idx]->arg, NULL, 10);
+
+	pthread_mutex_lock(&masters_mtx);
+	{
+		thread_trace_deflt_on = true;
+		thread_trace_deflt_size = size;
+
+		for (ALL_LIST_ELEMENTS_RO(masters, ln, m)) {
+			pthread_mutex_lock(&m->mtx);
+			thread_trace_start(m, size);
+			pthread_mutex_unlock(&m->mtx);
+		}
+	}
+	pthread_mutex_unlock(&masters_mtx);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_thread_trace,
+       no_thread_trace_cmd,
+       "no thread trace",
+       NO_STR
+       "Thread information\n"
+       "Record a per-event trace into a ring buffer\n")
+{
+	struct thread_master *m;
+	struct listnode *ln;
+
+	pthread_mutex_lock(&masters_mtx);
+	{
+		thread_trace_deflt_on = false;
+
+		/* Stop recording but keep the rings for inspection. */
+		for (ALL_LIST_ELEMENTS_RO(masters, ln, m)) {
+			pthread_mutex_lock(&m->mtx);
+			if (m->trace)
+				m->trace->on = false;
+			pthread_mutex_unlock(&m->mtx);
+		}
+	}
+	pthread_mutex_unlock(&masters_mtx);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (show_thread_trace,
+       show_thread_trace_cmd,
+       "show thread trace [folded]",
+       SHOW_STR
+       "Thread information\n"
+       "Recorded per-event trace\n"
+       "Folded-stack format for flamegraph tooling\n")
+{
+	bool folded = argc > 3;
+	struct thread_master *m;
+	struct listnode *ln;
+
+	pthread_mutex_lock(&masters_mtx);
+	{
+		for (ALL_LIST_ELEMENTS_RO(masters, ln, m)) {
+			pthread_mutex_lock(&m->mtx);
+			if (folded)
+				show_thread_trace_folded_helper(vty, m);
+			else
+				show_thread_trace_helper(vty, m);
+			pthread_mutex_unlock(&m->mtx);
+		}
+	}
+	pthread_mutex_unlock(&masters_mtx);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (clear_thread_trace,
+       clear_thread_trace_cmd,
+       "clear thread trace",
+       "Clear stored data in all pthreads\n"
+       "Thread information\n"
+       "Recorded per-event trace\n")
+{
+	struct thread_master *m;
+	struct listnode *ln;
+
+	pthread_mutex_lock(&masters_mtx);
+	{
+		for (ALL_LIST_ELEMENTS_RO(masters, ln, m)) {
+			pthread_mutex_lock(&m->mtx);
+			if (m->trace) {
+				m->trace->next = 0;
+				m->trace->total = 0;
+			}
+			pthread_mutex_unlock(&m->mtx);
+		}
+	}
+	pthread_mutex_unlock(&masters_mtx);
+
+	return CMD_SUCCESS;
+}
+
 void thread_cmd_init(void)
 {
 	install_element(VIEW_NODE, &show_thread_cpu_cmd);
 	install_element(VIEW_NODE, &show_thread_poll_cmd);
+	install_element(VIEW_NODE, &show_thread_trace_cmd);
 	install_element(ENABLE_NODE, &clear_thread_cpu_cmd);
+	install_element(ENABLE_NODE, &thread_trace_cmd);
+	install_element(ENABLE_NODE, &no_thread_trace_cmd);
+	install_element(ENABLE_NODE, &clear_thread_trace_cmd);
+	install_element(VIEW_NODE, &show_thread_latency_cmd);
+	install_element(ENABLE_NODE, &thread_watchdog_cmd);
+	install_element(ENABLE_NODE, &no_thread_watchdog_cmd);
+	install_element(ENABLE_NODE, &clear_thread_latency_cmd);
 }
 /* CLI end ------------------------------------------------------------------ */
 
@@ -457,6 +912,9 @@ struct thread_master *thread_master_create(const char *name)
 	set_nonblocking(rv->io_pipe[0]);
 	set_nonblocking(rv->io_pipe[1]);
 
+	/* Initialize cross-thread event ring */
+	thread_mpsc_create(rv);
+
 	/* Initialize data structures for poll() */
 	rv->handler.pfdsize = rv->fd_limit;
 	rv->handler.pfdcount = 0;
@@ -464,6 +922,17 @@ struct thread_master *thread_master_create(const char *name)
 				   sizeof(struct pollfd) * rv->handler.pfdsize);
 	rv->handler.copy = XCALLOC(MTYPE_THREAD_MASTER,
 				   sizeof(struct pollfd) * rv->handler.pfdsize);
+	rv->handler.fd_index = XMALLOC(MTYPE_THREAD_MASTER,
+				       sizeof(int) * rv->handler.pfdsize);
+	for (nfds_t i = 0; i < rv->handler.pfdsize; i++)
+		rv->handler.fd_index[i] = -1;
+#ifdef HAVE_SYS_EPOLL_H
+	rv->handler.epoll_fd = -1;
+#endif
+
+	/* Inherit tracing toggled on before this master existed */
+	if (thread_trace_deflt_on)
+		thread_trace_start(rv, thread_trace_deflt_size);
 
 	/* add to list of threadmasters */
 	pthread_mutex_lock(&masters_mtx);
@@ -532,6 +1001,153 @@ static struct thread *thread_trim_head(struct thread_list *list)
 	return NULL;
 }
 
+/* Hierarchical timing wheel -------------------------------------------- */
+
+/* Alternative backend for the timer queue.  The default binary heap costs
+ * O(log n) per insert/cancel, which shows up in profiles once a daemon
+ * keeps tens of thousands of timers alive (BGP FSM, PIM joins).  The wheel
+ * makes both O(1) at the cost of millisecond scheduling granularity;
+ * daemons opt in with thread_master_use_timer_wheel() right after
+ * creating their master.  (lib/wheel.c is unrelated: it is an
+ * application-level single-resolution wheel driven by a regular timer,
+ * not a scheduler backend.)
+ *
+ * Four levels of 256 slots at a 1ms tick cover ~49 days.  Each slot is a
+ * doubly linked list reusing thread->next/prev; thread->index encodes
+ * level * TW_SLOTS + slot so cancellation can unlink without searching.
+ * When the lower levels wrap into a new lap, the higher-level slot
+ * covering that lap is drained and its timers reinserted closer to the
+ * front ("cascading").
+ */
+
+#define TW_SLOT_BITS 8
+#define TW_SLOTS (1 << TW_SLOT_BITS)
+#define TW_SLOT_MASK (TW_SLOTS - 1)
+#define TW_LEVELS 4
+#define TW_TICK_MSEC 1
+
+struct thread_timer_wheel {
+	struct thread_list slot[TW_LEVELS][TW_SLOTS];
+	uint64_t curtick; /* last tick the wheel was advanced to */
+	unsigned long count; /* timers across all levels */
+	unsigned long level_count[TW_LEVELS];
+};
+
+/* Absolute monotime -> wheel tick. */
+static uint64_t thread_wheel_tick(const struct timeval *tv)
+{
+	return (uint64_t)tv->tv_sec * (1000 / TW_TICK_MSEC)
+	       + (uint64_t)tv->tv_usec / (TW_TICK_MSEC * 1000);
+}
+
+static void thread_wheel_insert(struct thread_timer_wheel *tw,
+				struct thread *thread)
+{
+	uint64_t expire = thread_wheel_tick(&thread->u.sands);
+	unsigned int level, slot;
+
+	/* Round up to the next tick so a timer never fires early. */
+	if (thread->u.sands.tv_usec % (TW_TICK_MSEC * 1000))
+		expire++;
+	/* Already-due timers go into the next slot to be swept. */
+	if (expire <= tw->curtick)
+		expire = tw->curtick + 1;
+	/* Beyond the horizon: park at the far end; each cascade recomputes
+	 * from u.sands, so the timer keeps sliding until it fits. */
+	if (expire - tw->curtick >= (uint64_t)1 << (TW_SLOT_BITS * TW_LEVELS))
+		expire = tw->curtick
+			 + ((uint64_t)1 << (TW_SLOT_BITS * TW_LEVELS)) - 1;
+
+	for (level = 0; level < TW_LEVELS - 1; level++)
+		if (expire - tw->curtick
+		    < (uint64_t)1 << (TW_SLOT_BITS * (level + 1)))
+			break;
+
+	slot = (expire >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK;
+	thread->index = level * TW_SLOTS + slot;
+	thread_list_add(&tw->slot[level][slot], thread);
+	tw->count++;
+	tw->level_count[level]++;
+}
+
+static void thread_wheel_remove(struct thread_timer_wheel *tw,
+				struct thread *thread)
+{
+	unsigned int level = thread->index / TW_SLOTS;
+	unsigned int slot = thread->index % TW_SLOTS;
+
+	thread_list_delete(&tw->slot[level][slot], thread);
+	tw->count--;
+	tw->level_count[level]--;
+}
+
+/* The wheel just wrapped into a new lap: drain the higher-level slot
+ * covering it and reinsert those timers at their now-lower level.  If the
+ * higher level wrapped too, recurse upwards. */
+static void thread_wheel_cascade(struct thread_timer_wheel *tw)
+{
+	struct thread_list drain = {NULL, NULL, 0};
+	struct thread *thread;
+	unsigned int level, slot;
+
+	for (level = 1; level < TW_LEVELS; level++) {
+		slot = (tw->curtick >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK;
+		while ((thread = thread_trim_head(&tw->slot[level][slot]))) {
+			tw->count--;
+			tw->level_count[level]--;
+			thread_list_add(&drain, thread);
+		}
+		while ((thread = thread_trim_head(&drain)))
+			thread_wheel_insert(tw, thread);
+		if (slot != 0)
+			break;
+	}
+}
+
+static void thread_wheel_free(struct thread_master *m,
+			      struct thread_timer_wheel *tw)
+{
+	struct thread *thread;
+	unsigned int level, slot;
+
+	for (level = 0; level < TW_LEVELS; level++)
+		for (slot = 0; slot < TW_SLOTS; slot++)
+			while ((thread =
+					thread_trim_head(&tw->slot[level][slot])))
+				thread_free(m, thread);
+	XFREE(MTYPE_THREAD_MASTER, tw);
+}
+
+/* Switch this master's timer backend from the binary heap to the
+ * hierarchical timing wheel.  Meant to be called right after
+ * thread_master_create(); timers already sitting on the heap are
+ * migrated over. */
+void thread_master_use_timer_wheel(struct thread_master *master)
+{
+	struct thread *thread;
+	struct timeval now;
+
+	pthread_mutex_lock(&master->mtx);
+	{
+		if (!master->twheel) {
+			master->twheel = XCALLOC(
+				MTYPE_THREAD_MASTER,
+				sizeof(struct thread_timer_wheel));
+			monotime(&now);
+			master->twheel->curtick = thread_wheel_tick(&now);
+
+			while (master->timer->size) {
+				thread = master->timer->array[0];
+				pqueue_dequeue(master->timer);
+				thread_wheel_insert(master->twheel, thread);
+			}
+		}
+	}
+	pthread_mutex_unlock(&master->mtx);
+}
+
+/* -------------------------------------------------------------------- */
+
 #define THREAD_UNUSED_DEPTH 10
 
 /* Move thread to unuse list. */
@@ -632,9 +1248,16 @@ void thread_master_free(struct thread_master *m)
 	thread_array_free(m, m->read);
 	thread_array_free(m, m->write);
 	thread_queue_free(m, m->timer);
+	if (m->twheel)
+		thread_wheel_free(m, m->twheel);
 	thread_list_free(m, &m->event);
 	thread_list_free(m, &m->ready);
 	thread_list_free(m, &m->unuse);
+	thread_mpsc_free(m);
+#if defined(GNU_LINUX) && defined(SIGEV_THREAD_ID)
+	if (m->watchdog_created)
+		timer_delete(m->watchdog_timer);
+#endif
 	pthread_mutex_destroy(&m->mtx);
 	pthread_cond_destroy(&m->cancel_cond);
 	close(m->io_pipe[0]);
@@ -646,9 +1269,21 @@ void thread_master_free(struct thread_master *m)
 	hash_free(m->cpu_record);
 	m->cpu_record = NULL;
 
+	if (m->trace) {
+		XFREE(MTYPE_THREAD_TRACE, m->trace->ents);
+		XFREE(MTYPE_THREAD_TRACE, m->trace);
+		m->trace = NULL;
+	}
+
 	XFREE(MTYPE_THREAD_MASTER, m->name);
 	XFREE(MTYPE_THREAD_MASTER, m->handler.pfds);
 	XFREE(MTYPE_THREAD_MASTER, m->handler.copy);
+	XFREE(MTYPE_THREAD_MASTER, m->handler.fd_index);
+#ifdef HAVE_SYS_EPOLL_H
+	if (m->handler.epoll_fd >= 0)
+		close(m->handler.epoll_fd);
+	XFREE(MTYPE_THREAD_MASTER, m->handler.events);
+#endif
 	XFREE(MTYPE_THREAD_MASTER, m);
 }
 
@@ -708,6 +1343,7 @@ static struct thread *thread_get(struct thread_master *m, uint8_t type,
 	thread->index = -1;
 	thread->yield = THREAD_YIELD_TIME_SLOT; /* default */
 	thread->ref = NULL;
+	monotime(&thread->sched_real);
 
 	/*
 	 * So if the passed in funcname is not what we have
@@ -746,6 +1382,186 @@ static void thread_free(struct thread_master *master, struct thread *thread)
 	XFREE(MTYPE_THREAD, thread);
 }
 
+/* Cross-thread event injection --------------------------------------------- */
+
+/* Lock-free MPSC ring used as the fast path for thread_add_event() calls
+ * coming from other pthreads.  The classic path takes master->mtx and
+ * writes the wakeup pipe on every call; under heavy cross-thread traffic
+ * (e.g. the bgpd I/O pthread handing packets to the main pthread) both
+ * show up hot.  Producers instead reserve a slot below with a single CAS
+ * and only the enqueue that finds the consumer asleep pays a wakeup
+ * syscall, so a burst of N events costs N CASes and one write.
+ *
+ * The ring is bounded; when it fills, enqueue fails and the caller just
+ * falls through to the classic locked path, so overload degrades to the
+ * old behavior instead of blocking or dropping.
+ *
+ * Slot sequence numbers follow the well-known bounded MPMC design
+ * (Vyukov): slot i starts with seq == i; a producer that reserved
+ * position "pos" publishes by storing seq = pos + 1; the consumer
+ * retires the slot by storing seq = pos + size, making it reservable
+ * again one lap later.
+ */
+
+#define THREAD_MPSC_SIZE 1024 /* slots; must be a power of two */
+
+struct thread_mpsc_slot {
+	_Atomic uint32_t seq;
+	int (*func)(struct thread *);
+	void *arg;
+	int val;
+	const char *funcname;
+	const char *schedfrom;
+	int schedfrom_line;
+};
+
+struct thread_mpsc {
+	struct thread_mpsc_slot *slots;
+	uint32_t size; /* power of two */
+
+	/* next position to reserve; producers CAS this */
+	_Atomic uint32_t head;
+	/* next position to consume; owning pthread only, under m->mtx */
+	uint32_t tail;
+
+	/* set by the consumer just before it sleeps; the producer that
+	 * exchanges it back to false owes the wakeup */
+	_Atomic bool armed;
+
+	/* eventfd for the batched wakeup, -1 to fall back to the
+	 * io_pipe poker (non-Linux) */
+	int event_fd;
+};
+
+static void thread_mpsc_create(struct thread_master *m)
+{
+	struct thread_mpsc *q;
+
+	q = XCALLOC(MTYPE_THREAD_MASTER, sizeof(struct thread_mpsc));
+	q->size = THREAD_MPSC_SIZE;
+	q->slots = XCALLOC(MTYPE_THREAD_MASTER,
+			   sizeof(struct thread_mpsc_slot) * q->size);
+	for (uint32_t i = 0; i < q->size; i++)
+		atomic_store_explicit(&q->slots[i].seq, i,
+				      memory_order_relaxed);
+	q->event_fd = -1;
+#ifdef HAVE_SYS_EVENTFD_H
+	q->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+	m->mpsc = q;
+}
+
+static void thread_mpsc_free(struct thread_master *m)
+{
+	if (m->mpsc->event_fd >= 0)
+		close(m->mpsc->event_fd);
+	XFREE(MTYPE_THREAD_MASTER, m->mpsc->slots);
+	XFREE(MTYPE_THREAD_MASTER, m->mpsc);
+}
+
+/* Producer side; any pthread, no locks held.  Returns false when the
+ * ring is full - the caller must then take the classic locked path. */
+static bool thread_mpsc_enqueue(struct thread_master *m,
+				int (*func)(struct thread *), void *arg,
+				int val, const char *funcname,
+				const char *schedfrom, int fromln)
+{
+	struct thread_mpsc *q = m->mpsc;
+	struct thread_mpsc_slot *slot;
+	uint32_t pos;
+	int32_t dif;
+
+	pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+	for (;;) {
+		slot = &q->slots[pos & (q->size - 1)];
+		dif = (int32_t)(atomic_load_explicit(&slot->seq,
+						     memory_order_acquire)
+				- pos);
+		if (dif == 0) {
+			if (atomic_compare_exchange_weak_explicit(
+				    &q->head, &pos, pos + 1,
+				    memory_order_relaxed,
+				    memory_order_relaxed))
+				break;
+		} else if (dif < 0) {
+			/* consumer is a full lap behind: ring is full */
+			return false;
+		} else {
+			pos = atomic_load_explicit(&q->head,
+						   memory_order_relaxed);
+		}
+	}
+
+	slot->func = func;
+	slot->arg = arg;
+	slot->val = val;
+	slot->funcname = funcname;
+	slot->schedfrom = schedfrom;
+	slot->schedfrom_line = fromln;
+	atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+	/* Order the publish above against the 'armed' read below; this
+	 * pairs with the consumer's fence between arming and its ring
+	 * re-check.  Without both fences this is the classic store-load
+	 * (store buffer) race: each side reads the other's stale value,
+	 * the wakeup is skipped and the consumer sleeps on a pending
+	 * entry for the full poll timeout. */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	/* Wake the consumer only if it announced it was going to sleep;
+	 * everyone else in the burst sees armed == false and skips the
+	 * syscall. */
+	if (atomic_exchange_explicit(&q->armed, false,
+				     memory_order_acq_rel)) {
+#ifdef HAVE_SYS_EVENTFD_H
+		if (q->event_fd >= 0) {
+			uint64_t one = 1;
+
+			write(q->event_fd, &one, sizeof(one));
+		} else
+#endif
+			AWAKEN(m);
+	}
+
+	return true;
+}
+
+/* Consumer side; owning pthread only, under m->mtx.  Turns published
+ * ring entries into regular entries on the event list, where the normal
+ * processing and cancellation machinery can see them. */
+static void thread_mpsc_drain(struct thread_master *m)
+{
+	struct thread_mpsc *q = m->mpsc;
+	struct thread_mpsc_slot *slot;
+	struct thread *thread;
+
+	for (;;) {
+		slot = &q->slots[q->tail & (q->size - 1)];
+		if (atomic_load_explicit(&slot->seq, memory_order_acquire)
+		    != q->tail + 1)
+			break;
+
+		thread = thread_get(m, THREAD_EVENT, slot->func, slot->arg,
+				    slot->funcname, slot->schedfrom,
+				    slot->schedfrom_line);
+		thread->u.val = slot->val;
+		thread_list_add(&m->event, thread);
+
+		atomic_store_explicit(&slot->seq, q->tail + q->size,
+				      memory_order_release);
+		q->tail++;
+	}
+}
+
+/* true if at least one published entry is waiting */
+static bool thread_mpsc_pending(struct thread_mpsc *q)
+{
+	struct thread_mpsc_slot *slot = &q->slots[q->tail & (q->size - 1)];
+
+	return atomic_load_explicit(&slot->seq, memory_order_acquire)
+	       == q->tail + 1;
+}
+
 static int fd_poll(struct thread_master *m, struct pollfd *pfds, nfds_t pfdsize,
 		   nfds_t count, const struct timeval *timer_wait)
 {
@@ -781,16 +1597,168 @@ static int fd_poll(struct thread_master *m, struct pollfd *pfds, nfds_t pfdsize,
 	pfds[count].events = POLLIN;
 	pfds[count].revents = 0x00;
 
-	num = poll(pfds, count + 1, timeout);
+	nfds_t numfds = count + 1;
+
+#ifdef HAVE_SYS_EVENTFD_H
+	/* MPSC wakeup eventfd, if we have one */
+	nfds_t efdpos = 0;
+
+	if (m->mpsc->event_fd >= 0) {
+		assert(count + 2 < pfdsize);
+		efdpos = numfds++;
+		pfds[efdpos].fd = m->mpsc->event_fd;
+		pfds[efdpos].events = POLLIN;
+		pfds[efdpos].revents = 0x00;
+	}
+#endif
+
+	num = poll(pfds, numfds, timeout);
 
 	unsigned char trash[64];
 	if (num > 0 && pfds[count].revents != 0 && num--)
 		while (read(m->io_pipe[0], &trash, sizeof(trash)) > 0)
 			;
 
+#ifdef HAVE_SYS_EVENTFD_H
+	if (efdpos && num > 0 && pfds[efdpos].revents != 0 && num--) {
+		uint64_t junk;
+
+		while (read(m->mpsc->event_fd, &junk, sizeof(junk)) > 0)
+			;
+	}
+#endif
+
 	return num;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/* Mirror the interest bits bookkept in pfds[] into the epoll set.
+ * "events" is the pollfd events word after the change; zero drops the fd
+ * from the set entirely. */
+static void thread_epoll_update(struct thread_master *m, int fd, short events)
+{
+	struct epoll_event ev = {.events = 0, .data = {.fd = fd}};
+
+	if (m->handler.epoll_fd < 0)
+		return;
+
+	if (events & POLLIN)
+		ev.events |= EPOLLIN;
+	if (events & POLLOUT)
+		ev.events |= EPOLLOUT;
+	if (m->handler.epoll_edge)
+		ev.events |= EPOLLET;
+
+	if (!(ev.events & (EPOLLIN | EPOLLOUT))) {
+		epoll_ctl(m->handler.epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+		return;
+	}
+
+	if (epoll_ctl(m->handler.epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0
+	    && errno == ENOENT
+	    && epoll_ctl(m->handler.epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+		flog_err(EC_LIB_SYSTEM_CALL, "epoll_ctl(add fd %d) error: %s",
+			 fd, safe_strerror(errno));
+}
+
+/* Counterpart of fd_poll(): wait on the epoll set.  Only descriptors
+ * with pending events come back, so dispatch cost scales with active
+ * fds instead of total fds. */
+static int fd_epoll(struct thread_master *m, const struct timeval *timer_wait)
+{
+	/* -1 = block indefinitely; see fd_poll() for the override rules */
+	int timeout = -1;
+	int num;
+
+	if (timer_wait != NULL
+	    && m->selectpoll_timeout == 0) // use the default value
+		timeout = (timer_wait->tv_sec * 1000)
+			  + (timer_wait->tv_usec / 1000);
+	else if (m->selectpoll_timeout > 0) // use the user's timeout
+		timeout = m->selectpoll_timeout;
+	else if (m->selectpoll_timeout
+		 < 0) // effect a poll (return immediately)
+		timeout = 0;
+
+	num = epoll_wait(m->handler.epoll_fd, m->handler.events,
+			 m->handler.pfdsize, timeout);
+
+	/* the poll pipe poker and the MPSC eventfd have permanent
+	 * registrations; drain them here, dispatch skips them */
+	for (int i = 0; i < num; i++) {
+		if (m->handler.events[i].data.fd == m->io_pipe[0]) {
+			unsigned char trash[64];
+
+			while (read(m->io_pipe[0], &trash, sizeof(trash)) > 0)
+				;
+		}
+#ifdef HAVE_SYS_EVENTFD_H
+		if (m->mpsc->event_fd >= 0
+		    && m->handler.events[i].data.fd == m->mpsc->event_fd) {
+			uint64_t junk;
+
+			while (read(m->mpsc->event_fd, &junk, sizeof(junk))
+			       > 0)
+				;
+		}
+#endif
+	}
+
+	return num;
+}
+#endif /* HAVE_SYS_EPOLL_H */
+
+/* Switch this master's I/O backend from poll() to epoll.  Meant to be
+ * called right after thread_master_create(); interest registered before
+ * the switch is migrated over.  With "edge" set registrations are
+ * edge-triggered (EPOLLET) - only useful for handlers that drain their
+ * fd completely.  No-op on platforms without epoll, which keep poll().
+ */
+void thread_master_use_epoll(struct thread_master *master, bool edge)
+{
+#ifdef HAVE_SYS_EPOLL_H
+	struct epoll_event ev = {.events = EPOLLIN,
+				 .data = {.fd = master->io_pipe[0]}};
+
+	pthread_mutex_lock(&master->mtx);
+	{
+		if (master->handler.epoll_fd < 0) {
+			int efd = epoll_create1(EPOLL_CLOEXEC);
+
+			if (efd < 0) {
+				flog_err(EC_LIB_SYSTEM_CALL,
+					 "epoll_create1 error: %s, staying with poll()",
+					 safe_strerror(errno));
+				pthread_mutex_unlock(&master->mtx);
+				return;
+			}
+			master->handler.epoll_fd = efd;
+			master->handler.epoll_edge = edge;
+			master->handler.events = XCALLOC(
+				MTYPE_THREAD_MASTER,
+				sizeof(struct epoll_event)
+					* master->handler.pfdsize);
+
+			epoll_ctl(efd, EPOLL_CTL_ADD, master->io_pipe[0], &ev);
+
+#ifdef HAVE_SYS_EVENTFD_H
+			if (master->mpsc->event_fd >= 0) {
+				ev.data.fd = master->mpsc->event_fd;
+				epoll_ctl(efd, EPOLL_CTL_ADD,
+					  master->mpsc->event_fd, &ev);
+			}
+#endif
+
+			for (nfds_t i = 0; i < master->handler.pfdcount; i++)
+				thread_epoll_update(
+					master, master->handler.pfds[i].fd,
+					master->handler.pfds[i].events);
+		}
+	}
+	pthread_mutex_unlock(&master->mtx);
+#endif /* HAVE_SYS_EPOLL_H */
+}
+
 /* Add new read thread. */
 struct thread *funcname_thread_add_read_write(int dir, struct thread_master *m,
 					      int (*func)(struct thread *),
@@ -813,13 +1781,10 @@ struct thread *funcname_thread_add_read_write(int dir, struct thread_master *m,
 		/* default to a new pollfd */
 		nfds_t queuepos = m->handler.pfdcount;
 
-		/* if we already have a pollfd for our file descriptor, find and
-		 * use it */
-		for (nfds_t i = 0; i < m->handler.pfdcount; i++)
-			if (m->handler.pfds[i].fd == fd) {
-				queuepos = i;
-				break;
-			}
+		/* if we already have a pollfd for our file descriptor, use it
+		 */
+		if (m->handler.fd_index[fd] >= 0)
+			queuepos = m->handler.fd_index[fd];
 
 		/* make sure we have room for this fd + pipe poker fd */
 		assert(queuepos + 1 < m->handler.pfdsize);
@@ -830,8 +1795,14 @@ struct thread *funcname_thread_add_read_write(int dir, struct thread_master *m,
 		m->handler.pfds[queuepos].events |=
 			(dir == THREAD_READ ? POLLIN : POLLOUT);
 
-		if (queuepos == m->handler.pfdcount)
+		if (queuepos == m->handler.pfdcount) {
+			m->handler.fd_index[fd] = queuepos;
 			m->handler.pfdcount++;
+		}
+
+#ifdef HAVE_SYS_EPOLL_H
+		thread_epoll_update(m, fd, m->handler.pfds[queuepos].events);
+#endif
 
 		if (thread) {
 			pthread_mutex_lock(&thread->mtx);
@@ -864,7 +1835,6 @@ funcname_thread_add_timer_timeval(struct thread_master *m,
 				  struct thread **t_ptr, debugargdef)
 {
 	struct thread *thread;
-	struct pqueue *queue;
 
 	assert(m != NULL);
 
@@ -880,7 +1850,6 @@ funcname_thread_add_timer_timeval(struct thread_master *m,
 			return NULL;
 		}
 
-		queue = m->timer;
 		thread = thread_get(m, type, func, arg, debugargpass);
 
 		pthread_mutex_lock(&thread->mtx);
@@ -888,7 +1857,10 @@ funcname_thread_add_timer_timeval(struct thread_master *m,
 			monotime(&thread->u.sands);
 			timeradd(&thread->u.sands, time_relative,
 				 &thread->u.sands);
-			pqueue_enqueue(thread, queue);
+			if (m->twheel)
+				thread_wheel_insert(m->twheel, thread);
+			else
+				pqueue_enqueue(thread, m->timer);
 			if (t_ptr) {
 				*t_ptr = thread;
 				thread->ref = t_ptr;
@@ -959,6 +1931,15 @@ struct thread *funcname_thread_add_event(struct thread_master *m,
 
 	assert(m != NULL);
 
+	/* Fire-and-forget events from other pthreads go through the
+	 * lock-free ring instead of taking m->mtx; a full ring just means
+	 * we fall through to the locked path below.  Events with a ref
+	 * pointer need the dedup check and a struct thread back, so they
+	 * always take the locked path. */
+	if (t_ptr == NULL && !pthread_equal(pthread_self(), m->owner)
+	    && thread_mpsc_enqueue(m, func, arg, val, debugargpass))
+		return NULL;
+
 	pthread_mutex_lock(&m->mtx);
 	{
 		if (t_ptr
@@ -1006,27 +1987,20 @@ struct thread *funcname_thread_add_event(struct thread_master *m,
  */
 static void thread_cancel_rw(struct thread_master *master, int fd, short state)
 {
-	bool found = false;
-
 	/* Cancel POLLHUP too just in case some bozo set it */
 	state |= POLLHUP;
 
 	/* find the index of corresponding pollfd */
 	nfds_t i;
 
-	for (i = 0; i < master->handler.pfdcount; i++)
-		if (master->handler.pfds[i].fd == fd) {
-			found = true;
-			break;
-		}
-
-	if (!found) {
+	if (master->handler.fd_index[fd] < 0) {
 		zlog_debug(
 			"[!] Received cancellation request for nonexistent rw job");
 		zlog_debug("[!] threadmaster: %s | fd: %d",
 			   master->name ? master->name : "", fd);
 		return;
 	}
+	i = master->handler.fd_index[fd];
 
 	/* NOT out event. */
 	master->handler.pfds[i].events &= ~(state);
@@ -1037,8 +2011,19 @@ static void thread_cancel_rw(struct thread_master *master, int fd, short state)
 			(master->handler.pfdcount - i - 1)
 				* sizeof(struct pollfd));
 		master->handler.pfdcount--;
+		master->handler.fd_index[fd] = -1;
+		for (nfds_t j = i; j < master->handler.pfdcount; j++)
+			master->handler.fd_index[master->handler.pfds[j].fd] =
+				j;
 	}
 
+#ifdef HAVE_SYS_EPOLL_H
+	thread_epoll_update(master, fd,
+			    master->handler.fd_index[fd] >= 0
+				    ? master->handler.pfds[i].events
+				    : 0);
+#endif
+
 	/* If we have the same pollfd in the copy, perform the same operations,
 	 * otherwise return. */
 	if (i >= master->handler.copycount)
@@ -1071,6 +2056,12 @@ static void do_thread_cancel(struct thread_master *master)
 
 	struct cancel_req *cr;
 	struct listnode *ln;
+
+	/* Land injected cross-thread events on the event list first, so an
+	 * eventobj cancellation below also covers events still sitting in
+	 * the ring. */
+	thread_mpsc_drain(master);
+
 	for (ALL_LIST_ELEMENTS_RO(master->cancel_req, ln, cr)) {
 		/* If this is an event object cancellation, linear search
 		 * through event
@@ -1129,6 +2120,15 @@ static void do_thread_cancel(struct thread_master *master)
 			thread_array = master->write;
 			break;
 		case THREAD_TIMER:
+			if (master->twheel) {
+				/* wheel slots are plain lists; unlink here
+				 * and skip the queue/list/array dispatch */
+				thread_wheel_remove(master->twheel, thread);
+				if (thread->ref)
+					*thread->ref = NULL;
+				thread_add_unuse(master, thread);
+				continue;
+			}
 			queue = master->timer;
 			break;
 		case THREAD_EVENT:
@@ -1280,6 +2280,44 @@ static struct timeval *thread_timer_wait(struct pqueue *queue,
 	return NULL;
 }
 
+/* Timing-wheel counterpart of thread_timer_wait().  Returns NULL (sleep
+ * forever) only when no timers exist at all.  When the lowest level is
+ * empty the sleep is bounded by the next lap boundary, where the cascade
+ * that refills it from the higher levels happens. */
+static struct timeval *thread_wheel_timer_wait(struct thread_timer_wheel *tw,
+					       struct timeval *timer_val)
+{
+	struct timeval now;
+	uint64_t now_tick, wait_tick = 0;
+	unsigned int i;
+
+	if (tw->count == 0)
+		return NULL;
+
+	if (tw->level_count[0]) {
+		for (i = 1; i <= TW_SLOTS; i++)
+			if (tw->slot[0][(tw->curtick + i) & TW_SLOT_MASK]
+				    .head) {
+				wait_tick = tw->curtick + i;
+				break;
+			}
+	} else
+		wait_tick = (tw->curtick | TW_SLOT_MASK) + 1;
+
+	monotime(&now);
+	now_tick = thread_wheel_tick(&now);
+	if (wait_tick <= now_tick) {
+		timer_val->tv_sec = 0;
+		timer_val->tv_usec = 0;
+	} else {
+		uint64_t msec = (wait_tick - now_tick) * TW_TICK_MSEC;
+
+		timer_val->tv_sec = msec / 1000;
+		timer_val->tv_usec = (msec % 1000) * 1000;
+	}
+	return timer_val;
+}
+
 static struct thread *thread_run(struct thread_master *m, struct thread *thread,
 				 struct thread *fetch)
 {
@@ -1304,6 +2342,10 @@ static int thread_process_io_helper(struct thread_master *m,
 	thread_array[thread->u.fd] = NULL;
 	thread_list_add(&m->ready, thread);
 	thread->type = THREAD_READY;
+	/* for tracing, I/O queue delay runs from readiness, not from
+	 * whenever the fd was scheduled */
+	if (m->trace)
+		monotime(&thread->sched_real);
 	/* if another pthread scheduled this file descriptor for the event we're
 	 * responding to, no problem; we're getting to it now */
 	thread->master->handler.pfds[pos].events &= ~(state);
@@ -1353,10 +2395,13 @@ static void thread_process_io(struct thread_master *m, unsigned int num)
 		 * from
 		 * both pfds + update sizes and index */
 		if (pfds[i].revents & POLLNVAL) {
+			m->handler.fd_index[pfds[i].fd] = -1;
 			memmove(m->handler.pfds + i, m->handler.pfds + i + 1,
 				(m->handler.pfdcount - i - 1)
 					* sizeof(struct pollfd));
 			m->handler.pfdcount--;
+			for (nfds_t j = i; j < m->handler.pfdcount; j++)
+				m->handler.fd_index[m->handler.pfds[j].fd] = j;
 
 			memmove(pfds + i, pfds + i + 1,
 				(m->handler.copycount - i - 1)
@@ -1368,6 +2413,39 @@ static void thread_process_io(struct thread_master *m, unsigned int num)
 	}
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/* Epoll counterpart of thread_process_io(): walk only the events
+ * epoll_wait() reported.  Each dispatch clears the interest bit in
+ * pfds[] (same one-shot semantics as poll), so the epoll set is
+ * re-armed with whatever interest remains. */
+static void thread_process_io_epoll(struct thread_master *m, unsigned int num)
+{
+	for (unsigned int i = 0; i < num; i++) {
+		struct epoll_event *ev = &m->handler.events[i];
+		int fd = ev->data.fd;
+		int idx;
+
+		if (fd == m->io_pipe[0])
+			continue;
+
+		idx = m->handler.fd_index[fd];
+		if (idx < 0)
+			continue;
+
+		/* HUP/ERR are reported regardless of subscription; wake
+		 * both directions so the owners see the error from their
+		 * read()/write() */
+		if (ev->events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+			thread_process_io_helper(m, m->read[fd], POLLIN, idx);
+		if (ev->events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+			thread_process_io_helper(m, m->write[fd], POLLOUT,
+						 idx);
+
+		thread_epoll_update(m, fd, m->handler.pfds[idx].events);
+	}
+}
+#endif /* HAVE_SYS_EPOLL_H */
+
 /* Add all timers that have popped to the ready list. */
 static unsigned int thread_process_timers(struct pqueue *queue,
 					  struct timeval *timenow)
@@ -1387,6 +2465,53 @@ static unsigned int thread_process_timers(struct pqueue *queue,
 	return ready;
 }
 
+/* Timing-wheel counterpart of thread_process_timers(): advance the wheel
+ * to "timenow", cascading the higher levels at each lap boundary and
+ * moving expired timers onto the ready list. */
+static unsigned int thread_process_wheel_timers(struct thread_master *m,
+						struct timeval *timenow)
+{
+	struct thread_timer_wheel *tw = m->twheel;
+	uint64_t target = thread_wheel_tick(timenow);
+	struct thread_list *slot;
+	struct thread *thread;
+	unsigned int ready = 0;
+
+	if (tw->count == 0) {
+		if (target > tw->curtick)
+			tw->curtick = target;
+		return 0;
+	}
+
+	while (tw->curtick < target) {
+		/* Nothing on the lowest level: jump straight to the next
+		 * lap boundary, where a cascade may refill it. */
+		if (tw->level_count[0] == 0) {
+			uint64_t boundary = (tw->curtick | TW_SLOT_MASK) + 1;
+
+			if (boundary > target) {
+				tw->curtick = target;
+				break;
+			}
+			tw->curtick = boundary - 1;
+		}
+
+		tw->curtick++;
+		if ((tw->curtick & TW_SLOT_MASK) == 0)
+			thread_wheel_cascade(tw);
+
+		slot = &tw->slot[0][tw->curtick & TW_SLOT_MASK];
+		while ((thread = thread_trim_head(slot))) {
+			tw->count--;
+			tw->level_count[0]--;
+			thread->type = THREAD_READY;
+			thread_list_add(&thread->master->ready, thread);
+			ready++;
+		}
+	}
+	return ready;
+}
+
 /* process a list en masse, e.g. for event thread lists */
 static unsigned int thread_process(struct thread_list *list)
 {
@@ -1463,32 +2588,67 @@ struct thread *thread_fetch(struct thread_master *m, struct thread *fetch)
 		 * In every case except the last, we need to hit poll() at least
 		 * once per loop to avoid starvation by events
 		 */
-		if (m->ready.count == 0)
-			tw = thread_timer_wait(m->timer, &tv);
+		if (m->ready.count == 0) {
+			if (m->twheel)
+				tw = thread_wheel_timer_wait(m->twheel, &tv);
+			else
+				tw = thread_timer_wait(m->timer, &tv);
+		}
 
 		if (m->ready.count != 0 || (tw && !timercmp(tw, &zerotime, >)))
 			tw = &zerotime;
 
+		/* Announce we are about to sleep, then re-check the MPSC
+		 * ring: a producer racing with us may have enqueued while
+		 * armed was still false, in which case nobody owes us a
+		 * wakeup and we must not block. */
+		atomic_store_explicit(&m->mpsc->armed, true,
+				      memory_order_release);
+		/* Pairs with the producer's fence after publishing a
+		 * slot; see thread_mpsc_enqueue(). */
+		atomic_thread_fence(memory_order_seq_cst);
+		if (thread_mpsc_pending(m->mpsc))
+			tw = &zerotime;
+
 		if (!tw && m->handler.pfdcount == 0) { /* die */
 			pthread_mutex_unlock(&m->mtx);
 			fetch = NULL;
 			break;
 		}
 
-		/*
-		 * Copy pollfd array + # active pollfds in it. Not necessary to
-		 * copy the array size as this is fixed.
-		 */
-		m->handler.copycount = m->handler.pfdcount;
-		memcpy(m->handler.copy, m->handler.pfds,
-		       m->handler.copycount * sizeof(struct pollfd));
-
-		pthread_mutex_unlock(&m->mtx);
+#ifdef HAVE_SYS_EPOLL_H
+		if (m->handler.epoll_fd >= 0) {
+			/* interest lives in the kernel; no pollfd copy */
+			pthread_mutex_unlock(&m->mtx);
+			{
+				num = fd_epoll(m, tw);
+			}
+			pthread_mutex_lock(&m->mtx);
+		} else
+#endif
 		{
-			num = fd_poll(m, m->handler.copy, m->handler.pfdsize,
-				      m->handler.copycount, tw);
+			/*
+			 * Copy pollfd array + # active pollfds in it. Not
+			 * necessary to copy the array size as this is fixed.
+			 */
+			m->handler.copycount = m->handler.pfdcount;
+			memcpy(m->handler.copy, m->handler.pfds,
+			       m->handler.copycount * sizeof(struct pollfd));
+
+			pthread_mutex_unlock(&m->mtx);
+			{
+				num = fd_poll(m, m->handler.copy,
+					      m->handler.pfdsize,
+					      m->handler.copycount, tw);
+			}
+			pthread_mutex_lock(&m->mtx);
 		}
-		pthread_mutex_lock(&m->mtx);
+
+		/* Awake again; producers can stop poking until the next
+		 * sleep.  Entries enqueued from here on are picked up by
+		 * the drain at the top of the next iteration. */
+		atomic_store_explicit(&m->mpsc->armed, false,
+				      memory_order_relaxed);
 
 		/* Handle any errors received in poll() */
 		if (num < 0) {
@@ -1508,11 +2668,20 @@ struct thread *thread_fetch(struct thread_master *m, struct thread *fetch)
 
 		/* Post timers to ready queue. */
 		monotime(&now);
-		thread_process_timers(m->timer, &now);
+		if (m->twheel)
+			thread_process_wheel_timers(m, &now);
+		else
+			thread_process_timers(m->timer, &now);
 
 		/* Post I/O to ready queue. */
-		if (num > 0)
-			thread_process_io(m, num);
+		if (num > 0) {
+#ifdef HAVE_SYS_EPOLL_H
+			if (m->handler.epoll_fd >= 0)
+				thread_process_io_epoll(m, num);
+			else
+#endif
+				thread_process_io(m, num);
+		}
 
 		pthread_mutex_unlock(&m->mtx);
 
@@ -1578,6 +2747,45 @@ void thread_getrusage(RUSAGE_T *r)
 	getrusage(FRR_RUSAGE, &(r->cpu));
 }
 
+/* Append one record for a completed handler to the master's trace ring
+ * (see "thread trace").  Only called when the ring exists; it is never
+ * freed before the master itself, so the unlocked pointer check in
+ * thread_call() is safe. */
+static void thread_trace_record(struct thread *thread, RUSAGE_T *before,
+				unsigned long realtime, unsigned long cputime)
+{
+	struct thread_master *m = thread->master;
+	struct thread_trace_entry *e;
+	int64_t qdelay;
+
+	pthread_mutex_lock(&m->mtx);
+	if (!m->trace->on) {
+		pthread_mutex_unlock(&m->mtx);
+		return;
+	}
+
+	/* Timers wait for their deadline by design; their queue delay is
+	 * only the lateness past it. */
+	if (thread->add_type == THREAD_TIMER)
+		qdelay = timeval_elapsed(before->real, thread->u.sands);
+	else
+		qdelay = timeval_elapsed(before->real, thread->sched_real);
+	if (qdelay < 0)
+		qdelay = 0;
+
+	e = &m->trace->ents[m->trace->next];
+	m->trace->next = (m->trace->next + 1) % m->trace->size;
+	m->trace->total++;
+
+	e->funcname = thread->funcname;
+	e->start = before->real;
+	e->queue_us = qdelay;
+	e->real_us = realtime;
+	e->cpu_us = cputime;
+	e->type = thread->add_type;
+	pthread_mutex_unlock(&m->mtx);
+}
+
 /*
  * Call a thread.
  *
@@ -1594,13 +2802,21 @@ void thread_call(struct thread *thread)
 	_Atomic unsigned long realtime, cputime;
 	unsigned long exp;
 	unsigned long helper;
+	unsigned long budget;
 	RUSAGE_T before, after;
 
+	budget = atomic_load_explicit(&thread_watchdog_budget,
+				      memory_order_relaxed);
+
 	GETRUSAGE(&before);
 	thread->real = before.real;
 
 	pthread_setspecific(thread_current, thread);
+	if (budget)
+		thread_watchdog_arm(thread->master, budget);
 	(*thread->func)(thread);
+	if (budget)
+		thread_watchdog_disarm(thread->master);
 	pthread_setspecific(thread_current, NULL);
 
 	GETRUSAGE(&after);
@@ -1635,6 +2851,25 @@ void thread_call(struct thread *thread)
 	atomic_fetch_or_explicit(&thread->hist->types, 1 << thread->add_type,
 				 memory_order_seq_cst);
 
+	if (thread->master->trace)
+		thread_trace_record(thread, &before, realtime, cputime);
+
+	/* per-pthread max-latency gauge */
+	exp = atomic_load_explicit(&thread->master->latency_max,
+				   memory_order_relaxed);
+	while (exp < realtime
+	       && !atomic_compare_exchange_weak_explicit(
+			  &thread->master->latency_max, &exp, realtime,
+			  memory_order_relaxed, memory_order_relaxed))
+		;
+
+	if (budget && realtime > budget)
+		flog_warn(
+			EC_LIB_SLOW_THREAD,
+			"WATCHDOG: task %s (%lx) overran its %lums budget: ran for %lums (cpu time %lums)",
+			thread->funcname, (unsigned long)thread->func,
+			budget / 1000, realtime / 1000, cputime / 1000);
+
 #ifdef CONSUMED_TIME_CHECK
 	if (realtime > CONSUMED_TIME_CHECK) {
 		/*
@@ -24,6 +24,9 @@
 #include <zebra.h>
 #include <pthread.h>
 #include <poll.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #include "monotime.h"
 #include "frratomic.h"
 
@@ -47,6 +50,8 @@ struct thread_list {
 };
 
 struct pqueue;
+struct thread_timer_wheel;
+struct thread_mpsc;
 
 struct fd_handler {
 	/* number of pfd that fit in the allocated space of pfds. This is a
@@ -63,6 +68,21 @@ struct fd_handler {
 	struct pollfd *copy;
 	/* number of pollfds stored in copy */
 	nfds_t copycount;
+
+	/* fd -> index into pfds, -1 when the fd has no entry; keeps the
+	 * pollfd bookkeeping O(1) */
+	int *fd_index;
+
+#ifdef HAVE_SYS_EPOLL_H
+	/* epoll backend (see thread_master_use_epoll()); -1 while the
+	 * default poll backend is in use.  pfds[] stays the registry of
+	 * interest, mirrored into the epoll set as it changes. */
+	int epoll_fd;
+	bool epoll_edge;
+	/* ready events returned by epoll_wait(); dispatch walks only
+	 * these instead of scanning the whole pollfd array */
+	struct epoll_event *events;
+#endif
 };
 
 struct cancel_req {
@@ -78,6 +98,8 @@ struct thread_master {
 	struct thread **read;
 	struct thread **write;
 	struct pqueue *timer;
+	struct thread_timer_wheel *twheel;
+	struct thread_mpsc *mpsc;
 	struct thread_list event;
 	struct thread_list ready;
 	struct thread_list unuse;
@@ -85,6 +107,12 @@ struct thread_master {
 	bool canceled;
 	pthread_cond_t cancel_cond;
 	struct hash *cpu_record;
+	struct thread_trace *trace;
+	/* event-loop latency watchdog; see thread_watchdog_arm() */
+	timer_t watchdog_timer;
+	pid_t watchdog_tid;
+	bool watchdog_created;
+	_Atomic unsigned long latency_max; /* usec, since last clear */
 	int io_pipe[2];
 	int fd_limit;
 	struct fd_handler handler;
@@ -113,6 +141,7 @@ struct thread {
 	} u;
 	int index; /* queue position for timers */
 	struct timeval real;
+	struct timeval sched_real; /* monotime when scheduled/made ready */
 	struct cpu_thread_history *hist; /* cache pointer to cpu_history */
 	unsigned long yield;		 /* yield time in microseconds */
 	const char *funcname;		 /* name of thread function */
@@ -133,6 +162,33 @@ struct cpu_thread_history {
 	const char *funcname;
 };
 
+/*
+ * Optional event tracing ("thread trace" / "show thread trace").
+ *
+ * While enabled, thread_call() appends one record per handler
+ * invocation to a fixed wrap-around ring, so individual slow or
+ * late-dispatched events can be attributed to their handler after the
+ * fact; "show thread trace folded" emits the ring in folded-stack form
+ * for flamegraph tooling.  The ring is written under the master's mtx
+ * and costs nothing beyond a pointer check while tracing is off.
+ */
+struct thread_trace_entry {
+	const char *funcname;
+	struct timeval start;   /* monotime the handler began running */
+	unsigned long queue_us; /* ready-to-run delay (timers: lateness) */
+	unsigned long real_us;  /* wall-clock runtime */
+	unsigned long cpu_us;   /* cpu (user+system) runtime */
+	uint8_t type;		/* THREAD_READ etc. (add_type) */
+};
+
+struct thread_trace {
+	struct thread_trace_entry *ents;
+	uint32_t size;	     /* ring capacity */
+	uint32_t next;	     /* next slot to overwrite */
+	unsigned long total; /* records written since enable/clear */
+	bool on;
+};
+
 /* Struct timeval's tv_usec one second value.  */
 #define TIMER_SECOND_MICRO 1000000L
 
@@ -180,6 +236,8 @@ struct cpu_thread_history {
 /* Prototypes. */
 extern struct thread_master *thread_master_create(const char *);
 void thread_master_set_name(struct thread_master *master, const char *name);
+extern void thread_master_use_timer_wheel(struct thread_master *master);
+extern void thread_master_use_epoll(struct thread_master *master, bool edge);
 extern void thread_master_free(struct thread_master *);
 extern void thread_master_free_unused(struct thread_master *);
 
@@ -0,0 +1,124 @@
+/*
+ * Token bucket rate limiter.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "tokenbucket.h"
+
+#define TB_NSEC_PER_SEC 1000000000ULL
+
+static uint64_t token_bucket_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * TB_NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* Lazy refill from elapsed wall time since the last operation. */
+static void token_bucket_refill(struct token_bucket *tb)
+{
+	uint64_t now = token_bucket_now_ns();
+	uint64_t delta = now - tb->last_ns;
+
+	/* A second's worth of rate always fills a burst-sized bucket;
+	 * short-cutting it also keeps delta * rate from overflowing. */
+	if (delta >= TB_NSEC_PER_SEC) {
+		tb->tokens = tb->burst;
+		tb->last_ns = now;
+		return;
+	}
+
+	tb->tokens += delta * tb->rate / TB_NSEC_PER_SEC;
+	if (tb->tokens > tb->burst)
+		tb->tokens = tb->burst;
+
+	/* Only account time actually converted into tokens, so
+	 * sub-token intervals accumulate instead of rounding away. */
+	if (tb->rate)
+		tb->last_ns = now - (delta * tb->rate % TB_NSEC_PER_SEC)
+					    / tb->rate;
+	else
+		tb->last_ns = now;
+}
+
+void token_bucket_init(struct token_bucket *tb, uint64_t rate, uint64_t burst)
+{
+	tb->rate = rate;
+	tb->burst = burst ? burst : rate;
+	tb->tokens = tb->burst;
+	tb->last_ns = token_bucket_now_ns();
+}
+
+bool token_bucket_consume(struct token_bucket *tb, uint64_t num)
+{
+	if (!tb->rate)
+		return true;
+
+	token_bucket_refill(tb);
+
+	if (tb->tokens < num) {
+		tb->tokens = 0;
+		return false;
+	}
+
+	tb->tokens -= num;
+	return true;
+}
+
+uint64_t token_bucket_take(struct token_bucket *tb, uint64_t max)
+{
+	uint64_t taken;
+
+	if (!tb->rate)
+		return max;
+
+	token_bucket_refill(tb);
+
+	taken = (tb->tokens < max) ? tb->tokens : max;
+	tb->tokens -= taken;
+	return taken;
+}
+
+void token_bucket_credit(struct token_bucket *tb, uint64_t num)
+{
+	if (!tb->rate)
+		return;
+
+	tb->tokens += num;
+	if (tb->tokens > tb->burst)
+		tb->tokens = tb->burst;
+}
+
+uint64_t token_bucket_wait_msec(struct token_bucket *tb, uint64_t num)
+{
+	uint64_t deficit;
+
+	if (!tb->rate)
+		return 0;
+
+	token_bucket_refill(tb);
+
+	if (tb->tokens >= num)
+		return 0;
+
+	deficit = num - tb->tokens;
+	/* round up; a zero wait would busy-loop the caller */
+	return (deficit * 1000 + tb->rate - 1) / tb->rate + 1;
+}
@@ -0,0 +1,82 @@
+/*
+ * Token bucket rate limiter.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _ZEBRA_TOKENBUCKET_H
+#define _ZEBRA_TOKENBUCKET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Classic token bucket, refilled lazily with nanosecond resolution on
+ * each operation.  The struct is meant to be embedded in per-consumer
+ * state (one zserv client, one bgp peer, ...) and touched only by the
+ * thread that owns that consumer; there is no locking and none is
+ * needed.
+ *
+ * rate is tokens per second, burst the bucket depth.  A rate of zero
+ * means "unlimited": consume always succeeds.
+ */
+struct token_bucket {
+	uint64_t rate;
+	uint64_t burst;
+	uint64_t tokens;
+	uint64_t last_ns; /* CLOCK_MONOTONIC of the last refill */
+};
+
+/*
+ * (Re)initialize a bucket; it starts full.  rate of zero disables
+ * limiting.
+ */
+extern void token_bucket_init(struct token_bucket *tb, uint64_t rate,
+			      uint64_t burst);
+
+/*
+ * Take num tokens.  Returns true and consumes them if available; on a
+ * shortfall the bucket is drained to zero and false is returned, so a
+ * caller charging work already done cannot run a persistent surplus.
+ */
+extern bool token_bucket_consume(struct token_bucket *tb, uint64_t num);
+
+/*
+ * Take as many tokens as available, capped at max; returns the number
+ * taken.  Unused tokens can be handed back with token_bucket_credit().
+ */
+extern uint64_t token_bucket_take(struct token_bucket *tb, uint64_t max);
+
+/*
+ * Return previously taken tokens, clamped at the burst depth.
+ */
+extern void token_bucket_credit(struct token_bucket *tb, uint64_t num);
+
+/*
+ * Milliseconds until num tokens accumulate; 0 when they are already
+ * available.  Useful as a retry timer interval after consume failed.
+ */
+extern uint64_t token_bucket_wait_msec(struct token_bucket *tb, uint64_t num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ZEBRA_TOKENBUCKET_H */
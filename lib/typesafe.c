@@ -0,0 +1,166 @@
+/*
+ * Shared helpers for the intrusive typesafe containers in typesafe.h.
+ * Copyright (C) 2019  FRRouting contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <zebra.h>
+
+#include "typesafe.h"
+#include "memory.h"
+
+DEFINE_MTYPE_STATIC(LIB, TYPEDHASH_BUCKET, "Typed-hash bucket array")
+DEFINE_MTYPE_STATIC(LIB, HEAP_ARRAY, "Typed-heap array")
+
+void typesafe_list_add(struct slist_head *head, struct slist_item **pos,
+		       struct slist_item *item)
+{
+	item->next = *pos;
+	*pos = item;
+	if (pos == head->last_next)
+		head->last_next = &item->next;
+	head->count++;
+}
+
+void typesafe_dlist_add(struct dlist_head *head, struct dlist_item *prev,
+			struct dlist_item *item)
+{
+	item->next = prev->next;
+	item->next->prev = item;
+	item->prev = prev;
+	prev->next = item;
+	head->count++;
+}
+
+#define TYPESAFE_HASH_MINSHIFT	3
+#define TYPESAFE_HASH_MAXSHIFT	31
+
+/* rehash buckets from one array into another.  entries within a bucket
+ * are already ordered by full hash value, so each old bucket splits (or
+ * merges) into destination buckets without any re-sorting.
+ */
+static void typesafe_hash_rehash(struct thash_head *head,
+				 struct thash_item **oentries, uint32_t osize)
+{
+	uint32_t i;
+
+	for (i = 0; i < osize; i++) {
+		struct thash_item *item, *next;
+
+		for (item = oentries[i]; item; item = next) {
+			struct thash_item **np;
+
+			next = item->next;
+			np = &head->entries[_HASH_KEY(head->tabshift,
+						      item->hashval)];
+			while (*np && (*np)->hashval < item->hashval)
+				np = &(*np)->next;
+			item->next = *np;
+			*np = item;
+		}
+	}
+}
+
+static void typesafe_hash_resize(struct thash_head *head, uint8_t newshift)
+{
+	struct thash_item **oentries = head->entries;
+	uint32_t osize = _HASH_SIZE(head->tabshift);
+
+	if (newshift == head->tabshift)
+		return;
+
+	head->entries = XCALLOC(MTYPE_TYPEDHASH_BUCKET,
+				sizeof(head->entries[0])
+					* _HASH_SIZE(newshift));
+	head->tabshift = newshift;
+	if (oentries) {
+		typesafe_hash_rehash(head, oentries, osize);
+		XFREE(MTYPE_TYPEDHASH_BUCKET, oentries);
+	}
+}
+
+void typesafe_hash_grow(struct thash_head *head)
+{
+	uint8_t newshift;
+
+	if (!head->tabshift)
+		newshift = head->minshift ? head->minshift
+					  : TYPESAFE_HASH_MINSHIFT + 1;
+	else
+		newshift = head->tabshift + 1;
+
+	if (head->maxshift && newshift > head->maxshift + 1)
+		newshift = head->maxshift + 1;
+	if (newshift > TYPESAFE_HASH_MAXSHIFT)
+		newshift = TYPESAFE_HASH_MAXSHIFT;
+
+	typesafe_hash_resize(head, newshift);
+}
+
+void typesafe_hash_shrink(struct thash_head *head)
+{
+	uint8_t newshift;
+
+	if (!head->count && !head->minshift) {
+		if (head->entries)
+			XFREE(MTYPE_TYPEDHASH_BUCKET, head->entries);
+		head->entries = NULL;
+		head->tabshift = 0;
+		return;
+	}
+
+	if (head->tabshift <= TYPESAFE_HASH_MINSHIFT + 1)
+		return;
+	newshift = head->tabshift - 1;
+	if (head->minshift && newshift < head->minshift)
+		newshift = head->minshift;
+	if (newshift <= TYPESAFE_HASH_MINSHIFT)
+		newshift = TYPESAFE_HASH_MINSHIFT + 1;
+
+	typesafe_hash_resize(head, newshift);
+}
+
+void typesafe_heap_resize(struct heap_head *head, bool grow)
+{
+	uint32_t newsz;
+
+	if (grow) {
+		newsz = head->arraysz ? head->arraysz * 2 : 32;
+	} else {
+		if (!head->count) {
+			if (head->array)
+				XFREE(MTYPE_HEAP_ARRAY, head->array);
+			head->array = NULL;
+			head->arraysz = 0;
+			return;
+		}
+		newsz = head->arraysz / 2;
+		if (newsz < head->count + 1)
+			newsz = head->count + 1;
+		if (newsz < 32)
+			newsz = 32;
+		if (newsz >= head->arraysz)
+			return;
+	}
+
+	head->array = XREALLOC(MTYPE_HEAP_ARRAY, head->array,
+			       sizeof(head->array[0]) * newsz);
+	head->arraysz = newsz;
+}
@@ -0,0 +1,738 @@
+/*
+ * Intrusive typesafe container macros: lists, sorted lists, heap, hash.
+ * Copyright (C) 2019  FRRouting contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_TYPESAFE_H
+#define _FRR_TYPESAFE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include "compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Intrusive containers.  Unlike lib/linklist.c, the linkage lives inside
+ * the item itself (a small struct embedded as a member), so membership
+ * costs no allocation and iteration does not chase a separate node.
+ *
+ * Usage:
+ *   PREDECL_LIST(quux)                  -- in the header, near the structs
+ *   struct item { ...; struct quux_item itm; ... };
+ *   DECLARE_LIST(quux, struct item, itm)
+ *
+ * This generates quux_init, _fini, _add_head/_add_tail (_add for sorted
+ * variants), _del, _pop, _first, _next, _next_safe and _count
+ * as inline functions.  Iterate with:
+ *   frr_each (quux, &head, item) ...
+ *   frr_each_safe (quux, &head, item) ...   (current item may be deleted)
+ *
+ * An item must be on at most one list of a given type at a time.  Putting
+ * an item on several *different* list types just needs one embedded
+ * linkage member per type.
+ */
+
+#ifndef macro_inline
+#define macro_inline	static inline __attribute__((unused))
+#endif
+#ifndef macro_pure
+#define macro_pure	static inline __attribute__((unused, pure))
+#endif
+
+/* generic iteration; prefix is the PREDECL/DECLARE name */
+#define frr_each(prefix, head, item)                                           \
+	for (item = prefix##_first(head); item;                                \
+	     item = prefix##_next(head, item))
+#define frr_each_safe(prefix, head, item)                                      \
+	for (typeof(prefix##_next_safe(head, NULL))                            \
+			prefix##_safe = prefix##_first(head);                  \
+	     (item = prefix##_safe)                                            \
+		     && (prefix##_safe = prefix##_next_safe(head, item), 1);)
+
+/* single-linked list, unsorted, with tail pointer => O(1) add_tail */
+
+struct slist_item {
+	struct slist_item *next;
+};
+
+struct slist_head {
+	struct slist_item *first, **last_next;
+	size_t count;
+};
+
+extern void typesafe_list_add(struct slist_head *head,
+			      struct slist_item **pos,
+			      struct slist_item *item);
+
+#define PREDECL_LIST(prefix)                                                   \
+struct prefix ## _head { struct slist_head sh; };                              \
+struct prefix ## _item { struct slist_item si; };
+
+#define INIT_LIST(var) { .sh = { .last_next = &var.sh.first, }, }
+
+#define DECLARE_LIST(prefix, type, field)                                      \
+                                                                               \
+macro_inline void prefix ## _init(struct prefix##_head *h)                     \
+{                                                                              \
+	memset(h, 0, sizeof(*h));                                              \
+	h->sh.last_next = &h->sh.first;                                        \
+}                                                                              \
+macro_inline void prefix ## _fini(struct prefix##_head *h)                     \
+{                                                                              \
+	memset(h, 0, sizeof(*h));                                              \
+}                                                                              \
+macro_inline void prefix ## _add_head(struct prefix##_head *h, type *item)     \
+{                                                                              \
+	typesafe_list_add(&h->sh, &h->sh.first, &item->field.si);              \
+}                                                                              \
+macro_inline void prefix ## _add_tail(struct prefix##_head *h, type *item)     \
+{                                                                              \
+	typesafe_list_add(&h->sh, h->sh.last_next, &item->field.si);           \
+}                                                                              \
+macro_inline void prefix ## _add_after(struct prefix##_head *h,                \
+		type *after, type *item)                                       \
+{                                                                              \
+	struct slist_item **nextp;                                             \
+	nextp = after ? &after->field.si.next : &h->sh.first;                  \
+	typesafe_list_add(&h->sh, nextp, &item->field.si);                     \
+}                                                                              \
+/* TODO: del_hint */                                                           \
+macro_inline type *prefix ## _del(struct prefix##_head *h, type *item)         \
+{                                                                              \
+	struct slist_item **iter = &h->sh.first;                               \
+	while (*iter && *iter != &item->field.si)                              \
+		iter = &(*iter)->next;                                         \
+	if (!*iter)                                                            \
+		return NULL;                                                   \
+	h->sh.count--;                                                         \
+	*iter = item->field.si.next;                                           \
+	if (!item->field.si.next)                                              \
+		h->sh.last_next = iter;                                        \
+	return item;                                                           \
+}                                                                              \
+macro_inline type *prefix ## _pop(struct prefix##_head *h)                     \
+{                                                                              \
+	struct slist_item *sitem = h->sh.first;                                \
+	if (!sitem)                                                            \
+		return NULL;                                                   \
+	h->sh.count--;                                                         \
+	h->sh.first = sitem->next;                                             \
+	if (h->sh.first == NULL)                                               \
+		h->sh.last_next = &h->sh.first;                                \
+	return container_of(sitem, type, field.si);                            \
+}                                                                              \
+macro_pure type *prefix ## _first(struct prefix##_head *h)                     \
+{                                                                              \
+	return container_of_null(h->sh.first, type, field.si);                 \
+}                                                                              \
+macro_pure type *prefix ## _next(struct prefix##_head * h, type *item)         \
+{                                                                              \
+	struct slist_item *sitem = &item->field.si;                            \
+	return container_of_null(sitem->next, type, field.si);                 \
+}                                                                              \
+macro_inline type *prefix ## _next_safe(struct prefix##_head *h, type *item)   \
+{                                                                              \
+	struct slist_item *sitem;                                              \
+	if (!item)                                                             \
+		return NULL;                                                   \
+	sitem = &item->field.si;                                               \
+	return container_of_null(sitem->next, type, field.si);                 \
+}                                                                              \
+macro_pure size_t prefix ## _count(struct prefix##_head *h)                    \
+{                                                                              \
+	return h->sh.count;                                                    \
+}                                                                              \
+/* ... */
+
+/* don't use these outside of this file */
+#ifndef container_of_null
+#define container_of_null(ptr, type, member)                                   \
+	({                                                                     \
+		typeof(ptr) _tmp = (ptr);                                      \
+		_tmp ? container_of(_tmp, type, member) : NULL;                \
+	})
+#endif
+
+/* double-linked list, for fast item deletion */
+
+struct dlist_item {
+	struct dlist_item *next, *prev;
+};
+
+struct dlist_head {
+	struct dlist_item hitem;
+	size_t count;
+};
+
+extern void typesafe_dlist_add(struct dlist_head *head,
+			       struct dlist_item *prev,
+			       struct dlist_item *item);
+
+#define PREDECL_DLIST(prefix)                                                  \
+struct prefix ## _head { struct dlist_head dh; };                              \
+struct prefix ## _item { struct dlist_item di; };
+
+#define INIT_DLIST(var) { .dh = { \
+	.hitem = { &var.dh.hitem, &var.dh.hitem }, }, }
+
+#define DECLARE_DLIST(prefix, type, field)                                     \
+                                                                               \
+macro_inline void prefix ## _init(struct prefix##_head *h)                     \
+{                                                                              \
+	memset(h, 0, sizeof(*h));                                              \
+	h->dh.hitem.prev = &h->dh.hitem;                                       \
+	h->dh.hitem.next = &h->dh.hitem;                                       \
+}                                                                              \
+macro_inline void prefix ## _fini(struct prefix##_head *h)                     \
+{                                                                              \
+	memset(h, 0, sizeof(*h));                                              \
+}                                                                              \
+macro_inline void prefix ## _add_head(struct prefix##_head *h, type *item)     \
+{                                                                              \
+	typesafe_dlist_add(&h->dh, &h->dh.hitem, &item->field.di);             \
+}                                                                              \
+macro_inline void prefix ## _add_tail(struct prefix##_head *h, type *item)     \
+{                                                                              \
+	typesafe_dlist_add(&h->dh, h->dh.hitem.prev, &item->field.di);         \
+}                                                                              \
+macro_inline void prefix ## _add_after(struct prefix##_head *h,                \
+		type *after, type *item)                                       \
+{                                                                              \
+	struct dlist_item *prev;                                               \
+	prev = after ? &after->field.di : &h->dh.hitem;                        \
+	typesafe_dlist_add(&h->dh, prev, &item->field.di);                     \
+}                                                                              \
+macro_inline type *prefix ## _del(struct prefix##_head *h, type *item)         \
+{                                                                              \
+	struct dlist_item *ditem = &item->field.di;                            \
+	ditem->prev->next = ditem->next;                                       \
+	ditem->next->prev = ditem->prev;                                       \
+	h->dh.count--;                                                         \
+	ditem->prev = ditem->next = NULL;                                      \
+	return item;                                                           \
+}                                                                              \
+macro_inline type *prefix ## _pop(struct prefix##_head *h)                     \
+{                                                                              \
+	struct dlist_item *ditem = h->dh.hitem.next;                           \
+	if (ditem == &h->dh.hitem)                                             \
+		return NULL;                                                   \
+	ditem->prev->next = ditem->next;                                       \
+	ditem->next->prev = ditem->prev;                                       \
+	h->dh.count--;                                                         \
+	ditem->prev = ditem->next = NULL;                                      \
+	return container_of(ditem, type, field.di);                            \
+}                                                                              \
+macro_pure type *prefix ## _first(struct prefix##_head *h)                     \
+{                                                                              \
+	struct dlist_item *ditem = h->dh.hitem.next;                           \
+	if (ditem == &h->dh.hitem)                                             \
+		return NULL;                                                   \
+	return container_of(ditem, type, field.di);                            \
+}                                                                              \
+macro_pure type *prefix ## _next(struct prefix##_head *h, type *item)          \
+{                                                                              \
+	struct dlist_item *ditem = &item->field.di;                            \
+	if (ditem->next == &h->dh.hitem)                                       \
+		return NULL;                                                   \
+	return container_of(ditem->next, type, field.di);                      \
+}                                                                              \
+macro_inline type *prefix ## _next_safe(struct prefix##_head *h, type *item)   \
+{                                                                              \
+	if (!item)                                                             \
+		return NULL;                                                   \
+	return prefix ## _next(h, item);                                       \
+}                                                                              \
+macro_pure size_t prefix ## _count(struct prefix##_head *h)                    \
+{                                                                              \
+	return h->dh.count;                                                    \
+}                                                                              \
+/* ... */
+
+/* single-linked list, sorted.
+ * can be used as priority queue with add / pop
+ */
+
+struct ssort_item {
+	struct ssort_item *next;
+};
+
+struct ssort_head {
+	struct ssort_item *first;
+	size_t count;
+};
+
+/* use as:
+ *
+ * PREDECL_SORTLIST_UNIQ(namelist)
+ * struct name {
+ *   struct namelist_item nlitem;
+ *   const char *name;
+ * };
+ * DECLARE_SORTLIST_UNIQ(namelist, struct name, nlitem, strcmp)
+ *
+ * Note: the cmp function can be called with either item as first arg,
+ * give consistent results.
+ */
+#define _PREDECL_SORTLIST(prefix)                                              \
+struct prefix ## _head { struct ssort_head sh; };                              \
+struct prefix ## _item { struct ssort_item si; };
+
+#define INIT_SORTLIST_UNIQ(var)		{ }
+#define INIT_SORTLIST_NONUNIQ(var)	{ }
+
+#define PREDECL_SORTLIST_UNIQ(prefix)                                          \
+	_PREDECL_SORTLIST(prefix)
+#define PREDECL_SORTLIST_NONUNIQ(prefix)                                       \
+	_PREDECL_SORTLIST(prefix)
+
+#define _DECLARE_SORTLIST(prefix, type, field, cmpfn_nuq, cmpfn_uq)            \
+                                                                               \
+macro_inline void prefix ## _init(struct prefix##_head *h)                     \
+{                                                                              \
+	memset(h, 0, sizeof(*h));                                              \
+}                                                                              \
+macro_inline void prefix ## _fini(struct prefix##_head *h)                     \
+{                                                                              \
+	memset(h, 0, sizeof(*h));                                              \
+}                                                                              \
+macro_inline type *prefix ## _add(struct prefix##_head *h, type *item)         \
+{                                                                              \
+	struct ssort_item **np = &h->sh.first;                                 \
+	int c = 1;                                                             \
+	while (*np && (c = cmpfn_uq(                                           \
+			container_of(*np, type, field.si), item)) < 0)         \
+		np = &(*np)->next;                                             \
+	if (c == 0)                                                            \
+		return container_of(*np, type, field.si);                      \
+	item->field.si.next = *np;                                             \
+	*np = &item->field.si;                                                 \
+	h->sh.count++;                                                         \
+	return NULL;                                                           \
+}                                                                              \
+macro_inline type *prefix ## _find_gteq(struct prefix##_head *h,               \
+		const type *item)                                              \
+{                                                                              \
+	struct ssort_item *sitem = h->sh.first;                                \
+	int cmpval = 0;                                                        \
+	while (sitem && (cmpval = cmpfn_nuq(                                   \
+			container_of(sitem, type, field.si), item)) < 0)       \
+		sitem = sitem->next;                                           \
+	return container_of_null(sitem, type, field.si);                       \
+}                                                                              \
+macro_inline type *prefix ## _find_lt(struct prefix##_head *h,                 \
+		const type *item)                                              \
+{                                                                              \
+	struct ssort_item *prev = NULL, *sitem = h->sh.first;                  \
+	int cmpval = 0;                                                        \
+	while (sitem && (cmpval = cmpfn_nuq(                                   \
+			container_of(sitem, type, field.si), item)) < 0)       \
+		sitem = (prev = sitem)->next;                                  \
+	return container_of_null(prev, type, field.si);                        \
+}                                                                              \
+/* TODO: del_hint */                                                           \
+macro_inline type *prefix ## _del(struct prefix##_head *h, type *item)         \
+{                                                                              \
+	struct ssort_item **iter = &h->sh.first;                               \
+	while (*iter && *iter != &item->field.si)                              \
+		iter = &(*iter)->next;                                         \
+	if (!*iter)                                                            \
+		return NULL;                                                   \
+	h->sh.count--;                                                         \
+	*iter = item->field.si.next;                                           \
+	return item;                                                           \
+}                                                                              \
+macro_inline type *prefix ## _pop(struct prefix##_head *h)                     \
+{                                                                              \
+	struct ssort_item *sitem = h->sh.first;                                \
+	if (!sitem)                                                            \
+		return NULL;                                                   \
+	h->sh.count--;                                                         \
+	h->sh.first = sitem->next;                                             \
+	return container_of(sitem, type, field.si);                            \
+}                                                                              \
+macro_pure type *prefix ## _first(struct prefix##_head *h)                     \
+{                                                                              \
+	return container_of_null(h->sh.first, type, field.si);                 \
+}                                                                              \
+macro_pure type *prefix ## _next(struct prefix##_head *h, type *item)          \
+{                                                                              \
+	struct ssort_item *sitem = &item->field.si;                            \
+	return container_of_null(sitem->next, type, field.si);                 \
+}                                                                              \
+macro_inline type *prefix ## _next_safe(struct prefix##_head *h, type *item)   \
+{                                                                              \
+	struct ssort_item *sitem;                                              \
+	if (!item)                                                             \
+		return NULL;                                                   \
+	sitem = &item->field.si;                                               \
+	return container_of_null(sitem->next, type, field.si);                 \
+}                                                                              \
+macro_pure size_t prefix ## _count(struct prefix##_head *h)                    \
+{                                                                              \
+	return h->sh.count;                                                    \
+}                                                                              \
+/* ... */
+
+#define DECLARE_SORTLIST_UNIQ(prefix, type, field, cmpfn)                      \
+	_DECLARE_SORTLIST(prefix, type, field, cmpfn, cmpfn)                   \
+                                                                               \
+macro_inline type *prefix ## _find(struct prefix##_head *h, const type *item)  \
+{                                                                              \
+	struct ssort_item *sitem = h->sh.first;                                \
+	int cmpval = 0;                                                        \
+	while (sitem && (cmpval = cmpfn(                                       \
+			container_of(sitem, type, field.si), item)) < 0)       \
+		sitem = sitem->next;                                           \
+	if (!sitem || cmpval > 0)                                              \
+		return NULL;                                                   \
+	return container_of(sitem, type, field.si);                            \
+}                                                                              \
+/* ... */
+
+#define DECLARE_SORTLIST_NONUNIQ(prefix, type, field, cmpfn)                   \
+macro_inline int _ ## prefix ## _cmp(const type *a, const type *b)             \
+{                                                                              \
+	int cmpval = cmpfn(a, b);                                              \
+	if (cmpval)                                                            \
+		return cmpval;                                                 \
+	if (a < b)                                                             \
+		return -1;                                                     \
+	if (a > b)                                                             \
+		return 1;                                                      \
+	return 0;                                                              \
+}                                                                              \
+	_DECLARE_SORTLIST(prefix, type, field, cmpfn, _ ## prefix ## _cmp)     \
+/* ... */
+
+/* hash, "sorted" by hash value */
+
+struct thash_item {
+	struct thash_item *next;
+	uint32_t hashval;
+};
+
+struct thash_head {
+	struct thash_item **entries;
+	uint32_t count;
+
+	uint8_t tabshift;
+	uint8_t minshift, maxshift;
+};
+
+#define _HASH_SIZE(tabshift)                                                   \
+	((1U << (tabshift)) >> 1)
+#define HASH_SIZE(head)                                                        \
+	_HASH_SIZE((head).tabshift)
+#define _HASH_KEY(tabshift, val)                                               \
+	((val) >> (33 - (tabshift)))
+#define HASH_KEY(head, val)                                                    \
+	_HASH_KEY((head).tabshift, val)
+/* named with a TH_ prefix to stay clear of the thresholds in lib/hash.h */
+#define TH_GROW_THRESHOLD(head)                                                \
+	((head).count >= HASH_SIZE(head))
+#define TH_SHRINK_THRESHOLD(head)                                              \
+	((head).count <= (HASH_SIZE(head) - 1) / 2)
+
+extern void typesafe_hash_grow(struct thash_head *head);
+extern void typesafe_hash_shrink(struct thash_head *head);
+
+/* use as:
+ *
+ * PREDECL_HASH(itemhash)
+ * struct item {
+ *   struct itemhash_item hitm;
+ *   ...
+ * };
+ * DECLARE_HASH(itemhash, struct item, hitm, cmpfn, hashfn)
+ */
+#define PREDECL_HASH(prefix)                                                   \
+struct prefix ## _head { struct thash_head hh; };                              \
+struct prefix ## _item { struct thash_item hi; };
+
+#define INIT_HASH(var)	{ }
+
+#define DECLARE_HASH(prefix, type, field, cmpfn, hashfn)                       \
+                                                                               \
+macro_inline void prefix ## _init(struct prefix##_head *h)                     \
+{                                                                              \
+	memset(h, 0, sizeof(*h));                                              \
+	h->hh.minshift = 0;                                                    \
+	h->hh.maxshift = 0;                                                    \
+}                                                                              \
+macro_inline void prefix ## _fini(struct prefix##_head *h)                     \
+{                                                                              \
+	assert(h->hh.count == 0);                                              \
+	h->hh.minshift = 0;                                                    \
+	typesafe_hash_shrink(&h->hh);                                          \
+	memset(h, 0, sizeof(*h));                                              \
+}                                                                              \
+macro_inline type *prefix ## _add(struct prefix##_head *h, type *item)         \
+{                                                                              \
+	uint32_t hval = hashfn(item), hbits;                                   \
+	item->field.hi.hashval = hval;                                         \
+	if (!h->hh.tabshift || TH_GROW_THRESHOLD(h->hh))                       \
+		typesafe_hash_grow(&h->hh);                                    \
+	hbits = HASH_KEY(h->hh, hval);                                         \
+	struct thash_item **np = &h->hh.entries[hbits];                        \
+	while (*np && (*np)->hashval < hval)                                   \
+		np = &(*np)->next;                                             \
+	while (*np && (*np)->hashval == hval) {                                \
+		if (cmpfn(container_of(*np, type, field.hi), item) == 0)       \
+			return container_of(*np, type, field.hi);              \
+		np = &(*np)->next;                                             \
+	}                                                                      \
+	item->field.hi.next = *np;                                             \
+	*np = &item->field.hi;                                                 \
+	h->hh.count++;                                                         \
+	return NULL;                                                           \
+}                                                                              \
+macro_inline type *prefix ## _find(struct prefix##_head *h, const type *item)  \
+{                                                                              \
+	uint32_t hval = hashfn(item);                                          \
+	struct thash_item *hitem;                                              \
+	if (!h->hh.tabshift)                                                   \
+		return NULL;                                                   \
+	hitem = h->hh.entries[HASH_KEY(h->hh, hval)];                          \
+	while (hitem && hitem->hashval < hval)                                 \
+		hitem = hitem->next;                                           \
+	while (hitem && hitem->hashval == hval) {                              \
+		if (!cmpfn(container_of(hitem, type, field.hi), item))         \
+			return container_of(hitem, type, field.hi);            \
+		hitem = hitem->next;                                           \
+	}                                                                      \
+	return NULL;                                                           \
+}                                                                              \
+macro_inline type *prefix ## _del(struct prefix##_head *h, type *item)         \
+{                                                                              \
+	uint32_t hval = item->field.hi.hashval;                                \
+	if (!h->hh.tabshift)                                                   \
+		return NULL;                                                   \
+	struct thash_item **np = &h->hh.entries[HASH_KEY(h->hh, hval)];        \
+	while (*np && (*np)->hashval < hval)                                   \
+		np = &(*np)->next;                                             \
+	while (*np && *np != &item->field.hi && (*np)->hashval == hval)        \
+		np = &(*np)->next;                                             \
+	if (*np != &item->field.hi)                                            \
+		return NULL;                                                   \
+	*np = item->field.hi.next;                                             \
+	item->field.hi.next = NULL;                                            \
+	h->hh.count--;                                                         \
+	if (TH_SHRINK_THRESHOLD(h->hh))                                        \
+		typesafe_hash_shrink(&h->hh);                                  \
+	return item;                                                           \
+}                                                                              \
+macro_inline type *prefix ## _pop(struct prefix##_head *h)                     \
+{                                                                              \
+	uint32_t i;                                                            \
+	for (i = 0; i < HASH_SIZE(h->hh); i++)                                 \
+		if (h->hh.entries[i]) {                                        \
+			struct thash_item *hitem = h->hh.entries[i];           \
+			h->hh.entries[i] = hitem->next;                        \
+			h->hh.count--;                                         \
+			hitem->next = NULL;                                    \
+			if (TH_SHRINK_THRESHOLD(h->hh))                        \
+				typesafe_hash_shrink(&h->hh);                  \
+			return container_of(hitem, type, field.hi);            \
+		}                                                              \
+	return NULL;                                                           \
+}                                                                              \
+macro_pure type *prefix ## _first(struct prefix##_head *h)                     \
+{                                                                              \
+	uint32_t i;                                                            \
+	for (i = 0; i < HASH_SIZE(h->hh); i++)                                 \
+		if (h->hh.entries[i])                                          \
+			return container_of(h->hh.entries[i], type, field.hi); \
+	return NULL;                                                           \
+}                                                                              \
+macro_pure type *prefix ## _next(struct prefix##_head *h, type *item)          \
+{                                                                              \
+	struct thash_item *hitem = &item->field.hi;                            \
+	if (hitem->next)                                                       \
+		return container_of(hitem->next, type, field.hi);              \
+	uint32_t i = HASH_KEY(h->hh, hitem->hashval) + 1;                      \
+	for (; i < HASH_SIZE(h->hh); i++)                                      \
+		if (h->hh.entries[i])                                          \
+			return container_of(h->hh.entries[i], type, field.hi); \
+	return NULL;                                                           \
+}                                                                              \
+macro_inline type *prefix ## _next_safe(struct prefix##_head *h, type *item)   \
+{                                                                              \
+	if (!item)                                                             \
+		return NULL;                                                   \
+	return prefix ## _next(h, item);                                       \
+}                                                                              \
+macro_pure size_t prefix ## _count(struct prefix##_head *h)                    \
+{                                                                              \
+	return h->hh.count;                                                    \
+}                                                                              \
+/* ... */
+
+/* binary heap, for min-item access in O(1) / pop in O(log n).
+ * item position in the array is tracked in the embedded linkage, so
+ * arbitrary deletion is O(log n) too.
+ */
+
+struct heap_item {
+	uint32_t index;
+};
+
+struct heap_head {
+	struct heap_item **array;
+	uint32_t arraysz, count;
+};
+
+#define HEAP_NARY		8U
+#define HEAP_RESIZE_TRESH_UP(h)                                                \
+	(h->hh.count + 1 >= h->hh.arraysz)
+#define HEAP_RESIZE_TRESH_DN(h)                                                \
+	(h->hh.count == 0 ||                                                   \
+	 h->hh.arraysz - h->hh.count > (h->hh.count + 1024) / 2)
+
+extern void typesafe_heap_resize(struct heap_head *head, bool grow);
+
+#define PREDECL_HEAP(prefix)                                                   \
+struct prefix ## _head { struct heap_head hh; };                               \
+struct prefix ## _item { struct heap_item hi; };
+
+#define INIT_HEAP(var)	{ }
+
+#define DECLARE_HEAP(prefix, type, field, cmpfn)                               \
+                                                                               \
+macro_inline void prefix ## _init(struct prefix##_head *h)                     \
+{                                                                              \
+	memset(h, 0, sizeof(*h));                                              \
+}                                                                              \
+macro_inline void prefix ## _fini(struct prefix##_head *h)                     \
+{                                                                              \
+	assert(h->hh.count == 0);                                              \
+	typesafe_heap_resize(&h->hh, false);                                   \
+	memset(h, 0, sizeof(*h));                                              \
+}                                                                              \
+macro_inline int prefix ## __cmp(const struct heap_item *a,                    \
+		const struct heap_item *b)                                     \
+{                                                                              \
+	return cmpfn(container_of(a, type, field.hi),                          \
+			container_of(b, type, field.hi));                      \
+}                                                                              \
+macro_inline void prefix ## __sift_up(struct heap_head *hh, uint32_t i)        \
+{                                                                              \
+	struct heap_item *itm = hh->array[i];                                  \
+	while (i) {                                                            \
+		uint32_t par = (i - 1) / HEAP_NARY;                            \
+		if (prefix ## __cmp(hh->array[par], itm) <= 0)                 \
+			break;                                                 \
+		hh->array[i] = hh->array[par];                                 \
+		hh->array[i]->index = i;                                       \
+		i = par;                                                       \
+	}                                                                      \
+	hh->array[i] = itm;                                                    \
+	itm->index = i;                                                        \
+}                                                                              \
+macro_inline void prefix ## __sift_down(struct heap_head *hh, uint32_t i)      \
+{                                                                              \
+	struct heap_item *itm = hh->array[i];                                  \
+	while (1) {                                                            \
+		uint32_t child = i * HEAP_NARY + 1, best = i, j;               \
+		struct heap_item *bestitm = itm;                               \
+		for (j = child;                                                \
+		     j < child + HEAP_NARY && j < hh->count; j++)              \
+			if (prefix ## __cmp(hh->array[j], bestitm) < 0) {      \
+				best = j;                                      \
+				bestitm = hh->array[j];                        \
+			}                                                      \
+		if (best == i)                                                 \
+			break;                                                 \
+		hh->array[i] = bestitm;                                        \
+		hh->array[i]->index = i;                                       \
+		i = best;                                                      \
+	}                                                                      \
+	hh->array[i] = itm;                                                    \
+	itm->index = i;                                                        \
+}                                                                              \
+macro_inline void prefix ## _add(struct prefix##_head *h, type *item)          \
+{                                                                              \
+	if (HEAP_RESIZE_TRESH_UP(h))                                           \
+		typesafe_heap_resize(&h->hh, true);                            \
+	h->hh.array[h->hh.count] = &item->field.hi;                            \
+	item->field.hi.index = h->hh.count;                                    \
+	h->hh.count++;                                                         \
+	prefix ## __sift_up(&h->hh, item->field.hi.index);                     \
+}                                                                              \
+macro_inline type *prefix ## _del(struct prefix##_head *h, type *item)         \
+{                                                                              \
+	uint32_t i = item->field.hi.index;                                     \
+	h->hh.count--;                                                         \
+	if (i != h->hh.count) {                                                \
+		h->hh.array[i] = h->hh.array[h->hh.count];                     \
+		h->hh.array[i]->index = i;                                     \
+		prefix ## __sift_down(&h->hh, i);                              \
+		prefix ## __sift_up(&h->hh, h->hh.array[i]->index);            \
+	}                                                                      \
+	if (HEAP_RESIZE_TRESH_DN(h))                                           \
+		typesafe_heap_resize(&h->hh, false);                           \
+	return item;                                                           \
+}                                                                              \
+macro_inline type *prefix ## _pop(struct prefix##_head *h)                     \
+{                                                                              \
+	if (!h->hh.count)                                                      \
+		return NULL;                                                   \
+	struct heap_item *hitem = h->hh.array[0];                              \
+	h->hh.count--;                                                         \
+	if (h->hh.count) {                                                     \
+		h->hh.array[0] = h->hh.array[h->hh.count];                     \
+		h->hh.array[0]->index = 0;                                     \
+		prefix ## __sift_down(&h->hh, 0);                              \
+	}                                                                      \
+	if (HEAP_RESIZE_TRESH_DN(h))                                           \
+		typesafe_heap_resize(&h->hh, false);                           \
+	return container_of(hitem, type, field.hi);                            \
+}                                                                              \
+macro_pure type *prefix ## _first(struct prefix##_head *h)                     \
+{                                                                              \
+	if (!h->hh.count)                                                      \
+		return NULL;                                                   \
+	return container_of(h->hh.array[0], type, field.hi);                   \
+}                                                                              \
+macro_pure type *prefix ## _next(struct prefix##_head *h, type *item)          \
+{                                                                              \
+	uint32_t i = item->field.hi.index + 1;                                 \
+	if (i >= h->hh.count)                                                  \
+		return NULL;                                                   \
+	return container_of(h->hh.array[i], type, field.hi);                   \
+}                                                                              \
+macro_inline type *prefix ## _next_safe(struct prefix##_head *h, type *item)   \
+{                                                                              \
+	if (!item)                                                             \
+		return NULL;                                                   \
+	return prefix ## _next(h, item);                                       \
+}                                                                              \
+macro_pure size_t prefix ## _count(struct prefix##_head *h)                    \
+{                                                                              \
+	return h->hh.count;                                                    \
+}                                                                              \
+/* ... */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_TYPESAFE_H */
@@ -83,6 +83,13 @@ struct vrf {
 	struct if_name_head ifaces_by_name;
 	struct if_index_head ifaces_by_index;
 
+	/* Direct-mapped mirror of ifaces_by_index so resolution by
+	 * ifindex is an array load; sparse, pages allocated only for
+	 * populated index ranges.  Maintained in lib/if.c alongside
+	 * the RB tree. */
+	struct interface ***if_index_pages;
+	uint32_t if_index_npages;
+
 	/* User data */
 	void *info;
 
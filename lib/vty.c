@@ -23,6 +23,7 @@
 
 #include <lib/version.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <regex.h>
 #include <stdio.h>
 
@@ -59,11 +60,18 @@ enum event {
 #ifdef VTYSH
 	VTYSH_SERV,
 	VTYSH_READ,
-	VTYSH_WRITE
+	VTYSH_WRITE,
+	VTYSH_RESUME
 #endif /* VTYSH */
 };
 
 static void vty_event(enum event, int, struct vty *);
+#ifdef VTYSH
+static int vtysh_flush(struct vty *vty);
+#endif /* VTYSH */
+
+/* Master of the threads. */
+static struct thread_master *vty_master;
 
 /* Extern host structure from command.c */
 extern struct host host;
@@ -97,6 +105,11 @@ char integrate_default[] = SYSCONFDIR INTEGRATE_DEFAULT_CONFIG;
 
 static int do_log_commands = 0;
 
+/* "service fork-read": render large show commands in a forked child
+ * working from a copy-on-write snapshot, bounding the impact on the
+ * main process to the cost of the fork itself. */
+static bool vty_fork_read;
+
 void vty_frame(struct vty *vty, const char *format, ...)
 {
 	va_list args;
@@ -271,6 +284,68 @@ done:
 	return len;
 }
 
+/* Hand accumulated output to the session mid-command.
+ *
+ * Table-scale show commands can emit many megabytes; normally all of it
+ * sits in vty->obuf until the command returns.  Callers that produce
+ * output incrementally may invoke this every so often to keep the peak
+ * obuf footprint flat.  If the peer is slow we wait for the socket to
+ * drain rather than keep buffering.
+ *
+ * Only file and vtysh sessions are drained here; interactive terminals
+ * keep their usual buffered behavior so that width/lines flow control
+ * (see vty_flush) is not bypassed.  Write errors are left for the
+ * end-of-command flush, which owns closing the session.
+ */
+void vty_out_flush(struct vty *vty)
+{
+	if (vty->type != VTY_SHELL_SERV && vty->type != VTY_FILE)
+		return;
+
+	while (buffer_flush_available(vty->obuf, vty->wfd) == BUFFER_PENDING) {
+		struct pollfd pfd = {.fd = vty->wfd, .events = POLLOUT};
+
+		if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+			break;
+	}
+}
+
+/* Suspend the running command and hand control back to the event loop.
+ *
+ * A command producing table-scale output stashes its walk state in "arg"
+ * and returns the value of this function.  "cont" is then invoked every
+ * time the output buffer has drained to the peer; it emits the next
+ * chunk through vty_out() and either returns CMD_SUSPEND to be called
+ * again or a final CMD_* code, which is reported to the peer exactly as
+ * if the command had produced everything in one pass.  The continuation
+ * owns "arg" and must release it before finishing; if the session dies
+ * mid-walk, "cancel" is called instead so locks and allocations held in
+ * "arg" are not leaked.
+ *
+ * Only vtysh sessions have the event-driven writer (the vtysh protocol
+ * already defers the result header until the command completes); on
+ * other vty types the continuation is simply run to completion in
+ * place, so consumers need not care what kind of session they serve. */
+int vty_yield(struct vty *vty, int (*cont)(struct vty *vty, void *arg),
+	      void (*cancel)(struct vty *vty, void *arg), void *arg)
+{
+	int ret;
+
+	/* A fork-read child has no event loop, so it too runs the
+	 * continuation inline. */
+	if (vty->type != VTY_SHELL_SERV || vty->fork_child) {
+		do
+			ret = (*cont)(vty, arg);
+		while (ret == CMD_SUSPEND);
+		return ret;
+	}
+
+	vty->yield_cont = cont;
+	vty->yield_cancel = cancel;
+	vty->yield_arg = arg;
+	return CMD_SUSPEND;
+}
+
 static int vty_log_out(struct vty *vty, const char *level,
 		       const char *proto_str, const char *format,
 		       struct timestamp_control *ctl, va_list va)
@@ -475,10 +550,151 @@ static void vty_auth(struct vty *vty, char *buf)
 }
 
 /* Command execution over the vty interface. */
+/* Turn a parse/execution failure into the conventional message. */
+static void vty_report_cmd_result(struct vty *vty, int ret, const char *buf)
+{
+	switch (ret) {
+	case CMD_WARNING:
+		if (vty->type == VTY_FILE)
+			vty_out(vty, "Warning...\n");
+		break;
+	case CMD_ERR_AMBIGUOUS:
+		vty_out(vty, "%% Ambiguous command.\n");
+		break;
+	case CMD_ERR_NO_MATCH:
+		vty_out(vty, "%% [%s] Unknown command: %s\n", frr_protoname,
+			buf);
+		break;
+	case CMD_ERR_INCOMPLETE:
+		vty_out(vty, "%% Command incomplete.\n");
+		break;
+	}
+}
+
+#ifdef VTYSH
+/*
+ * True if this command should be rendered by a forked child: opt-in via
+ * "service fork-read", vtysh sessions only (their protocol already
+ * defers the result header until the command completes), and only show
+ * commands - anything else must see and mutate live state.
+ */
+static bool vty_fork_read_candidate(struct vty *vty, const char *buf)
+{
+	if (!vty_fork_read || vty->type != VTY_SHELL_SERV)
+		return false;
+
+	if (vty->node != VIEW_NODE && vty->node != ENABLE_NODE)
+		return false;
+
+	/* one pending command per session */
+	if (vty->t_fork || vty->yield_cont)
+		return false;
+
+	while (isspace((int)*buf))
+		buf++;
+
+	return strncmp(buf, "show ", 5) == 0;
+}
+
+/* The forked child has exited: everything it rendered is already in the
+ * session socket, so reap it and send the deferred result header the
+ * same way vtysh_yield_continue() does. */
+static int vty_fork_done(struct thread *thread)
+{
+	struct vty *vty = THREAD_ARG(thread);
+	uint8_t header[4] = {0, 0, 0, 0};
+	uint8_t result = CMD_SUCCESS;
+
+	vty->t_fork = NULL;
+
+	/* the child's last word is its CMD_* result; EOF means it died
+	 * before finishing and warrants a warning code */
+	if (read(vty->fork_wait_fd, &result, 1) != 1)
+		result = CMD_WARNING;
+
+	close(vty->fork_wait_fd);
+	vty->fork_wait_fd = -1;
+	waitpid(vty->fork_pid, NULL, 0);
+	vty->fork_pid = 0;
+
+	/* warning: watchfrr hardcodes this result write */
+	header[3] = result;
+	buffer_put(vty->obuf, header, 4);
+
+	if (!vty->t_write)
+		vtysh_flush(vty);
+	return 0;
+}
+
+/*
+ * Render "buf" in a forked child.  The child inherits a copy-on-write
+ * snapshot of the whole daemon, so it can walk tables at leisure
+ * without competing with the parent for anything but memory bandwidth;
+ * it pushes the output down the session socket synchronously and exits.
+ * Returns CMD_SUSPEND on success - the result header is deferred until
+ * the child is done - or -1 if the fork failed and the caller should
+ * render in-process.
+ */
+static int vty_command_fork(struct vty *vty, char *buf)
+{
+	int waitpipe[2];
+	pid_t pid;
+
+	if (pipe(waitpipe) < 0)
+		return -1;
+
+	pid = fork();
+	if (pid < 0) {
+		close(waitpipe[0]);
+		close(waitpipe[1]);
+		return -1;
+	}
+
+	if (pid == 0) {
+		uint8_t result;
+
+		close(waitpipe[0]);
+
+		/* no event loop here - vty_yield() must run inline */
+		vty->fork_child = true;
+
+		result = cmd_execute(vty, buf, NULL, 0);
+		vty_report_cmd_result(vty, result, buf);
+
+		/* Push everything down the socket.  The fd's open file
+		 * description is shared with the parent across fork(),
+		 * so O_NONBLOCK must stay set - clearing it here would
+		 * make the parent's session socket blocking too.  Poll
+		 * and retry instead until the kernel has taken it all.
+		 */
+		while (buffer_flush_all(vty->obuf, vty->wfd)
+		       == BUFFER_PENDING) {
+			struct pollfd pfd = {.fd = vty->wfd,
+					     .events = POLLOUT};
+
+			if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+				break;
+		}
+
+		while (write(waitpipe[1], &result, 1) < 0
+		       && errno == EINTR)
+			;
+		_exit(0);
+	}
+
+	close(waitpipe[1]);
+	vty->fork_pid = pid;
+	vty->fork_wait_fd = waitpipe[0];
+	thread_add_read(vty_master, vty_fork_done, vty, waitpipe[0],
+			&vty->t_fork);
+
+	return CMD_SUSPEND;
+}
+#endif /* VTYSH */
+
 static int vty_command(struct vty *vty, char *buf)
 {
 	int ret;
-	const char *protocolname;
 	char *cp = NULL;
 
 	assert(vty);
@@ -516,6 +732,15 @@ static int vty_command(struct vty *vty, char *buf)
 		zlog_notice("%s%s", prompt_str, buf);
 	}
 
+#ifdef VTYSH
+	if (vty_fork_read_candidate(vty, buf)) {
+		ret = vty_command_fork(vty, buf);
+		if (ret >= 0)
+			return ret;
+		/* fork failed - render in-process as usual */
+	}
+#endif /* VTYSH */
+
 #ifdef CONSUMED_TIME_CHECK
 	{
 		RUSAGE_T before;
@@ -527,9 +752,6 @@ static int vty_command(struct vty *vty, char *buf)
 
 		ret = cmd_execute(vty, buf, NULL, 0);
 
-		/* Get the name of the protocol if any */
-		protocolname = frr_protoname;
-
 #ifdef CONSUMED_TIME_CHECK
 		GETRUSAGE(&after);
 		if ((realtime = thread_consumed_time(&after, &before, &cputime))
@@ -543,22 +765,7 @@ static int vty_command(struct vty *vty, char *buf)
 #endif /* CONSUMED_TIME_CHECK */
 
 	if (ret != CMD_SUCCESS)
-		switch (ret) {
-		case CMD_WARNING:
-			if (vty->type == VTY_FILE)
-				vty_out(vty, "Warning...\n");
-			break;
-		case CMD_ERR_AMBIGUOUS:
-			vty_out(vty, "%% Ambiguous command.\n");
-			break;
-		case CMD_ERR_NO_MATCH:
-			vty_out(vty, "%% [%s] Unknown command: %s\n",
-				protocolname, buf);
-			break;
-		case CMD_ERR_INCOMPLETE:
-			vty_out(vty, "%% Command incomplete.\n");
-			break;
-		}
+		vty_report_cmd_result(vty, ret, buf);
 
 	return ret;
 }
@@ -2082,11 +2289,43 @@ static int vtysh_flush(struct vty *vty)
 		return -1;
 		break;
 	case BUFFER_EMPTY:
+		/* the peer has consumed everything; if a command yielded
+		 * mid-walk, let it produce the next chunk */
+		if (vty->yield_cont && !vty->t_yield)
+			vty_event(VTYSH_RESUME, vty->wfd, vty);
 		break;
 	}
 	return 0;
 }
 
+/* Output to the vtysh peer has drained; run the next leg of a command
+ * suspended via vty_yield(), or report its deferred result. */
+static int vtysh_yield_continue(struct thread *thread)
+{
+	struct vty *vty = THREAD_ARG(thread);
+	uint8_t header[4] = {0, 0, 0, 0};
+	int ret;
+
+	vty->t_yield = NULL;
+	if (!vty->yield_cont)
+		return 0;
+
+	ret = (*vty->yield_cont)(vty, vty->yield_arg);
+	if (ret != CMD_SUSPEND) {
+		vty->yield_cont = NULL;
+		vty->yield_cancel = NULL;
+		vty->yield_arg = NULL;
+
+		/* warning: watchfrr hardcodes this result write */
+		header[3] = ret;
+		buffer_put(vty->obuf, header, 4);
+	}
+
+	if (!vty->t_write)
+		vtysh_flush(vty);
+	return 0;
+}
+
 static int vtysh_read(struct thread *thread)
 {
 	int ret;
@@ -2148,11 +2387,19 @@ static int vtysh_read(struct thread *thread)
 #endif /* VTYSH_DEBUG */
 
 				/* hack for asynchronous "write integrated"
+				 * and commands suspended via vty_yield()
 				 * - other commands in "buf" will be ditched
-				 * - input during pending config-write is
+				 * - input during the pending command is
 				 * "unsupported" */
-				if (ret == CMD_SUSPEND)
+				if (ret == CMD_SUSPEND) {
+					/* kick the writer so a yielded
+					 * command's first chunk goes out (and
+					 * an empty obuf resumes it at once) */
+					if (vty->yield_cont && !vty->t_write
+					    && vtysh_flush(vty) < 0)
+						return 0;
 					break;
+				}
 
 				/* warning: watchfrr hardcodes this result write
 				 */
@@ -2221,6 +2468,24 @@ void vty_close(struct vty *vty)
 		thread_cancel(vty->t_write);
 	if (vty->t_timeout)
 		thread_cancel(vty->t_timeout);
+	if (vty->t_yield)
+		thread_cancel(vty->t_yield);
+	if (vty->t_fork)
+		thread_cancel(vty->t_fork);
+
+	/* A command suspended via vty_yield() will never finish; let it
+	 * release whatever its walk state holds. */
+	if (vty->yield_cancel)
+		(*vty->yield_cancel)(vty, vty->yield_arg);
+
+	/* An in-flight fork-read child is writing to a socket nobody
+	 * will read again; SIGKILL, since the inherited handlers make
+	 * SIGTERM a no-op in the child. */
+	if (vty->fork_pid > 0) {
+		close(vty->fork_wait_fd);
+		kill(vty->fork_pid, SIGKILL);
+		waitpid(vty->fork_pid, NULL, 0);
+	}
 
 	/* Flush buffer. */
 	buffer_flush_all(vty->obuf, vty->wfd);
@@ -2666,9 +2931,6 @@ void vty_config_exclusive_unlock(struct vty *vty)
 		vty_exclusive_lock = NULL;
 }
 
-/* Master of the threads. */
-static struct thread_master *vty_master;
-
 static void vty_event(enum event event, int sock, struct vty *vty)
 {
 	struct thread *vty_serv_thread = NULL;
@@ -2695,6 +2957,10 @@ static void vty_event(enum event event, int sock, struct vty *vty)
 		thread_add_write(vty_master, vtysh_write, vty, sock,
 				 &vty->t_write);
 		break;
+	case VTYSH_RESUME:
+		thread_add_event(vty_master, vtysh_yield_continue, vty, 0,
+				 &vty->t_yield);
+		break;
 #endif /* VTYSH */
 	case VTY_READ:
 		vty->t_read = NULL;
@@ -2931,6 +3197,27 @@ DEFUN (no_service_advanced_vty,
 	return CMD_SUCCESS;
 }
 
+DEFUN (service_fork_read,
+       service_fork_read_cmd,
+       "service fork-read",
+       "Set up miscellaneous service\n"
+       "Render large show commands from a forked copy-on-write snapshot\n")
+{
+	vty_fork_read = true;
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_service_fork_read,
+       no_service_fork_read_cmd,
+       "no service fork-read",
+       NO_STR
+       "Set up miscellaneous service\n"
+       "Render large show commands from a forked copy-on-write snapshot\n")
+{
+	vty_fork_read = false;
+	return CMD_SUCCESS;
+}
+
 DEFUN_NOSH (terminal_monitor,
        terminal_monitor_cmd,
        "terminal monitor",
@@ -3021,6 +3308,9 @@ static int vty_config_write(struct vty *vty)
 	if (do_log_commands)
 		vty_out(vty, "log commands\n");
 
+	if (vty_fork_read)
+		vty_out(vty, "service fork-read\n");
+
 	vty_out(vty, "!\n");
 
 	return CMD_SUCCESS;
@@ -3139,6 +3429,8 @@ void vty_init(struct thread_master *master_thread)
 	install_element(CONFIG_NODE, &line_vty_cmd);
 	install_element(CONFIG_NODE, &service_advanced_vty_cmd);
 	install_element(CONFIG_NODE, &no_service_advanced_vty_cmd);
+	install_element(CONFIG_NODE, &service_fork_read_cmd);
+	install_element(CONFIG_NODE, &no_service_fork_read_cmd);
 	install_element(CONFIG_NODE, &show_history_cmd);
 	install_element(CONFIG_NODE, &log_commands_cmd);
 	install_element(ENABLE_NODE, &terminal_monitor_cmd);
@@ -176,6 +176,27 @@ struct vty {
 	struct thread *t_read;
 	struct thread *t_write;
 
+	/* Mid-command yield (see vty_yield).  While yield_cont is set the
+	 * command's result has not been reported to the peer yet; the
+	 * continuation is re-run from t_yield each time the output buffer
+	 * has drained, until it returns something other than CMD_SUSPEND.
+	 * yield_cancel releases the walk state if the session dies first. */
+	int (*yield_cont)(struct vty *vty, void *arg);
+	void (*yield_cancel)(struct vty *vty, void *arg);
+	void *yield_arg;
+	struct thread *t_yield;
+
+	/* Fork-read (see "service fork-read"): a forked child renders a
+	 * large show command from a copy-on-write snapshot of the daemon
+	 * and writes straight to the session socket; t_fork watches
+	 * fork_wait_fd for the child's exit, after which the deferred
+	 * result header goes out.  fork_child is set only in the child,
+	 * where yields must run inline (there is no event loop). */
+	pid_t fork_pid;
+	int fork_wait_fd;
+	struct thread *t_fork;
+	bool fork_child;
+
 	/* Timeout seconds and thread. */
 	unsigned long v_timeout;
 	struct thread *t_timeout;
@@ -310,6 +331,15 @@ extern int vty_out(struct vty *, const char *, ...) PRINTF_ATTRIBUTE(2, 3);
 extern void vty_frame(struct vty *, const char *, ...) PRINTF_ATTRIBUTE(2, 3);
 extern void vty_endframe(struct vty *, const char *);
 bool vty_set_include(struct vty *vty, const char *regexp);
+/* Drain buffered output mid-command (no-op on interactive terminals);
+ * lets incremental producers keep the peak obuf footprint flat. */
+extern void vty_out_flush(struct vty *vty);
+/* Suspend the running command; "cont" emits the next output chunk each
+ * time the buffer has drained and returns CMD_SUSPEND to be called
+ * again, or a final CMD_* code.  Commands return this function's return
+ * value.  See the definition for the full contract. */
+extern int vty_yield(struct vty *vty, int (*cont)(struct vty *vty, void *arg),
+		     void (*cancel)(struct vty *vty, void *arg), void *arg);
 
 extern bool vty_read_config(struct nb_config *config, const char *config_file,
 			    char *config_default_dir);
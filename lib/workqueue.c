@@ -27,10 +27,47 @@
 #include "linklist.h"
 #include "command.h"
 #include "log.h"
+#include "frr_pthread.h"
+#include "frratomic.h"
 
 DEFINE_MTYPE(LIB, WORK_QUEUE, "Work queue")
 DEFINE_MTYPE_STATIC(LIB, WORK_QUEUE_ITEM, "Work queue item")
 DEFINE_MTYPE_STATIC(LIB, WORK_QUEUE_NAME, "Work queue name string")
+DEFINE_MTYPE_STATIC(LIB, WORK_QUEUE_SHARD, "Work queue shard")
+
+/* Sharded executor: per-worker state.  Each worker owns a deque of items;
+ * siblings lock it to steal from the head when their own runs dry. */
+struct wq_worker {
+	struct work_queue_shard *shard;
+	struct frr_pthread *fpt;
+	unsigned int id;
+
+	pthread_mutex_t mtx; /* protects items / item_count */
+	struct work_queue_items items;
+	int item_count;
+
+	unsigned long handled; /* items this worker ran */
+	unsigned long stolen;  /* of which stolen from siblings */
+};
+
+struct work_queue_shard {
+	struct work_queue *wq;
+	unsigned int nworkers;
+	struct wq_worker *workers;
+
+	/* sleeping workers wait here; producers signal after enqueueing */
+	pthread_mutex_t cond_mtx;
+	pthread_cond_t cond;
+
+	/* items sitting in worker deques, not yet picked up */
+	_Atomic uint32_t queued;
+	/* items handed out and not yet finished; the worker dropping this
+	 * to zero marshals the completion callback back to the owner */
+	_Atomic uint32_t pending;
+
+	unsigned int rr; /* round-robin enqueue cursor, owner thread only */
+	struct thread *t_completion;
+};
 
 /* master list of work_queues */
 static struct list _work_queues;
@@ -73,6 +110,287 @@ static void work_queue_item_remove(struct work_queue *wq,
 	return;
 }
 
+/* Sharded executor ---------------------------------------------------- */
+
+/* owner-side event: last outstanding item finished */
+static int wq_shard_completion_run(struct thread *thread)
+{
+	struct work_queue *wq = THREAD_ARG(thread);
+
+	/* more work may have been added since the worker queued this */
+	if (atomic_load_explicit(&wq->shard->pending, memory_order_acquire)
+		    == 0
+	    && wq->spec.completion_func)
+		wq->spec.completion_func(wq);
+
+	return 0;
+}
+
+static void wq_shard_enqueue(struct work_queue *wq,
+			     struct work_queue_item *item)
+{
+	struct work_queue_shard *shard = wq->shard;
+	struct wq_worker *worker;
+
+	worker = &shard->workers[shard->rr++ % shard->nworkers];
+
+	pthread_mutex_lock(&worker->mtx);
+	{
+		STAILQ_INSERT_TAIL(&worker->items, item, wq);
+		worker->item_count++;
+	}
+	pthread_mutex_unlock(&worker->mtx);
+
+	atomic_fetch_add_explicit(&shard->pending, 1, memory_order_release);
+	atomic_fetch_add_explicit(&shard->queued, 1, memory_order_release);
+
+	pthread_mutex_lock(&shard->cond_mtx);
+	pthread_cond_signal(&shard->cond);
+	pthread_mutex_unlock(&shard->cond_mtx);
+}
+
+/* Pop from our own deque, or steal half of the first non-empty sibling's.
+ */
+static struct work_queue_item *wq_worker_take(struct wq_worker *me)
+{
+	struct work_queue_shard *shard = me->shard;
+	struct work_queue_item *item = NULL;
+	unsigned int v;
+
+	pthread_mutex_lock(&me->mtx);
+	{
+		item = STAILQ_FIRST(&me->items);
+		if (item) {
+			STAILQ_REMOVE_HEAD(&me->items, wq);
+			me->item_count--;
+		}
+	}
+	pthread_mutex_unlock(&me->mtx);
+
+	if (item) {
+		atomic_fetch_sub_explicit(&shard->queued, 1,
+					  memory_order_relaxed);
+		return item;
+	}
+
+	for (v = 1; v < shard->nworkers; v++) {
+		struct wq_worker *victim =
+			&shard->workers[(me->id + v) % shard->nworkers];
+		struct work_queue_items moved;
+		int grab = 0;
+
+		STAILQ_INIT(&moved);
+
+		/* pull onto a local list first - never hold two worker
+		 * mutexes at once, a sibling may be stealing from us */
+		pthread_mutex_lock(&victim->mtx);
+		{
+			grab = (victim->item_count + 1) / 2;
+			for (int i = 0; i < grab; i++) {
+				item = STAILQ_FIRST(&victim->items);
+				STAILQ_REMOVE_HEAD(&victim->items, wq);
+				victim->item_count--;
+				STAILQ_INSERT_TAIL(&moved, item, wq);
+			}
+		}
+		pthread_mutex_unlock(&victim->mtx);
+
+		if (!grab) {
+			item = NULL;
+			continue;
+		}
+
+		item = STAILQ_FIRST(&moved);
+		STAILQ_REMOVE_HEAD(&moved, wq);
+
+		if (!STAILQ_EMPTY(&moved)) {
+			pthread_mutex_lock(&me->mtx);
+			{
+				STAILQ_CONCAT(&me->items, &moved);
+				me->item_count += grab - 1;
+			}
+			pthread_mutex_unlock(&me->mtx);
+		}
+
+		me->stolen += grab;
+		atomic_fetch_sub_explicit(&shard->queued, 1,
+					  memory_order_relaxed);
+		return item;
+	}
+
+	return NULL;
+}
+
+static void wq_worker_process(struct wq_worker *me,
+			      struct work_queue_item *item)
+{
+	struct work_queue_shard *shard = me->shard;
+	struct work_queue *wq = shard->wq;
+	wq_item_status ret;
+
+	do {
+		ret = wq->spec.workfunc(wq, item->data);
+		item->ran++;
+	} while ((ret == WQ_RETRY_NOW) && (item->ran < wq->spec.max_retries));
+
+	me->handled++;
+
+	switch (ret) {
+	case WQ_QUEUE_BLOCKED:
+	case WQ_RETRY_LATER:
+		/* can't pause a worker pool; treated like WQ_REQUEUE */
+	case WQ_REQUEUE:
+		item->ran--;
+		pthread_mutex_lock(&me->mtx);
+		{
+			STAILQ_INSERT_TAIL(&me->items, item, wq);
+			me->item_count++;
+		}
+		pthread_mutex_unlock(&me->mtx);
+		/* we are awake and will pick it up again; no signal */
+		atomic_fetch_add_explicit(&shard->queued, 1,
+					  memory_order_relaxed);
+		return; /* still pending */
+	case WQ_RETRY_NOW:
+	/* a RETRY_NOW that gets here has exceeded max_tries, same as
+	 * ERROR */
+	case WQ_ERROR:
+		if (wq->spec.errorfunc)
+			wq->spec.errorfunc(wq, item);
+	/* fallthru */
+	case WQ_SUCCESS:
+	default:
+		if (wq->spec.del_item_data)
+			wq->spec.del_item_data(wq, item->data);
+		work_queue_item_free(item);
+		break;
+	}
+
+	if (atomic_fetch_sub_explicit(&shard->pending, 1, memory_order_release)
+		    == 1
+	    && wq->spec.completion_func)
+		thread_add_event(wq->master, wq_shard_completion_run, wq, 0,
+				 &shard->t_completion);
+}
+
+static void *wq_worker_run(void *arg)
+{
+	struct frr_pthread *fpt = arg;
+	struct wq_worker *me = fpt->data;
+	struct work_queue_shard *shard = me->shard;
+	struct work_queue_item *item;
+
+	frr_pthread_set_name(fpt);
+	frr_pthread_notify_running(fpt);
+
+	while (atomic_load_explicit(&fpt->running, memory_order_relaxed)) {
+		item = wq_worker_take(me);
+		if (item) {
+			wq_worker_process(me, item);
+			continue;
+		}
+
+		pthread_mutex_lock(&shard->cond_mtx);
+		if (atomic_load_explicit(&fpt->running, memory_order_relaxed)
+		    && atomic_load_explicit(&shard->queued,
+					    memory_order_acquire) == 0)
+			pthread_cond_wait(&shard->cond, &shard->cond_mtx);
+		pthread_mutex_unlock(&shard->cond_mtx);
+	}
+
+	return NULL;
+}
+
+static int wq_worker_stop(struct frr_pthread *fpt, void **result)
+{
+	struct wq_worker *me = fpt->data;
+
+	atomic_store_explicit(&fpt->running, false, memory_order_relaxed);
+
+	pthread_mutex_lock(&me->shard->cond_mtx);
+	pthread_cond_broadcast(&me->shard->cond);
+	pthread_mutex_unlock(&me->shard->cond_mtx);
+
+	pthread_join(fpt->thread, result);
+	return 0;
+}
+
+static struct frr_pthread_attr wq_worker_attr = {
+	.start = wq_worker_run,
+	.stop = wq_worker_stop,
+};
+
+void work_queue_shard(struct work_queue *wq, unsigned int workers)
+{
+	struct work_queue_shard *shard;
+	char name[64], os_name[OS_THREAD_NAMELEN];
+
+	assert(!wq->shard && work_queue_empty(wq));
+
+	if (workers < 1)
+		workers = 1;
+
+	shard = XCALLOC(MTYPE_WORK_QUEUE_SHARD, sizeof(*shard));
+	shard->wq = wq;
+	shard->nworkers = workers;
+	shard->workers = XCALLOC(MTYPE_WORK_QUEUE_SHARD,
+				 sizeof(struct wq_worker) * workers);
+	pthread_mutex_init(&shard->cond_mtx, NULL);
+	pthread_cond_init(&shard->cond, NULL);
+
+	wq->shard = shard;
+	SET_FLAG(wq->flags, WQ_SHARDED);
+
+	for (unsigned int i = 0; i < workers; i++) {
+		struct wq_worker *worker = &shard->workers[i];
+
+		worker->shard = shard;
+		worker->id = i;
+		pthread_mutex_init(&worker->mtx, NULL);
+		STAILQ_INIT(&worker->items);
+
+		snprintf(name, sizeof(name), "WQ worker %u (%s)", i, wq->name);
+		snprintf(os_name, sizeof(os_name), "wq_wrk_%u", i);
+		worker->fpt = frr_pthread_new(&wq_worker_attr, name, os_name);
+		worker->fpt->data = worker;
+		frr_pthread_run(worker->fpt, NULL);
+		frr_pthread_wait_running(worker->fpt);
+	}
+}
+
+static void wq_shard_free(struct work_queue *wq)
+{
+	struct work_queue_shard *shard = wq->shard;
+
+	for (unsigned int i = 0; i < shard->nworkers; i++) {
+		struct wq_worker *worker = &shard->workers[i];
+
+		frr_pthread_stop(worker->fpt, NULL);
+		frr_pthread_destroy(worker->fpt);
+
+		/* workers are gone; drain what they left behind */
+		while (!STAILQ_EMPTY(&worker->items)) {
+			struct work_queue_item *item =
+				STAILQ_FIRST(&worker->items);
+
+			STAILQ_REMOVE_HEAD(&worker->items, wq);
+			if (wq->spec.del_item_data)
+				wq->spec.del_item_data(wq, item->data);
+			work_queue_item_free(item);
+		}
+		pthread_mutex_destroy(&worker->mtx);
+	}
+
+	THREAD_OFF(shard->t_completion);
+	pthread_mutex_destroy(&shard->cond_mtx);
+	pthread_cond_destroy(&shard->cond);
+	XFREE(MTYPE_WORK_QUEUE_SHARD, shard->workers);
+	XFREE(MTYPE_WORK_QUEUE_SHARD, shard);
+	wq->shard = NULL;
+}
+
+/* --------------------------------------------------------------------- */
+
 /* create new work queue */
 struct work_queue *work_queue_new(struct thread_master *m,
 				  const char *queue_name)
@@ -103,6 +421,9 @@ void work_queue_free_and_null(struct work_queue **wqp)
 {
 	struct work_queue *wq = *wqp;
 
+	if (wq->shard)
+		wq_shard_free(wq);
+
 	if (wq->thread != NULL)
 		thread_cancel(wq->thread);
 
@@ -159,6 +480,12 @@ void work_queue_add(struct work_queue *wq, void *data)
 	item = work_queue_item_new(wq);
 
 	item->data = data;
+
+	if (wq->shard) {
+		wq_shard_enqueue(wq, item);
+		return;
+	}
+
 	work_queue_item_enqueue(wq, item);
 
 	work_queue_schedule(wq, wq->spec.hold);
@@ -191,6 +518,21 @@ DEFUN (show_work_queues,
 		"Name");
 
 	for (ALL_LIST_ELEMENTS_RO(work_queues, node, wq)) {
+		if (wq->shard) {
+			unsigned long handled = 0, stolen = 0;
+
+			for (unsigned int i = 0; i < wq->shard->nworkers; i++) {
+				handled += wq->shard->workers[i].handled;
+				stolen += wq->shard->workers[i].stolen;
+			}
+			vty_out(vty, "%c %8u %5s %8lu %8lu %7s %6s %8s %6s %s (%u workers)\n",
+				'S',
+				atomic_load_explicit(&wq->shard->queued,
+						     memory_order_relaxed),
+				"-", handled, stolen, "-", "-", "-", "-",
+				wq->name, wq->shard->nworkers);
+			continue;
+		}
 		vty_out(vty, "%c %8d %5d %8ld %8ld %7d %6d %8ld %6u %s\n",
 			(CHECK_FLAG(wq->flags, WQ_UNPLUGGED) ? ' ' : 'P'),
 			work_queue_item_count(wq), wq->spec.hold, wq->runs,
@@ -58,6 +58,10 @@ struct work_queue_item {
 };
 
 #define WQ_UNPLUGGED	(1 << 0) /* available for draining */
+#define WQ_SHARDED	(1 << 1) /* parallel executor, see work_queue_shard() */
+
+/* worker pool state for sharded queues, private to workqueue.c */
+struct work_queue_shard;
 
 struct work_queue {
 	/* Everything but the specification struct is private
@@ -117,6 +121,9 @@ struct work_queue {
 
 	/* private state */
 	uint16_t flags; /* user set flag */
+
+	/* non-NULL once work_queue_shard() marked the queue sharded */
+	struct work_queue_shard *shard;
 };
 
 /* User API */
@@ -169,6 +176,20 @@ extern void work_queue_free_and_null(struct work_queue **wqp);
 /* Add the supplied data as an item onto the workqueue */
 extern void work_queue_add(struct work_queue *wq, void *item);
 
+/* Mark the queue sharded: items added from here on are distributed
+ * round-robin over a pool of frr_pthread workers which steal from each
+ * other when they run dry, instead of being run in batches on the owning
+ * thread_master.  The completion callback is marshalled back onto the
+ * owner's thread_master once the last outstanding item finishes.
+ *
+ * Constraints compared to the classic mode: workfunc, errorfunc and
+ * del_item_data run on worker pthreads and must be safe to call there;
+ * WQ_RETRY_LATER and WQ_QUEUE_BLOCKED cannot pause a worker pool and are
+ * handled like WQ_REQUEUE; plugging is not supported.  Call once, before
+ * the first work_queue_add(), with the spec already filled in.
+ */
+extern void work_queue_shard(struct work_queue *wq, unsigned int workers);
+
 /* plug the queue, ie prevent it from being drained / processed */
 extern void work_queue_plug(struct work_queue *wq);
 /* unplug the queue, allow it to be drained again */
@@ -0,0 +1,159 @@
+#!/usr/bin/perl
+##
+## Scan a table of fixed-layout ZAPI field groups (see zapi_msg.txt) and
+## generate a header of specialized marshallers for them.  Each group
+## "foo" yields:
+##
+##   - ZAPI_FOO_WIRE_SIZE, the group's on-wire size in bytes
+##   - zapi_foo_encode(s, fields...), 0 on success, -1 if the stream
+##     is out of space
+##   - zapi_foo_decode(s, &fields...), 0 on success, -1 if the stream
+##     runs short
+##
+## Both check stream bounds exactly once for the whole group and then
+## move the fields with straight-line byte loads/stores, instead of one
+## bounds-checked stream accessor call per field.
+##
+## Copyright (C) 2019 Cumulus Networks, Inc.
+## This file is part of FRR.
+##
+## FRR is free software; you can redistribute it and/or modify it
+## under the terms of the GNU General Public License as published by the
+## Free Software Foundation; either version 2, or (at your option) any
+## later version.
+##
+## FRR is distributed in the hope that it will be useful, but
+## WITHOUT ANY WARRANTY; without even the implied warranty of
+## MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+## General Public License for more details.
+##
+## You should have received a copy of the GNU General Public License
+## along with FRR; see the file COPYING.  If not, write to the Free
+## Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+## 02110-1301, USA.
+##
+
+use strict;
+
+# input processing
+#
+my @groups;
+my %groupfields;
+
+my %wiresize = ("c" => 1, "w" => 2, "l" => 4);
+my %ctype = ("c" => "uint8_t", "w" => "uint16_t", "l" => "uint32_t");
+
+my $cur;
+while (<STDIN>) {
+	# skip comments and empty lines
+	next if (/^\s*(#|$)/);
+
+	# strip whitespace
+	chomp;
+	$_ =~ s/^\s*//;
+	$_ =~ s/\s*$//;
+
+	if (/^group\s+(\w+)$/) {
+		$cur = $1;
+		push @groups, $cur;
+		$groupfields{$cur} = [];
+		next;
+	}
+
+	$_ =~ s/\s*,\s*/,/g;
+	my @f = split(/,/, $_);
+	unless (defined($cur) && @f == 2 && defined($wiresize{$f[1]})) {
+		die "invalid input on zapi_msg line $.\n";
+	}
+	push @{$groupfields{$cur}}, { "name" => $f[0], "type" => $f[1] };
+}
+
+# output
+print <<EOF;
+/* Auto-generated from zapi_msg.txt by zapi_msg.pl. */
+/* Do not edit! */
+
+#ifndef _FRR_ZAPI_FIXED_H
+#define _FRR_ZAPI_FIXED_H
+
+#include "stream.h"
+
+/* These marshallers intentionally reach into the stream's getp/endp:
+ * bounds are established once per group up front, so the per-field
+ * checks of the generic stream accessors would be pure overhead.
+ */
+
+EOF
+
+for my $g (@groups) {
+	my @fields = @{$groupfields{$g}};
+	my $size = 0;
+	$size += $wiresize{$_->{"type"}} for (@fields);
+	my $sizemacro = sprintf("ZAPI_%s_WIRE_SIZE", uc($g));
+
+	printf "/* %s: %d bytes on the wire */\n", $g, $size;
+	printf "#define %s %d\n\n", $sizemacro, $size;
+
+	# encode
+	my @args = map { sprintf("%s %s", $ctype{$_->{"type"}}, $_->{"name"}) }
+		@fields;
+	printf "static inline int zapi_%s_encode(struct stream *s, %s)\n",
+		$g, join(",\n\t\t\t\t", @args);
+	print "{\n";
+	print "\tuint8_t *p;\n\n";
+	printf "\tif (STREAM_WRITEABLE(s) < %s)\n", $sizemacro;
+	print "\t\treturn -1;\n";
+	print "\tp = STREAM_DATA(s) + s->endp;\n";
+	my $off = 0;
+	for my $f (@fields) {
+		my ($n, $t) = ($f->{"name"}, $f->{"type"});
+		if ($t eq "c") {
+			printf "\tp[%d] = %s;\n", $off, $n;
+		} elsif ($t eq "w") {
+			printf "\tp[%d] = (uint8_t)(%s >> 8);\n", $off, $n;
+			printf "\tp[%d] = (uint8_t)%s;\n", $off + 1, $n;
+		} else {
+			for my $i (0 .. 3) {
+				printf "\tp[%d] = (uint8_t)(%s >> %d);\n",
+					$off + $i, $n, 24 - 8 * $i;
+			}
+		}
+		$off += $wiresize{$t};
+	}
+	printf "\ts->endp += %s;\n", $sizemacro;
+	print "\treturn 0;\n";
+	print "}\n\n";
+
+	# decode
+	@args = map { sprintf("%s *%s", $ctype{$_->{"type"}}, $_->{"name"}) }
+		@fields;
+	printf "static inline int zapi_%s_decode(struct stream *s, %s)\n",
+		$g, join(",\n\t\t\t\t", @args);
+	print "{\n";
+	print "\tconst uint8_t *p;\n\n";
+	printf "\tif (STREAM_READABLE(s) < %s)\n", $sizemacro;
+	print "\t\treturn -1;\n";
+	print "\tp = STREAM_DATA(s) + s->getp;\n";
+	$off = 0;
+	for my $f (@fields) {
+		my ($n, $t) = ($f->{"name"}, $f->{"type"});
+		if ($t eq "c") {
+			printf "\t*%s = p[%d];\n", $n, $off;
+		} elsif ($t eq "w") {
+			printf "\t*%s = (uint16_t)(((uint16_t)p[%d] << 8)" .
+				" | p[%d]);\n", $n, $off, $off + 1;
+		} else {
+			printf "\t*%s = ((uint32_t)p[%d] << 24)" .
+				" | ((uint32_t)p[%d] << 16)\n" .
+				"\t\t| ((uint32_t)p[%d] << 8)" .
+				" | p[%d];\n",
+				$n, $off, $off + 1, $off + 2, $off + 3;
+		}
+		$off += $wiresize{$t};
+	}
+	printf "\ts->getp += %s;\n", $sizemacro;
+	print "\treturn 0;\n";
+	print "}\n\n";
+}
+
+print "#endif /* _FRR_ZAPI_FIXED_H */\n";
@@ -38,17 +38,29 @@
 #include "sockopt.h"
 #include "pbr.h"
 #include "nexthop_group.h"
+#include "shstrtab.h"
 #include "lib_errors.h"
+#include "zapi_fixed.h"
 
 DEFINE_MTYPE_STATIC(LIB, ZCLIENT, "Zclient")
 DEFINE_MTYPE_STATIC(LIB, REDIST_INST, "Redistribution instance IDs")
 
 /* Zebra client events. */
-enum event { ZCLIENT_SCHEDULE, ZCLIENT_READ, ZCLIENT_CONNECT };
+enum event {
+	ZCLIENT_SCHEDULE,
+	ZCLIENT_READ,
+	ZCLIENT_CONNECT,
+	ZCLIENT_SHM_READ,
+};
 
 /* Prototype for event manager. */
 static void zclient_event(enum event, struct zclient *);
 
+/* Shared-memory ring transport (see zclient_shm_hello). */
+static int zclient_shm_send(struct zclient *zclient);
+static void zclient_dispatch(struct zclient *zclient, uint16_t command,
+			     uint16_t length, vrf_id_t vrf_id);
+
 struct sockaddr_storage zclient_addr;
 socklen_t zclient_addr_len;
 
@@ -70,6 +82,11 @@ struct zclient *zclient_new(struct thread_master *master,
 	zclient->master = master;
 
 	zclient->receive_notify = opt->receive_notify;
+	zclient->use_shm = opt->use_shm;
+
+	zclient->shm_tx.fd = zclient->shm_tx.doorbell = -1;
+	zclient->shm_rx.fd = zclient->shm_rx.doorbell = -1;
+	zclient->shm_outq = stream_fifo_new();
 
 	return zclient;
 }
@@ -87,6 +104,10 @@ void zclient_free(struct zclient *zclient)
 		stream_free(zclient->obuf);
 	if (zclient->wb)
 		buffer_free(zclient->wb);
+	if (zclient->shm_outq)
+		stream_fifo_free(zclient->shm_outq);
+	if (zclient->strtab)
+		shstrtab_close(zclient->strtab);
 
 	XFREE(MTYPE_ZCLIENT, zclient);
 }
@@ -150,6 +171,8 @@ void zclient_stop(struct zclient *zclient)
 	THREAD_OFF(zclient->t_read);
 	THREAD_OFF(zclient->t_connect);
 	THREAD_OFF(zclient->t_write);
+	THREAD_OFF(zclient->t_shm_read);
+	THREAD_OFF(zclient->t_shm_flush);
 
 	/* Reset streams. */
 	stream_reset(zclient->ibuf);
@@ -158,6 +181,14 @@ void zclient_stop(struct zclient *zclient)
 	/* Empty the write buffer. */
 	buffer_reset(zclient->wb);
 
+	/* Tear down the shared-memory transport; a reconnect renegotiates
+	 * from scratch. */
+	zshm_ring_close(&zclient->shm_tx);
+	zshm_ring_close(&zclient->shm_rx);
+	zclient->shm_tx_active = zclient->shm_rx_active = false;
+	zclient->shm_pending = false;
+	stream_fifo_clean(zclient->shm_outq);
+
 	/* Close socket. */
 	if (zclient->sock >= 0) {
 		close(zclient->sock);
@@ -270,6 +301,8 @@ int zclient_send_message(struct zclient *zclient)
 {
 	if (zclient->sock < 0)
 		return -1;
+	if (zclient->shm_tx_active)
+		return zclient_shm_send(zclient);
 	switch (buffer_write(zclient->wb, zclient->sock,
 			     STREAM_DATA(zclient->obuf),
 			     stream_get_endp(zclient->obuf))) {
@@ -554,6 +587,297 @@ void zclient_send_interface_radv_req(struct zclient *zclient, vrf_id_t vrf_id,
 }
 
 /* Make connection to zebra daemon. */
+/* Shared-memory ring transport --------------------------------------------
+ *
+ * When zclient_options.use_shm is set, the client offers zebra a pair of
+ * SPSC byte rings (one per direction) right after connecting, before any
+ * other traffic.  The offer is a ZEBRA_SHM_HELLO message whose sendmsg()
+ * carries the four descriptors (two ring segments, two eventfd doorbells)
+ * as SCM_RIGHTS ancillary data.  A zebra that supports the transport maps
+ * the rings, answers with ZEBRA_SHM_HELLO as its *last* socket message
+ * and moves its output to the ring; the client answers ZEBRA_SHM_SWITCH
+ * the same way.  Those two marker messages keep the byte streams strictly
+ * ordered across the handover.  A zebra that does not understand the
+ * offer simply never answers and the session stays on the socket.
+ */
+
+/* fds passed with ZEBRA_SHM_HELLO, in the client's view. */
+#define ZSHM_HELLO_NFDS 4
+
+static int zclient_shm_flush(struct thread *thread);
+static int zclient_shm_read(struct thread *thread);
+
+/* Offer the ring transport to zebra.  Failure is not an error - the
+ * session just stays on the socket. */
+static void zclient_shm_hello(struct zclient *zclient)
+{
+	struct stream *s = zclient->obuf;
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	union {
+		struct cmsghdr align;
+		char buf[CMSG_SPACE(sizeof(int) * ZSHM_HELLO_NFDS)];
+	} cmsgbuf;
+	int fds[ZSHM_HELLO_NFDS];
+
+	if (!zshm_available())
+		return;
+
+	if (zshm_ring_create(&zclient->shm_tx, ZSHM_RING_DEFAULT_SIZE) < 0)
+		return;
+	if (zshm_ring_create(&zclient->shm_rx, ZSHM_RING_DEFAULT_SIZE) < 0) {
+		zshm_ring_close(&zclient->shm_tx);
+		return;
+	}
+
+	stream_reset(s);
+	zclient_create_header(s, ZEBRA_SHM_HELLO, VRF_DEFAULT);
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	fds[0] = zclient->shm_tx.fd;
+	fds[1] = zclient->shm_tx.doorbell;
+	fds[2] = zclient->shm_rx.fd;
+	fds[3] = zclient->shm_rx.doorbell;
+
+	memset(&msg, 0, sizeof(msg));
+	memset(&cmsgbuf, 0, sizeof(cmsgbuf));
+	iov.iov_base = STREAM_DATA(s);
+	iov.iov_len = stream_get_endp(s);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cmsgbuf.buf;
+	msg.msg_controllen = sizeof(cmsgbuf.buf);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * ZSHM_HELLO_NFDS);
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	/* The socket buffer is empty this early; a short write means no
+	 * shm for this session. */
+	if (sendmsg(zclient->sock, &msg, 0) != (ssize_t)iov.iov_len) {
+		zshm_ring_close(&zclient->shm_tx);
+		zshm_ring_close(&zclient->shm_rx);
+		return;
+	}
+
+	zclient->shm_pending = true;
+	if (zclient_debug)
+		zlog_debug("zclient: offered shm transport on socket %d",
+			   zclient->sock);
+}
+
+/* zebra accepted the rings (its ack is the last thing it sends on the
+ * socket).  Send ZEBRA_SHM_SWITCH as our own last socket message and
+ * move both directions over. */
+static void zclient_shm_activate(struct zclient *zclient)
+{
+	if (!zclient->shm_pending)
+		return;
+	zclient->shm_pending = false;
+
+	zebra_message_send(zclient, ZEBRA_SHM_SWITCH, VRF_DEFAULT);
+	zclient->shm_tx_active = true;
+	zclient->shm_rx_active = true;
+
+	if (zclient_debug)
+		zlog_debug("zclient: shm transport active on socket %d",
+			   zclient->sock);
+}
+
+void zclient_shstrtab_request(struct zclient *zclient)
+{
+	zebra_message_send(zclient, ZEBRA_SHM_STRTAB_GET, VRF_DEFAULT);
+}
+
+/* zebra's answer to ZEBRA_SHM_STRTAB_GET: the shm name of the segment. */
+static void zclient_shstrtab_reply(struct zclient *zclient)
+{
+	struct stream *s = zclient->ibuf;
+	char name[MAXPATHLEN];
+	uint16_t nlen;
+
+	if (zclient->strtab)
+		return;
+
+	STREAM_GETW(s, nlen);
+	if (nlen == 0 || nlen >= sizeof(name))
+		return;
+	STREAM_GET(name, s, nlen);
+	name[nlen] = '\0';
+
+	zclient->strtab = shstrtab_open(name);
+	if (!zclient->strtab)
+		zlog_warn("zclient: cannot map shared string table %s", name);
+	else if (zclient_debug)
+		zlog_debug("zclient: mapped shared string table %s", name);
+
+stream_failure:
+	return;
+}
+
+const char *zclient_shstrtab_intern(struct zclient *zclient, const char *str)
+{
+	const char *shared;
+	size_t len = strlen(str);
+	struct stream *s;
+
+	if (!zclient->strtab || len == 0 || len > UINT16_MAX)
+		return NULL;
+
+	shared = shstrtab_lookup(zclient->strtab, str);
+	if (shared)
+		return shared;
+
+	/* Not interned yet; ask zebra to add it.  The caller keeps its own
+	 * copy for now and picks up the shared one on a later lookup. */
+	s = zclient->obuf;
+	stream_reset(s);
+	zclient_create_header(s, ZEBRA_SHM_STRTAB_ADD, VRF_DEFAULT);
+	stream_putw(s, len);
+	stream_put(s, str, len);
+	stream_putw_at(s, 0, stream_get_endp(s));
+	zclient_send_message(zclient);
+
+	return NULL;
+}
+
+/* Move one just-built obuf message onto the tx ring, spilling to
+ * shm_outq (drained by zclient_shm_flush) when the ring is full. */
+static int zclient_shm_send(struct zclient *zclient)
+{
+	struct stream *s;
+	size_t want = stream_get_endp(zclient->obuf);
+	size_t done = 0;
+
+	if (stream_fifo_head(zclient->shm_outq) == NULL) {
+		done = zshm_ring_put(&zclient->shm_tx,
+				     STREAM_DATA(zclient->obuf), want);
+		if (done)
+			zshm_ring_kick(&zclient->shm_tx);
+		if (done == want)
+			return 0;
+	}
+
+	/* Ring full: keep the remainder in order behind earlier spills,
+	 * using getp as the sent-so-far cursor. */
+	s = stream_dup(zclient->obuf);
+	stream_set_getp(s, done);
+	stream_fifo_push(zclient->shm_outq, s);
+	if (!zclient->t_shm_flush)
+		thread_add_timer_msec(zclient->master, zclient_shm_flush,
+				      zclient, 1, &zclient->t_shm_flush);
+	return 0;
+}
+
+static int zclient_shm_flush(struct thread *thread)
+{
+	struct zclient *zclient = THREAD_ARG(thread);
+	struct stream *s;
+	bool wrote = false;
+
+	zclient->t_shm_flush = NULL;
+
+	while ((s = stream_fifo_head(zclient->shm_outq)) != NULL) {
+		size_t left = stream_get_endp(s) - stream_get_getp(s);
+		size_t done =
+			zshm_ring_put(&zclient->shm_tx,
+				      STREAM_DATA(s) + stream_get_getp(s),
+				      left);
+
+		wrote |= done != 0;
+		if (done < left) {
+			/* Still full; the consumer will drain it shortly. */
+			stream_set_getp(s, stream_get_getp(s) + done);
+			thread_add_timer_msec(zclient->master,
+					      zclient_shm_flush, zclient, 1,
+					      &zclient->t_shm_flush);
+			break;
+		}
+		stream_fifo_pop(zclient->shm_outq);
+		stream_free(s);
+	}
+
+	if (wrote)
+		zshm_ring_kick(&zclient->shm_tx);
+	return 0;
+}
+
+/* Receive path: drain the doorbell, then lift complete messages off the
+ * ring into ibuf and dispatch them exactly like the socket path does. */
+static int zclient_shm_read(struct thread *thread)
+{
+	struct zclient *zclient = THREAD_ARG(thread);
+	uint8_t buf[4096];
+
+	zclient->t_shm_read = NULL;
+	zshm_ring_doorbell_drain(&zclient->shm_rx);
+
+	for (;;) {
+		size_t already = stream_get_endp(zclient->ibuf);
+		uint16_t length, command;
+		uint8_t marker, version;
+		vrf_id_t vrf_id;
+		size_t n;
+
+		if (already < ZEBRA_HEADER_SIZE) {
+			n = zshm_ring_get(&zclient->shm_rx, buf,
+					  ZEBRA_HEADER_SIZE - already);
+			stream_put(zclient->ibuf, buf, n);
+			already += n;
+			if (already < ZEBRA_HEADER_SIZE)
+				/* Partial header; wait for the next kick. */
+				break;
+		}
+
+		stream_set_getp(zclient->ibuf, 0);
+		length = stream_getw(zclient->ibuf);
+		marker = stream_getc(zclient->ibuf);
+		version = stream_getc(zclient->ibuf);
+		vrf_id = stream_getl(zclient->ibuf);
+		command = stream_getw(zclient->ibuf);
+
+		if (marker != ZEBRA_HEADER_MARKER || version != ZSERV_VERSION
+		    || length < ZEBRA_HEADER_SIZE) {
+			flog_err(EC_LIB_ZAPI_MISSMATCH,
+				 "%s: corrupt header on shm ring (socket %d)",
+				 __func__, zclient->sock);
+			return zclient_failed(zclient);
+		}
+
+		if (length > STREAM_SIZE(zclient->ibuf)) {
+			struct stream *ns = stream_new(length);
+
+			stream_copy(ns, zclient->ibuf);
+			stream_free(zclient->ibuf);
+			zclient->ibuf = ns;
+		}
+
+		while (already < length) {
+			n = zshm_ring_get(&zclient->shm_rx, buf,
+					  MIN((size_t)(length - already),
+					      sizeof(buf)));
+			if (n == 0)
+				break;
+			stream_put(zclient->ibuf, buf, n);
+			already += n;
+		}
+		if (already < length)
+			break;
+
+		zclient_dispatch(zclient, command, length - ZEBRA_HEADER_SIZE,
+				 vrf_id);
+		if (zclient->sock < 0)
+			/* Connection was closed during packet processing. */
+			return -1;
+		stream_reset(zclient->ibuf);
+	}
+
+	zclient_event(ZCLIENT_SHM_READ, zclient);
+	return 0;
+}
+
 int zclient_start(struct zclient *zclient)
 {
 	if (zclient_debug)
@@ -585,6 +909,10 @@ int zclient_start(struct zclient *zclient)
 		zlog_debug("zclient connect success with socket [%d]",
 			   zclient->sock);
 
+	/* Offer the shared-memory transport before any other traffic. */
+	if (zclient->use_shm)
+		zclient_shm_hello(zclient);
+
 	/* Create read thread. */
 	zclient_event(ZCLIENT_READ, zclient);
 
@@ -756,11 +1084,6 @@ int zapi_route_encode(uint8_t cmd, struct stream *s, struct zapi_route *api)
 			 __PRETTY_FUNCTION__, api->type);
 		return -1;
 	}
-	stream_putc(s, api->type);
-
-	stream_putw(s, api->instance);
-	stream_putl(s, api->flags);
-	stream_putc(s, api->message);
 
 	if (api->safi < SAFI_UNICAST || api->safi >= SAFI_MAX) {
 		flog_err(EC_LIB_ZAPI_ENCODE,
@@ -768,7 +1091,14 @@ int zapi_route_encode(uint8_t cmd, struct stream *s, struct zapi_route *api)
 			 __PRETTY_FUNCTION__, api->safi);
 		return -1;
 	}
-	stream_putc(s, api->safi);
+
+	if (zapi_route_fixed_encode(s, api->type, api->instance, api->flags,
+				    api->message, api->safi) < 0) {
+		flog_err(EC_LIB_ZAPI_ENCODE,
+			 "%s: stream too small for route header",
+			 __PRETTY_FUNCTION__);
+		return -1;
+	}
 
 	/* Put prefix information. */
 	stream_putc(s, api->prefix.family);
@@ -801,9 +1131,14 @@ int zapi_route_encode(uint8_t cmd, struct stream *s, struct zapi_route *api)
 		for (i = 0; i < api->nexthop_num; i++) {
 			api_nh = &api->nexthops[i];
 
-			stream_putl(s, api_nh->vrf_id);
-			stream_putc(s, api_nh->type);
-			stream_putc(s, api_nh->onlink);
+			if (zapi_nexthop_fixed_encode(s, api_nh->vrf_id,
+						      api_nh->type,
+						      api_nh->onlink) < 0) {
+				flog_err(EC_LIB_ZAPI_ENCODE,
+					 "%s: stream too small for nexthop",
+					 __PRETTY_FUNCTION__);
+				return -1;
+			}
 			switch (api_nh->type) {
 			case NEXTHOP_TYPE_BLACKHOLE:
 				stream_putc(s, api_nh->bh_type);
@@ -880,10 +1215,16 @@ int zapi_route_decode(struct stream *s, struct zapi_route *api)
 	struct zapi_nexthop *api_nh;
 	int i;
 
+	uint8_t safi;
+
 	memset(api, 0, sizeof(*api));
 
 	/* Type, flags, message. */
-	STREAM_GETC(s, api->type);
+	if (zapi_route_fixed_decode(s, &api->type, &api->instance, &api->flags,
+				    &api->message, &safi) < 0)
+		goto stream_failure;
+	api->safi = safi;
+
 	if (api->type >= ZEBRA_ROUTE_MAX) {
 		flog_err(EC_LIB_ZAPI_ENCODE,
 			 "%s: Specified route type: %d is not a legal value\n",
@@ -891,10 +1232,6 @@ int zapi_route_decode(struct stream *s, struct zapi_route *api)
 		return -1;
 	}
 
-	STREAM_GETW(s, api->instance);
-	STREAM_GETL(s, api->flags);
-	STREAM_GETC(s, api->message);
-	STREAM_GETC(s, api->safi);
 	if (api->safi < SAFI_UNICAST || api->safi >= SAFI_MAX) {
 		flog_err(EC_LIB_ZAPI_ENCODE,
 			 "%s: Specified route SAFI (%u) is not a legal value\n",
@@ -966,11 +1303,16 @@ int zapi_route_decode(struct stream *s, struct zapi_route *api)
 		}
 
 		for (i = 0; i < api->nexthop_num; i++) {
+			uint8_t nh_type, nh_onlink;
+
 			api_nh = &api->nexthops[i];
 
-			STREAM_GETL(s, api_nh->vrf_id);
-			STREAM_GETC(s, api_nh->type);
-			STREAM_GETC(s, api_nh->onlink);
+			if (zapi_nexthop_fixed_decode(s, &api_nh->vrf_id,
+						      &nh_type, &nh_onlink)
+			    < 0)
+				goto stream_failure;
+			api_nh->type = nh_type;
+			api_nh->onlink = nh_onlink;
 			switch (api_nh->type) {
 			case NEXTHOP_TYPE_BLACKHOLE:
 				STREAM_GETC(s, api_nh->bh_type);
@@ -1036,6 +1378,112 @@ stream_failure:
 	return 0;
 }
 
+/*
+ * Bulk route install.  A ZEBRA_ROUTE_ADD_BULK message is a regular
+ * route message body (the "template", carrying the first prefix)
+ * followed by a count of additional prefixes that share every other
+ * attribute of the template - type, flags, nexthops, metric and so on.
+ * This lets a daemon announce many prefixes resolving over the same
+ * nexthop set in a single zserv message instead of one per prefix.
+ */
+int zapi_route_encode_bulk(uint8_t cmd, struct stream *s,
+			   struct zapi_route *api,
+			   const struct prefix *prefixes, uint16_t prefix_num)
+{
+	int i;
+	int psize;
+
+	if (prefix_num > ZAPI_BULK_ROUTES_MAX) {
+		flog_err(EC_LIB_ZAPI_ENCODE,
+			 "%s: can't encode %u extra prefixes (maximum is %u)",
+			 __func__, prefix_num, ZAPI_BULK_ROUTES_MAX);
+		return -1;
+	}
+
+	/* The prefix block has no room for per-route source prefixes. */
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_SRCPFX)) {
+		flog_err(EC_LIB_ZAPI_ENCODE,
+			 "%s: SRC prefix cannot be used in a bulk message",
+			 __func__);
+		return -1;
+	}
+
+	if (zapi_route_encode(cmd, s, api) < 0)
+		return -1;
+
+	stream_putw(s, prefix_num);
+	for (i = 0; i < prefix_num; i++) {
+		stream_putc(s, prefixes[i].family);
+		psize = PSIZE(prefixes[i].prefixlen);
+		stream_putc(s, prefixes[i].prefixlen);
+		stream_write(s, (const uint8_t *)&prefixes[i].u.prefix, psize);
+	}
+
+	/* Rewrite the length now that the prefix block is appended. */
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	return 0;
+}
+
+int zapi_route_decode_bulk(struct stream *s, struct zapi_route *api,
+			   struct prefix *prefixes, uint16_t *prefix_num)
+{
+	uint16_t num;
+	int i;
+
+	*prefix_num = 0;
+
+	if (zapi_route_decode(s, api) < 0)
+		return -1;
+
+	STREAM_GETW(s, num);
+	if (num > ZAPI_BULK_ROUTES_MAX) {
+		flog_err(EC_LIB_ZAPI_ENCODE,
+			 "%s: invalid number of bulk prefixes (%u)", __func__,
+			 num);
+		return -1;
+	}
+
+	for (i = 0; i < num; i++) {
+		memset(&prefixes[i], 0, sizeof(prefixes[i]));
+		STREAM_GETC(s, prefixes[i].family);
+		STREAM_GETC(s, prefixes[i].prefixlen);
+		switch (prefixes[i].family) {
+		case AF_INET:
+			if (prefixes[i].prefixlen > IPV4_MAX_PREFIXLEN)
+				return -1;
+			break;
+		case AF_INET6:
+			if (prefixes[i].prefixlen > IPV6_MAX_PREFIXLEN)
+				return -1;
+			break;
+		default:
+			flog_err(EC_LIB_ZAPI_ENCODE,
+				 "%s: Specified family %d is not v4 or v6",
+				 __func__, prefixes[i].family);
+			return -1;
+		}
+		STREAM_GET(&prefixes[i].u.prefix, s,
+			   PSIZE(prefixes[i].prefixlen));
+	}
+
+	*prefix_num = num;
+	return 0;
+
+stream_failure:
+	return -1;
+}
+
+int zclient_route_send_bulk(struct zclient *zclient, struct zapi_route *api,
+			    const struct prefix *prefixes, uint16_t prefix_num)
+{
+	if (zapi_route_encode_bulk(ZEBRA_ROUTE_ADD_BULK, zclient->obuf, api,
+				   prefixes, prefix_num)
+	    < 0)
+		return -1;
+	return zclient_send_message(zclient);
+}
+
 static void zapi_encode_prefix(struct stream *s, struct prefix *p,
 			       uint8_t family)
 {
@@ -2503,11 +2951,42 @@ static int zclient_read(struct thread *thread)
 
 	length -= ZEBRA_HEADER_SIZE;
 
+	zclient_dispatch(zclient, command, length, vrf_id);
+
+	if (zclient->sock < 0)
+		/* Connection was closed during packet processing. */
+		return -1;
+
+	/* Register read thread. */
+	stream_reset(zclient->ibuf);
+	if (zclient->shm_rx_active)
+		/* The message above switched us over to the ring. */
+		zclient_event(ZCLIENT_SHM_READ, zclient);
+	else
+		zclient_event(ZCLIENT_READ, zclient);
+
+	return 0;
+}
+
+/*
+ * Hand one received message (header already consumed from ibuf) to the
+ * daemon's callbacks.  Shared between the socket and shared-memory
+ * receive paths.
+ */
+static void zclient_dispatch(struct zclient *zclient, uint16_t command,
+			     uint16_t length, vrf_id_t vrf_id)
+{
 	if (zclient_debug)
 		zlog_debug("zclient 0x%p command 0x%x VRF %u\n",
 			   (void *)zclient, command, vrf_id);
 
 	switch (command) {
+	case ZEBRA_SHM_HELLO:
+		zclient_shm_activate(zclient);
+		break;
+	case ZEBRA_SHM_STRTAB_GET:
+		zclient_shstrtab_reply(zclient);
+		break;
 	case ZEBRA_CAPABILITIES:
 		zclient_capability_decode(command, zclient, length, vrf_id);
 		break;
@@ -2701,16 +3180,6 @@ static int zclient_read(struct thread *thread)
 	default:
 		break;
 	}
-
-	if (zclient->sock < 0)
-		/* Connection was closed during packet processing. */
-		return -1;
-
-	/* Register read thread. */
-	stream_reset(zclient->ibuf);
-	zclient_event(ZCLIENT_READ, zclient);
-
-	return 0;
 }
 
 void zclient_redistribute(int command, struct zclient *zclient, afi_t afi,
@@ -2792,6 +3261,12 @@ static void zclient_event(enum event event, struct zclient *zclient)
 		thread_add_read(zclient->master, zclient_read, zclient,
 				zclient->sock, &zclient->t_read);
 		break;
+	case ZCLIENT_SHM_READ:
+		zclient->t_shm_read = NULL;
+		thread_add_read(zclient->master, zclient_shm_read, zclient,
+				zclient->shm_rx.doorbell,
+				&zclient->t_shm_read);
+		break;
 	}
 }
 
@@ -38,6 +38,11 @@
 
 #include "mlag.h"
 
+/* For the shared-memory ring transport. */
+#include "zshmring.h"
+
+struct shstrtab;
+
 /* For input/output buffer to zebra. */
 #define ZEBRA_MAX_PACKET_SIZ          16384
 
@@ -164,6 +169,11 @@ typedef enum {
 	ZEBRA_IPTABLE_DELETE,
 	ZEBRA_IPTABLE_NOTIFY_OWNER,
 	ZEBRA_VXLAN_FLOOD_CONTROL,
+	ZEBRA_ROUTE_ADD_BULK,
+	ZEBRA_SHM_HELLO,
+	ZEBRA_SHM_SWITCH,
+	ZEBRA_SHM_STRTAB_GET,
+	ZEBRA_SHM_STRTAB_ADD,
 } zebra_message_types_t;
 
 struct redist_proto {
@@ -188,6 +198,9 @@ struct zclient {
 	/* Do we care about failure events for route install? */
 	bool receive_notify;
 
+	/* Offer the shared-memory ring transport at connect time? */
+	bool use_shm;
+
 	/* Socket to zebra daemon. */
 	int sock;
 
@@ -210,6 +223,24 @@ struct zclient {
 	/* Thread to write buffered data to zebra. */
 	struct thread *t_write;
 
+	/* Shared-memory ring transport (see zclient_options.use_shm).
+	 * Negotiated at zclient_start(); while inactive the plain socket
+	 * path is used.  shm_tx carries this daemon's messages to zebra,
+	 * shm_rx the reverse direction. */
+	struct zshm_ring shm_tx;
+	struct zshm_ring shm_rx;
+	bool shm_tx_active;
+	bool shm_rx_active;
+	bool shm_pending; /* rings offered, no answer from zebra yet */
+	struct stream_fifo *shm_outq; /* spill queue when shm_tx is full */
+	struct thread *t_shm_read;
+	struct thread *t_shm_flush;
+
+	/* Shared string intern table, mapped read-only after zebra answers
+	 * zclient_shstrtab_request().  Survives session resets; identical
+	 * strings interned by co-located daemons share physical pages. */
+	struct shstrtab *strtab;
+
 	/* Redistribute information. */
 	uint8_t redist_default; /* clients protocol */
 	unsigned short instance;
@@ -360,6 +391,13 @@ struct zapi_route {
 	uint32_t tableid;
 };
 
+/*
+ * Upper bound on the number of additional prefixes that may ride in a
+ * single ZEBRA_ROUTE_ADD_BULK message; keeps the worst-case message
+ * (full nexthop set plus prefix block) within the zapi stream size.
+ */
+#define ZAPI_BULK_ROUTES_MAX 64
+
 struct zapi_pw {
 	char ifname[IF_NAMESIZE];
 	ifindex_t ifindex;
@@ -432,6 +470,10 @@ enum zebra_neigh_state { ZEBRA_NEIGH_INACTIVE = 0, ZEBRA_NEIGH_ACTIVE = 1 };
 
 struct zclient_options {
 	bool receive_notify;
+	/* Offer the shared-memory ring transport to zebra at connect time;
+	 * falls back to the unix socket transparently if zebra does not
+	 * answer the offer. */
+	bool use_shm;
 };
 
 extern struct zclient_options zclient_options_default;
@@ -498,6 +540,17 @@ extern void zclient_redistribute_default(int command, struct zclient *,
    Returns 0 for success or -1 on an I/O error. */
 extern int zclient_send_message(struct zclient *);
 
+/* Ask zebra for the shared string intern segment (opt-in).  The reply is
+ * handled internally; once it arrives, zclient->strtab is mapped. */
+extern void zclient_shstrtab_request(struct zclient *zclient);
+
+/* Resolve 'str' to its copy in the shared intern segment.  If the string
+ * is not interned yet, zebra is asked to add it and NULL is returned; the
+ * caller keeps using its own copy and may retry on a later occasion.
+ * Returned pointers stay valid for the lifetime of the process. */
+extern const char *zclient_shstrtab_intern(struct zclient *zclient,
+					   const char *str);
+
 /* create header for command, length to be filled in by user later */
 extern void zclient_create_header(struct stream *, uint16_t, vrf_id_t);
 /*
@@ -601,6 +654,17 @@ extern int zclient_send_rnh(struct zclient *zclient, int command,
 			    vrf_id_t vrf_id);
 extern int zapi_route_encode(uint8_t, struct stream *, struct zapi_route *);
 extern int zapi_route_decode(struct stream *, struct zapi_route *);
+extern int zclient_route_send_bulk(struct zclient *zclient,
+				   struct zapi_route *api,
+				   const struct prefix *prefixes,
+				   uint16_t prefix_num);
+extern int zapi_route_encode_bulk(uint8_t cmd, struct stream *s,
+				  struct zapi_route *api,
+				  const struct prefix *prefixes,
+				  uint16_t prefix_num);
+extern int zapi_route_decode_bulk(struct stream *s, struct zapi_route *api,
+				  struct prefix *prefixes,
+				  uint16_t *prefix_num);
 bool zapi_route_notify_decode(struct stream *s, struct prefix *p,
 			      uint32_t *tableid,
 			      enum zapi_route_notify_owner *note);
@@ -0,0 +1,277 @@
+/*
+ * Shared-memory SPSC ring transport for the ZAPI byte stream.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include <sys/mman.h>
+#ifdef GNU_LINUX
+#include <sys/eventfd.h>
+#endif
+
+#include "zshmring.h"
+#include "log.h"
+#include "network.h"
+
+#ifdef GNU_LINUX
+
+bool zshm_available(void)
+{
+	return true;
+}
+
+/* Round up to the next power of two (result >= 2). */
+static uint32_t zshm_pow2(uint32_t val)
+{
+	uint32_t size = 2;
+
+	while (size < val && size != 0)
+		size <<= 1;
+	return size ? size : (1u << 31);
+}
+
+/*
+ * Create the backing segment as an unlinked temporary file, preferring
+ * tmpfs.  A plain file works too (mmap MAP_SHARED is what matters); the
+ * name is gone before the fd is ever handed to a peer.
+ */
+static int zshm_segment_create(size_t len)
+{
+	static const char *const dirs[] = {"/dev/shm", "/tmp", NULL};
+	char path[MAXPATHLEN];
+	int fd, i;
+
+	for (i = 0; dirs[i]; i++) {
+		snprintf(path, sizeof(path), "%s/frr-zshm-XXXXXX", dirs[i]);
+		fd = mkstemp(path);
+		if (fd < 0)
+			continue;
+		unlink(path);
+		if (ftruncate(fd, len) < 0) {
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+	return -1;
+}
+
+int zshm_ring_create(struct zshm_ring *ring, uint32_t size)
+{
+	size_t maplen;
+
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = ring->doorbell = -1;
+
+	size = zshm_pow2(size);
+	maplen = sizeof(struct zshm_ring_shared) + size;
+
+	ring->fd = zshm_segment_create(maplen);
+	if (ring->fd < 0)
+		goto fail;
+
+	ring->doorbell = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (ring->doorbell < 0)
+		goto fail;
+
+	ring->sh = mmap(NULL, maplen, PROT_READ | PROT_WRITE, MAP_SHARED,
+			ring->fd, 0);
+	if (ring->sh == MAP_FAILED) {
+		ring->sh = NULL;
+		goto fail;
+	}
+
+	ring->maplen = maplen;
+	ring->sh->size = size;
+	ring->sh->magic = ZSHM_RING_MAGIC;
+	set_cloexec(ring->fd);
+	return 0;
+
+fail:
+	zshm_ring_close(ring);
+	return -1;
+}
+
+int zshm_ring_attach(struct zshm_ring *ring, int fd, int doorbell)
+{
+	struct stat st;
+	struct zshm_ring_shared *sh;
+	size_t maplen;
+
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = ring->doorbell = -1;
+
+	if (fstat(fd, &st) < 0)
+		return -1;
+	maplen = st.st_size;
+	if (maplen <= sizeof(struct zshm_ring_shared))
+		return -1;
+
+	sh = mmap(NULL, maplen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (sh == MAP_FAILED)
+		return -1;
+
+	/* Validate what the peer claims against the mapping we got. */
+	if (sh->magic != ZSHM_RING_MAGIC || sh->size < 2
+	    || (sh->size & (sh->size - 1))
+	    || maplen < sizeof(struct zshm_ring_shared) + sh->size) {
+		munmap(sh, maplen);
+		return -1;
+	}
+
+	ring->sh = sh;
+	ring->maplen = maplen;
+	ring->fd = fd;
+	ring->doorbell = doorbell;
+	set_nonblocking(doorbell);
+	return 0;
+}
+
+void zshm_ring_close(struct zshm_ring *ring)
+{
+	if (ring->sh)
+		munmap(ring->sh, ring->maplen);
+	if (ring->fd >= 0)
+		close(ring->fd);
+	if (ring->doorbell >= 0)
+		close(ring->doorbell);
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = ring->doorbell = -1;
+}
+
+size_t zshm_ring_put(struct zshm_ring *ring, const void *buf, size_t len)
+{
+	struct zshm_ring_shared *sh = ring->sh;
+	uint32_t head = atomic_load_explicit(&sh->head, memory_order_acquire);
+	uint32_t tail = atomic_load_explicit(&sh->tail, memory_order_relaxed);
+	uint32_t space = sh->size - (tail - head);
+	uint32_t offset, chunk;
+
+	if (len > space)
+		len = space;
+	if (len == 0)
+		return 0;
+
+	offset = tail & (sh->size - 1);
+	chunk = MIN(len, (size_t)(sh->size - offset));
+	memcpy(sh->data + offset, buf, chunk);
+	if (chunk < len)
+		memcpy(sh->data, (const char *)buf + chunk, len - chunk);
+
+	atomic_store_explicit(&sh->tail, tail + len, memory_order_release);
+	return len;
+}
+
+size_t zshm_ring_get(struct zshm_ring *ring, void *buf, size_t len)
+{
+	struct zshm_ring_shared *sh = ring->sh;
+	uint32_t tail = atomic_load_explicit(&sh->tail, memory_order_acquire);
+	uint32_t head = atomic_load_explicit(&sh->head, memory_order_relaxed);
+	uint32_t avail = tail - head;
+	uint32_t offset, chunk;
+
+	if (len > avail)
+		len = avail;
+	if (len == 0)
+		return 0;
+
+	offset = head & (sh->size - 1);
+	chunk = MIN(len, (size_t)(sh->size - offset));
+	memcpy(buf, sh->data + offset, chunk);
+	if (chunk < len)
+		memcpy((char *)buf + chunk, sh->data, len - chunk);
+
+	atomic_store_explicit(&sh->head, head + len, memory_order_release);
+	return len;
+}
+
+size_t zshm_ring_readable(const struct zshm_ring *ring)
+{
+	struct zshm_ring_shared *sh = ring->sh;
+	uint32_t tail = atomic_load_explicit(&sh->tail, memory_order_acquire);
+	uint32_t head = atomic_load_explicit(&sh->head, memory_order_relaxed);
+
+	return tail - head;
+}
+
+void zshm_ring_kick(struct zshm_ring *ring)
+{
+	uint64_t one = 1;
+
+	if (write(ring->doorbell, &one, sizeof(one)) < 0 && errno != EAGAIN)
+		zlog_warn("%s: eventfd write failed: %s", __func__,
+			  safe_strerror(errno));
+}
+
+void zshm_ring_doorbell_drain(struct zshm_ring *ring)
+{
+	uint64_t val;
+
+	while (read(ring->doorbell, &val, sizeof(val)) > 0)
+		;
+}
+
+#else /* !GNU_LINUX */
+
+/* No eventfd: the negotiation is simply never attempted. */
+
+bool zshm_available(void)
+{
+	return false;
+}
+
+int zshm_ring_create(struct zshm_ring *ring, uint32_t size)
+{
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = ring->doorbell = -1;
+	return -1;
+}
+
+int zshm_ring_attach(struct zshm_ring *ring, int fd, int doorbell)
+{
+	return -1;
+}
+
+void zshm_ring_close(struct zshm_ring *ring)
+{
+}
+
+size_t zshm_ring_put(struct zshm_ring *ring, const void *buf, size_t len)
+{
+	return 0;
+}
+
+size_t zshm_ring_get(struct zshm_ring *ring, void *buf, size_t len)
+{
+	return 0;
+}
+
+size_t zshm_ring_readable(const struct zshm_ring *ring)
+{
+	return 0;
+}
+
+void zshm_ring_kick(struct zshm_ring *ring)
+{
+}
+
+void zshm_ring_doorbell_drain(struct zshm_ring *ring)
+{
+}
+
+#endif /* GNU_LINUX */
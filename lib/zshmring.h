@@ -0,0 +1,100 @@
+/*
+ * Shared-memory SPSC ring transport for the ZAPI byte stream.
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _ZEBRA_ZSHMRING_H
+#define _ZEBRA_ZSHMRING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "frratomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A single-producer/single-consumer byte ring living in a shared mapping,
+ * with an eventfd doorbell the producer kicks after publishing data.  Two
+ * rings (one per direction) form a full ZAPI transport between co-located
+ * processes; the byte stream carried is the ordinary ZAPI framing, the
+ * ring is just an alternative to the unix socket that avoids the
+ * per-message write+read syscalls and kernel copies.
+ *
+ * The producer owns "tail", the consumer owns "head"; each side reads the
+ * other's position with acquire semantics and publishes its own with
+ * release semantics, so no locks are needed.
+ */
+struct zshm_ring_shared {
+	_Atomic uint32_t head; /* consumer position */
+	_Atomic uint32_t tail; /* producer position */
+	uint32_t size;	 /* data bytes, power of two */
+	uint32_t magic;
+	char data[];
+};
+
+#define ZSHM_RING_MAGIC 0x5a52494e /* "ZRIN" */
+
+/* Default per-direction ring size.  Must comfortably exceed the maximum
+ * ZAPI message length (uint16_t) so a message always fits when empty. */
+#define ZSHM_RING_DEFAULT_SIZE (4 * 1024 * 1024)
+
+/* Per-process view of a ring. */
+struct zshm_ring {
+	struct zshm_ring_shared *sh;
+	size_t maplen;
+	int fd;       /* backing memory segment */
+	int doorbell; /* eventfd; producer kicks it after writing */
+};
+
+/* Whether this platform can carry the transport at all (eventfd). */
+extern bool zshm_available(void);
+
+/* Create a new ring of 'size' data bytes (rounded up to a power of two)
+ * backed by an unlinked shared file plus a fresh eventfd.  Returns 0 on
+ * success, -1 on failure with the struct zeroed. */
+extern int zshm_ring_create(struct zshm_ring *ring, uint32_t size);
+
+/* Map a ring received from a peer (fd + doorbell, e.g. via SCM_RIGHTS).
+ * Validates the header.  Takes ownership of both descriptors on success;
+ * the caller keeps them on failure. */
+extern int zshm_ring_attach(struct zshm_ring *ring, int fd, int doorbell);
+
+/* Unmap and close; safe on a zeroed/never-opened ring. */
+extern void zshm_ring_close(struct zshm_ring *ring);
+
+/* Copy up to 'len' bytes in/out.  Both return the number of bytes
+ * actually transferred, which may be short (ring full/empty). */
+extern size_t zshm_ring_put(struct zshm_ring *ring, const void *buf,
+			    size_t len);
+extern size_t zshm_ring_get(struct zshm_ring *ring, void *buf, size_t len);
+
+/* Bytes currently readable (consumer side view). */
+extern size_t zshm_ring_readable(const struct zshm_ring *ring);
+
+/* Ring the doorbell after producing / drain it before consuming. */
+extern void zshm_ring_kick(struct zshm_ring *ring);
+extern void zshm_ring_doorbell_drain(struct zshm_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ZEBRA_ZSHMRING_H */
@@ -25,7 +25,6 @@
 
 enum nhrp_log_refs {
 	EC_NHRP_SWAN = NHRP_FERR_START,
-	EC_NHRP_RESOLVER,
 };
 
 extern void nhrp_error_init(void);
@@ -22,6 +22,13 @@ DEFINE_MTYPE_STATIC(NHRPD, NHRP_SHORTCUT, "NHRP shortcut")
 
 static struct route_table *shortcut_rib[AFI_MAX];
 
+/* Suppress duplicate resolution requests for the same destination while
+ * one is still in flight. */
+#define NHRP_SHORTCUT_RETRY_TIME 5
+/* Negative cache bounds for failed resolutions. */
+#define NHRP_SHORTCUT_BACKOFF_MIN 5
+#define NHRP_SHORTCUT_BACKOFF_MAX 300
+
 static int nhrp_shortcut_do_purge(struct thread *t);
 static void nhrp_shortcut_delete(struct nhrp_shortcut *s);
 static void nhrp_shortcut_send_resolution_req(struct nhrp_shortcut *s);
@@ -47,6 +54,13 @@ static int nhrp_shortcut_do_expire(struct thread *t)
 	s->expiring = 1;
 	nhrp_shortcut_check_use(s);
 
+	/* Retry negative-cached failures so the backoff keeps doubling
+	 * instead of resetting when the entry gets purged.  Once the cap
+	 * is reached, stay quiet and let the purge reclaim the entry. */
+	if (s->type == NHRP_CACHE_NEGATIVE && s->backoff
+	    && s->backoff < NHRP_SHORTCUT_BACKOFF_MAX)
+		nhrp_shortcut_send_resolution_req(s);
+
 	return 0;
 }
 
@@ -181,6 +195,27 @@ static struct nhrp_shortcut *nhrp_shortcut_get(struct prefix *p)
 	return s;
 }
 
+/* Negative-cache a failed resolution with exponential backoff: repeated
+ * failures double the hold time so a destination that keeps failing to
+ * resolve costs one request per backoff period instead of one per
+ * second of traffic. */
+static void nhrp_shortcut_failure_cache(struct nhrp_shortcut *s)
+{
+	char buf[PREFIX_STRLEN];
+
+	if (s->backoff)
+		s->backoff *= 2;
+	else
+		s->backoff = NHRP_SHORTCUT_BACKOFF_MIN;
+	if (s->backoff > NHRP_SHORTCUT_BACKOFF_MAX)
+		s->backoff = NHRP_SHORTCUT_BACKOFF_MAX;
+
+	debugf(NHRP_DEBUG_COMMON,
+	       "Shortcut %s: resolution failed, negative cache for %u seconds",
+	       prefix2str(s->p, buf, sizeof buf), s->backoff);
+	nhrp_shortcut_update_binding(s, NHRP_CACHE_NEGATIVE, NULL, s->backoff);
+}
+
 static void nhrp_shortcut_recv_resolution_rep(struct nhrp_reqid *reqid,
 					      void *arg)
 {
@@ -213,6 +248,7 @@ static void nhrp_shortcut_recv_resolution_rep(struct nhrp_reqid *reqid,
 		} else {
 			debugf(NHRP_DEBUG_COMMON,
 			       "Shortcut: Resolution failed");
+			nhrp_shortcut_failure_cache(s);
 		}
 		return;
 	}
@@ -241,6 +277,7 @@ static void nhrp_shortcut_recv_resolution_rep(struct nhrp_reqid *reqid,
 	if (!cie || cie->code != NHRP_CODE_SUCCESS) {
 		debugf(NHRP_DEBUG_COMMON, "Shortcut: CIE code %d",
 		       cie ? cie->code : -1);
+		nhrp_shortcut_failure_cache(s);
 		return;
 	}
 
@@ -298,6 +335,8 @@ static void nhrp_shortcut_recv_resolution_rep(struct nhrp_reqid *reqid,
 		}
 	}
 
+	s->backoff = 0;
+
 	debugf(NHRP_DEBUG_COMMON, "Shortcut: Resolution reply handled");
 }
 
@@ -309,6 +348,13 @@ static void nhrp_shortcut_send_resolution_req(struct nhrp_shortcut *s)
 	struct nhrp_interface *nifp;
 	struct nhrp_peer *peer;
 
+	/* One outstanding request per destination is enough: a hub
+	 * reroute makes every used shortcut and every following traffic
+	 * indication try to resolve at the same time. */
+	if (s->reqid.cb
+	    && monotime(NULL) - s->last_request < NHRP_SHORTCUT_RETRY_TIME)
+		return;
+
 	if (nhrp_route_address(NULL, &s->addr, NULL, &peer)
 	    != NHRP_ROUTE_NBMA_NEXTHOP)
 		return;
@@ -350,6 +396,7 @@ static void nhrp_shortcut_send_resolution_req(struct nhrp_shortcut *s)
 	nhrp_peer_send(peer, zb);
 	nhrp_peer_unref(peer);
 	zbuf_free(zb);
+	s->last_request = monotime(NULL);
 }
 
 void nhrp_shortcut_initiate(union sockunion *addr)
@@ -359,6 +406,11 @@ void nhrp_shortcut_initiate(union sockunion *addr)
 
 	sockunion2hostprefix(addr, &p);
 	s = nhrp_shortcut_get(&p);
+	/* Failed resolutions are negative cached; retries happen from the
+	 * expiry timer with backoff, not from the traffic that keeps
+	 * hitting the prefix. */
+	if (s && s->type == NHRP_CACHE_NEGATIVE && s->backoff && !s->expiring)
+		return;
 	if (s && s->type != NHRP_CACHE_INCOMPLETE) {
 		s->addr = *addr;
 		THREAD_OFF(s->t_timer);
@@ -16,6 +16,7 @@
 #include "zclient.h"
 #include "debug.h"
 #include "memory.h"
+#include "resolver.h"
 
 DECLARE_MGROUP(NHRPD)
 
@@ -84,15 +85,6 @@ static inline int notifier_active(struct notifier_list *l)
 	return !list_empty(&l->notifier_head);
 }
 
-struct resolver_query {
-	void (*callback)(struct resolver_query *, int n, union sockunion *);
-};
-
-void resolver_init(void);
-void resolver_resolve(struct resolver_query *query, int af,
-		      const char *hostname, void (*cb)(struct resolver_query *,
-						       int, union sockunion *));
-
 void nhrp_zebra_init(void);
 void nhrp_zebra_terminate(void);
 
@@ -238,6 +230,10 @@ struct nhrp_shortcut {
 
 	enum nhrp_cache_type type;
 	unsigned int holding_time;
+	/* Negative cache time for failed resolutions; doubles on each
+	 * consecutive failure, zeroed on success. */
+	unsigned int backoff;
+	time_t last_request;
 	unsigned route_installed : 1;
 	unsigned expiring : 1;
 
@@ -508,6 +508,49 @@ void ospf6_lsa_show(struct vty *vty, struct ospf6_lsa *lsa)
 }
 
 /* OSPFv3 LSA creation/deletion function */
+/* LSA bodies are shared: a working-list copy made by ospf6_lsa_copy()
+ * borrows its original's buffer instead of duplicating it, which is
+ * where memory and allocator time used to explode with many neighbors
+ * (one full body per neighbor on each retransmission list).  Every
+ * body therefore carries a reference count in the bytes just ahead of
+ * the header; the buffer goes away with its last holder.
+ */
+#define OSPF6_LSA_BODY_HEADROOM 8
+
+static unsigned int *ospf6_lsa_body_refcnt(struct ospf6_lsa_header *header)
+{
+	return (unsigned int *)(void *)((caddr_t)header
+					- OSPF6_LSA_BODY_HEADROOM);
+}
+
+struct ospf6_lsa_header *ospf6_lsa_body_alloc(uint16_t size)
+{
+	caddr_t buf;
+
+	buf = XMALLOC(MTYPE_OSPF6_LSA_HEADER, OSPF6_LSA_BODY_HEADROOM + size);
+	*(unsigned int *)(void *)buf = 1;
+
+	return (struct ospf6_lsa_header *)(buf + OSPF6_LSA_BODY_HEADROOM);
+}
+
+static void ospf6_lsa_body_ref(struct ospf6_lsa_header *header)
+{
+	(*ospf6_lsa_body_refcnt(header))++;
+}
+
+static void ospf6_lsa_body_unref(struct ospf6_lsa_header *header)
+{
+	unsigned int *refcnt = ospf6_lsa_body_refcnt(header);
+	void *buf;
+
+	assert(*refcnt > 0);
+	if (--*refcnt > 0)
+		return;
+
+	buf = refcnt;
+	XFREE(MTYPE_OSPF6_LSA_HEADER, buf);
+}
+
 struct ospf6_lsa *ospf6_lsa_create(struct ospf6_lsa_header *header)
 {
 	struct ospf6_lsa *lsa = NULL;
@@ -518,7 +561,7 @@ struct ospf6_lsa *ospf6_lsa_create(struct ospf6_lsa_header *header)
 	lsa_size = ntohs(header->length); /* XXX vulnerable */
 
 	/* allocate memory for this LSA */
-	new_header = XMALLOC(MTYPE_OSPF6_LSA_HEADER, lsa_size);
+	new_header = ospf6_lsa_body_alloc(lsa_size);
 
 	/* copy LSA from original header */
 	memcpy(new_header, header, lsa_size);
@@ -544,8 +587,7 @@ struct ospf6_lsa *ospf6_lsa_create_headeronly(struct ospf6_lsa_header *header)
 	struct ospf6_lsa_header *new_header = NULL;
 
 	/* allocate memory for this LSA */
-	new_header = XMALLOC(MTYPE_OSPF6_LSA_HEADER,
-			     sizeof(struct ospf6_lsa_header));
+	new_header = ospf6_lsa_body_alloc(sizeof(struct ospf6_lsa_header));
 
 	/* copy LSA from original header */
 	memcpy(new_header, header, sizeof(struct ospf6_lsa_header));
@@ -575,7 +617,7 @@ void ospf6_lsa_delete(struct ospf6_lsa *lsa)
 	THREAD_OFF(lsa->refresh);
 
 	/* do free */
-	XFREE(MTYPE_OSPF6_LSA_HEADER, lsa->header);
+	ospf6_lsa_body_unref(lsa->header);
 	XFREE(MTYPE_OSPF6_LSA, lsa);
 }
 
@@ -584,12 +626,15 @@ struct ospf6_lsa *ospf6_lsa_copy(struct ospf6_lsa *lsa)
 	struct ospf6_lsa *copy = NULL;
 
 	ospf6_lsa_age_current(lsa);
-	if (CHECK_FLAG(lsa->flag, OSPF6_LSA_HEADERONLY))
-		copy = ospf6_lsa_create_headeronly(lsa->header);
-	else
-		copy = ospf6_lsa_create(lsa->header);
-	assert(copy->lock == 0);
 
+	/* The copy shares the original's body instead of duplicating
+	 * it; only the bookkeeping structure is allocated. */
+	copy = XCALLOC(MTYPE_OSPF6_LSA, sizeof(struct ospf6_lsa));
+	copy->header = lsa->header;
+	ospf6_lsa_body_ref(copy->header);
+
+	memcpy(copy->name, lsa->name, sizeof(copy->name));
+	copy->flag = CHECK_FLAG(lsa->flag, OSPF6_LSA_HEADERONLY);
 	copy->birth = lsa->birth;
 	copy->originated = lsa->originated;
 	copy->received = lsa->received;
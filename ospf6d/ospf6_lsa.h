@@ -220,6 +220,7 @@ extern void ospf6_lsa_show_dump(struct vty *vty, struct ospf6_lsa *lsa);
 extern void ospf6_lsa_show_internal(struct vty *vty, struct ospf6_lsa *lsa);
 extern void ospf6_lsa_show(struct vty *vty, struct ospf6_lsa *lsa);
 
+extern struct ospf6_lsa_header *ospf6_lsa_body_alloc(uint16_t size);
 extern struct ospf6_lsa *ospf6_lsa_create(struct ospf6_lsa_header *header);
 extern struct ospf6_lsa *
 ospf6_lsa_create_headeronly(struct ospf6_lsa_header *header);
@@ -26,6 +26,8 @@
 #include "prefix.h"
 #include "table.h"
 #include "vty.h"
+#include "hash.h"
+#include "jhash.h"
 
 #include "ospf6_proto.h"
 #include "ospf6_lsa.h"
@@ -34,6 +36,23 @@
 #include "ospf6d.h"
 #include "bitfield.h"
 
+static unsigned int ospf6_lsdb_hash_key(void *data)
+{
+	struct ospf6_lsa *lsa = data;
+
+	return jhash_3words(lsa->header->id, lsa->header->adv_router,
+			    lsa->header->type, 0);
+}
+
+static bool ospf6_lsdb_hash_cmp(const void *d1, const void *d2)
+{
+	const struct ospf6_lsa *lsa1 = d1, *lsa2 = d2;
+
+	return lsa1->header->type == lsa2->header->type
+	       && lsa1->header->id == lsa2->header->id
+	       && lsa1->header->adv_router == lsa2->header->adv_router;
+}
+
 struct ospf6_lsdb *ospf6_lsdb_create(void *data)
 {
 	struct ospf6_lsdb *lsdb;
@@ -43,6 +62,8 @@ struct ospf6_lsdb *ospf6_lsdb_create(void *data)
 
 	lsdb->data = data;
 	lsdb->table = route_table_init();
+	lsdb->index = hash_create(ospf6_lsdb_hash_key, ospf6_lsdb_hash_cmp,
+				  "OSPF6 LSDB index");
 	return lsdb;
 }
 
@@ -50,6 +71,7 @@ void ospf6_lsdb_delete(struct ospf6_lsdb *lsdb)
 {
 	if (lsdb != NULL) {
 		ospf6_lsdb_remove_all(lsdb);
+		hash_free(lsdb->index);
 		route_table_finish(lsdb->table);
 		XFREE(MTYPE_OSPF6_LSDB, lsdb);
 	}
@@ -107,6 +129,10 @@ void ospf6_lsdb_add(struct ospf6_lsa *lsa, struct ospf6_lsdb *lsdb)
 	lsa->rn = current;
 	ospf6_lsa_lock(lsa);
 
+	if (old)
+		hash_release(lsdb->index, old);
+	hash_get(lsdb->index, lsa, hash_alloc_intern);
+
 	if (!old) {
 		lsdb->count++;
 
@@ -156,6 +182,7 @@ void ospf6_lsdb_remove(struct ospf6_lsa *lsa, struct ospf6_lsdb *lsdb)
 	node = route_node_lookup(lsdb->table, (struct prefix *)&key);
 	assert(node && node->info == lsa);
 
+	hash_release(lsdb->index, lsa);
 	node->info = NULL;
 	lsdb->count--;
 
@@ -173,23 +200,19 @@ struct ospf6_lsa *ospf6_lsdb_lookup(uint16_t type, uint32_t id,
 				    uint32_t adv_router,
 				    struct ospf6_lsdb *lsdb)
 {
-	struct route_node *node;
-	struct prefix_ipv6 key;
+	struct ospf6_lsa key;
+	struct ospf6_lsa_header header;
 
 	if (lsdb == NULL)
 		return NULL;
 
-	memset(&key, 0, sizeof(key));
-	ospf6_lsdb_set_key(&key, &type, sizeof(type));
-	ospf6_lsdb_set_key(&key, &adv_router, sizeof(adv_router));
-	ospf6_lsdb_set_key(&key, &id, sizeof(id));
-
-	node = route_node_lookup(lsdb->table, (struct prefix *)&key);
-	if (node == NULL || node->info == NULL)
-		return NULL;
+	memset(&header, 0, sizeof(header));
+	header.type = type;
+	header.id = id;
+	header.adv_router = adv_router;
+	key.header = &header;
 
-	route_unlock_node(node);
-	return (struct ospf6_lsa *)node->info;
+	return hash_lookup(lsdb->index, &key);
 }
 
 struct ospf6_lsa *ospf6_lsdb_lookup_next(uint16_t type, uint32_t id,
@@ -28,6 +28,10 @@
 struct ospf6_lsdb {
 	void *data; /* data structure that holds this lsdb */
 	struct route_table *table;
+	/* Direct (type, LS-ID, advertising router) index over the table
+	   above, for O(1) exact lookups; the table remains authoritative
+	   for ordered iteration. */
+	struct hash *index;
 	uint32_t count;
 	void (*hook_add)(struct ospf6_lsa *);
 	void (*hook_remove)(struct ospf6_lsa *);
@@ -103,11 +103,33 @@ static int ospf6_vertex_id_cmp(void *a, void *b)
 	return ret;
 }
 
+/* An SPF run creates and destroys vertices in bulk.  Keep a bounded
+ * free list of fully constructed ones - the struct together with its
+ * two lists - so steady-state runs mostly stay out of the allocator.
+ * Pooled vertices are chained through their (otherwise NULL) parent
+ * pointer. */
+#define OSPF6_VERTEX_POOL_MAX 512
+static struct ospf6_vertex *vertex_pool;
+static unsigned int vertex_pool_count;
+
 static struct ospf6_vertex *ospf6_vertex_create(struct ospf6_lsa *lsa)
 {
 	struct ospf6_vertex *v;
 
-	v = XMALLOC(MTYPE_OSPF6_VERTEX, sizeof(struct ospf6_vertex));
+	if (vertex_pool) {
+		v = vertex_pool;
+		vertex_pool = v->parent;
+		vertex_pool_count--;
+	} else {
+		v = XMALLOC(MTYPE_OSPF6_VERTEX, sizeof(struct ospf6_vertex));
+
+		v->nh_list = list_new();
+		v->nh_list->cmp = (int (*)(void *, void *))ospf6_nexthop_cmp;
+		v->nh_list->del = (void (*)(void *))ospf6_nexthop_delete;
+
+		v->child_list = list_new();
+		v->child_list->cmp = ospf6_vertex_id_cmp;
+	}
 
 	/* type */
 	if (ntohs(lsa->header->type) == OSPF6_LSTYPE_ROUTER) {
@@ -144,19 +166,25 @@ static struct ospf6_vertex *ospf6_vertex_create(struct ospf6_lsa *lsa)
 	v->options[1] = *(uint8_t *)(OSPF6_LSA_HEADER_END(lsa->header) + 2);
 	v->options[2] = *(uint8_t *)(OSPF6_LSA_HEADER_END(lsa->header) + 3);
 
-	v->nh_list = list_new();
-	v->nh_list->cmp = (int (*)(void *, void *))ospf6_nexthop_cmp;
-	v->nh_list->del = (void (*)(void *))ospf6_nexthop_delete;
-
 	v->parent = NULL;
-	v->child_list = list_new();
-	v->child_list->cmp = ospf6_vertex_id_cmp;
 
 	return v;
 }
 
 static void ospf6_vertex_delete(struct ospf6_vertex *v)
 {
+	if (vertex_pool_count < OSPF6_VERTEX_POOL_MAX) {
+		/* Empty the lists (freeing the nexthops) but keep them,
+		 * and park the vertex for the next run. */
+		list_delete_all_node(v->nh_list);
+		list_delete_all_node(v->child_list);
+
+		v->parent = vertex_pool;
+		vertex_pool = v;
+		vertex_pool_count++;
+		return;
+	}
+
 	list_delete(&v->nh_list);
 	list_delete(&v->child_list);
 	XFREE(MTYPE_OSPF6_VERTEX, v);
@@ -455,6 +483,10 @@ void ospf6_spf_reason_string(unsigned int reason, char *buf, int size)
 	}
 }
 
+/* Candidate heap, kept across runs (empty in between) to avoid
+ * re-growing its array on every calculation. */
+static struct pqueue *spf_candidate_list;
+
 /* RFC2328 16.1.  Calculating the shortest-path tree for an area */
 /* RFC2740 3.8.1.  Calculating the shortest path tree for an area */
 void ospf6_spf_calculation(uint32_t router_id,
@@ -480,9 +512,13 @@ void ospf6_spf_calculation(uint32_t router_id,
 		return;
 	}
 
-	/* initialize */
-	candidate_list = pqueue_create();
-	candidate_list->cmp = ospf6_vertex_cmp;
+	/* initialize; the queue is kept (empty) across runs so its array
+	 * stays grown to the working size of this router's areas */
+	if (spf_candidate_list == NULL) {
+		spf_candidate_list = pqueue_create();
+		spf_candidate_list->cmp = ospf6_vertex_cmp;
+	}
+	candidate_list = spf_candidate_list;
 
 	root = ospf6_vertex_create(lsa);
 	root->area = oa;
@@ -562,7 +598,7 @@ void ospf6_spf_calculation(uint32_t router_id,
 	}
 
 
-	pqueue_delete(candidate_list);
+	/* The loop above drained the queue; it is reused by the next run. */
 
 	ospf6_remove_temp_router_lsa(oa);
 
@@ -1011,8 +1047,9 @@ struct ospf6_lsa *ospf6_create_single_router_lsa(struct ospf6_area *area,
 		return NULL;
 	}
 
-	/* Allocate memory for this LSA */
-	new_header = XMALLOC(MTYPE_OSPF6_LSA_HEADER, total_lsa_length);
+	/* Allocate memory for this LSA (reference-counted like every
+	 * other LSA body, since it is freed via ospf6_lsa_delete()) */
+	new_header = (uint8_t *)ospf6_lsa_body_alloc(total_lsa_length);
 
 	/* LSA information structure */
 	lsa = XCALLOC(MTYPE_OSPF6_LSA, sizeof(struct ospf6_lsa));
@@ -508,8 +508,8 @@ void ospf_if_stream_unset(struct ospf_interface *oi)
 		ospf_if_reset_stats(oi);
 
 		if (oi->on_write_q) {
-			listnode_delete(ospf->oi_write_q, oi);
-			if (list_isempty(ospf->oi_write_q))
+			oi_write_q_del(&ospf->oi_write_q, oi);
+			if (oi_write_q_count(&ospf->oi_write_q) == 0)
 				OSPF_TIMER_OFF(ospf->t_write);
 			oi->on_write_q = 0;
 		}
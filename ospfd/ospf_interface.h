@@ -229,6 +229,8 @@ struct ospf_interface {
 	struct thread *t_opaque_lsa_self; /* Type-9 Opaque-LSAs */
 
 	int on_write_q;
+	/* linkage on ospf->oi_write_q, valid while on_write_q is set */
+	struct oi_write_q_item wq_item;
 
 	/* Statistics fields. */
 	uint32_t hello_in;     /* Hello message input count. */
@@ -250,6 +252,8 @@ struct ospf_interface {
 };
 DECLARE_QOBJ_TYPE(ospf_interface)
 
+DECLARE_DLIST(oi_write_q, struct ospf_interface, wq_item)
+
 /* Prototypes. */
 extern char *ospf_if_name(struct ospf_interface *);
 extern struct ospf_interface *ospf_if_new(struct ospf *, struct interface *,
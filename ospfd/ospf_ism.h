@@ -50,7 +50,7 @@
 #define OSPF_ISM_WRITE_ON(O)                                                   \
 	do {                                                                   \
 		if (oi->on_write_q == 0) {                                     \
-			listnode_add((O)->oi_write_q, oi);                     \
+			oi_write_q_add_tail(&(O)->oi_write_q, oi);             \
 			oi->on_write_q = 1;                                    \
 		}                                                              \
 		thread_add_write(master, ospf_write, (O), (O)->fd,             \
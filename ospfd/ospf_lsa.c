@@ -136,6 +136,70 @@ uint16_t ospf_lsa_checksum(struct lsa_header *lsa)
 	return fletcher_checksum(buffer, len, checksum_offset);
 }
 
+/* Derive the checksum of 'new' from the one already computed for 'old'
+ * when the two are identical except for the LS sequence number - the
+ * common case for periodic refreshes of unchanged LSAs.  The fletcher
+ * sums of the old body are recovered (mod 255) from its check bytes and
+ * adjusted by the weighted deltas of the four sequence number bytes,
+ * avoiding a full pass over the LSA.  Returns 1 and writes the checksum
+ * on success, 0 if the contents differ and a full computation is needed.
+ */
+static int ospf_lsa_checksum_update_seqnum(struct lsa_header *old,
+					   struct lsa_header *new)
+{
+	uint8_t *ob = (uint8_t *)&old->options;
+	uint8_t *nb = (uint8_t *)&new->options;
+	int seq_offset = (uint8_t *)&new->ls_seqnum - nb;  /* should be 10 */
+	int checksum_offset = (uint8_t *)&new->checksum - nb; /* 14 */
+	int len, x, y, c0, c1, i;
+
+	if (old->length != new->length)
+		return 0;
+
+	len = ntohs(new->length) - 2; /* Skip the AGE field */
+
+	/* Everything but age, sequence number and checksum must match. */
+	if (memcmp(nb, ob, seq_offset) != 0
+	    || memcmp(nb + checksum_offset + 2, ob + checksum_offset + 2,
+		      len - checksum_offset - 2)
+		       != 0)
+		return 0;
+
+	/* Recover the old sums: x = (len - offset - 1) * c0 - c1 and
+	 * y = 510 - c0 - x, see fletcher_checksum(). */
+	x = ob[checksum_offset];
+	y = ob[checksum_offset + 1];
+	c0 = (510 - x - y) % 255;
+	c1 = ((len - checksum_offset - 1) * c0 - x) % 255;
+
+	/* A byte at offset i contributes (len - i) times to c1. */
+	for (i = 0; i < 4; i++) {
+		int delta = nb[seq_offset + i] - ob[seq_offset + i];
+
+		c0 += delta;
+		c1 += (len - (seq_offset + i)) * delta;
+	}
+
+	c0 %= 255;
+	if (c0 < 0)
+		c0 += 255;
+	c1 %= 255;
+	if (c1 < 0)
+		c1 += 255;
+
+	x = ((len - checksum_offset - 1) * c0 - c1) % 255;
+	if (x <= 0)
+		x += 255;
+	y = 510 - c0 - x;
+	if (y > 255)
+		y -= 255;
+
+	nb[checksum_offset] = x;
+	nb[checksum_offset + 1] = y;
+
+	return 1;
+}
+
 int ospf_lsa_checksum_valid(struct lsa_header *lsa)
 {
 	uint8_t *buffer = (uint8_t *)&lsa->options;
@@ -2639,6 +2703,11 @@ struct ospf_lsa *ospf_lsa_install(struct ospf *ospf, struct ospf_interface *oi,
 	if (old == NULL || ospf_lsa_different(old, lsa))
 		rt_recalc = 1;
 
+	/* Classify the change for incremental SPF while the old instance
+	   is still around to compare against. */
+	if (rt_recalc && lsa->area)
+		ospf_spf_install_classify(lsa->area, old, lsa);
+
 	/*
 	   Sequence number check (Section 14.1 of rfc 2328)
 	   "Premature aging is used when it is time for a self-originated
@@ -2680,9 +2749,12 @@ struct ospf_lsa *ospf_lsa_install(struct ospf *ospf, struct ospf_interface *oi,
 	if (old != NULL)
 		ospf_discard_from_db(ospf, lsdb, lsa);
 
-	/* Calculate Checksum if self-originated?. */
+	/* Calculate Checksum if self-originated?.  A content-identical
+	   refresh reuses the old instance's checksum incrementally. */
 	if (IS_LSA_SELF(lsa))
-		ospf_lsa_checksum(lsa->data);
+		if (old == NULL || old->data == NULL
+		    || !ospf_lsa_checksum_update_seqnum(old->data, lsa->data))
+			ospf_lsa_checksum(lsa->data);
 
 	/* Insert LSA to LSDB. */
 	ospf_lsdb_add(lsdb, lsa);
@@ -3665,6 +3737,8 @@ int ospf_lsa_refresh_walker(struct thread *t)
 	struct ospf_lsa *lsa;
 	int i;
 	struct list *lsa_to_refresh = list_new();
+	struct timeval ref_start;
+	unsigned int limit, done = 0;
 
 	if (IS_DEBUG_OSPF(lsa, LSA_REFRESH))
 		zlog_debug("LSA[Refresh]: ospf_lsa_refresh_walker(): start");
@@ -3727,13 +3801,48 @@ int ospf_lsa_refresh_walker(struct thread *t)
 			 ospf->lsa_refresh_interval, &ospf->t_lsa_refresher);
 	ospf->lsa_refresher_started = monotime(NULL);
 
+	/* Cap this tick's work by the measured per-LSA refresh cost;
+	 * anything beyond the budget spills into the current slot and
+	 * goes out on a later tick, flattening the refresh burst.  The
+	 * headroom to MaxAge is ample. */
+	limit = UINT_MAX;
+	if (ospf->lsa_refresh_usec_per_lsa) {
+		limit = OSPF_LSA_REFRESHER_USEC_BUDGET
+			/ ospf->lsa_refresh_usec_per_lsa;
+		if (limit < 16)
+			limit = 16;
+	}
+
+	monotime(&ref_start);
+
 	for (ALL_LIST_ELEMENTS(lsa_to_refresh, node, nnode, lsa)) {
-		ospf_lsa_refresh(ospf, lsa);
 		assert(lsa->lock > 0);
+
+		if (done >= limit) {
+			/* Spill over, keeping the queue's lock. */
+			i = ospf->lsa_refresh_queue.index;
+			if (!ospf->lsa_refresh_queue.qs[i])
+				ospf->lsa_refresh_queue.qs[i] = list_new();
+			listnode_add(ospf->lsa_refresh_queue.qs[i], lsa);
+			lsa->refresh_list = i;
+			continue;
+		}
+
+		ospf_lsa_refresh(ospf, lsa);
+		done++;
 		ospf_lsa_unlock(
 			&lsa); /* lsa_refresh_queue & temp for lsa_to_refresh*/
 	}
 
+	if (done) {
+		unsigned long per = monotime_since(&ref_start, NULL) / done;
+
+		ospf->lsa_refresh_usec_per_lsa =
+			ospf->lsa_refresh_usec_per_lsa
+				? (3 * ospf->lsa_refresh_usec_per_lsa + per) / 4
+				: per;
+	}
+
 	list_delete(&lsa_to_refresh);
 
 	if (IS_DEBUG_OSPF(lsa, LSA_REFRESH))
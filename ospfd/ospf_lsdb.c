@@ -25,12 +25,32 @@
 #include "table.h"
 #include "memory.h"
 #include "log.h"
+#include "hash.h"
+#include "jhash.h"
 
 #include "ospfd/ospfd.h"
 #include "ospfd/ospf_asbr.h"
 #include "ospfd/ospf_lsa.h"
 #include "ospfd/ospf_lsdb.h"
 
+static unsigned int ospf_lsdb_hash_key(void *p)
+{
+	const struct ospf_lsa *lsa = p;
+
+	return jhash_3words(lsa->data->id.s_addr, lsa->data->adv_router.s_addr,
+			    lsa->data->type, 0);
+}
+
+static bool ospf_lsdb_hash_cmp(const void *p1, const void *p2)
+{
+	const struct ospf_lsa *l1 = p1;
+	const struct ospf_lsa *l2 = p2;
+
+	return l1->data->type == l2->data->type
+	       && IPV4_ADDR_SAME(&l1->data->id, &l2->data->id)
+	       && IPV4_ADDR_SAME(&l1->data->adv_router, &l2->data->adv_router);
+}
+
 struct ospf_lsdb *ospf_lsdb_new(void)
 {
 	struct ospf_lsdb *new;
@@ -47,6 +67,9 @@ void ospf_lsdb_init(struct ospf_lsdb *lsdb)
 
 	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++)
 		lsdb->type[i].db = route_table_init();
+
+	lsdb->index = hash_create(ospf_lsdb_hash_key, ospf_lsdb_hash_cmp,
+				  "OSPF LSDB index");
 }
 
 void ospf_lsdb_free(struct ospf_lsdb *lsdb)
@@ -65,6 +88,9 @@ void ospf_lsdb_cleanup(struct ospf_lsdb *lsdb)
 
 	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++)
 		route_table_finish(lsdb->type[i].db);
+
+	hash_free(lsdb->index);
+	lsdb->index = NULL;
 }
 
 void ls_prefix_set(struct prefix_ls *lp, struct ospf_lsa *lsa)
@@ -92,6 +118,7 @@ static void ospf_lsdb_delete_entry(struct ospf_lsdb *lsdb,
 	lsdb->type[lsa->data->type].count--;
 	lsdb->type[lsa->data->type].checksum -= ntohs(lsa->data->checksum);
 	lsdb->total--;
+	hash_release(lsdb->index, lsa);
 	rn->info = NULL;
 	route_unlock_node(rn);
 #ifdef MONITOR_LSDB_CHANGE
@@ -134,6 +161,7 @@ void ospf_lsdb_add(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
 #endif /* MONITOR_LSDB_CHANGE */
 	lsdb->type[lsa->data->type].checksum += ntohs(lsa->data->checksum);
 	rn->info = ospf_lsa_lock(lsa); /* lsdb */
+	hash_get(lsdb->index, lsa, hash_alloc_intern);
 }
 
 void ospf_lsdb_delete(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
@@ -186,46 +214,23 @@ void ospf_lsdb_clean_stat(struct ospf_lsdb *lsdb)
 
 struct ospf_lsa *ospf_lsdb_lookup(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
 {
-	struct route_table *table;
-	struct prefix_ls lp;
-	struct route_node *rn;
-	struct ospf_lsa *find;
-
-	table = lsdb->type[lsa->data->type].db;
-	ls_prefix_set(&lp, lsa);
-	rn = route_node_lookup(table, (struct prefix *)&lp);
-	if (rn) {
-		find = rn->info;
-		route_unlock_node(rn);
-		return find;
-	}
-	return NULL;
+	return hash_lookup(lsdb->index, lsa);
 }
 
 struct ospf_lsa *ospf_lsdb_lookup_by_id(struct ospf_lsdb *lsdb, uint8_t type,
 					struct in_addr id,
 					struct in_addr adv_router)
 {
-	struct route_table *table;
-	struct prefix_ls lp;
-	struct route_node *rn;
-	struct ospf_lsa *find;
+	struct ospf_lsa key;
+	struct lsa_header data;
 
-	table = lsdb->type[type].db;
+	memset(&data, 0, sizeof(struct lsa_header));
+	data.type = type;
+	data.id = id;
+	data.adv_router = adv_router;
+	key.data = &data;
 
-	memset(&lp, 0, sizeof(struct prefix_ls));
-	lp.family = 0;
-	lp.prefixlen = 64;
-	lp.id = id;
-	lp.adv_router = adv_router;
-
-	rn = route_node_lookup(table, (struct prefix *)&lp);
-	if (rn) {
-		find = rn->info;
-		route_unlock_node(rn);
-		return find;
-	}
-	return NULL;
+	return hash_lookup(lsdb->index, &key);
 }
 
 struct ospf_lsa *ospf_lsdb_lookup_by_id_next(struct ospf_lsdb *lsdb,
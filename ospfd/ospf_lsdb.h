@@ -31,6 +31,9 @@ struct ospf_lsdb {
 		struct route_table *db;
 	} type[OSPF_MAX_LSA];
 	unsigned long total;
+	/* Direct (type, LS-ID, advertising router) index over all the
+	   per-type tables above, for O(1) lookup during flooding. */
+	struct hash *index;
 #define MONITOR_LSDB_CHANGE 1 /* XXX */
 #ifdef MONITOR_LSDB_CHANGE
 	/* Hooks for callback functions to catch every add/del event. */
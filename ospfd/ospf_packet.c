@@ -136,16 +136,46 @@ struct ospf_packet *ospf_packet_new(size_t size)
 
 	new = XCALLOC(MTYPE_OSPF_PACKET, sizeof(struct ospf_packet));
 	new->s = stream_new(size);
+	new->ref = 1;
+
+	return new;
+}
+
+/* Share an already built, immutable packet body with another
+ * destination.  The clone borrows the original's stream; it must not be
+ * modified through either reference once clones exist.
+ */
+static struct ospf_packet *ospf_packet_clone(struct ospf_packet *op,
+					     struct in_addr dst)
+{
+	struct ospf_packet *new;
+	struct ospf_packet *owner = op->parent ? op->parent : op;
+
+	new = XCALLOC(MTYPE_OSPF_PACKET, sizeof(struct ospf_packet));
+
+	owner->ref++;
+	new->parent = owner;
+	new->s = owner->s;
+	new->dst = dst;
+	new->length = owner->length;
 
 	return new;
 }
 
 void ospf_packet_free(struct ospf_packet *op)
 {
-	if (op->s)
-		stream_free(op->s);
+	struct ospf_packet *owner = op->parent ? op->parent : op;
+
+	if (op != owner)
+		XFREE(MTYPE_OSPF_PACKET, op);
 
-	XFREE(MTYPE_OSPF_PACKET, op);
+	if (--owner->ref > 0)
+		return;
+
+	if (owner->s)
+		stream_free(owner->s);
+
+	XFREE(MTYPE_OSPF_PACKET, owner);
 }
 
 struct ospf_fifo *ospf_fifo_new(void)
@@ -361,8 +391,7 @@ static int ospf_check_md5_digest(struct ospf_interface *oi,
 	}
 
 	/* Generate a digest for the ospf packet - their digest + our digest. */
-	memset(&ctx, 0, sizeof(ctx));
-	MD5Init(&ctx);
+	MD5Init(&ctx); /* fully initializes the context */
 	MD5Update(&ctx, ospfh, length);
 	MD5Update(&ctx, ck->auth_key, OSPF_AUTH_MD5_SIZE);
 	MD5Final(digest, &ctx);
@@ -422,8 +451,7 @@ static int ospf_make_md5_digest(struct ospf_interface *oi,
 	}
 
 	/* Generate a digest for the entire packet + our secret key. */
-	memset(&ctx, 0, sizeof(ctx));
-	MD5Init(&ctx);
+	MD5Init(&ctx); /* fully initializes the context */
 	MD5Update(&ctx, ibuf, ntohs(ospfh->length));
 	MD5Update(&ctx, auth_key, OSPF_AUTH_MD5_SIZE);
 	MD5Final(digest, &ctx);
@@ -646,7 +674,6 @@ static int ospf_write(struct thread *thread)
 	uint8_t type;
 	int ret;
 	int flags = 0;
-	struct listnode *node;
 #ifdef WANT_OSPF_WRITE_FRAGMENT
 	static uint16_t ipid = 0;
 	uint16_t maxdatasize;
@@ -662,9 +689,7 @@ static int ospf_write(struct thread *thread)
 
 	ospf->t_write = NULL;
 
-	node = listhead(ospf->oi_write_q);
-	assert(node);
-	oi = listgetdata(node);
+	oi = oi_write_q_first(&ospf->oi_write_q);
 	assert(oi);
 
 #ifdef WANT_OSPF_WRITE_FRAGMENT
@@ -856,26 +881,21 @@ static int ospf_write(struct thread *thread)
 
 		/* Move this interface to the tail of write_q to
 		       serve everyone in a round robin fashion */
-		list_delete_node(ospf->oi_write_q, node);
+		oi_write_q_del(&ospf->oi_write_q, oi);
 		if (ospf_fifo_head(oi->obuf) == NULL) {
 			oi->on_write_q = 0;
 			last_serviced_oi = NULL;
 			oi = NULL;
 		} else {
-			listnode_add(ospf->oi_write_q, oi);
+			oi_write_q_add_tail(&ospf->oi_write_q, oi);
 		}
 
 		/* Setup to service from the head of the queue again */
-		if (!list_isempty(ospf->oi_write_q)) {
-			node = listhead(ospf->oi_write_q);
-			assert(node);
-			oi = listgetdata(node);
-			assert(oi);
-		}
+		oi = oi_write_q_first(&ospf->oi_write_q);
 	}
 
 	/* If packets still remain in queue, call write thread. */
-	if (!list_isempty(ospf->oi_write_q))
+	if (oi_write_q_count(&ospf->oi_write_q))
 		thread_add_write(master, ospf_write, ospf, ospf->fd,
 				 &ospf->t_write);
 
@@ -2292,7 +2312,7 @@ static void ospf_ls_ack(struct ip *iph, struct ospf_header *ospfh,
 
 static struct stream *ospf_recv_packet(struct ospf *ospf, int fd,
 				       struct interface **ifp,
-				       struct stream *ibuf)
+				       struct stream *ibuf, int flags)
 {
 	int ret;
 	struct ip *iph;
@@ -2309,8 +2329,13 @@ static struct stream *ospf_recv_packet(struct ospf *ospf, int fd,
 	msgh.msg_control = (caddr_t)buff;
 	msgh.msg_controllen = sizeof(buff);
 
-	ret = stream_recvmsg(ibuf, fd, &msgh, 0, OSPF_MAX_PACKET_SIZE + 1);
+	ret = stream_recvmsg(ibuf, fd, &msgh, flags,
+			     OSPF_MAX_PACKET_SIZE + 1);
 	if (ret < 0) {
+		/* No more packets queued; not an error when polling. */
+		if ((flags & MSG_DONTWAIT)
+		    && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return NULL;
 		flog_warn(EC_OSPF_PACKET, "stream_recvmsg failed: %s",
 			  safe_strerror(errno));
 		return NULL;
@@ -2931,29 +2956,18 @@ static int ospf_verify_header(struct stream *ibuf, struct ospf_interface *oi,
 }
 
 /* Starting point of packet process function. */
-int ospf_read(struct thread *thread)
+/* Process one received, preparsed OSPF packet.  'ibuf' holds the raw IP
+   packet as returned by ospf_recv_packet(). */
+static int ospf_process_packet(struct ospf *ospf, struct stream *ibuf,
+			       struct interface *ifp)
 {
 	int ret;
-	struct stream *ibuf;
-	struct ospf *ospf;
 	struct ospf_interface *oi;
 	struct ip *iph;
 	struct ospf_header *ospfh;
 	uint16_t length;
-	struct interface *ifp = NULL;
 	struct connected *c;
 
-	/* first of all get interface pointer. */
-	ospf = THREAD_ARG(thread);
-
-	/* prepare for next packet. */
-	ospf->t_read = NULL;
-	thread_add_read(master, ospf_read, ospf, ospf->fd, &ospf->t_read);
-
-	stream_reset(ospf->ibuf);
-	ibuf = ospf_recv_packet(ospf, ospf->fd, &ifp, ospf->ibuf);
-	if (ibuf == NULL)
-		return -1;
 	/* This raw packet is known to be at least as big as its IP header. */
 
 	/* Note that there should not be alignment problems with this assignment
@@ -3166,6 +3180,86 @@ int ospf_read(struct thread *thread)
 	return 0;
 }
 
+/* How many packets one read event may drain from the socket.  During
+   adjacency storms packets pile up in the socket buffer; draining them
+   in bulk saves an event-loop pass per packet and lets us pick Hellos
+   out of the backlog first.  Without MSG_DONTWAIT a second receive on
+   the blocking socket could hang, so fall back to one per event. */
+#ifdef MSG_DONTWAIT
+#define OSPF_READ_BATCH 64
+#else
+#define MSG_DONTWAIT 0
+#define OSPF_READ_BATCH 1
+#endif
+
+int ospf_read(struct thread *thread)
+{
+	struct ospf *ospf = THREAD_ARG(thread);
+	struct {
+		struct stream *ibuf;
+		struct interface *ifp;
+		uint8_t type;
+	} batch[OSPF_READ_BATCH];
+	int nread = 0, i;
+
+	/* prepare for next packet. */
+	ospf->t_read = NULL;
+	thread_add_read(master, ospf_read, ospf, ospf->fd, &ospf->t_read);
+
+	/* Ingest and preparse everything queued on the socket, up to the
+	   batch limit.  Only the first receive may block; the rest poll. */
+	while (nread < OSPF_READ_BATCH) {
+		struct interface *ifp = NULL;
+		struct stream *ibuf;
+		struct ip *iph;
+		unsigned int hlen;
+		uint8_t type = 0;
+
+		stream_reset(ospf->ibuf);
+		ibuf = ospf_recv_packet(ospf, ospf->fd, &ifp, ospf->ibuf,
+					nread ? MSG_DONTWAIT : 0);
+		if (ibuf == NULL)
+			break;
+
+		/* Peek at the OSPF packet type for prioritization; full
+		   header and authentication checks follow in
+		   ospf_process_packet(). */
+		iph = (struct ip *)STREAM_DATA(ibuf);
+		hlen = iph->ip_hl * 4;
+		if (stream_get_endp(ibuf) >= hlen + OSPF_HEADER_SIZE)
+			type = STREAM_DATA(ibuf)[hlen + 1];
+
+		/* The receive buffer is reused for the next packet; keep a
+		   right-sized copy (stream_dup() trims to endp). */
+		batch[nread].ibuf = stream_dup(ibuf);
+		batch[nread].ifp = ifp;
+		batch[nread].type = type;
+		nread++;
+	}
+
+	/* Hellos first, so adjacencies stay up even when a storm of LS
+	   Updates is queued ahead of them. */
+	for (i = 0; i < nread; i++) {
+		if (batch[i].type != OSPF_MSG_HELLO)
+			continue;
+
+		ospf_process_packet(ospf, batch[i].ibuf, batch[i].ifp);
+		stream_free(batch[i].ibuf);
+		batch[i].ibuf = NULL;
+	}
+
+	/* Everything else, in arrival order. */
+	for (i = 0; i < nread; i++) {
+		if (batch[i].ibuf == NULL)
+			continue;
+
+		ospf_process_packet(ospf, batch[i].ibuf, batch[i].ifp);
+		stream_free(batch[i].ibuf);
+	}
+
+	return 0;
+}
+
 /* Make OSPF header. */
 static void ospf_make_header(int type, struct ospf_interface *oi,
 			     struct stream *s)
@@ -3960,12 +4054,44 @@ static struct ospf_packet *ospf_ls_upd_packet_new(struct list *update,
 	return ospf_packet_new(size - sizeof(struct ip));
 }
 
-static void ospf_ls_upd_queue_send(struct ospf_interface *oi,
-				   struct list *update, struct in_addr addr,
-				   int send_lsupd_now)
+/* Check whether the pending update list begins with exactly the LSAs
+ * that went into an already built packet, in the same order.
+ */
+static int ospf_ls_upd_batch_same(struct list *update, struct list *batch)
+{
+	struct listnode *un, *bn;
+
+	if (listcount(batch) == 0 || listcount(update) < listcount(batch))
+		return 0;
+
+	un = listhead(update);
+	for (bn = listhead(batch); bn; bn = listnextnode(bn)) {
+		if (listgetdata(un) != listgetdata(bn))
+			return 0;
+		un = listnextnode(un);
+	}
+
+	return 1;
+}
+
+/* Build an LS Update packet for one destination and queue it on the
+ * interface.  When 'shared_op'/'shared_lsas' describe the packet built
+ * for a previous destination in the same run and this destination's
+ * list starts with the same LSA batch, the body is sent by reference
+ * via ospf_packet_clone() instead of being rebuilt - with MD5
+ * authentication the body is patched at write time and cannot be
+ * shared.  On a fresh build, 'shared_lsas' is refilled with the LSAs
+ * that went into the packet.  Returns the packet holding the body, with
+ * a reference owned by the caller.
+ */
+static struct ospf_packet *
+ospf_ls_upd_queue_send(struct ospf_interface *oi, struct list *update,
+		       struct in_addr addr, int send_lsupd_now,
+		       struct ospf_packet *shared_op, struct list *shared_lsas)
 {
 	struct ospf_packet *op;
 	uint16_t length = OSPF_HEADER_SIZE;
+	struct in_addr dst;
 
 	if (IS_DEBUG_OSPF_EVENT)
 		zlog_debug("listcount = %d, [%s]dst %s", listcount(update),
@@ -3973,10 +4099,56 @@ static void ospf_ls_upd_queue_send(struct ospf_interface *oi,
 
 	/* Check that we have really something to process */
 	if (listcount(update) == 0)
-		return;
+		return shared_op;
+
+	/* Decide destination address. */
+	if (oi->type == OSPF_IFTYPE_POINTOPOINT)
+		dst.s_addr = htonl(OSPF_ALLSPFROUTERS);
+	else
+		dst.s_addr = addr.s_addr;
+
+	if (shared_op && shared_lsas
+	    && ospf_auth_type(oi) != OSPF_AUTH_CRYPTOGRAPHIC
+	    && ospf_ls_upd_batch_same(update, shared_lsas)) {
+		struct listnode *node, *nnode;
+		struct ospf_lsa *lsa;
+		unsigned int left = listcount(shared_lsas);
+
+		/* Same batch as the packet just built: consume the LSAs
+		 * as the build would and reuse the body. */
+		for (ALL_LIST_ELEMENTS(update, node, nnode, lsa)) {
+			if (left-- == 0)
+				break;
+			list_delete_node(update, node);
+			ospf_lsa_unlock(&lsa); /* oi->ls_upd_queue */
+		}
+
+		op = ospf_packet_clone(shared_op, dst);
+
+		/* Add packet to the interface output queue. */
+		ospf_packet_add(oi, op);
+
+		goto send;
+	}
+
+	/* Done with the body built for the previous destination. */
+	if (shared_op)
+		ospf_packet_free(shared_op);
+	shared_op = NULL;
 
 	op = ospf_ls_upd_packet_new(update, oi);
 
+	/* Remember, in order, the LSAs going into this packet, so later
+	 * destinations with the same batch can reuse the body. */
+	if (shared_lsas) {
+		struct listnode *node;
+		struct ospf_lsa *lsa;
+
+		list_delete_all_node(shared_lsas);
+		for (ALL_LIST_ELEMENTS_RO(update, node, lsa))
+			listnode_add(shared_lsas, lsa);
+	}
+
 	/* Prepare OSPF common header. */
 	ospf_make_header(OSPF_MSG_LS_UPD, oi, op->s);
 
@@ -3985,27 +4157,39 @@ static void ospf_ls_upd_queue_send(struct ospf_interface *oi,
 	 */
 	length += ospf_make_ls_upd(oi, update, op->s);
 
+	/* Trim the batch record down to what actually fit in. */
+	if (shared_lsas) {
+		unsigned int consumed =
+			listcount(shared_lsas) - listcount(update);
+
+		while (listcount(shared_lsas) > consumed)
+			list_delete_node(shared_lsas,
+					 listtail(shared_lsas));
+	}
+
 	/* Fill OSPF header. */
 	ospf_fill_header(oi, op->s, length);
 
 	/* Set packet length. */
 	op->length = length;
+	op->dst = dst;
 
-	/* Decide destination address. */
-	if (oi->type == OSPF_IFTYPE_POINTOPOINT)
-		op->dst.s_addr = htonl(OSPF_ALLSPFROUTERS);
-	else
-		op->dst.s_addr = addr.s_addr;
+	/* The caller keeps a reference so the body can be shared with
+	 * the next destination even after ospf_write() drains it. */
+	shared_op = op;
+	op->ref++;
 
 	/* Add packet to the interface output queue. */
 	ospf_packet_add(oi, op);
+
+send:
 	/* Call ospf_write() right away to send ospf packets to neighbors */
 	if (send_lsupd_now) {
 		struct thread os_packet_thd;
 
 		os_packet_thd.arg = (void *)oi->ospf;
 		if (oi->on_write_q == 0) {
-			listnode_add(oi->ospf->oi_write_q, oi);
+			oi_write_q_add_tail(&oi->ospf->oi_write_q, oi);
 			oi->on_write_q = 1;
 		}
 		ospf_write(&os_packet_thd);
@@ -4013,6 +4197,8 @@ static void ospf_ls_upd_queue_send(struct ospf_interface *oi,
 		/* Hook thread to write packet. */
 		OSPF_ISM_WRITE_ON(oi->ospf);
 	}
+
+	return shared_op;
 }
 
 static int ospf_ls_upd_send_queue_event(struct thread *thread)
@@ -4021,6 +4207,8 @@ static int ospf_ls_upd_send_queue_event(struct thread *thread)
 	struct route_node *rn;
 	struct route_node *rnext;
 	struct list *update;
+	struct ospf_packet *shared_op = NULL;
+	struct list *shared_lsas;
 	char again = 0;
 
 	oi->t_ls_upd_event = NULL;
@@ -4028,6 +4216,8 @@ static int ospf_ls_upd_send_queue_event(struct thread *thread)
 	if (IS_DEBUG_OSPF_EVENT)
 		zlog_debug("ospf_ls_upd_send_queue start");
 
+	shared_lsas = list_new();
+
 	for (rn = route_top(oi->ls_upd_queue); rn; rn = rnext) {
 		rnext = route_next(rn);
 
@@ -4036,7 +4226,8 @@ static int ospf_ls_upd_send_queue_event(struct thread *thread)
 
 		update = (struct list *)rn->info;
 
-		ospf_ls_upd_queue_send(oi, update, rn->p.u.prefix4, 0);
+		shared_op = ospf_ls_upd_queue_send(oi, update, rn->p.u.prefix4,
+						   0, shared_op, shared_lsas);
 
 		/* list might not be empty. */
 		if (listcount(update) == 0) {
@@ -4046,6 +4237,10 @@ static int ospf_ls_upd_send_queue_event(struct thread *thread)
 			again = 1;
 	}
 
+	if (shared_op)
+		ospf_packet_free(shared_op);
+	list_delete(&shared_lsas);
+
 	if (again != 0) {
 		if (IS_DEBUG_OSPF_EVENT)
 			zlog_debug(
@@ -4114,6 +4309,8 @@ void ospf_ls_upd_send(struct ospf_neighbor *nbr, struct list *update, int flag,
 	if (send_lsupd_now) {
 		struct list *send_update_list;
 		struct route_node *rnext;
+		struct ospf_packet *shared_op = NULL;
+		struct list *shared_lsas = list_new();
 
 		for (rn = route_top(oi->ls_upd_queue); rn; rn = rnext) {
 			rnext = route_next(rn);
@@ -4123,9 +4320,14 @@ void ospf_ls_upd_send(struct ospf_neighbor *nbr, struct list *update, int flag,
 
 			send_update_list = (struct list *)rn->info;
 
-			ospf_ls_upd_queue_send(oi, send_update_list,
-					       rn->p.u.prefix4, 1);
+			shared_op = ospf_ls_upd_queue_send(
+				oi, send_update_list, rn->p.u.prefix4, 1,
+				shared_op, shared_lsas);
 		}
+
+		if (shared_op)
+			ospf_packet_free(shared_op);
+		list_delete(&shared_lsas);
 	} else
 		thread_add_event(master, ospf_ls_upd_send_queue_event, oi, 0,
 				 &oi->t_ls_upd_event);
@@ -52,7 +52,8 @@
 struct ospf_packet {
 	struct ospf_packet *next;
 
-	/* Pointer to data stream. */
+	/* Pointer to data stream.  May be shared with clones of this
+	   packet, see 'parent' below. */
 	struct stream *s;
 
 	/* IP destination address. */
@@ -60,6 +61,13 @@ struct ospf_packet {
 
 	/* OSPF packet length. */
 	uint16_t length;
+
+	/* Body sharing: an LS Update built once for several destinations
+	   is sent by reference; clones borrow the original's stream and
+	   point 'parent' at it.  'ref' counts the original itself plus
+	   its clones; the stream goes away with the last of them. */
+	uint16_t ref;
+	struct ospf_packet *parent;
 };
 
 /* OSPF packet queue structure. */
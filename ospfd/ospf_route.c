@@ -115,26 +115,34 @@ void ospf_route_table_free(struct route_table *rt)
 	route_table_finish(rt);
 }
 
-/* If a prefix exists in the new routing table, then return 1,
-   otherwise return 0. Since the ZEBRA-RIB does an implicit
-   withdraw, it is not necessary to send a delete, an add later
-   will act like an implicit delete. */
-static int ospf_route_exist_new_table(struct route_table *rt,
-				      struct prefix_ipv4 *prefix)
+/* Compare two routes for the same prefix; return 1 when type, cost and
+   (for networks) the ordered path list are identical. */
+static int ospf_route_same(struct ospf_route *or, struct ospf_route *newor)
 {
-	struct route_node *rn;
-
-	assert(rt);
-	assert(prefix);
+	struct ospf_path *op;
+	struct ospf_path *newop;
+	struct listnode *n1;
+	struct listnode *n2;
 
-	rn = route_node_lookup(rt, (struct prefix *)prefix);
-	if (!rn) {
+	if (or->type != newor->type || or->cost != newor->cost)
 		return 0;
-	}
-	route_unlock_node(rn);
 
-	if (!rn->info) {
+	if (or->type != OSPF_DESTINATION_NETWORK)
+		return 1;
+
+	if (or->paths->count != newor->paths->count)
 		return 0;
+
+	/* Check each path. */
+	for (n1 = listhead(or->paths), n2 = listhead(newor->paths); n1 && n2;
+	     n1 = listnextnode_unchecked(n1), n2 = listnextnode_unchecked(n2)) {
+		op = listgetdata(n1);
+		newop = listgetdata(n2);
+
+		if (!IPV4_ADDR_SAME(&op->nexthop, &newop->nexthop))
+			return 0;
+		if (op->ifindex != newop->ifindex)
+			return 0;
 	}
 
 	return 1;
@@ -146,11 +154,6 @@ int ospf_route_match_same(struct route_table *rt, struct prefix_ipv4 *prefix,
 			  struct ospf_route *newor)
 {
 	struct route_node *rn;
-	struct ospf_route * or ;
-	struct ospf_path *op;
-	struct ospf_path *newop;
-	struct listnode *n1;
-	struct listnode *n2;
 
 	if (!rt || !prefix)
 		return 0;
@@ -161,31 +164,7 @@ int ospf_route_match_same(struct route_table *rt, struct prefix_ipv4 *prefix,
 
 	route_unlock_node(rn);
 
-	or = rn->info;
-	if (or->type == newor->type && or->cost == newor->cost) {
-		if (or->type == OSPF_DESTINATION_NETWORK) {
-			if (or->paths->count != newor->paths->count)
-				return 0;
-
-			/* Check each path. */
-			for (n1 = listhead(or->paths),
-			    n2 = listhead(newor->paths);
-			     n1 && n2; n1 = listnextnode_unchecked(n1),
-			    n2 = listnextnode_unchecked(n2)) {
-				op = listgetdata(n1);
-				newop = listgetdata(n2);
-
-				if (!IPV4_ADDR_SAME(&op->nexthop,
-						    &newop->nexthop))
-					return 0;
-				if (op->ifindex != newop->ifindex)
-					return 0;
-			}
-			return 1;
-		} else if (prefix_same(&rn->p, (struct prefix *)prefix))
-			return 1;
-	}
-	return 0;
+	return ospf_route_same(rn->info, newor);
 }
 
 /* delete routes generated from AS-External routes if there is a inter/intra
@@ -218,43 +197,10 @@ static void ospf_route_delete_same_ext(struct ospf *ospf,
 	}
 }
 
-/* rt: Old, cmprt: New */
-static void ospf_route_delete_uniq(struct ospf *ospf, struct route_table *rt,
-				   struct route_table *cmprt)
-{
-	struct route_node *rn;
-	struct ospf_route * or ;
-
-	for (rn = route_top(rt); rn; rn = route_next(rn))
-		if ((or = rn->info) != NULL)
-			if (or->path_type == OSPF_PATH_INTRA_AREA ||
-			    or->path_type == OSPF_PATH_INTER_AREA) {
-				if (or->type == OSPF_DESTINATION_NETWORK) {
-					if (!ospf_route_exist_new_table(
-						    cmprt,
-						    (struct prefix_ipv4 *)&rn
-							    ->p))
-						ospf_zebra_delete(
-							ospf,
-							(struct prefix_ipv4
-								 *)&rn->p,
-							or);
-				} else if (or->type == OSPF_DESTINATION_DISCARD)
-					if (!ospf_route_exist_new_table(
-						    cmprt,
-						    (struct prefix_ipv4 *)&rn
-							    ->p))
-						ospf_zebra_delete_discard(
-							ospf,
-							(struct prefix_ipv4
-								 *)&rn->p);
-			}
-}
-
 /* Install routes to table. */
 void ospf_route_install(struct ospf *ospf, struct route_table *rt)
 {
-	struct route_node *rn;
+	struct route_node *orn, *nrn;
 	struct ospf_route * or ;
 
 	/* rt contains new routing table, new_table contains an old one.
@@ -265,31 +211,74 @@ void ospf_route_install(struct ospf *ospf, struct route_table *rt)
 	ospf->old_table = ospf->new_table;
 	ospf->new_table = rt;
 
-	/* Delete old routes. */
-	if (ospf->old_table)
-		ospf_route_delete_uniq(ospf, ospf->old_table, rt);
 	if (ospf->old_external_route)
 		ospf_route_delete_same_ext(ospf, ospf->old_external_route, rt);
 
-	/* Install new routes. */
-	for (rn = route_top(rt); rn; rn = route_next(rn))
-		if ((or = rn->info) != NULL) {
-			if (or->type == OSPF_DESTINATION_NETWORK) {
-				if (!ospf_route_match_same(
-					    ospf->old_table,
-					    (struct prefix_ipv4 *)&rn->p, or))
-					ospf_zebra_add(
+	/* Walk the old and the new table together, in traversal order,
+	 * and touch zebra only for the prefixes that actually changed.
+	 * This replaces per-prefix lookups of one table in the other;
+	 * unchanged routes cost one comparison each. */
+	orn = ospf->old_table ? route_top(ospf->old_table) : NULL;
+	nrn = route_top(rt);
+
+	while (orn || nrn) {
+		int cmp;
+
+		if (orn && orn->info == NULL) {
+			orn = route_next(orn);
+			continue;
+		}
+		if (nrn && nrn->info == NULL) {
+			nrn = route_next(nrn);
+			continue;
+		}
+
+		if (orn == NULL)
+			cmp = 1;
+		else if (nrn == NULL)
+			cmp = -1;
+		else
+			cmp = route_table_prefix_iter_cmp(&orn->p, &nrn->p);
+
+		if (cmp < 0) {
+			/* Prefix vanished from the new table. */
+			or = orn->info;
+			if (or->path_type == OSPF_PATH_INTRA_AREA
+			    || or->path_type == OSPF_PATH_INTER_AREA) {
+				if (or->type == OSPF_DESTINATION_NETWORK)
+					ospf_zebra_delete(
 						ospf,
-						(struct prefix_ipv4 *)&rn->p,
+						(struct prefix_ipv4 *)&orn->p,
 						or);
-			} else if (or->type == OSPF_DESTINATION_DISCARD)
-				if (!ospf_route_match_same(
-					    ospf->old_table,
-					    (struct prefix_ipv4 *)&rn->p, or))
+				else if (or->type == OSPF_DESTINATION_DISCARD)
+					ospf_zebra_delete_discard(
+						ospf,
+						(struct prefix_ipv4 *)&orn->p);
+			}
+			orn = route_next(orn);
+		} else {
+			struct ospf_route *newor = nrn->info;
+
+			/* New prefix, or existing one whose route
+			 * changed; an unchanged route is left alone. */
+			if (cmp > 0
+			    || !ospf_route_same(orn->info, newor)) {
+				if (newor->type == OSPF_DESTINATION_NETWORK)
+					ospf_zebra_add(
+						ospf,
+						(struct prefix_ipv4 *)&nrn->p,
+						newor);
+				else if (newor->type == OSPF_DESTINATION_DISCARD)
 					ospf_zebra_add_discard(
 						ospf,
-						(struct prefix_ipv4 *)&rn->p);
+						(struct prefix_ipv4 *)&nrn->p);
+			}
+
+			if (cmp == 0)
+				orn = route_next(orn);
+			nrn = route_next(nrn);
 		}
+	}
 }
 
 /* RFC2328 16.1. (4). For "router". */
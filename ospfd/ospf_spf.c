@@ -19,6 +19,7 @@
  */
 
 #include <zebra.h>
+#include <pthread.h>
 
 #include "monotime.h"
 #include "thread.h"
@@ -65,10 +66,11 @@ static void ospf_spf_set_reason(ospf_spf_reason_t reason)
 
 static void ospf_vertex_free(void *);
 /* List of allocated vertices, to simplify cleanup of SPF.
- * Not thread-safe obviously. If it ever needs to be, it'd have to be
- * dynamically allocated at begin of ospf_spf_calculate
+ * Thread-local, since the tree stage of the calculation may run one
+ * area per worker thread (see ospf_spf_calculate_trees); each worker
+ * gets its own scratch list.
  */
-static struct list vertex_list = {.del = ospf_vertex_free};
+static __thread struct list vertex_list = {.del = ospf_vertex_free};
 
 /* Heap related functions, for the managment of the candidates, to
  * be used with pqueue. */
@@ -177,6 +179,7 @@ static struct vertex *ospf_vertex_new(struct ospf_lsa *lsa)
 	new->type = lsa->data->type;
 	new->id = lsa->data->id;
 	new->lsa = lsa->data;
+	new->lsa_p = ospf_lsa_lock(lsa);
 	new->children = list_new();
 	new->parents = list_new();
 	new->parents->del = vertex_parent_free;
@@ -214,11 +217,115 @@ static void ospf_vertex_free(void *data)
 	if (v->parents)
 		list_delete(&v->parents);
 
+	ospf_lsa_unlock(&v->lsa_p);
 	v->lsa = NULL;
 
 	XFREE(MTYPE_OSPF_VERTEX, v);
 }
 
+/* Release the vertices (and their canonical nexthops) kept from the
+ * area's last SPF calculation.  Called before a full recalculation and
+ * when the area goes away.
+ */
+void ospf_spf_tree_free(struct ospf_area *area)
+{
+	if (area->spf)
+		ospf_canonical_nexthops_free(area->spf);
+
+	if (area->spf_vertex_list)
+		list_delete(&area->spf_vertex_list);
+
+	area->spf = NULL;
+	area->spf_tree_valid = false;
+}
+
+/* Compare the parts of two router-LSAs that determine the shape of the
+ * SPF tree: the router bits (ABR/ASBR/VL/shortcut), the options, and
+ * the ordered sequence of non-stub links with their id/data/metric.
+ * Stub links are leaves; they only feed the second (stub) stage of the
+ * calculation and may differ freely.  Returns 1 if equivalent.
+ */
+static int ospf_router_lsa_links_same(struct lsa_header *a,
+				      struct lsa_header *b)
+{
+	struct router_lsa_link *la, *lb;
+	uint8_t *pa, *pb, *lima, *limb;
+
+	if (a->options != b->options)
+		return 0;
+
+	if (((struct router_lsa *)a)->flags != ((struct router_lsa *)b)->flags)
+		return 0;
+
+	pa = (uint8_t *)a + OSPF_LSA_HEADER_SIZE + 4;
+	pb = (uint8_t *)b + OSPF_LSA_HEADER_SIZE + 4;
+	lima = (uint8_t *)a + ntohs(a->length);
+	limb = (uint8_t *)b + ntohs(b->length);
+
+	for (;;) {
+		/* Skip stub links on either side. */
+		while (pa < lima) {
+			la = (struct router_lsa_link *)pa;
+			if (la->m[0].type != LSA_LINK_TYPE_STUB)
+				break;
+			pa += (OSPF_ROUTER_LSA_LINK_SIZE
+			       + (la->m[0].tos_count
+				  * OSPF_ROUTER_LSA_TOS_SIZE));
+		}
+		while (pb < limb) {
+			lb = (struct router_lsa_link *)pb;
+			if (lb->m[0].type != LSA_LINK_TYPE_STUB)
+				break;
+			pb += (OSPF_ROUTER_LSA_LINK_SIZE
+			       + (lb->m[0].tos_count
+				  * OSPF_ROUTER_LSA_TOS_SIZE));
+		}
+
+		if (pa >= lima || pb >= limb)
+			return (pa >= lima) && (pb >= limb);
+
+		la = (struct router_lsa_link *)pa;
+		lb = (struct router_lsa_link *)pb;
+
+		if (la->m[0].type != lb->m[0].type
+		    || la->m[0].tos_count != lb->m[0].tos_count
+		    || la->m[0].metric != lb->m[0].metric
+		    || !IPV4_ADDR_SAME(&la->link_id, &lb->link_id)
+		    || !IPV4_ADDR_SAME(&la->link_data, &lb->link_data))
+			return 0;
+
+		pa += (OSPF_ROUTER_LSA_LINK_SIZE
+		       + (la->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+		pb += (OSPF_ROUTER_LSA_LINK_SIZE
+		       + (lb->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+	}
+}
+
+void ospf_spf_install_classify(struct ospf_area *area, struct ospf_lsa *old,
+			       struct ospf_lsa *lsa)
+{
+	switch (lsa->data->type) {
+	case OSPF_ROUTER_LSA:
+		/* Replacing a router-LSA whose non-stub links are
+		 * unchanged cannot move any vertex of the tree. */
+		if (old && old->data && !IS_LSA_MAXAGE(old)
+		    && !IS_LSA_MAXAGE(lsa)
+		    && ospf_router_lsa_links_same(old->data, lsa->data))
+			return;
+		area->spf_leaf_only = false;
+		break;
+	case OSPF_NETWORK_LSA:
+		/* A changed network-LSA always restructures the tree
+		 * (attached router set or DR change). */
+		area->spf_leaf_only = false;
+		break;
+	default:
+		/* Summaries, externals and opaques do not feed the
+		 * intra-area Dijkstra stage. */
+		break;
+	}
+}
+
 static void ospf_vertex_dump(const char *msg, struct vertex *v,
 			     int print_parents, int print_children)
 {
@@ -1157,13 +1264,69 @@ ospf_rtrs_print (struct route_table *rtrs)
 }
 #endif
 
-/* Calculating the shortest-path tree for an area. */
-static void ospf_spf_calculate(struct ospf *ospf, struct ospf_area *area,
-			       struct route_table *new_table,
-			       struct route_table *new_rtrs)
+/* SPF trigger reasons that cannot change the shape of an area's SPF
+ * tree by themselves; anything outside this set forces a full Dijkstra.
+ */
+#define SPF_LEAF_SAFE_REASONS                                                  \
+	((1 << SPF_FLAG_ROUTER_LSA_INSTALL)                                    \
+	 | (1 << SPF_FLAG_SUMMARY_LSA_INSTALL)                                 \
+	 | (1 << SPF_FLAG_ASBR_SUMMARY_LSA_INSTALL))
+
+/* Incremental SPF: when every LSA change since the last run was
+ * classified as leaf-only (stub links), the tree kept from that run is
+ * still correct - only the second-stage (stub) routes can differ.
+ * Re-bind each saved vertex to the current LSDB instance of its LSA so
+ * the route stage can replay the tree from fresh LSA bodies.
+ * Returns 1 on success, 0 if a full calculation is required.
+ */
+static int ospf_spf_tree_rebind(struct ospf_area *area)
+{
+	struct listnode *node;
+	struct vertex *v;
+
+	if (!area->spf_tree_valid || !area->spf_leaf_only || !area->spf
+	    || !area->spf_vertex_list)
+		return 0;
+
+	/* Every vertex of the saved tree must still have a live,
+	 * non-MaxAge LSA in the LSDB; re-bind lsa/stat to it.  Nothing
+	 * outside the tree is touched, so bailing out to a full run is
+	 * safe. */
+	for (ALL_LIST_ELEMENTS_RO(area->spf_vertex_list, node, v)) {
+		struct ospf_lsa *lsa;
+
+		lsa = ospf_lsdb_lookup_by_id(area->lsdb, v->type, v->id,
+					     v->lsa->adv_router);
+		if (lsa == NULL || lsa->data == NULL || IS_LSA_MAXAGE(lsa))
+			return 0;
+
+		if (lsa != v->lsa_p) {
+			ospf_lsa_unlock(&v->lsa_p);
+			v->lsa_p = ospf_lsa_lock(lsa);
+			v->lsa = lsa->data;
+			v->stat = &(lsa->stat);
+		}
+	}
+
+	/* The root must still be our own router-LSA. */
+	if (area->spf->lsa_p != area->router_lsa_self)
+		return 0;
+
+	return 1;
+}
+
+/* First stage of the SPF calculation for an area: build (or re-bind)
+ * the shortest-path tree.  This stage only reads and writes state owned
+ * by the area itself - its LSDB, LSA references and vertices - so
+ * different areas' tree stages may run on different threads.  Route
+ * derivation from the tree is done serially afterwards by
+ * ospf_spf_calculate_routes().  Returns nonzero when a tree was built.
+ */
+static int ospf_spf_calculate_tree(struct ospf *ospf, struct ospf_area *area)
 {
 	struct pqueue *candidate;
 	struct vertex *v;
+	struct listnode *node;
 
 	if (IS_DEBUG_OSPF_EVENT) {
 		zlog_debug("ospf_spf_calculate: Start");
@@ -1179,9 +1342,26 @@ static void ospf_spf_calculate(struct ospf *ospf, struct ospf_area *area,
 				"ospf_spf_calculate: "
 				"Skip area %s's calculation due to empty router_lsa_self",
 				inet_ntoa(area->area_id));
-		return;
+		/* A tree kept from an earlier run is rooted in an LSA we
+		 * no longer originate; drop it. */
+		ospf_spf_tree_free(area);
+		return 0;
 	}
 
+	/* Incremental update: if nothing since the last run could have
+	 * changed the shape of the tree, skip the Dijkstra stage. */
+	if (!(spf_reason_flags & ~SPF_LEAF_SAFE_REASONS)
+	    && ospf_spf_tree_rebind(area)) {
+		if (IS_DEBUG_OSPF_EVENT)
+			zlog_debug(
+				"ospf_spf_calculate: incremental update for area %s",
+				inet_ntoa(area->area_id));
+		return 1;
+	}
+
+	/* Full run: drop the tree kept from the previous calculation. */
+	ospf_spf_tree_free(area);
+
 	/* RFC2328 16.1. (1). */
 	/* Initialize the algorithm's data structures. */
 
@@ -1228,17 +1408,77 @@ static void ospf_spf_calculate(struct ospf *ospf, struct ospf_area *area,
 
 		ospf_vertex_add_parent(v);
 
-		/* RFC2328 16.1. (4). */
-		if (v->type == OSPF_VERTEX_ROUTER)
-			ospf_intra_add_router(new_rtrs, v, area);
-		else
-			ospf_intra_add_transit(new_table, v, area);
+		/* RFC2328 16.1. (4) is deferred to
+		 * ospf_spf_calculate_routes(). */
 
 		/* RFC2328 16.1. (5). */
 		/* Iterate the algorithm by returning to Step 2. */
 
 	} /* end loop until no more candidate vertices */
 
+	/* Free candidate queue. */
+	pqueue_delete(candidate);
+
+	if (IS_DEBUG_OSPF_EVENT)
+		zlog_debug("ospf_spf_calculate: Stop. %zd vertices",
+			   mtype_stats_alloc(MTYPE_OSPF_VERTEX));
+
+	/* Keep the vertices (with their canonical nexthops, see
+	 * ospf_nexthop_calculation) on the area for incremental SPF;
+	 * move them off the scratch list without running its
+	 * deconstructor.  They are freed by ospf_spf_tree_free() before
+	 * the next full run or when the area goes away.
+	 */
+	area->spf_vertex_list = list_new();
+	area->spf_vertex_list->del = ospf_vertex_free;
+
+	for (node = vertex_list.head; node; node = listnextnode(node))
+		listnode_add(area->spf_vertex_list, listgetdata(node));
+
+	vertex_list.del = NULL;
+	list_delete_all_node(&vertex_list);
+	vertex_list.del = ospf_vertex_free;
+
+	area->spf_tree_valid = true;
+	area->spf_leaf_only = true;
+
+	return 1;
+}
+
+/* Second stage of the SPF calculation for an area: derive routes from
+ * the tree built by ospf_spf_calculate_tree() - RFC2328 16.1. (4) plus
+ * the stub stage.  Everything here touches state shared across areas
+ * (the global route tables, virtual links via ospf_vl_up_check(),
+ * ABR/ASBR counts), so this stage always runs serially on the main
+ * thread, in area order. */
+static void ospf_spf_calculate_routes(struct ospf *ospf,
+				      struct ospf_area *area,
+				      struct route_table *new_table,
+				      struct route_table *new_rtrs)
+{
+	struct listnode *node;
+	struct vertex *v;
+
+	if (!area->spf_tree_valid || !area->spf)
+		return;
+
+	area->abr_count = 0;
+	area->asbr_count = 0;
+	area->shortcut_capability = 1;
+
+	for (ALL_LIST_ELEMENTS_RO(area->spf_vertex_list, node, v)) {
+		/* Reset the stub-stage walk marker from the last run. */
+		UNSET_FLAG(v->flags, OSPF_VERTEX_PROCESSED);
+
+		if (v == area->spf)
+			continue;
+
+		if (v->type == OSPF_VERTEX_ROUTER)
+			ospf_intra_add_router(new_rtrs, v, area);
+		else
+			ospf_intra_add_transit(new_table, v, area);
+	}
+
 	if (IS_DEBUG_OSPF_EVENT) {
 		ospf_spf_dump(area->spf, 0);
 		ospf_route_table_dump(new_table);
@@ -1247,30 +1487,80 @@ static void ospf_spf_calculate(struct ospf *ospf, struct ospf_area *area,
 	/* Second stage of SPF calculation procedure's  */
 	ospf_spf_process_stubs(area, area->spf, new_table, 0);
 
-	/* Free candidate queue. */
-	pqueue_delete(candidate);
-
 	ospf_vertex_dump(__func__, area->spf, 0, 1);
-	/* Free nexthop information, canonical versions of which are attached
-	 * the first level of router vertices attached to the root vertex, see
-	 * ospf_nexthop_calculation.
-	 */
-	ospf_canonical_nexthops_free(area->spf);
 
 	/* Increment SPF Calculation Counter. */
 	area->spf_calculation++;
 
 	monotime(&area->ospf->ts_spf);
 	area->ts_spf = area->ospf->ts_spf;
+}
 
-	if (IS_DEBUG_OSPF_EVENT)
-		zlog_debug("ospf_spf_calculate: Stop. %zd vertices",
-			   mtype_stats_alloc(MTYPE_OSPF_VERTEX));
+/* Upper bound on threads building per-area SPF trees concurrently. */
+#define OSPF_SPF_WORKERS 4
 
-	/* Free SPF vertices, but not the list. List has ospf_vertex_free
-	 * as deconstructor.
-	 */
-	list_delete_all_node(&vertex_list);
+struct ospf_spf_work {
+	struct ospf *ospf;
+	struct ospf_area **areas;
+	int nareas;
+	int next; /* next unclaimed area index, under mtx */
+	pthread_mutex_t mtx;
+};
+
+static void *ospf_spf_worker(void *arg)
+{
+	struct ospf_spf_work *work = arg;
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&work->mtx);
+		i = work->next++;
+		pthread_mutex_unlock(&work->mtx);
+
+		if (i >= work->nareas)
+			break;
+
+		ospf_spf_calculate_tree(work->ospf, work->areas[i]);
+	}
+
+	return NULL;
+}
+
+/* Build the SPF trees for a set of areas, concurrently when there is
+ * more than one.  The main thread takes part in the work and blocks
+ * until every tree is done, so nothing else in the daemon observes the
+ * worker threads. */
+static void ospf_spf_calculate_trees(struct ospf *ospf,
+				     struct ospf_area **areas, int nareas)
+{
+	struct ospf_spf_work work;
+	pthread_t workers[OSPF_SPF_WORKERS];
+	int nworkers, i;
+
+	if (nareas == 1) {
+		ospf_spf_calculate_tree(ospf, areas[0]);
+		return;
+	}
+
+	work.ospf = ospf;
+	work.areas = areas;
+	work.nareas = nareas;
+	work.next = 0;
+	pthread_mutex_init(&work.mtx, NULL);
+
+	/* One thread per area up to the cap, counting this thread. */
+	nworkers = MIN(nareas, OSPF_SPF_WORKERS) - 1;
+	for (i = 0; i < nworkers; i++)
+		if (pthread_create(&workers[i], NULL, ospf_spf_worker, &work))
+			break;
+
+	/* Anything the spawned workers do not claim is done right here. */
+	ospf_spf_worker(&work);
+
+	while (i > 0)
+		pthread_join(workers[--i], NULL);
+
+	pthread_mutex_destroy(&work.mtx);
 }
 
 /* Timer for SPF calculation. */
@@ -1278,10 +1568,11 @@ static int ospf_spf_calculate_timer(struct thread *thread)
 {
 	struct ospf *ospf = THREAD_ARG(thread);
 	struct route_table *new_table, *new_rtrs;
-	struct ospf_area *area;
+	struct ospf_area *area, **spf_areas;
 	struct listnode *node, *nnode;
 	struct timeval start_time, spf_start_time;
 	int areas_processed = 0;
+	int nspf_areas = 0, i;
 	unsigned long ia_time, prune_time, rt_time;
 	unsigned long abr_time, total_spf_time, spf_time;
 	char rbuf[32]; /* reason_buf */
@@ -1298,7 +1589,11 @@ static int ospf_spf_calculate_timer(struct thread *thread)
 
 	ospf_vl_unapprove(ospf);
 
-	/* Calculate SPF for each area. */
+	/* Build the non-backbone trees concurrently, then derive their
+	 * routes serially in area order. */
+	spf_areas = XCALLOC(MTYPE_TMP,
+			    listcount(ospf->areas) * sizeof(*spf_areas));
+
 	for (ALL_LIST_ELEMENTS(ospf->areas, node, nnode, area)) {
 		/* Do backbone last, so as to first discover intra-area paths
 		 * for any back-bone virtual-links
@@ -1306,13 +1601,27 @@ static int ospf_spf_calculate_timer(struct thread *thread)
 		if (ospf->backbone && ospf->backbone == area)
 			continue;
 
-		ospf_spf_calculate(ospf, area, new_table, new_rtrs);
+		spf_areas[nspf_areas++] = area;
+	}
+
+	if (nspf_areas)
+		ospf_spf_calculate_trees(ospf, spf_areas, nspf_areas);
+
+	for (i = 0; i < nspf_areas; i++) {
+		ospf_spf_calculate_routes(ospf, spf_areas[i], new_table,
+					  new_rtrs);
 		areas_processed++;
 	}
 
-	/* SPF for backbone, if required */
+	XFREE(MTYPE_TMP, spf_areas);
+
+	/* SPF for backbone, if required.  Its tree may depend on virtual
+	 * links brought up by the transit areas' routes just above, so it
+	 * cannot join the concurrent stage. */
 	if (ospf->backbone) {
-		ospf_spf_calculate(ospf, ospf->backbone, new_table, new_rtrs);
+		ospf_spf_calculate_tree(ospf, ospf->backbone);
+		ospf_spf_calculate_routes(ospf, ospf->backbone, new_table,
+					  new_rtrs);
 		areas_processed++;
 	}
 
@@ -37,6 +37,8 @@ struct vertex {
 	uint8_t type;		/* copied from LSA header */
 	struct in_addr id;      /* copied from LSA header */
 	struct lsa_header *lsa; /* Router or Network LSA */
+	struct ospf_lsa *lsa_p; /* Refcounted LSA; keeps lsa/stat valid
+				   while the tree outlives the SPF run */
 	int *stat;		/* Link to LSA status. */
 	uint32_t distance;      /* from root to this vertex */
 	struct list *parents;   /* list of parents in SPF tree */
@@ -71,5 +73,16 @@ typedef enum {
 extern void ospf_spf_calculate_schedule(struct ospf *, ospf_spf_reason_t);
 extern void ospf_rtrs_free(struct route_table *);
 
+/* Classify an LSA change for incremental SPF; must be called while the
+ * old instance is still in the LSDB.  Clears the area's "leaf changes
+ * only" state whenever the change can alter the shape of the SPF tree.
+ */
+extern void ospf_spf_install_classify(struct ospf_area *area,
+				      struct ospf_lsa *old,
+				      struct ospf_lsa *lsa);
+
+/* Release the SPF tree kept from the area's last calculation. */
+extern void ospf_spf_tree_free(struct ospf_area *area);
+
 /* void ospf_spf_calculate_timer_add (); */
 #endif /* _QUAGGA_OSPF_SPF_H */
@@ -315,7 +315,7 @@ static struct ospf *ospf_new(unsigned short instance, const char *name)
 	new->ibuf = stream_new(OSPF_MAX_PACKET_SIZE + 1);
 
 	new->t_read = NULL;
-	new->oi_write_q = list_new();
+	oi_write_q_init(&new->oi_write_q);
 	new->write_oi_count = OSPF_WRITE_INTERFACE_COUNT_DEFAULT;
 
 /* Enable "log-adjacency-changes" */
@@ -754,7 +754,7 @@ static void ospf_finish_final(struct ospf *ospf)
 	}
 
 	list_delete(&ospf->areas);
-	list_delete(&ospf->oi_write_q);
+	oi_write_q_fini(&ospf->oi_write_q);
 
 	for (i = ZEBRA_ROUTE_SYSTEM; i <= ZEBRA_ROUTE_MAX; i++) {
 		struct list *ext_list;
@@ -847,6 +847,9 @@ static void ospf_area_free(struct ospf_area *area)
 
 	ospf_opaque_type10_lsa_term(area);
 
+	/* Free the saved SPF tree; its vertices hold LSA references. */
+	ospf_spf_tree_free(area);
+
 	/* Free LSDBs. */
 	LSDB_LOOP (ROUTER_LSDB(area), rn, lsa)
 		ospf_discard_from_db(area->ospf, area->lsdb, lsa);
@@ -24,6 +24,7 @@
 
 #include <zebra.h>
 #include "qobj.h"
+#include "typesafe.h"
 #include "libospf.h"
 
 #include "filter.h"
@@ -118,6 +119,12 @@ struct ospf_redist {
 };
 
 /* OSPF instance structure. */
+/* Intrusive round-robin queue of interfaces with packets pending in
+ * their output FIFO; linkage is embedded in struct ospf_interface
+ * (at most one membership, tracked by oi->on_write_q).
+ */
+PREDECL_DLIST(oi_write_q)
+
 struct ospf {
 	/* OSPF's running state based on the '[no] router ospf [<instance>]'
 	 * config. */
@@ -251,7 +258,7 @@ struct ospf {
 	struct thread *t_read;
 	int fd;
 	struct stream *ibuf;
-	struct list *oi_write_q;
+	struct oi_write_q_head oi_write_q;
 
 	/* Distribute lists out of other route sources. */
 	struct {
@@ -285,6 +292,12 @@ struct ospf {
 #define OSPF_LSA_REFRESH_INTERVAL_DEFAULT 10
 	uint16_t lsa_refresh_interval;
 
+/* Per-tick budget for LSA refreshes; work beyond it spills into the
+   following slot to flatten the periodic refresh burst. */
+#define OSPF_LSA_REFRESHER_USEC_BUDGET 50000
+	/* Measured cost of one LSA refresh (EWMA), for the budget above. */
+	unsigned long lsa_refresh_usec_per_lsa;
+
 	/* Distance parameter. */
 	uint8_t distance_all;
 	uint8_t distance_intra;
@@ -407,6 +420,14 @@ struct ospf_area {
 	/* Shortest Path Tree. */
 	struct vertex *spf;
 
+	/* Incremental SPF: vertices of the tree above, kept across runs
+	   so leaf-only (stub link) changes can skip the Dijkstra stage.
+	   spf_leaf_only is cleared by ospf_spf_install_classify() when a
+	   change may alter the shape of the tree. */
+	struct list *spf_vertex_list;
+	bool spf_tree_valid;
+	bool spf_leaf_only;
+
 	/* Threads. */
 	struct thread *t_stub_router;     /* Stub-router timer */
 	struct thread *t_opaque_lsa_self; /* Type-10 Opaque-LSAs origin. */
@@ -525,11 +525,58 @@ static void pbr_encode_pbr_map_sequence(struct stream *s,
 	stream_putl(s, ifp->ifindex);
 }
 
+/*
+ * Rule updates are batched: the wire format already carries a rule
+ * count and zebra loops over it, so consecutive installs or deletes
+ * are collected into one message and flushed through the event queue
+ * once the current map evaluation has finished.  A policy refresh
+ * then costs one zapi message per buffer instead of one per rule.
+ */
+#define PBR_RULE_ENCODE_LEN 128 /* worst case for one encoded sequence */
+
+static struct stream *rule_batch;
+static uint32_t rule_batch_count;
+static bool rule_batch_install;
+static struct thread *t_rule_batch;
+
+static void pbr_send_pbr_map_flush(void)
+{
+	struct stream *s;
+
+	if (rule_batch_count == 0)
+		return;
+
+	DEBUGD(&pbr_dbg_zebra, "%s: %s %u rules", __PRETTY_FUNCTION__,
+	       rule_batch_install ? "Installing" : "Deleting",
+	       rule_batch_count);
+
+	s = zclient->obuf;
+	stream_reset(s);
+
+	zclient_create_header(s,
+			      rule_batch_install ? ZEBRA_RULE_ADD
+						 : ZEBRA_RULE_DELETE,
+			      VRF_DEFAULT);
+	stream_putl(s, rule_batch_count);
+	stream_put(s, STREAM_DATA(rule_batch), stream_get_endp(rule_batch));
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	zclient_send_message(zclient);
+
+	stream_reset(rule_batch);
+	rule_batch_count = 0;
+}
+
+static int pbr_send_pbr_map_event(struct thread *t)
+{
+	pbr_send_pbr_map_flush();
+	return 0;
+}
+
 void pbr_send_pbr_map(struct pbr_map_sequence *pbrms,
 		      struct pbr_map_interface *pmi, bool install)
 {
 	struct pbr_map *pbrm = pbrms->parent;
-	struct stream *s;
 	uint64_t is_installed = (uint64_t)1 << pmi->install_bit;
 
 	is_installed &= pbrms->installed;
@@ -548,25 +595,26 @@ void pbr_send_pbr_map(struct pbr_map_sequence *pbrms,
 	if (!install && !is_installed)
 		return;
 
-	s = zclient->obuf;
-	stream_reset(s);
-
-	zclient_create_header(s,
-			      install ? ZEBRA_RULE_ADD : ZEBRA_RULE_DELETE,
-			      VRF_DEFAULT);
+	if (rule_batch == NULL)
+		rule_batch = stream_new(ZEBRA_MAX_PACKET_SIZ);
 
 	/*
-	 * We are sending one item at a time at the moment
+	 * Adds and deletes must stay ordered, so a command change
+	 * pushes the pending batch out first; so does a full buffer.
 	 */
-	stream_putl(s, 1);
+	if (rule_batch_count
+	    && (rule_batch_install != install
+		|| STREAM_WRITEABLE(rule_batch) < PBR_RULE_ENCODE_LEN))
+		pbr_send_pbr_map_flush();
 
 	DEBUGD(&pbr_dbg_zebra, "%s: \t%s %s %d %s %u",
 	       __PRETTY_FUNCTION__, install ? "Installing" : "Deleting",
 	       pbrm->name, install, pmi->ifp->name, pmi->delete);
 
-	pbr_encode_pbr_map_sequence(s, pbrms, pmi->ifp);
-
-	stream_putw_at(s, 0, stream_get_endp(s));
+	rule_batch_install = install;
+	pbr_encode_pbr_map_sequence(rule_batch, pbrms, pmi->ifp);
+	rule_batch_count++;
 
-	zclient_send_message(zclient);
+	thread_add_event(master, pbr_send_pbr_map_event, NULL, 0,
+			 &t_rule_batch);
 }
@@ -2339,6 +2339,11 @@ static void pim_show_upstream(struct pim_instance *pim, struct vty *vty,
 {
 	struct listnode *upnode;
 	struct pim_upstream *up;
+	struct interface *nbr_ifp = NULL;
+	struct in_addr nbr_addr = {.s_addr = INADDR_ANY};
+	struct pim_neighbor *nbr = NULL;
+	struct in_addr rpg_grp = {.s_addr = INADDR_ANY};
+	struct pim_rpf *rpg = NULL;
 	time_t now;
 	json_object *json = NULL;
 	json_object *json_group = NULL;
@@ -2370,14 +2375,22 @@ static void pim_show_upstream(struct pim_instance *pim, struct vty *vty,
 					 up->t_join_timer);
 
 		/*
-		 * If we have a J/P timer for the neighbor display that
+		 * If we have a J/P timer for the neighbor display that.
+		 *
+		 * Consecutive upstreams mostly share one RPF neighbor, and
+		 * pim_neighbor_find() walks the interface neighbor list, so
+		 * reuse the previous lookup whenever interface and address
+		 * are unchanged.  Monitoring polls this command on large
+		 * tables and the repeated scans were the bulk of its cost.
 		 */
 		if (!up->t_join_timer) {
-			struct pim_neighbor *nbr;
-
-			nbr = pim_neighbor_find(
-				up->rpf.source_nexthop.interface,
-				up->rpf.rpf_addr.u.prefix4);
+			if (up->rpf.source_nexthop.interface != nbr_ifp
+			    || up->rpf.rpf_addr.u.prefix4.s_addr
+				       != nbr_addr.s_addr) {
+				nbr_ifp = up->rpf.source_nexthop.interface;
+				nbr_addr = up->rpf.rpf_addr.u.prefix4;
+				nbr = pim_neighbor_find(nbr_ifp, nbr_addr);
+			}
 			if (nbr)
 				pim_time_timer_to_hhmmss(join_timer,
 							 sizeof(join_timer),
@@ -2425,9 +2438,16 @@ static void pim_show_upstream(struct pim_instance *pim, struct vty *vty,
 			if (up->flags & PIM_UPSTREAM_FLAG_MASK_FHR
 			    || up->sg.src.s_addr == INADDR_ANY) {
 				char rpf[PREFIX_STRLEN];
-				struct pim_rpf *rpg;
 
-				rpg = RP(pim, up->sg.grp);
+				/*
+				 * The upstream list is sorted by group, so
+				 * one RP lookup serves the whole run of
+				 * entries for the same group.
+				 */
+				if (up->sg.grp.s_addr != rpg_grp.s_addr) {
+					rpg_grp = up->sg.grp;
+					rpg = RP(pim, up->sg.grp);
+				}
 				pim_inet4_dump("<rpf?>",
 					       rpg->rpf_addr.u.prefix4, rpf,
 					       sizeof(rpf));
@@ -8459,8 +8479,15 @@ static void ip_msdp_show_sa_entry_detail(struct pim_msdp_sa *sa,
 	} else {
 		strcpy(local_str, "no");
 	}
-	pim_time_timer_to_hhmmss(statetimer, sizeof(statetimer),
-				 sa->sa_state_timer);
+	/* expiry is wheel-scheduled; render the remaining hold time from
+	 * the deadline */
+	if (sa->state_expiry)
+		pim_time_uptime(statetimer, sizeof(statetimer),
+				(sa->state_expiry > now) ? sa->state_expiry
+								   - now
+							 : 0);
+	else
+		snprintf(statetimer, sizeof(statetimer), "--:--:--");
 	if (uj) {
 		json_object_object_get_ex(json, grp_str, &json_group);
 
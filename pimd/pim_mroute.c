@@ -1032,7 +1032,6 @@ void pim_mroute_update_counters(struct channel_oil *c_oil)
 	sgreq.src = c_oil->oil.mfcc_origin;
 	sgreq.grp = c_oil->oil.mfcc_mcastgrp;
 
-	pim_zlookup_sg_statistics(c_oil);
 	if (ioctl(pim->mroute_socket, SIOCGETSGCNT, &sgreq)) {
 		if (PIM_DEBUG_MROUTE) {
 			struct prefix_sg sg;
@@ -1053,5 +1052,19 @@ void pim_mroute_update_counters(struct channel_oil *c_oil)
 	c_oil->cc.bytecnt = sgreq.bytecnt;
 	c_oil->cc.wrong_if = sgreq.wrong_if;
 
+	/*
+	 * The only thing the synchronous zclient round trip adds on top of
+	 * the local ioctl is lastused.  If the packet count moved since the
+	 * previous poll a packet used this entry within the poll window, so
+	 * lastused is effectively zero and every idle-longer-than-X check
+	 * stays correct; only flows showing no progress need the real value
+	 * from zebra.  This keeps the zebra round trip off the common path
+	 * when thousands of active (S,G) are polled.
+	 */
+	if (c_oil->cc.pktcnt > c_oil->cc.oldpktcnt)
+		c_oil->cc.lastused = 0;
+	else
+		pim_zlookup_sg_statistics(c_oil);
+
 	return;
 }
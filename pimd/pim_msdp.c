@@ -27,6 +27,7 @@
 #include <lib/stream.h>
 #include <lib/thread.h>
 #include <lib/vty.h>
+#include <lib/wheel.h>
 #include <lib/plist.h>
 #include <lib/lib_errors.h>
 
@@ -91,27 +92,41 @@ static void pim_msdp_sa_adv_timer_setup(struct pim_instance *pim, bool start)
 	}
 }
 
-/* RFC-3618:Sec-5.3 - SA cache state timer */
-static int pim_msdp_sa_state_timer_cb(struct thread *t)
+/* RFC-3618:Sec-5.3 - SA cache state timer
+ *
+ * Expiry is enforced by a timer wheel instead of one thread timer per
+ * cache entry.  At internet-exchange scale every peer refresh used to
+ * delete and re-insert an entry in the timer heap; the wheel just moves
+ * the deadline forward.  An entry may outlive its deadline by up to one
+ * wheel rotation, which is noise against the 210s hold time.
+ */
+static void pim_msdp_sa_expiry_wheel_run(void *arg)
 {
-	struct pim_msdp_sa *sa;
+	struct pim_msdp_sa *sa = arg;
 
-	sa = THREAD_ARG(t);
+	if (!sa->state_expiry || sa->state_expiry > pim_time_monotonic_sec()) {
+		return;
+	}
 
 	if (PIM_DEBUG_MSDP_EVENTS) {
 		pim_msdp_sa_timer_expiry_log(sa, "state");
 	}
 
 	pim_msdp_sa_deref(sa, PIM_MSDP_SAF_PEER);
-	return 0;
 }
 static void pim_msdp_sa_state_timer_setup(struct pim_msdp_sa *sa, bool start)
 {
-	THREAD_OFF(sa->sa_state_timer);
 	if (start) {
-		thread_add_timer(sa->pim->msdp.master,
-				 pim_msdp_sa_state_timer_cb, sa,
-				 PIM_MSDP_SA_HOLD_TIME, &sa->sa_state_timer);
+		if (!sa->state_expiry) {
+			wheel_add_item(sa->pim->msdp.sa_expiry_wheel, sa);
+		}
+		sa->state_expiry =
+			pim_time_monotonic_sec() + PIM_MSDP_SA_HOLD_TIME;
+	} else {
+		if (sa->state_expiry) {
+			wheel_remove_item(sa->pim->msdp.sa_expiry_wheel, sa);
+		}
+		sa->state_expiry = 0;
 	}
 }
 
@@ -1586,6 +1601,11 @@ void pim_msdp_init(struct pim_instance *pim, struct thread_master *master)
 	pim->msdp.sa_list = list_new();
 	pim->msdp.sa_list->del = (void (*)(void *))pim_msdp_sa_free;
 	pim->msdp.sa_list->cmp = (int (*)(void *, void *))pim_msdp_sa_comp;
+
+	snprintf(hash_name, 64, "PIM %s MSDP SA Expiry Wheel", pim->vrf->name);
+	pim->msdp.sa_expiry_wheel =
+		wheel_init(master, 10000, 100, pim_msdp_sa_hash_key_make,
+			   pim_msdp_sa_expiry_wheel_run, hash_name);
 }
 
 /* counterpart to MSDP init; XXX: unused currently */
@@ -1617,6 +1637,11 @@ void pim_msdp_exit(struct pim_instance *pim)
 		list_delete(&pim->msdp.sa_list);
 	}
 
+	if (pim->msdp.sa_expiry_wheel) {
+		wheel_delete(pim->msdp.sa_expiry_wheel);
+		pim->msdp.sa_expiry_wheel = NULL;
+	}
+
 	if (pim->msdp.work_obuf)
 		stream_free(pim->msdp.work_obuf);
 	pim->msdp.work_obuf = NULL;
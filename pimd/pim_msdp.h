@@ -85,7 +85,10 @@ struct pim_msdp_sa {
 /* rfc-3618 is missing default value for SA-hold-down-Period. pulled
  * this number from industry-standards */
 #define PIM_MSDP_SA_HOLD_TIME ((3*60)+30)
-	struct thread *sa_state_timer; // 5.6
+	/* 5.6 - expiry deadline enforced by the SA expiry wheel; zero when
+	 * the entry is not peer-referenced (wheel scheduling avoids the
+	 * per-refresh timer churn of one thread timer per cache entry) */
+	int64_t state_expiry;
 	int64_t uptime;
 
 	struct pim_upstream *up;
@@ -189,6 +192,7 @@ struct pim_msdp {
 	struct thread *sa_adv_timer; // 5.6
 	struct hash *sa_hash;
 	struct list *sa_list;
+	struct timer_wheel *sa_expiry_wheel;
 	uint32_t local_cnt;
 
 	/* keep a scratch pad for building SA TLVs */
@@ -26,6 +26,7 @@
 #include "prefix.h"
 #include "vty.h"
 #include "plist.h"
+#include "jhash.h"
 
 #include "pimd.h"
 #include "pim_mroute.h"
@@ -43,6 +44,7 @@
 #include "pim_join.h"
 #include "pim_util.h"
 #include "pim_ssm.h"
+#include "pim_time.h"
 
 struct thread *send_test_packet_timer = NULL;
 
@@ -62,6 +64,51 @@ void pim_register_join(struct pim_upstream *up)
 	up->reg_state = PIM_REG_JOIN;
 }
 
+/*
+ * RFC 7761 Sec. 4.4.1 allows an RP to rate-limit Register-Stops.  A
+ * first-hop router bursting Registers for the same flow would otherwise
+ * get one Register-Stop per Register, and building and sending those
+ * answers is most of the per-packet cost at the RP during new-source
+ * bursts.  Keep a small direct-mapped cache of recently answered
+ * (S,G,originator) tuples and suppress duplicates for a second; a lost
+ * Register-Stop is recovered by the very next Register of the burst.
+ */
+#define REG_STOP_CACHE_SIZE	256	/* power of two */
+#define REG_STOP_SUPPRESS_MSEC	1000
+
+struct reg_stop_cache_entry {
+	struct in_addr src;
+	struct in_addr grp;
+	struct in_addr originator;
+	int64_t last_msec;
+};
+
+static struct reg_stop_cache_entry reg_stop_cache[REG_STOP_CACHE_SIZE];
+
+static bool pim_register_stop_suppress(struct prefix_sg *sg,
+				       struct in_addr originator)
+{
+	struct reg_stop_cache_entry *entry;
+	int64_t now = pim_time_monotonic_usec() / 1000;
+
+	entry = &reg_stop_cache[jhash_3words(sg->src.s_addr, sg->grp.s_addr,
+					     originator.s_addr, 0)
+				& (REG_STOP_CACHE_SIZE - 1)];
+
+	if (entry->src.s_addr == sg->src.s_addr
+	    && entry->grp.s_addr == sg->grp.s_addr
+	    && entry->originator.s_addr == originator.s_addr
+	    && now - entry->last_msec < REG_STOP_SUPPRESS_MSEC)
+		return true;
+
+	entry->src = sg->src;
+	entry->grp = sg->grp;
+	entry->originator = originator;
+	entry->last_msec = now;
+
+	return false;
+}
+
 void pim_register_stop_send(struct interface *ifp, struct prefix_sg *sg,
 			    struct in_addr src, struct in_addr originator)
 {
@@ -72,6 +119,9 @@ void pim_register_stop_send(struct interface *ifp, struct prefix_sg *sg,
 	uint8_t *b1;
 	struct prefix p;
 
+	if (pim_register_stop_suppress(sg, originator))
+		return;
+
 	if (PIM_DEBUG_PIM_REG) {
 		zlog_debug("Sending Register stop for %s to %s on %s",
 			   pim_str_sg_dump(sg), inet_ntoa(originator),
@@ -1077,10 +1077,22 @@ static int pim_upstream_keep_alive_timer(struct thread *t)
 {
 	struct pim_upstream *up;
 	struct pim_instance *pim;
+	time_t now;
 
 	up = THREAD_ARG(t);
 	pim = up->channel_oil->pim;
 
+	/*
+	 * The KAT was refreshed while we were armed; sleep out the
+	 * remainder instead of expiring.
+	 */
+	now = pim_time_monotonic_sec();
+	if (up->ka_deadline > now) {
+		thread_add_timer(router->master, pim_upstream_keep_alive_timer,
+				 up, up->ka_deadline - now, &up->t_ka_timer);
+		return 0;
+	}
+
 	if (I_am_RP(pim, up->sg.grp)) {
 		pim_br_clear_pmbr(&up->sg);
 		/*
@@ -1123,9 +1135,20 @@ void pim_upstream_keep_alive_timer_start(struct pim_upstream *up, uint32_t time)
 			zlog_debug("kat start on %s with no stream reference",
 				   up->sg_str);
 	}
-	THREAD_OFF(up->t_ka_timer);
-	thread_add_timer(router->master, pim_upstream_keep_alive_timer, up,
-			 time, &up->t_ka_timer);
+	/*
+	 * Refreshing a running KAT is the common case - every counter
+	 * scan of an active stream does it - and with tens of thousands
+	 * of (S,G) the timer churn adds up.  Push the deadline out and
+	 * let the armed timer re-arm itself when it fires early; only
+	 * touch the timer if it is stopped or would fire too late.
+	 */
+	up->ka_deadline = pim_time_monotonic_sec() + time;
+	if (up->t_ka_timer
+	    && thread_timer_remain_second(up->t_ka_timer) > time)
+		THREAD_OFF(up->t_ka_timer);
+	if (!up->t_ka_timer)
+		thread_add_timer(router->master, pim_upstream_keep_alive_timer,
+				 up, time, &up->t_ka_timer);
 
 	/* any time keepalive is started against a SG we will have to
 	 * re-evaluate our active source database */
@@ -123,8 +123,13 @@ struct pim_upstream {
 
 	/*
 	 * KAT(S,G)
+	 *
+	 * Restarts only move ka_deadline forward; the running timer
+	 * re-arms itself for the remainder when it fires early, so
+	 * refreshing the KAT is a plain store instead of timer churn.
 	 */
 	struct thread *t_ka_timer;
+	time_t ka_deadline;
 #define PIM_KEEPALIVE_PERIOD  (210)
 #define PIM_RP_KEEPALIVE_PERIOD                                                \
 	(3 * router->register_suppress_time + router->register_probe_time)
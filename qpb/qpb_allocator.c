@@ -26,6 +26,8 @@
 #include "config.h"
 #endif
 
+#include <stdlib.h>
+
 #include "linear_allocator.h"
 
 #include "qpb_allocator.h"
@@ -59,3 +61,44 @@ void qpb_allocator_init_linear(qpb_allocator_t *allocator,
 	*allocator = allocator_template;
 	allocator->allocator_data = linear_allocator;
 }
+
+/*
+ * Reusable per-thread arena.
+ *
+ * Callers that encode one protobuf message at a time (the FPM encoder,
+ * for instance) can grab the calling thread's arena instead of setting
+ * up a fresh allocator for every message. The backing buffer is
+ * allocated once per thread on first use and reused afterwards, so
+ * encoding does no heap allocation in steady state.
+ */
+typedef struct qpb_thread_arena_t_ {
+	linear_allocator_t linear;
+	qpb_allocator_t qpb;
+	char *buf;
+} qpb_thread_arena_t;
+
+static __thread qpb_thread_arena_t qpb_thread_arena;
+
+/*
+ * qpb_thread_allocator
+ *
+ * Returns the calling thread's arena allocator, reset and ready for
+ * use. Returns NULL if the backing buffer could not be allocated.
+ */
+qpb_allocator_t *qpb_thread_allocator(void)
+{
+	qpb_thread_arena_t *arena = &qpb_thread_arena;
+
+	if (!arena->buf) {
+		arena->buf = malloc(QPB_THREAD_ARENA_SIZE);
+		if (!arena->buf)
+			return NULL;
+
+		linear_allocator_init(&arena->linear, arena->buf,
+				      QPB_THREAD_ARENA_SIZE);
+		qpb_allocator_init_linear(&arena->qpb, &arena->linear);
+	}
+
+	linear_allocator_reset(&arena->linear);
+	return &arena->qpb;
+}
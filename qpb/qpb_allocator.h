@@ -74,11 +74,19 @@ static inline void qpb_free(qpb_allocator_t *allocator, void *ptr)
  */
 #define QPB_ALLOC(allocator, type) (type *)qpb_alloc(allocator, sizeof(type))
 
+/*
+ * Size of the buffer backing each thread's reusable arena. Large
+ * enough for any single FPM message, including routes with many
+ * nexthops.
+ */
+#define QPB_THREAD_ARENA_SIZE (64 * 1024)
+
 /*
  * Externs.
  */
 extern void qpb_allocator_init_linear(qpb_allocator_t *,
 				      struct linear_allocator_t_ *);
+extern qpb_allocator_t *qpb_thread_allocator(void);
 
 /*
  * The following macros are for the common case where a qpb allocator
@@ -481,6 +481,8 @@ static void rip_interface_clean(struct rip_interface *ri)
 		thread_cancel(ri->t_wakeup);
 		ri->t_wakeup = NULL;
 	}
+
+	rip_update_cache_free(ri);
 }
 
 void rip_interfaces_clean(void)
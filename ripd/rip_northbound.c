@@ -137,6 +137,7 @@ static int ripd_instance_default_metric_modify(enum nb_event event,
 
 	rip->default_metric = yang_dnode_get_uint8(dnode, NULL);
 	/* rip_update_default_metric (); */
+	rip_update_cache_invalidate();
 
 	return NB_OK;
 }
@@ -407,6 +408,7 @@ static int ripd_instance_offset_list_delete(enum nb_event event,
 	if (offset->direct[RIP_OFFSET_LIST_IN].alist_name == NULL
 	    && offset->direct[RIP_OFFSET_LIST_OUT].alist_name == NULL)
 		offset_list_del(offset);
+	rip_update_cache_invalidate();
 
 	return NB_OK;
 }
@@ -433,6 +435,7 @@ ripd_instance_offset_list_access_list_modify(enum nb_event event,
 	if (offset->direct[direct].alist_name)
 		free(offset->direct[direct].alist_name);
 	offset->direct[direct].alist_name = strdup(alist_name);
+	rip_update_cache_invalidate();
 
 	return NB_OK;
 }
@@ -456,6 +459,7 @@ static int ripd_instance_offset_list_metric_modify(enum nb_event event,
 
 	offset = yang_dnode_get_entry(dnode, true);
 	offset->direct[direct].metric = metric;
+	rip_update_cache_invalidate();
 
 	return NB_OK;
 }
@@ -1242,8 +1246,6 @@ static int clear_rip_route_rpc(const char *xpath, const struct list *input,
 		}
 
 		if (rinfo) {
-			RIP_TIMER_OFF(rinfo->t_timeout);
-			RIP_TIMER_OFF(rinfo->t_garbage_collect);
 			listnode_delete(list, rinfo);
 			rip_info_free(rinfo);
 		}
@@ -42,6 +42,9 @@
 #include "privs.h"
 #include "lib_errors.h"
 #include "northbound_cli.h"
+#include "monotime.h"
+#include "jhash.h"
+#include "wheel.h"
 
 #include "ripd/ripd.h"
 #include "ripd/rip_debug.h"
@@ -62,6 +65,15 @@ long rip_global_route_changes = 0;
 /* RIP queries. */
 long rip_global_queries = 0;
 
+/* Coarse timer wheel driving route timeout and garbage collection.
+ * Every rip_info is a member; aging just compares deadlines when the
+ * entry's slot comes around, so refreshing a route on every update is
+ * a plain store instead of a timer-heap delete/insert pair. */
+static struct timer_wheel *rip_aging_wheel;
+
+#define RIP_AGING_PERIOD 1000 /* msec, full wheel rotation */
+#define RIP_AGING_SLOTS 10
+
 /* Prototypes. */
 static void rip_output_process(struct connected *, struct sockaddr_in *, int,
 			       uint8_t);
@@ -109,25 +121,28 @@ int rip_route_rte(struct rip_info *rinfo)
 
 static struct rip_info *rip_info_new(void)
 {
-	return XCALLOC(MTYPE_RIP_INFO, sizeof(struct rip_info));
+	struct rip_info *rinfo;
+
+	rinfo = XCALLOC(MTYPE_RIP_INFO, sizeof(struct rip_info));
+	wheel_add_item(rip_aging_wheel, rinfo);
+
+	return rinfo;
 }
 
 void rip_info_free(struct rip_info *rinfo)
 {
+	wheel_remove_item(rip_aging_wheel, rinfo);
 	XFREE(MTYPE_RIP_INFO, rinfo);
 }
 
-/* RIP route garbage collect timer. */
-static int rip_garbage_collect(struct thread *t)
+/* RIP route garbage collect. */
+static void rip_garbage_collect(struct rip_info *rinfo)
 {
-	struct rip_info *rinfo;
 	struct route_node *rp;
 
-	rinfo = THREAD_ARG(t);
-	rinfo->t_garbage_collect = NULL;
-
-	/* Off timeout timer. */
-	RIP_TIMER_OFF(rinfo->t_timeout);
+	/* Disarm both deadlines. */
+	rinfo->garbage_expire = 0;
+	rinfo->timeout_expire = 0;
 
 	/* Get route_node pointer. */
 	rp = rinfo->rp;
@@ -142,11 +157,56 @@ static int rip_garbage_collect(struct thread *t)
 	/* Free RIP routing information. */
 	rip_info_free(rinfo);
 
-	return 0;
+	rip_update_cache_invalidate();
+}
+
+static unsigned int rip_aging_slot_key(void *arg)
+{
+	return jhash_1word((uint32_t)(uintptr_t)arg, 0);
+}
+
+/* Called for every rip_info whose wheel slot comes up; fire whichever
+ * deadline has passed. */
+static void rip_aging_wheel_run(void *arg)
+{
+	struct rip_info *rinfo = arg;
+	time_t now = monotime(NULL);
+
+	if (rinfo->timeout_expire && now >= rinfo->timeout_expire) {
+		rinfo->timeout_expire = 0;
+		rip_ecmp_delete(rinfo);
+		return;
+	}
+
+	if (rinfo->garbage_expire && now >= rinfo->garbage_expire)
+		rip_garbage_collect(rinfo);
 }
 
 static void rip_timeout_update(struct rip_info *rinfo);
 
+/* Generation number of the cached periodic update packets.  It is bumped
+ * whenever the routing table or the output policy changes, which makes
+ * rip_output_process() rebuild the per-interface packets instead of
+ * replaying the cached ones. */
+static uint32_t rip_update_gen = 1;
+
+void rip_update_cache_invalidate(void)
+{
+	rip_update_gen++;
+}
+
+static void rip_update_cache_stream_free(void *arg)
+{
+	stream_free(arg);
+}
+
+void rip_update_cache_free(struct rip_interface *ri)
+{
+	if (ri->update_cache)
+		list_delete(&ri->update_cache);
+	ri->update_cache_gen = 0;
+}
+
 /* Add new route to the ECMP list.
  * RETURN: the new entry added in the list, or NULL if it is not the first
  *         entry and ECMP is not allowed.
@@ -179,6 +239,8 @@ struct rip_info *rip_ecmp_add(struct rip_info *rinfo_new)
 	rinfo = listgetdata(listhead(list));
 	SET_FLAG(rinfo->flags, RIP_RTF_CHANGED);
 
+	rip_update_cache_invalidate();
+
 	/* Signal the output process to trigger an update (see section 2.5). */
 	rip_event(RIP_TRIGGERED_UPDATE, 0);
 
@@ -209,15 +271,13 @@ struct rip_info *rip_ecmp_replace(struct rip_info *rinfo_new)
 	/* Re-use the first entry, and delete the others. */
 	for (ALL_LIST_ELEMENTS(list, node, nextnode, tmp_rinfo))
 		if (tmp_rinfo != rinfo) {
-			RIP_TIMER_OFF(tmp_rinfo->t_timeout);
-			RIP_TIMER_OFF(tmp_rinfo->t_garbage_collect);
 			list_delete_node(list, node);
 			rip_info_free(tmp_rinfo);
 		}
 
-	RIP_TIMER_OFF(rinfo->t_timeout);
-	RIP_TIMER_OFF(rinfo->t_garbage_collect);
 	memcpy(rinfo, rinfo_new, sizeof(struct rip_info));
+	rinfo->timeout_expire = 0;
+	rinfo->garbage_expire = 0;
 
 	if (rip_route_rte(rinfo)) {
 		rip_timeout_update(rinfo);
@@ -228,6 +288,8 @@ struct rip_info *rip_ecmp_replace(struct rip_info *rinfo_new)
 	/* Set the route change flag. */
 	SET_FLAG(rinfo->flags, RIP_RTF_CHANGED);
 
+	rip_update_cache_invalidate();
+
 	/* Signal the output process to trigger an update (see section 2.5). */
 	rip_event(RIP_TRIGGERED_UPDATE, 0);
 
@@ -245,12 +307,11 @@ struct rip_info *rip_ecmp_delete(struct rip_info *rinfo)
 	struct route_node *rp = rinfo->rp;
 	struct list *list = (struct list *)rp->info;
 
-	RIP_TIMER_OFF(rinfo->t_timeout);
+	rinfo->timeout_expire = 0;
 
 	if (listcount(list) > 1) {
 		/* Some other ECMP entries still exist. Just delete this entry.
 		 */
-		RIP_TIMER_OFF(rinfo->t_garbage_collect);
 		listnode_delete(list, rinfo);
 		if (rip_route_rte(rinfo)
 		    && CHECK_FLAG(rinfo->flags, RIP_RTF_FIB))
@@ -266,8 +327,7 @@ struct rip_info *rip_ecmp_delete(struct rip_info *rinfo)
 		 */
 
 		rinfo->metric = RIP_METRIC_INFINITY;
-		RIP_TIMER_ON(rinfo->t_garbage_collect, rip_garbage_collect,
-			     rip->garbage_time);
+		rinfo->garbage_expire = monotime(NULL) + rip->garbage_time;
 
 		if (rip_route_rte(rinfo)
 		    && CHECK_FLAG(rinfo->flags, RIP_RTF_FIB))
@@ -278,25 +338,18 @@ struct rip_info *rip_ecmp_delete(struct rip_info *rinfo)
 	rinfo = listgetdata(listhead(list));
 	SET_FLAG(rinfo->flags, RIP_RTF_CHANGED);
 
+	rip_update_cache_invalidate();
+
 	/* Signal the output process to trigger an update (see section 2.5). */
 	rip_event(RIP_TRIGGERED_UPDATE, 0);
 
 	return rinfo;
 }
 
-/* Timeout RIP routes. */
-static int rip_timeout(struct thread *t)
-{
-	rip_ecmp_delete((struct rip_info *)THREAD_ARG(t));
-	return 0;
-}
-
 static void rip_timeout_update(struct rip_info *rinfo)
 {
-	if (rinfo->metric != RIP_METRIC_INFINITY) {
-		RIP_TIMER_OFF(rinfo->t_timeout);
-		RIP_TIMER_ON(rinfo->t_timeout, rip_timeout, rip->timeout_time);
-	}
+	if (rinfo->metric != RIP_METRIC_INFINITY)
+		rinfo->timeout_expire = monotime(NULL) + rip->timeout_time;
 }
 
 static int rip_filter(int rip_distribute, struct prefix_ipv4 *p,
@@ -647,8 +700,6 @@ static void rip_rte_process(struct rte *rte, struct sockaddr_in *from,
 					assert(newinfo.metric
 					       != RIP_METRIC_INFINITY);
 
-					RIP_TIMER_OFF(rinfo->t_timeout);
-					RIP_TIMER_OFF(rinfo->t_garbage_collect);
 					memcpy(rinfo, &newinfo,
 					       sizeof(struct rip_info));
 					rip_timeout_update(rinfo);
@@ -915,8 +966,7 @@ static int rip_auth_md5(struct rip_packet *packet, struct sockaddr_in *from,
 		return 0;
 
 	/* MD5 digest authentication. */
-	memset(&ctx, 0, sizeof(ctx));
-	MD5Init(&ctx);
+	MD5Init(&ctx); /* fully initializes the context */
 	MD5Update(&ctx, packet, packet_len + RIP_HEADER_SIZE);
 	MD5Update(&ctx, auth_str, RIP_AUTH_MD5_SIZE);
 	MD5Final(digest, &ctx);
@@ -1073,8 +1123,7 @@ static void rip_auth_md5_set(struct stream *s, struct rip_interface *ri,
 	stream_putw(s, RIP_AUTH_DATA);
 
 	/* Generate a digest for the RIP packet. */
-	memset(&ctx, 0, sizeof(ctx));
-	MD5Init(&ctx);
+	MD5Init(&ctx); /* fully initializes the context */
 	MD5Update(&ctx, STREAM_DATA(s), stream_get_endp(s));
 	MD5Update(&ctx, auth_str, RIP_AUTH_MD5_SIZE);
 	MD5Final(digest, &ctx);
@@ -1542,10 +1591,9 @@ void rip_redistribute_delete(int type, int sub_type, struct prefix_ipv4 *p,
 			    && rinfo->nh.ifindex == ifindex) {
 				/* Perform poisoned reverse. */
 				rinfo->metric = RIP_METRIC_INFINITY;
-				RIP_TIMER_ON(rinfo->t_garbage_collect,
-					     rip_garbage_collect,
-					     rip->garbage_time);
-				RIP_TIMER_OFF(rinfo->t_timeout);
+				rinfo->garbage_expire =
+					monotime(NULL) + rip->garbage_time;
+				rinfo->timeout_expire = 0;
 				rinfo->flags |= RIP_RTF_CHANGED;
 
 				if (IS_RIP_DEBUG_EVENT)
@@ -1557,6 +1605,7 @@ void rip_redistribute_delete(int type, int sub_type, struct prefix_ipv4 *p,
 						ifindex2ifname(ifindex,
 							       VRF_DEFAULT));
 
+				rip_update_cache_invalidate();
 				rip_event(RIP_TRIGGERED_UPDATE, 0);
 			}
 		}
@@ -2056,6 +2105,7 @@ void rip_output_process(struct connected *ifc, struct sockaddr_in *to,
 	int num = 0;
 	int rtemax;
 	int subnetted = 0;
+	int caching = 0;
 	struct list *list = NULL;
 	struct listnode *listnode = NULL;
 
@@ -2069,6 +2119,35 @@ void rip_output_process(struct connected *ifc, struct sockaddr_in *to,
 				   ifc->ifp->name, ifc->ifp->ifindex);
 	}
 
+	/* Get RIP interface. */
+	ri = ifc->ifp->info;
+
+	/* For periodic updates, replay the packets built on a previous
+	 * cycle when neither the routing table nor the output policy
+	 * changed in between.  Authenticated updates are never cached:
+	 * the MD5 digest and key chain selection must be redone on every
+	 * transmission. */
+	if (route_type == rip_all_route && ri->auth_type == RIP_NO_AUTH
+	    && ri->update_cache && ri->update_cache_gen == rip_update_gen
+	    && ri->update_cache_ifc == ifc
+	    && ri->update_cache_version == version
+	    && ri->update_cache_horizon == ri->split_horizon) {
+		struct stream *cs;
+
+		for (ALL_LIST_ELEMENTS_RO(ri->update_cache, listnode, cs)) {
+			ret = rip_send_packet(STREAM_DATA(cs),
+					      stream_get_endp(cs), to, ifc);
+
+			if (ret >= 0 && IS_RIP_DEBUG_SEND)
+				rip_packet_dump(
+					(struct rip_packet *)STREAM_DATA(cs),
+					stream_get_endp(cs), "SEND");
+		}
+
+		ri->sent_updates++;
+		return;
+	}
+
 	/* Set output stream. */
 	s = rip->obuf;
 
@@ -2076,8 +2155,19 @@ void rip_output_process(struct connected *ifc, struct sockaddr_in *to,
 	stream_reset(s);
 	rtemax = RIP_MAX_RTE;
 
-	/* Get RIP interface. */
-	ri = ifc->ifp->info;
+	/* (Re)build the packet cache alongside the update we are about to
+	 * send out. */
+	caching = (route_type == rip_all_route
+		   && ri->auth_type == RIP_NO_AUTH);
+	if (caching) {
+		rip_update_cache_free(ri);
+		ri->update_cache = list_new();
+		ri->update_cache->del = rip_update_cache_stream_free;
+		ri->update_cache_gen = rip_update_gen;
+		ri->update_cache_ifc = ifc;
+		ri->update_cache_version = version;
+		ri->update_cache_horizon = ri->split_horizon;
+	}
 
 	/* If output interface is in simple password authentication mode, we
 	   need space for authentication data.  */
@@ -2377,6 +2467,9 @@ void rip_output_process(struct connected *ifc, struct sockaddr_in *to,
 								STREAM_DATA(s),
 							stream_get_endp(s),
 							"SEND");
+				if (caching)
+					listnode_add(ri->update_cache,
+						     stream_dup(s));
 				num = 0;
 				stream_reset(s);
 			}
@@ -2394,6 +2487,8 @@ void rip_output_process(struct connected *ifc, struct sockaddr_in *to,
 		if (ret >= 0 && IS_RIP_DEBUG_SEND)
 			rip_packet_dump((struct rip_packet *)STREAM_DATA(s),
 					stream_get_endp(s), "SEND");
+		if (caching)
+			listnode_add(ri->update_cache, stream_dup(s));
 		stream_reset(s);
 	}
 
@@ -2643,10 +2738,9 @@ void rip_redistribute_withdraw(int type)
 			    && rinfo->sub_type != RIP_ROUTE_INTERFACE) {
 				/* Perform poisoned reverse. */
 				rinfo->metric = RIP_METRIC_INFINITY;
-				RIP_TIMER_ON(rinfo->t_garbage_collect,
-					     rip_garbage_collect,
-					     rip->garbage_time);
-				RIP_TIMER_OFF(rinfo->t_timeout);
+				rinfo->garbage_expire =
+					monotime(NULL) + rip->garbage_time;
+				rinfo->timeout_expire = 0;
 				rinfo->flags |= RIP_RTF_CHANGED;
 
 				if (IS_RIP_DEBUG_EVENT) {
@@ -2662,6 +2756,7 @@ void rip_redistribute_withdraw(int type)
 							VRF_DEFAULT));
 				}
 
+				rip_update_cache_invalidate();
 				rip_event(RIP_TRIGGERED_UPDATE, 0);
 			}
 		}
@@ -2947,9 +3042,6 @@ void rip_ecmp_disable(void)
 			/* Drop all other entries, except the first one. */
 			for (ALL_LIST_ELEMENTS(list, node, nextnode, tmp_rinfo))
 				if (tmp_rinfo != rinfo) {
-					RIP_TIMER_OFF(tmp_rinfo->t_timeout);
-					RIP_TIMER_OFF(
-						tmp_rinfo->t_garbage_collect);
 					list_delete_node(list, node);
 					rip_info_free(tmp_rinfo);
 				}
@@ -2969,18 +3061,22 @@ void rip_ecmp_disable(void)
 static void rip_vty_out_uptime(struct vty *vty, struct rip_info *rinfo)
 {
 	time_t clock;
+	time_t now = monotime(NULL);
 	struct tm *tm;
 #define TIME_BUF 25
 	char timebuf[TIME_BUF];
-	struct thread *thread;
 
-	if ((thread = rinfo->t_timeout) != NULL) {
-		clock = thread_timer_remain_second(thread);
+	if (rinfo->timeout_expire) {
+		clock = (rinfo->timeout_expire > now)
+				? rinfo->timeout_expire - now
+				: 0;
 		tm = gmtime(&clock);
 		strftime(timebuf, TIME_BUF, "%M:%S", tm);
 		vty_out(vty, "%5s", timebuf);
-	} else if ((thread = rinfo->t_garbage_collect) != NULL) {
-		clock = thread_timer_remain_second(thread);
+	} else if (rinfo->garbage_expire) {
+		clock = (rinfo->garbage_expire > now)
+				? rinfo->garbage_expire - now
+				: 0;
 		tm = gmtime(&clock);
 		strftime(timebuf, TIME_BUF, "%M:%S", tm);
 		vty_out(vty, "%5s", timebuf);
@@ -3298,6 +3394,8 @@ static void rip_distribute_update(struct distribute_ctx *ctx,
 			ri->prefix[RIP_FILTER_OUT] = NULL;
 	} else
 		ri->prefix[RIP_FILTER_OUT] = NULL;
+
+	rip_update_cache_invalidate();
 }
 
 void rip_distribute_update_interface(struct interface *ifp)
@@ -3345,11 +3443,8 @@ void rip_clean(void)
 					rip_zebra_ipv4_delete(rp);
 
 				for (ALL_LIST_ELEMENTS_RO(list, listnode,
-							  rinfo)) {
-					RIP_TIMER_OFF(rinfo->t_timeout);
-					RIP_TIMER_OFF(rinfo->t_garbage_collect);
+							  rinfo))
 					rip_info_free(rinfo);
-				}
 				list_delete(&list);
 				rp->info = NULL;
 				route_unlock_node(rp);
@@ -3434,6 +3529,8 @@ static void rip_if_rmap_update(struct if_rmap_ctx *ctx,
 			ri->routemap[IF_RMAP_OUT] = NULL;
 	} else
 		ri->routemap[RIP_FILTER_OUT] = NULL;
+
+	rip_update_cache_invalidate();
 }
 
 void rip_if_rmap_update_interface(struct interface *ifp)
@@ -3480,6 +3577,7 @@ static void rip_routemap_update(const char *notused)
 		rip_if_rmap_update_interface(ifp);
 
 	rip_routemap_update_redistribute();
+	rip_update_cache_invalidate();
 }
 
 /* Allocate new rip structure and set default value. */
@@ -3521,4 +3619,9 @@ void rip_init(void)
 
 	/* Distance control. */
 	rip_distance_table = route_table_init();
+
+	/* Route aging wheel. */
+	rip_aging_wheel = wheel_init(master, RIP_AGING_PERIOD, RIP_AGING_SLOTS,
+				     rip_aging_slot_key, rip_aging_wheel_run,
+				     "RIP route aging");
 }
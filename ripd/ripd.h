@@ -211,9 +211,11 @@ struct rip_info {
 #define RIP_RTF_CHANGED  2
 	uint8_t flags;
 
-	/* Garbage collect timer. */
-	struct thread *t_timeout;
-	struct thread *t_garbage_collect;
+	/* Timeout and garbage collection deadlines in monotime seconds;
+	 * zero when disarmed.  Route aging runs off a coarse timer wheel
+	 * instead of per-route heap timers (see rip_aging_wheel_run). */
+	time_t timeout_expire;
+	time_t garbage_expire;
 
 	/* Route-map futures - this variables can be changed. */
 	struct in_addr nexthop_out;
@@ -293,6 +295,15 @@ struct rip_interface {
 
 	/* Passive interface. */
 	int passive;
+
+	/* Cached packets of the last periodic update, replayed while the
+	 * global update generation and the bits of per-interface policy
+	 * recorded below stay unchanged (see rip_output_process). */
+	struct list *update_cache;
+	uint32_t update_cache_gen;
+	struct connected *update_cache_ifc;
+	uint8_t update_cache_version;
+	split_horizon_policy_t update_cache_horizon;
 };
 
 /* RIP peer information. */
@@ -358,9 +369,6 @@ enum rip_event {
 	RIP_TRIGGERED_UPDATE,
 };
 
-/* Macro for timer turn on. */
-#define RIP_TIMER_ON(T,F,V) thread_add_timer (master, (F), rinfo, (V), &(T))
-
 /* Macro for timer turn off. */
 #define RIP_TIMER_OFF(X) THREAD_TIMER_OFF(X)
 
@@ -441,6 +449,8 @@ extern uint8_t rip_distance_apply(struct rip_info *);
 extern void rip_redistribute_clean(void);
 
 extern int rip_route_rte(struct rip_info *rinfo);
+extern void rip_update_cache_invalidate(void);
+extern void rip_update_cache_free(struct rip_interface *ri);
 extern struct rip_info *rip_ecmp_add(struct rip_info *);
 extern struct rip_info *rip_ecmp_replace(struct rip_info *);
 extern struct rip_info *rip_ecmp_delete(struct rip_info *);
@@ -801,8 +801,6 @@ static int clear_ripng_route_rpc(const char *xpath, const struct list *input,
 		}
 
 		if (rinfo) {
-			RIPNG_TIMER_OFF(rinfo->t_timeout);
-			RIPNG_TIMER_OFF(rinfo->t_garbage_collect);
 			listnode_delete(list, rinfo);
 			ripng_info_free(rinfo);
 		}
@@ -37,6 +37,9 @@
 #include "privs.h"
 #include "lib_errors.h"
 #include "northbound_cli.h"
+#include "monotime.h"
+#include "jhash.h"
+#include "wheel.h"
 
 #include "ripngd/ripngd.h"
 #include "ripngd/ripng_route.h"
@@ -48,6 +51,16 @@
    ripng->fd must be negative value. */
 struct ripng *ripng = NULL;
 
+/* Coarse timer wheel driving route timeout and garbage collection.
+ * Every ripng_info is a member; aging just compares deadlines when
+ * the entry's slot comes around, so refreshing a route on every
+ * update is a plain store instead of a timer-heap delete/insert
+ * pair. */
+static struct timer_wheel *ripng_aging_wheel;
+
+#define RIPNG_AGING_PERIOD 1000 /* msec, full wheel rotation */
+#define RIPNG_AGING_SLOTS 10
+
 enum { ripng_all_route,
        ripng_changed_route,
 };
@@ -84,12 +97,15 @@ struct ripng_info *ripng_info_new(void)
 	struct ripng_info *new;
 
 	new = XCALLOC(MTYPE_RIPNG_ROUTE, sizeof(struct ripng_info));
+	wheel_add_item(ripng_aging_wheel, new);
+
 	return new;
 }
 
 /* Free ripng information. */
 void ripng_info_free(struct ripng_info *rinfo)
 {
+	wheel_remove_item(ripng_aging_wheel, rinfo);
 	XFREE(MTYPE_RIPNG_ROUTE, rinfo);
 }
 
@@ -396,17 +412,14 @@ static int ripng_lladdr_check(struct interface *ifp, struct in6_addr *addr)
 	return 0;
 }
 
-/* RIPng route garbage collect timer. */
-static int ripng_garbage_collect(struct thread *t)
+/* RIPng route garbage collect. */
+static void ripng_garbage_collect(struct ripng_info *rinfo)
 {
-	struct ripng_info *rinfo;
 	struct agg_node *rp;
 
-	rinfo = THREAD_ARG(t);
-	rinfo->t_garbage_collect = NULL;
-
-	/* Off timeout timer. */
-	RIPNG_TIMER_OFF(rinfo->t_timeout);
+	/* Disarm both deadlines. */
+	rinfo->garbage_expire = 0;
+	rinfo->timeout_expire = 0;
 
 	/* Get route_node pointer. */
 	rp = rinfo->rp;
@@ -420,8 +433,28 @@ static int ripng_garbage_collect(struct thread *t)
 
 	/* Free RIPng routing information. */
 	ripng_info_free(rinfo);
+}
 
-	return 0;
+static unsigned int ripng_aging_slot_key(void *arg)
+{
+	return jhash_1word((uint32_t)(uintptr_t)arg, 0);
+}
+
+/* Called for every ripng_info whose wheel slot comes up; fire
+ * whichever deadline has passed. */
+static void ripng_aging_wheel_run(void *arg)
+{
+	struct ripng_info *rinfo = arg;
+	time_t now = monotime(NULL);
+
+	if (rinfo->timeout_expire && now >= rinfo->timeout_expire) {
+		rinfo->timeout_expire = 0;
+		ripng_ecmp_delete(rinfo);
+		return;
+	}
+
+	if (rinfo->garbage_expire && now >= rinfo->garbage_expire)
+		ripng_garbage_collect(rinfo);
 }
 
 static void ripng_timeout_update(struct ripng_info *rinfo);
@@ -493,15 +526,13 @@ struct ripng_info *ripng_ecmp_replace(struct ripng_info *rinfo_new)
 	/* Re-use the first entry, and delete the others. */
 	for (ALL_LIST_ELEMENTS(list, node, nextnode, tmp_rinfo))
 		if (tmp_rinfo != rinfo) {
-			RIPNG_TIMER_OFF(tmp_rinfo->t_timeout);
-			RIPNG_TIMER_OFF(tmp_rinfo->t_garbage_collect);
 			list_delete_node(list, node);
 			ripng_info_free(tmp_rinfo);
 		}
 
-	RIPNG_TIMER_OFF(rinfo->t_timeout);
-	RIPNG_TIMER_OFF(rinfo->t_garbage_collect);
 	memcpy(rinfo, rinfo_new, sizeof(struct ripng_info));
+	rinfo->timeout_expire = 0;
+	rinfo->garbage_expire = 0;
 
 	if (ripng_route_rte(rinfo)) {
 		ripng_timeout_update(rinfo);
@@ -531,7 +562,7 @@ struct ripng_info *ripng_ecmp_delete(struct ripng_info *rinfo)
 	struct agg_node *rp = rinfo->rp;
 	struct list *list = (struct list *)rp->info;
 
-	RIPNG_TIMER_OFF(rinfo->t_timeout);
+	rinfo->timeout_expire = 0;
 
 	if (rinfo->metric != RIPNG_METRIC_INFINITY)
 		ripng_aggregate_decrement(rp, rinfo);
@@ -539,7 +570,6 @@ struct ripng_info *ripng_ecmp_delete(struct ripng_info *rinfo)
 	if (listcount(list) > 1) {
 		/* Some other ECMP entries still exist. Just delete this entry.
 		 */
-		RIPNG_TIMER_OFF(rinfo->t_garbage_collect);
 		listnode_delete(list, rinfo);
 		if (ripng_route_rte(rinfo)
 		    && CHECK_FLAG(rinfo->flags, RIPNG_RTF_FIB))
@@ -555,8 +585,7 @@ struct ripng_info *ripng_ecmp_delete(struct ripng_info *rinfo)
 		 */
 
 		rinfo->metric = RIPNG_METRIC_INFINITY;
-		RIPNG_TIMER_ON(rinfo->t_garbage_collect, ripng_garbage_collect,
-			       ripng->garbage_time);
+		rinfo->garbage_expire = monotime(NULL) + ripng->garbage_time;
 
 		if (ripng_route_rte(rinfo)
 		    && CHECK_FLAG(rinfo->flags, RIPNG_RTF_FIB))
@@ -573,20 +602,10 @@ struct ripng_info *ripng_ecmp_delete(struct ripng_info *rinfo)
 	return rinfo;
 }
 
-/* Timeout RIPng routes. */
-static int ripng_timeout(struct thread *t)
-{
-	ripng_ecmp_delete((struct ripng_info *)THREAD_ARG(t));
-	return 0;
-}
-
 static void ripng_timeout_update(struct ripng_info *rinfo)
 {
-	if (rinfo->metric != RIPNG_METRIC_INFINITY) {
-		RIPNG_TIMER_OFF(rinfo->t_timeout);
-		RIPNG_TIMER_ON(rinfo->t_timeout, ripng_timeout,
-			       ripng->timeout_time);
-	}
+	if (rinfo->metric != RIPNG_METRIC_INFINITY)
+		rinfo->timeout_expire = monotime(NULL) + ripng->timeout_time;
 }
 
 static int ripng_filter(int ripng_distribute, struct prefix_ipv6 *p,
@@ -868,8 +887,8 @@ static void ripng_route_process(struct rte *rte, struct sockaddr_in6 *from,
 		 * highly recommended".
 		 */
 		if (!ripng->ecmp && !same && rinfo->metric == rte->metric
-		    && rinfo->t_timeout
-		    && (thread_timer_remain_second(rinfo->t_timeout)
+		    && rinfo->timeout_expire
+		    && (rinfo->timeout_expire - monotime(NULL)
 			< (ripng->timeout_time / 2))) {
 			ripng_ecmp_replace(&newinfo);
 		}
@@ -996,10 +1015,9 @@ void ripng_redistribute_delete(int type, int sub_type, struct prefix_ipv6 *p,
 			    && rinfo->ifindex == ifindex) {
 				/* Perform poisoned reverse. */
 				rinfo->metric = RIPNG_METRIC_INFINITY;
-				RIPNG_TIMER_ON(rinfo->t_garbage_collect,
-					       ripng_garbage_collect,
-					       ripng->garbage_time);
-				RIPNG_TIMER_OFF(rinfo->t_timeout);
+				rinfo->garbage_expire =
+					monotime(NULL) + ripng->garbage_time;
+				rinfo->timeout_expire = 0;
 
 				/* Aggregate count decrement. */
 				ripng_aggregate_decrement(rp, rinfo);
@@ -1039,10 +1057,9 @@ void ripng_redistribute_withdraw(int type)
 			    && (rinfo->sub_type != RIPNG_ROUTE_INTERFACE)) {
 				/* Perform poisoned reverse. */
 				rinfo->metric = RIPNG_METRIC_INFINITY;
-				RIPNG_TIMER_ON(rinfo->t_garbage_collect,
-					       ripng_garbage_collect,
-					       ripng->garbage_time);
-				RIPNG_TIMER_OFF(rinfo->t_timeout);
+				rinfo->garbage_expire =
+					monotime(NULL) + ripng->garbage_time;
+				rinfo->timeout_expire = 0;
 
 				/* Aggregate count decrement. */
 				ripng_aggregate_decrement(rp, rinfo);
@@ -1907,18 +1924,22 @@ void ripng_event(enum ripng_event event, int sock)
 static void ripng_vty_out_uptime(struct vty *vty, struct ripng_info *rinfo)
 {
 	time_t clock;
+	time_t now = monotime(NULL);
 	struct tm *tm;
 #define TIME_BUF 25
 	char timebuf[TIME_BUF];
-	struct thread *thread;
 
-	if ((thread = rinfo->t_timeout) != NULL) {
-		clock = thread_timer_remain_second(thread);
+	if (rinfo->timeout_expire) {
+		clock = (rinfo->timeout_expire > now)
+				? rinfo->timeout_expire - now
+				: 0;
 		tm = gmtime(&clock);
 		strftime(timebuf, TIME_BUF, "%M:%S", tm);
 		vty_out(vty, "%5s", timebuf);
-	} else if ((thread = rinfo->t_garbage_collect) != NULL) {
-		clock = thread_timer_remain_second(thread);
+	} else if (rinfo->garbage_expire) {
+		clock = (rinfo->garbage_expire > now)
+				? rinfo->garbage_expire - now
+				: 0;
 		tm = gmtime(&clock);
 		strftime(timebuf, TIME_BUF, "%M:%S", tm);
 		vty_out(vty, "%5s", timebuf);
@@ -2280,9 +2301,6 @@ void ripng_ecmp_disable(void)
 			/* Drop all other entries, except the first one. */
 			for (ALL_LIST_ELEMENTS(list, node, nextnode, tmp_rinfo))
 				if (tmp_rinfo != rinfo) {
-					RIPNG_TIMER_OFF(tmp_rinfo->t_timeout);
-					RIPNG_TIMER_OFF(
-						tmp_rinfo->t_garbage_collect);
 					list_delete_node(list, node);
 					ripng_info_free(tmp_rinfo);
 				}
@@ -2429,12 +2447,8 @@ void ripng_clean(void)
 					ripng_zebra_ipv6_delete(rp);
 
 				for (ALL_LIST_ELEMENTS_RO(list, listnode,
-							  rinfo)) {
-					RIPNG_TIMER_OFF(rinfo->t_timeout);
-					RIPNG_TIMER_OFF(
-						rinfo->t_garbage_collect);
+							  rinfo))
 					ripng_info_free(rinfo);
-				}
 				list_delete(&list);
 				rp->info = NULL;
 				agg_unlock_node(rp);
@@ -2613,4 +2627,10 @@ void ripng_init(void)
 	route_map_delete_hook(ripng_routemap_update);
 
 	if_rmap_init(RIPNG_NODE);
+
+	/* Route aging wheel. */
+	ripng_aging_wheel =
+		wheel_init(master, RIPNG_AGING_PERIOD, RIPNG_AGING_SLOTS,
+			   ripng_aging_slot_key, ripng_aging_wheel_run,
+			   "RIPng route aging");
 }
@@ -184,9 +184,11 @@ struct ripng_info {
 #define RIPNG_RTF_CHANGED  2
 	uint8_t flags;
 
-	/* Garbage collect timer. */
-	struct thread *t_timeout;
-	struct thread *t_garbage_collect;
+	/* Timeout and garbage collection deadlines in monotime seconds;
+	 * zero when disarmed.  Route aging runs off a coarse timer wheel
+	 * instead of per-route heap timers (see ripng_aging_wheel_run). */
+	time_t timeout_expire;
+	time_t garbage_expire;
 
 	/* Route-map features - this variables can be changed. */
 	struct in6_addr nexthop_out;
@@ -309,9 +311,7 @@ enum ripng_event {
 	RIPNG_TRIGGERED_UPDATE,
 };
 
-/* RIPng timer on/off macro. */
-#define RIPNG_TIMER_ON(T,F,V) thread_add_timer (master, (F), rinfo, (V), &(T))
-
+/* RIPng timer off macro. */
 #define RIPNG_TIMER_OFF(T)                                                     \
 	do {                                                                   \
 		if (T) {                                                       \
@@ -39,6 +39,22 @@ struct sharp_routes {
 
 	uint8_t inst;
 
+	/* Install/removal pacing.  rate is routes per second split over
+	 * 100ms ticks; 0 means send everything at once. */
+	uint32_t rate;
+	struct prefix pace_prefix;
+	uint32_t pace_left;
+	bool pace_install;
+	struct thread *t_pace;
+
+	/* Round trip latency samples for the last run.  Slot i holds the
+	 * nanosecond send timestamp of route i until its notify arrives. */
+	struct prefix lat_prefix;
+	uint64_t *lat_send;
+	uint64_t *lat_res;
+	uint32_t lat_total;
+	uint32_t lat_done;
+
 	struct timeval t_start;
 	struct timeval t_end;
 };
@@ -39,16 +39,19 @@
 #endif
 
 DEFPY(watch_nexthop_v6, watch_nexthop_v6_cmd,
-      "sharp watch <nexthop$n|import$import> X:X::X:X$nhop [connected$connected]",
+      "sharp watch <nexthop$n|import$import> X:X::X:X$nhop [connected$connected] [count (2-100000)$cnt]",
       "Sharp routing Protocol\n"
       "Watch for changes\n"
       "Watch for nexthop changes\n"
       "Watch for import check changes\n"
       "The v6 nexthop to signal for watching\n"
-      "Should the route be connected\n")
+      "Should the route be connected\n"
+      "Watch a range of consecutive nexthops\n"
+      "How many consecutive nexthops to watch\n")
 {
 	struct prefix p;
 	bool type_import;
+	long i, num = (cnt < 1) ? 1 : cnt;
 
 
 	if (n)
@@ -62,23 +65,29 @@ DEFPY(watch_nexthop_v6, watch_nexthop_v6_cmd,
 	memcpy(&p.u.prefix6, &nhop, 16);
 	p.family = AF_INET6;
 
-	sharp_nh_tracker_get(&p);
-	sharp_zebra_nexthop_watch(&p, type_import, true, !!connected);
+	for (i = 0; i < num; i++) {
+		sharp_nh_tracker_get(&p);
+		sharp_zebra_nexthop_watch(&p, type_import, true, !!connected);
+		p.u.val32[3] = htonl(ntohl(p.u.val32[3]) + 1);
+	}
 
 	return CMD_SUCCESS;
 }
 
 DEFPY(watch_nexthop_v4, watch_nexthop_v4_cmd,
-      "sharp watch <nexthop$n|import$import> A.B.C.D$nhop [connected$connected]",
+      "sharp watch <nexthop$n|import$import> A.B.C.D$nhop [connected$connected] [count (2-100000)$cnt]",
       "Sharp routing Protocol\n"
       "Watch for changes\n"
       "Watch for nexthop changes\n"
       "Watch for import check changes\n"
       "The v4 nexthop to signal for watching\n"
-      "Should the route be connected\n")
+      "Should the route be connected\n"
+      "Watch a range of consecutive nexthops\n"
+      "How many consecutive nexthops to watch\n")
 {
 	struct prefix p;
 	bool type_import;
+	long i, num = (cnt < 1) ? 1 : cnt;
 
 	memset(&p, 0, sizeof(p));
 
@@ -91,8 +100,11 @@ DEFPY(watch_nexthop_v4, watch_nexthop_v4_cmd,
 	p.u.prefix4 = nhop;
 	p.family = AF_INET;
 
-	sharp_nh_tracker_get(&p);
-	sharp_zebra_nexthop_watch(&p, type_import, true, !!connected);
+	for (i = 0; i < num; i++) {
+		sharp_nh_tracker_get(&p);
+		sharp_zebra_nexthop_watch(&p, type_import, true, !!connected);
+		p.u.prefix4.s_addr = htonl(ntohl(p.u.prefix4.s_addr) + 1);
+	}
 
 	return CMD_SUCCESS;
 }
@@ -127,12 +139,14 @@ DEFPY (install_routes_data_dump,
 		sg.r.removed_routes,
 		r.tv_sec, r.tv_usec);
 
+	sharp_lat_report(vty);
+
 	return CMD_SUCCESS;
 }
 
 DEFPY (install_routes,
        install_routes_cmd,
-       "sharp install routes <A.B.C.D$start4|X:X::X:X$start6> <nexthop <A.B.C.D$nexthop4|X:X::X:X$nexthop6>|nexthop-group NAME$nexthop_group> (1-1000000)$routes [instance (0-255)$instance] [repeat (2-1000)$rpt]",
+       "sharp install routes <A.B.C.D$start4|X:X::X:X$start6> <nexthop <A.B.C.D$nexthop4|X:X::X:X$nexthop6>|nexthop-group NAME$nexthop_group> (1-1000000)$routes [instance (0-255)$instance] [repeat (2-1000)$rpt] [rate (1-1000000)$rate]",
        "Sharp routing Protocol\n"
        "install some routes\n"
        "Routes to install\n"
@@ -147,13 +161,16 @@ DEFPY (install_routes,
        "Instance to use\n"
        "Instance\n"
        "Should we repeat this command\n"
-       "How many times to repeat this command\n")
+       "How many times to repeat this command\n"
+       "Pace the route installation\n"
+       "Routes to send per second\n")
 {
 	struct prefix prefix;
 	uint32_t rts;
 
 	sg.r.total_routes = routes;
 	sg.r.installed_routes = 0;
+	sg.r.rate = rate;
 
 	if (rpt >= 2)
 		sg.r.repeat = rpt * 2;
@@ -237,7 +254,7 @@ DEFPY(vrf_label, vrf_label_cmd,
 
 DEFPY (remove_routes,
        remove_routes_cmd,
-       "sharp remove routes <A.B.C.D$start4|X:X::X:X$start6> (1-1000000)$routes [instance (0-255)$instance]",
+       "sharp remove routes <A.B.C.D$start4|X:X::X:X$start6> (1-1000000)$routes [instance (0-255)$instance] [rate (1-1000000)$rate]",
        "Sharp Routing Protocol\n"
        "Remove some routes\n"
        "Routes to remove\n"
@@ -245,12 +262,15 @@ DEFPY (remove_routes,
        "v6 Starting spot\n"
        "Routes to uninstall\n"
        "instance to use\n"
-       "Value of instance\n")
+       "Value of instance\n"
+       "Pace the route removal\n"
+       "Routes to send per second\n")
 {
 	struct prefix prefix;
 
 	sg.r.total_routes = routes;
 	sg.r.removed_routes = 0;
+	sg.r.rate = rate;
 	uint32_t rts;
 
 	memset(&prefix, 0, sizeof(prefix));
@@ -131,53 +131,170 @@ static int interface_state_down(int command, struct zclient *zclient,
 	return 0;
 }
 
-void sharp_install_routes_helper(struct prefix *p, uint8_t instance,
-				 struct nexthop_group *nhg,
-				 uint32_t routes)
+DEFINE_MTYPE_STATIC(SHARPD, LATENCY, "Latency samples")
+
+static uint64_t sharp_time_nsec(void)
 {
-	uint32_t temp, i;
-	bool v4 = false;
+	struct timespec ts;
 
-	zlog_debug("Inserting %u routes", routes);
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static void sharp_lat_begin(struct prefix *p, uint32_t routes)
+{
+	XFREE(MTYPE_LATENCY, sg.r.lat_send);
+	XFREE(MTYPE_LATENCY, sg.r.lat_res);
+
+	sg.r.lat_prefix = *p;
+	sg.r.lat_send = XCALLOC(MTYPE_LATENCY, routes * sizeof(uint64_t));
+	sg.r.lat_res = XCALLOC(MTYPE_LATENCY, routes * sizeof(uint64_t));
+	sg.r.lat_total = routes;
+	sg.r.lat_done = 0;
+}
+
+static void sharp_lat_record(const struct prefix *p)
+{
+	uint32_t base, val, idx;
+
+	if (!sg.r.lat_send || p->family != sg.r.lat_prefix.family)
+		return;
 
 	if (p->family == AF_INET) {
-		v4 = true;
+		base = ntohl(sg.r.lat_prefix.u.prefix4.s_addr);
+		val = ntohl(p->u.prefix4.s_addr);
+	} else {
+		base = ntohl(sg.r.lat_prefix.u.val32[3]);
+		val = ntohl(p->u.val32[3]);
+	}
+
+	idx = val - base;
+	if (idx >= sg.r.lat_total || sg.r.lat_send[idx] == 0
+	    || sg.r.lat_res[idx] != 0)
+		return;
+
+	sg.r.lat_res[idx] = sharp_time_nsec() - sg.r.lat_send[idx];
+	sg.r.lat_done++;
+}
+
+static int sharp_lat_cmp(const void *a, const void *b)
+{
+	const uint64_t *la = a, *lb = b;
+
+	if (*la < *lb)
+		return -1;
+	if (*la > *lb)
+		return 1;
+	return 0;
+}
+
+void sharp_lat_report(struct vty *vty)
+{
+	uint64_t *sorted;
+	uint32_t i, count = 0;
+
+	if (!sg.r.lat_res || sg.r.lat_done == 0) {
+		vty_out(vty, "No latency samples collected yet\n");
+		return;
+	}
+
+	sorted = XCALLOC(MTYPE_LATENCY, sg.r.lat_done * sizeof(uint64_t));
+	for (i = 0; i < sg.r.lat_total && count < sg.r.lat_done; i++) {
+		if (sg.r.lat_res[i])
+			sorted[count++] = sg.r.lat_res[i];
+	}
+	qsort(sorted, count, sizeof(uint64_t), sharp_lat_cmp);
+
+	vty_out(vty,
+		"Zapi round trip latency (usec) over %u samples: p50 %" PRIu64
+		" p90 %" PRIu64 " p99 %" PRIu64 " max %" PRIu64 "\n",
+		count, sorted[count / 2] / 1000, sorted[(count * 9) / 10] / 1000,
+		sorted[(count * 99) / 100] / 1000, sorted[count - 1] / 1000);
+
+	XFREE(MTYPE_LATENCY, sorted);
+}
+
+/*
+ * Send the next burst of the current run.  With a configured rate the
+ * run is spread over 100ms ticks; without one the whole range goes out
+ * in a single call, as before.
+ */
+static int sharp_route_pace_timer(struct thread *t);
+
+static void sharp_route_pace_chunk(void)
+{
+	struct prefix *p = &sg.r.pace_prefix;
+	uint32_t temp, burst, idx;
+	bool v4 = (p->family == AF_INET);
+
+	burst = sg.r.rate ? sg.r.rate / 10 : sg.r.pace_left;
+	if (burst == 0)
+		burst = 1;
+	if (burst > sg.r.pace_left)
+		burst = sg.r.pace_left;
+
+	if (v4)
 		temp = ntohl(p->u.prefix4.s_addr);
-	} else
+	else
 		temp = ntohl(p->u.val32[3]);
 
-	monotime(&sg.r.t_start);
-	for (i = 0; i < routes; i++) {
-		route_add(p, (uint8_t)instance, nhg);
+	for (; burst > 0; burst--) {
+		idx = sg.r.lat_total - sg.r.pace_left;
+		if (sg.r.lat_send && idx < sg.r.lat_total)
+			sg.r.lat_send[idx] = sharp_time_nsec();
+
+		if (sg.r.pace_install)
+			route_add(p, sg.r.inst, &sg.r.nhop_group);
+		else
+			route_delete(p, sg.r.inst);
+		sg.r.pace_left--;
+
 		if (v4)
 			p->u.prefix4.s_addr = htonl(++temp);
 		else
 			p->u.val32[3] = htonl(++temp);
 	}
+
+	if (sg.r.pace_left)
+		thread_add_timer_msec(master, sharp_route_pace_timer, NULL,
+				      100, &sg.r.t_pace);
+}
+
+static int sharp_route_pace_timer(struct thread *t)
+{
+	sharp_route_pace_chunk();
+	return 0;
+}
+
+void sharp_install_routes_helper(struct prefix *p, uint8_t instance,
+				 struct nexthop_group *nhg,
+				 uint32_t routes)
+{
+	zlog_debug("Inserting %u routes", routes);
+
+	sg.r.pace_prefix = *p;
+	sg.r.pace_left = routes;
+	sg.r.pace_install = true;
+	THREAD_OFF(sg.r.t_pace);
+	sharp_lat_begin(p, routes);
+
+	monotime(&sg.r.t_start);
+	sharp_route_pace_chunk();
 }
 
 void sharp_remove_routes_helper(struct prefix *p, uint8_t instance,
 				uint32_t routes)
 {
-	uint32_t temp, i;
-	bool v4 = false;
-
 	zlog_debug("Removing %u routes", routes);
 
-	if (p->family == AF_INET) {
-		v4 = true;
-		temp = ntohl(p->u.prefix4.s_addr);
-	} else
-		temp = ntohl(p->u.val32[3]);
+	sg.r.pace_prefix = *p;
+	sg.r.pace_left = routes;
+	sg.r.pace_install = false;
+	THREAD_OFF(sg.r.t_pace);
+	sharp_lat_begin(p, routes);
 
 	monotime(&sg.r.t_start);
-	for (i = 0; i < routes; i++) {
-		route_delete(p, (uint8_t)instance);
-		if (v4)
-			p->u.prefix4.s_addr = htonl(++temp);
-		else
-			p->u.val32[3] = htonl(++temp);
-	}
+	sharp_route_pace_chunk();
 }
 
 static void handle_repeated(bool installed)
@@ -213,6 +330,7 @@ static int route_notify_owner(int command, struct zclient *zclient,
 
 	switch (note) {
 	case ZAPI_ROUTE_INSTALLED:
+		sharp_lat_record(&p);
 		sg.r.installed_routes++;
 		if (sg.r.total_routes == sg.r.installed_routes) {
 			monotime(&sg.r.t_end);
@@ -229,6 +347,7 @@ static int route_notify_owner(int command, struct zclient *zclient,
 		zlog_debug("Better Admin Distance won over us");
 		break;
 	case ZAPI_ROUTE_REMOVED:
+		sharp_lat_record(&p);
 		sg.r.removed_routes++;
 		if (sg.r.total_routes == sg.r.removed_routes) {
 			monotime(&sg.r.t_end);
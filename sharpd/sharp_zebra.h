@@ -36,4 +36,5 @@ extern void sharp_install_routes_helper(struct prefix *p, uint8_t instance,
 					 uint32_t routes);
 extern void sharp_remove_routes_helper(struct prefix *p, uint8_t instance,
 				       uint32_t routes);
+extern void sharp_lat_report(struct vty *vty);
 #endif
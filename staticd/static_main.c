@@ -141,6 +141,7 @@ int main(int argc, char **argv, char **envp)
 	master = frr_init();
 
 	access_list_init();
+	static_nht_index_init();
 	static_vrf_init();
 
 	static_zebra_init();
@@ -23,74 +23,61 @@
 #include "table.h"
 #include "vrf.h"
 #include "nexthop.h"
+#include "linklist.h"
 
 #include "static_vrf.h"
 #include "static_routes.h"
 #include "static_zebra.h"
 #include "static_nht.h"
 
-static void static_nht_update_safi(struct prefix *p, uint32_t nh_num,
-				   afi_t afi, safi_t safi, struct vrf *vrf,
-				   vrf_id_t nh_vrf_id)
+void static_nht_update(struct prefix *p, uint32_t nh_num, afi_t afi,
+		       vrf_id_t nh_vrf_id)
 {
-	struct route_table *stable;
-	struct static_route *si;
-	struct static_vrf *svrf;
-	struct route_node *rn;
-	bool orig;
-	bool reinstall;
+	struct static_route *si, *sibling;
+	struct listnode *node;
+	struct list *routes;
+	union g_addr addr;
+	bool valid = !!nh_num;
+	bool changed = false;
 
-	svrf = vrf->info;
-	if (!svrf)
-		return;
+	memset(&addr, 0, sizeof(addr));
+	if (p->family == AF_INET)
+		addr.ipv4 = p->u.prefix4;
+	else
+		addr.ipv6 = p->u.prefix6;
 
-	stable = static_vrf_static_table(afi, safi, svrf);
-	if (!stable)
+	routes = static_nht_index_lookup(p->family, &addr, nh_vrf_id);
+	if (!routes)
 		return;
 
-	for (rn = route_top(stable); rn; rn = route_next(rn)) {
-		reinstall = false;
-		for (si = rn->info; si; si = si->next) {
-			if (si->nh_vrf_id != nh_vrf_id)
-				return;
-
-			if (si->type != STATIC_IPV4_GATEWAY
-			    && si->type != STATIC_IPV4_GATEWAY_IFNAME
-			    && si->type != STATIC_IPV6_GATEWAY
-			    && si->type != STATIC_IPV6_GATEWAY_IFNAME)
-				return;
+	/* First flip validity on every dependent route, then announce.
+	 * One zebra message carries all nexthops of a prefix that share
+	 * a distance and table, so siblings covered by an earlier
+	 * announcement drop their pending bit instead of re-sending. */
+	for (ALL_LIST_ELEMENTS_RO(routes, node, si)) {
+		if (si->nh_valid == valid)
+			continue;
 
-			orig = si->nh_valid;
-			if (p->family == AF_INET
-			    && p->u.prefix4.s_addr == si->addr.ipv4.s_addr)
-				si->nh_valid = !!nh_num;
+		si->nh_valid = valid;
+		si->nh_update_pending = true;
+		changed = true;
+	}
 
-			if (p->family == AF_INET6
-			    && memcmp(&p->u.prefix6, &si->addr.ipv6, 16) == 0)
-				si->nh_valid = !!nh_num;
+	if (!changed)
+		return;
 
-			if (orig != si->nh_valid)
-				reinstall = true;
+	for (ALL_LIST_ELEMENTS_RO(routes, node, si)) {
+		if (!si->nh_update_pending)
+			continue;
 
-			if (reinstall) {
-				static_zebra_route_add(rn, si, vrf->vrf_id,
-						       safi, true);
-				reinstall = false;
-			}
+		for (sibling = si->rn->info; sibling;
+		     sibling = sibling->next) {
+			if (sibling->distance == si->distance
+			    && sibling->table_id == si->table_id)
+				sibling->nh_update_pending = false;
 		}
-	}
-}
-
-void static_nht_update(struct prefix *p, uint32_t nh_num, afi_t afi,
-		       vrf_id_t nh_vrf_id)
-{
-
-	struct vrf *vrf;
 
-	RB_FOREACH (vrf, vrf_name_head, &vrfs_by_name) {
-		static_nht_update_safi(p, nh_num, afi, SAFI_UNICAST,
-				       vrf, nh_vrf_id);
-		static_nht_update_safi(p, nh_num, afi, SAFI_MULTICAST,
-				       vrf, nh_vrf_id);
+		static_zebra_route_add(si->rn, si, si->vrf_id, si->safi,
+				       true);
 	}
 }
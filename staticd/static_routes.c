@@ -26,12 +26,150 @@
 #include <lib/vty.h>
 #include <lib/vrf.h>
 #include <lib/memory.h>
+#include <lib/hash.h>
+#include <lib/jhash.h>
+#include <lib/linklist.h>
 
 #include "static_vrf.h"
 #include "static_routes.h"
 #include "static_memory.h"
 #include "static_zebra.h"
 
+/*
+ * Index from tracked nexthop to the gateway routes resolving over it,
+ * so a nexthop-tracking update from zebra touches only the dependent
+ * routes instead of walking every static table (see static_nht_update).
+ */
+static struct hash *static_nht_index;
+
+struct static_nht_index_entry {
+	/* Key: nexthop address and the vrf it is resolved in. */
+	int family;
+	union g_addr addr;
+	vrf_id_t nh_vrf_id;
+
+	/* Gateway routes using this nexthop. */
+	struct list *routes;
+};
+
+/* Fill in the index key for a route; false if it is not gateway based
+ * and hence not indexed. */
+static bool static_nht_index_entry_make(const struct static_route *si,
+					struct static_nht_index_entry *entry)
+{
+	memset(entry, 0, sizeof(*entry));
+
+	switch (si->type) {
+	case STATIC_IPV4_GATEWAY:
+	case STATIC_IPV4_GATEWAY_IFNAME:
+		entry->family = AF_INET;
+		entry->addr.ipv4 = si->addr.ipv4;
+		break;
+	case STATIC_IPV6_GATEWAY:
+	case STATIC_IPV6_GATEWAY_IFNAME:
+		entry->family = AF_INET6;
+		entry->addr.ipv6 = si->addr.ipv6;
+		break;
+	case STATIC_IFNAME:
+	case STATIC_BLACKHOLE:
+		return false;
+	}
+
+	entry->nh_vrf_id = si->nh_vrf_id;
+
+	return true;
+}
+
+static unsigned int static_nht_index_key(void *data)
+{
+	struct static_nht_index_entry *entry = data;
+
+	return jhash2((const uint32_t *)&entry->addr,
+		      sizeof(entry->addr) / sizeof(uint32_t),
+		      jhash_1word(entry->nh_vrf_id, entry->family));
+}
+
+static bool static_nht_index_cmp(const void *d1, const void *d2)
+{
+	const struct static_nht_index_entry *e1 = d1;
+	const struct static_nht_index_entry *e2 = d2;
+
+	if (e1->family != e2->family)
+		return false;
+
+	if (e1->nh_vrf_id != e2->nh_vrf_id)
+		return false;
+
+	return memcmp(&e1->addr, &e2->addr, sizeof(e1->addr)) == 0;
+}
+
+static void *static_nht_index_alloc(void *data)
+{
+	struct static_nht_index_entry *copy = data;
+	struct static_nht_index_entry *new;
+
+	new = XMALLOC(MTYPE_TMP, sizeof(*new));
+	*new = *copy;
+	new->routes = list_new();
+
+	return new;
+}
+
+static void static_nht_index_add(struct static_route *si)
+{
+	struct static_nht_index_entry lookup, *entry;
+
+	if (!static_nht_index_entry_make(si, &lookup))
+		return;
+
+	entry = hash_get(static_nht_index, &lookup, static_nht_index_alloc);
+	listnode_add(entry->routes, si);
+}
+
+static void static_nht_index_del(struct static_route *si)
+{
+	struct static_nht_index_entry lookup, *entry;
+
+	if (!static_nht_index_entry_make(si, &lookup))
+		return;
+
+	entry = hash_lookup(static_nht_index, &lookup);
+	if (!entry)
+		return;
+
+	listnode_delete(entry->routes, si);
+	if (list_isempty(entry->routes)) {
+		hash_release(static_nht_index, entry);
+		list_delete(&entry->routes);
+		XFREE(MTYPE_TMP, entry);
+	}
+}
+
+struct list *static_nht_index_lookup(int family, const union g_addr *addr,
+				     vrf_id_t nh_vrf_id)
+{
+	struct static_nht_index_entry lookup, *entry;
+
+	memset(&lookup, 0, sizeof(lookup));
+	lookup.family = family;
+	if (family == AF_INET)
+		lookup.addr.ipv4 = addr->ipv4;
+	else
+		lookup.addr.ipv6 = addr->ipv6;
+	lookup.nh_vrf_id = nh_vrf_id;
+
+	entry = hash_lookup(static_nht_index, &lookup);
+
+	return entry ? entry->routes : NULL;
+}
+
+void static_nht_index_init(void)
+{
+	static_nht_index = hash_create(static_nht_index_key,
+				       static_nht_index_cmp,
+				       "Static NHT index");
+}
+
 /* Install static route into rib. */
 static void static_install_route(struct route_node *rn,
 				 struct static_route *si_changed, safi_t safi)
@@ -181,6 +319,11 @@ int static_add_route(afi_t afi, safi_t safi, uint8_t type, struct prefix *p,
 	si->prev = pp;
 	si->next = cp;
 
+	/* Index by tracked nexthop. */
+	si->rn = rn;
+	si->safi = safi;
+	static_nht_index_add(si);
+
 	/* check whether interface exists in system & install if it does */
 	if (!ifname)
 		static_install_route(rn, si, safi);
@@ -242,6 +385,7 @@ int static_delete_route(afi_t afi, safi_t safi, uint8_t type, struct prefix *p,
 		return 0;
 	}
 
+	static_nht_index_del(si);
 	static_zebra_nht_register(si, false);
 
 	/* Unlink static route from linked list. */
@@ -328,7 +472,10 @@ static void static_fixup_vrf(struct static_vrf *svrf,
 			if (strcmp(svrf->vrf->name, si->nh_vrfname) != 0)
 				continue;
 
+			/* The nexthop vrf is part of the index key. */
+			static_nht_index_del(si);
 			si->nh_vrf_id = svrf->vrf->vrf_id;
+			static_nht_index_add(si);
 			if (si->ifindex) {
 				ifp = if_lookup_by_name(si->ifname,
 							si->nh_vrf_id);
@@ -86,6 +86,14 @@ struct static_route {
 	 * are specified.
 	 */
 	bool onlink;
+
+	/* Back pointers for the tracked-nexthop index. */
+	struct route_node *rn;
+	safi_t safi;
+
+	/* Announcement owed after a nexthop validity flip; used to
+	 * coalesce zebra updates within one NHT event. */
+	bool nh_update_pending;
 };
 
 extern bool mpls_enabled;
@@ -94,6 +102,11 @@ extern struct zebra_privs_t static_privs;
 
 void static_fixup_vrf_ids(struct static_vrf *svrf);
 
+extern void static_nht_index_init(void);
+extern struct list *static_nht_index_lookup(int family,
+					    const union g_addr *addr,
+					    vrf_id_t nh_vrf_id);
+
 extern int static_add_route(afi_t afi, safi_t safi, uint8_t type,
 			    struct prefix *p, struct prefix_ipv6 *src_p,
 			    union g_addr *gate, const char *ifname,
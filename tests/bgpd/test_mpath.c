@@ -98,8 +98,7 @@ static struct bgp *bgp_create_fake(as_t *as, const char *name)
 	// bgp->peer_self->host = XSTRDUP (MTYPE_BGP_PEER_HOST, "Static
 	// announcement");
 
-	bgp->peer = list_new();
-	// bgp->peer->cmp = (int (*)(void *, void *)) peer_cmp;
+	bgp_peers_init(&bgp->peer);
 
 	bgp->group = list_new();
 	// bgp->group->cmp = (int (*)(void *, void *)) peer_group_cmp;
@@ -257,6 +256,7 @@ static int run_bgp_mp_list(testcase_t *t)
 	bgp_mp_list_add(&mp_list, &test_mp_list_info[2]);
 	bgp_mp_list_add(&mp_list, &test_mp_list_info[3]);
 	bgp_mp_list_add(&mp_list, &test_mp_list_info[0]);
+	bgp_mp_list_sort(&mp_list);
 
 	for (i = 0, mp_node = mp_list.head; i < test_mp_list_info_count;
 	     i++, mp_node = listnextnode(mp_node)) {
@@ -0,0 +1,376 @@
+/*
+ * Microbenchmarks for lib/ primitives.
+ *
+ * Measures route_table insert/lookup/walk, hash growth, stream
+ * encode/decode, timer scheduling and workqueue throughput.  Prints a
+ * human-readable table on stderr and JSON on stdout; a previous JSON
+ * run can be passed back in as a baseline to catch regressions.
+ *
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "hash.h"
+#include "jhash.h"
+#include "lib/json.h"
+#include "memory.h"
+#include "prefix.h"
+#include "stream.h"
+#include "table.h"
+#include "thread.h"
+#include "workqueue.h"
+
+#include "prng.h"
+
+#define ROUTE_COUNT	 250000
+#define HASH_COUNT	1000000
+#define STREAM_MSGS	1000000
+#define TIMER_COUNT	 500000
+#define WQ_ITEMS	1000000
+
+/* regression threshold against the baseline, percent */
+#define DEFAULT_TOLERANCE 10.0
+
+struct thread_master *master;
+
+struct bench_result {
+	const char *name;
+	unsigned long iterations;
+	double ns_per_op;
+};
+
+static struct bench_result results[32];
+static unsigned int n_results;
+static struct timeval bench_tv;
+
+static void bench_begin(void)
+{
+	monotime(&bench_tv);
+}
+
+static void bench_end(const char *name, unsigned long iterations)
+{
+	struct timeval now, delta;
+	struct bench_result *br;
+
+	monotime(&now);
+	timersub(&now, &bench_tv, &delta);
+
+	assert(n_results < array_size(results));
+	br = &results[n_results++];
+	br->name = name;
+	br->iterations = iterations;
+	br->ns_per_op = (delta.tv_sec * 1e9 + delta.tv_usec * 1e3)
+			/ iterations;
+
+	fprintf(stderr, "%-24s %10lu iterations %12.1f ns/op\n", name,
+		iterations, br->ns_per_op);
+}
+
+static void bench_route_table(struct prng *prng)
+{
+	struct route_table *table;
+	struct route_node **rns;
+	struct route_node *rn;
+	struct prefix *prefixes;
+	unsigned long i, count = 0;
+
+	table = route_table_init();
+	rns = XCALLOC(MTYPE_TMP, ROUTE_COUNT * sizeof(*rns));
+	prefixes = XCALLOC(MTYPE_TMP, ROUTE_COUNT * sizeof(*prefixes));
+
+	/* pre-generate prefixes so the prng isn't part of the measurement */
+	for (i = 0; i < ROUTE_COUNT; i++) {
+		prefixes[i].family = AF_INET;
+		prefixes[i].prefixlen = IPV4_MAX_BITLEN;
+		prefixes[i].u.prefix4.s_addr = htonl(prng_rand(prng));
+	}
+
+	bench_begin();
+	for (i = 0; i < ROUTE_COUNT; i++)
+		rns[i] = route_node_get(table, &prefixes[i]);
+	bench_end("route_table_insert", ROUTE_COUNT);
+
+	bench_begin();
+	for (i = 0; i < ROUTE_COUNT; i++) {
+		rn = route_node_lookup(table, &prefixes[i]);
+		assert(rn);
+		route_unlock_node(rn);
+	}
+	bench_end("route_table_lookup", ROUTE_COUNT);
+
+	bench_begin();
+	for (rn = route_top(table); rn; rn = route_next(rn))
+		count++;
+	bench_end("route_table_walk", count);
+
+	for (i = 0; i < ROUTE_COUNT; i++)
+		route_unlock_node(rns[i]);
+	route_table_finish(table);
+	XFREE(MTYPE_TMP, rns);
+	XFREE(MTYPE_TMP, prefixes);
+}
+
+static unsigned int bench_hash_key(void *data)
+{
+	return jhash_1word(*(uint32_t *)data, 0x55aa5a5a);
+}
+
+static bool bench_hash_cmp(const void *a, const void *b)
+{
+	return *(const uint32_t *)a == *(const uint32_t *)b;
+}
+
+static void bench_hash(void)
+{
+	struct hash *hash;
+	uint32_t *vals;
+	unsigned long i;
+	void *ret;
+
+	hash = hash_create(bench_hash_key, bench_hash_cmp, "benchmark");
+	vals = XCALLOC(MTYPE_TMP, HASH_COUNT * sizeof(*vals));
+	for (i = 0; i < HASH_COUNT; i++)
+		vals[i] = i;
+
+	/* distinct keys; starts at the default size so this exercises all
+	 * the intermediate grow steps */
+	bench_begin();
+	for (i = 0; i < HASH_COUNT; i++)
+		hash_get(hash, &vals[i], hash_alloc_intern);
+	bench_end("hash_get_growth", HASH_COUNT);
+
+	bench_begin();
+	for (i = 0; i < HASH_COUNT; i++) {
+		ret = hash_lookup(hash, &vals[i]);
+		assert(ret);
+	}
+	bench_end("hash_lookup", HASH_COUNT);
+
+	hash_clean(hash, NULL);
+	hash_free(hash);
+	XFREE(MTYPE_TMP, vals);
+}
+
+static void bench_stream(void)
+{
+	struct stream *s;
+	unsigned long i;
+	int round;
+	uint64_t sink = 0;
+
+	s = stream_new(4096);
+
+	bench_begin();
+	for (i = 0; i < STREAM_MSGS; i++) {
+		stream_reset(s);
+		for (round = 0; round < 4; round++) {
+			stream_putc(s, 0x7f);
+			stream_putw(s, 0x1234);
+			stream_putl(s, 0xdeadbeef);
+			stream_putq(s, 0x0123456789abcdefULL);
+		}
+	}
+	bench_end("stream_encode", STREAM_MSGS);
+
+	bench_begin();
+	for (i = 0; i < STREAM_MSGS; i++) {
+		stream_set_getp(s, 0);
+		for (round = 0; round < 4; round++) {
+			sink += stream_getc(s);
+			sink += stream_getw(s);
+			sink += stream_getl(s);
+			sink += stream_getq(s);
+		}
+	}
+	bench_end("stream_decode", STREAM_MSGS);
+
+	/* keep the reads from being optimized out */
+	assert(sink != 0);
+
+	stream_free(s);
+}
+
+static int bench_dummy_func(struct thread *thread)
+{
+	return 0;
+}
+
+static void bench_timers(struct prng *prng)
+{
+	struct thread **timers;
+	long *intervals;
+	unsigned long i;
+
+	timers = XCALLOC(MTYPE_TMP, TIMER_COUNT * sizeof(*timers));
+	intervals = XCALLOC(MTYPE_TMP, TIMER_COUNT * sizeof(*intervals));
+	for (i = 0; i < TIMER_COUNT; i++)
+		intervals[i] = prng_rand(prng) % (100 * TIMER_COUNT);
+
+	bench_begin();
+	for (i = 0; i < TIMER_COUNT; i++)
+		thread_add_timer_msec(master, bench_dummy_func, NULL,
+				      intervals[i], &timers[i]);
+	bench_end("thread_timer_add", TIMER_COUNT);
+
+	bench_begin();
+	for (i = 0; i < TIMER_COUNT; i++)
+		thread_cancel(timers[i]);
+	bench_end("thread_timer_cancel", TIMER_COUNT);
+
+	XFREE(MTYPE_TMP, timers);
+	XFREE(MTYPE_TMP, intervals);
+}
+
+static unsigned long wq_items_done;
+
+static wq_item_status bench_wq_func(struct work_queue *wq, void *data)
+{
+	wq_items_done++;
+	return WQ_SUCCESS;
+}
+
+static void bench_workqueue(void)
+{
+	struct work_queue *wq;
+	struct thread thread;
+	unsigned long i;
+
+	wq = work_queue_new(master, "benchmark");
+	wq->spec.workfunc = bench_wq_func;
+	wq->spec.max_retries = 0;
+	wq->spec.hold = 0;
+
+	for (i = 0; i < WQ_ITEMS; i++)
+		work_queue_add(wq, (void *)0x1);
+
+	bench_begin();
+	while (wq_items_done < WQ_ITEMS && thread_fetch(master, &thread))
+		thread_call(&thread);
+	bench_end("workqueue_run", WQ_ITEMS);
+
+	work_queue_free_and_null(&wq);
+}
+
+static void print_json(void)
+{
+	unsigned int i;
+
+	printf("{\n  \"benchmarks\":[\n");
+	for (i = 0; i < n_results; i++)
+		printf("    {\"name\":\"%s\",\"iterations\":%lu,"
+		       "\"ns_per_op\":%.1f}%s\n",
+		       results[i].name, results[i].iterations,
+		       results[i].ns_per_op, i + 1 < n_results ? "," : "");
+	printf("  ]\n}\n");
+}
+
+/* returns the number of benchmarks that regressed beyond the tolerance,
+ * or -1 if the baseline could not be read */
+static int compare_baseline(const char *file, double tolerance)
+{
+	json_object *root, *benchmarks, *jb, *jname, *jns;
+	int i, j, len, regressions = 0;
+	double base, delta;
+
+	root = json_object_from_file(file);
+	if (!root) {
+		fprintf(stderr, "could not read baseline %s\n", file);
+		return -1;
+	}
+	if (!json_object_object_get_ex(root, "benchmarks", &benchmarks)) {
+		fprintf(stderr, "baseline %s has no \"benchmarks\"\n", file);
+		json_object_free(root);
+		return -1;
+	}
+
+	fprintf(stderr, "\ncomparison against %s (tolerance %.1f%%):\n", file,
+		tolerance);
+
+	len = json_object_array_length(benchmarks);
+	for (i = 0; i < (int)n_results; i++) {
+		for (j = 0; j < len; j++) {
+			jb = json_object_array_get_idx(benchmarks, j);
+			if (!json_object_object_get_ex(jb, "name", &jname)
+			    || strcmp(json_object_get_string(jname),
+				      results[i].name))
+				continue;
+			if (!json_object_object_get_ex(jb, "ns_per_op", &jns))
+				continue;
+
+			base = json_object_get_double(jns);
+			delta = (results[i].ns_per_op - base) / base * 100.0;
+			fprintf(stderr,
+				"%-24s %12.1f -> %12.1f ns/op (%+6.1f%%)%s\n",
+				results[i].name, base, results[i].ns_per_op,
+				delta,
+				delta > tolerance ? "  REGRESSION" : "");
+			if (delta > tolerance)
+				regressions++;
+			break;
+		}
+	}
+
+	json_object_free(root);
+	return regressions;
+}
+
+int main(int argc, char **argv)
+{
+	struct prng *prng;
+	const char *baseline = NULL;
+	double tolerance = DEFAULT_TOLERANCE;
+	int opt, regressions = 0;
+
+	while ((opt = getopt(argc, argv, "b:t:")) != -1) {
+		switch (opt) {
+		case 'b':
+			baseline = optarg;
+			break;
+		case 't':
+			tolerance = atof(optarg);
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-b baseline.json] [-t tolerance%%]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	master = thread_master_create(NULL);
+	prng = prng_new(0);
+
+	bench_route_table(prng);
+	bench_hash();
+	bench_stream();
+	bench_timers(prng);
+	bench_workqueue();
+
+	print_json();
+	if (baseline)
+		regressions = compare_baseline(baseline, tolerance);
+
+	prng_free(prng);
+	thread_master_free(master);
+
+	return regressions != 0;
+}
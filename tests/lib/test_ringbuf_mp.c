@@ -0,0 +1,118 @@
+/*
+ * Multi-producer ring buffer tests.
+ * Copyright (C) 2019 FRRouting contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <zebra.h>
+#include <pthread.h>
+
+#include "memory.h"
+#include "ringbuf.h"
+
+#define NPRODUCERS 4
+#define NITEMS 100000 /* per producer */
+
+static struct ringbuf_mp *ring;
+
+static void *producer(void *arg)
+{
+	uintptr_t id = (uintptr_t)arg;
+	void *batch[16];
+	size_t n, sent = 0, queued;
+
+	while (sent < NITEMS) {
+		n = MIN((size_t)(NITEMS - sent), array_size(batch));
+		for (size_t i = 0; i < n; i++)
+			/* tag items with producer id + sequence number */
+			batch[i] = (void *)((id << 28) | (sent + i + 1));
+
+		queued = ringbuf_mp_put_batch(ring, batch, n);
+		sent += queued;
+	}
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t threads[NPRODUCERS];
+	void *items[32];
+	uintptr_t last_seen[NPRODUCERS] = {0};
+	size_t total = 0, n;
+
+	/* single-threaded basics */
+	printf("Validating single-threaded operation...\n");
+	ring = ringbuf_mp_new(4);
+	assert(ring->size == 4);
+	assert(ringbuf_mp_get(ring) == NULL);
+
+	assert(ringbuf_mp_put(ring, (void *)1));
+	assert(ringbuf_mp_put(ring, (void *)2));
+	assert(ringbuf_mp_put(ring, (void *)3));
+	assert(ringbuf_mp_put(ring, (void *)4));
+	/* full */
+	assert(!ringbuf_mp_put(ring, (void *)5));
+
+	assert(ringbuf_mp_get(ring) == (void *)1);
+	assert(ringbuf_mp_get(ring) == (void *)2);
+
+	/* partial batch put into the two freed slots */
+	items[0] = (void *)5;
+	items[1] = (void *)6;
+	items[2] = (void *)7;
+	assert(ringbuf_mp_put_batch(ring, items, 3) == 2);
+
+	assert(ringbuf_mp_get_batch(ring, items, 32) == 4);
+	assert(items[0] == (void *)3);
+	assert(items[1] == (void *)4);
+	assert(items[2] == (void *)5);
+	assert(items[3] == (void *)6);
+	assert(ringbuf_mp_get(ring) == NULL);
+	ringbuf_mp_del(ring);
+
+	/* hammer it from several pthreads; the consumer checks that each
+	 * producer's items arrive complete and in order */
+	printf("Validating multi-producer operation...\n");
+	ring = ringbuf_mp_new(1024);
+
+	for (uintptr_t i = 0; i < NPRODUCERS; i++)
+		pthread_create(&threads[i], NULL, producer, (void *)i);
+
+	while (total < (size_t)NPRODUCERS * NITEMS) {
+		n = ringbuf_mp_get_batch(ring, items, array_size(items));
+		for (size_t i = 0; i < n; i++) {
+			uintptr_t id = (uintptr_t)items[i] >> 28;
+			uintptr_t seq = (uintptr_t)items[i] & 0xfffffff;
+
+			assert(id < NPRODUCERS);
+			assert(seq == last_seen[id] + 1);
+			last_seen[id] = seq;
+		}
+		total += n;
+	}
+
+	for (size_t i = 0; i < NPRODUCERS; i++)
+		pthread_join(threads[i], NULL);
+
+	assert(ringbuf_mp_get(ring) == NULL);
+	for (size_t i = 0; i < NPRODUCERS; i++)
+		assert(last_seen[i] == NITEMS);
+
+	ringbuf_mp_del(ring);
+
+	printf("Done.\n");
+	return 0;
+}
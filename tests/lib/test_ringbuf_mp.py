@@ -0,0 +1,6 @@
+import frrtest
+
+class TestRingbufMp(frrtest.TestMultiOut):
+    program = './test_ringbuf_mp'
+
+TestRingbufMp.exit_cleanly()
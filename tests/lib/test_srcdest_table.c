@@ -25,6 +25,7 @@
 
 #include "hash.h"
 #include "memory.h"
+#include "monotime.h"
 #include "prefix.h"
 #include "prng.h"
 #include "srcdest_table.h"
@@ -52,6 +53,8 @@ struct srcdest_rnode {
 	ROUTE_NODE_FIELDS;
 
 	struct route_table *src_table;
+
+	struct route_node *src_inline[SRCDEST_SRC_INLINE];
 };
 
 struct test_state {
@@ -434,9 +437,111 @@ static void run_prng_test(void)
 	test_state_free(test);
 }
 
+/* ----- benchmark: exercise the table at SADR edge scale ----- */
+
+#define BENCH_LOOKUP_ROUNDS 5
+
+static void bench_dst_prefix(unsigned int i, struct prefix_ipv6 *p)
+{
+	memset(p, 0, sizeof(*p));
+	p->family = AF_INET6;
+	p->prefixlen = 64;
+	p->prefix.s6_addr[0] = 0x20;
+	p->prefix.s6_addr[1] = 0x01;
+	p->prefix.s6_addr[2] = 0x0d;
+	p->prefix.s6_addr[3] = 0xb8;
+	p->prefix.s6_addr[4] = (i >> 8) & 0xff;
+	p->prefix.s6_addr[5] = i & 0xff;
+}
+
+static void bench_src_prefix(unsigned int j, struct prefix_ipv6 *p)
+{
+	memset(p, 0, sizeof(*p));
+	p->family = AF_INET6;
+	p->prefixlen = 64;
+	p->prefix.s6_addr[0] = 0xfd;
+	p->prefix.s6_addr[1] = 0x00;
+	p->prefix.s6_addr[6] = (j >> 8) & 0xff;
+	p->prefix.s6_addr[7] = j & 0xff;
+}
+
+static long elapsed_msec(struct timeval *start, struct timeval *stop)
+{
+	return 1000 * (stop->tv_sec - start->tv_sec)
+	       + (stop->tv_usec - start->tv_usec) / 1000;
+}
+
+static void run_benchmark(unsigned int ndsts, unsigned int nsrcs)
+{
+	struct route_table *table = srcdest_table_init();
+	struct timeval tv_start, tv_add, tv_lookup, tv_del;
+	struct prefix_ipv6 dst_p, src_p;
+	struct route_node *rn;
+	unsigned int i, j, round;
+
+	monotime(&tv_start);
+
+	for (i = 0; i < ndsts; i++) {
+		bench_dst_prefix(i, &dst_p);
+		for (j = 0; j < nsrcs; j++) {
+			bench_src_prefix(j, &src_p);
+			rn = srcdest_rnode_get(table, (struct prefix *)&dst_p,
+					       &src_p);
+			assert(rn);
+			/* keep the lock as the route's reference */
+			rn->info = (void *)0xdeadbeef;
+		}
+	}
+
+	monotime(&tv_add);
+
+	for (round = 0; round < BENCH_LOOKUP_ROUNDS; round++)
+		for (i = 0; i < ndsts; i++) {
+			bench_dst_prefix(i, &dst_p);
+			for (j = 0; j < nsrcs; j++) {
+				bench_src_prefix(j, &src_p);
+				rn = srcdest_rnode_lookup(
+					table, (struct prefix *)&dst_p, &src_p);
+				assert(rn && rn->info == (void *)0xdeadbeef);
+				route_unlock_node(rn);
+			}
+		}
+
+	monotime(&tv_lookup);
+
+	for (i = 0; i < ndsts; i++) {
+		bench_dst_prefix(i, &dst_p);
+		for (j = 0; j < nsrcs; j++) {
+			bench_src_prefix(j, &src_p);
+			rn = srcdest_rnode_lookup(table, (struct prefix *)&dst_p,
+						  &src_p);
+			assert(rn);
+			rn->info = NULL;
+			route_unlock_node(rn);
+			route_unlock_node(rn);
+		}
+	}
+
+	monotime(&tv_del);
+
+	route_table_finish(table);
+
+	printf("%u dests x %u srcs: add %ld ms, %u lookups %ld ms, delete %ld ms\n",
+	       ndsts, nsrcs, elapsed_msec(&tv_start, &tv_add),
+	       BENCH_LOOKUP_ROUNDS * ndsts * nsrcs,
+	       elapsed_msec(&tv_add, &tv_lookup),
+	       elapsed_msec(&tv_lookup, &tv_del));
+}
+
 int main(int argc, char *argv[])
 {
 	run_prng_test();
 	printf("PRNG Test successful.\n");
+
+	/* 80k routes either way: few sources per dest (inline cache hits)
+	 * versus many sources per dest (cache overflows to src_table) */
+	run_benchmark(20000, 4);
+	run_benchmark(5000, 16);
+	printf("Benchmark successful.\n");
 	return 0;
 }
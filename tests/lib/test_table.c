@@ -492,6 +492,162 @@ static void test_iter_pause(void)
 	route_table_finish(table);
 }
 
+/*
+ * dindex_rand
+ *
+ * Cheap deterministic pseudo-random source for the direct index test.
+ */
+static uint32_t dindex_rand_state = 0x12345678;
+
+static uint32_t dindex_rand(void)
+{
+	dindex_rand_state = dindex_rand_state * 1103515245 + 12345;
+	return dindex_rand_state >> 8;
+}
+
+/*
+ * dindex_add_prefix
+ *
+ * Like add_node(), but takes a parsed prefix. Returns NULL if the
+ * prefix was already present.
+ */
+static struct route_node *dindex_add_prefix(struct route_table *table,
+					    struct prefix_ipv4 *p)
+{
+	char buf[PREFIX2STR_BUFFER];
+	test_node_t *node;
+	struct route_node *rn;
+
+	rn = route_node_get(table, (struct prefix *)p);
+	if (rn->info) {
+		route_unlock_node(rn);
+		return NULL;
+	}
+
+	node = malloc(sizeof(test_node_t));
+	assert(node);
+	prefix2str((struct prefix *)p, buf, sizeof(buf));
+	node->prefix_str = strdup(buf);
+	assert(node->prefix_str);
+	rn->info = node;
+	return rn;
+}
+
+/*
+ * verify_match_parity
+ *
+ * Assert that an LPM lookup returns the same prefix from both tables.
+ * The tables are expected to hold identical prefix sets; one of them
+ * has the direct index enabled.
+ */
+static void verify_match_parity(struct route_table *plain,
+				struct route_table *indexed, struct prefix *p)
+{
+	struct route_node *rn1, *rn2;
+
+	rn1 = route_node_match(plain, p);
+	rn2 = route_node_match(indexed, p);
+
+	assert((rn1 == NULL) == (rn2 == NULL));
+	if (rn1) {
+		assert(prefix_same(&rn1->p, &rn2->p));
+		route_unlock_node(rn1);
+		route_unlock_node(rn2);
+	}
+}
+
+/*
+ * test_dindex_match
+ *
+ * Populate a plain table and a direct-indexed table with the same
+ * pseudo-random prefixes and verify that route_node_match() agrees on
+ * both, across inserts and deletes.
+ */
+static void test_dindex_match(void)
+{
+	struct route_table *plain, *indexed;
+	static struct prefix_ipv4 prefixes[2000];
+	struct prefix_ipv4 q;
+	int num_prefixes = 0;
+	int i;
+
+	printf("\n\nTesting direct-indexed route_node_match()\n");
+
+	plain = route_table_init();
+	indexed = route_table_init();
+
+	/* half the prefixes go in before the index is built ... */
+	for (i = 0; i < 2000; i++) {
+		struct prefix_ipv4 p;
+
+		memset(&p, 0, sizeof(p));
+		p.family = AF_INET;
+		/* /8 .. /32, crossing the /16 stride both ways */
+		p.prefixlen = 8 + dindex_rand() % 25;
+		p.prefix.s_addr =
+			htonl((10 << 24) | (dindex_rand() & 0x00ffffff));
+		apply_mask_ipv4(&p);
+
+		if (!dindex_add_prefix(plain, &p))
+			continue;
+		assert(dindex_add_prefix(indexed, &p));
+		prefixes[num_prefixes++] = p;
+
+		if (i == 1000)
+			route_table_use_dindex(indexed);
+	}
+
+	/* ... and the other half is maintained incrementally */
+	for (i = 0; i < 10000; i++) {
+		memset(&q, 0, sizeof(q));
+		q.family = AF_INET;
+		q.prefixlen = IPV4_MAX_PREFIXLEN;
+		/* mostly hits in 10/8, some guaranteed misses in 11/8 */
+		q.prefix.s_addr = htonl((((i % 10) ? 10 : 11) << 24)
+					| (dindex_rand() & 0x00ffffff));
+		verify_match_parity(plain, indexed, (struct prefix *)&q);
+
+		/* non-host queries, including the short fallback path */
+		q.prefixlen = 8 + dindex_rand() % 25;
+		apply_mask_ipv4(&q);
+		verify_match_parity(plain, indexed, (struct prefix *)&q);
+	}
+
+	/* delete every other prefix and check parity again */
+	for (i = 0; i < num_prefixes; i += 2) {
+		struct route_table *tables[2] = {plain, indexed};
+
+		for (int t = 0; t < 2; t++) {
+			struct route_node *rn;
+			test_node_t *node;
+
+			rn = route_node_lookup(tables[t],
+					       (struct prefix *)&prefixes[i]);
+			assert(rn && rn->info);
+			node = rn->info;
+			rn->info = NULL;
+			free(node->prefix_str);
+			free(node);
+			route_unlock_node(rn); /* lookup */
+			route_unlock_node(rn); /* original get */
+		}
+	}
+
+	for (i = 0; i < 10000; i++) {
+		memset(&q, 0, sizeof(q));
+		q.family = AF_INET;
+		q.prefixlen = IPV4_MAX_PREFIXLEN;
+		q.prefix.s_addr =
+			htonl((10 << 24) | (dindex_rand() & 0x00ffffff));
+		verify_match_parity(plain, indexed, (struct prefix *)&q);
+	}
+
+	clear_table(plain);
+	clear_table(indexed);
+	route_table_finish(plain);
+	route_table_finish(indexed);
+}
+
 /*
  * run_tests
  */
@@ -500,6 +656,7 @@ static void run_tests(void)
 	test_prefix_iter_cmp();
 	test_get_next();
 	test_iter_pause();
+	test_dindex_match();
 }
 
 /*
@@ -0,0 +1,215 @@
+/*
+ * Test program for the hierarchical timing-wheel timer backend: verify
+ * that timers fire in tick order, that same-tick timers fire in the
+ * order they were scheduled, and that cancellation works.
+ *
+ * Derived from test_timer_correctness.c; the wheel trades microsecond
+ * ordering for O(1) insert/cancel, so expiry times are compared at the
+ * wheel's millisecond tick granularity here.
+ *
+ * Copyright (C) 2013 by Open Source Routing.
+ * Copyright (C) 2013 by Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This file is part of Quagga
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "memory.h"
+#include "prng.h"
+#include "thread.h"
+
+#define SCHEDULE_TIMERS 800
+#define REMOVE_TIMERS   200
+
+#define TIMESTR_LEN strlen("0123456789abcdef.9999")
+
+struct thread_master *master;
+
+static size_t log_buf_len;
+static size_t log_buf_pos;
+static char *log_buf;
+
+static size_t expected_buf_len;
+static size_t expected_buf_pos;
+static char *expected_buf;
+
+static struct prng *prng;
+
+static struct thread **timers;
+
+static int timers_pending;
+
+struct tick_key {
+	uint64_t tick; /* expiry, rounded up to the wheel tick */
+	int seq;       /* scheduling order, tiebreaker within a tick */
+};
+
+static struct tick_key *keys;
+
+static void terminate_test(void)
+{
+	int exit_code;
+
+	if (strcmp(log_buf, expected_buf)) {
+		fprintf(stderr,
+			"Expected output and received output differ.\n");
+		fprintf(stderr, "---Expected output: ---\n%s", expected_buf);
+		fprintf(stderr, "---Actual output: ---\n%s", log_buf);
+		exit_code = 1;
+	} else {
+		printf("Expected output and actual output match.\n");
+		exit_code = 0;
+	}
+
+	thread_master_free(master);
+	XFREE(MTYPE_TMP, log_buf);
+	XFREE(MTYPE_TMP, expected_buf);
+	prng_free(prng);
+	XFREE(MTYPE_TMP, timers);
+	XFREE(MTYPE_TMP, keys);
+
+	exit(exit_code);
+}
+
+static int timer_func(struct thread *thread)
+{
+	int rv;
+
+	rv = snprintf(log_buf + log_buf_pos, log_buf_len - log_buf_pos, "%s\n",
+		      (char *)thread->arg);
+	assert(rv >= 0);
+	log_buf_pos += rv;
+	assert(log_buf_pos < log_buf_len);
+	XFREE(MTYPE_TMP, thread->arg);
+
+	timers_pending--;
+	if (!timers_pending)
+		terminate_test();
+
+	return 0;
+}
+
+/* Round a timer's absolute expiry up to the wheel's 1ms tick, the same
+ * way the wheel backend does when slotting it. */
+static uint64_t timer_tick(const struct timeval *tv)
+{
+	uint64_t tick;
+
+	tick = (uint64_t)tv->tv_sec * 1000 + (uint64_t)tv->tv_usec / 1000;
+	if (tv->tv_usec % 1000)
+		tick++;
+	return tick;
+}
+
+static int cmp_tick_key(const void *a, const void *b)
+{
+	const struct tick_key *ka = a;
+	const struct tick_key *kb = b;
+
+	if (ka->tick < kb->tick)
+		return -1;
+	if (ka->tick > kb->tick)
+		return 1;
+	return ka->seq - kb->seq;
+}
+
+int main(int argc, char **argv)
+{
+	int i, j;
+	struct thread t;
+
+	master = thread_master_create(NULL);
+	thread_master_use_timer_wheel(master);
+
+	log_buf_len = SCHEDULE_TIMERS * (TIMESTR_LEN + 1) + 1;
+	log_buf_pos = 0;
+	log_buf = XMALLOC(MTYPE_TMP, log_buf_len);
+
+	expected_buf_len = SCHEDULE_TIMERS * (TIMESTR_LEN + 1) + 1;
+	expected_buf_pos = 0;
+	expected_buf = XMALLOC(MTYPE_TMP, expected_buf_len);
+
+	prng = prng_new(0);
+
+	timers = XMALLOC(MTYPE_TMP, SCHEDULE_TIMERS * sizeof(*timers));
+	keys = XMALLOC(MTYPE_TMP, SCHEDULE_TIMERS * sizeof(*keys));
+
+	for (i = 0; i < SCHEDULE_TIMERS; i++) {
+		long interval_msec;
+		int ret;
+		char *arg;
+
+		/* Schedule timers to expire in 1..5 seconds; a timer within
+		 * the wheel's current tick would be pushed into the next
+		 * slot, which the expected-output sort below cannot model. */
+		interval_msec = 1 + prng_rand(prng) % 4999;
+		arg = XMALLOC(MTYPE_TMP, TIMESTR_LEN + 1);
+		timers[i] = NULL;
+		thread_add_timer_msec(master, timer_func, arg, interval_msec,
+				      &timers[i]);
+		keys[i].tick = timer_tick(&timers[i]->u.sands);
+		keys[i].seq = i;
+		ret = snprintf(arg, TIMESTR_LEN + 1, "%016llx.%04d",
+			       (unsigned long long)keys[i].tick, i);
+		assert(ret > 0);
+		assert((size_t)ret < TIMESTR_LEN + 1);
+		timers_pending++;
+	}
+
+	for (i = 0; i < REMOVE_TIMERS; i++) {
+		int index;
+
+		index = prng_rand(prng) % SCHEDULE_TIMERS;
+		if (!timers[index])
+			continue;
+
+		XFREE(MTYPE_TMP, timers[index]->arg);
+		thread_cancel(timers[index]);
+		timers[index] = NULL;
+		timers_pending--;
+	}
+
+	/* Same-tick timers share a wheel slot and fire in scheduling order,
+	 * so sorting by (tick, seq) yields the expected firing order. */
+	j = 0;
+	for (i = 0; i < SCHEDULE_TIMERS; i++) {
+		if (!timers[i])
+			continue;
+		keys[j++] = keys[i];
+	}
+	qsort(keys, j, sizeof(*keys), cmp_tick_key);
+	for (i = 0; i < j; i++) {
+		int ret;
+
+		ret = snprintf(expected_buf + expected_buf_pos,
+			       expected_buf_len - expected_buf_pos,
+			       "%016llx.%04d\n",
+			       (unsigned long long)keys[i].tick, keys[i].seq);
+		assert(ret > 0);
+		expected_buf_pos += ret;
+		assert(expected_buf_pos < expected_buf_len);
+	}
+
+	while (thread_fetch(master, &t))
+		thread_call(&t);
+
+	return 0;
+}
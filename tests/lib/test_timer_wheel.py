@@ -0,0 +1,6 @@
+import frrtest
+
+class TestTimerWheel(frrtest.TestMultiOut):
+    program = './test_timer_wheel'
+
+TestTimerWheel.onesimple('Expected output and actual output match.')
@@ -157,36 +157,21 @@ static void vclient_close(struct vtysh_client *vclient)
 }
 
 /*
- * Send a CLI command to a client and read the response.
+ * Send a CLI command to a client, without waiting for the response.
  *
- * Output will be printed to vty->of. If you want to suppress output, set that
- * to NULL.
+ * The reply must be collected with vtysh_client_receive() before anything
+ * else is sent on the same socket.  On failure the connection is closed and
+ * marked for reconnect; the client is then skipped by the receive step.
  *
  * vclient
  *    the client to send the command to
  *
  * line
  *    the command to send
- *
- * callback
- *    if non-null, this will be called with each line of output received from
- *    the client passed in the second parameter
- *
- * cbarg
- *    optional first argument to pass to callback
- *
- * Returns:
- *    a status code
  */
-static int vtysh_client_run(struct vtysh_client *vclient, const char *line,
-			    void (*callback)(void *, const char *), void *cbarg)
+static void vtysh_client_send(struct vtysh_client *vclient, const char *line)
 {
 	int ret;
-	char stackbuf[4096];
-	char *buf = stackbuf;
-	size_t bufsz = sizeof(stackbuf);
-	char *bufvalid, *end = NULL;
-	char terminator[3] = {0, 0, 0};
 
 	/* vclinet was previously active, try to reconnect */
 	if (vclient->fd == VTYSH_WAS_ACTIVE) {
@@ -196,7 +181,7 @@ static int vtysh_client_run(struct vtysh_client *vclient, const char *line,
 	}
 
 	if (vclient->fd < 0)
-		return CMD_SUCCESS;
+		return;
 
 	ret = write(vclient->fd, line, strlen(line) + 1);
 	if (ret <= 0) {
@@ -210,6 +195,44 @@ static int vtysh_client_run(struct vtysh_client *vclient, const char *line,
 		if (ret <= 0)
 			goto out_err;
 	}
+	return;
+
+out_err:
+	vclient_close(vclient);
+}
+
+/*
+ * Read the response to a command previously passed to vtysh_client_send().
+ *
+ * Output will be printed to vty->of. If you want to suppress output, set that
+ * to NULL.
+ *
+ * vclient
+ *    the client to read the response from
+ *
+ * callback
+ *    if non-null, this will be called with each line of output received from
+ *    the client passed in the second parameter
+ *
+ * cbarg
+ *    optional first argument to pass to callback
+ *
+ * Returns:
+ *    a status code
+ */
+static int vtysh_client_receive(struct vtysh_client *vclient,
+				void (*callback)(void *, const char *),
+				void *cbarg)
+{
+	int ret;
+	char stackbuf[4096];
+	char *buf = stackbuf;
+	size_t bufsz = sizeof(stackbuf);
+	char *bufvalid, *end = NULL;
+	char terminator[3] = {0, 0, 0};
+
+	if (vclient->fd < 0)
+		return CMD_SUCCESS;
 
 	bufvalid = buf;
 	do {
@@ -343,6 +366,18 @@ out:
 	return ret;
 }
 
+/*
+ * Send a CLI command to a client and read the response.  See
+ * vtysh_client_send() and vtysh_client_receive() for the parameters.
+ */
+static int vtysh_client_run(struct vtysh_client *vclient, const char *line,
+			    void (*callback)(void *, const char *), void *cbarg)
+{
+	vtysh_client_send(vclient, line);
+
+	return vtysh_client_receive(vclient, callback, cbarg);
+}
+
 static int vtysh_client_run_all(struct vtysh_client *head_client,
 				const char *line, int continue_on_err,
 				void (*callback)(void *, const char *),
@@ -420,6 +455,41 @@ static void vtysh_client_config(struct vtysh_client *head_client, char *line)
 	vty->of = vty->of_saved;
 }
 
+/*
+ * Retrieve running config from all daemons at once.  The dump command is
+ * sent to every daemon before any response is read, so the daemons build
+ * their configs concurrently instead of one after another; the responses
+ * are then collected in daemon order, which makes the parsed result
+ * identical to a serial walk of the daemon list.
+ */
+static void vtysh_client_config_all(char *line)
+{
+	struct vtysh_client *client;
+	unsigned int i;
+
+	for (i = 0; i < array_size(vtysh_client); i++) {
+		/* Same watchfrr special case as vtysh_client_config. */
+		if (vtysh_client[i].flag == VTYSH_WATCHFRR)
+			continue;
+
+		for (client = &vtysh_client[i]; client; client = client->next)
+			vtysh_client_send(client, line);
+	}
+
+	/* suppress output to user */
+	vty->of_saved = vty->of;
+	vty->of = NULL;
+	for (i = 0; i < array_size(vtysh_client); i++) {
+		if (vtysh_client[i].flag == VTYSH_WATCHFRR)
+			continue;
+
+		for (client = &vtysh_client[i]; client; client = client->next)
+			vtysh_client_receive(client, vtysh_config_parse_line,
+					     NULL);
+	}
+	vty->of = vty->of_saved;
+}
+
 /* Command execution over the vty interface. */
 static int vtysh_execute_func(const char *line, int pager)
 {
@@ -2641,10 +2711,12 @@ DEFUN (vtysh_write_terminal,
 	vty_out(vty, "\nCurrent configuration:\n");
 	vty_out(vty, "!\n");
 
-	for (i = 0; i < array_size(vtysh_client); i++)
-		if ((argc < 3)
-		    || (strmatch(vtysh_client[i].name, argv[2]->text)))
-			vtysh_client_config(&vtysh_client[i], line);
+	if (argc < 3)
+		vtysh_client_config_all(line);
+	else
+		for (i = 0; i < array_size(vtysh_client); i++)
+			if (strmatch(vtysh_client[i].name, argv[2]->text))
+				vtysh_client_config(&vtysh_client[i], line);
 
 	/* Integrate vtysh specific configuration. */
 	vty_open_pager(vty);
@@ -2718,7 +2790,6 @@ static void backup_config_file(const char *fbackup)
 
 int vtysh_write_config_integrated(void)
 {
-	unsigned int i;
 	char line[] = "do write terminal\n";
 	FILE *fp;
 	int fd;
@@ -2745,8 +2816,7 @@ int vtysh_write_config_integrated(void)
 	}
 	fd = fileno(fp);
 
-	for (i = 0; i < array_size(vtysh_client); i++)
-		vtysh_client_config(&vtysh_client[i], line);
+	vtysh_client_config_all(line);
 
 	vtysh_config_write();
 	vty->of_saved = vty->of;
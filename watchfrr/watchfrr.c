@@ -148,6 +148,20 @@ static const char *state_str[] = {
 	"Init", "Down", "Connecting", "Up", "Unresponsive",
 };
 
+/* Echo round-trip times are slotted into coarse latency buckets for the
+   vty status report; the last bucket catches everything slower. */
+#define PROBE_BUCKETS 6
+static const long probe_bucket_msec[PROBE_BUCKETS - 1] = {10, 100, 500, 1000,
+							  5000};
+static const char *probe_bucket_str[PROBE_BUCKETS] = {
+	"<10ms", "<100ms", "<500ms", "<1s", "<5s", ">=5s",
+};
+
+/* Number of consecutive slow (but answered) echoes after which a daemon
+   is treated as hung, instead of waiting out the full timeout on every
+   probe cycle. */
+#define SLOW_PROBE_RUN 3
+
 struct daemon {
 	const char *name;
 	daemon_state_t state;
@@ -159,6 +173,11 @@ struct daemon {
 	struct thread *t_write;
 	struct daemon *next;
 	struct restart_info restart;
+
+	/* echo round-trip accounting, see daemon_record_probe() */
+	unsigned int probe_hist[PROBE_BUCKETS];
+	struct timeval probe_max;
+	unsigned int probe_slow_run;
 };
 
 #define OPTION_MINRESTART 2000
@@ -564,6 +583,28 @@ static void daemon_down(struct daemon *dmn, const char *why)
 	phase_check();
 }
 
+static void daemon_record_probe(struct daemon *dmn, struct timeval *delay)
+{
+	long msec = delay->tv_sec * 1000 + delay->tv_usec / 1000;
+	unsigned int i;
+
+	for (i = 0; i < PROBE_BUCKETS - 1; i++)
+		if (msec < probe_bucket_msec[i])
+			break;
+	dmn->probe_hist[i]++;
+
+	if (timercmp(delay, &dmn->probe_max, >))
+		dmn->probe_max = *delay;
+
+	/* "Slow" is half the unresponsiveness timeout: well beyond any
+	   healthy response time, but reached several probe periods before
+	   wakeup_no_answer() would fire. */
+	if (delay->tv_sec >= (gs.timeout + 1) / 2)
+		dmn->probe_slow_run++;
+	else
+		dmn->probe_slow_run = 0;
+}
+
 static int handle_read(struct thread *t_read)
 {
 	struct daemon *dmn = THREAD_ARG(t_read);
@@ -614,8 +655,9 @@ static int handle_read(struct thread *t_read)
 
 	time_elapsed(&delay, &dmn->echo_sent);
 	dmn->echo_sent.tv_sec = 0;
+	daemon_record_probe(dmn, &delay);
 	if (dmn->state == DAEMON_UNRESPONSIVE) {
-		if (delay.tv_sec < gs.timeout) {
+		if (delay.tv_sec < gs.timeout && !dmn->probe_slow_run) {
 			dmn->state = DAEMON_UP;
 			zlog_warn(
 				"%s state -> up : echo response received after %ld.%06ld "
@@ -632,6 +674,18 @@ static int handle_read(struct thread *t_read)
 		zlog_debug("%s: echo response received after %ld.%06ld seconds",
 			   dmn->name, (long)delay.tv_sec, (long)delay.tv_usec);
 
+	/* A daemon that keeps answering, but pathologically late, is hung
+	   just the same; escalate without waiting for a ping to go entirely
+	   unanswered. */
+	if (dmn->state == DAEMON_UP && dmn->probe_slow_run >= SLOW_PROBE_RUN) {
+		dmn->state = DAEMON_UNRESPONSIVE;
+		flog_err(EC_WATCHFRR_CONNECTION,
+			 "%s state -> unresponsive : %u consecutive echo "
+			 "responses slower than %ld seconds",
+			 dmn->name, dmn->probe_slow_run, (gs.timeout + 1) / 2);
+		try_restart(dmn);
+	}
+
 	SET_READ_HANDLER(dmn);
 	if (dmn->t_wakeup)
 		thread_cancel(dmn->t_wakeup);
@@ -1004,6 +1058,7 @@ void watchfrr_status(struct vty *vty)
 {
 	struct daemon *dmn;
 	struct timeval delay;
+	unsigned int i, probes;
 
 	vty_out(vty, "watchfrr global phase: %s\n", phase_str[gs.phase]);
 	if (gs.restart.pid)
@@ -1022,6 +1077,19 @@ void watchfrr_status(struct vty *vty)
 				" (%lds backoff interval)\n",
 				dmn->restart.interval - delay.tv_sec,
 				dmn->restart.interval);
+
+		probes = 0;
+		for (i = 0; i < PROBE_BUCKETS; i++)
+			probes += dmn->probe_hist[i];
+		if (probes) {
+			vty_out(vty, "      echo rtt: %u probes, max %ld.%03lds,",
+				probes, (long)dmn->probe_max.tv_sec,
+				(long)dmn->probe_max.tv_usec / 1000);
+			for (i = 0; i < PROBE_BUCKETS; i++)
+				vty_out(vty, " %s:%u", probe_bucket_str[i],
+					dmn->probe_hist[i]);
+			vty_out(vty, "\n");
+		}
 	}
 }
 
@@ -62,6 +62,12 @@ DEFINE_HOOK(zebra_if_config_wr, (struct vty * vty, struct interface *ifp),
 
 
 static void if_down_del_nbr_connected(struct interface *ifp);
+static void if_down_apply(struct interface *ifp);
+
+/* Settle window for link event coalescing, in milliseconds.  Zero means
+ * transitions are applied immediately (historical behaviour).
+ */
+static uint32_t if_settle_time;
 
 static int if_zebra_speed_update(struct thread *thread)
 {
@@ -175,6 +181,8 @@ static int if_zebra_delete_hook(struct interface *ifp)
 
 		struct rtadvconf *rtadv;
 
+		rtadv_if_fini(ifp);
+
 		rtadv = &zebra_if->rtadv;
 		list_delete(&rtadv->AdvPrefixList);
 		list_delete(&rtadv->AdvRDNSSList);
@@ -182,6 +190,7 @@ static int if_zebra_delete_hook(struct interface *ifp)
 #endif /* HAVE_RTADV */
 
 		THREAD_OFF(zebra_if->speed_update);
+		THREAD_OFF(zebra_if->t_settle);
 
 		XFREE(MTYPE_ZINFO, zebra_if);
 	}
@@ -716,6 +725,16 @@ void if_delete_update(struct interface *ifp)
 	if (!CHECK_FLAG(ifp->status, ZEBRA_INTERFACE_ACTIVE))
 		return;
 
+	/* Flush a transition still held back by the settle window, so the
+	 * delete is processed against the state the clients last saw.
+	 */
+	zif = ifp->info;
+	if (zif && zif->t_settle) {
+		THREAD_OFF(zif->t_settle);
+		if (zif->settle_applied_up && !zif->settle_want_up)
+			if_down_apply(ifp);
+	}
+
 	/* Mark interface as inactive */
 	UNSET_FLAG(ifp->status, ZEBRA_INTERFACE_ACTIVE);
 
@@ -907,7 +926,7 @@ static void if_down_del_nbr_connected(struct interface *ifp)
 }
 
 /* Interface is up. */
-void if_up(struct interface *ifp)
+static void if_up_apply(struct interface *ifp)
 {
 	struct zebra_if *zif;
 	struct interface *link_if;
@@ -964,7 +983,7 @@ void if_up(struct interface *ifp)
 
 /* Interface goes down.  We have to manage different behavior of based
    OS. */
-void if_down(struct interface *ifp)
+static void if_down_apply(struct interface *ifp)
 {
 	struct zebra_if *zif;
 	struct interface *link_if;
@@ -1009,6 +1028,91 @@ void if_down(struct interface *ifp)
 	if_down_del_nbr_connected(ifp);
 }
 
+/* Settle timer expired - apply the final state of the burst, if it still
+ * differs from what was last signalled.  The timer is re-armed after a
+ * deferred transition so a link that keeps bouncing is rate-limited to
+ * one down/up cycle per window.
+ */
+static int if_settle_timer(struct thread *thread)
+{
+	struct interface *ifp = THREAD_ARG(thread);
+	struct zebra_if *zif = ifp->info;
+
+	if (zif->settle_want_up == zif->settle_applied_up)
+		return 0;
+
+	if (IS_ZEBRA_DEBUG_EVENT)
+		zlog_debug(
+			"%u: IF %s settle window closed, going %s (%u transitions absorbed)",
+			ifp->vrf_id, ifp->name,
+			zif->settle_want_up ? "up" : "down",
+			zif->settle_absorbed);
+
+	zif->settle_applied_up = zif->settle_want_up;
+	if (zif->settle_want_up)
+		if_up_apply(ifp);
+	else
+		if_down_apply(ifp);
+
+	thread_add_timer_msec(zrouter.master, if_settle_timer, ifp,
+			      if_settle_time, &zif->t_settle);
+	return 0;
+}
+
+/* Common entry point for link state transitions.  The first transition
+ * of a burst is applied at once and opens the settle window; anything
+ * arriving while the window is open only records the desired final state.
+ */
+static void if_state_transition(struct interface *ifp, bool up)
+{
+	struct zebra_if *zif = ifp->info;
+
+	if (!if_settle_time) {
+		if (up)
+			if_up_apply(ifp);
+		else
+			if_down_apply(ifp);
+		return;
+	}
+
+	zif->settle_want_up = up;
+
+	if (zif->t_settle) {
+		zif->settle_absorbed++;
+		return;
+	}
+
+	zif->settle_applied_up = up;
+	if (up)
+		if_up_apply(ifp);
+	else
+		if_down_apply(ifp);
+
+	thread_add_timer_msec(zrouter.master, if_settle_timer, ifp,
+			      if_settle_time, &zif->t_settle);
+}
+
+void if_up(struct interface *ifp)
+{
+	if_state_transition(ifp, true);
+}
+
+void if_down(struct interface *ifp)
+{
+	if_state_transition(ifp, false);
+}
+
+int if_settle_time_set(uint32_t msec)
+{
+	if_settle_time = msec;
+	return 0;
+}
+
+uint32_t if_settle_time_get(void)
+{
+	return if_settle_time;
+}
+
 void if_refresh(struct interface *ifp)
 {
 	if_get_flags(ifp);
@@ -1292,6 +1396,9 @@ static void if_dump_vty(struct vty *vty, struct interface *ifp)
 		zebra_if->up_last[0] ? zebra_if->up_last : "(never)");
 	vty_out(vty, "  Link downs: %5u    last: %s\n", zebra_if->down_count,
 		zebra_if->down_last[0] ? zebra_if->down_last : "(never)");
+	if (zebra_if->settle_absorbed)
+		vty_out(vty, "  Link transitions absorbed by settle window: %u\n",
+			zebra_if->settle_absorbed);
 
 	zebra_ptm_show_status(vty, ifp);
 
@@ -279,6 +279,16 @@ struct zebra_if {
 	unsigned int down_count;
 	char down_last[QUAGGA_TIMESTAMP_LEN];
 
+	/* Link event coalescing.  While the settle timer runs, further
+	 * up/down transitions are merely recorded and collapsed to the
+	 * final state when it fires, so a bouncing link costs at most
+	 * one down/up cycle per settle window.
+	 */
+	struct thread *t_settle;
+	bool settle_want_up;	/* state to apply when the timer fires */
+	bool settle_applied_up; /* state last handed to if_up()/if_down() */
+	unsigned int settle_absorbed; /* transitions swallowed by the window */
+
 #if defined(HAVE_RTADV)
 	struct rtadvconf rtadv;
 	unsigned int ra_sent, ra_rcvd;
@@ -406,6 +416,8 @@ extern void if_delete_update(struct interface *ifp);
 extern void if_add_update(struct interface *ifp);
 extern void if_up(struct interface *);
 extern void if_down(struct interface *);
+extern int if_settle_time_set(uint32_t msec);
+extern uint32_t if_settle_time_get(void);
 extern void if_refresh(struct interface *);
 extern void if_flags_update(struct interface *, uint64_t);
 extern int if_subnet_add(struct interface *, struct connected *);
@@ -42,6 +42,7 @@
 #include "vrf.h"
 #include "mpls.h"
 #include "lib_errors.h"
+#include "frr_pthread.h"
 
 //#include "zebra/zserv.h"
 #include "zebra/zebra_router.h"
@@ -55,6 +56,8 @@
 #include "zebra/rule_netlink.h"
 #include "zebra/zebra_errors.h"
 
+DEFINE_MTYPE_STATIC(ZEBRA, NL_BUF, "Netlink batch buffer")
+
 #ifndef SO_RCVBUFFORCE
 #define SO_RCVBUFFORCE  (33)
 #endif
@@ -137,6 +140,19 @@ extern uint32_t nl_rcvbufsize;
 
 extern struct zebra_privs_t zserv_privs;
 
+/* When startup dumps for multiple namespaces are being read by worker
+ * threads, only the recvmsg()/dump generation may proceed concurrently;
+ * the filter callbacks merge into shared zebra structures and must be
+ * serialized.
+ */
+static bool netlink_parallel_dump;
+static pthread_mutex_t netlink_dump_merge_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+void netlink_parallel_dump_set(bool on)
+{
+	netlink_parallel_dump = on;
+}
+
 
 int netlink_talk_filter(struct nlmsghdr *h, ns_id_t ns_id, int startup)
 {
@@ -200,6 +216,58 @@ static int netlink_recvbuf(struct nlsock *nl, uint32_t newsize)
 	return 0;
 }
 
+/* Receive-path telemetry, reported by "show zebra". */
+static struct netlink_recv_stats nl_recv_stats;
+
+void netlink_recv_stats_get(struct netlink_recv_stats *stats)
+{
+	*stats = nl_recv_stats;
+}
+
+/* Ceiling for adaptive receive buffer growth. */
+#define NL_RCVBUF_GROW_MAX (64 * 1024 * 1024)
+
+/* An ENOBUFS overrun means the socket buffer filled while we were busy
+ * parsing; double it (up to a cap) so the same burst fits next time.
+ */
+static void netlink_rcvbuf_grow(const struct nlsock *nl)
+{
+	uint32_t cursize, newsize;
+	socklen_t len = sizeof(cursize);
+	int ret;
+
+	if (getsockopt(nl->sock, SOL_SOCKET, SO_RCVBUF, &cursize, &len) < 0)
+		return;
+	if (cursize >= NL_RCVBUF_GROW_MAX)
+		return;
+
+	newsize = cursize * 2;
+	if (newsize > NL_RCVBUF_GROW_MAX)
+		newsize = NL_RCVBUF_GROW_MAX;
+
+	frr_elevate_privs(&zserv_privs) {
+		ret = setsockopt(nl->sock, SOL_SOCKET, SO_RCVBUFFORCE,
+				 &newsize, sizeof(newsize));
+	}
+	if (ret < 0)
+		ret = setsockopt(nl->sock, SOL_SOCKET, SO_RCVBUF, &newsize,
+				 sizeof(newsize));
+	if (ret < 0) {
+		flog_err_sys(EC_LIB_SOCKET,
+			     "Can't grow %s receive buffer size: %s", nl->name,
+			     safe_strerror(errno));
+		return;
+	}
+
+	len = sizeof(newsize);
+	if (getsockopt(nl->sock, SOL_SOCKET, SO_RCVBUF, &newsize, &len) < 0)
+		return;
+
+	nl_recv_stats.rcvbuf_grown = newsize;
+	zlog_info("%s: receive buffer grown %u -> %u after overrun", nl->name,
+		  cursize, newsize);
+}
+
 /* Make socket for Linux netlink interface. */
 static int netlink_socket(struct nlsock *nl, unsigned long groups,
 			  ns_id_t ns_id)
@@ -695,41 +763,76 @@ int netlink_parse_info(int (*filter)(struct nlmsghdr *, ns_id_t, int),
 		       const struct zebra_dplane_info *zns,
 		       int count, int startup)
 {
+	/* Ring of full-size receive slots; recvmmsg() drains the socket
+	 * into as many of them as it can ahead of parsing, so a burst is
+	 * pulled out of the kernel in one syscall instead of competing
+	 * with the parse work message by message.
+	 */
+	static char ring[NL_RCV_RING_SIZE][NL_RCV_PKT_BUF_SIZE];
 	int status;
 	int ret = 0;
 	int error;
 	int read_in = 0;
 
 	while (1) {
-		char buf[NL_RCV_PKT_BUF_SIZE];
-		struct iovec iov = {.iov_base = buf, .iov_len = sizeof buf};
-		struct sockaddr_nl snl;
-		struct msghdr msg = {.msg_name = (void *)&snl,
-				     .msg_namelen = sizeof snl,
-				     .msg_iov = &iov,
-				     .msg_iovlen = 1};
-		struct nlmsghdr *h;
+		struct mmsghdr mmsg[NL_RCV_RING_SIZE];
+		struct iovec iov[NL_RCV_RING_SIZE];
+		struct sockaddr_nl snl[NL_RCV_RING_SIZE];
+		unsigned int vlen, i;
+		int nrecv;
 
 		if (count && read_in >= count)
 			return 0;
 
+		memset(mmsg, 0, sizeof(mmsg));
+		vlen = NL_RCV_RING_SIZE;
+		if (count && (unsigned int)(count - read_in) < vlen)
+			vlen = count - read_in;
+		for (i = 0; i < vlen; i++) {
+			iov[i].iov_base = ring[i];
+			iov[i].iov_len = NL_RCV_PKT_BUF_SIZE;
+			mmsg[i].msg_hdr.msg_name = (void *)&snl[i];
+			mmsg[i].msg_hdr.msg_namelen = sizeof(snl[i]);
+			mmsg[i].msg_hdr.msg_iov = &iov[i];
+			mmsg[i].msg_hdr.msg_iovlen = 1;
+		}
+
 #if defined(HANDLE_NETLINK_FUZZING)
 		/* Check if reading and filename is set */
 		if (netlink_read && '\0' != netlink_fuzz_file[0]) {
 			zlog_debug("Reading netlink fuzz file");
-			status = netlink_read_file(buf, netlink_fuzz_file);
-			snl.nl_pid = 0;
+			nrecv = netlink_read_file(ring[0], netlink_fuzz_file);
+			if (nrecv > 0) {
+				mmsg[0].msg_len = nrecv;
+				mmsg[0].msg_hdr.msg_namelen = sizeof(snl[0]);
+				snl[0].nl_pid = 0;
+				nrecv = 1;
+			}
 		} else {
-			status = recvmsg(nl->sock, &msg, 0);
+			nrecv = recvmmsg(nl->sock, mmsg, vlen, 0, NULL);
 		}
 #else
-		status = recvmsg(nl->sock, &msg, 0);
+		nrecv = recvmmsg(nl->sock, mmsg, vlen, 0, NULL);
 #endif /* HANDLE_NETLINK_FUZZING */
-		if (status < 0) {
+		if (nrecv < 0) {
 			if (errno == EINTR)
 				continue;
 			if (errno == EWOULDBLOCK || errno == EAGAIN)
 				break;
+			if (errno == ENOBUFS) {
+				/* The kernel dropped messages on the floor;
+				 * whatever they announced is surfaced only
+				 * by the overrun counter.  Grow the buffer
+				 * so the next burst fits and keep going.
+				 */
+				nl_recv_stats.overruns++;
+				nl_recv_stats.last_overrun = monotime(NULL);
+				flog_err(EC_ZEBRA_RECVMSG_OVERRUN,
+					 "%s recvmsg overrun: %s", nl->name,
+					 safe_strerror(errno));
+				netlink_rcvbuf_grow(nl);
+				continue;
+			}
 			flog_err(EC_ZEBRA_RECVMSG_OVERRUN,
 				 "%s recvmsg overrun: %s", nl->name,
 				 safe_strerror(errno));
@@ -742,185 +845,206 @@ int netlink_parse_info(int (*filter)(struct nlmsghdr *, ns_id_t, int),
 			continue;
 		}
 
-		if (status == 0) {
+		if (nrecv == 0) {
 			flog_err_sys(EC_LIB_SOCKET, "%s EOF", nl->name);
 			return -1;
 		}
 
-		if (msg.msg_namelen != sizeof snl) {
-			flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
-				 "%s sender address length error: length %d",
-				 nl->name, msg.msg_namelen);
-			return -1;
-		}
+		nl_recv_stats.batches++;
+		nl_recv_stats.msgs += nrecv;
 
-		if (IS_ZEBRA_DEBUG_KERNEL_MSGDUMP_RECV) {
-			zlog_debug("%s: << netlink message dump [recv]",
-				   __func__);
-			zlog_hexdump(buf, status);
-		}
+		for (i = 0; i < (unsigned int)nrecv; i++) {
+			char *buf = ring[i];
+			struct nlmsghdr *h;
+
+			status = mmsg[i].msg_len;
+			if (status == 0) {
+				flog_err_sys(EC_LIB_SOCKET, "%s EOF",
+					     nl->name);
+				return -1;
+			}
+
+			if (mmsg[i].msg_hdr.msg_namelen != sizeof(snl[i])) {
+				flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
+					 "%s sender address length error: length %d",
+					 nl->name,
+					 mmsg[i].msg_hdr.msg_namelen);
+				return -1;
+			}
+
+			if (IS_ZEBRA_DEBUG_KERNEL_MSGDUMP_RECV) {
+				zlog_debug("%s: << netlink message dump [recv]",
+					   __func__);
+				zlog_hexdump(buf, status);
+			}
 
 #if defined(HANDLE_NETLINK_FUZZING)
-		if (!netlink_read) {
-			zlog_debug("Writing incoming netlink message");
-			netlink_write_incoming(buf, status,
-					       netlink_file_counter++);
-		}
+			if (!netlink_read) {
+				zlog_debug("Writing incoming netlink message");
+				netlink_write_incoming(buf, status,
+						       netlink_file_counter++);
+			}
 #endif /* HANDLE_NETLINK_FUZZING */
 
-		read_in++;
-		for (h = (struct nlmsghdr *)buf;
-		     (status >= 0 && NLMSG_OK(h, (unsigned int)status));
-		     h = NLMSG_NEXT(h, status)) {
-			/* Finish of reading. */
-			if (h->nlmsg_type == NLMSG_DONE)
-				return ret;
-
-			/* Error handling. */
-			if (h->nlmsg_type == NLMSG_ERROR) {
-				struct nlmsgerr *err =
-					(struct nlmsgerr *)NLMSG_DATA(h);
-				int errnum = err->error;
-				int msg_type = err->msg.nlmsg_type;
-
-				if (h->nlmsg_len
-				    < NLMSG_LENGTH(sizeof(struct nlmsgerr))) {
-					flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
-						 "%s error: message truncated",
-						 nl->name);
-					return -1;
-				}
+			read_in++;
+			for (h = (struct nlmsghdr *)buf;
+			     (status >= 0 && NLMSG_OK(h, (unsigned int)status));
+			     h = NLMSG_NEXT(h, status)) {
+				/* Finish of reading. */
+				if (h->nlmsg_type == NLMSG_DONE)
+					return ret;
+
+				/* Error handling. */
+				if (h->nlmsg_type == NLMSG_ERROR) {
+					struct nlmsgerr *err =
+						(struct nlmsgerr *)NLMSG_DATA(h);
+					int errnum = err->error;
+					int msg_type = err->msg.nlmsg_type;
+
+					if (h->nlmsg_len
+					    < NLMSG_LENGTH(sizeof(struct nlmsgerr))) {
+						flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
+							 "%s error: message truncated",
+							 nl->name);
+						return -1;
+					}
 
-				/*
-				 * Parse the extended information before
-				 * we actually handle it.
-				 * At this point in time we do not
-				 * do anything other than report the
-				 * issue.
-				 */
-				if (h->nlmsg_flags & NLM_F_ACK_TLVS)
-					netlink_parse_extended_ack(h);
-
-				/* If the error field is zero, then this is an
-				 * ACK */
-				if (err->error == 0) {
-					if (IS_ZEBRA_DEBUG_KERNEL) {
-						zlog_debug(
-							"%s: %s ACK: type=%s(%u), seq=%u, pid=%u",
-							__FUNCTION__, nl->name,
-							nl_msg_type_to_str(
-								err->msg.nlmsg_type),
-							err->msg.nlmsg_type,
-							err->msg.nlmsg_seq,
-							err->msg.nlmsg_pid);
+					/*
+					 * Parse the extended information before
+					 * we actually handle it.
+					 * At this point in time we do not
+					 * do anything other than report the
+					 * issue.
+					 */
+					if (h->nlmsg_flags & NLM_F_ACK_TLVS)
+						netlink_parse_extended_ack(h);
+
+					/* If the error field is zero, then this is an
+					 * ACK */
+					if (err->error == 0) {
+						if (IS_ZEBRA_DEBUG_KERNEL) {
+							zlog_debug(
+								"%s: %s ACK: type=%s(%u), seq=%u, pid=%u",
+								__FUNCTION__, nl->name,
+								nl_msg_type_to_str(
+									err->msg.nlmsg_type),
+								err->msg.nlmsg_type,
+								err->msg.nlmsg_seq,
+								err->msg.nlmsg_pid);
+						}
+
+						/* return if not a multipart message,
+						 * otherwise continue */
+						if (!(h->nlmsg_flags & NLM_F_MULTI))
+							return 0;
+						continue;
 					}
 
-					/* return if not a multipart message,
-					 * otherwise continue */
-					if (!(h->nlmsg_flags & NLM_F_MULTI))
+					/* Deal with errors that occur because of races
+					 * in link handling */
+					if (zns->is_cmd
+					    && ((msg_type == RTM_DELROUTE
+						 && (-errnum == ENODEV
+						     || -errnum == ESRCH))
+						|| (msg_type == RTM_NEWROUTE
+						    && (-errnum == ENETDOWN
+							|| -errnum == EEXIST)))) {
+						if (IS_ZEBRA_DEBUG_KERNEL)
+							zlog_debug(
+								"%s: error: %s type=%s(%u), seq=%u, pid=%u",
+								nl->name,
+								safe_strerror(-errnum),
+								nl_msg_type_to_str(
+									msg_type),
+								msg_type,
+								err->msg.nlmsg_seq,
+								err->msg.nlmsg_pid);
 						return 0;
-					continue;
-				}
-
-				/* Deal with errors that occur because of races
-				 * in link handling */
-				if (zns->is_cmd
-				    && ((msg_type == RTM_DELROUTE
-					 && (-errnum == ENODEV
-					     || -errnum == ESRCH))
-					|| (msg_type == RTM_NEWROUTE
-					    && (-errnum == ENETDOWN
-						|| -errnum == EEXIST)))) {
-					if (IS_ZEBRA_DEBUG_KERNEL)
-						zlog_debug(
-							"%s: error: %s type=%s(%u), seq=%u, pid=%u",
-							nl->name,
-							safe_strerror(-errnum),
-							nl_msg_type_to_str(
-								msg_type),
-							msg_type,
-							err->msg.nlmsg_seq,
-							err->msg.nlmsg_pid);
-					return 0;
-				}
+					}
 
-				/* We see RTM_DELNEIGH when shutting down an
-				 * interface with an IPv4
-				 * link-local.  The kernel should have already
-				 * deleted the neighbor
-				 * so do not log these as an error.
-				 */
-				if (msg_type == RTM_DELNEIGH
-				    || (zns->is_cmd && msg_type == RTM_NEWROUTE
-					&& (-errnum == ESRCH
-					    || -errnum == ENETUNREACH))) {
-					/* This is known to happen in some
-					 * situations, don't log
-					 * as error.
+					/* We see RTM_DELNEIGH when shutting down an
+					 * interface with an IPv4
+					 * link-local.  The kernel should have already
+					 * deleted the neighbor
+					 * so do not log these as an error.
 					 */
-					if (IS_ZEBRA_DEBUG_KERNEL)
-						zlog_debug(
+					if (msg_type == RTM_DELNEIGH
+					    || (zns->is_cmd && msg_type == RTM_NEWROUTE
+						&& (-errnum == ESRCH
+						    || -errnum == ENETUNREACH))) {
+						/* This is known to happen in some
+						 * situations, don't log
+						 * as error.
+						 */
+						if (IS_ZEBRA_DEBUG_KERNEL)
+							zlog_debug(
+								"%s error: %s, type=%s(%u), seq=%u, pid=%u",
+								nl->name,
+								safe_strerror(-errnum),
+								nl_msg_type_to_str(
+									msg_type),
+								msg_type,
+								err->msg.nlmsg_seq,
+								err->msg.nlmsg_pid);
+					} else
+						flog_err(
+							EC_ZEBRA_UNEXPECTED_MESSAGE,
 							"%s error: %s, type=%s(%u), seq=%u, pid=%u",
 							nl->name,
 							safe_strerror(-errnum),
-							nl_msg_type_to_str(
-								msg_type),
-							msg_type,
-							err->msg.nlmsg_seq,
+							nl_msg_type_to_str(msg_type),
+							msg_type, err->msg.nlmsg_seq,
 							err->msg.nlmsg_pid);
-				} else
-					flog_err(
-						EC_ZEBRA_UNEXPECTED_MESSAGE,
-						"%s error: %s, type=%s(%u), seq=%u, pid=%u",
+
+					return -1;
+				}
+
+				/* OK we got netlink message. */
+				if (IS_ZEBRA_DEBUG_KERNEL)
+					zlog_debug(
+						"netlink_parse_info: %s type %s(%u), len=%d, seq=%u, pid=%u",
 						nl->name,
-						safe_strerror(-errnum),
-						nl_msg_type_to_str(msg_type),
-						msg_type, err->msg.nlmsg_seq,
-						err->msg.nlmsg_pid);
+						nl_msg_type_to_str(h->nlmsg_type),
+						h->nlmsg_type, h->nlmsg_len,
+						h->nlmsg_seq, h->nlmsg_pid);
 
-				return -1;
-			}
 
-			/* OK we got netlink message. */
-			if (IS_ZEBRA_DEBUG_KERNEL)
-				zlog_debug(
-					"netlink_parse_info: %s type %s(%u), len=%d, seq=%u, pid=%u",
-					nl->name,
-					nl_msg_type_to_str(h->nlmsg_type),
-					h->nlmsg_type, h->nlmsg_len,
-					h->nlmsg_seq, h->nlmsg_pid);
+				/*
+				 * Ignore messages that maybe sent from
+				 * other actors besides the kernel
+				 */
+				if (snl[i].nl_pid != 0) {
+					zlog_debug("Ignoring message from pid %u",
+						   snl[i].nl_pid);
+					continue;
+				}
 
+				if (netlink_parallel_dump) {
+					pthread_mutex_lock(&netlink_dump_merge_mtx);
+					error = (*filter)(h, zns->ns_id, startup);
+					pthread_mutex_unlock(&netlink_dump_merge_mtx);
+				} else
+					error = (*filter)(h, zns->ns_id, startup);
+				if (error < 0) {
+					zlog_debug("%s filter function error",
+						   nl->name);
+					ret = error;
+				}
+			}
 
-			/*
-			 * Ignore messages that maybe sent from
-			 * other actors besides the kernel
-			 */
-			if (snl.nl_pid != 0) {
-				zlog_debug("Ignoring message from pid %u",
-					   snl.nl_pid);
+			/* After error care. */
+			if (mmsg[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
+					 "%s error: message truncated", nl->name);
 				continue;
 			}
-
-			error = (*filter)(h, zns->ns_id, startup);
-			if (error < 0) {
-				zlog_debug("%s filter function error",
-					   nl->name);
-				ret = error;
+			if (status) {
+				flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
+					 "%s error: data remnant size %d", nl->name,
+					 status);
+				return -1;
 			}
 		}
-
-		/* After error care. */
-		if (msg.msg_flags & MSG_TRUNC) {
-			flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
-				 "%s error: message truncated", nl->name);
-			continue;
-		}
-		if (status) {
-			flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
-				 "%s error: data remnant size %d", nl->name,
-				 status);
-			return -1;
-		}
 	}
 	return ret;
 }
@@ -996,6 +1120,152 @@ int netlink_talk_info(int (*filter)(struct nlmsghdr *, ns_id_t, int startup),
 	return netlink_parse_info(filter, nl, dp_info, 0, startup);
 }
 
+/* Default and max number of messages packed into one batched send */
+static _Atomic uint32_t nl_batch_limit = NL_BATCH_MAX_MSGS;
+
+uint32_t netlink_batch_get_limit(void)
+{
+	return atomic_load_explicit(&nl_batch_limit, memory_order_relaxed);
+}
+
+void netlink_batch_set_limit(uint32_t limit, bool set)
+{
+	if (!set || limit > NL_BATCH_MAX_MSGS)
+		limit = NL_BATCH_MAX_MSGS;
+	if (limit == 0)
+		limit = 1;
+
+	atomic_store_explicit(&nl_batch_limit, limit, memory_order_relaxed);
+}
+
+/*
+ * Begin a batch of outgoing netlink messages. Storage is allocated
+ * lazily on first add and reused across flushes of the same batch.
+ */
+void netlink_batch_begin(struct nl_batch *bth,
+			 int (*filter)(struct nlmsghdr *, ns_id_t, int startup),
+			 const struct zebra_dplane_info *dp_info, int startup)
+{
+	memset(bth, 0, sizeof(*bth));
+
+	bth->dp_info = *dp_info;
+	bth->filter = filter;
+	bth->startup = startup;
+
+	/* Stay elevated for the whole batch so the per-flush (and per-ACK
+	 * receive) elevations below are refcount bumps, not syscalls. */
+	frr_privs_batch_enter(&zserv_privs);
+}
+
+/*
+ * Pack one message into the batch, flushing first if the batch is full.
+ * The message is copied, so the caller's buffer may be reused.
+ */
+int netlink_batch_add_msg(struct nl_batch *bth, struct nlmsghdr *n)
+{
+	struct nlmsghdr *packed;
+	int ret = 0;
+
+	if (bth->buf == NULL) {
+		bth->bufsiz = (size_t)NL_BATCH_MAX_MSGS * NL_PKT_BUF_SIZE;
+		bth->buf = XMALLOC(MTYPE_NL_BUF, bth->bufsiz);
+	}
+
+	if (bth->count >= netlink_batch_get_limit()
+	    || bth->pos + n->nlmsg_len > bth->bufsiz)
+		ret = netlink_batch_flush(bth);
+
+	packed = (struct nlmsghdr *)((char *)bth->buf + bth->pos);
+	memcpy(packed, n, n->nlmsg_len);
+
+	packed->nlmsg_seq = bth->dp_info.nls.seq;
+	packed->nlmsg_pid = bth->dp_info.nls.snl.nl_pid;
+
+	bth->pos += NLMSG_ALIGN(n->nlmsg_len);
+	bth->count++;
+
+	return ret;
+}
+
+/*
+ * Send all packed messages with a single sendmsg() and consume one ACK
+ * per message. Returns 0 if every message was acked cleanly.
+ */
+int netlink_batch_flush(struct nl_batch *bth)
+{
+	struct sockaddr_nl snl;
+	struct iovec iov;
+	struct msghdr msg;
+	const struct nlsock *nl;
+	int status, save_errno = 0;
+	int ret = 0;
+	size_t i;
+
+	if (bth->count == 0)
+		return 0;
+
+	nl = &(bth->dp_info.nls);
+
+	memset(&snl, 0, sizeof(snl));
+	memset(&iov, 0, sizeof(iov));
+	memset(&msg, 0, sizeof(msg));
+
+	iov.iov_base = bth->buf;
+	iov.iov_len = bth->pos;
+	msg.msg_name = (void *)&snl;
+	msg.msg_namelen = sizeof(snl);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	snl.nl_family = AF_NETLINK;
+
+	if (IS_ZEBRA_DEBUG_KERNEL)
+		zlog_debug("%s: %s, %zu msgs, %zu bytes, seq=%u", __func__,
+			   nl->name, bth->count, bth->pos, nl->seq);
+
+	frr_elevate_privs(&zserv_privs) {
+		status = sendmsg(nl->sock, &msg, 0);
+		save_errno = errno;
+	}
+
+	if (status < 0) {
+		flog_err_sys(EC_LIB_SOCKET, "%s sendmsg() error: %s", __func__,
+			     safe_strerror(save_errno));
+		bth->pos = 0;
+		bth->count = 0;
+		return -1;
+	}
+
+	/* One ACK (or error) is expected per packed message */
+	for (i = 0; i < bth->count; i++) {
+		if (netlink_parse_info(bth->filter, nl, &bth->dp_info, 0,
+				       bth->startup) != 0)
+			ret = -1;
+	}
+
+	bth->pos = 0;
+	bth->count = 0;
+
+	return ret;
+}
+
+/*
+ * Flush any remaining messages and release the batch's storage.
+ */
+int netlink_batch_finish(struct nl_batch *bth)
+{
+	int ret;
+
+	ret = netlink_batch_flush(bth);
+
+	frr_privs_batch_exit(&zserv_privs);
+
+	XFREE(MTYPE_NL_BUF, bth->buf);
+	bth->bufsiz = 0;
+
+	return ret;
+}
+
 /*
  * Synchronous version of netlink_talk_info. Converts args to suit the
  * common version, which is suitable for both sync and async use.
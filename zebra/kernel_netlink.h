@@ -23,9 +23,25 @@
 
 #ifdef HAVE_NETLINK
 
+#include "zebra/zebra_dplane.h"
+
 #define NL_RCV_PKT_BUF_SIZE     32768
 #define NL_PKT_BUF_SIZE         8192
 
+/* Receive ring slots drained per recvmmsg() call */
+#define NL_RCV_RING_SIZE        8
+
+/* Receive-path telemetry, reported by "show zebra". */
+struct netlink_recv_stats {
+	uint64_t msgs;         /* datagrams drained */
+	uint64_t batches;      /* recvmmsg() calls that returned data */
+	uint64_t overruns;     /* ENOBUFS kernel drops observed */
+	time_t last_overrun;   /* monotime of the most recent overrun */
+	uint32_t rcvbuf_grown; /* adaptively grown SO_RCVBUF; 0 = untouched */
+};
+
+extern void netlink_recv_stats_get(struct netlink_recv_stats *stats);
+
 extern void netlink_parse_rtattr(struct rtattr **tb, int max,
 				 struct rtattr *rta, int len);
 extern void netlink_parse_rtattr_nested(struct rtattr **tb, int max,
@@ -51,6 +67,8 @@ extern const char *nl_rttype_to_str(uint8_t rttype);
 extern bool netlink_read;
 extern void netlink_read_init(const char *fname);
 #endif /* HANDLE_NETLINK_FUZZING */
+/* Serialize filter callbacks while startup dumps run on worker threads */
+extern void netlink_parallel_dump_set(bool on);
 extern int netlink_parse_info(int (*filter)(struct nlmsghdr *, ns_id_t, int),
 			      const struct nlsock *nl,
 			      const struct zebra_dplane_info *dp_info,
@@ -64,6 +82,40 @@ int netlink_talk_info(int (*filter)(struct nlmsghdr *, ns_id_t, int startup),
 		      struct nlmsghdr *n,
 		      const struct zebra_dplane_info *dp_info, int startup);
 
+/* Batching of outgoing netlink messages: many messages are packed into
+ * a single sendmsg() call and acknowledged in one ACK window, instead of
+ * paying a sendmsg+recvmsg round trip per message.
+ */
+#define NL_BATCH_MAX_MSGS 256
+
+struct nl_batch {
+	/* Packed message storage */
+	void *buf;
+	size_t bufsiz;
+	size_t pos;
+
+	/* Number of messages currently packed */
+	size_t count;
+
+	/* Snapshot of socket info used for the whole batch */
+	struct zebra_dplane_info dp_info;
+	int (*filter)(struct nlmsghdr *, ns_id_t, int startup);
+	int startup;
+};
+
+extern void netlink_batch_begin(struct nl_batch *bth,
+				int (*filter)(struct nlmsghdr *, ns_id_t,
+					      int startup),
+				const struct zebra_dplane_info *dp_info,
+				int startup);
+extern int netlink_batch_add_msg(struct nl_batch *bth, struct nlmsghdr *n);
+extern int netlink_batch_flush(struct nl_batch *bth);
+extern int netlink_batch_finish(struct nl_batch *bth);
+
+/* Runtime limit on the number of messages packed per batch */
+extern uint32_t netlink_batch_get_limit(void);
+extern void netlink_batch_set_limit(uint32_t limit, bool set);
+
 extern int netlink_request(struct nlsock *nl, struct nlmsghdr *n);
 
 #endif /* HAVE_NETLINK */
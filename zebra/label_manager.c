@@ -26,6 +26,7 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include "lib/jhash.h"
 #include "lib/log.h"
 #include "lib/memory.h"
 #include "lib/mpls.h"
@@ -61,6 +62,20 @@ static void delete_label_chunk(void *val)
 	XFREE(MTYPE_LM_CHUNK, val);
 }
 
+static unsigned int label_chunk_hash_key(void *p)
+{
+	const struct label_manager_chunk *lmc = p;
+
+	return jhash_1word(lmc->start, 0);
+}
+
+static bool label_chunk_hash_equal(const void *p1, const void *p2)
+{
+	const struct label_manager_chunk *lmc1 = p1, *lmc2 = p2;
+
+	return lmc1->start == lmc2->start;
+}
+
 static int relay_response_back(void)
 {
 	int ret = 0;
@@ -355,7 +370,11 @@ int release_daemon_label_chunks(struct zserv *client)
 		}
 	}
 
-	zlog_debug("%s: Released %d label chunks", __func__, count);
+	zlog_debug("%s: Released %d label chunks, %u still held by %s",
+		   __func__, count,
+		   (proto < ZEBRA_ROUTE_MAX) ? lbl_mgr.client_chunks[proto]
+					     : 0,
+		   zebra_route_string(proto));
 
 	return count;
 }
@@ -371,6 +390,12 @@ void label_manager_init(char *lm_zserv_path)
 		lm_is_external = false;
 		lbl_mgr.lc_list = list_new();
 		lbl_mgr.lc_list->del = delete_label_chunk;
+		lbl_mgr.chunks = vector_init(VECTOR_MIN_SIZE);
+		lbl_mgr.chunk_hash =
+			hash_create_size(8, label_chunk_hash_key,
+					 label_chunk_hash_equal,
+					 "Label Manager Chunks");
+		bf_init(lbl_mgr.in_use, 1024);
 	} else { /* it's acting just as a proxy */
 		zlog_debug("Initializing external label manager at %s",
 			   lm_zserv_path);
@@ -386,7 +411,7 @@ void label_manager_init(char *lm_zserv_path)
 /**
  * Core function, assigns label cunks
  *
- * It first searches through the list to check if there's one available
+ * It first checks the bitmap of released chunk slots for one available
  * (previously released). Otherwise it creates and assigns a new one
  *
  * @param proto Daemon protocol of client, to identify the owner
@@ -400,15 +425,41 @@ struct label_manager_chunk *assign_label_chunk(uint8_t proto,
 					       uint8_t keep, uint32_t size)
 {
 	struct label_manager_chunk *lmc;
-	struct listnode *node;
+	uint32_t idx;
 
-	/* first check if there's one available */
-	for (ALL_LIST_ELEMENTS_RO(lbl_mgr.lc_list, node, lmc)) {
-		if (lmc->proto == NO_PROTO
-		    && lmc->end - lmc->start + 1 == size) {
+	/* first check if there's one available; the bitmap yields the
+	 * lowest released slot without walking the in-use chunks.
+	 */
+	if (lbl_mgr.free_count > 0) {
+		bf_find_bit(lbl_mgr.in_use, idx);
+		lmc = (idx < vector_active(lbl_mgr.chunks))
+			      ? vector_slot(lbl_mgr.chunks, idx)
+			      : NULL;
+		if (lmc && lmc->end - lmc->start + 1 != size) {
+			/* Chunk sizes are uniform in practice; on a
+			 * mismatch, scan the remaining released slots.
+			 */
+			lmc = NULL;
+			for (idx++; idx < vector_active(lbl_mgr.chunks);
+			     idx++) {
+				struct label_manager_chunk *tmp;
+
+				tmp = vector_slot(lbl_mgr.chunks, idx);
+				if (tmp->proto == NO_PROTO
+				    && tmp->end - tmp->start + 1 == size) {
+					lmc = tmp;
+					break;
+				}
+			}
+		}
+		if (lmc) {
+			bf_set_bit(lbl_mgr.in_use, lmc->idx);
+			lbl_mgr.free_count--;
 			lmc->proto = proto;
 			lmc->instance = instance;
 			lmc->keep = keep;
+			if (proto < ZEBRA_ROUTE_MAX)
+				lbl_mgr.client_chunks[proto]++;
 			return lmc;
 		}
 	}
@@ -433,7 +484,13 @@ struct label_manager_chunk *assign_label_chunk(uint8_t proto,
 	lmc->proto = proto;
 	lmc->instance = instance;
 	lmc->keep = keep;
+	lmc->idx = vector_active(lbl_mgr.chunks);
+	vector_set_index(lbl_mgr.chunks, lmc->idx, lmc);
+	bf_set_bit(lbl_mgr.in_use, lmc->idx);
+	(void)hash_get(lbl_mgr.chunk_hash, lmc, hash_alloc_intern);
 	listnode_add(lbl_mgr.lc_list, lmc);
+	if (proto < ZEBRA_ROUTE_MAX)
+		lbl_mgr.client_chunks[proto]++;
 
 	return lmc;
 }
@@ -450,39 +507,46 @@ struct label_manager_chunk *assign_label_chunk(uint8_t proto,
 int release_label_chunk(uint8_t proto, unsigned short instance, uint32_t start,
 			uint32_t end)
 {
-	struct listnode *node;
+	struct label_manager_chunk lookup = {.start = start};
 	struct label_manager_chunk *lmc;
-	int ret = -1;
 
 	/* check that size matches */
 	zlog_debug("Releasing label chunk: %u - %u", start, end);
 	/* find chunk and disown */
-	for (ALL_LIST_ELEMENTS_RO(lbl_mgr.lc_list, node, lmc)) {
-		if (lmc->start != start)
-			continue;
-		if (lmc->end != end)
-			continue;
-		if (lmc->proto != proto || lmc->instance != instance) {
-			flog_err(EC_ZEBRA_LM_DAEMON_MISMATCH,
-				 "%s: Daemon mismatch!!", __func__);
-			continue;
-		}
-		lmc->proto = NO_PROTO;
-		lmc->instance = 0;
-		lmc->keep = 0;
-		ret = 0;
-		break;
+	lmc = hash_lookup(lbl_mgr.chunk_hash, &lookup);
+	if (!lmc || lmc->end != end) {
+		flog_err(EC_ZEBRA_LM_UNRELEASED_CHUNK,
+			 "%s: Label chunk not released!!", __func__);
+		return -1;
 	}
-	if (ret != 0)
+	if (lmc->proto != proto || lmc->instance != instance) {
+		flog_err(EC_ZEBRA_LM_DAEMON_MISMATCH, "%s: Daemon mismatch!!",
+			 __func__);
 		flog_err(EC_ZEBRA_LM_UNRELEASED_CHUNK,
 			 "%s: Label chunk not released!!", __func__);
+		return -1;
+	}
+	if (lmc->proto < ZEBRA_ROUTE_MAX)
+		lbl_mgr.client_chunks[lmc->proto]--;
+	lmc->proto = NO_PROTO;
+	lmc->instance = 0;
+	lmc->keep = 0;
+	bf_release_index(lbl_mgr.in_use, lmc->idx);
+	lbl_mgr.free_count++;
 
-	return ret;
+	return 0;
 }
 
 
 void label_manager_close(void)
 {
 	list_delete(&lbl_mgr.lc_list);
+	if (lbl_mgr.chunk_hash) {
+		hash_clean(lbl_mgr.chunk_hash, NULL);
+		hash_free(lbl_mgr.chunk_hash);
+	}
+	if (lbl_mgr.chunks)
+		vector_free(lbl_mgr.chunks);
+	bf_free(lbl_mgr.in_use);
 	stream_free(obuf);
 }
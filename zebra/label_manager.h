@@ -26,8 +26,11 @@
 
 #include <stdint.h>
 
+#include "lib/bitfield.h"
+#include "lib/hash.h"
 #include "lib/linklist.h"
 #include "lib/thread.h"
+#include "lib/vector.h"
 
 #include "zebra/zserv.h"
 
@@ -51,14 +54,30 @@ struct label_manager_chunk {
 	uint8_t keep;
 	uint32_t start; /* First label of the chunk */
 	uint32_t end;   /* Last label of the chunk */
+	uint32_t idx;   /* Slot in the chunk bitmap, fixed for the
+			 * lifetime of the chunk
+			 */
 };
 
 /*
  * Main label manager struct
- * Holds a linked list of label chunks.
+ * Holds a linked list of label chunks, plus the allocator state used to
+ * assign and release chunks in constant time: a bitmap of in-use chunk
+ * slots, a slot-indexed lookup vector and a hash keyed by chunk start
+ * label.
  */
 struct label_manager {
 	struct list *lc_list;
+
+	bitfield_t in_use;
+	vector chunks;
+	struct hash *chunk_hash;
+
+	/* Number of released chunks awaiting reuse */
+	uint32_t free_count;
+
+	/* Per-client chunk accounting, indexed by daemon protocol */
+	uint32_t client_chunks[ZEBRA_ROUTE_MAX];
 };
 
 bool lm_is_external;
@@ -55,6 +55,7 @@
 #include "zebra/zebra_netns_notify.h"
 #include "zebra/zebra_rnh.h"
 #include "zebra/zebra_pbr.h"
+#include "zebra/zebra_fib_state.h"
 
 #if defined(HANDLE_NETLINK_FUZZING)
 #include "zebra/kernel_netlink.h"
@@ -156,12 +157,18 @@ static void sigint(void)
 	list_delete_all_node(zrouter.client_list);
 	zebra_ptm_finish();
 
-	if (retain_mode)
+	if (retain_mode) {
+		/* Routes stay in the kernel; remember what was installed
+		 * so the next run can reconcile instead of reprogramming.
+		 */
+		zebra_fib_state_save();
+
 		RB_FOREACH (vrf, vrf_name_head, &vrfs_by_name) {
 			zvrf = vrf->info;
 			if (zvrf)
 				SET_FLAG(zvrf->flags, ZEBRA_VRF_RETAIN);
 		}
+	}
 	if (zrouter.lsp_process_q)
 		work_queue_free_and_null(&zrouter.lsp_process_q);
 	vrf_terminate();
@@ -383,6 +390,9 @@ int main(int argc, char **argv)
 	}
 
 	zrouter.master = frr_init();
+	/* zebra watches a descriptor per zclient plus netlink/interface
+	 * sockets; epoll keeps dispatch proportional to active fds. */
+	thread_master_use_epoll(zrouter.master, false);
 
 	/* Initialize pthread library */
 	frr_pthread_init();
@@ -391,6 +401,7 @@ int main(int argc, char **argv)
 	zebra_router_init();
 	zserv_init();
 	rib_init();
+	zebra_fib_state_init();
 	zebra_if_init();
 	zebra_debug_init();
 	router_id_cmd_init();
@@ -414,6 +425,8 @@ int main(int argc, char **argv)
 	zebra_mpls_vty_init();
 	zebra_pw_vty_init();
 	zebra_pbr_init();
+	zebra_pbr_agg_init();
+	zrib_dt_init();
 
 /* For debug purpose. */
 /* SET_FLAG (zebra_debug_event, ZEBRA_DEBUG_EVENT); */
@@ -435,7 +448,7 @@ int main(int argc, char **argv)
 	*  will be equal to the current getpid(). To know about such routes,
 	* we have to have route_read() called before.
 	*/
-	if (!keep_kernel_mode)
+	if (!keep_kernel_mode && !zebra_fib_state_present())
 		rib_sweep_route();
 
 	/* Needed for BSD routing socket. */
@@ -92,58 +92,129 @@ static void zebra_redistribute_default(struct zserv *client, vrf_id_t vrf_id)
 			    && newre->distance != DISTANCE_INFINITY)
 				zsend_redistribute_route(
 					ZEBRA_REDISTRIBUTE_ROUTE_ADD, client,
-					&rn->p, NULL, newre);
+					&rn->p, NULL, newre, NULL);
 		}
 
 		route_unlock_node(rn);
 	}
 }
 
+/*
+ * Maintain the per-type route lists that are used to replay
+ * redistribution registrations. Only routes in the main unicast
+ * tables are linked; other tables are never redistributed directly.
+ */
+void redistribute_list_add(struct route_node *rn, struct route_entry *re)
+{
+	rib_table_info_t *info = rib_table_info(rn->table);
+	struct zebra_vrf *zvrf = info->zvrf;
+	struct route_entry *head;
+
+	if (!zvrf || info->safi != SAFI_UNICAST
+	    || re->table != zvrf->table_id || re->type >= ZEBRA_ROUTE_MAX)
+		return;
+
+	head = zvrf->redist_routes[info->afi][re->type];
+	if (head)
+		head->redist_prev = re;
+	re->redist_next = head;
+	re->redist_prev = NULL;
+	zvrf->redist_routes[info->afi][re->type] = re;
+}
+
+void redistribute_list_del(struct route_entry *re)
+{
+	rib_table_info_t *info;
+	struct zebra_vrf *zvrf;
+
+	if (!re->rn)
+		return;
+
+	info = rib_table_info(re->rn->table);
+	zvrf = info->zvrf;
+
+	if (re->redist_next)
+		re->redist_next->redist_prev = re->redist_prev;
+	if (re->redist_prev)
+		re->redist_prev->redist_next = re->redist_next;
+	else if (zvrf && re->type < ZEBRA_ROUTE_MAX
+		 && zvrf->redist_routes[info->afi][re->type] == re)
+		zvrf->redist_routes[info->afi][re->type] = re->redist_next;
+
+	re->redist_next = re->redist_prev = NULL;
+}
+
+/*
+ * Replay one per-type route list to a client. Messages are collected
+ * on the given fifo so they can be handed to the client in one batch.
+ */
+static void zebra_redistribute_list(struct zserv *client, int type,
+				    unsigned short instance,
+				    struct route_entry *head,
+				    struct stream_fifo *fifo)
+{
+	struct route_entry *newre;
+
+	for (newre = head; newre; newre = newre->redist_next) {
+		const struct prefix *dst_p, *src_p;
+		char buf[PREFIX_STRLEN];
+
+		srcdest_rnode_prefixes(newre->rn, &dst_p, &src_p);
+
+		if (IS_ZEBRA_DEBUG_EVENT)
+			zlog_debug(
+				"%s: client %s %s(%u) checking: selected=%d, type=%d, distance=%d, metric=%d zebra_check_addr=%d",
+				__func__,
+				zebra_route_string(client->proto),
+				prefix2str(dst_p, buf, sizeof(buf)),
+				newre->vrf_id, CHECK_FLAG(newre->flags,
+							  ZEBRA_FLAG_SELECTED),
+				newre->type, newre->distance,
+				newre->metric, zebra_check_addr(dst_p));
+
+		if (!CHECK_FLAG(newre->flags, ZEBRA_FLAG_SELECTED))
+			continue;
+		if (type != ZEBRA_ROUTE_ALL && newre->instance != instance)
+			continue;
+		if (newre->distance == DISTANCE_INFINITY)
+			continue;
+		if (!zebra_check_addr(dst_p))
+			continue;
+
+		zsend_redistribute_route(ZEBRA_REDISTRIBUTE_ROUTE_ADD, client,
+					 dst_p, src_p, newre, fifo);
+	}
+}
+
 /* Redistribute routes. */
 static void zebra_redistribute(struct zserv *client, int type,
 			       unsigned short instance, vrf_id_t vrf_id,
 			       int afi)
 {
-	struct route_entry *newre;
-	struct route_table *table;
-	struct route_node *rn;
+	struct zebra_vrf *zvrf;
+	struct stream_fifo *fifo;
+	int t;
 
-	table = zebra_vrf_table(afi, SAFI_UNICAST, vrf_id);
-	if (!table)
+	zvrf = vrf_info_lookup(vrf_id);
+	if (!zvrf || !zebra_vrf_table(afi, SAFI_UNICAST, vrf_id))
 		return;
 
-	for (rn = route_top(table); rn; rn = srcdest_route_next(rn))
-		RNODE_FOREACH_RE (rn, newre) {
-			const struct prefix *dst_p, *src_p;
-			char buf[PREFIX_STRLEN];
+	fifo = stream_fifo_new();
 
-			srcdest_rnode_prefixes(rn, &dst_p, &src_p);
-
-			if (IS_ZEBRA_DEBUG_EVENT)
-				zlog_debug(
-					"%s: client %s %s(%u) checking: selected=%d, type=%d, distance=%d, metric=%d zebra_check_addr=%d",
-					__func__,
-					zebra_route_string(client->proto),
-					prefix2str(dst_p, buf, sizeof(buf)),
-					vrf_id, CHECK_FLAG(newre->flags,
-							   ZEBRA_FLAG_SELECTED),
-					newre->type, newre->distance,
-					newre->metric, zebra_check_addr(dst_p));
-
-			if (!CHECK_FLAG(newre->flags, ZEBRA_FLAG_SELECTED))
-				continue;
-			if ((type != ZEBRA_ROUTE_ALL
-			     && (newre->type != type
-				 || newre->instance != instance)))
-				continue;
-			if (newre->distance == DISTANCE_INFINITY)
-				continue;
-			if (!zebra_check_addr(dst_p))
-				continue;
-
-			zsend_redistribute_route(ZEBRA_REDISTRIBUTE_ROUTE_ADD,
-						 client, dst_p, src_p, newre);
-		}
+	/* Walk only the list(s) for the requested type; registration
+	 * replay no longer visits the entire RIB.
+	 */
+	if (type == ZEBRA_ROUTE_ALL) {
+		for (t = 0; t < ZEBRA_ROUTE_MAX; t++)
+			zebra_redistribute_list(client, type, instance,
+						zvrf->redist_routes[afi][t],
+						fifo);
+	} else
+		zebra_redistribute_list(client, type, instance,
+					zvrf->redist_routes[afi][type], fifo);
+
+	zserv_send_fifo(client, fifo);
+	stream_fifo_free(fifo);
 }
 
 /* Either advertise a route for redistribution to registered clients or */
@@ -203,7 +274,7 @@ void redistribute_update(const struct prefix *p, const struct prefix *src_p,
 					   re->distance, re->metric);
 			}
 			zsend_redistribute_route(ZEBRA_REDISTRIBUTE_ROUTE_ADD,
-						 client, p, src_p, re);
+						 client, p, src_p, re, NULL);
 		} else if (prev_re
 			   && ((re->instance
 				&& redist_check_instance(
@@ -214,7 +285,8 @@ void redistribute_update(const struct prefix *p, const struct prefix *src_p,
 					  client->redist[afi][prev_re->type],
 					  re->vrf_id))) {
 			zsend_redistribute_route(ZEBRA_REDISTRIBUTE_ROUTE_DEL,
-						 client, p, src_p, prev_re);
+						 client, p, src_p, prev_re,
+						 NULL);
 		}
 	}
 }
@@ -259,7 +331,7 @@ void redistribute_delete(const struct prefix *p, const struct prefix *src_p,
 		    || vrf_bitmap_check(client->redist[afi][re->type],
 					re->vrf_id)) {
 			zsend_redistribute_route(ZEBRA_REDISTRIBUTE_ROUTE_DEL,
-						 client, p, src_p, re);
+						 client, p, src_p, re, NULL);
 		}
 	}
 }
@@ -36,6 +36,10 @@ extern void zebra_redistribute_default_add(ZAPI_HANDLER_ARGS);
 extern void zebra_redistribute_default_delete(ZAPI_HANDLER_ARGS);
 /* ----------------- */
 
+extern void redistribute_list_add(struct route_node *rn,
+				  struct route_entry *re);
+extern void redistribute_list_del(struct route_entry *re);
+
 extern void redistribute_update(const struct prefix *p,
 				const struct prefix *src_p,
 				struct route_entry *re,
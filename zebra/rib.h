@@ -43,6 +43,17 @@ struct route_entry {
 	struct route_entry *next;
 	struct route_entry *prev;
 
+	/* Per-redistribution-type list linkage; only set while the
+	 * entry is linked into a main unicast table. Lets registration
+	 * replay only the routes of the requested type instead of
+	 * walking the entire RIB.
+	 */
+	struct route_entry *redist_next;
+	struct route_entry *redist_prev;
+
+	/* Back pointer to the owning route node, set while linked. */
+	struct route_node *rn;
+
 	/* Nexthop structure */
 	struct nexthop_group ng;
 
@@ -95,6 +106,8 @@ struct route_entry {
 #define ROUTE_ENTRY_INSTALLED        0x20
 /* Route has Failed installation into the Data Plane in some manner */
 #define ROUTE_ENTRY_FAILED           0x40
+/* Route matches persisted pre-restart state; kernel work is skipped */
+#define ROUTE_ENTRY_RECONCILED       0x80
 
 	/* Nexthop information. */
 	uint8_t nexthop_num;
@@ -168,6 +181,14 @@ typedef struct rib_dest_t_ {
  */
 #define RIB_DEST_UPDATE_FPM    (1 << (ZEBRA_MAX_QINDEX + 2))
 
+/*
+ * This dest was (re)queued only because individual route entries on it
+ * changed, not because of an external event such as an interface state
+ * change. rib_process() can then limit nexthop re-evaluation to the
+ * entries actually flagged ROUTE_ENTRY_CHANGED.
+ */
+#define RIB_DEST_ENTRY_TRIGGERED (1 << (ZEBRA_MAX_QINDEX + 3))
+
 /*
  * Macro to iterate over each route for a destination (prefix).
  */
@@ -189,6 +210,8 @@ typedef struct rib_dest_t_ {
 
 #if defined(HAVE_RTADV)
 /* Structure which hold status of router advertisement. */
+struct timer_wheel;
+
 struct rtadv {
 	int sock;
 
@@ -197,6 +220,11 @@ struct rtadv {
 
 	struct thread *ra_read;
 	struct thread *ra_timer;
+
+	/* Wheel pacing interfaces with second-granularity RA intervals;
+	 * ra_timer only runs while sub-second intervals are configured.
+	 */
+	struct timer_wheel *ra_wheel;
 };
 #endif /* HAVE_RTADV */
 
@@ -346,6 +374,14 @@ extern unsigned long rib_score_proto_table(uint8_t proto,
 					   struct route_table *table);
 extern void rib_queue_add(struct route_node *rn);
 extern void meta_queue_free(struct meta_queue *mq);
+extern void rib_meta_queue_purge_vrf(struct zebra_vrf *zvrf);
+extern int rib_workers_set(uint32_t nworkers);
+extern uint32_t rib_workers_get(void);
+extern bool rib_queues_empty(void);
+
+/* rib load harness (zebra_rib_dt.c) */
+extern void zrib_dt_init(void);
+extern void rib_workers_terminate(void);
 extern int zebra_rib_labeled_unicast(struct route_entry *re);
 extern struct route_table *rib_table_ipv6;
 
@@ -38,11 +38,22 @@
 extern enum zebra_dplane_result kernel_route_update(
 	struct zebra_dplane_ctx *ctx);
 
+/*
+ * Install or remove a kernel nexthop-group object. Returns 0 on
+ * success, nonzero if the platform has no nexthop-object support.
+ */
+struct nhg_hash_entry;
+extern int kernel_nexthop_group_update(const struct nhg_hash_entry *nhe,
+				       bool install);
+
 extern enum zebra_dplane_result kernel_lsp_update(
 	struct zebra_dplane_ctx *ctx);
 
 enum zebra_dplane_result kernel_pw_update(struct zebra_dplane_ctx *ctx);
 
+extern enum zebra_dplane_result kernel_pbr_rule_update(
+	struct zebra_dplane_ctx *ctx);
+
 extern int kernel_address_add_ipv4(struct interface *, struct connected *);
 extern int kernel_address_delete_ipv4(struct interface *, struct connected *);
 extern int kernel_address_add_ipv6(struct interface *, struct connected *);
@@ -26,6 +26,7 @@
 #include <linux/lwtunnel.h>
 #include <linux/mpls_iptunnel.h>
 #include <linux/neighbour.h>
+#include <linux/nexthop.h>
 #include <linux/rtnetlink.h>
 
 /* Hack for GNU libc version 2. */
@@ -63,6 +64,7 @@
 #include "zebra/kernel_netlink.h"
 #include "zebra/rt_netlink.h"
 #include "zebra/zebra_mroute.h"
+#include "zebra/zebra_nhg.h"
 #include "zebra/zebra_vxlan.h"
 #include "zebra/zebra_errors.h"
 
@@ -1435,7 +1437,8 @@ static int netlink_neigh_update(int cmd, int ifindex, uint32_t addr, char *lla,
 /*
  * Routing table change via netlink interface, using a dataplane context object
  */
-static int netlink_route_multipath(int cmd, struct zebra_dplane_ctx *ctx)
+static int netlink_route_multipath(int cmd, struct zebra_dplane_ctx *ctx,
+				   struct nl_batch *bth)
 {
 	int bytelen;
 	struct nexthop *nexthop = NULL;
@@ -1557,6 +1560,19 @@ static int netlink_route_multipath(int cmd, struct zebra_dplane_ctx *ctx)
 			  RTA_PAYLOAD(rta));
 	}
 
+	/* If the nexthops are covered by an installed kernel nexthop-group
+	 * object, just reference the object id instead of re-encoding the
+	 * full nexthop list for every route that shares it.
+	 */
+	if (cmd == RTM_NEWROUTE) {
+		uint32_t nhg_id = dplane_ctx_get_nhg_id(ctx);
+
+		if (nhg_id) {
+			addattr32(&req.n, sizeof(req), RTA_NH_ID, nhg_id);
+			goto skip;
+		}
+	}
+
 	/* Count overall nexthops so we can decide whether to use singlepath
 	 * or multipath case.
 	 */
@@ -1746,7 +1762,12 @@ static int netlink_route_multipath(int cmd, struct zebra_dplane_ctx *ctx)
 	}
 
 skip:
-	/* Talk to netlink socket. */
+	/* Pack into the caller's batch if one is active, else talk to the
+	 * netlink socket directly.
+	 */
+	if (bth)
+		return netlink_batch_add_msg(bth, &req.n);
+
 	return netlink_talk_info(netlink_talk_filter, &req.n,
 				 dplane_ctx_get_ns(ctx), 0);
 }
@@ -1804,6 +1825,85 @@ int kernel_get_ipmr_sg_stats(struct zebra_vrf *zvrf, void *in)
 	return suc;
 }
 
+/*
+ * Install or remove a kernel nexthop-group object (RTM_NEWNEXTHOP /
+ * RTM_DELNEXTHOP). Multi-nexthop entries reference the object ids of
+ * their member singletons via NHA_GROUP.
+ */
+int kernel_nexthop_group_update(const struct nhg_hash_entry *nhe, bool install)
+{
+	struct zebra_ns *zns = zebra_ns_lookup(NS_DEFAULT);
+	int cmd = install ? RTM_NEWNEXTHOP : RTM_DELNEXTHOP;
+	struct nexthop *nexthop;
+
+	struct {
+		struct nlmsghdr n;
+		struct nhmsg nhm;
+		char buf[NL_PKT_BUF_SIZE];
+	} req;
+
+	memset(&req, 0, sizeof(req) - NL_PKT_BUF_SIZE);
+
+	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct nhmsg));
+	req.n.nlmsg_flags = NLM_F_CREATE | NLM_F_REQUEST | NLM_F_REPLACE;
+	req.n.nlmsg_type = cmd;
+
+	req.nhm.nh_family = AF_UNSPEC;
+	req.nhm.nh_protocol = RTPROT_ZEBRA;
+
+	addattr32(&req.n, sizeof(req), NHA_ID, nhe->id);
+
+	if (install && nhe->grp_count > 0) {
+		struct nexthop_grp grp[ZEBRA_NHG_MAX_GROUP];
+		uint8_t i;
+
+		memset(grp, 0, sizeof(grp));
+		for (i = 0; i < nhe->grp_count; i++) {
+			grp[i].id = nhe->grp[i];
+			grp[i].weight = 1;
+		}
+
+		addattr_l(&req.n, sizeof(req), NHA_GROUP, grp,
+			  nhe->grp_count * sizeof(grp[0]));
+	} else if (install) {
+		nexthop = nhe->nhg.nexthop;
+
+		if (nexthop->type == NEXTHOP_TYPE_BLACKHOLE) {
+			addattr_l(&req.n, sizeof(req), NHA_BLACKHOLE, NULL, 0);
+		} else {
+			switch (nexthop->type) {
+			case NEXTHOP_TYPE_IPV4:
+			case NEXTHOP_TYPE_IPV4_IFINDEX:
+				req.nhm.nh_family = AF_INET;
+				addattr_l(&req.n, sizeof(req), NHA_GATEWAY,
+					  &nexthop->gate.ipv4, 4);
+				break;
+			case NEXTHOP_TYPE_IPV6:
+			case NEXTHOP_TYPE_IPV6_IFINDEX:
+				req.nhm.nh_family = AF_INET6;
+				addattr_l(&req.n, sizeof(req), NHA_GATEWAY,
+					  &nexthop->gate.ipv6, 16);
+				break;
+			case NEXTHOP_TYPE_IFINDEX:
+				break;
+			default:
+				return -1;
+			}
+
+			if (nexthop->ifindex)
+				addattr32(&req.n, sizeof(req), NHA_OIF,
+					  nexthop->ifindex);
+		}
+	}
+
+	if (IS_ZEBRA_DEBUG_KERNEL)
+		zlog_debug("%s: %s nexthop-group %u", __func__,
+			   install ? "install" : "remove", nhe->id);
+
+	return netlink_talk(netlink_talk_filter, &req.n, &zns->netlink_cmd,
+			    zns, 0);
+}
+
 /*
  * Update or delete a prefix from the kernel,
  * using info from a dataplane context.
@@ -1813,6 +1913,16 @@ enum zebra_dplane_result kernel_route_update(struct zebra_dplane_ctx *ctx)
 	int cmd, ret;
 	const struct prefix *p = dplane_ctx_get_dest(ctx);
 	struct nexthop *nexthop;
+	struct nl_batch batch, *bth = NULL;
+
+	/* When batching is enabled, all messages for this update share a
+	 * single sendmsg() and ACK window.
+	 */
+	if (netlink_batch_get_limit() > 1) {
+		netlink_batch_begin(&batch, netlink_talk_filter,
+				    dplane_ctx_get_ns(ctx), 0);
+		bth = &batch;
+	}
 
 	if (dplane_ctx_get_op(ctx) == DPLANE_OP_ROUTE_DELETE) {
 		cmd = RTM_DELROUTE;
@@ -1836,15 +1946,19 @@ enum zebra_dplane_result kernel_route_update(struct zebra_dplane_ctx *ctx)
 			 * of the route delete.  If that happens yeah we're
 			 * screwed.
 			 */
-			(void)netlink_route_multipath(RTM_DELROUTE, ctx);
+			(void)netlink_route_multipath(RTM_DELROUTE, ctx, bth);
 			cmd = RTM_NEWROUTE;
 		}
 
 	} else {
+		if (bth)
+			netlink_batch_finish(bth);
 		return ZEBRA_DPLANE_REQUEST_FAILURE;
 	}
 
-	ret = netlink_route_multipath(cmd, ctx);
+	ret = netlink_route_multipath(cmd, ctx, bth);
+	if (bth && netlink_batch_finish(bth) != 0)
+		ret = -1;
 	if ((cmd == RTM_NEWROUTE) && (ret == 0)) {
 		/* Update installed nexthops to signal which have been
 		 * installed.
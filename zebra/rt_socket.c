@@ -342,6 +342,12 @@ enum zebra_dplane_result kernel_route_update(struct zebra_dplane_ctx *ctx)
 	return res;
 }
 
+/* No kernel nexthop-group objects on the routing-socket platforms */
+int kernel_nexthop_group_update(const struct nhg_hash_entry *nhe, bool install)
+{
+	return -1;
+}
+
 int kernel_neigh_update(int add, int ifindex, uint32_t addr, char *lla,
 			int llalen, ns_id_t ns_id)
 {
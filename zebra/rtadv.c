@@ -36,6 +36,7 @@
 #include "vrf.h"
 #include "ns.h"
 #include "lib_errors.h"
+#include "wheel.h"
 
 #include "zebra/interface.h"
 #include "zebra/rtadv.h"
@@ -459,22 +460,75 @@ no_more_opts:
 		zif->ra_sent++;
 }
 
+/*
+ * Timer wheel slot key; spreads interfaces over the wheel's slots so
+ * that same-slot interfaces are advertised in one pass.
+ */
+static unsigned int rtadv_wheel_key(void *item)
+{
+	struct interface *ifp = item;
+
+	return (unsigned int)ifp->ifindex;
+}
+
+/*
+ * Timer wheel worker, run once per wheel period (one second) for every
+ * interface with RA enabled. Sub-second intervals are paced by the
+ * millisecond timer instead.
+ */
+static void rtadv_wheel_run(void *item)
+{
+	struct interface *ifp = item;
+	struct zebra_if *zif = ifp->info;
+
+	if (if_is_loopback(ifp)
+	    || CHECK_FLAG(ifp->status, ZEBRA_INTERFACE_VRF_LOOPBACK)
+	    || !if_is_operative(ifp))
+		return;
+
+	if (!zif->rtadv.AdvSendAdvertisements
+	    || zif->rtadv.MaxRtrAdvInterval < 1000)
+		return;
+
+	if (zif->rtadv.inFastRexmit) {
+		/* We assume we fast rexmit every sec so no
+		 * additional vars */
+		if (--zif->rtadv.NumFastReXmitsRemain <= 0)
+			zif->rtadv.inFastRexmit = 0;
+
+		if (IS_ZEBRA_DEBUG_SEND)
+			zlog_debug("Fast RA Rexmit on interface %s",
+				   ifp->name);
+
+		rtadv_send_packet(zrouter.rtadv.sock, ifp);
+	} else {
+		zif->rtadv.AdvIntervalTimer -= 1000;
+		if (zif->rtadv.AdvIntervalTimer <= 0) {
+			/* FIXME: using MaxRtrAdvInterval each time isn't
+			   what section 6.2.4 of RFC4861 tells to do. */
+			zif->rtadv.AdvIntervalTimer =
+				zif->rtadv.MaxRtrAdvInterval;
+			rtadv_send_packet(zrouter.rtadv.sock, ifp);
+		}
+	}
+}
+
 static int rtadv_timer(struct thread *thread)
 {
 	struct zebra_ns *zns = THREAD_ARG(thread);
 	struct vrf *vrf;
 	struct interface *ifp;
 	struct zebra_if *zif;
-	int period;
 
 	zrouter.rtadv.ra_timer = NULL;
-	if (zrouter.rtadv.adv_msec_if_count == 0) {
-		period = 1000; /* 1 s */
-		rtadv_event(zns, RTADV_TIMER, 1 /* 1 s */);
-	} else {
-		period = 10; /* 10 ms */
-		rtadv_event(zns, RTADV_TIMER_MSEC, 10 /* 10 ms */);
-	}
+
+	/* Interfaces with second-granularity intervals are driven by the
+	 * RA timer wheel; this timer only paces sub-second intervals.
+	 */
+	if (zrouter.rtadv.adv_msec_if_count == 0)
+		return 0;
+
+	rtadv_event(zns, RTADV_TIMER_MSEC, 10 /* 10 ms */);
 
 	RB_FOREACH (vrf, vrf_id_head, &vrfs_by_id)
 		FOR_ALL_INTERFACES (vrf, ifp) {
@@ -486,44 +540,37 @@ static int rtadv_timer(struct thread *thread)
 
 			zif = ifp->info;
 
-			if (zif->rtadv.AdvSendAdvertisements) {
-				if (zif->rtadv.inFastRexmit) {
-					/* We assume we fast rexmit every sec so
-					 * no
-					 * additional vars */
-					if (--zif->rtadv.NumFastReXmitsRemain
-					    <= 0)
-						zif->rtadv.inFastRexmit = 0;
-
-					if (IS_ZEBRA_DEBUG_SEND)
-						zlog_debug(
-							"Fast RA Rexmit on interface %s",
-							ifp->name);
-
-					rtadv_send_packet(zrouter.rtadv.sock,
-							  ifp);
-				} else {
-					zif->rtadv.AdvIntervalTimer -= period;
-					if (zif->rtadv.AdvIntervalTimer <= 0) {
-						/* FIXME: using
-						   MaxRtrAdvInterval each
-						   time isn't what section
-						   6.2.4 of RFC4861 tells to do.
-						   */
-						zif->rtadv.AdvIntervalTimer =
-							zif->rtadv
-								.MaxRtrAdvInterval;
-						rtadv_send_packet(
-							zrouter.rtadv.sock,
-							ifp);
-					}
-				}
+			if (!zif->rtadv.AdvSendAdvertisements
+			    || zif->rtadv.MaxRtrAdvInterval >= 1000)
+				continue;
+
+			zif->rtadv.AdvIntervalTimer -= 10;
+			if (zif->rtadv.AdvIntervalTimer <= 0) {
+				/* FIXME: using MaxRtrAdvInterval each
+				   time isn't what section 6.2.4 of
+				   RFC4861 tells to do. */
+				zif->rtadv.AdvIntervalTimer =
+					zif->rtadv.MaxRtrAdvInterval;
+				rtadv_send_packet(zrouter.rtadv.sock, ifp);
 			}
 		}
 
 	return 0;
 }
 
+/*
+ * Make sure the millisecond timer is ticking whenever some interface
+ * uses a sub-second RA interval; it stops itself once none are left.
+ */
+static void rtadv_msec_timer_update(struct interface *ifp)
+{
+	struct zebra_vrf *zvrf = vrf_info_lookup(ifp->vrf_id);
+
+	if (zrouter.rtadv.adv_msec_if_count > 0
+	    && zrouter.rtadv.adv_if_count > 0 && !zrouter.rtadv.ra_timer)
+		rtadv_event(zvrf->zns, RTADV_TIMER_MSEC, 10);
+}
+
 static void rtadv_process_solicit(struct interface *ifp)
 {
 	struct zebra_vrf *zvrf = vrf_info_lookup(ifp->vrf_id);
@@ -888,6 +935,9 @@ static void ipv6_nd_suppress_ra_set(struct interface *ifp,
 			zif->rtadv.AdvIntervalTimer = 0;
 			zrouter.rtadv.adv_if_count--;
 
+			if (zrouter.rtadv.ra_wheel)
+				wheel_remove_item(zrouter.rtadv.ra_wheel, ifp);
+
 			if_leave_all_router(zrouter.rtadv.sock, ifp);
 
 			if (zrouter.rtadv.adv_if_count == 0)
@@ -912,6 +962,11 @@ static void ipv6_nd_suppress_ra_set(struct interface *ifp,
 			if (zrouter.rtadv.adv_if_count == 1)
 				rtadv_event(zns, RTADV_START,
 					    zrouter.rtadv.sock);
+
+			if (zrouter.rtadv.ra_wheel)
+				wheel_add_item(zrouter.rtadv.ra_wheel, ifp);
+
+			rtadv_msec_timer_update(ifp);
 		}
 	}
 }
@@ -1071,6 +1126,8 @@ DEFUN (ipv6_nd_ra_interval_msec,
 	zif->rtadv.MinRtrAdvInterval = 0.33 * interval;
 	zif->rtadv.AdvIntervalTimer = 0;
 
+	rtadv_msec_timer_update(ifp);
+
 	return CMD_SUCCESS;
 }
 
@@ -2102,10 +2159,16 @@ static void rtadv_event(struct zebra_ns *zns, enum rtadv_event event, int val)
 	case RTADV_START:
 		thread_add_read(zrouter.master, rtadv_read, zns, val,
 				&rtadv->ra_read);
-		thread_add_event(zrouter.master, rtadv_timer, zns, 0,
-				 &rtadv->ra_timer);
+		if (rtadv->ra_wheel == NULL)
+			rtadv->ra_wheel = wheel_init(
+				zrouter.master, 1, 100, rtadv_wheel_key,
+				rtadv_wheel_run, "RA timer wheel");
+		else
+			wheel_start(rtadv->ra_wheel);
 		break;
 	case RTADV_STOP:
+		if (rtadv->ra_wheel)
+			wheel_stop(rtadv->ra_wheel);
 		if (rtadv->ra_timer) {
 			thread_cancel(rtadv->ra_timer);
 			rtadv->ra_timer = NULL;
@@ -2138,6 +2201,18 @@ void rtadv_init(struct zebra_ns *zns)
 	zrouter.rtadv.sock = rtadv_make_socket(zns->ns_id);
 }
 
+/*
+ * Drop an interface from RA scheduling state; called while the
+ * interface is being deleted.
+ */
+void rtadv_if_fini(struct interface *ifp)
+{
+	struct zebra_if *zif = ifp->info;
+
+	if (zif->rtadv.AdvSendAdvertisements && zrouter.rtadv.ra_wheel)
+		wheel_remove_item(zrouter.rtadv.ra_wheel, ifp);
+}
+
 void rtadv_terminate(struct zebra_ns *zns)
 {
 	rtadv_event(zns, RTADV_STOP, 0);
@@ -2255,4 +2330,8 @@ void rtadv_cmd_init(void)
 {
 	/* Empty.*/;
 }
+void rtadv_if_fini(struct interface *ifp)
+{
+	/* Empty.*/;
+}
 #endif /* HAVE_RTADV */
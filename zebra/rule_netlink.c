@@ -49,10 +49,11 @@
 /* Private functions */
 
 /* Install or uninstall specified rule for a specific interface.
- * Form netlink message and ship it. Currently, notify status after
- * waiting for netlink status.
+ * Form netlink message and ship it; if a batch is supplied the message
+ * is packed into it instead of being sent synchronously.
  */
-static int netlink_rule_update(int cmd, struct zebra_pbr_rule *rule)
+static int netlink_rule_update(int cmd, struct zebra_pbr_rule *rule,
+			       struct nl_batch *bth)
 {
 	int family;
 	int bytelen;
@@ -127,6 +128,12 @@ static int netlink_rule_update(int cmd, struct zebra_pbr_rule *rule)
 				   sizeof(buf2)),
 			rule->rule.action.table);
 
+	/* If batching, just pack the message; acks are collected when the
+	 * batch is flushed.
+	 */
+	if (bth)
+		return netlink_batch_add_msg(bth, &req.n);
+
 	/* Ship off the message.
 	 * Note: Currently, netlink_talk() is a blocking call which returns
 	 * back the status.
@@ -140,35 +147,36 @@ static int netlink_rule_update(int cmd, struct zebra_pbr_rule *rule)
 
 /* Public functions */
 /*
- * Install specified rule for a specific interface. The preference is what
- * goes in the rule to denote relative ordering; it may or may not be the
- * same as the rule's user-defined sequence number.
+ * Install or uninstall a rule from the kernel, using info from a
+ * dataplane context. The preference is what goes in the rule to denote
+ * relative ordering; it may or may not be the same as the rule's
+ * user-defined sequence number.
  */
-enum zebra_dplane_result kernel_add_pbr_rule(struct zebra_pbr_rule *rule)
+enum zebra_dplane_result kernel_pbr_rule_update(struct zebra_dplane_ctx *ctx)
 {
-	int ret = 0;
-
-	ret = netlink_rule_update(RTM_NEWRULE, rule);
-	kernel_pbr_rule_add_del_status(rule,
-				       (!ret) ? ZEBRA_DPLANE_INSTALL_SUCCESS
-					      : ZEBRA_DPLANE_INSTALL_FAILURE);
+	int cmd, ret;
+	struct nl_batch batch, *bth = NULL;
 
-	return ZEBRA_DPLANE_REQUEST_SUCCESS;
-}
+	/* When batching is enabled, rules in this update share a single
+	 * sendmsg() and ACK window.
+	 */
+	if (netlink_batch_get_limit() > 1) {
+		netlink_batch_begin(&batch, netlink_talk_filter,
+				    dplane_ctx_get_ns(ctx), 0);
+		bth = &batch;
+	}
 
-/*
- * Uninstall specified rule for a specific interface.
- */
-enum zebra_dplane_result kernel_del_pbr_rule(struct zebra_pbr_rule *rule)
-{
-	int ret = 0;
+	if (dplane_ctx_get_op(ctx) == DPLANE_OP_RULE_DELETE)
+		cmd = RTM_DELRULE;
+	else
+		cmd = RTM_NEWRULE;
 
-	ret = netlink_rule_update(RTM_DELRULE, rule);
-	kernel_pbr_rule_add_del_status(rule,
-				       (!ret) ? ZEBRA_DPLANE_DELETE_SUCCESS
-					      : ZEBRA_DPLANE_DELETE_FAILURE);
+	ret = netlink_rule_update(cmd, dplane_ctx_get_rule(ctx), bth);
+	if (bth && netlink_batch_finish(bth) != 0)
+		ret = -1;
 
-	return ZEBRA_DPLANE_REQUEST_SUCCESS;
+	return (ret == 0 ? ZEBRA_DPLANE_REQUEST_SUCCESS
+			 : ZEBRA_DPLANE_REQUEST_FAILURE);
 }
 
 /*
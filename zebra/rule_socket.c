@@ -43,14 +43,7 @@
 #include "zebra/zebra_pbr.h"
 #include "zebra/zebra_errors.h"
 
-enum zebra_dplane_result kernel_add_pbr_rule(struct zebra_pbr_rule *rule)
-{
-	flog_err(EC_LIB_UNAVAILABLE, "%s not Implemented for this platform",
-		 __PRETTY_FUNCTION__);
-	return ZEBRA_DPLANE_REQUEST_FAILURE;
-}
-
-enum zebra_dplane_result kernel_del_pbr_rule(struct zebra_pbr_rule *rule)
+enum zebra_dplane_result kernel_pbr_rule_update(struct zebra_dplane_ctx *ctx)
 {
 	flog_err(EC_LIB_UNAVAILABLE, "%s not Implemented for this platform",
 		 __PRETTY_FUNCTION__);
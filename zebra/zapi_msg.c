@@ -41,6 +41,7 @@
 #include "lib/vrf.h"
 #include "lib/libfrr.h"
 #include "lib/sockopt.h"
+#include "lib/shstrtab.h"
 
 #include "zebra/zebra_router.h"
 #include "zebra/rib.h"
@@ -514,7 +515,8 @@ int zsend_interface_update(int cmd, struct zserv *client, struct interface *ifp)
 
 int zsend_redistribute_route(int cmd, struct zserv *client,
 			     const struct prefix *p,
-			     const struct prefix *src_p, struct route_entry *re)
+			     const struct prefix *src_p, struct route_entry *re,
+			     struct stream_fifo *fifo)
 {
 	struct zapi_route api;
 	struct zapi_nexthop *api_nh;
@@ -621,6 +623,13 @@ int zsend_redistribute_route(int cmd, struct zserv *client,
 			   zebra_route_string(api.type), api.vrf_id,
 			   buf_prefix);
 	}
+
+	/* Batched callers collect the messages and send them together */
+	if (fifo) {
+		stream_fifo_push(fifo, s);
+		return 0;
+	}
+
 	return zserv_send_message(client, s);
 }
 
@@ -1343,10 +1352,14 @@ void zserv_nexthop_num_warn(const char *caller, const struct prefix *p,
 	}
 }
 
-static void zread_route_add(ZAPI_HANDLER_ARGS)
+/*
+ * Install one route described by a decoded zapi_route.  Factored out of
+ * zread_route_add() so the bulk handler can run the same path for each
+ * prefix riding in a ZEBRA_ROUTE_ADD_BULK message.
+ */
+static void zapi_route_install(struct zserv *client, struct zebra_vrf *zvrf,
+			       struct zapi_route *api)
 {
-	struct stream *s;
-	struct zapi_route api;
 	struct zapi_nexthop *api_nh;
 	afi_t afi;
 	struct prefix_ipv6 *src_p = NULL;
@@ -1356,43 +1369,35 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 	vrf_id_t vrf_id = 0;
 	struct ipaddr vtep_ip;
 
-	s = msg;
-	if (zapi_route_decode(s, &api) < 0) {
-		if (IS_ZEBRA_DEBUG_RECV)
-			zlog_debug("%s: Unable to decode zapi_route sent",
-				   __PRETTY_FUNCTION__);
-		return;
-	}
-
 	if (IS_ZEBRA_DEBUG_RECV) {
 		char buf_prefix[PREFIX_STRLEN];
 
-		prefix2str(&api.prefix, buf_prefix, sizeof(buf_prefix));
+		prefix2str(&api->prefix, buf_prefix, sizeof(buf_prefix));
 		zlog_debug("%s: p=%s, ZAPI_MESSAGE_LABEL: %sset, flags=0x%x",
 			   __func__, buf_prefix,
-			   (CHECK_FLAG(api.message, ZAPI_MESSAGE_LABEL) ? ""
+			   (CHECK_FLAG(api->message, ZAPI_MESSAGE_LABEL) ? ""
 									: "un"),
-			   api.flags);
+			   api->flags);
 	}
 
 	/* Allocate new route. */
 	vrf_id = zvrf_id(zvrf);
 	re = XCALLOC(MTYPE_RE, sizeof(struct route_entry));
-	re->type = api.type;
-	re->instance = api.instance;
-	re->flags = api.flags;
+	re->type = api->type;
+	re->instance = api->instance;
+	re->flags = api->flags;
 	re->uptime = time(NULL);
 	re->vrf_id = vrf_id;
-	if (api.tableid && vrf_id == VRF_DEFAULT)
-		re->table = api.tableid;
+	if (api->tableid && vrf_id == VRF_DEFAULT)
+		re->table = api->tableid;
 	else
 		re->table = zvrf->table_id;
 
-	if (!CHECK_FLAG(api.message, ZAPI_MESSAGE_NEXTHOP)
-	    || api.nexthop_num == 0) {
+	if (!CHECK_FLAG(api->message, ZAPI_MESSAGE_NEXTHOP)
+	    || api->nexthop_num == 0) {
 		char buf_prefix[PREFIX_STRLEN];
 
-		prefix2str(&api.prefix, buf_prefix, sizeof(buf_prefix));
+		prefix2str(&api->prefix, buf_prefix, sizeof(buf_prefix));
 		flog_warn(EC_ZEBRA_RX_ROUTE_NO_NEXTHOPS,
 			  "%s: received a route without nexthops for prefix %s",
 			  __func__, buf_prefix);
@@ -1405,8 +1410,8 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 	 * api_nh->vrf_id instead of re->vrf_id ? I only changed
 	 * for cases NEXTHOP_TYPE_IPV4 and NEXTHOP_TYPE_IPV6.
 	 */
-	for (i = 0; i < api.nexthop_num; i++) {
-		api_nh = &api.nexthops[i];
+	for (i = 0; i < api->nexthop_num; i++) {
+		api_nh = &api->nexthops[i];
 		ifindex_t ifindex = 0;
 
 		if (IS_ZEBRA_DEBUG_RECV)
@@ -1450,14 +1455,14 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 			/* Special handling for IPv4 routes sourced from EVPN:
 			 * the nexthop and associated MAC need to be installed.
 			 */
-			if (CHECK_FLAG(api.flags, ZEBRA_FLAG_EVPN_ROUTE)) {
+			if (CHECK_FLAG(api->flags, ZEBRA_FLAG_EVPN_ROUTE)) {
 				vtep_ip.ipa_type = IPADDR_V4;
 				memcpy(&(vtep_ip.ipaddr_v4),
 				       &(api_nh->gate.ipv4),
 				       sizeof(struct in_addr));
 				zebra_vxlan_evpn_vrf_route_add(
 					vrf_id, &api_nh->rmac, &vtep_ip,
-					&api.prefix);
+					&api->prefix);
 			}
 			break;
 		case NEXTHOP_TYPE_IPV6:
@@ -1474,13 +1479,13 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 			/* Special handling for IPv6 routes sourced from EVPN:
 			 * the nexthop and associated MAC need to be installed.
 			 */
-			if (CHECK_FLAG(api.flags, ZEBRA_FLAG_EVPN_ROUTE)) {
+			if (CHECK_FLAG(api->flags, ZEBRA_FLAG_EVPN_ROUTE)) {
 				vtep_ip.ipa_type = IPADDR_V6;
 				memcpy(&vtep_ip.ipaddr_v6, &(api_nh->gate.ipv6),
 				       sizeof(struct in6_addr));
 				zebra_vxlan_evpn_vrf_route_add(
 					vrf_id, &api_nh->rmac, &vtep_ip,
-					&api.prefix);
+					&api->prefix);
 			}
 			break;
 		case NEXTHOP_TYPE_BLACKHOLE:
@@ -1493,7 +1498,7 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 			flog_warn(
 				EC_ZEBRA_NEXTHOP_CREATION_FAILED,
 				"%s: Nexthops Specified: %d but we failed to properly create one",
-				__PRETTY_FUNCTION__, api.nexthop_num);
+				__PRETTY_FUNCTION__, api->nexthop_num);
 			nexthops_free(re->ng.nexthop);
 			XFREE(MTYPE_RE, re);
 			return;
@@ -1502,7 +1507,7 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 			SET_FLAG(nexthop->flags, NEXTHOP_FLAG_ONLINK);
 
 		/* MPLS labels for BGP-LU or Segment Routing */
-		if (CHECK_FLAG(api.message, ZAPI_MESSAGE_LABEL)
+		if (CHECK_FLAG(api->message, ZAPI_MESSAGE_LABEL)
 		    && api_nh->type != NEXTHOP_TYPE_IFINDEX
 		    && api_nh->type != NEXTHOP_TYPE_BLACKHOLE) {
 			enum lsp_types_t label_type;
@@ -1522,17 +1527,17 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 		}
 	}
 
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_DISTANCE))
-		re->distance = api.distance;
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_METRIC))
-		re->metric = api.metric;
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_TAG))
-		re->tag = api.tag;
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_MTU))
-		re->mtu = api.mtu;
-
-	afi = family2afi(api.prefix.family);
-	if (afi != AFI_IP6 && CHECK_FLAG(api.message, ZAPI_MESSAGE_SRCPFX)) {
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_DISTANCE))
+		re->distance = api->distance;
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_METRIC))
+		re->metric = api->metric;
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_TAG))
+		re->tag = api->tag;
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_MTU))
+		re->mtu = api->mtu;
+
+	afi = family2afi(api->prefix.family);
+	if (afi != AFI_IP6 && CHECK_FLAG(api->message, ZAPI_MESSAGE_SRCPFX)) {
 		flog_warn(EC_ZEBRA_RX_SRCDEST_WRONG_AFI,
 			  "%s: Received SRC Prefix but afi is not v6",
 			  __PRETTY_FUNCTION__);
@@ -1540,13 +1545,13 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 		XFREE(MTYPE_RE, re);
 		return;
 	}
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_SRCPFX))
-		src_p = &api.src_prefix;
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_SRCPFX))
+		src_p = &api->src_prefix;
 
-	ret = rib_add_multipath(afi, api.safi, &api.prefix, src_p, re);
+	ret = rib_add_multipath(afi, api->safi, &api->prefix, src_p, re);
 
 	/* Stats */
-	switch (api.prefix.family) {
+	switch (api->prefix.family) {
 	case AF_INET:
 		if (ret > 0)
 			client->v4_route_add_cnt++;
@@ -1562,6 +1567,44 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 	}
 }
 
+
+static void zread_route_add(ZAPI_HANDLER_ARGS)
+{
+	struct zapi_route api;
+
+	if (zapi_route_decode(msg, &api) < 0) {
+		if (IS_ZEBRA_DEBUG_RECV)
+			zlog_debug("%s: Unable to decode zapi_route sent",
+				   __PRETTY_FUNCTION__);
+		return;
+	}
+
+	zapi_route_install(client, zvrf, &api);
+}
+
+static void zread_route_add_bulk(ZAPI_HANDLER_ARGS)
+{
+	struct zapi_route api;
+	struct prefix prefixes[ZAPI_BULK_ROUTES_MAX];
+	uint16_t prefix_num;
+	uint16_t i;
+
+	if (zapi_route_decode_bulk(msg, &api, prefixes, &prefix_num) < 0) {
+		if (IS_ZEBRA_DEBUG_RECV)
+			zlog_debug("%s: Unable to decode bulk zapi_route sent",
+				   __PRETTY_FUNCTION__);
+		return;
+	}
+
+	/* The template itself carries the first prefix. */
+	zapi_route_install(client, zvrf, &api);
+
+	for (i = 0; i < prefix_num; i++) {
+		api.prefix = prefixes[i];
+		zapi_route_install(client, zvrf, &api);
+	}
+}
+
 static void zread_route_del(ZAPI_HANDLER_ARGS)
 {
 	struct stream *s;
@@ -1688,6 +1731,10 @@ static void zread_hello(ZAPI_HANDLER_ARGS)
 
 		client->proto = proto;
 		client->instance = instance;
+		client->msg_weight = zserv_get_client_weight(proto);
+		atomic_store_explicit(&client->recv_pps,
+				      zserv_get_client_ratelimit(proto),
+				      memory_order_relaxed);
 	}
 
 	zsend_capabilities(client, zvrf);
@@ -2400,12 +2447,58 @@ stream_failure:
 	return;
 }
 
+/* Shared string intern table, created when the first client asks for it.
+ * Lives for the rest of zebra's lifetime; clients map it read-only and
+ * send ZEBRA_SHM_STRTAB_ADD for strings they want interned. */
+static struct shstrtab *zebra_strtab;
+
+static void zread_shm_strtab_get(ZAPI_HANDLER_ARGS)
+{
+	struct stream *s;
+
+	if (!zebra_strtab)
+		zebra_strtab = shstrtab_create(SHSTRTAB_DEFAULT_NAME,
+					       SHSTRTAB_DEFAULT_SIZE);
+	if (!zebra_strtab)
+		return;
+
+	s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	zclient_create_header(s, ZEBRA_SHM_STRTAB_GET, VRF_DEFAULT);
+	stream_putw(s, strlen(SHSTRTAB_DEFAULT_NAME));
+	stream_put(s, SHSTRTAB_DEFAULT_NAME, strlen(SHSTRTAB_DEFAULT_NAME));
+	stream_putw_at(s, 0, stream_get_endp(s));
+	zserv_send_message(client, s);
+}
+
+static void zread_shm_strtab_add(ZAPI_HANDLER_ARGS)
+{
+	struct stream *s = msg;
+	char buf[ZEBRA_MAX_PACKET_SIZ];
+	uint16_t len;
+
+	if (!zebra_strtab)
+		return;
+
+	STREAM_GETW(s, len);
+	if (len == 0 || len >= sizeof(buf))
+		return;
+	STREAM_GET(buf, s, len);
+	buf[len] = '\0';
+
+	/* a full table is not an error; clients keep their local copies */
+	shstrtab_insert(zebra_strtab, buf);
+
+stream_failure:
+	return;
+}
+
 void (*zserv_handlers[])(ZAPI_HANDLER_ARGS) = {
 	[ZEBRA_ROUTER_ID_ADD] = zread_router_id_add,
 	[ZEBRA_ROUTER_ID_DELETE] = zread_router_id_delete,
 	[ZEBRA_INTERFACE_ADD] = zread_interface_add,
 	[ZEBRA_INTERFACE_DELETE] = zread_interface_delete,
 	[ZEBRA_ROUTE_ADD] = zread_route_add,
+	[ZEBRA_ROUTE_ADD_BULK] = zread_route_add_bulk,
 	[ZEBRA_ROUTE_DELETE] = zread_route_del,
 	[ZEBRA_REDISTRIBUTE_ADD] = zebra_redistribute_add,
 	[ZEBRA_REDISTRIBUTE_DELETE] = zebra_redistribute_delete,
@@ -2468,6 +2561,8 @@ void (*zserv_handlers[])(ZAPI_HANDLER_ARGS) = {
 	[ZEBRA_IPTABLE_ADD] = zread_iptable,
 	[ZEBRA_IPTABLE_DELETE] = zread_iptable,
 	[ZEBRA_VXLAN_FLOOD_CONTROL] = zebra_vxlan_flood_control,
+	[ZEBRA_SHM_STRTAB_GET] = zread_shm_strtab_get,
+	[ZEBRA_SHM_STRTAB_ADD] = zread_shm_strtab_add,
 };
 
 #if defined(HANDLE_ZAPI_FUZZING)
@@ -28,7 +28,9 @@
 #include "zebra/zebra_memory.h"
 #include "zebra/zebra_router.h"
 #include "zebra/zebra_dplane.h"
+#include "zebra/zebra_nhg.h"
 #include "zebra/rt.h"
+#include "zebra/zebra_pbr.h"
 #include "zebra/debug.h"
 
 /* Memory type for context blocks */
@@ -94,6 +96,9 @@ struct dplane_route_info {
 	/* Nexthops */
 	struct nexthop_group zd_ng;
 
+	/* Kernel nexthop-group object id covering zd_ng, or 0 */
+	uint32_t zd_nhg_id;
+
 	/* "Previous" nexthops, used only in route updates without netlink */
 	struct nexthop_group zd_old_ng;
 
@@ -154,11 +159,19 @@ struct zebra_dplane_ctx {
 		struct dplane_route_info rinfo;
 		zebra_lsp_t lsp;
 		struct dplane_pw_info pw;
+		struct zebra_pbr_rule rule;
 	} u;
 
 	/* Namespace info, used especially for netlink kernel communication */
 	struct zebra_dplane_info zd_ns_info;
 
+	/* Stage timestamps (CLOCK_MONOTONIC, nanoseconds) feeding the
+	 * per-stage latency statistics; see dplane_stat_record().
+	 */
+	uint64_t zd_ns_init;
+	uint64_t zd_ns_dequeue;
+	uint64_t zd_ns_kernel_done;
+
 	/* Embedded list linkage */
 	TAILQ_ENTRY(zebra_dplane_ctx) zd_q_entries;
 };
@@ -231,9 +244,21 @@ static struct zebra_dplane_globals {
 	/* Sentinel for end of shutdown */
 	volatile bool dg_run;
 
+	/* Null mode: contexts are marked skip-kernel at init, so updates
+	 * run the whole pipeline without touching the fib; used by the
+	 * rib load harness (zebra_rib_dt.c)
+	 */
+	bool dg_null_mode;
+
 	/* Route-update context queue inbound to the dataplane */
 	TAILQ_HEAD(zdg_ctx_q, zebra_dplane_ctx) dg_route_ctx_q;
 
+	/* LSP-update context queue inbound to the dataplane. Label
+	 * updates have their own queue so that label programming is not
+	 * delayed behind a large backlog of route updates.
+	 */
+	TAILQ_HEAD(zdg_lsp_q, zebra_dplane_ctx) dg_lsp_ctx_q;
+
 	/* Ordered list of providers */
 	TAILQ_HEAD(zdg_prov_q, zebra_dplane_provider) dg_providers_q;
 
@@ -246,7 +271,7 @@ static struct zebra_dplane_globals {
 	/* Limit number of new updates dequeued at once, to pace an
 	 * incoming burst.
 	 */
-	uint32_t dg_updates_per_cycle;
+	_Atomic uint32_t dg_updates_per_cycle;
 
 	_Atomic uint32_t dg_routes_in;
 	_Atomic uint32_t dg_routes_queued;
@@ -260,6 +285,9 @@ static struct zebra_dplane_globals {
 	_Atomic uint32_t dg_pws_in;
 	_Atomic uint32_t dg_pw_errors;
 
+	_Atomic uint32_t dg_rules_in;
+	_Atomic uint32_t dg_rule_errors;
+
 	_Atomic uint32_t dg_update_yields;
 
 	/* Dataplane pthread */
@@ -297,6 +325,72 @@ static enum zebra_dplane_result lsp_update_internal(zebra_lsp_t *lsp,
 						    enum dplane_op_e op);
 static enum zebra_dplane_result pw_update_internal(struct zebra_pw *pw,
 						   enum dplane_op_e op);
+static enum zebra_dplane_result rule_update_internal(
+	struct zebra_pbr_rule *rule, enum dplane_op_e op);
+
+/*
+ * Always-on per-stage latency statistics.  Updates are sampled as a
+ * context moves through the pipeline: time spent queued before the
+ * kernel provider dequeues it, time spent in the kernel-facing apis,
+ * and time until the finished context is consumed and freed on the
+ * main pthread.  Samples land in power-of-two nanosecond buckets, so
+ * the cost per sample is a clock read and a few relaxed atomics.
+ */
+#define DPLANE_STAT_BUCKETS 24
+
+struct dplane_stage_stats {
+	_Atomic uint64_t count;
+	_Atomic uint64_t total_ns;
+	_Atomic uint64_t max_ns;
+	_Atomic uint64_t buckets[DPLANE_STAT_BUCKETS];
+};
+
+static struct dplane_stage_stats dplane_stat_queue;
+static struct dplane_stage_stats dplane_stat_kernel;
+static struct dplane_stage_stats dplane_stat_result;
+
+static uint64_t dplane_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void dplane_stat_record(struct dplane_stage_stats *st, uint64_t ns)
+{
+	uint64_t max;
+	int bucket = 0;
+
+	atomic_fetch_add_explicit(&st->count, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&st->total_ns, ns, memory_order_relaxed);
+
+	max = atomic_load_explicit(&st->max_ns, memory_order_relaxed);
+	while (ns > max
+	       && !atomic_compare_exchange_weak_explicit(&st->max_ns, &max, ns,
+							 memory_order_relaxed,
+							 memory_order_relaxed))
+		;
+
+	/* Bucket 0 is < 1us; each following bucket doubles the bound. */
+	while (bucket < DPLANE_STAT_BUCKETS - 1 && ns >= (1000ULL << bucket))
+		bucket++;
+
+	atomic_fetch_add_explicit(&st->buckets[bucket], 1,
+				  memory_order_relaxed);
+}
+
+/* Render a nanosecond bucket bound compactly for the stats display. */
+static void dplane_stat_bound_str(uint64_t ns, char *buf, size_t len)
+{
+	if (ns < 1000000ULL)
+		snprintf(buf, len, "%" PRIu64 "us", ns / 1000);
+	else if (ns < 1000000000ULL)
+		snprintf(buf, len, "%" PRIu64 "ms", ns / 1000000);
+	else
+		snprintf(buf, len, "%" PRIu64 "s", ns / 1000000000);
+}
 
 /*
  * Public APIs
@@ -320,6 +414,8 @@ static struct zebra_dplane_ctx *dplane_ctx_alloc(void)
 	 */
 	p = XCALLOC(MTYPE_DP_CTX, sizeof(struct zebra_dplane_ctx));
 
+	p->zd_ns_init = dplane_clock_ns();
+
 	return p;
 }
 
@@ -333,6 +429,15 @@ static void dplane_ctx_free(struct zebra_dplane_ctx **pctx)
 
 	DPLANE_CTX_VALID(*pctx);
 
+	/* Contexts that went through the kernel provider contribute a
+	 * result-delivery sample: the time from kernel completion until
+	 * the consumer finished with the context.
+	 */
+	if ((*pctx)->zd_ns_kernel_done)
+		dplane_stat_record(&dplane_stat_result,
+				   dplane_clock_ns()
+					   - (*pctx)->zd_ns_kernel_done);
+
 	/* TODO -- just freeing memory, but would like to maintain
 	 * a pool
 	 */
@@ -386,6 +491,8 @@ static void dplane_ctx_free(struct zebra_dplane_ctx **pctx)
 
 	case DPLANE_OP_PW_INSTALL:
 	case DPLANE_OP_PW_UNINSTALL:
+	case DPLANE_OP_RULE_ADD:
+	case DPLANE_OP_RULE_DELETE:
 	case DPLANE_OP_NONE:
 		break;
 	}
@@ -520,6 +627,13 @@ const char *dplane_op2str(enum dplane_op_e op)
 		ret = "PW_UNINSTALL";
 		break;
 
+	case DPLANE_OP_RULE_ADD:
+		ret = "RULE_ADD";
+		break;
+	case DPLANE_OP_RULE_DELETE:
+		ret = "RULE_DELETE";
+		break;
+
 	}
 
 	return ret;
@@ -705,6 +819,13 @@ const struct nexthop_group *dplane_ctx_get_ng(
 	return &(ctx->u.rinfo.zd_ng);
 }
 
+uint32_t dplane_ctx_get_nhg_id(const struct zebra_dplane_ctx *ctx)
+{
+	DPLANE_CTX_VALID(ctx);
+
+	return ctx->u.rinfo.zd_nhg_id;
+}
+
 const struct nexthop_group *dplane_ctx_get_old_ng(
 	const struct zebra_dplane_ctx *ctx)
 {
@@ -830,6 +951,14 @@ const union pw_protocol_fields *dplane_ctx_get_pw_proto(
 	return &(ctx->u.pw.fields);
 }
 
+/* Accessor for PBR rule information */
+struct zebra_pbr_rule *dplane_ctx_get_rule(const struct zebra_dplane_ctx *ctx)
+{
+	DPLANE_CTX_VALID(ctx);
+
+	return (struct zebra_pbr_rule *)&(ctx->u.rule);
+}
+
 /*
  * End of dplane context accessors
  */
@@ -857,6 +986,29 @@ void dplane_set_in_queue_limit(uint32_t limit, bool set)
 			      memory_order_relaxed);
 }
 
+/*
+ * Retrieve the number of updates the dplane pthread dequeues per cycle.
+ */
+uint32_t dplane_get_update_batch(void)
+{
+	return atomic_load_explicit(&zdplane_info.dg_updates_per_cycle,
+				    memory_order_relaxed);
+}
+
+/*
+ * Configure the number of updates dequeued per dplane cycle; this paces
+ * work toward the providers during an incoming burst.
+ */
+void dplane_set_update_batch(uint32_t batch, bool set)
+{
+	/* Reset to default on 'unset' */
+	if (!set)
+		batch = DPLANE_DEFAULT_NEW_WORK;
+
+	atomic_store_explicit(&zdplane_info.dg_updates_per_cycle, batch,
+			      memory_order_relaxed);
+}
+
 /*
  * Retrieve the current queue depth of incoming, unprocessed updates
  */
@@ -910,6 +1062,13 @@ static int dplane_ctx_route_init(struct zebra_dplane_ctx *ctx,
 	ctx->zd_op = op;
 	ctx->zd_status = ZEBRA_DPLANE_REQUEST_SUCCESS;
 
+	/* Reconciled routes already match the kernel; skip programming
+	 * but run the normal result path.  Null mode skips everything.
+	 */
+	if (zdplane_info.dg_null_mode
+	    || CHECK_FLAG(re->status, ROUTE_ENTRY_RECONCILED))
+		dplane_ctx_set_skip_kernel(ctx);
+
 	ctx->u.rinfo.zd_type = re->type;
 	ctx->u.rinfo.zd_old_type = re->type;
 
@@ -956,6 +1115,13 @@ static int dplane_ctx_route_init(struct zebra_dplane_ctx *ctx,
 	for (ALL_NEXTHOPS(ctx->u.rinfo.zd_ng, nexthop))
 		UNSET_FLAG(nexthop->flags, NEXTHOP_FLAG_FIB);
 
+	/* Resolve a kernel nexthop-group object id on the main pthread,
+	 * while the route's nexthops are still authoritative.
+	 */
+	if (op != DPLANE_OP_ROUTE_DELETE)
+		ctx->u.rinfo.zd_nhg_id =
+			zebra_nhg_get_id(&(ctx->u.rinfo.zd_ng), re->vrf_id);
+
 	/* Trying out the sequence number idea, so we can try to detect
 	 * when a result is stale.
 	 */
@@ -1071,6 +1237,33 @@ static int dplane_ctx_pw_init(struct zebra_dplane_ctx *ctx,
 	return AOK;
 }
 
+/*
+ * Capture information for a PBR rule update in a dplane context.
+ */
+static int dplane_ctx_rule_init(struct zebra_dplane_ctx *ctx,
+				enum dplane_op_e op,
+				struct zebra_pbr_rule *rule)
+{
+	if (IS_ZEBRA_DEBUG_DPLANE_DETAIL)
+		zlog_debug("init dplane ctx %s: rule seq %u pri %u unique %u",
+			   dplane_op2str(op), rule->rule.seq,
+			   rule->rule.priority, rule->rule.unique);
+
+	ctx->zd_op = op;
+	ctx->zd_status = ZEBRA_DPLANE_REQUEST_SUCCESS;
+
+	/* Capture namespace info */
+	dplane_ctx_ns_init(ctx, zebra_ns_lookup(NS_DEFAULT), false);
+
+	/* The context takes a flat copy of the rule, so the caller's
+	 * struct may be freed as soon as we've been enqueued.
+	 */
+	ctx->u.rule = *rule;
+	ctx->zd_vrf_id = rule->vrf_id;
+
+	return AOK;
+}
+
 /*
  * Enqueue a new route update,
  * and ensure an event is active for the dataplane pthread.
@@ -1117,6 +1310,24 @@ static int dplane_route_enqueue(struct zebra_dplane_ctx *ctx)
 	return ret;
 }
 
+/*
+ * Enqueue a new LSP update on the dedicated LSP queue,
+ * and ensure an event is active for the dataplane pthread.
+ */
+static int dplane_lsp_enqueue(struct zebra_dplane_ctx *ctx)
+{
+	/* Enqueue for processing by the dataplane pthread */
+	DPLANE_LOCK();
+	{
+		TAILQ_INSERT_TAIL(&zdplane_info.dg_lsp_ctx_q, ctx,
+				  zd_q_entries);
+	}
+	DPLANE_UNLOCK();
+
+	/* Ensure that an event for the dataplane thread is active */
+	return dplane_provider_work_ready();
+}
+
 /*
  * Utility that prepares a route update and enqueues it for processing
  */
@@ -1290,6 +1501,22 @@ enum zebra_dplane_result dplane_pw_uninstall(struct zebra_pw *pw)
 	return pw_update_internal(pw, DPLANE_OP_PW_UNINSTALL);
 }
 
+/*
+ * Enqueue PBR rule install for the dataplane.
+ */
+enum zebra_dplane_result dplane_pbr_rule_add(struct zebra_pbr_rule *rule)
+{
+	return rule_update_internal(rule, DPLANE_OP_RULE_ADD);
+}
+
+/*
+ * Enqueue PBR rule removal for the dataplane.
+ */
+enum zebra_dplane_result dplane_pbr_rule_delete(struct zebra_pbr_rule *rule)
+{
+	return rule_update_internal(rule, DPLANE_OP_RULE_DELETE);
+}
+
 /*
  * Common internal LSP update utility
  */
@@ -1311,7 +1538,7 @@ static enum zebra_dplane_result lsp_update_internal(zebra_lsp_t *lsp,
 	if (ret != AOK)
 		goto done;
 
-	ret = dplane_route_enqueue(ctx);
+	ret = dplane_lsp_enqueue(ctx);
 
 done:
 	/* Update counter */
@@ -1369,6 +1596,45 @@ done:
 	return result;
 }
 
+/*
+ * Internal, common handler for PBR rule updates.
+ */
+static enum zebra_dplane_result rule_update_internal(
+	struct zebra_pbr_rule *rule, enum dplane_op_e op)
+{
+	enum zebra_dplane_result result = ZEBRA_DPLANE_REQUEST_FAILURE;
+	int ret;
+	struct zebra_dplane_ctx *ctx = NULL;
+
+	ctx = dplane_ctx_alloc();
+	if (ctx == NULL) {
+		ret = ENOMEM;
+		goto done;
+	}
+
+	ret = dplane_ctx_rule_init(ctx, op, rule);
+	if (ret != AOK)
+		goto done;
+
+	ret = dplane_route_enqueue(ctx);
+
+done:
+	/* Update counter */
+	atomic_fetch_add_explicit(&zdplane_info.dg_rules_in, 1,
+				  memory_order_relaxed);
+
+	if (ret == AOK)
+		result = ZEBRA_DPLANE_REQUEST_QUEUED;
+	else {
+		atomic_fetch_add_explicit(&zdplane_info.dg_rule_errors, 1,
+					  memory_order_relaxed);
+		if (ctx)
+			dplane_ctx_free(&ctx);
+	}
+
+	return result;
+}
+
 /*
  * Handler for 'show dplane'
  */
@@ -1400,6 +1666,8 @@ int dplane_show_helper(struct vty *vty, bool detailed)
 	vty_out(vty, "Route update errors:      %"PRIu64"\n", errs);
 	vty_out(vty, "Other errors       :      %"PRIu64"\n", other_errs);
 	vty_out(vty, "Route update queue limit: %"PRIu64"\n", limit);
+	vty_out(vty, "Route update batch size:  %u\n",
+		dplane_get_update_batch());
 	vty_out(vty, "Route update queue depth: %"PRIu64"\n", queued);
 	vty_out(vty, "Route update queue max:   %"PRIu64"\n", queue_max);
 	vty_out(vty, "Dplane update yields:      %"PRIu64"\n", yields);
@@ -1407,6 +1675,67 @@ int dplane_show_helper(struct vty *vty, bool detailed)
 	return CMD_SUCCESS;
 }
 
+/*
+ * Handler for 'show dplane stats'
+ */
+int dplane_show_stats_helper(struct vty *vty)
+{
+	struct dplane_stage_stats *stages[] = {&dplane_stat_queue,
+					       &dplane_stat_kernel,
+					       &dplane_stat_result};
+	const char *stage_names[] = {"Queue wait", "Kernel update",
+				     "Result delivery"};
+	char lo[32], hi[32];
+	uint64_t count, total, max, samples;
+	unsigned int i;
+	int b;
+
+	vty_out(vty, "Zebra dataplane stage latency:\n");
+
+	for (i = 0; i < array_size(stages); i++) {
+		count = atomic_load_explicit(&stages[i]->count,
+					     memory_order_relaxed);
+		total = atomic_load_explicit(&stages[i]->total_ns,
+					     memory_order_relaxed);
+		max = atomic_load_explicit(&stages[i]->max_ns,
+					   memory_order_relaxed);
+
+		vty_out(vty, "\n%s:\n", stage_names[i]);
+		vty_out(vty, "  Samples:     %" PRIu64 "\n", count);
+		if (count == 0)
+			continue;
+
+		vty_out(vty, "  Average:     %" PRIu64 " usec\n",
+			total / count / 1000);
+		vty_out(vty, "  Maximum:     %" PRIu64 " usec\n", max / 1000);
+
+		for (b = 0; b < DPLANE_STAT_BUCKETS; b++) {
+			samples = atomic_load_explicit(&stages[i]->buckets[b],
+						       memory_order_relaxed);
+			if (samples == 0)
+				continue;
+
+			dplane_stat_bound_str(1000ULL << b, hi, sizeof(hi));
+			if (b == 0)
+				vty_out(vty, "  <  %8s:  %" PRIu64 "\n", hi,
+					samples);
+			else if (b == DPLANE_STAT_BUCKETS - 1) {
+				dplane_stat_bound_str(1000ULL << (b - 1), lo,
+						      sizeof(lo));
+				vty_out(vty, "  >= %8s:  %" PRIu64 "\n", lo,
+					samples);
+			} else {
+				dplane_stat_bound_str(1000ULL << (b - 1), lo,
+						      sizeof(lo));
+				vty_out(vty, "  %4s - %5s:  %" PRIu64 "\n", lo,
+					hi, samples);
+			}
+		}
+	}
+
+	return CMD_SUCCESS;
+}
+
 /*
  * Handler for 'show dplane providers'
  */
@@ -1539,7 +1868,7 @@ void *dplane_provider_get_data(const struct zebra_dplane_provider *prov)
 
 int dplane_provider_get_work_limit(const struct zebra_dplane_provider *prov)
 {
-	return zdplane_info.dg_updates_per_cycle;
+	return dplane_get_update_batch();
 }
 
 /* Lock/unlock a provider's mutex - iff the provider was registered with
@@ -1589,7 +1918,7 @@ int dplane_provider_dequeue_in_list(struct zebra_dplane_provider *prov,
 	int limit, ret;
 	struct zebra_dplane_ctx *ctx;
 
-	limit = zdplane_info.dg_updates_per_cycle;
+	limit = dplane_get_update_batch();
 
 	dplane_provider_lock(prov);
 
@@ -1722,6 +2051,33 @@ kernel_dplane_pw_update(struct zebra_dplane_ctx *ctx)
 	return res;
 }
 
+/*
+ * Handler for kernel PBR rule updates
+ */
+static enum zebra_dplane_result
+kernel_dplane_rule_update(struct zebra_dplane_ctx *ctx)
+{
+	enum zebra_dplane_result res;
+	struct zebra_pbr_rule *rule;
+
+	if (IS_ZEBRA_DEBUG_DPLANE_DETAIL) {
+		rule = dplane_ctx_get_rule(ctx);
+
+		zlog_debug("Dplane rule update ctx %p op %s pri %u unique %u",
+			   ctx, dplane_op2str(ctx->zd_op),
+			   rule->rule.priority, rule->rule.unique);
+	}
+
+	res = kernel_pbr_rule_update(ctx);
+
+	if (res != ZEBRA_DPLANE_REQUEST_SUCCESS)
+		atomic_fetch_add_explicit(
+			&zdplane_info.dg_rule_errors, 1,
+			memory_order_relaxed);
+
+	return res;
+}
+
 /*
  * Handler for kernel route updates
  */
@@ -1773,6 +2129,18 @@ static int kernel_dplane_process_func(struct zebra_dplane_provider *prov)
 		if (ctx == NULL)
 			break;
 
+		ctx->zd_ns_dequeue = dplane_clock_ns();
+		dplane_stat_record(&dplane_stat_queue,
+				   ctx->zd_ns_dequeue - ctx->zd_ns_init);
+
+		/* A provider ahead of us, or reconciliation, may have
+		 * decided that no kernel work is needed.
+		 */
+		if (dplane_ctx_is_skip_kernel(ctx)) {
+			res = ZEBRA_DPLANE_REQUEST_SUCCESS;
+			goto update_done;
+		}
+
 		/* Dispatch to appropriate kernel-facing apis */
 		switch (dplane_ctx_get_op(ctx)) {
 
@@ -1793,6 +2161,11 @@ static int kernel_dplane_process_func(struct zebra_dplane_provider *prov)
 			res = kernel_dplane_pw_update(ctx);
 			break;
 
+		case DPLANE_OP_RULE_ADD:
+		case DPLANE_OP_RULE_DELETE:
+			res = kernel_dplane_rule_update(ctx);
+			break;
+
 		default:
 			atomic_fetch_add_explicit(
 				&zdplane_info.dg_other_errors, 1,
@@ -1802,8 +2175,14 @@ static int kernel_dplane_process_func(struct zebra_dplane_provider *prov)
 			break;
 		}
 
+update_done:
 		dplane_ctx_set_status(ctx, res);
 
+		ctx->zd_ns_kernel_done = dplane_clock_ns();
+		dplane_stat_record(&dplane_stat_kernel,
+				   ctx->zd_ns_kernel_done
+					   - ctx->zd_ns_dequeue);
+
 		dplane_provider_enqueue_out_ctx(prov, ctx);
 	}
 
@@ -1918,6 +2297,20 @@ static void dplane_provider_init(void)
 #endif	/* DPLANE_TEST_PROVIDER */
 }
 
+/* Enable or disable null mode; new route contexts are marked
+ * skip-kernel so the pipeline runs end-to-end without programming the
+ * fib.  Main pthread only.
+ */
+void dplane_null_mode_set(bool enable)
+{
+	zdplane_info.dg_null_mode = enable;
+}
+
+bool dplane_null_mode_get(void)
+{
+	return zdplane_info.dg_null_mode;
+}
+
 /* Indicates zebra shutdown/exit is in progress. Some operations may be
  * simplified or skipped during shutdown processing.
  */
@@ -1958,7 +2351,9 @@ static bool dplane_work_pending(void)
 	 */
 	DPLANE_LOCK();
 	{
-		ctx = TAILQ_FIRST(&zdplane_info.dg_route_ctx_q);
+		ctx = TAILQ_FIRST(&zdplane_info.dg_lsp_ctx_q);
+		if (ctx == NULL)
+			ctx = TAILQ_FIRST(&zdplane_info.dg_route_ctx_q);
 		prov = TAILQ_FIRST(&zdplane_info.dg_providers_q);
 	}
 	DPLANE_UNLOCK();
@@ -2061,11 +2456,11 @@ static int dplane_thread_loop(struct thread *event)
 	struct dplane_ctx_q error_list;
 	struct zebra_dplane_provider *prov;
 	struct zebra_dplane_ctx *ctx, *tctx;
-	int limit, counter, error_counter;
+	int limit, counter, route_counter, error_counter;
 	uint64_t curr, high;
 
 	/* Capture work limit per cycle */
-	limit = zdplane_info.dg_updates_per_cycle;
+	limit = dplane_get_update_batch();
 
 	/* Init temporary lists used to move contexts among providers */
 	TAILQ_INIT(&work_list);
@@ -2084,25 +2479,35 @@ static int dplane_thread_loop(struct thread *event)
 	/* Locate initial registered provider */
 	prov = TAILQ_FIRST(&zdplane_info.dg_providers_q);
 
-	/* Move new work from incoming list to temp list */
+	/* Move new work from incoming lists to temp list. The LSP queue
+	 * is drained first so that label programming is serviced ahead
+	 * of any route-update backlog.
+	 */
+	route_counter = 0;
 	for (counter = 0; counter < limit; counter++) {
-		ctx = TAILQ_FIRST(&zdplane_info.dg_route_ctx_q);
+		ctx = TAILQ_FIRST(&zdplane_info.dg_lsp_ctx_q);
 		if (ctx) {
+			TAILQ_REMOVE(&zdplane_info.dg_lsp_ctx_q, ctx,
+				     zd_q_entries);
+		} else {
+			ctx = TAILQ_FIRST(&zdplane_info.dg_route_ctx_q);
+			if (ctx == NULL)
+				break;
+
 			TAILQ_REMOVE(&zdplane_info.dg_route_ctx_q, ctx,
 				     zd_q_entries);
+			route_counter++;
+		}
 
-			ctx->zd_provider = prov->dp_id;
+		ctx->zd_provider = prov->dp_id;
 
-			TAILQ_INSERT_TAIL(&work_list, ctx, zd_q_entries);
-		} else {
-			break;
-		}
+		TAILQ_INSERT_TAIL(&work_list, ctx, zd_q_entries);
 	}
 
 	DPLANE_UNLOCK();
 
-	atomic_fetch_sub_explicit(&zdplane_info.dg_routes_queued, counter,
-				  memory_order_relaxed);
+	atomic_fetch_sub_explicit(&zdplane_info.dg_routes_queued,
+				  route_counter, memory_order_relaxed);
 
 	if (IS_ZEBRA_DEBUG_DPLANE_DETAIL)
 		zlog_debug("dplane: incoming new work counter: %d", counter);
@@ -2275,6 +2680,7 @@ static void zebra_dplane_init_internal(void)
 	pthread_mutex_init(&zdplane_info.dg_mutex, NULL);
 
 	TAILQ_INIT(&zdplane_info.dg_route_ctx_q);
+	TAILQ_INIT(&zdplane_info.dg_lsp_ctx_q);
 	TAILQ_INIT(&zdplane_info.dg_providers_q);
 
 	zdplane_info.dg_updates_per_cycle = DPLANE_DEFAULT_NEW_WORK;
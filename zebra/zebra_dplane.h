@@ -110,8 +110,14 @@ enum dplane_op_e {
 	/* Pseudowire update */
 	DPLANE_OP_PW_INSTALL,
 	DPLANE_OP_PW_UNINSTALL,
+
+	/* PBR rule update */
+	DPLANE_OP_RULE_ADD,
+	DPLANE_OP_RULE_DELETE,
 };
 
+struct zebra_pbr_rule;
+
 /*
  * The dataplane context struct is used to exchange info between the main zebra
  * context and the dataplane module(s). If these are two independent pthreads,
@@ -198,6 +204,7 @@ const struct nexthop_group *dplane_ctx_get_ng(
 	const struct zebra_dplane_ctx *ctx);
 const struct nexthop_group *dplane_ctx_get_old_ng(
 	const struct zebra_dplane_ctx *ctx);
+uint32_t dplane_ctx_get_nhg_id(const struct zebra_dplane_ctx *ctx);
 
 /* Accessors for LSP information */
 mpls_label_t dplane_ctx_get_in_label(const struct zebra_dplane_ctx *ctx);
@@ -255,6 +262,15 @@ enum zebra_dplane_result dplane_lsp_delete(zebra_lsp_t *lsp);
 enum zebra_dplane_result dplane_pw_install(struct zebra_pw *pw);
 enum zebra_dplane_result dplane_pw_uninstall(struct zebra_pw *pw);
 
+/*
+ * Enqueue PBR rule operations for the dataplane.
+ */
+enum zebra_dplane_result dplane_pbr_rule_add(struct zebra_pbr_rule *rule);
+enum zebra_dplane_result dplane_pbr_rule_delete(struct zebra_pbr_rule *rule);
+
+/* Accessor for PBR rule information */
+struct zebra_pbr_rule *dplane_ctx_get_rule(const struct zebra_dplane_ctx *ctx);
+
 /* Retrieve the limit on the number of pending, unprocessed updates. */
 uint32_t dplane_get_in_queue_limit(void);
 
@@ -263,14 +279,29 @@ uint32_t dplane_get_in_queue_limit(void);
  */
 void dplane_set_in_queue_limit(uint32_t limit, bool set);
 
+/* Retrieve the number of updates dequeued per dplane work cycle. */
+uint32_t dplane_get_update_batch(void);
+
+/* Configure the per-cycle update batch size. If 'unset', reset to default
+ * value.
+ */
+void dplane_set_update_batch(uint32_t batch, bool set);
+
 /* Retrieve the current queue depth of incoming, unprocessed updates */
 uint32_t dplane_get_in_queue_len(void);
 
+/* Null mode: mark new route contexts skip-kernel so updates traverse
+ * the pipeline without programming the fib (rib load harness)
+ */
+void dplane_null_mode_set(bool enable);
+bool dplane_null_mode_get(void);
+
 /*
  * Vty/cli apis
  */
 int dplane_show_helper(struct vty *vty, bool detailed);
 int dplane_show_provs_helper(struct vty *vty, bool detailed);
+int dplane_show_stats_helper(struct vty *vty);
 
 
 /*
@@ -0,0 +1,363 @@
+/*
+ * Zebra persisted FIB state, used to reconcile kernel routes across
+ * a restart without reprogramming unchanged routes.
+ * Copyright (C) 2019
+ *
+ * This file is part of FRR.
+ *
+ * FRR is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * FRR is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FRR; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "lib/hash.h"
+#include "lib/jhash.h"
+#include "lib/libfrr.h"
+#include "lib/memory.h"
+#include "lib/prefix.h"
+#include "lib/srcdest_table.h"
+#include "lib/thread.h"
+#include "lib/vrf.h"
+
+#include "zebra/rib.h"
+#include "zebra/zebra_fib_state.h"
+#include "zebra/zebra_memory.h"
+#include "zebra/zebra_router.h"
+#include "zebra/zebra_vrf.h"
+
+DEFINE_MTYPE_STATIC(ZEBRA, FIB_STATE, "Persisted FIB state")
+
+#define FIB_STATE_MAGIC 0x5a464953 /* 'ZFIS' */
+#define FIB_STATE_VERSION 1
+
+/* On-disk file layout: header followed by 'count' records */
+struct fib_state_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+};
+
+struct fib_state_rec {
+	vrf_id_t vrf_id;
+	uint8_t type;
+	uint8_t distance;
+	uint16_t instance;
+	uint32_t metric;
+
+	/* Signature over the route's nexthop group */
+	uint32_t nh_sig;
+
+	struct prefix prefix;
+	struct prefix src_prefix;
+};
+
+/* Loaded records, keyed by vrf and prefixes; consumed on match */
+static struct hash *fib_state_hash;
+static struct thread *t_fib_state_flush;
+
+static void fib_state_path(char *buf, size_t len)
+{
+	snprintf(buf, len, "%s/%s", frr_vtydir, ZEBRA_FIB_STATE_FILE);
+}
+
+/*
+ * Order-sensitive signature over a route's nexthops; both the save and
+ * the check sides run it on the same route_entry nexthop list.
+ */
+static uint32_t fib_state_nh_sig(struct route_entry *re)
+{
+	struct nexthop *nexthop;
+	uint32_t sig = 0;
+
+	for (ALL_NEXTHOPS(re->ng, nexthop)) {
+		sig = jhash_3words(nexthop->type, nexthop->vrf_id,
+				   nexthop->ifindex, sig);
+		sig = jhash(&nexthop->gate, sizeof(nexthop->gate), sig);
+	}
+
+	return sig;
+}
+
+static void fib_state_rec_from_route(struct fib_state_rec *rec,
+				     struct route_node *rn,
+				     struct route_entry *re)
+{
+	const struct prefix *p, *src_p;
+
+	srcdest_rnode_prefixes(rn, &p, &src_p);
+
+	memset(rec, 0, sizeof(*rec));
+	rec->vrf_id = re->vrf_id;
+	rec->type = re->type;
+	rec->instance = re->instance;
+	rec->distance = re->distance;
+	rec->metric = re->metric;
+	rec->nh_sig = fib_state_nh_sig(re);
+	prefix_copy(&rec->prefix, p);
+	if (src_p)
+		prefix_copy(&rec->src_prefix, src_p);
+}
+
+static unsigned int fib_state_hash_key(void *p)
+{
+	struct fib_state_rec *rec = p;
+
+	return jhash_2words(prefix_hash_key(&rec->prefix),
+			    prefix_hash_key(&rec->src_prefix),
+			    rec->vrf_id);
+}
+
+static bool fib_state_hash_equal(const void *p1, const void *p2)
+{
+	const struct fib_state_rec *r1 = p1, *r2 = p2;
+
+	if (r1->vrf_id != r2->vrf_id)
+		return false;
+	if (!prefix_same(&r1->prefix, &r2->prefix))
+		return false;
+	if (r1->src_prefix.family != r2->src_prefix.family)
+		return false;
+	if (r1->src_prefix.family
+	    && !prefix_same(&r1->src_prefix, &r2->src_prefix))
+		return false;
+
+	return true;
+}
+
+static void fib_state_rec_free(void *p)
+{
+	XFREE(MTYPE_FIB_STATE, p);
+}
+
+/*
+ * Walk the installed unicast routes; with a NULL cursor just count
+ * them, otherwise emit a record per route at the cursor.
+ */
+static uint32_t fib_state_walk(struct fib_state_rec *cursor)
+{
+	struct vrf *vrf;
+	struct zebra_vrf *zvrf;
+	struct route_table *table;
+	struct route_node *rn;
+	rib_dest_t *dest;
+	struct route_entry *re;
+	uint32_t count = 0;
+	afi_t afi;
+
+	RB_FOREACH (vrf, vrf_id_head, &vrfs_by_id) {
+		zvrf = vrf->info;
+		if (!zvrf)
+			continue;
+
+		for (afi = AFI_IP; afi <= AFI_IP6; afi++) {
+			table = zvrf->table[afi][SAFI_UNICAST];
+			if (!table)
+				continue;
+
+			for (rn = route_top(table); rn;
+			     rn = srcdest_route_next(rn)) {
+				dest = rib_dest_from_rnode(rn);
+				re = dest ? dest->selected_fib : NULL;
+				if (!re
+				    || !CHECK_FLAG(re->status,
+						   ROUTE_ENTRY_INSTALLED))
+					continue;
+
+				if (cursor)
+					fib_state_rec_from_route(
+						&cursor[count], rn, re);
+				count++;
+			}
+		}
+	}
+
+	return count;
+}
+
+void zebra_fib_state_save(void)
+{
+	char path[MAXPATHLEN];
+	struct fib_state_hdr *hdr;
+	uint32_t count;
+	size_t len;
+	void *base;
+	int fd;
+
+	fib_state_path(path, sizeof(path));
+
+	count = fib_state_walk(NULL);
+	if (count == 0) {
+		unlink(path);
+		return;
+	}
+
+	len = sizeof(struct fib_state_hdr)
+	      + (size_t)count * sizeof(struct fib_state_rec);
+
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		zlog_warn("%s: can't open %s: %s", __func__, path,
+			  safe_strerror(errno));
+		return;
+	}
+	if (ftruncate(fd, len) != 0) {
+		zlog_warn("%s: can't size %s: %s", __func__, path,
+			  safe_strerror(errno));
+		close(fd);
+		unlink(path);
+		return;
+	}
+
+	base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		zlog_warn("%s: can't mmap %s: %s", __func__, path,
+			  safe_strerror(errno));
+		close(fd);
+		unlink(path);
+		return;
+	}
+
+	hdr = base;
+	hdr->magic = FIB_STATE_MAGIC;
+	hdr->version = FIB_STATE_VERSION;
+	hdr->count = count;
+
+	fib_state_walk((struct fib_state_rec *)(hdr + 1));
+
+	msync(base, len, MS_SYNC);
+	munmap(base, len);
+	close(fd);
+
+	zlog_info("Persisted %u installed routes to %s", count, path);
+}
+
+/*
+ * Holddown expired: drop whatever state was not matched and sweep the
+ * self-originated kernel routes that nobody reclaimed.
+ */
+static int fib_state_flush_timer(struct thread *thread)
+{
+	unsigned long leftovers = hashcount(fib_state_hash);
+
+	hash_clean(fib_state_hash, fib_state_rec_free);
+	hash_free(fib_state_hash);
+	fib_state_hash = NULL;
+
+	zlog_info("FIB state holddown expired, %lu unclaimed routes",
+		  leftovers);
+
+	rib_sweep_route();
+
+	return 0;
+}
+
+void zebra_fib_state_init(void)
+{
+	char path[MAXPATHLEN];
+	struct fib_state_hdr *hdr;
+	struct fib_state_rec *recs, *rec;
+	struct stat st;
+	size_t len;
+	void *base;
+	uint32_t i;
+	int fd;
+
+	fib_state_path(path, sizeof(path));
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return;
+
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(*hdr)) {
+		close(fd);
+		unlink(path);
+		return;
+	}
+
+	len = st.st_size;
+	base = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		unlink(path);
+		return;
+	}
+
+	hdr = base;
+	if (hdr->magic != FIB_STATE_MAGIC || hdr->version != FIB_STATE_VERSION
+	    || len < sizeof(*hdr) + (size_t)hdr->count * sizeof(*rec)) {
+		zlog_warn("%s: ignoring malformed state file %s", __func__,
+			  path);
+		munmap(base, len);
+		unlink(path);
+		return;
+	}
+
+	fib_state_hash = hash_create_size(1024, fib_state_hash_key,
+					  fib_state_hash_equal,
+					  "Persisted FIB state");
+
+	recs = (struct fib_state_rec *)(hdr + 1);
+	for (i = 0; i < hdr->count; i++) {
+		rec = XCALLOC(MTYPE_FIB_STATE, sizeof(*rec));
+		memcpy(rec, &recs[i], sizeof(*rec));
+		(void)hash_get(fib_state_hash, rec, hash_alloc_intern);
+	}
+
+	munmap(base, len);
+	unlink(path);
+
+	zlog_info("Loaded %u persisted routes for FIB reconciliation",
+		  hdr->count);
+
+	/* The state file is one-shot; sweep leftovers after holddown */
+	thread_add_timer(zrouter.master, fib_state_flush_timer, NULL,
+			 ZEBRA_FIB_STATE_HOLDDOWN, &t_fib_state_flush);
+}
+
+bool zebra_fib_state_present(void)
+{
+	return fib_state_hash != NULL;
+}
+
+bool zebra_fib_state_check(struct route_node *rn, struct route_entry *re)
+{
+	struct fib_state_rec lookup, *rec;
+
+	if (!fib_state_hash)
+		return false;
+
+	fib_state_rec_from_route(&lookup, rn, re);
+
+	rec = hash_lookup(fib_state_hash, &lookup);
+	if (!rec)
+		return false;
+
+	if (rec->type != lookup.type || rec->instance != lookup.instance
+	    || rec->distance != lookup.distance
+	    || rec->metric != lookup.metric
+	    || rec->nh_sig != lookup.nh_sig)
+		return false;
+
+	/* Matches are consumed so later updates program normally */
+	hash_release(fib_state_hash, rec);
+	fib_state_rec_free(rec);
+
+	return true;
+}
@@ -0,0 +1,60 @@
+/*
+ * Zebra persisted FIB state, used to reconcile kernel routes across
+ * a restart without reprogramming unchanged routes.
+ * Copyright (C) 2019
+ *
+ * This file is part of FRR.
+ *
+ * FRR is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * FRR is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FRR; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_FIB_STATE_H
+#define _ZEBRA_FIB_STATE_H
+
+#include "zebra/rib.h"
+
+/* State file, kept in the runtime directory next to the vty sockets */
+#define ZEBRA_FIB_STATE_FILE "zebra_fib_state"
+
+/* How long loaded state is honored before leftovers are swept, secs */
+#define ZEBRA_FIB_STATE_HOLDDOWN 90
+
+/*
+ * Load persisted state left by the previous run, if any, and arm the
+ * holddown timer that flushes it and sweeps stale kernel routes.
+ */
+extern void zebra_fib_state_init(void);
+
+/*
+ * Whether persisted state was loaded and is still being honored; while
+ * true the startup route sweep is deferred to the holddown expiry.
+ */
+extern bool zebra_fib_state_present(void);
+
+/*
+ * Persist the installed routes to the state file; called at shutdown
+ * when routes are being retained in the kernel.
+ */
+extern void zebra_fib_state_save(void);
+
+/*
+ * Check whether the persisted pre-restart state matches this route
+ * exactly; a successful match is consumed.
+ */
+extern bool zebra_fib_state_check(struct route_node *rn,
+				  struct route_entry *re);
+
+#endif /* _ZEBRA_FIB_STATE_H */
@@ -30,6 +30,10 @@
 #include "network.h"
 #include "command.h"
 #include "version.h"
+#include "frr_pthread.h"
+#include "frratomic.h"
+#include "memory.h"
+#include "zebra_memory.h"
 
 #include "zebra/rib.h"
 #include "zebra/zserv.h"
@@ -40,6 +44,8 @@
 #include "fpm/fpm.h"
 #include "zebra_fpm_private.h"
 
+DEFINE_MTYPE_STATIC(ZEBRA, FPM_RING, "FPM output ring")
+
 /*
  * Interval at which we attempt to connect to the FPM.
  */
@@ -49,12 +55,19 @@
  * Sizes of outgoing and incoming stream buffers for writing/reading
  * FPM messages.
  */
-#define ZFPM_OBUF_SIZE (2 * FPM_MAX_MSG_LEN)
 #define ZFPM_IBUF_SIZE (FPM_MAX_MSG_LEN)
 
 /*
- * The maximum number of times the FPM socket write callback can call
- * 'write' before it yields.
+ * Size of the ring buffer between the main-thread encoder and the FPM
+ * writer pthread.  Must be a power of two; sized to absorb a burst of
+ * a full statistics interval worth of updates without stalling the
+ * encoder behind a slow collector.
+ */
+#define ZFPM_RING_SIZE (4 * 1024 * 1024)
+
+/*
+ * The maximum number of times the FPM writer pthread can call writev()
+ * before it yields back to its event loop.
  */
 #define ZFPM_MAX_WRITES_PER_RUN 10
 
@@ -82,10 +95,7 @@ typedef struct zfpm_stats_t_ {
 	unsigned long read_cb_calls;
 
 	unsigned long write_cb_calls;
-	unsigned long write_calls;
-	unsigned long partial_writes;
-	unsigned long max_writes_hit;
-	unsigned long t_write_yields;
+	unsigned long ring_full_stalls;
 
 	unsigned long nop_deletes_skipped;
 	unsigned long route_adds;
@@ -184,11 +194,40 @@ typedef struct zfpm_glob_t_ {
 	int sock;
 
 	/*
-	 * Buffers for messages to/from the FPM.
+	 * Buffer for messages from the FPM.
 	 */
-	struct stream *obuf;
 	struct stream *ibuf;
 
+	/*
+	 * Contiguous ring buffer between the main-thread encoder and the
+	 * FPM writer pthread.  The indices run free and are masked with
+	 * (ZFPM_RING_SIZE - 1); 'ring_head' is advanced only by the main
+	 * thread after it has copied encoded messages in, 'ring_tail'
+	 * only by the writer once the bytes have hit the socket.
+	 */
+	uint8_t *ring_buf;
+	_Atomic uint32_t ring_head;
+	_Atomic uint32_t ring_tail;
+
+	/*
+	 * Socket fd as published to the writer pthread; -1 when the
+	 * connection is down.
+	 */
+	_Atomic int ring_sock;
+
+	/*
+	 * Set by the encoder when it runs out of ring space; the writer
+	 * pokes the main thread to resume building once room frees up.
+	 */
+	_Atomic uint32_t ring_stalled;
+
+	/*
+	 * pthread draining the ring to the FPM socket, and its write
+	 * task (scheduled on the pthread's own thread master).
+	 */
+	struct frr_pthread *writer_pthread;
+	struct thread *t_ring_write;
+
 	/*
 	 * Threads for I/O.
 	 */
@@ -251,14 +290,25 @@ typedef struct zfpm_glob_t_ {
 static zfpm_glob_t zfpm_glob_space;
 static zfpm_glob_t *zfpm_g = &zfpm_glob_space;
 
+/*
+ * Counters owned by the writer pthread; kept separate from
+ * zfpm_stats_t, which is manipulated without atomics on the main
+ * thread.
+ */
+static _Atomic uint64_t zfpm_ring_writev_calls;
+static _Atomic uint64_t zfpm_ring_bytes_written;
+
 static int zfpm_trigger_update(struct route_node *rn, const char *reason);
 
 static int zfpm_read_cb(struct thread *thread);
 static int zfpm_write_cb(struct thread *thread);
+static int zfpm_ring_write_cb(struct thread *thread);
 
 static void zfpm_set_state(zfpm_state_t state, const char *reason);
 static void zfpm_start_connect_timer(const char *reason);
 static void zfpm_start_stats_timer(void);
+static void zfpm_connection_down(const char *detail);
+static inline void zfpm_write_on(void);
 
 /*
  * zfpm_thread_should_yield
@@ -469,6 +519,208 @@ static inline void zfpm_write_off(void)
 	THREAD_WRITE_OFF(zfpm_g->t_write);
 }
 
+/*
+ * zfpm_ring_free_space
+ *
+ * Bytes the encoder may copy into the ring without catching up with
+ * the writer.
+ */
+static inline uint32_t zfpm_ring_free_space(void)
+{
+	uint32_t head, tail;
+
+	head = atomic_load_explicit(&zfpm_g->ring_head, memory_order_relaxed);
+	tail = atomic_load_explicit(&zfpm_g->ring_tail, memory_order_acquire);
+
+	return ZFPM_RING_SIZE - (head - tail);
+}
+
+/*
+ * zfpm_ring_put
+ *
+ * Copy an encoded message into the ring. The caller must have checked
+ * that there is enough free space; the copy is split in two when it
+ * wraps around the physical end of the buffer.
+ */
+static void zfpm_ring_put(const uint8_t *data, uint32_t len)
+{
+	uint32_t head, pos, first;
+
+	head = atomic_load_explicit(&zfpm_g->ring_head, memory_order_relaxed);
+	pos = head & (ZFPM_RING_SIZE - 1);
+	first = MIN(len, ZFPM_RING_SIZE - pos);
+
+	memcpy(zfpm_g->ring_buf + pos, data, first);
+	if (first < len)
+		memcpy(zfpm_g->ring_buf, data + first, len - first);
+
+	atomic_store_explicit(&zfpm_g->ring_head, head + len,
+			      memory_order_release);
+}
+
+/*
+ * zfpm_ring_resume_cb
+ *
+ * Scheduled onto the main thread by the writer when ring space frees
+ * up after the encoder had stalled for lack of it.
+ */
+static int zfpm_ring_resume_cb(struct thread *thread)
+{
+	if (zfpm_g->state != ZFPM_STATE_ESTABLISHED)
+		return 0;
+
+	if (!zfpm_g->t_write)
+		zfpm_write_on();
+
+	return 0;
+}
+
+/*
+ * zfpm_ring_write_error_cb
+ *
+ * Scheduled onto the main thread when the writer pthread fails to
+ * write to the FPM socket; connection teardown must run here.
+ */
+static int zfpm_ring_write_error_cb(struct thread *thread)
+{
+	if (zfpm_g->state == ZFPM_STATE_ESTABLISHED)
+		zfpm_connection_down("failed to write to socket");
+
+	return 0;
+}
+
+/*
+ * zfpm_ring_close_cb
+ *
+ * Runs on the writer pthread to close a torn-down connection's
+ * socket. Closing here rather than on the main thread orders the
+ * close after any writev() still in flight for the old connection.
+ */
+static int zfpm_ring_close_cb(struct thread *thread)
+{
+	THREAD_OFF(zfpm_g->t_ring_write);
+	close(THREAD_VAL(thread));
+
+	return 0;
+}
+
+/*
+ * zfpm_ring_write_cb
+ *
+ * Runs on the writer pthread: drain the ring to the FPM socket with
+ * writev(), using two iovecs when the data wraps around the end of
+ * the buffer.
+ */
+static int zfpm_ring_write_cb(struct thread *thread)
+{
+	int num_writes = 0;
+	int sock;
+
+	zfpm_g->t_ring_write = NULL;
+
+	sock = atomic_load_explicit(&zfpm_g->ring_sock, memory_order_acquire);
+	if (sock < 0)
+		return 0;
+
+	do {
+		struct iovec iov[2];
+		int iovcnt;
+		uint32_t head, tail, used, pos, first;
+		ssize_t nwritten;
+
+		head = atomic_load_explicit(&zfpm_g->ring_head,
+					    memory_order_acquire);
+		tail = atomic_load_explicit(&zfpm_g->ring_tail,
+					    memory_order_relaxed);
+		used = head - tail;
+		if (!used) {
+			/*
+			 * Nothing to send, but the encoder may have
+			 * recorded a stall just as the last bytes were
+			 * drained; clear it on this exit path too, or
+			 * the dest_q sits unsent until unrelated churn
+			 * schedules the writer again.
+			 */
+			if (atomic_exchange_explicit(&zfpm_g->ring_stalled, 0,
+						     memory_order_acq_rel))
+				thread_add_event(zfpm_g->master,
+						 zfpm_ring_resume_cb, NULL, 0,
+						 NULL);
+			break;
+		}
+
+		pos = tail & (ZFPM_RING_SIZE - 1);
+		first = MIN(used, ZFPM_RING_SIZE - pos);
+
+		iov[0].iov_base = zfpm_g->ring_buf + pos;
+		iov[0].iov_len = first;
+		iovcnt = 1;
+
+		if (first < used) {
+			iov[1].iov_base = zfpm_g->ring_buf;
+			iov[1].iov_len = used - first;
+			iovcnt = 2;
+		}
+
+		nwritten = writev(sock, iov, iovcnt);
+		atomic_fetch_add_explicit(&zfpm_ring_writev_calls, 1,
+					  memory_order_relaxed);
+		num_writes++;
+
+		if (nwritten < 0) {
+			if (ERRNO_IO_RETRY(errno)) {
+				thread_add_write(
+					zfpm_g->writer_pthread->master,
+					zfpm_ring_write_cb, NULL, sock,
+					&zfpm_g->t_ring_write);
+				return 0;
+			}
+
+			thread_add_event(zfpm_g->master,
+					 zfpm_ring_write_error_cb, NULL, 0,
+					 NULL);
+			return 0;
+		}
+
+		atomic_fetch_add_explicit(&zfpm_ring_bytes_written, nwritten,
+					  memory_order_relaxed);
+		atomic_store_explicit(&zfpm_g->ring_tail,
+				      tail + (uint32_t)nwritten,
+				      memory_order_release);
+
+		/*
+		 * Let the encoder continue if it ran out of ring space.
+		 */
+		if (atomic_exchange_explicit(&zfpm_g->ring_stalled, 0,
+					     memory_order_acq_rel))
+			thread_add_event(zfpm_g->master, zfpm_ring_resume_cb,
+					 NULL, 0, NULL);
+
+		if ((uint32_t)nwritten < used) {
+			/*
+			 * Partial write - wait until the socket is
+			 * writable again.
+			 */
+			thread_add_write(zfpm_g->writer_pthread->master,
+					 zfpm_ring_write_cb, NULL, sock,
+					 &zfpm_g->t_ring_write);
+			return 0;
+		}
+	} while (num_writes < ZFPM_MAX_WRITES_PER_RUN);
+
+	/*
+	 * If there is still (or again) data in the ring, pick it up on
+	 * the next pass of the writer's event loop.
+	 */
+	if (atomic_load_explicit(&zfpm_g->ring_head, memory_order_acquire)
+	    != atomic_load_explicit(&zfpm_g->ring_tail, memory_order_relaxed))
+		thread_add_event(zfpm_g->writer_pthread->master,
+				 zfpm_ring_write_cb, NULL, 0,
+				 &zfpm_g->t_ring_write);
+
+	return 0;
+}
+
 /*
  * zfpm_conn_up_thread_cb
  *
@@ -531,6 +783,16 @@ static void zfpm_connection_up(const char *detail)
 	assert(zfpm_g->sock >= 0);
 	zfpm_read_on();
 	zfpm_write_on();
+
+	/*
+	 * Reset the ring and hand the socket to the writer pthread.
+	 */
+	atomic_store_explicit(&zfpm_g->ring_head, 0, memory_order_relaxed);
+	atomic_store_explicit(&zfpm_g->ring_tail, 0, memory_order_relaxed);
+	atomic_store_explicit(&zfpm_g->ring_stalled, 0, memory_order_relaxed);
+	atomic_store_explicit(&zfpm_g->ring_sock, zfpm_g->sock,
+			      memory_order_release);
+
 	zfpm_set_state(ZFPM_STATE_ESTABLISHED, detail);
 
 	/*
@@ -660,10 +922,17 @@ static void zfpm_connection_down(const char *detail)
 	zfpm_write_off();
 
 	stream_reset(zfpm_g->ibuf);
-	stream_reset(zfpm_g->obuf);
 
 	if (zfpm_g->sock >= 0) {
-		close(zfpm_g->sock);
+		/*
+		 * Unpublish the socket and let the writer pthread close
+		 * it, so that the close is ordered after any writev()
+		 * still in flight for this connection.
+		 */
+		atomic_store_explicit(&zfpm_g->ring_sock, -1,
+				      memory_order_release);
+		thread_add_event(zfpm_g->writer_pthread->master,
+				 zfpm_ring_close_cb, NULL, zfpm_g->sock, NULL);
 		zfpm_g->sock = -1;
 	}
 
@@ -778,30 +1047,6 @@ done:
 	return 0;
 }
 
-/*
- * zfpm_writes_pending
- *
- * Returns TRUE if we may have something to write to the FPM.
- */
-static int zfpm_writes_pending(void)
-{
-
-	/*
-	 * Check if there is any data in the outbound buffer that has not
-	 * been written to the socket yet.
-	 */
-	if (stream_get_endp(zfpm_g->obuf) - stream_get_getp(zfpm_g->obuf))
-		return 1;
-
-	/*
-	 * Check if there are any prefixes on the outbound queue.
-	 */
-	if (!TAILQ_EMPTY(&zfpm_g->dest_q))
-		return 1;
-
-	return 0;
-}
-
 /*
  * zfpm_encode_route
  *
@@ -863,14 +1108,14 @@ struct route_entry *zfpm_route_for_update(rib_dest_t *dest)
 /*
  * zfpm_build_updates
  *
- * Process the outgoing queue and write messages to the outbound
- * buffer.
+ * Process the outgoing queue: encode messages into a scratch buffer
+ * and copy them into the ring for the writer pthread to send.
  */
 static void zfpm_build_updates(void)
 {
-	struct stream *s;
+	uint8_t msg_buf[FPM_MAX_MSG_LEN];
 	rib_dest_t *dest;
-	unsigned char *buf, *data, *buf_end;
+	unsigned char *data, *buf_end;
 	size_t msg_len;
 	size_t data_len;
 	fpm_msg_hdr_t *hdr;
@@ -878,20 +1123,38 @@ static void zfpm_build_updates(void)
 	int is_add, write_msg;
 	fpm_msg_type_e msg_type;
 
-	s = zfpm_g->obuf;
-
-	assert(stream_empty(s));
+	hdr = (fpm_msg_hdr_t *)msg_buf;
+	buf_end = msg_buf + sizeof(msg_buf);
 
 	do {
 
 		/*
-		 * Make sure there is enough space to write another message.
+		 * Make sure the ring can take another message. If not,
+		 * record the stall; the writer pokes us to resume once
+		 * it has freed up space.
 		 */
-		if (STREAM_WRITEABLE(s) < FPM_MAX_MSG_LEN)
-			break;
+		if (zfpm_ring_free_space() < FPM_MAX_MSG_LEN) {
+			atomic_store_explicit(&zfpm_g->ring_stalled, 1,
+					      memory_order_release);
 
-		buf = STREAM_DATA(s) + stream_get_endp(s);
-		buf_end = buf + STREAM_WRITEABLE(s);
+			/*
+			 * The writer may have drained the ring between
+			 * the check and the store; re-check so that the
+			 * stall cannot be missed.  The fence orders the
+			 * stall store against the tail re-load below -
+			 * without it this is a store-load race and both
+			 * we and the writer can act on stale values,
+			 * leaving the stall set with nobody to clear it.
+			 */
+			atomic_thread_fence(memory_order_seq_cst);
+			if (zfpm_ring_free_space() < FPM_MAX_MSG_LEN) {
+				zfpm_g->stats.ring_full_stalls++;
+				break;
+			}
+
+			atomic_store_explicit(&zfpm_g->ring_stalled, 0,
+					      memory_order_release);
+		}
 
 		dest = TAILQ_FIRST(&zfpm_g->dest_q);
 		if (!dest)
@@ -899,7 +1162,6 @@ static void zfpm_build_updates(void)
 
 		assert(CHECK_FLAG(dest->flags, RIB_DEST_UPDATE_FPM));
 
-		hdr = (fpm_msg_hdr_t *)buf;
 		hdr->version = FPM_PROTO_VERSION;
 
 		data = fpm_msg_data(hdr);
@@ -928,7 +1190,7 @@ static void zfpm_build_updates(void)
 				hdr->msg_type = msg_type;
 				msg_len = fpm_data_len_to_msg_len(data_len);
 				hdr->msg_len = htons(msg_len);
-				stream_forward_endp(s, msg_len);
+				zfpm_ring_put(msg_buf, msg_len);
 
 				if (is_add)
 					zfpm_g->stats.route_adds++;
@@ -960,12 +1222,14 @@ static void zfpm_build_updates(void)
 
 /*
  * zfpm_write_cb
+ *
+ * Runs on the main thread: encode pending updates into the ring and
+ * wake the writer pthread. The socket writes themselves happen on the
+ * writer, so a full-table replay no longer competes with rib_process
+ * for this thread.
  */
 static int zfpm_write_cb(struct thread *thread)
 {
-	struct stream *s;
-	int num_writes;
-
 	zfpm_g->stats.write_cb_calls++;
 	zfpm_g->t_write = NULL;
 
@@ -980,65 +1244,16 @@ static int zfpm_write_cb(struct thread *thread)
 	assert(zfpm_g->state == ZFPM_STATE_ESTABLISHED);
 	assert(zfpm_g->sock >= 0);
 
-	num_writes = 0;
-
-	do {
-		int bytes_to_write, bytes_written;
-
-		s = zfpm_g->obuf;
-
-		/*
-		 * If the stream is empty, try fill it up with data.
-		 */
-		if (stream_empty(s)) {
-			zfpm_build_updates();
-		}
-
-		bytes_to_write = stream_get_endp(s) - stream_get_getp(s);
-		if (!bytes_to_write)
-			break;
-
-		bytes_written =
-			write(zfpm_g->sock, stream_pnt(s), bytes_to_write);
-		zfpm_g->stats.write_calls++;
-		num_writes++;
-
-		if (bytes_written < 0) {
-			if (ERRNO_IO_RETRY(errno))
-				break;
-
-			zfpm_connection_down("failed to write to socket");
-			return 0;
-		}
-
-		if (bytes_written != bytes_to_write) {
-
-			/*
-			 * Partial write.
-			 */
-			stream_forward_getp(s, bytes_written);
-			zfpm_g->stats.partial_writes++;
-			break;
-		}
-
-		/*
-		 * We've written out the entire contents of the stream.
-		 */
-		stream_reset(s);
-
-		if (num_writes >= ZFPM_MAX_WRITES_PER_RUN) {
-			zfpm_g->stats.max_writes_hit++;
-			break;
-		}
-
-		if (zfpm_thread_should_yield(thread)) {
-			zfpm_g->stats.t_write_yields++;
-			break;
-		}
-	} while (1);
+	zfpm_build_updates();
 
-	if (zfpm_writes_pending())
-		zfpm_write_on();
+	/*
+	 * Wake the writer pthread if there is anything to send.
+	 */
+	if (atomic_load_explicit(&zfpm_g->ring_head, memory_order_relaxed)
+	    != atomic_load_explicit(&zfpm_g->ring_tail, memory_order_relaxed))
+		thread_add_event(zfpm_g->writer_pthread->master,
+				 zfpm_ring_write_cb, NULL, 0,
+				 &zfpm_g->t_ring_write);
 
 	return 0;
 }
@@ -1358,10 +1573,7 @@ static void zfpm_show_stats(struct vty *vty)
 	ZFPM_SHOW_STAT(connect_no_sock);
 	ZFPM_SHOW_STAT(read_cb_calls);
 	ZFPM_SHOW_STAT(write_cb_calls);
-	ZFPM_SHOW_STAT(write_calls);
-	ZFPM_SHOW_STAT(partial_writes);
-	ZFPM_SHOW_STAT(max_writes_hit);
-	ZFPM_SHOW_STAT(t_write_yields);
+	ZFPM_SHOW_STAT(ring_full_stalls);
 	ZFPM_SHOW_STAT(nop_deletes_skipped);
 	ZFPM_SHOW_STAT(route_adds);
 	ZFPM_SHOW_STAT(route_dels);
@@ -1378,6 +1590,17 @@ static void zfpm_show_stats(struct vty *vty)
 	ZFPM_SHOW_STAT(t_conn_up_aborts);
 	ZFPM_SHOW_STAT(t_conn_up_finishes);
 
+	/*
+	 * Counters maintained by the writer pthread; these are
+	 * cumulative only.
+	 */
+	vty_out(vty, "%-40s %10lu\n", "ring_writev_calls",
+		(unsigned long)atomic_load_explicit(&zfpm_ring_writev_calls,
+						    memory_order_relaxed));
+	vty_out(vty, "%-40s %10lu\n", "ring_bytes_written",
+		(unsigned long)atomic_load_explicit(&zfpm_ring_bytes_written,
+						    memory_order_relaxed));
+
 	if (!zfpm_g->last_stats_clear_time)
 		return;
 
@@ -1620,9 +1843,20 @@ static int zfpm_init(struct thread_master *master)
 
 	zfpm_g->fpm_port = port;
 
-	zfpm_g->obuf = stream_new(ZFPM_OBUF_SIZE);
 	zfpm_g->ibuf = stream_new(ZFPM_IBUF_SIZE);
 
+	/*
+	 * Start the writer pthread that drains the ring to the FPM
+	 * socket.
+	 */
+	zfpm_g->ring_buf = XMALLOC(MTYPE_FPM_RING, ZFPM_RING_SIZE);
+	atomic_store_explicit(&zfpm_g->ring_sock, -1, memory_order_relaxed);
+
+	zfpm_g->writer_pthread = frr_pthread_new(NULL, "Zebra FPM writer",
+						 "zebra_fpm_wr");
+	frr_pthread_run(zfpm_g->writer_pthread, NULL);
+	frr_pthread_wait_running(zfpm_g->writer_pthread);
+
 	zfpm_start_stats_timer();
 	zfpm_start_connect_timer("initialized");
 	return 0;
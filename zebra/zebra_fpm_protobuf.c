@@ -282,12 +282,16 @@ int zfpm_protobuf_encode_route(rib_dest_t *dest, struct route_entry *re,
 			       uint8_t *in_buf, size_t in_buf_len)
 {
 	Fpm__Message *msg;
-	QPB_DECLARE_STACK_ALLOCATOR(allocator, 4096);
+	qpb_allocator_t *allocator;
 	size_t len;
 
-	QPB_INIT_STACK_ALLOCATOR(allocator);
+	allocator = qpb_thread_allocator();
+	if (!allocator) {
+		assert(0);
+		return 0;
+	}
 
-	msg = create_route_message(&allocator, dest, re);
+	msg = create_route_message(allocator, dest, re);
 	if (!msg) {
 		assert(0);
 		return 0;
@@ -296,6 +300,5 @@ int zfpm_protobuf_encode_route(rib_dest_t *dest, struct route_entry *re,
 	len = fpm__message__pack(msg, (uint8_t *)in_buf);
 	assert(len <= in_buf_len);
 
-	QPB_RESET_STACK_ALLOCATOR(allocator);
 	return len;
 }
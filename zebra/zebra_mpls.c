@@ -49,6 +49,7 @@
 #include "zebra/zebra_errors.h"
 
 DEFINE_MTYPE_STATIC(ZEBRA, LSP, "MPLS LSP object")
+DEFINE_MTYPE_STATIC(ZEBRA, LSP_INDEX, "MPLS label index")
 DEFINE_MTYPE_STATIC(ZEBRA, FEC, "MPLS FEC object")
 DEFINE_MTYPE_STATIC(ZEBRA, SLSP, "MPLS static LSP config")
 DEFINE_MTYPE_STATIC(ZEBRA, NHLFE, "MPLS nexthop object")
@@ -105,7 +106,7 @@ static zebra_nhlfe_t *nhlfe_add(zebra_lsp_t *lsp, enum lsp_types_t lsp_type,
 static int nhlfe_del(zebra_nhlfe_t *snhlfe);
 static void nhlfe_out_label_update(zebra_nhlfe_t *nhlfe,
 				   struct mpls_label_stack *nh_label);
-static int mpls_lsp_uninstall_all(struct hash *lsp_table, zebra_lsp_t *lsp,
+static int mpls_lsp_uninstall_all(struct zebra_vrf *zvrf, zebra_lsp_t *lsp,
 				  enum lsp_types_t type);
 static int mpls_static_lsp_uninstall_all(struct zebra_vrf *zvrf,
 					 mpls_label_t in_label);
@@ -146,14 +147,115 @@ static void clear_nhlfe_installed(zebra_lsp_t *lsp)
 	}
 }
 
+/*
+ * Direct index over the label forwarding table.
+ *
+ * The LSP hash remains the owner of the entries and is still used for
+ * iteration; the index provides an O(1) lookup path keyed directly by
+ * the 20-bit label value, so that large label programming bursts (e.g.
+ * from a segment routing controller) avoid per-operation hash overhead.
+ * The label space is carved into pages allocated on demand, so an idle
+ * table costs only the page-pointer array.
+ */
+#define LSP_INDEX_PAGE_SHIFT 12
+#define LSP_INDEX_PAGE_SIZE (1 << LSP_INDEX_PAGE_SHIFT)
+#define LSP_INDEX_NUM_PAGES ((MPLS_LABEL_MAX + 1) >> LSP_INDEX_PAGE_SHIFT)
+
+struct lsp_index {
+	zebra_lsp_t **pages[LSP_INDEX_NUM_PAGES];
+};
+
+static zebra_lsp_t *lsp_index_lookup(struct zebra_vrf *zvrf,
+				     mpls_label_t in_label)
+{
+	struct lsp_index *index = zvrf->lsp_index;
+	zebra_lsp_t **page;
+
+	if (!index || in_label > MPLS_LABEL_MAX)
+		return NULL;
+
+	page = index->pages[in_label >> LSP_INDEX_PAGE_SHIFT];
+	if (!page)
+		return NULL;
+
+	return page[in_label & (LSP_INDEX_PAGE_SIZE - 1)];
+}
+
+static void lsp_index_update(struct zebra_vrf *zvrf, mpls_label_t in_label,
+			     zebra_lsp_t *lsp)
+{
+	struct lsp_index *index = zvrf->lsp_index;
+	zebra_lsp_t **page;
+
+	if (!index || in_label > MPLS_LABEL_MAX)
+		return;
+
+	page = index->pages[in_label >> LSP_INDEX_PAGE_SHIFT];
+	if (!page) {
+		if (!lsp)
+			return;
+		page = XCALLOC(MTYPE_LSP_INDEX,
+			       LSP_INDEX_PAGE_SIZE * sizeof(zebra_lsp_t *));
+		index->pages[in_label >> LSP_INDEX_PAGE_SHIFT] = page;
+	}
+
+	page[in_label & (LSP_INDEX_PAGE_SIZE - 1)] = lsp;
+}
+
+/*
+ * Locate or allocate the LSP entry for an in-label, keeping the direct
+ * index in sync with the hash table.
+ */
+static zebra_lsp_t *lsp_get(struct zebra_vrf *zvrf, mpls_label_t in_label)
+{
+	zebra_ile_t tmp_ile;
+	zebra_lsp_t *lsp;
+
+	lsp = lsp_index_lookup(zvrf, in_label);
+	if (lsp)
+		return lsp;
+
+	tmp_ile.in_label = in_label;
+	lsp = hash_get(zvrf->lsp_table, &tmp_ile, lsp_alloc);
+	if (lsp)
+		lsp_index_update(zvrf, in_label, lsp);
+
+	return lsp;
+}
+
+/*
+ * Look up the LSP entry for an in-label, via the direct index where
+ * possible.
+ */
+static zebra_lsp_t *lsp_lookup(struct zebra_vrf *zvrf, mpls_label_t in_label)
+{
+	zebra_ile_t tmp_ile;
+	zebra_lsp_t *lsp;
+
+	lsp = lsp_index_lookup(zvrf, in_label);
+	if (lsp)
+		return lsp;
+
+	tmp_ile.in_label = in_label;
+	return hash_lookup(zvrf->lsp_table, &tmp_ile);
+}
+
+/*
+ * Remove and free an LSP entry, clearing its slot in the direct index.
+ */
+static void lsp_release(struct zebra_vrf *zvrf, zebra_lsp_t *lsp)
+{
+	lsp_index_update(zvrf, lsp->ile.in_label, NULL);
+	lsp = hash_release(zvrf->lsp_table, &lsp->ile);
+	XFREE(MTYPE_LSP, lsp);
+}
+
 /*
  * Install label forwarding entry based on labeled-route entry.
  */
 static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
 		       struct route_node *rn, struct route_entry *re)
 {
-	struct hash *lsp_table;
-	zebra_ile_t tmp_ile;
 	zebra_lsp_t *lsp;
 	zebra_nhlfe_t *nhlfe;
 	struct nexthop *nexthop;
@@ -162,16 +264,14 @@ static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
 	int added, changed;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	lsp_type = lsp_type_from_re_type(re->type);
 	added = changed = 0;
 
 	/* Locate or allocate LSP entry. */
-	tmp_ile.in_label = label;
-	lsp = hash_get(lsp_table, &tmp_ile, lsp_alloc);
+	lsp = lsp_get(zvrf, label);
 	if (!lsp)
 		return -1;
 
@@ -248,8 +348,7 @@ static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
 			zlog_debug("Free LSP in-label %u flags 0x%x",
 				   lsp->ile.in_label, lsp->flags);
 
-		lsp = hash_release(lsp_table, &lsp->ile);
-		XFREE(MTYPE_LSP, lsp);
+		lsp_release(zvrf, lsp);
 	}
 
 	return 0;
@@ -261,20 +360,16 @@ static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
  */
 static int lsp_uninstall(struct zebra_vrf *zvrf, mpls_label_t label)
 {
-	struct hash *lsp_table;
-	zebra_ile_t tmp_ile;
 	zebra_lsp_t *lsp;
 	zebra_nhlfe_t *nhlfe, *nhlfe_next;
 	char buf[BUFSIZ];
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_lookup(zvrf, label);
 	if (!lsp || !lsp->nhlfe_list)
 		return 0;
 
@@ -311,8 +406,7 @@ static int lsp_uninstall(struct zebra_vrf *zvrf, mpls_label_t label)
 			zlog_debug("Del LSP in-label %u flags 0x%x",
 				   lsp->ile.in_label, lsp->flags);
 
-		lsp = hash_release(lsp_table, &lsp->ile);
-		XFREE(MTYPE_LSP, lsp);
+		lsp_release(zvrf, lsp);
 	}
 
 	return 0;
@@ -1014,14 +1108,12 @@ static void lsp_processq_del(struct work_queue *wq, void *data)
 {
 	struct zebra_vrf *zvrf;
 	zebra_lsp_t *lsp;
-	struct hash *lsp_table;
 	zebra_nhlfe_t *nhlfe, *nhlfe_next;
 
 	zvrf = vrf_info_lookup(VRF_DEFAULT);
 	assert(zvrf);
 
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table) // unexpected
+	if (!zvrf->lsp_table) // unexpected
 		return;
 
 	lsp = (zebra_lsp_t *)data;
@@ -1045,8 +1137,7 @@ static void lsp_processq_del(struct work_queue *wq, void *data)
 			zlog_debug("Free LSP in-label %u flags 0x%x",
 				   lsp->ile.in_label, lsp->flags);
 
-		lsp = hash_release(lsp_table, &lsp->ile);
-		XFREE(MTYPE_LSP, lsp);
+		lsp_release(zvrf, lsp);
 	}
 }
 
@@ -1290,7 +1381,7 @@ static void nhlfe_out_label_update(zebra_nhlfe_t *nhlfe,
 	nhlfe->nexthop->nh_label->label[0] = nh_label->label[0];
 }
 
-static int mpls_lsp_uninstall_all(struct hash *lsp_table, zebra_lsp_t *lsp,
+static int mpls_lsp_uninstall_all(struct zebra_vrf *zvrf, zebra_lsp_t *lsp,
 				  enum lsp_types_t type)
 {
 	zebra_nhlfe_t *nhlfe, *nhlfe_next;
@@ -1331,8 +1422,7 @@ static int mpls_lsp_uninstall_all(struct hash *lsp_table, zebra_lsp_t *lsp,
 			zlog_debug("Free LSP in-label %u flags 0x%x",
 				   lsp->ile.in_label, lsp->flags);
 
-		lsp = hash_release(lsp_table, &lsp->ile);
-		XFREE(MTYPE_LSP, lsp);
+		lsp_release(zvrf, lsp);
 	}
 
 	return 0;
@@ -1345,22 +1435,18 @@ static int mpls_lsp_uninstall_all(struct hash *lsp_table, zebra_lsp_t *lsp,
 static int mpls_static_lsp_uninstall_all(struct zebra_vrf *zvrf,
 					 mpls_label_t in_label)
 {
-	struct hash *lsp_table;
-	zebra_ile_t tmp_ile;
 	zebra_lsp_t *lsp;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = in_label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_lookup(zvrf, in_label);
 	if (!lsp || !lsp->nhlfe_list)
 		return 0;
 
-	return mpls_lsp_uninstall_all(lsp_table, lsp, ZEBRA_LSP_STATIC);
+	return mpls_lsp_uninstall_all(zvrf, lsp, ZEBRA_LSP_STATIC);
 }
 
 static json_object *nhlfe_json(zebra_nhlfe_t *nhlfe)
@@ -1734,8 +1820,6 @@ static int mpls_processq_init(void)
 void zebra_mpls_lsp_dplane_result(struct zebra_dplane_ctx *ctx)
 {
 	struct zebra_vrf *zvrf;
-	zebra_ile_t tmp_ile;
-	struct hash *lsp_table;
 	zebra_lsp_t *lsp;
 	zebra_nhlfe_t *nhlfe;
 	struct nexthop *nexthop;
@@ -1759,10 +1843,7 @@ void zebra_mpls_lsp_dplane_result(struct zebra_dplane_ctx *ctx)
 		if (zvrf == NULL)
 			break;
 
-		lsp_table = zvrf->lsp_table;
-
-		tmp_ile.in_label = dplane_ctx_get_in_label(ctx);
-		lsp = hash_lookup(lsp_table, &tmp_ile);
+		lsp = lsp_lookup(zvrf, dplane_ctx_get_in_label(ctx));
 		if (lsp == NULL) {
 			if (IS_ZEBRA_DEBUG_DPLANE)
 				zlog_debug("LSP ctx %p: in-label %u not found",
@@ -2418,20 +2499,16 @@ int mpls_lsp_install(struct zebra_vrf *zvrf, enum lsp_types_t type,
 		     enum nexthop_types_t gtype, union g_addr *gate,
 		     ifindex_t ifindex)
 {
-	struct hash *lsp_table;
-	zebra_ile_t tmp_ile;
 	zebra_lsp_t *lsp;
 	zebra_nhlfe_t *nhlfe;
 	char buf[BUFSIZ];
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is present, exit. */
-	tmp_ile.in_label = in_label;
-	lsp = hash_get(lsp_table, &tmp_ile, lsp_alloc);
+	lsp = lsp_get(zvrf, in_label);
 	if (!lsp)
 		return -1;
 	nhlfe = nhlfe_find(lsp, type, gtype, gate, ifindex);
@@ -2491,20 +2568,16 @@ int mpls_lsp_uninstall(struct zebra_vrf *zvrf, enum lsp_types_t type,
 		       mpls_label_t in_label, enum nexthop_types_t gtype,
 		       union g_addr *gate, ifindex_t ifindex)
 {
-	struct hash *lsp_table;
-	zebra_ile_t tmp_ile;
 	zebra_lsp_t *lsp;
 	zebra_nhlfe_t *nhlfe;
 	char buf[BUFSIZ];
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = in_label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_lookup(zvrf, in_label);
 	if (!lsp)
 		return 0;
 	nhlfe = nhlfe_find(lsp, type, gtype, gate, ifindex);
@@ -2533,8 +2606,7 @@ int mpls_lsp_uninstall(struct zebra_vrf *zvrf, enum lsp_types_t type,
 				zlog_debug("Free LSP in-label %u flags 0x%x",
 					   lsp->ile.in_label, lsp->flags);
 
-			lsp = hash_release(lsp_table, &lsp->ile);
-			XFREE(MTYPE_LSP, lsp);
+			lsp_release(zvrf, lsp);
 		}
 	}
 	return 0;
@@ -2547,17 +2619,17 @@ int mpls_lsp_uninstall(struct zebra_vrf *zvrf, enum lsp_types_t type,
 void mpls_ldp_lsp_uninstall_all(struct hash_bucket *bucket, void *ctxt)
 {
 	zebra_lsp_t *lsp;
-	struct hash *lsp_table;
+	struct zebra_vrf *zvrf;
 
 	lsp = (zebra_lsp_t *)bucket->data;
 	if (!lsp->nhlfe_list)
 		return;
 
-	lsp_table = ctxt;
-	if (!lsp_table)
+	zvrf = ctxt;
+	if (!zvrf)
 		return;
 
-	mpls_lsp_uninstall_all(lsp_table, lsp, ZEBRA_LSP_LDP);
+	mpls_lsp_uninstall_all(zvrf, lsp, ZEBRA_LSP_LDP);
 }
 
 /*
@@ -2803,19 +2875,15 @@ void zebra_mpls_lsp_schedule(struct zebra_vrf *zvrf)
 void zebra_mpls_print_lsp(struct vty *vty, struct zebra_vrf *zvrf,
 			  mpls_label_t label, bool use_json)
 {
-	struct hash *lsp_table;
 	zebra_lsp_t *lsp;
-	zebra_ile_t tmp_ile;
 	json_object *json = NULL;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_lookup(zvrf, label);
 	if (!lsp)
 		return;
 
@@ -3013,9 +3081,16 @@ void zebra_mpls_cleanup_tables(struct zebra_vrf *zvrf)
  */
 void zebra_mpls_close_tables(struct zebra_vrf *zvrf)
 {
+	int i;
+
 	hash_iterate(zvrf->lsp_table, lsp_uninstall_from_kernel, NULL);
 	hash_clean(zvrf->lsp_table, NULL);
 	hash_free(zvrf->lsp_table);
+	if (zvrf->lsp_index) {
+		for (i = 0; i < LSP_INDEX_NUM_PAGES; i++)
+			XFREE(MTYPE_LSP_INDEX, zvrf->lsp_index->pages[i]);
+		XFREE(MTYPE_LSP_INDEX, zvrf->lsp_index);
+	}
 	hash_clean(zvrf->slsp_table, NULL);
 	hash_free(zvrf->slsp_table);
 	route_table_finish(zvrf->fec_table[AFI_IP]);
@@ -3033,6 +3108,7 @@ void zebra_mpls_init_tables(struct zebra_vrf *zvrf)
 	zvrf->slsp_table =
 		hash_create(label_hash, label_cmp, "ZEBRA SLSP table");
 	zvrf->lsp_table = hash_create(label_hash, label_cmp, "ZEBRA LSP table");
+	zvrf->lsp_index = XCALLOC(MTYPE_LSP_INDEX, sizeof(struct lsp_index));
 	zvrf->fec_table[AFI_IP] = route_table_init();
 	zvrf->fec_table[AFI_IP6] = route_table_init();
 	zvrf->mpls_flags = 0;
@@ -0,0 +1,225 @@
+/* Zebra nexthop-group object tracking
+ * Copyright (C) 2019 Cumulus Networks, Inc.
+ *
+ * This file is part of FRR.
+ *
+ * FRR is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * FRR is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "hash.h"
+#include "jhash.h"
+#include "memory.h"
+#include "nexthop.h"
+#include "nexthop_group.h"
+
+#include "zebra/debug.h"
+#include "zebra/rt.h"
+#include "zebra/zebra_memory.h"
+#include "zebra/zebra_nhg.h"
+
+DEFINE_MTYPE_STATIC(ZEBRA, NHG, "Nexthop group entry")
+
+static struct hash *zebra_nhg_table;
+
+/* Kernel object ids are allocated by zebra; zero is never used so that
+ * callers can treat id 0 as 'not representable'.
+ */
+static uint32_t zebra_nhg_next_id = 1;
+
+static bool kernel_nexthops_enabled;
+
+bool zebra_nhg_kernel_nexthops_enabled(void)
+{
+	return kernel_nexthops_enabled;
+}
+
+void zebra_nhg_set_kernel_nexthops(bool enabled)
+{
+	kernel_nexthops_enabled = enabled;
+}
+
+static unsigned int zebra_nhg_hash_key(void *arg)
+{
+	struct nhg_hash_entry *nhe = arg;
+
+	return jhash_1word(nexthop_group_hash(&nhe->nhg), nhe->vrf_id);
+}
+
+static bool zebra_nhg_hash_equal(const void *arg1, const void *arg2)
+{
+	const struct nhg_hash_entry *nhe1 = arg1;
+	const struct nhg_hash_entry *nhe2 = arg2;
+
+	if (nhe1->vrf_id != nhe2->vrf_id)
+		return false;
+
+	return nexthop_group_equal(&nhe1->nhg, &nhe2->nhg);
+}
+
+/* Copy a single nexthop without its chain or resolution state */
+static struct nexthop *zebra_nhg_nexthop_dup(const struct nexthop *nh)
+{
+	struct nexthop *new;
+
+	new = nexthop_new();
+	memcpy(new, nh, sizeof(*new));
+	new->next = NULL;
+	new->prev = NULL;
+	new->resolved = NULL;
+	new->nh_label = NULL;
+
+	return new;
+}
+
+/* Intern one entry; 'single' describes a one-nexthop group. */
+static struct nhg_hash_entry *zebra_nhg_find(const struct nexthop *nh,
+					     vrf_id_t vrf_id)
+{
+	struct nhg_hash_entry lookup, *nhe;
+	struct nexthop single;
+
+	/* Compare against just this one nexthop */
+	memcpy(&single, nh, sizeof(single));
+	single.next = NULL;
+
+	memset(&lookup, 0, sizeof(lookup));
+	lookup.vrf_id = vrf_id;
+	lookup.nhg.nexthop = &single;
+
+	nhe = hash_lookup(zebra_nhg_table, &lookup);
+	if (nhe) {
+		nhe->refcnt++;
+		return nhe;
+	}
+
+	nhe = XCALLOC(MTYPE_NHG, sizeof(*nhe));
+	nhe->id = zebra_nhg_next_id++;
+	nhe->vrf_id = vrf_id;
+	nhe->nhg.nexthop = zebra_nhg_nexthop_dup(nh);
+	nhe->refcnt = 1;
+
+	if (kernel_nexthop_group_update(nhe, true) == 0)
+		nhe->installed = true;
+
+	hash_get(zebra_nhg_table, nhe, hash_alloc_intern);
+
+	return nhe;
+}
+
+uint32_t zebra_nhg_get_id(const struct nexthop_group *nhg, vrf_id_t vrf_id)
+{
+	struct nhg_hash_entry lookup, *nhe;
+	struct nexthop *nexthop;
+	uint32_t nexthop_num = 0;
+
+	if (!kernel_nexthops_enabled)
+		return 0;
+
+	/* Only groups of resolved, label-free nexthops can be mapped to
+	 * kernel objects; anything else falls back to per-route encoding.
+	 */
+	for (ALL_NEXTHOPS_PTR(nhg, nexthop)) {
+		if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_RECURSIVE))
+			continue;
+		if (nexthop->nh_label)
+			return 0;
+
+		nexthop_num++;
+	}
+
+	if (nexthop_num == 0 || nexthop_num > ZEBRA_NHG_MAX_GROUP)
+		return 0;
+
+	if (nexthop_num == 1) {
+		for (ALL_NEXTHOPS_PTR(nhg, nexthop)) {
+			if (CHECK_FLAG(nexthop->flags,
+				       NEXTHOP_FLAG_RECURSIVE))
+				continue;
+
+			nhe = zebra_nhg_find(nexthop, vrf_id);
+			return nhe->installed ? nhe->id : 0;
+		}
+
+		return 0;
+	}
+
+	/* Multipath: look up the group as a whole first */
+	memset(&lookup, 0, sizeof(lookup));
+	lookup.vrf_id = vrf_id;
+	lookup.nhg = *nhg;
+
+	nhe = hash_lookup(zebra_nhg_table, &lookup);
+	if (nhe) {
+		nhe->refcnt++;
+		return nhe->installed ? nhe->id : 0;
+	}
+
+	nhe = XCALLOC(MTYPE_NHG, sizeof(*nhe));
+	nhe->id = zebra_nhg_next_id++;
+	nhe->vrf_id = vrf_id;
+	copy_nexthops(&nhe->nhg.nexthop, nhg->nexthop, NULL);
+	nhe->refcnt = 1;
+
+	/* Intern each member as a singleton so the kernel group can
+	 * reference their object ids.
+	 */
+	for (ALL_NEXTHOPS_PTR(nhg, nexthop)) {
+		struct nhg_hash_entry *member;
+
+		if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_RECURSIVE))
+			continue;
+
+		member = zebra_nhg_find(nexthop, vrf_id);
+		if (!member->installed) {
+			hash_get(zebra_nhg_table, nhe, hash_alloc_intern);
+			return 0;
+		}
+
+		nhe->grp[nhe->grp_count++] = member->id;
+	}
+
+	if (kernel_nexthop_group_update(nhe, true) == 0)
+		nhe->installed = true;
+
+	hash_get(zebra_nhg_table, nhe, hash_alloc_intern);
+
+	return nhe->installed ? nhe->id : 0;
+}
+
+static void zebra_nhg_free(void *arg)
+{
+	struct nhg_hash_entry *nhe = arg;
+
+	if (nhe->installed)
+		kernel_nexthop_group_update(nhe, false);
+
+	nexthops_free(nhe->nhg.nexthop);
+	XFREE(MTYPE_NHG, nhe);
+}
+
+void zebra_nhg_init(void)
+{
+	zebra_nhg_table = hash_create(zebra_nhg_hash_key, zebra_nhg_hash_equal,
+				      "Zebra nexthop groups");
+}
+
+void zebra_nhg_terminate(void)
+{
+	hash_clean(zebra_nhg_table, zebra_nhg_free);
+	hash_free(zebra_nhg_table);
+	zebra_nhg_table = NULL;
+}
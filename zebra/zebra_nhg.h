@@ -0,0 +1,68 @@
+/* Zebra nexthop-group object tracking
+ * Copyright (C) 2019 Cumulus Networks, Inc.
+ *
+ * This file is part of FRR.
+ *
+ * FRR is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * FRR is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _ZEBRA_NHG_H
+#define _ZEBRA_NHG_H
+
+#include "nexthop_group.h"
+#include "vrf.h"
+
+/* Upper bound on members of a kernel nexthop-group object */
+#define ZEBRA_NHG_MAX_GROUP 64
+
+/* An interned nexthop group, mapped to a kernel nexthop object id so
+ * that many routes sharing the same nexthops reference one kernel
+ * object instead of re-encoding their full nexthop list on install.
+ */
+struct nhg_hash_entry {
+	/* Kernel object id; ids are allocated by zebra */
+	uint32_t id;
+
+	vrf_id_t vrf_id;
+
+	/* Deep copy of the nexthops this entry represents */
+	struct nexthop_group nhg;
+
+	/* For multi-nexthop entries, ids of the member singletons */
+	uint32_t grp[ZEBRA_NHG_MAX_GROUP];
+	uint8_t grp_count;
+
+	uint32_t refcnt;
+
+	/* Object is present in the kernel */
+	bool installed;
+};
+
+extern void zebra_nhg_init(void);
+extern void zebra_nhg_terminate(void);
+
+/* Runtime toggle for use of kernel nexthop-group objects */
+extern bool zebra_nhg_kernel_nexthops_enabled(void);
+extern void zebra_nhg_set_kernel_nexthops(bool enabled);
+
+/* Return the kernel object id covering 'nhg', interning and installing
+ * a new object if this is the first use of the group. Returns 0 if the
+ * group cannot be represented as a kernel object; callers must then
+ * fall back to per-route nexthop encoding.
+ */
+extern uint32_t zebra_nhg_get_id(const struct nexthop_group *nhg,
+				 vrf_id_t vrf_id);
+
+#endif /* _ZEBRA_NHG_H */
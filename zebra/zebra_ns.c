@@ -39,10 +39,17 @@
 #include "zebra_pbr.h"
 #include "rib.h"
 #include "table_manager.h"
+#ifdef HAVE_NETLINK
+#include "frr_pthread.h"
+#include "kernel_netlink.h"
+#endif
 
 extern struct zebra_privs_t zserv_privs;
 
 DEFINE_MTYPE(ZEBRA, ZEBRA_NS, "Zebra Name Space")
+#ifdef HAVE_NETLINK
+DEFINE_MTYPE_STATIC(ZEBRA, ZNS_DUMP_JOB, "Zebra NS startup dump job")
+#endif
 
 static struct zebra_ns *dzns;
 
@@ -115,6 +122,105 @@ int zebra_ns_disabled(struct ns *ns)
 	return zebra_ns_disable_internal(zns, true);
 }
 
+#ifdef HAVE_NETLINK
+/* Parallel startup dumps.
+ *
+ * Reading the kernel state of a namespace (RTM_GETLINK/GETADDR/GETROUTE
+ * dumps) is dominated by waiting for the kernel to generate the dump
+ * replies; with thousands of netns-backend VRFs doing this serially
+ * stretches cold start into minutes.  While the initial netns directory
+ * scan runs, zebra_ns_enable() only opens the sockets inline and queues
+ * the dump reads; once the scan is complete, a small pool of worker
+ * threads drains the queue, overlapping the kernel-side dump generation
+ * across namespaces.  Merging into shared zebra structures is serialized
+ * inside netlink_parse_info() (see netlink_parallel_dump_set()), and the
+ * main thread blocks in pthread_join() for the duration, so no other
+ * actor touches those structures concurrently.
+ */
+#define ZNS_DUMP_WORKERS 4
+
+struct zns_dump_job {
+	struct zebra_ns *zns;
+	struct zns_dump_job *next;
+};
+
+static struct zns_dump_job *zns_dump_jobs;
+static pthread_mutex_t zns_dump_mtx = PTHREAD_MUTEX_INITIALIZER;
+static bool zns_dump_defer;
+
+static void *zebra_ns_dump_worker(void *arg)
+{
+	struct zns_dump_job *job;
+
+	while (true) {
+		pthread_mutex_lock(&zns_dump_mtx);
+		job = zns_dump_jobs;
+		if (job)
+			zns_dump_jobs = job->next;
+		pthread_mutex_unlock(&zns_dump_mtx);
+
+		if (job == NULL)
+			break;
+
+		interface_list(job->zns);
+		route_read(job->zns);
+
+		XFREE(MTYPE_ZNS_DUMP_JOB, job);
+	}
+
+	return NULL;
+}
+
+/* Begin deferring namespace dump reads; enable hooks fired while this
+ * window is open queue their dumps instead of reading them inline.
+ */
+static void zebra_ns_dump_begin(void)
+{
+	zns_dump_defer = true;
+}
+
+/* Run the queued dump reads on a worker pool and wait for completion. */
+static void zebra_ns_dump_finish(void)
+{
+	pthread_t workers[ZNS_DUMP_WORKERS];
+	struct zns_dump_job *job;
+	unsigned int nworkers = 0;
+	unsigned int njobs = 0;
+	unsigned int i;
+
+	zns_dump_defer = false;
+
+	for (job = zns_dump_jobs; job; job = job->next)
+		njobs++;
+
+	if (njobs == 0)
+		return;
+
+	netlink_parallel_dump_set(true);
+
+	for (i = 0; i < MIN(njobs, ZNS_DUMP_WORKERS); i++) {
+		if (pthread_create(&workers[i], NULL, zebra_ns_dump_worker,
+				   NULL) != 0)
+			break;
+		nworkers++;
+	}
+
+	if (nworkers == 0) {
+		/* Fall back to reading the queue on this thread. */
+		zebra_ns_dump_worker(NULL);
+	} else {
+		for (i = 0; i < nworkers; i++)
+			pthread_join(workers[i], NULL);
+	}
+
+	netlink_parallel_dump_set(false);
+
+	if (IS_ZEBRA_DEBUG_EVENT)
+		zlog_info("ZNS startup dumps for %u namespaces read by %u workers",
+			  njobs, nworkers);
+}
+#endif /* HAVE_NETLINK */
+
 /* Do global enable actions - open sockets, read kernel config etc. */
 int zebra_ns_enable(ns_id_t ns_id, void **info)
 {
@@ -127,8 +233,23 @@ int zebra_ns_enable(ns_id_t ns_id, void **info)
 #endif
 
 	kernel_init(zns);
+
+#ifdef HAVE_NETLINK
+	if (zns_dump_defer && ns_id != NS_DEFAULT) {
+		struct zns_dump_job *job;
+
+		job = XCALLOC(MTYPE_ZNS_DUMP_JOB, sizeof(*job));
+		job->zns = zns;
+		job->next = zns_dump_jobs;
+		zns_dump_jobs = job;
+	} else {
+		interface_list(zns);
+		route_read(zns);
+	}
+#else
 	interface_list(zns);
 	route_read(zns);
+#endif
 
 	/* Initiate Table Manager per ZNS */
 	table_manager_enable(ns_id);
@@ -216,7 +337,13 @@ int zebra_ns_init(const char *optional_default_name)
 		ns_add_hook(NS_ENABLE_HOOK, zebra_ns_enabled);
 		ns_add_hook(NS_DISABLE_HOOK, zebra_ns_disabled);
 		ns_add_hook(NS_DELETE_HOOK, zebra_ns_delete);
+#ifdef HAVE_NETLINK
+		zebra_ns_dump_begin();
 		zebra_ns_notify_parse();
+		zebra_ns_dump_finish();
+#else
+		zebra_ns_notify_parse();
+#endif
 		zebra_ns_notify_init();
 	}
 
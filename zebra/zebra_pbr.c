@@ -131,7 +131,7 @@ void zebra_pbr_rules_free(void *arg)
 
 	rule = (struct zebra_pbr_rule *)arg;
 
-	(void)kernel_del_pbr_rule(rule);
+	(void)dplane_pbr_rule_delete(rule);
 	XFREE(MTYPE_TMP, rule);
 }
 
@@ -436,8 +436,29 @@ void zebra_pbr_add_rule(struct zebra_pbr_rule *rule)
 	struct zebra_pbr_rule *unique =
 		pbr_rule_lookup_unique(rule);
 
+	/* An enabled aggregation engine may fold this into an ipset
+	 * instead; clean up a discrete leftover if the rule used to be
+	 * installed directly.
+	 */
+	if (zebra_pbr_agg_rule_add(rule)) {
+		if (unique)
+			zebra_pbr_del_rule(unique);
+		return;
+	}
+
+	/*
+	 * Resync: if the existing rule is identical, the kernel already
+	 * has it - skip the delete/re-add churn and just ack the owner.
+	 */
+	if (unique && rule->sock == unique->sock
+	    && zebra_pbr_rules_hash_equal(rule, unique)) {
+		kernel_pbr_rule_add_del_status(rule,
+					       ZEBRA_DPLANE_INSTALL_SUCCESS);
+		return;
+	}
+
 	(void)hash_get(zrouter.rules_hash, rule, pbr_rule_alloc_intern);
-	(void)kernel_add_pbr_rule(rule);
+	(void)dplane_pbr_rule_add(rule);
 	/*
 	 * Rule Replace semantics, if we have an old, install the
 	 * new rule, look above, and then delete the old
@@ -450,8 +471,11 @@ void zebra_pbr_del_rule(struct zebra_pbr_rule *rule)
 {
 	struct zebra_pbr_rule *lookup;
 
+	if (zebra_pbr_agg_rule_del(rule))
+		return;
+
 	lookup = hash_lookup(zrouter.rules_hash, rule);
-	(void)kernel_del_pbr_rule(rule);
+	(void)dplane_pbr_rule_delete(rule);
 
 	if (lookup) {
 		hash_release(zrouter.rules_hash, lookup);
@@ -467,7 +491,7 @@ static void zebra_pbr_cleanup_rules(struct hash_bucket *b, void *data)
 	int *sock = data;
 
 	if (rule->sock == *sock) {
-		(void)kernel_del_pbr_rule(rule);
+		(void)dplane_pbr_rule_delete(rule);
 		hash_release(zrouter.rules_hash, rule);
 		XFREE(MTYPE_TMP, rule);
 	}
@@ -512,6 +536,7 @@ static int zebra_pbr_client_close_cleanup(struct zserv *client)
 
 	if (!sock)
 		return 0;
+	zebra_pbr_agg_client_close(sock);
 	hash_iterate(zrouter.rules_hash, zebra_pbr_cleanup_rules, &sock);
 	hash_iterate(zrouter.iptable_hash, zebra_pbr_cleanup_iptable, &sock);
 	hash_iterate(zrouter.ipset_entry_hash, zebra_pbr_cleanup_ipset_entry,
@@ -716,6 +741,27 @@ void kernel_pbr_rule_add_del_status(struct zebra_pbr_rule *rule,
 	}
 }
 
+/*
+ * Process a dataplane result for a rule (un)install and notify the
+ * owning client; called on the zebra main pthread.
+ */
+void zebra_pbr_dplane_result(struct zebra_dplane_ctx *ctx)
+{
+	struct zebra_pbr_rule *rule = dplane_ctx_get_rule(ctx);
+	bool ok = (dplane_ctx_get_status(ctx) == ZEBRA_DPLANE_REQUEST_SUCCESS);
+
+	if (dplane_ctx_get_op(ctx) == DPLANE_OP_RULE_ADD)
+		kernel_pbr_rule_add_del_status(
+			rule, ok ? ZEBRA_DPLANE_INSTALL_SUCCESS
+				 : ZEBRA_DPLANE_INSTALL_FAILURE);
+	else
+		kernel_pbr_rule_add_del_status(
+			rule, ok ? ZEBRA_DPLANE_DELETE_SUCCESS
+				 : ZEBRA_DPLANE_DELETE_FAILURE);
+
+	dplane_ctx_fini(&ctx);
+}
+
 /*
  * Handle success or failure of ipset (un)install in the kernel.
  */
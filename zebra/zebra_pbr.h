@@ -165,17 +165,10 @@ void zebra_pbr_add_iptable(struct zebra_pbr_iptable *iptable);
 void zebra_pbr_del_iptable(struct zebra_pbr_iptable *iptable);
 
 /*
- * Install specified rule for a specific interface.
- * It is possible that the user-defined sequence number and the one in the
- * forwarding plane may not coincide, hence the API requires a separate
- * rule priority - maps to preference/FRA_PRIORITY on Linux.
+ * Process a dataplane result for a rule (un)install that was queued
+ * through the dataplane subsystem.
  */
-extern enum zebra_dplane_result kernel_add_pbr_rule(struct zebra_pbr_rule *rule);
-
-/*
- * Uninstall specified rule for a specific interface.
- */
-extern enum zebra_dplane_result kernel_del_pbr_rule(struct zebra_pbr_rule *rule);
+extern void zebra_pbr_dplane_result(struct zebra_dplane_ctx *ctx);
 
 /*
  * Get to know existing PBR rules in the kernel - typically called at startup.
@@ -229,6 +222,14 @@ extern uint32_t zebra_pbr_iptable_hash_key(void *arg);
 extern bool zebra_pbr_iptable_hash_equal(const void *arg1, const void *arg2);
 
 extern void zebra_pbr_init(void);
+
+/* rule aggregation engine (zebra_pbr_agg.c) */
+extern void zebra_pbr_agg_init(void);
+extern bool zebra_pbr_agg_rule_add(struct zebra_pbr_rule *rule);
+extern bool zebra_pbr_agg_rule_del(struct zebra_pbr_rule *rule);
+extern void zebra_pbr_agg_client_close(int sock);
+extern bool zebra_pbr_agg_enabled_get(void);
+
 extern void zebra_pbr_show_ipset_list(struct vty *vty, char *ipsetname);
 extern void zebra_pbr_show_iptable(struct vty *vty, char *iptable);
 extern void zebra_pbr_iptable_update_interfacelist(struct stream *s,
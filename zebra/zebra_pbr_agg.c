@@ -0,0 +1,406 @@
+/* Zebra Policy Based Routing (PBR) rule aggregation.
+ *
+ * Folds discrete rules that share an action into one ipset-backed
+ * matcher, so rule churn becomes set membership updates.
+ *
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This file is part of FRR.
+ *
+ * FRR is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * FRR is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FRR; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include <jhash.h>
+#include <hash.h>
+#include <memory.h>
+#include <linklist.h>
+#include <vty.h>
+#include <command.h>
+
+#include "zebra/zebra_router.h"
+#include "zebra/zebra_pbr.h"
+#include "zebra/zebra_memory.h"
+
+DEFINE_MTYPE_STATIC(ZEBRA, PBR_AGG_GROUP, "PBR aggregation group")
+DEFINE_MTYPE_STATIC(ZEBRA, PBR_AGG_MEMBER, "PBR aggregation member")
+
+/* uniques for the synthetic ipset/iptable/rule objects live well above
+ * anything the owning daemons allocate */
+#define PBR_AGG_UNIQUE_BASE (1 << 24)
+
+/* fwmark space used to tie the per-group iptable to the per-group rule */
+#define PBR_AGG_FWMARK_BASE 0x40000000
+
+static bool pbr_agg_enabled;
+static struct hash *pbr_agg_group_hash;
+static uint32_t pbr_agg_next_unique = PBR_AGG_UNIQUE_BASE;
+static uint32_t pbr_agg_next_group_id = 1;
+
+/* All rules sharing (owner, vrf, match direction, priority, table) fold
+ * into one group: one ipset holding the prefixes, one iptable entry
+ * marking packets that hit the set, one rule sending the mark to the
+ * action table. */
+struct zebra_pbr_agg_group {
+	int sock;
+	vrf_id_t vrf_id;
+	uint8_t family;
+	bool match_src;
+	uint32_t priority;
+	uint32_t table;
+
+	uint32_t id;
+	uint32_t fwmark;
+	char ipset_name[ZEBRA_IPSET_NAME_SIZE];
+
+	/* members keyed by the owner's rule unique */
+	struct hash *members;
+
+	/* the synthetic objects handed to the pbr backend */
+	struct zebra_pbr_ipset ipset;
+	struct zebra_pbr_iptable iptable;
+	struct zebra_pbr_rule rule;
+};
+
+struct zebra_pbr_agg_member {
+	uint32_t unique; /* owner's rule unique */
+	struct zebra_pbr_ipset_entry entry;
+};
+
+static uint32_t pbr_agg_group_hash_key(void *arg)
+{
+	struct zebra_pbr_agg_group *group = arg;
+	uint32_t key;
+
+	key = jhash_3words(group->vrf_id, group->table, group->priority,
+			   0x55aa5a5a);
+	return jhash_3words(group->sock, group->family, group->match_src, key);
+}
+
+static bool pbr_agg_group_hash_equal(const void *arg1, const void *arg2)
+{
+	const struct zebra_pbr_agg_group *g1 = arg1, *g2 = arg2;
+
+	return g1->sock == g2->sock && g1->vrf_id == g2->vrf_id
+	       && g1->family == g2->family && g1->match_src == g2->match_src
+	       && g1->priority == g2->priority && g1->table == g2->table;
+}
+
+static uint32_t pbr_agg_member_hash_key(void *arg)
+{
+	struct zebra_pbr_agg_member *member = arg;
+
+	return jhash_1word(member->unique, 0x7e3f1d2b);
+}
+
+static bool pbr_agg_member_hash_equal(const void *arg1, const void *arg2)
+{
+	const struct zebra_pbr_agg_member *m1 = arg1, *m2 = arg2;
+
+	return m1->unique == m2->unique;
+}
+
+/* only plain source-or-destination prefix matches with a table action
+ * can be folded into a set; everything else stays a discrete rule */
+static bool pbr_agg_rule_eligible(const struct zebra_pbr_rule *rule)
+{
+	uint32_t bm = rule->rule.filter.filter_bm;
+
+	if (rule->ifp || rule->rule.ifindex)
+		return false;
+	if (bm != PBR_FILTER_SRC_IP && bm != PBR_FILTER_DST_IP)
+		return false;
+	if (!rule->rule.action.table)
+		return false;
+	return true;
+}
+
+static void pbr_agg_group_key(const struct zebra_pbr_rule *rule,
+			      struct zebra_pbr_agg_group *key)
+{
+	bool match_src = rule->rule.filter.filter_bm & PBR_FILTER_SRC_IP;
+
+	memset(key, 0, sizeof(*key));
+	key->sock = rule->sock;
+	key->vrf_id = rule->vrf_id;
+	key->match_src = match_src;
+	key->family = match_src ? rule->rule.filter.src_ip.family
+				: rule->rule.filter.dst_ip.family;
+	key->priority = rule->rule.priority;
+	key->table = rule->rule.action.table;
+}
+
+/* first member: stand up the group's ipset, iptable and fwmark rule */
+static void *pbr_agg_group_alloc(void *arg)
+{
+	struct zebra_pbr_agg_group *key = arg;
+	struct zebra_pbr_agg_group *group;
+
+	group = XCALLOC(MTYPE_PBR_AGG_GROUP, sizeof(*group));
+	memcpy(group, key, sizeof(*key));
+
+	group->id = pbr_agg_next_group_id++;
+	group->fwmark = PBR_AGG_FWMARK_BASE + group->id;
+	snprintf(group->ipset_name, sizeof(group->ipset_name), "frr-agg-%u",
+		 group->id);
+	group->members = hash_create_size(32, pbr_agg_member_hash_key,
+					  pbr_agg_member_hash_equal,
+					  "PBR agg members");
+
+	group->ipset.sock = group->sock;
+	group->ipset.vrf_id = group->vrf_id;
+	group->ipset.unique = pbr_agg_next_unique++;
+	group->ipset.type = IPSET_NET;
+	strlcpy(group->ipset.ipset_name, group->ipset_name,
+		sizeof(group->ipset.ipset_name));
+	zebra_pbr_create_ipset(&group->ipset);
+
+	group->iptable.sock = group->sock;
+	group->iptable.vrf_id = group->vrf_id;
+	group->iptable.unique = pbr_agg_next_unique++;
+	group->iptable.type = IPSET_NET;
+	group->iptable.filter_bm = group->match_src ? MATCH_IP_SRC_SET
+						    : MATCH_IP_DST_SET;
+	group->iptable.fwmark = group->fwmark;
+	group->iptable.action = ZEBRA_IPTABLES_FORWARD;
+	group->iptable.interface_name_list = list_new();
+	strlcpy(group->iptable.ipset_name, group->ipset_name,
+		sizeof(group->iptable.ipset_name));
+	zebra_pbr_add_iptable(&group->iptable);
+
+	group->rule.sock = group->sock;
+	group->rule.vrf_id = group->vrf_id;
+	group->rule.rule.vrf_id = group->vrf_id;
+	group->rule.rule.priority = group->priority;
+	group->rule.rule.unique = pbr_agg_next_unique++;
+	group->rule.rule.filter.filter_bm = PBR_FILTER_FWMARK;
+	group->rule.rule.filter.fwmark = group->fwmark;
+	group->rule.rule.action.table = group->table;
+	zebra_pbr_add_rule(&group->rule);
+
+	return group;
+}
+
+static void pbr_agg_group_teardown(struct zebra_pbr_agg_group *group)
+{
+	zebra_pbr_del_rule(&group->rule);
+	zebra_pbr_del_iptable(&group->iptable);
+	list_delete(&group->iptable.interface_name_list);
+	zebra_pbr_destroy_ipset(&group->ipset);
+
+	hash_release(pbr_agg_group_hash, group);
+	hash_free(group->members);
+	XFREE(MTYPE_PBR_AGG_GROUP, group);
+}
+
+static void *pbr_agg_member_alloc(void *arg)
+{
+	struct zebra_pbr_agg_member *key = arg;
+	struct zebra_pbr_agg_member *member;
+
+	member = XCALLOC(MTYPE_PBR_AGG_MEMBER, sizeof(*member));
+	member->unique = key->unique;
+	return member;
+}
+
+bool zebra_pbr_agg_rule_add(struct zebra_pbr_rule *rule)
+{
+	struct zebra_pbr_agg_group key, *group;
+	struct zebra_pbr_agg_member mkey, *member;
+	const struct prefix *p;
+
+	if (!pbr_agg_enabled || !pbr_agg_rule_eligible(rule))
+		return false;
+
+	pbr_agg_group_key(rule, &key);
+	group = hash_get(pbr_agg_group_hash, &key, pbr_agg_group_alloc);
+
+	memset(&mkey, 0, sizeof(mkey));
+	mkey.unique = rule->rule.unique;
+	member = hash_lookup(group->members, &mkey);
+	if (member)
+		/* replace semantics: drop the old prefix first */
+		zebra_pbr_del_ipset_entry(&member->entry);
+	else
+		member = hash_get(group->members, &mkey,
+				  pbr_agg_member_alloc);
+
+	p = group->match_src ? &rule->rule.filter.src_ip
+			     : &rule->rule.filter.dst_ip;
+
+	memset(&member->entry, 0, sizeof(member->entry));
+	member->entry.sock = group->sock;
+	member->entry.unique = pbr_agg_next_unique++;
+	if (group->match_src)
+		member->entry.src = *p;
+	else
+		member->entry.dst = *p;
+	member->entry.filter_bm = group->iptable.filter_bm;
+	member->entry.backpointer =
+		zebra_pbr_lookup_ipset_pername(group->ipset_name);
+	zebra_pbr_add_ipset_entry(&member->entry);
+
+	/* the owner sees its rule as installed */
+	kernel_pbr_rule_add_del_status(rule, ZEBRA_DPLANE_INSTALL_SUCCESS);
+	return true;
+}
+
+bool zebra_pbr_agg_rule_del(struct zebra_pbr_rule *rule)
+{
+	struct zebra_pbr_agg_group key, *group;
+	struct zebra_pbr_agg_member mkey, *member;
+
+	if (!pbr_agg_rule_eligible(rule))
+		return false;
+
+	pbr_agg_group_key(rule, &key);
+	group = hash_lookup(pbr_agg_group_hash, &key);
+	if (!group)
+		return false;
+
+	memset(&mkey, 0, sizeof(mkey));
+	mkey.unique = rule->rule.unique;
+	member = hash_lookup(group->members, &mkey);
+	if (!member)
+		return false;
+
+	zebra_pbr_del_ipset_entry(&member->entry);
+	hash_release(group->members, member);
+	XFREE(MTYPE_PBR_AGG_MEMBER, member);
+
+	if (!hashcount(group->members))
+		pbr_agg_group_teardown(group);
+
+	kernel_pbr_rule_add_del_status(rule, ZEBRA_DPLANE_DELETE_SUCCESS);
+	return true;
+}
+
+struct pbr_agg_walk_ctx {
+	int sock;
+	struct vty *vty;
+	struct zebra_pbr_agg_group *group;
+};
+
+static void pbr_agg_member_free_cb(struct hash_bucket *b, void *data)
+{
+	XFREE(MTYPE_PBR_AGG_MEMBER, b->data);
+}
+
+static int pbr_agg_client_close_walker(struct hash_bucket *b, void *data)
+{
+	struct zebra_pbr_agg_group *group = b->data;
+	struct pbr_agg_walk_ctx *ctx = data;
+
+	if (group->sock != ctx->sock)
+		return HASHWALK_CONTINUE;
+
+	ctx->group = group;
+	return HASHWALK_ABORT;
+}
+
+void zebra_pbr_agg_client_close(int sock)
+{
+	struct pbr_agg_walk_ctx ctx = {.sock = sock};
+
+	/* the kernel objects are swept by the per-client hash cleanup;
+	 * only the bookkeeping needs to go */
+	do {
+		ctx.group = NULL;
+		hash_walk(pbr_agg_group_hash, pbr_agg_client_close_walker,
+			  &ctx);
+		if (ctx.group) {
+			hash_iterate(ctx.group->members,
+				     pbr_agg_member_free_cb, NULL);
+			hash_release(pbr_agg_group_hash, ctx.group);
+			hash_free(ctx.group->members);
+			list_delete(&ctx.group->iptable.interface_name_list);
+			XFREE(MTYPE_PBR_AGG_GROUP, ctx.group);
+		}
+	} while (ctx.group);
+}
+
+bool zebra_pbr_agg_enabled_get(void)
+{
+	return pbr_agg_enabled;
+}
+
+DEFUN (pbr_rule_aggregation,
+       pbr_rule_aggregation_cmd,
+       "pbr rule-aggregation",
+       PBR_STR
+       "Fold rules sharing an action into ipset-backed matchers\n")
+{
+	pbr_agg_enabled = true;
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_pbr_rule_aggregation,
+       no_pbr_rule_aggregation_cmd,
+       "no pbr rule-aggregation",
+       NO_STR
+       PBR_STR
+       "Fold rules sharing an action into ipset-backed matchers\n")
+{
+	/* existing groups drain as their members are withdrawn; only
+	 * newly received rules go back to discrete installs */
+	pbr_agg_enabled = false;
+	return CMD_SUCCESS;
+}
+
+static int pbr_agg_show_walker(struct hash_bucket *b, void *data)
+{
+	struct zebra_pbr_agg_group *group = b->data;
+	struct pbr_agg_walk_ctx *ctx = data;
+
+	vty_out(ctx->vty,
+		"%-12s %8u %-5s %10u 0x%-8x %8lu\n",
+		group->ipset_name, group->vrf_id,
+		group->match_src ? "src" : "dst", group->table, group->fwmark,
+		hashcount(group->members));
+	return HASHWALK_CONTINUE;
+}
+
+DEFUN (show_pbr_rule_aggregation,
+       show_pbr_rule_aggregation_cmd,
+       "show pbr rule-aggregation",
+       SHOW_STR
+       PBR_STR
+       "Fold rules sharing an action into ipset-backed matchers\n")
+{
+	struct pbr_agg_walk_ctx ctx = {.vty = vty};
+
+	vty_out(vty, "Rule aggregation: %s, %lu groups\n",
+		pbr_agg_enabled ? "enabled" : "disabled",
+		hashcount(pbr_agg_group_hash));
+	if (hashcount(pbr_agg_group_hash)) {
+		vty_out(vty, "%-12s %8s %-5s %10s %-10s %8s\n", "Set", "VRF",
+			"Match", "Table", "Fwmark", "Members");
+		hash_walk(pbr_agg_group_hash, pbr_agg_show_walker, &ctx);
+	}
+	return CMD_SUCCESS;
+}
+
+void zebra_pbr_agg_init(void)
+{
+	pbr_agg_group_hash =
+		hash_create_size(8, pbr_agg_group_hash_key,
+				 pbr_agg_group_hash_equal, "PBR agg groups");
+
+	install_element(CONFIG_NODE, &pbr_rule_aggregation_cmd);
+	install_element(CONFIG_NODE, &no_pbr_rule_aggregation_cmd);
+	install_element(VIEW_NODE, &show_pbr_rule_aggregation_cmd);
+}
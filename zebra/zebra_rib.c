@@ -21,6 +21,7 @@
 #include <zebra.h>
 
 #include "command.h"
+#include "frratomic.h"
 #include "if.h"
 #include "linklist.h"
 #include "log.h"
@@ -48,7 +49,9 @@
 #include "zebra/zapi_msg.h"
 #include "zebra/zebra_errors.h"
 #include "zebra/zebra_memory.h"
+#include "zebra/zebra_fib_state.h"
 #include "zebra/zebra_ns.h"
+#include "zebra/zebra_pbr.h"
 #include "zebra/zebra_rnh.h"
 #include "zebra/zebra_routemap.h"
 #include "zebra/zebra_vrf.h"
@@ -57,11 +60,20 @@
 #include "zebra/zebra_dplane.h"
 
 /*
- * Event, list, and mutex for delivery of dataplane results
+ * Results from the dataplane pthread are returned to the main thread
+ * through a lock-free stack of completed-context batches: the dplane
+ * side pushes a batch per results callback, and the main thread swaps
+ * out the whole stack in one atomic exchange.
  */
-static pthread_mutex_t dplane_mutex;
+struct rib_dplane_batch {
+	struct dplane_ctx_q ctxlist;
+	struct rib_dplane_batch *next;
+};
+
+static struct rib_dplane_batch *_Atomic rib_dplane_batches;
 static struct thread *t_dplane;
-static struct dplane_ctx_q rib_dplane_q;
+
+DEFINE_MTYPE_STATIC(ZEBRA, RIB_DPLANE_BATCH, "Dplane result batch")
 
 DEFINE_HOOK(rib_update, (struct route_node * rn, const char *reason),
 	    (rn, reason))
@@ -1067,6 +1079,14 @@ void rib_install_kernel(struct route_node *rn, struct route_entry *re,
 		}
 	}
 
+	/*
+	 * Post-restart reconciliation: if persisted pre-restart state
+	 * says the kernel already holds exactly this route, flag the
+	 * update so the dataplane skips reprogramming it.
+	 */
+	if (!old && zebra_fib_state_check(rn, re))
+		SET_FLAG(re->status, ROUTE_ENTRY_RECONCILED);
+
 	/*
 	 * If this is a replace to a new RE let the originator of the RE
 	 * know that they've lost
@@ -1113,6 +1133,8 @@ void rib_install_kernel(struct route_node *rn, struct route_entry *re,
 		break;
 	}
 
+	UNSET_FLAG(re->status, ROUTE_ENTRY_RECONCILED);
+
 	return;
 }
 
@@ -1563,6 +1585,7 @@ static void rib_process(struct route_node *rn)
 	rib_dest_t *dest;
 	struct zebra_vrf *zvrf = NULL;
 	const struct prefix *p, *src_p;
+	bool entry_changes_only = false;
 
 	srcdest_rnode_prefixes(rn, &p, &src_p);
 	vrf_id_t vrf_id = VRF_UNKNOWN;
@@ -1573,6 +1596,16 @@ static void rib_process(struct route_node *rn)
 	if (dest) {
 		zvrf = rib_dest_vrf(dest);
 		vrf_id = zvrf_id(zvrf);
+
+		/* Consume the 'entry change only' hint; when set, entries
+		 * without ROUTE_ENTRY_CHANGED have not been affected by any
+		 * external event since their last evaluation and need not
+		 * have their nexthops re-checked.
+		 */
+		if (CHECK_FLAG(dest->flags, RIB_DEST_ENTRY_TRIGGERED)) {
+			entry_changes_only = true;
+			UNSET_FLAG(dest->flags, RIB_DEST_ENTRY_TRIGGERED);
+		}
 	}
 
 	if (IS_ZEBRA_DEBUG_RIB)
@@ -1590,6 +1623,50 @@ static void rib_process(struct route_node *rn)
 	if (dest)
 		old_fib = dest->selected_fib;
 
+	/* Fast path: when triggered only by changed entries, and none of
+	 * the changed entries can displace the currently selected/FIB
+	 * entry on distance alone, just refresh the changed entries and
+	 * skip the full selection/installation pass.
+	 */
+	if (entry_changes_only && old_fib
+	    && CHECK_FLAG(old_fib->flags, ZEBRA_FLAG_SELECTED)
+	    && !CHECK_FLAG(old_fib->status,
+			   ROUTE_ENTRY_CHANGED | ROUTE_ENTRY_REMOVED)) {
+		bool fastpath = true;
+
+		RNODE_FOREACH_RE (rn, re) {
+			if (re == old_fib)
+				continue;
+
+			if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED)
+			    || CHECK_FLAG(re->flags, ZEBRA_FLAG_FIB_OVERRIDE)
+			    || (CHECK_FLAG(re->status, ROUTE_ENTRY_CHANGED)
+				&& re->distance <= old_fib->distance)) {
+				fastpath = false;
+				break;
+			}
+		}
+
+		if (fastpath) {
+			RNODE_FOREACH_RE (rn, re) {
+				if (!CHECK_FLAG(re->status,
+						ROUTE_ENTRY_CHANGED))
+					continue;
+
+				nexthop_active_update(rn, re, false);
+				UNSET_FLAG(re->status, ROUTE_ENTRY_CHANGED);
+				UNSET_FLAG(re->status,
+					   ROUTE_ENTRY_NEXTHOPS_CHANGED);
+			}
+
+			if (IS_ZEBRA_DEBUG_RIB_DETAILED)
+				zlog_debug(
+					"%u:%s: Fast path: changed entries cannot displace selected re %p",
+					vrf_id, buf, (void *)old_fib);
+			return;
+		}
+	}
+
 	RNODE_FOREACH_RE_SAFE (rn, re, next) {
 		if (IS_ZEBRA_DEBUG_RIB_DETAILED)
 			zlog_debug(
@@ -1629,7 +1706,9 @@ static void rib_process(struct route_node *rn)
 		 * recursive NHs.
 		 */
 		if (!CHECK_FLAG(re->status, ROUTE_ENTRY_CHANGED)
-		    && !nexthop_active_update(rn, re, false)) {
+		    && !(entry_changes_only
+				 ? re->nexthop_active_num
+				 : nexthop_active_update(rn, re, false))) {
 			if (re->type == ZEBRA_ROUTE_TABLE) {
 				/* XXX: HERE BE DRAGONS!!!!!
 				 * In all honesty, I have not yet figured out
@@ -1991,6 +2070,7 @@ static void rib_process_result(struct zebra_dplane_ctx *ctx)
 				zvrf->installs++;
 				/* Set flag for nexthop tracking processing */
 				zvrf->flags |= ZEBRA_VRF_RIB_SCHEDULED;
+				zebra_rnh_mark_dirty(zvrf, dest_pfx);
 			}
 
 			/* Redistribute */
@@ -2139,6 +2219,9 @@ static void do_nht_processing(void)
 		zebra_evaluate_rnh(zvrf, AFI_IP6, 0, RNH_NEXTHOP_TYPE, NULL);
 		zebra_evaluate_rnh(zvrf, AFI_IP6, 0, RNH_IMPORT_CHECK_TYPE,
 				   NULL);
+
+		/* All rnh tables of this VRF have now seen the changes. */
+		zebra_rnh_clear_dirty(zvrf);
 	}
 
 	/* Schedule LSPs for processing, if needed. */
@@ -2153,6 +2236,168 @@ static void do_nht_processing(void)
 	}
 }
 
+/* Optional pool of RIB processing shards.
+ *
+ * When enabled via "zebra rib workers", route nodes are sharded by VRF
+ * id onto a set of private meta queues, each drained in bounded batches
+ * by its own task on the main pthread.  rib_process() and its side
+ * effects - redistribution, owner notification, rib_dest_t teardown -
+ * are not thread-safe against the rest of zebra, so the shards do NOT
+ * run on their own pthreads; what the pool buys is fair interleaving
+ * between VRFs and with other main-thread work, instead of one VRF's
+ * flood monopolizing the single meta queue.
+ */
+struct rib_worker {
+	/* Shard owned by this worker */
+	struct meta_queue *mq;
+
+	/* Drain task, on the main pthread */
+	struct thread *t_run;
+};
+
+static struct rib_worker **rib_workers;
+static uint32_t rib_nworkers;
+
+/* Nodes handled per shard wakeup before yielding back to the master */
+#define RIB_WORKER_BATCH 128
+
+static struct meta_queue *meta_queue_new(void);
+
+static int rib_worker_run(struct thread *thread)
+{
+	struct rib_worker *worker = THREAD_ARG(thread);
+	uint32_t queue_len, queue_limit;
+	unsigned int processed = 0;
+	unsigned int i;
+
+	/* Apply the same dataplane backpressure as meta_queue_process() */
+	queue_limit = dplane_get_in_queue_limit();
+	queue_len = dplane_get_in_queue_len();
+	if (queue_len > queue_limit) {
+		thread_add_timer_msec(zrouter.master, rib_worker_run, worker,
+				      10, &worker->t_run);
+		return 0;
+	}
+
+	while (processed < RIB_WORKER_BATCH) {
+		bool found = false;
+
+		for (i = 0; i < MQ_SIZE; i++)
+			if (process_subq(worker->mq->subq[i], i)) {
+				worker->mq->size--;
+				found = true;
+				break;
+			}
+
+		if (!found)
+			break;
+		processed++;
+	}
+
+	if (worker->mq->size)
+		thread_add_event(zrouter.master, rib_worker_run, worker, 0,
+				 &worker->t_run);
+
+	if (processed)
+		do_nht_processing();
+	return 0;
+}
+
+/* Shard selection: a VRF maps to exactly one worker.  Keyed off the
+ * node's table rather than its route entries, so a node is always
+ * handled by the same shard even while it holds no entries.
+ */
+static struct rib_worker *rib_worker_pick(struct route_node *rn)
+{
+	rib_table_info_t *info = srcdest_rnode_table_info(rn);
+	vrf_id_t vrf_id = info->zvrf ? zvrf_id(info->zvrf) : VRF_DEFAULT;
+
+	return rib_workers[vrf_id % rib_nworkers];
+}
+
+static struct rib_worker *rib_worker_create(uint32_t index)
+{
+	struct rib_worker *worker;
+
+	worker = XCALLOC(MTYPE_WORK_QUEUE, sizeof(struct rib_worker));
+	worker->mq = meta_queue_new();
+
+	return worker;
+}
+
+static void rib_worker_destroy(struct rib_worker *worker)
+{
+	THREAD_OFF(worker->t_run);
+	meta_queue_free(worker->mq);
+	XFREE(MTYPE_WORK_QUEUE, worker);
+}
+
+uint32_t rib_workers_get(void)
+{
+	return rib_nworkers;
+}
+
+/* true when no route nodes are waiting in the main meta queue or in
+ * any worker's shard */
+bool rib_queues_empty(void)
+{
+	uint32_t i;
+
+	if (zrouter.mq->size)
+		return false;
+	for (i = 0; i < rib_nworkers; i++) {
+		if (rib_workers[i]->mq->size)
+			return false;
+	}
+
+	return true;
+}
+
+/* Resize the worker pool. Refused while any work is queued, since moving
+ * queued nodes between shards would break per-VRF ordering.
+ */
+int rib_workers_set(uint32_t nworkers)
+{
+	uint32_t i;
+
+	if (nworkers == rib_nworkers)
+		return 0;
+
+	if (zrouter.mq->size)
+		return -1;
+	for (i = 0; i < rib_nworkers; i++) {
+		if (rib_workers[i]->mq->size)
+			return -1;
+	}
+
+	for (i = nworkers; i < rib_nworkers; i++)
+		rib_worker_destroy(rib_workers[i]);
+
+	if (nworkers == 0) {
+		XFREE(MTYPE_WORK_QUEUE, rib_workers);
+		rib_nworkers = 0;
+		return 0;
+	}
+
+	rib_workers = XREALLOC(MTYPE_WORK_QUEUE, rib_workers,
+			       nworkers * sizeof(struct rib_worker *));
+	for (i = rib_nworkers; i < nworkers; i++)
+		rib_workers[i] = rib_worker_create(i);
+
+	rib_nworkers = nworkers;
+	return 0;
+}
+
+void rib_workers_terminate(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < rib_nworkers; i++)
+		rib_worker_destroy(rib_workers[i]);
+	XFREE(MTYPE_WORK_QUEUE, rib_workers);
+	rib_nworkers = 0;
+}
+
 /* Dispatch the meta queue by picking, processing and unlocking the next RN from
  * a non-empty sub-queue with lowest priority. wq is equal to zebra->ribq and
  * data
@@ -2245,15 +2490,33 @@ static void rib_meta_queue_add(struct meta_queue *mq, struct route_node *rn)
 			    (void *)rn, qindex);
 
 	zvrf = zebra_vrf_lookup_by_id(re->vrf_id);
-	if (zvrf)
+	if (zvrf) {
 		zvrf->flags |= ZEBRA_VRF_RIB_SCHEDULED;
+		zebra_rnh_mark_dirty(zvrf, &rn->p);
+	}
 }
 
 /* Add route_node to work queue and schedule processing */
-void rib_queue_add(struct route_node *rn)
+static void rib_queue_add_internal(struct route_node *rn, bool entry_change)
 {
+	rib_dest_t *dest;
+
 	assert(rn);
 
+	/* Track whether this (re)queue was caused only by changed route
+	 * entries, so rib_process() can skip re-evaluating the others.
+	 * An event-triggered queue always forces a full evaluation.
+	 */
+	dest = rib_dest_from_rnode(rn);
+	if (dest) {
+		if (entry_change) {
+			if (!CHECK_FLAG(dest->flags, RIB_ROUTE_ANY_QUEUED))
+				SET_FLAG(dest->flags,
+					 RIB_DEST_ENTRY_TRIGGERED);
+		} else
+			UNSET_FLAG(dest->flags, RIB_DEST_ENTRY_TRIGGERED);
+	}
+
 	/* Pointless to queue a route_node with no RIB entries to add or remove
 	 */
 	if (!rnode_to_ribs(rn)) {
@@ -2269,6 +2532,18 @@ void rib_queue_add(struct route_node *rn)
 		return;
 	}
 
+	/* With a worker pool active, hand the node to its VRF's shard
+	 * instead of the main-thread meta queue.
+	 */
+	if (rib_nworkers) {
+		struct rib_worker *worker = rib_worker_pick(rn);
+
+		rib_meta_queue_add(worker->mq, rn);
+		thread_add_event(zrouter.master, rib_worker_run, worker, 0,
+				 &worker->t_run);
+		return;
+	}
+
 	/*
 	 * The RIB queue should normally be either empty or holding the only
 	 * work_queue_item element. In the latter case this element would
@@ -2285,6 +2560,50 @@ void rib_queue_add(struct route_node *rn)
 	return;
 }
 
+void rib_queue_add(struct route_node *rn)
+{
+	rib_queue_add_internal(rn, false);
+}
+
+/* Queue a route_node whose only pending work is changed route entries */
+static void rib_queue_entry_add(struct route_node *rn)
+{
+	rib_queue_add_internal(rn, true);
+}
+
+/* Flush any queued route nodes belonging to 'zvrf' from the main meta
+ * queue and from all worker shards; used when a VRF goes away.
+ */
+void rib_meta_queue_purge_vrf(struct zebra_vrf *zvrf)
+{
+	struct meta_queue *mq;
+	uint32_t w;
+	unsigned i;
+
+	for (w = 0; w <= rib_nworkers; w++) {
+		if (w == rib_nworkers)
+			mq = zrouter.mq;
+		else
+			mq = rib_workers[w]->mq;
+
+		for (i = 0; i < MQ_SIZE; i++) {
+			struct listnode *lnode, *nnode;
+			struct route_node *rnode;
+			rib_dest_t *dest;
+
+			for (ALL_LIST_ELEMENTS(mq->subq[i], lnode, nnode,
+					       rnode)) {
+				dest = rib_dest_from_rnode(rnode);
+				if (dest && rib_dest_vrf(dest) == zvrf) {
+					route_unlock_node(rnode);
+					list_delete_node(mq->subq[i], lnode);
+					mq->size--;
+				}
+			}
+		}
+	}
+}
+
 /* Create new meta queue.
    A destructor function doesn't seem to be necessary here.
  */
@@ -2405,6 +2724,9 @@ static void rib_link(struct route_node *rn, struct route_entry *re, int process)
 	re->next = head;
 	dest->routes = re;
 
+	re->rn = rn;
+	redistribute_list_add(rn, re);
+
 	afi = (rn->p.family == AF_INET)
 		      ? AFI_IP
 		      : (rn->p.family == AF_INET6) ? AFI_IP6 : AFI_MAX;
@@ -2412,7 +2734,7 @@ static void rib_link(struct route_node *rn, struct route_entry *re, int process)
 		rmap_name = zebra_get_import_table_route_map(afi, re->table);
 		zebra_add_import_table_entry(rn, re, rmap_name);
 	} else if (process)
-		rib_queue_add(rn);
+		rib_queue_entry_add(rn);
 }
 
 static void rib_addnode(struct route_node *rn,
@@ -2465,6 +2787,9 @@ void rib_unlink(struct route_node *rn, struct route_entry *re)
 	if (dest->selected_fib == re)
 		dest->selected_fib = NULL;
 
+	redistribute_list_del(re);
+	re->rn = NULL;
+
 	nexthops_free(re->ng.nexthop);
 	XFREE(MTYPE_RE, re);
 }
@@ -2494,7 +2819,7 @@ void rib_delnode(struct route_node *rn, struct route_entry *re)
 
 		rib_unlink(rn, re);
 	} else {
-		rib_queue_add(rn);
+		rib_queue_entry_add(rn);
 	}
 }
 
@@ -3263,29 +3588,31 @@ done:
  */
 static int rib_process_dplane_results(struct thread *thread)
 {
+	struct rib_dplane_batch *batch, *next, *prev;
 	struct zebra_dplane_ctx *ctx;
 	struct dplane_ctx_q ctxlist;
 
-	/* Dequeue a list of completed updates with one lock/unlock cycle */
+	/* Take the entire stack of batches in one atomic swap. The stack
+	 * is LIFO, so reverse it to process results in arrival order.
+	 */
+	batch = atomic_exchange_explicit(&rib_dplane_batches, NULL,
+					 memory_order_acquire);
+	prev = NULL;
+	while (batch) {
+		next = batch->next;
+		batch->next = prev;
+		prev = batch;
+		batch = next;
+	}
 
-	do {
-		TAILQ_INIT(&ctxlist);
+	for (batch = prev; batch; batch = next) {
+		next = batch->next;
 
-		/* Take lock controlling queue of results */
-		pthread_mutex_lock(&dplane_mutex);
-		{
-			/* Dequeue list of context structs */
-			dplane_ctx_list_append(&ctxlist, &rib_dplane_q);
-		}
-		pthread_mutex_unlock(&dplane_mutex);
+		TAILQ_INIT(&ctxlist);
+		dplane_ctx_list_append(&ctxlist, &batch->ctxlist);
+		XFREE(MTYPE_RIB_DPLANE_BATCH, batch);
 
-		/* Dequeue context block */
 		ctx = dplane_ctx_dequeue(&ctxlist);
-
-		/* If we've emptied the results queue, we're done */
-		if (ctx == NULL)
-			break;
-
 		while (ctx) {
 			switch (dplane_ctx_get_op(ctx)) {
 			case DPLANE_OP_ROUTE_INSTALL:
@@ -3305,6 +3632,11 @@ static int rib_process_dplane_results(struct thread *thread)
 				handle_pw_result(ctx);
 				break;
 
+			case DPLANE_OP_RULE_ADD:
+			case DPLANE_OP_RULE_DELETE:
+				zebra_pbr_dplane_result(ctx);
+				break;
+
 			default:
 				/* Don't expect this: just return the struct? */
 				dplane_ctx_fini(&ctx);
@@ -3313,8 +3645,7 @@ static int rib_process_dplane_results(struct thread *thread)
 
 			ctx = dplane_ctx_dequeue(&ctxlist);
 		}
-
-	} while (1);
+	}
 
 	/* Check for nexthop tracking processing after finishing with results */
 	do_nht_processing();
@@ -3329,13 +3660,21 @@ static int rib_process_dplane_results(struct thread *thread)
  */
 static int rib_dplane_results(struct dplane_ctx_q *ctxlist)
 {
-	/* Take lock controlling queue of results */
-	pthread_mutex_lock(&dplane_mutex);
-	{
-		/* Enqueue context blocks */
-		dplane_ctx_list_append(&rib_dplane_q, ctxlist);
-	}
-	pthread_mutex_unlock(&dplane_mutex);
+	struct rib_dplane_batch *batch, *head;
+
+	/* Wrap the completed contexts in a batch and push it onto the
+	 * lock-free results stack.
+	 */
+	batch = XCALLOC(MTYPE_RIB_DPLANE_BATCH, sizeof(*batch));
+	TAILQ_INIT(&batch->ctxlist);
+	dplane_ctx_list_append(&batch->ctxlist, ctxlist);
+
+	head = atomic_load_explicit(&rib_dplane_batches, memory_order_relaxed);
+	do {
+		batch->next = head;
+	} while (!atomic_compare_exchange_weak_explicit(
+		&rib_dplane_batches, &head, batch, memory_order_release,
+		memory_order_relaxed));
 
 	/* Ensure event is signalled to zebra main pthread */
 	thread_add_event(zrouter.master, rib_process_dplane_results, NULL, 0,
@@ -3350,8 +3689,7 @@ void rib_init(void)
 	rib_queue_init();
 
 	/* Init dataplane, and register for results */
-	pthread_mutex_init(&dplane_mutex, NULL);
-	TAILQ_INIT(&rib_dplane_q);
+	atomic_store_explicit(&rib_dplane_batches, NULL, memory_order_relaxed);
 	zebra_dplane_init(rib_dplane_results);
 }
 
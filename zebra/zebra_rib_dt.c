@@ -0,0 +1,438 @@
+/*
+ * zebra_rib_dt.c
+ *
+ * Copyright (C) 2019  Cumulus Networks, Inc.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * RIB load harness.  Generates synthetic zapi route streams and feeds
+ * them straight into the zread handlers (zserv_handle_commands), the
+ * same path a real client's messages take, with the dataplane in null
+ * mode so nothing reaches the kernel.  Prefix count, nexthop diversity
+ * and churn ratio are parameterized, and the generator is a fixed-seed
+ * LCG, so runs are reproducible and comparable across builds.
+ *
+ *   # zebra rib-benchmark 500000 nexthops 16 churn 10 bulk
+ *   # show zebra rib-benchmark
+ *
+ * Install and delete completion are detected by polling the rib meta
+ * queues and the dataplane queue; per-stage latency histograms are in
+ * "show zebra dplane stats".
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "log.h"
+#include "memory.h"
+#include "prefix.h"
+#include "stream.h"
+#include "thread.h"
+#include "vrf.h"
+#include "zclient.h"
+
+#include "zebra/rib.h"
+#include "zebra/zserv.h"
+#include "zebra/zapi_msg.h"
+#include "zebra/zebra_router.h"
+#include "zebra/zebra_vrf.h"
+#include "zebra/zebra_dplane.h"
+
+/* synthetic routes: 10.0.0.0/8 host routes, resolving recursively over
+ * a blackhole anchor covering the nexthop pool */
+#define ZRIB_DT_PREFIX_BASE  0x0a000000 /* 10.0.0.0 */
+#define ZRIB_DT_NEXTHOP_BASE 0xc6336400 /* 198.51.100.0 */
+#define ZRIB_DT_ANCHOR_PLEN  24
+#define ZRIB_DT_MAX_NEXTHOPS 64
+
+#define ZRIB_DT_LCG_SEED 0x5eed5eed
+#define ZRIB_DT_POLL_MSEC 100
+
+enum zrib_dt_phase {
+	ZRIB_DT_IDLE = 0,
+	ZRIB_DT_INSTALLING,
+	ZRIB_DT_DELETING,
+	ZRIB_DT_DONE,
+};
+
+static struct zrib_dt_stats {
+	enum zrib_dt_phase phase;
+
+	uint32_t routes;
+	uint32_t nexthops;
+	uint32_t churn;
+	bool bulk;
+
+	unsigned long msgs;
+	unsigned long churn_updates;
+	unsigned long churn_deletes;
+
+	struct timeval start;
+	struct timeval feed_done;
+	struct timeval install_done;
+	struct timeval delete_start;
+	struct timeval delete_done;
+} zrib_dt;
+
+static struct zserv *zrib_dt_client;
+static struct thread *zrib_dt_timer;
+static uint32_t zrib_dt_lcg;
+static int zrib_dt_idle_polls;
+static bool zrib_dt_saved_null_mode;
+
+static uint32_t zrib_dt_rand(void)
+{
+	zrib_dt_lcg = zrib_dt_lcg * 1103515245 + 12345;
+	return zrib_dt_lcg >> 8;
+}
+
+/* deterministic per-route decisions, shared by the churn and cleanup
+ * phases so cleanup knows which prefixes churn already deleted */
+static bool zrib_dt_churned(uint32_t i, uint32_t nchurn)
+{
+	return i < nchurn && (i & 1);
+}
+
+static void zrib_dt_send(struct stream *s)
+{
+	stream_putw_at(s, 0, stream_get_endp(s));
+	zserv_handle_commands(zrib_dt_client, s);
+	zrib_dt.msgs++;
+}
+
+static void zrib_dt_api_init(struct zapi_route *api, uint32_t i)
+{
+	memset(api, 0, sizeof(*api));
+	api->vrf_id = VRF_DEFAULT;
+	api->type = ZEBRA_ROUTE_SHARP;
+	api->safi = SAFI_UNICAST;
+	api->flags = ZEBRA_FLAG_ALLOW_RECURSION;
+	api->prefix.family = AF_INET;
+	api->prefix.prefixlen = IPV4_MAX_BITLEN;
+	api->prefix.u.prefix4.s_addr = htonl(ZRIB_DT_PREFIX_BASE + i);
+
+	SET_FLAG(api->message, ZAPI_MESSAGE_NEXTHOP);
+	api->nexthop_num = 1;
+	api->nexthops[0].vrf_id = VRF_DEFAULT;
+	api->nexthops[0].type = NEXTHOP_TYPE_IPV4;
+	api->nexthops[0].gate.ipv4.s_addr = htonl(
+		ZRIB_DT_NEXTHOP_BASE + 1 + zrib_dt_rand() % zrib_dt.nexthops);
+}
+
+/* blackhole anchor covering the nexthop pool, so the gateway nexthops
+ * of the synthetic routes resolve without any interfaces configured */
+static void zrib_dt_anchor(struct stream *s, uint8_t cmd)
+{
+	struct zapi_route api;
+
+	memset(&api, 0, sizeof(api));
+	api.vrf_id = VRF_DEFAULT;
+	api.type = ZEBRA_ROUTE_SHARP;
+	api.safi = SAFI_UNICAST;
+	api.prefix.family = AF_INET;
+	api.prefix.prefixlen = ZRIB_DT_ANCHOR_PLEN;
+	api.prefix.u.prefix4.s_addr = htonl(ZRIB_DT_NEXTHOP_BASE);
+
+	SET_FLAG(api.message, ZAPI_MESSAGE_NEXTHOP);
+	api.nexthop_num = 1;
+	api.nexthops[0].vrf_id = VRF_DEFAULT;
+	api.nexthops[0].type = NEXTHOP_TYPE_BLACKHOLE;
+	api.nexthops[0].bh_type = BLACKHOLE_NULL;
+
+	stream_reset(s);
+	zapi_route_encode(cmd, s, &api);
+	zrib_dt_send(s);
+}
+
+static void zrib_dt_feed_adds(struct stream *s)
+{
+	struct zapi_route api;
+	struct prefix prefixes[ZAPI_BULK_ROUTES_MAX];
+	uint32_t i;
+	uint16_t batch;
+
+	for (i = 0; i < zrib_dt.routes;) {
+		zrib_dt_api_init(&api, i);
+		i++;
+
+		if (!zrib_dt.bulk) {
+			stream_reset(s);
+			zapi_route_encode(ZEBRA_ROUTE_ADD, s, &api);
+			zrib_dt_send(s);
+			continue;
+		}
+
+		/* the template carries the first prefix; up to
+		 * ZAPI_BULK_ROUTES_MAX more ride behind it, all sharing
+		 * the template's nexthop */
+		for (batch = 0;
+		     batch < ZAPI_BULK_ROUTES_MAX && i < zrib_dt.routes;
+		     batch++, i++) {
+			memset(&prefixes[batch], 0, sizeof(prefixes[batch]));
+			prefixes[batch].family = AF_INET;
+			prefixes[batch].prefixlen = IPV4_MAX_BITLEN;
+			prefixes[batch].u.prefix4.s_addr =
+				htonl(ZRIB_DT_PREFIX_BASE + i);
+		}
+
+		stream_reset(s);
+		zapi_route_encode_bulk(ZEBRA_ROUTE_ADD_BULK, s, &api, prefixes,
+				       batch);
+		zrib_dt_send(s);
+	}
+}
+
+/* churn: re-add part of the table with fresh nexthops, delete every
+ * other churned prefix */
+static void zrib_dt_feed_churn(struct stream *s)
+{
+	struct zapi_route api;
+	uint32_t i, nchurn;
+
+	nchurn = (uint64_t)zrib_dt.routes * zrib_dt.churn / 100;
+
+	for (i = 0; i < nchurn; i++) {
+		zrib_dt_api_init(&api, i);
+
+		stream_reset(s);
+		if (zrib_dt_churned(i, nchurn)) {
+			zapi_route_encode(ZEBRA_ROUTE_DELETE, s, &api);
+			zrib_dt.churn_deletes++;
+		} else {
+			zapi_route_encode(ZEBRA_ROUTE_ADD, s, &api);
+			zrib_dt.churn_updates++;
+		}
+		zrib_dt_send(s);
+	}
+}
+
+static void zrib_dt_feed_deletes(struct stream *s)
+{
+	struct zapi_route api;
+	uint32_t i, nchurn;
+
+	nchurn = (uint64_t)zrib_dt.routes * zrib_dt.churn / 100;
+
+	for (i = 0; i < zrib_dt.routes; i++) {
+		if (zrib_dt_churned(i, nchurn))
+			continue;
+
+		zrib_dt_api_init(&api, i);
+		stream_reset(s);
+		zapi_route_encode(ZEBRA_ROUTE_DELETE, s, &api);
+		zrib_dt_send(s);
+	}
+
+	zrib_dt_anchor(s, ZEBRA_ROUTE_DELETE);
+}
+
+static double zrib_dt_seconds(const struct timeval *from,
+			      const struct timeval *to)
+{
+	struct timeval delta;
+
+	timersub(to, from, &delta);
+	return delta.tv_sec + delta.tv_usec / 1e6;
+}
+
+static bool zrib_dt_drained(void)
+{
+	if (!rib_queues_empty() || dplane_get_in_queue_len()) {
+		zrib_dt_idle_polls = 0;
+		return false;
+	}
+
+	/* require two consecutive idle samples; contexts can be between
+	 * the dataplane and the result queue when we look */
+	return ++zrib_dt_idle_polls >= 2;
+}
+
+static int zrib_dt_poll(struct thread *thread)
+{
+	struct stream *s;
+
+	if (!zrib_dt_drained()) {
+		thread_add_timer_msec(zrouter.master, zrib_dt_poll, NULL,
+				      ZRIB_DT_POLL_MSEC, &zrib_dt_timer);
+		return 0;
+	}
+	zrib_dt_idle_polls = 0;
+
+	if (zrib_dt.phase == ZRIB_DT_INSTALLING) {
+		monotime(&zrib_dt.install_done);
+		zlog_info(
+			"rib-benchmark: %u routes installed in %.3fs (%.0f routes/s end-to-end)",
+			zrib_dt.routes,
+			zrib_dt_seconds(&zrib_dt.start,
+					&zrib_dt.install_done),
+			zrib_dt.routes
+				/ zrib_dt_seconds(&zrib_dt.start,
+						  &zrib_dt.install_done));
+
+		/* clean up, timing the delete side as well */
+		zrib_dt.phase = ZRIB_DT_DELETING;
+		monotime(&zrib_dt.delete_start);
+		s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+		zrib_dt_feed_deletes(s);
+		stream_free(s);
+
+		thread_add_timer_msec(zrouter.master, zrib_dt_poll, NULL,
+				      ZRIB_DT_POLL_MSEC, &zrib_dt_timer);
+		return 0;
+	}
+
+	/* delete phase drained: done */
+	monotime(&zrib_dt.delete_done);
+	zrib_dt.phase = ZRIB_DT_DONE;
+	dplane_null_mode_set(zrib_dt_saved_null_mode);
+
+	zlog_info(
+		"rib-benchmark: cleanup done in %.3fs; %lu messages total, see \"show zebra rib-benchmark\"",
+		zrib_dt_seconds(&zrib_dt.delete_start, &zrib_dt.delete_done),
+		zrib_dt.msgs);
+
+	return 0;
+}
+
+static void zrib_dt_run(uint32_t routes, uint32_t nexthops, uint32_t churn,
+			bool bulk)
+{
+	struct stream *s;
+
+	memset(&zrib_dt, 0, sizeof(zrib_dt));
+	zrib_dt.phase = ZRIB_DT_INSTALLING;
+	zrib_dt.routes = routes;
+	zrib_dt.nexthops = nexthops;
+	zrib_dt.churn = churn;
+	zrib_dt.bulk = bulk;
+	zrib_dt_lcg = ZRIB_DT_LCG_SEED;
+	zrib_dt_idle_polls = 0;
+
+	if (!zrib_dt_client)
+		zrib_dt_client = XCALLOC(MTYPE_TMP, sizeof(struct zserv));
+
+	zrib_dt_saved_null_mode = dplane_null_mode_get();
+	dplane_null_mode_set(true);
+
+	monotime(&zrib_dt.start);
+
+	s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	zrib_dt_anchor(s, ZEBRA_ROUTE_ADD);
+	zrib_dt_feed_adds(s);
+	zrib_dt_feed_churn(s);
+	stream_free(s);
+
+	monotime(&zrib_dt.feed_done);
+
+	thread_add_timer_msec(zrouter.master, zrib_dt_poll, NULL,
+			      ZRIB_DT_POLL_MSEC, &zrib_dt_timer);
+}
+
+DEFUN (zebra_rib_benchmark,
+       zebra_rib_benchmark_cmd,
+       "zebra rib-benchmark (1-1000000) [nexthops (1-64)] [churn (0-100)] [bulk]",
+       ZEBRA_STR
+       "Run the synthetic rib load harness\n"
+       "Number of routes to install\n"
+       "Nexthop diversity\n"
+       "Number of distinct nexthops to cycle through\n"
+       "Churn after the initial feed\n"
+       "Percentage of routes to re-announce or delete\n"
+       "Use ZEBRA_ROUTE_ADD_BULK messages for the initial feed\n")
+{
+	uint32_t routes, nexthops = 8, churn = 0;
+	bool bulk = false;
+	int idx = 0;
+
+	if (zrib_dt.phase == ZRIB_DT_INSTALLING
+	    || zrib_dt.phase == ZRIB_DT_DELETING) {
+		vty_out(vty, "%% rib-benchmark already running\n");
+		return CMD_WARNING;
+	}
+
+	argv_find(argv, argc, "(1-1000000)", &idx);
+	routes = strtoul(argv[idx]->arg, NULL, 10);
+	if (argv_find(argv, argc, "(1-64)", &idx))
+		nexthops = strtoul(argv[idx]->arg, NULL, 10);
+	if (argv_find(argv, argc, "(0-100)", &idx))
+		churn = strtoul(argv[idx]->arg, NULL, 10);
+	if (argv_find(argv, argc, "bulk", &idx))
+		bulk = true;
+
+	zrib_dt_run(routes, nexthops, churn, bulk);
+
+	vty_out(vty,
+		"Fed %lu messages (%u routes%s, %lu churn updates, %lu churn deletes) in %.3f s\n",
+		zrib_dt.msgs, zrib_dt.routes, zrib_dt.bulk ? ", bulk" : "",
+		zrib_dt.churn_updates, zrib_dt.churn_deletes,
+		zrib_dt_seconds(&zrib_dt.start, &zrib_dt.feed_done));
+	vty_out(vty,
+		"Install runs in the background; see \"show zebra rib-benchmark\"\n");
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (show_zebra_rib_benchmark,
+       show_zebra_rib_benchmark_cmd,
+       "show zebra rib-benchmark",
+       SHOW_STR
+       ZEBRA_STR
+       "RIB load harness results\n")
+{
+	const char *phase_str[] = {"idle", "installing", "deleting", "done"};
+	double feed, install;
+
+	if (zrib_dt.phase == ZRIB_DT_IDLE) {
+		vty_out(vty, "%% No rib-benchmark has been run\n");
+		return CMD_WARNING;
+	}
+
+	vty_out(vty, "rib-benchmark: %u routes, %u nexthops, %u%% churn%s (%s)\n",
+		zrib_dt.routes, zrib_dt.nexthops, zrib_dt.churn,
+		zrib_dt.bulk ? ", bulk" : "", phase_str[zrib_dt.phase]);
+	vty_out(vty, "  Messages fed:        %lu (%lu churn updates, %lu churn deletes)\n",
+		zrib_dt.msgs, zrib_dt.churn_updates, zrib_dt.churn_deletes);
+
+	feed = zrib_dt_seconds(&zrib_dt.start, &zrib_dt.feed_done);
+	vty_out(vty, "  Feed time:           %.3f s (%.0f msgs/s)\n", feed,
+		zrib_dt.msgs / feed);
+
+	if (timerisset(&zrib_dt.install_done)) {
+		install = zrib_dt_seconds(&zrib_dt.start,
+					  &zrib_dt.install_done);
+		vty_out(vty,
+			"  Install complete:    %.3f s (%.0f routes/s end-to-end)\n",
+			install, zrib_dt.routes / install);
+	}
+	if (timerisset(&zrib_dt.delete_done))
+		vty_out(vty, "  Cleanup time:        %.3f s\n",
+			zrib_dt_seconds(&zrib_dt.delete_start,
+					&zrib_dt.delete_done));
+
+	vty_out(vty,
+		"Per-stage latency histograms: \"show zebra dplane stats\"\n");
+
+	return CMD_SUCCESS;
+}
+
+void zrib_dt_init(void)
+{
+	install_element(ENABLE_NODE, &zebra_rib_benchmark_cmd);
+	install_element(VIEW_NODE, &show_zebra_rib_benchmark_cmd);
+}
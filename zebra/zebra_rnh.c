@@ -728,6 +728,92 @@ static void zebra_rnh_clear_nhc_flag(struct zebra_vrf *zvrf, afi_t afi,
 	}
 }
 
+/*
+ * Record a changed RIB prefix in the VRF's dirty set.  A tracked
+ * nexthop resolves via longest-prefix match, so only a change whose
+ * prefix covers the tracked address can affect it; remembering the
+ * changed prefixes lets the next evaluation pass restrict itself to
+ * the covered parts of the rnh tables.  Once the set overflows, the
+ * pass falls back to a full-table walk.
+ */
+void zebra_rnh_mark_dirty(struct zebra_vrf *zvrf, const struct prefix *p)
+{
+	afi_t afi;
+	uint16_t i;
+
+	afi = family2afi(p->family);
+	if (afi != AFI_IP && afi != AFI_IP6)
+		return;
+
+	if (zvrf->rnh_dirty_overflow[afi])
+		return;
+
+	/* Coalesce: a covering prefix already recorded subsumes p. */
+	for (i = 0; i < zvrf->rnh_dirty_num[afi]; i++)
+		if (prefix_match(&zvrf->rnh_dirty[afi][i], p))
+			return;
+
+	if (zvrf->rnh_dirty_num[afi] == ZEBRA_RNH_DIRTY_MAX) {
+		zvrf->rnh_dirty_overflow[afi] = true;
+		return;
+	}
+
+	prefix_copy(&zvrf->rnh_dirty[afi][zvrf->rnh_dirty_num[afi]++], p);
+}
+
+void zebra_rnh_clear_dirty(struct zebra_vrf *zvrf)
+{
+	afi_t afi;
+
+	for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+		zvrf->rnh_dirty_num[afi] = 0;
+		zvrf->rnh_dirty_overflow[afi] = false;
+	}
+}
+
+/* Walk the part of the rnh table covered by the given prefix, calling
+ * the per-entry function on each tracked entry.  The covered subtree is
+ * contiguous in iteration order, so this touches only the entries that
+ * the prefix can actually affect.
+ */
+static void zebra_rnh_walk_covered(struct zebra_vrf *zvrf, afi_t afi,
+				   rnh_type_t type,
+				   struct route_table *rnh_table,
+				   const struct prefix *p,
+				   void (*func)(struct zebra_vrf *zvrf,
+						afi_t afi, rnh_type_t type,
+						struct route_node *nrn))
+{
+	struct route_node *nrn;
+	struct route_node *next;
+
+	/* The node matching the prefix exactly, if any. */
+	nrn = route_node_lookup(rnh_table, p);
+	if (nrn) {
+		if (nrn->info)
+			func(zvrf, afi, type, nrn);
+		route_unlock_node(nrn);
+	}
+
+	nrn = route_table_get_next(rnh_table, p);
+	while (nrn && prefix_match(p, &nrn->p)) {
+		if (nrn->info)
+			func(zvrf, afi, type, nrn);
+		next = route_table_get_next(rnh_table, &nrn->p);
+		route_unlock_node(nrn);
+		nrn = next;
+	}
+	if (nrn)
+		route_unlock_node(nrn);
+}
+
+static void zebra_rnh_evaluate_entry_cb(struct zebra_vrf *zvrf, afi_t afi,
+					rnh_type_t type,
+					struct route_node *nrn)
+{
+	zebra_rnh_evaluate_entry(zvrf, afi, 0, type, nrn);
+}
+
 /* Evaluate all tracked entries (nexthops or routes for import into BGP)
  * of a particular VRF and address-family or a specific prefix.
  */
@@ -736,6 +822,7 @@ void zebra_evaluate_rnh(struct zebra_vrf *zvrf, afi_t afi, int force,
 {
 	struct route_table *rnh_table;
 	struct route_node *nrn;
+	uint16_t i;
 
 	rnh_table = get_rnh_table(zvrf->vrf->vrf_id, afi, type);
 	if (!rnh_table) // unexpected
@@ -749,6 +836,21 @@ void zebra_evaluate_rnh(struct zebra_vrf *zvrf, afi_t afi, int force,
 
 		if (nrn)
 			route_unlock_node(nrn);
+	} else if (!force && !zvrf->rnh_dirty_overflow[afi]
+		   && zvrf->rnh_dirty_num[afi]) {
+		/* Evaluate only the subtrees covered by the RIB changes
+		 * recorded since the last pass.  The caller clears the
+		 * dirty set via zebra_rnh_clear_dirty() once all rnh
+		 * tables of this VRF have been evaluated.
+		 */
+		for (i = 0; i < zvrf->rnh_dirty_num[afi]; i++)
+			zebra_rnh_walk_covered(zvrf, afi, type, rnh_table,
+					       &zvrf->rnh_dirty[afi][i],
+					       zebra_rnh_evaluate_entry_cb);
+		for (i = 0; i < zvrf->rnh_dirty_num[afi]; i++)
+			zebra_rnh_walk_covered(zvrf, afi, type, rnh_table,
+					       &zvrf->rnh_dirty[afi][i],
+					       zebra_rnh_clear_nhc_flag);
 	} else {
 		/* Evaluate entire table. */
 		nrn = route_top(rnh_table);
@@ -1059,7 +1161,7 @@ static int zebra_client_cleanup_rnh(struct zserv *client)
 			if (client->proto == ZEBRA_ROUTE_LDP) {
 				hash_iterate(zvrf->lsp_table,
 					     mpls_ldp_lsp_uninstall_all,
-					     zvrf->lsp_table);
+					     zvrf);
 				mpls_ldp_ftn_uninstall_all(zvrf, AFI_IP);
 				mpls_ldp_ftn_uninstall_all(zvrf, AFI_IP6);
 			}
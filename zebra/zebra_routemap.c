@@ -79,7 +79,8 @@ static int zebra_route_match_add(struct vty *vty, const char *command,
 		break;
 	case RMAP_COMPILE_SUCCESS:
 		if (type != RMAP_EVENT_MATCH_ADDED) {
-			route_map_upd8_dependency(type, arg, index->map->name);
+			route_map_upd8_dependency(type, arg, index->map->name,
+						  index);
 		}
 		break;
 	}
@@ -123,7 +124,8 @@ static int zebra_route_match_delete(struct vty *vty, const char *command,
 		break;
 	case RMAP_COMPILE_SUCCESS:
 		if (type != RMAP_EVENT_MATCH_DELETED && dep_name)
-			route_map_upd8_dependency(type, dep_name, rmap_name);
+			route_map_upd8_dependency(type, dep_name, rmap_name,
+						  index);
 		break;
 	}
 
@@ -1717,6 +1719,32 @@ void zebra_del_import_table_route_map(afi_t afi, uint32_t table)
 	XFREE(MTYPE_ROUTE_MAP_NAME, zebra_import_table_routemap[afi][table]);
 }
 
+/* Generation counter for memoized route-map resolutions; bumped by the
+ * route-map hooks below whenever any map or referenced list changes. */
+static uint64_t zebra_rmap_gen = 1;
+
+/* Memoized route_map_lookup_by_name(): the import-table and
+ * redistribution list walks apply the same map to every route of a
+ * batch, so remember the last resolution until a route-map change
+ * bumps the generation.  The name-hash lookup otherwise shows up in
+ * profiles under BGP churn. */
+static struct route_map *zebra_route_map_lookup_memo(const char *rmap_name)
+{
+	static char *memo_name;
+	static struct route_map *memo_map;
+	static uint64_t memo_gen;
+
+	if (memo_name && memo_gen == zebra_rmap_gen
+	    && strcmp(memo_name, rmap_name) == 0)
+		return memo_map;
+
+	memo_map = route_map_lookup_by_name(rmap_name);
+	memo_gen = zebra_rmap_gen;
+	XFREE(MTYPE_ROUTE_MAP_NAME, memo_name);
+	memo_name = XSTRDUP(MTYPE_ROUTE_MAP_NAME, rmap_name);
+	return memo_map;
+}
+
 route_map_result_t
 zebra_import_table_route_map_check(int family, int re_type, uint8_t instance,
 				   const struct prefix *p,
@@ -1736,7 +1764,7 @@ zebra_import_table_route_map_check(int family, int re_type, uint8_t instance,
 	nh_obj.tag = tag;
 
 	if (re_type >= 0 && re_type < ZEBRA_ROUTE_MAX)
-		rmap = route_map_lookup_by_name(rmap_name);
+		rmap = zebra_route_map_lookup_memo(rmap_name);
 	if (rmap) {
 		ret = route_map_apply(rmap, p, RMAP_ZEBRA, &nh_obj);
 	}
@@ -1784,6 +1812,8 @@ static void zebra_route_map_mark_update(const char *rmap_name)
 
 static void zebra_route_map_add(const char *rmap_name)
 {
+	zebra_rmap_gen++;
+
 	if (route_map_mark_updated(rmap_name) == 0)
 		zebra_route_map_mark_update(rmap_name);
 
@@ -1792,6 +1822,8 @@ static void zebra_route_map_add(const char *rmap_name)
 
 static void zebra_route_map_delete(const char *rmap_name)
 {
+	zebra_rmap_gen++;
+
 	if (route_map_mark_updated(rmap_name) == 0)
 		zebra_route_map_mark_update(rmap_name);
 
@@ -1801,12 +1833,34 @@ static void zebra_route_map_delete(const char *rmap_name)
 static void zebra_route_map_event(route_map_event_t event,
 				  const char *rmap_name)
 {
+	zebra_rmap_gen++;
+
 	if (route_map_mark_updated(rmap_name) == 0)
 		zebra_route_map_mark_update(rmap_name);
 
 	route_map_notify_dependencies(rmap_name, RMAP_EVENT_MATCH_ADDED);
 }
 
+/* A referenced list changed; mark only the route-maps whose clauses
+ * actually use it, from the clause set the library hands us. */
+static void zebra_route_map_dep_clauses(route_map_event_t event,
+					const char *dep_name,
+					struct list *clauses)
+{
+	struct route_map_index *index;
+	struct listnode *node;
+
+	zebra_rmap_gen++;
+
+	for (ALL_LIST_ELEMENTS_RO(clauses, node, index)) {
+		if (route_map_mark_updated(index->map->name) == 0)
+			zebra_route_map_mark_update(index->map->name);
+
+		route_map_notify_dependencies(index->map->name,
+					      RMAP_EVENT_MATCH_ADDED);
+	}
+}
+
 /* ip protocol configuration write function */
 void zebra_routemap_config_write_protocol(struct vty *vty,
 					  struct zebra_vrf *zvrf)
@@ -1892,6 +1946,7 @@ void zebra_route_map_init(void)
 	route_map_add_hook(zebra_route_map_add);
 	route_map_delete_hook(zebra_route_map_delete);
 	route_map_event_hook(zebra_route_map_event);
+	route_map_dep_clause_hook(zebra_route_map_dep_clauses);
 
 	route_map_match_interface_hook(generic_match_add);
 	route_map_no_match_interface_hook(generic_match_delete);
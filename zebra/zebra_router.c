@@ -26,6 +26,7 @@
 
 #include "zebra_router.h"
 #include "zebra_memory.h"
+#include "zebra_nhg.h"
 #include "zebra_pbr.h"
 #include "zebra_vxlan.h"
 #include "zebra_mlag.h"
@@ -106,6 +107,11 @@ struct route_table *zebra_router_get_table(struct zebra_vrf *zvrf,
 	zrt->table =
 		(afi == AFI_IP6) ? srcdest_table_init() : route_table_init();
 
+	/* nexthop tracking resolves against this table with LPM lookups;
+	 * index the v4 side so those don't pay the full radix walk */
+	if (afi == AFI_IP && safi == SAFI_UNICAST)
+		route_table_use_dindex(zrt->table);
+
 	info = XCALLOC(MTYPE_RIB_TABLE_INFO, sizeof(*info));
 	info->zvrf = zvrf;
 	info->afi = afi;
@@ -188,9 +194,12 @@ void zebra_router_terminate(void)
 		zebra_router_free_table(zrt);
 	}
 
+	rib_workers_terminate();
 	work_queue_free_and_null(&zrouter.ribq);
 	meta_queue_free(zrouter.mq);
 
+	zebra_nhg_terminate();
+
 	zebra_vxlan_disable();
 	zebra_mlag_terminate();
 
@@ -214,6 +223,7 @@ void zebra_router_init(void)
 
 	zebra_vxlan_init();
 	zebra_mlag_init();
+	zebra_nhg_init();
 
 	zrouter.rules_hash = hash_create_size(8, zebra_pbr_rules_hash_key,
 					      zebra_pbr_rules_hash_equal,
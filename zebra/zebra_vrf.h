@@ -39,6 +39,9 @@ struct zebra_rmap {
 	struct route_map *map;
 };
 
+struct lsp_index;
+struct route_entry;
+
 /* Routing table instance.  */
 struct zebra_vrf {
 	/* Back pointer */
@@ -66,6 +69,18 @@ struct zebra_vrf {
 	/* Import check table (used mostly by BGP */
 	struct route_table *import_check_table[AFI_MAX];
 
+	/*
+	 * Coalesced set of RIB prefixes changed since the last NHT
+	 * evaluation pass.  A tracked nexthop can only be affected by a
+	 * RIB change whose prefix covers it, so as long as this set does
+	 * not overflow, zebra_evaluate_rnh() walks just the covered
+	 * subtrees of the rnh tables instead of the whole table.
+	 */
+#define ZEBRA_RNH_DIRTY_MAX 64
+	struct prefix rnh_dirty[AFI_MAX][ZEBRA_RNH_DIRTY_MAX];
+	uint16_t rnh_dirty_num[AFI_MAX];
+	bool rnh_dirty_overflow[AFI_MAX];
+
 	/* 2nd pointer type used primarily to quell a warning on
 	 * ALL_LIST_ELEMENTS_RO
 	 */
@@ -89,6 +104,9 @@ struct zebra_vrf {
 	/* MPLS label forwarding table */
 	struct hash *lsp_table;
 
+	/* Direct-indexed view of the label forwarding table */
+	struct lsp_index *lsp_index;
+
 	/* MPLS FEC binding table */
 	struct route_table *fec_table[AFI_MAX];
 
@@ -102,6 +120,11 @@ struct zebra_vrf {
 	struct zebra_rmap proto_rm[AFI_MAX][ZEBRA_ROUTE_MAX + 1];
 	struct zebra_rmap nht_rm[AFI_MAX][ZEBRA_ROUTE_MAX + 1];
 
+	/* Per-type lists of routes in the main unicast tables, used to
+	 * replay redistribution registrations without a full RIB walk.
+	 */
+	struct route_entry *redist_routes[AFI_MAX][ZEBRA_ROUTE_MAX];
+
 	/* MPLS processing flags */
 	uint16_t mpls_flags;
 #define MPLS_FLAG_SCHEDULE_LSPS    (1 << 0)
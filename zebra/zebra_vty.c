@@ -43,6 +43,7 @@
 #include "zebra/redistribute.h"
 #include "zebra/zebra_routemap.h"
 #include "lib/json.h"
+#include "lib/jsonw.h"
 #include "zebra/zebra_vxlan.h"
 #ifndef VTYSH_EXTRACT_PL
 #include "zebra/zebra_vty_clippy.c"
@@ -51,13 +52,18 @@
 #include "zebra/router-id.h"
 #include "zebra/ipforward.h"
 #include "zebra/zebra_vxlan_private.h"
+#include "zebra/interface.h"
+#include "zebra/zebra_nhg.h"
 #include "zebra/zebra_pbr.h"
+#if defined(HAVE_NETLINK)
+#include "zebra/kernel_netlink.h"
+#endif
 
 extern int allow_delete;
 
 static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 			    safi_t safi, bool use_fib, bool use_json,
-			    route_tag_t tag,
+			    enum jsonw_encoding enc, route_tag_t tag,
 			    const struct prefix *longer_prefix_p,
 			    bool supernets_only, int type,
 			    unsigned short ospf_instance_id);
@@ -128,7 +134,7 @@ DEFUN (show_ip_rpf,
 {
 	bool uj = use_json(argc, argv);
 	return do_show_ip_route(vty, VRF_DEFAULT_NAME, AFI_IP, SAFI_MULTICAST,
-				false, uj, 0, NULL, false, 0, 0);
+				false, uj, JSONW_JSON, 0, NULL, false, 0, 0);
 }
 
 DEFUN (show_ip_rpf_addr,
@@ -372,15 +378,11 @@ static void vty_show_ip_route_detail(struct vty *vty, struct route_node *rn,
 }
 
 static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
-			      struct route_entry *re, json_object *json)
+			      struct route_entry *re, struct json_writer *jw)
 {
 	struct nexthop *nexthop;
 	int len = 0;
 	char buf[SRCDEST2STR_BUFFER];
-	json_object *json_nexthops = NULL;
-	json_object *json_nexthop = NULL;
-	json_object *json_route = NULL;
-	json_object *json_labels = NULL;
 	time_t uptime;
 	struct tm *tm;
 
@@ -388,51 +390,42 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 	uptime -= re->uptime;
 	tm = gmtime(&uptime);
 
-	if (json) {
-		json_route = json_object_new_object();
-		json_nexthops = json_object_new_array();
+	if (jw) {
+		/* streamed straight into the vty buffer; the caller has the
+		 * enclosing per-prefix array open */
+		jsonw_start_object(jw);
 
-		json_object_string_add(json_route, "prefix",
-				       srcdest_rnode2str(rn, buf, sizeof buf));
-		json_object_string_add(json_route, "protocol",
-				       zebra_route_string(re->type));
+		jsonw_string_add(jw, "prefix",
+				 srcdest_rnode2str(rn, buf, sizeof buf));
+		jsonw_string_add(jw, "protocol",
+				 zebra_route_string(re->type));
 
 		if (re->instance)
-			json_object_int_add(json_route, "instance",
-					    re->instance);
+			jsonw_int_add(jw, "instance", re->instance);
 
 		if (re->vrf_id)
-			json_object_int_add(json_route, "vrfId", re->vrf_id);
+			jsonw_int_add(jw, "vrfId", re->vrf_id);
 
 		if (CHECK_FLAG(re->flags, ZEBRA_FLAG_SELECTED))
-			json_object_boolean_true_add(json_route, "selected");
+			jsonw_boolean_true_add(jw, "selected");
 
-		json_object_int_add(json_route, "distance",
-				    re->distance);
-		json_object_int_add(json_route, "metric", re->metric);
+		jsonw_int_add(jw, "distance", re->distance);
+		jsonw_int_add(jw, "metric", re->metric);
 
 		if (CHECK_FLAG(re->status, ROUTE_ENTRY_INSTALLED))
-			json_object_boolean_true_add(json_route, "installed");
+			jsonw_boolean_true_add(jw, "installed");
 
 		if (CHECK_FLAG(re->status, ROUTE_ENTRY_FAILED))
-			json_object_boolean_true_add(json_route, "failed");
+			jsonw_boolean_true_add(jw, "failed");
 
 		if (CHECK_FLAG(re->status, ROUTE_ENTRY_QUEUED))
-			json_object_boolean_true_add(json_route, "queued");
-
-		if (re->type != ZEBRA_ROUTE_CONNECT) {
-			json_object_int_add(json_route, "distance",
-					    re->distance);
-			json_object_int_add(json_route, "metric", re->metric);
-		}
+			jsonw_boolean_true_add(jw, "queued");
 
 		if (re->tag)
-			json_object_int_add(json_route, "tag", re->tag);
+			jsonw_int_add(jw, "tag", re->tag);
 
-		json_object_int_add(json_route, "internalStatus",
-				    re->status);
-		json_object_int_add(json_route, "internalFlags",
-				    re->flags);
+		jsonw_int_add(jw, "internalStatus", re->status);
+		jsonw_int_add(jw, "internalFlags", re->flags);
 		if (uptime < ONE_DAY_SECOND)
 			sprintf(buf, "%02d:%02d:%02d", tm->tm_hour, tm->tm_min,
 				tm->tm_sec);
@@ -444,37 +437,35 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 				tm->tm_yday - ((tm->tm_yday / 7) * 7),
 				tm->tm_hour);
 
-		json_object_string_add(json_route, "uptime", buf);
+		jsonw_string_add(jw, "uptime", buf);
+
+		jsonw_name(jw, "nexthops");
+		jsonw_start_array(jw);
 
 		for (ALL_NEXTHOPS(re->ng, nexthop)) {
-			json_nexthop = json_object_new_object();
+			jsonw_start_object(jw);
 
-			json_object_int_add(json_nexthop, "flags",
-					    nexthop->flags);
+			jsonw_int_add(jw, "flags", nexthop->flags);
 
 			if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_DUPLICATE))
-				json_object_boolean_true_add(json_nexthop,
-							     "duplicate");
+				jsonw_boolean_true_add(jw, "duplicate");
 
 			if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_FIB))
-				json_object_boolean_true_add(json_nexthop,
-							     "fib");
+				jsonw_boolean_true_add(jw, "fib");
 
 			switch (nexthop->type) {
 			case NEXTHOP_TYPE_IPV4:
 			case NEXTHOP_TYPE_IPV4_IFINDEX:
-				json_object_string_add(
-					json_nexthop, "ip",
+				jsonw_string_add(
+					jw, "ip",
 					inet_ntoa(nexthop->gate.ipv4));
-				json_object_string_add(json_nexthop, "afi",
-						       "ipv4");
+				jsonw_string_add(jw, "afi", "ipv4");
 
 				if (nexthop->ifindex) {
-					json_object_int_add(json_nexthop,
-							    "interfaceIndex",
-							    nexthop->ifindex);
-					json_object_string_add(
-						json_nexthop, "interfaceName",
+					jsonw_int_add(jw, "interfaceIndex",
+						      nexthop->ifindex);
+					jsonw_string_add(
+						jw, "interfaceName",
 						ifindex2ifname(
 							nexthop->ifindex,
 							nexthop->vrf_id));
@@ -482,19 +473,17 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 				break;
 			case NEXTHOP_TYPE_IPV6:
 			case NEXTHOP_TYPE_IPV6_IFINDEX:
-				json_object_string_add(
-					json_nexthop, "ip",
+				jsonw_string_add(
+					jw, "ip",
 					inet_ntop(AF_INET6, &nexthop->gate.ipv6,
 						  buf, sizeof buf));
-				json_object_string_add(json_nexthop, "afi",
-						       "ipv6");
+				jsonw_string_add(jw, "afi", "ipv6");
 
 				if (nexthop->ifindex) {
-					json_object_int_add(json_nexthop,
-							    "interfaceIndex",
-							    nexthop->ifindex);
-					json_object_string_add(
-						json_nexthop, "interfaceName",
+					jsonw_int_add(jw, "interfaceIndex",
+						      nexthop->ifindex);
+					jsonw_string_add(
+						jw, "interfaceName",
 						ifindex2ifname(
 							nexthop->ifindex,
 							nexthop->vrf_id));
@@ -502,32 +491,28 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 				break;
 
 			case NEXTHOP_TYPE_IFINDEX:
-				json_object_boolean_true_add(
-					json_nexthop, "directlyConnected");
-				json_object_int_add(json_nexthop,
-						    "interfaceIndex",
-						    nexthop->ifindex);
-				json_object_string_add(
-					json_nexthop, "interfaceName",
+				jsonw_boolean_true_add(jw,
+						       "directlyConnected");
+				jsonw_int_add(jw, "interfaceIndex",
+					      nexthop->ifindex);
+				jsonw_string_add(
+					jw, "interfaceName",
 					ifindex2ifname(nexthop->ifindex,
 						       nexthop->vrf_id));
 				break;
 			case NEXTHOP_TYPE_BLACKHOLE:
-				json_object_boolean_true_add(json_nexthop,
-							     "unreachable");
+				jsonw_boolean_true_add(jw, "unreachable");
 				switch (nexthop->bh_type) {
 				case BLACKHOLE_REJECT:
-					json_object_boolean_true_add(
-						json_nexthop, "reject");
+					jsonw_boolean_true_add(jw, "reject");
 					break;
 				case BLACKHOLE_ADMINPROHIB:
-					json_object_boolean_true_add(
-						json_nexthop,
-						"admin-prohibited");
+					jsonw_boolean_true_add(
+						jw, "admin-prohibited");
 					break;
 				case BLACKHOLE_NULL:
-					json_object_boolean_true_add(
-						json_nexthop, "blackhole");
+					jsonw_boolean_true_add(jw,
+							       "blackhole");
 					break;
 				case BLACKHOLE_UNSPEC:
 					break;
@@ -542,24 +527,17 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 				struct vrf *vrf =
 					vrf_lookup_by_id(nexthop->vrf_id);
 
-				json_object_string_add(json_nexthop, "vrf",
-						       vrf->name);
+				jsonw_string_add(jw, "vrf", vrf->name);
 			}
-			if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_DUPLICATE))
-				json_object_boolean_true_add(json_nexthop,
-							     "duplicate");
 
 			if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_ACTIVE))
-				json_object_boolean_true_add(json_nexthop,
-							     "active");
+				jsonw_boolean_true_add(jw, "active");
 
 			if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_ONLINK))
-				json_object_boolean_true_add(json_nexthop,
-							     "onLink");
+				jsonw_boolean_true_add(jw, "onLink");
 
 			if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_RECURSIVE))
-				json_object_boolean_true_add(json_nexthop,
-							     "recursive");
+				jsonw_boolean_true_add(jw, "recursive");
 
 			switch (nexthop->type) {
 			case NEXTHOP_TYPE_IPV4:
@@ -568,9 +546,8 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 					if (inet_ntop(AF_INET,
 						      &nexthop->src.ipv4, buf,
 						      sizeof buf))
-						json_object_string_add(
-							json_nexthop, "source",
-							buf);
+						jsonw_string_add(jw, "source",
+								 buf);
 				}
 				break;
 			case NEXTHOP_TYPE_IPV6:
@@ -580,9 +557,8 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 					if (inet_ntop(AF_INET6,
 						      &nexthop->src.ipv6, buf,
 						      sizeof buf))
-						json_object_string_add(
-							json_nexthop, "source",
-							buf);
+						jsonw_string_add(jw, "source",
+								 buf);
 				}
 				break;
 			default:
@@ -591,27 +567,25 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 
 			if (nexthop->nh_label
 			    && nexthop->nh_label->num_labels) {
-				json_labels = json_object_new_array();
+				jsonw_name(jw, "labels");
+				jsonw_start_array(jw);
 
 				for (int label_index = 0;
 				     label_index
 				     < nexthop->nh_label->num_labels;
 				     label_index++)
-					json_object_array_add(
-						json_labels,
-						json_object_new_int(
-							nexthop->nh_label->label
-								[label_index]));
-
-				json_object_object_add(json_nexthop, "labels",
-						       json_labels);
+					jsonw_int(jw,
+						  nexthop->nh_label->label
+							  [label_index]);
+
+				jsonw_end_array(jw);
 			}
 
-			json_object_array_add(json_nexthops, json_nexthop);
+			jsonw_end_object(jw);
 		}
 
-		json_object_object_add(json_route, "nexthops", json_nexthops);
-		json_object_array_add(json, json_route);
+		jsonw_end_array(jw);
+		jsonw_end_object(jw);
 		return;
 	}
 
@@ -752,23 +726,24 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 static void vty_show_ip_route_detail_json(struct vty *vty,
 					struct route_node *rn)
 {
-	json_object *json = NULL;
-	json_object *json_prefix = NULL;
+	struct json_writer *jw;
 	struct route_entry *re;
 	char buf[BUFSIZ];
 
-	json = json_object_new_object();
-	json_prefix = json_object_new_array();
+	jw = jsonw_new(vty, JSONW_JSON);
+	jsonw_start_object(jw);
+
+	prefix2str(&rn->p, buf, sizeof(buf));
+	jsonw_name(jw, buf);
+	jsonw_start_array(jw);
 
 	RNODE_FOREACH_RE (rn, re) {
-		vty_show_ip_route(vty, rn, re, json_prefix);
+		vty_show_ip_route(vty, rn, re, jw);
 	}
 
-	prefix2str(&rn->p, buf, sizeof(buf));
-	json_object_object_add(json, buf, json_prefix);
-	vty_out(vty, "%s\n", json_object_to_json_string_ext(
-					     json, JSON_C_TO_STRING_PRETTY));
-	json_object_free(json);
+	jsonw_end_array(jw);
+	jsonw_end_object(jw);
+	jsonw_destroy(&jw);
 }
 
 static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
@@ -776,19 +751,28 @@ static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
 				 bool use_fib, route_tag_t tag,
 				 const struct prefix *longer_prefix_p,
 				 bool supernets_only, int type,
-				 unsigned short ospf_instance_id, bool use_json)
+				 unsigned short ospf_instance_id, bool use_json,
+				 enum jsonw_encoding enc)
 {
 	struct route_node *rn;
 	struct route_entry *re;
 	int first = 1;
 	rib_dest_t *dest;
-	json_object *json = NULL;
-	json_object *json_prefix = NULL;
+	struct json_writer *jw = NULL;
+	bool prefix_open = false;
 	uint32_t addr;
 	char buf[BUFSIZ];
 
-	if (use_json)
-		json = json_object_new_object();
+	if (use_json) {
+		jw = jsonw_new(vty, enc);
+		jsonw_start_object(jw);
+	}
+
+	/* Walk the table inside an epoch so that route processing (which
+	 * may run concurrently with this dump) cannot free nodes out from
+	 * under the iteration.
+	 */
+	route_table_epoch_enter(table);
 
 	/* Show all routes. */
 	for (rn = route_top(table); rn; rn = srcdest_route_next(rn)) {
@@ -828,8 +812,12 @@ static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
 				continue;
 
 			if (use_json) {
-				if (!json_prefix)
-					json_prefix = json_object_new_array();
+				if (!prefix_open) {
+					prefix2str(&rn->p, buf, sizeof(buf));
+					jsonw_name(jw, buf);
+					jsonw_start_array(jw);
+					prefix_open = true;
+				}
 			} else {
 				if (first) {
 					if (afi == AFI_IP)
@@ -847,26 +835,36 @@ static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
 				}
 			}
 
-			vty_show_ip_route(vty, rn, re, json_prefix);
+			vty_show_ip_route(vty, rn, re, jw);
 		}
 
-		if (json_prefix) {
-			prefix2str(&rn->p, buf, sizeof(buf));
-			json_object_object_add(json, buf, json_prefix);
-			json_prefix = NULL;
+		if (prefix_open) {
+			jsonw_end_array(jw);
+			prefix_open = false;
 		}
 	}
 
+	route_table_epoch_exit(table);
+
 	if (use_json) {
-		vty_out(vty, "%s\n", json_object_to_json_string_ext(json,
-						JSON_C_TO_STRING_PRETTY));
-		json_object_free(json);
+		jsonw_end_object(jw);
+		jsonw_destroy(&jw);
 	}
 }
 
+static void do_show_ip_route_empty(struct vty *vty, enum jsonw_encoding enc)
+{
+	struct json_writer *jw;
+
+	jw = jsonw_new(vty, enc);
+	jsonw_start_object(jw);
+	jsonw_end_object(jw);
+	jsonw_destroy(&jw);
+}
+
 static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 			    safi_t safi, bool use_fib, bool use_json,
-			    route_tag_t tag,
+			    enum jsonw_encoding enc, route_tag_t tag,
 			    const struct prefix *longer_prefix_p,
 			    bool supernets_only, int type,
 			    unsigned short ospf_instance_id)
@@ -876,7 +874,7 @@ static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 
 	if (!(zvrf = zebra_vrf_lookup_by_name(vrf_name))) {
 		if (use_json)
-			vty_out(vty, "{}\n");
+			do_show_ip_route_empty(vty, enc);
 		else
 			vty_out(vty, "vrf %s not defined\n", vrf_name);
 		return CMD_SUCCESS;
@@ -884,7 +882,7 @@ static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 
 	if (zvrf_id(zvrf) == VRF_UNKNOWN) {
 		if (use_json)
-			vty_out(vty, "{}\n");
+			do_show_ip_route_empty(vty, enc);
 		else
 			vty_out(vty, "vrf %s inactive\n", vrf_name);
 		return CMD_SUCCESS;
@@ -893,13 +891,13 @@ static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 	table = zebra_vrf_table(afi, safi, zvrf_id(zvrf));
 	if (!table) {
 		if (use_json)
-			vty_out(vty, "{}\n");
+			do_show_ip_route_empty(vty, enc);
 		return CMD_SUCCESS;
 	}
 
 	do_show_route_helper(vty, zvrf, table, afi, use_fib, tag,
 			     longer_prefix_p, supernets_only, type,
-			     ospf_instance_id, use_json);
+			     ospf_instance_id, use_json, enc);
 
 	return CMD_SUCCESS;
 }
@@ -922,7 +920,7 @@ DEFPY (show_route_table,
 	t = zebra_router_find_table(zvrf, table, afi, SAFI_UNICAST);
 	if (t)
 		do_show_route_helper(vty, zvrf, t, afi, false, 0, false, false,
-				     0, 0, !!json);
+				     0, 0, !!json, JSONW_JSON);
 
 	return CMD_SUCCESS;
 }
@@ -951,7 +949,7 @@ DEFPY (show_route_table_vrf,
 	t = zebra_router_find_table(zvrf, table, afi, SAFI_UNICAST);
 	if (t)
 		do_show_route_helper(vty, zvrf, t, afi, false, 0, false, false,
-				     0, 0, !!json);
+				     0, 0, !!json, JSONW_JSON);
 
 	return CMD_SUCCESS;
 }
@@ -1126,7 +1124,7 @@ DEFPY (show_route,
 	   }]\
 	   [" FRR_IP6_REDIST_STR_ZEBRA "$type_str]\
 	 >\
-        [json$json]",
+        [<json$json|cbor$cbor>]",
        SHOW_STR
        IP_STR
        "IP forwarding table\n"
@@ -1149,9 +1147,12 @@ DEFPY (show_route,
        "IPv6 prefix\n"
        "Show route matching the specified Network/Mask pair only\n"
        FRR_IP6_REDIST_HELP_STR_ZEBRA
-       JSON_STR)
+       JSON_STR
+       CBOR_STR)
 {
 	afi_t afi = ipv4 ? AFI_IP : AFI_IP6;
+	enum jsonw_encoding enc = cbor ? JSONW_CBOR : JSONW_JSON;
+	bool use_json = !!json || !!cbor;
 	struct vrf *vrf;
 	int type = 0;
 
@@ -1174,7 +1175,7 @@ DEFPY (show_route,
 
 			do_show_ip_route(
 				vty, zvrf_name(zvrf), afi, SAFI_UNICAST, !!fib,
-				!!json, tag, prefix_str ? prefix : NULL,
+				use_json, enc, tag, prefix_str ? prefix : NULL,
 				!!supernets_only, type, ospf_instance_id);
 		}
 	} else {
@@ -1184,7 +1185,7 @@ DEFPY (show_route,
 			VRF_GET_ID(vrf_id, vrf_name, !!json);
 		vrf = vrf_lookup_by_id(vrf_id);
 		do_show_ip_route(vty, vrf->name, afi, SAFI_UNICAST, !!fib,
-				 !!json, tag, prefix_str ? prefix : NULL,
+				 use_json, enc, tag, prefix_str ? prefix : NULL,
 				 !!supernets_only, type, ospf_instance_id);
 	}
 
@@ -2504,6 +2505,166 @@ DEFUN_HIDDEN (no_zebra_workqueue_timer,
 	return CMD_SUCCESS;
 }
 
+DEFUN (zebra_rib_workers,
+       zebra_rib_workers_cmd,
+       "zebra rib workers (0-16)",
+       ZEBRA_STR
+       "RIB processing\n"
+       "Number of worker pthreads for RIB processing (0 = main thread)\n"
+       "Number of workers\n")
+{
+	uint32_t nworkers = strtoul(argv[3]->arg, NULL, 10);
+
+	if (rib_workers_set(nworkers) < 0) {
+		vty_out(vty,
+			"%% Cannot resize worker pool while RIB work is queued\n");
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_zebra_rib_workers,
+       no_zebra_rib_workers_cmd,
+       "no zebra rib workers [(0-16)]",
+       NO_STR
+       ZEBRA_STR
+       "RIB processing\n"
+       "Number of worker pthreads for RIB processing (0 = main thread)\n"
+       "Number of workers\n")
+{
+	if (rib_workers_set(0) < 0) {
+		vty_out(vty,
+			"%% Cannot resize worker pool while RIB work is queued\n");
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (zebra_interface_settle_time,
+       zebra_interface_settle_time_cmd,
+       "zebra interface settle-time (10-5000)",
+       ZEBRA_STR
+       "Interface event handling\n"
+       "Coalesce link transitions arriving within a settle window\n"
+       "Settle window in milliseconds\n")
+{
+	if_settle_time_set(strtoul(argv[3]->arg, NULL, 10));
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_zebra_interface_settle_time,
+       no_zebra_interface_settle_time_cmd,
+       "no zebra interface settle-time [(10-5000)]",
+       NO_STR
+       ZEBRA_STR
+       "Interface event handling\n"
+       "Coalesce link transitions arriving within a settle window\n"
+       "Settle window in milliseconds\n")
+{
+	if_settle_time_set(0);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (zebra_zapi_weight,
+       zebra_zapi_weight_cmd,
+       "zebra zapi-weight " FRR_IP_PROTOCOL_MAP_STR_ZEBRA " $proto (1-8)$weight",
+       ZEBRA_STR
+       "Message scheduling weight for a client protocol\n"
+       FRR_IP_PROTOCOL_MAP_HELP_STR_ZEBRA
+       "Weight relative to the default of 4\n")
+{
+	int rtype;
+
+	if (strcasecmp(proto, "any") == 0) {
+		vty_out(vty, "%% Cannot set a weight for \"any\"\n");
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+
+	rtype = proto_name2num(proto);
+	if (rtype < 0) {
+		vty_out(vty, "invalid protocol name \"%s\"\n", proto);
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+
+	zserv_set_client_weight(rtype, weight);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_zebra_zapi_weight,
+       no_zebra_zapi_weight_cmd,
+       "no zebra zapi-weight " FRR_IP_PROTOCOL_MAP_STR_ZEBRA " $proto [(1-8)]",
+       NO_STR
+       ZEBRA_STR
+       "Message scheduling weight for a client protocol\n"
+       FRR_IP_PROTOCOL_MAP_HELP_STR_ZEBRA
+       "Weight relative to the default of 4\n")
+{
+	int rtype;
+
+	rtype = proto_name2num(proto);
+	if (rtype < 0) {
+		vty_out(vty, "invalid protocol name \"%s\"\n", proto);
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+
+	zserv_set_client_weight(rtype, 0);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (zebra_zapi_ratelimit,
+       zebra_zapi_ratelimit_cmd,
+       "zebra zapi-ratelimit " FRR_IP_PROTOCOL_MAP_STR_ZEBRA " $proto (100-1000000)$pps",
+       ZEBRA_STR
+       "Message intake rate limit for a client protocol\n"
+       FRR_IP_PROTOCOL_MAP_HELP_STR_ZEBRA
+       "Messages per second\n")
+{
+	int rtype;
+
+	if (strcasecmp(proto, "any") == 0) {
+		vty_out(vty, "%% Cannot set a rate limit for \"any\"\n");
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+
+	rtype = proto_name2num(proto);
+	if (rtype < 0) {
+		vty_out(vty, "invalid protocol name \"%s\"\n", proto);
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+
+	zserv_set_client_ratelimit(rtype, pps);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_zebra_zapi_ratelimit,
+       no_zebra_zapi_ratelimit_cmd,
+       "no zebra zapi-ratelimit " FRR_IP_PROTOCOL_MAP_STR_ZEBRA " $proto [(100-1000000)]",
+       NO_STR
+       ZEBRA_STR
+       "Message intake rate limit for a client protocol\n"
+       FRR_IP_PROTOCOL_MAP_HELP_STR_ZEBRA
+       "Messages per second\n")
+{
+	int rtype;
+
+	rtype = proto_name2num(proto);
+	if (rtype < 0) {
+		vty_out(vty, "invalid protocol name \"%s\"\n", proto);
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+
+	zserv_set_client_ratelimit(rtype, 0);
+
+	return CMD_SUCCESS;
+}
+
 DEFUN (no_ip_zebra_import_table,
        no_ip_zebra_import_table_cmd,
        "no ip import-table (1-252) [distance (1-255)] [route-map NAME]",
@@ -2552,10 +2713,25 @@ static int config_write_protocol(struct vty *vty)
 	if (zrouter.ribq->spec.hold != ZEBRA_RIB_PROCESS_HOLD_TIME)
 		vty_out(vty, "zebra work-queue %u\n", zrouter.ribq->spec.hold);
 
+	if (rib_workers_get())
+		vty_out(vty, "zebra rib workers %u\n", rib_workers_get());
+
+	if (if_settle_time_get())
+		vty_out(vty, "zebra interface settle-time %u\n",
+			if_settle_time_get());
+
+	if (zebra_pbr_agg_enabled_get())
+		vty_out(vty, "pbr rule-aggregation\n");
+
+	if (zebra_nhg_kernel_nexthops_enabled())
+		vty_out(vty, "zebra nexthop-group\n");
+
 	if (zrouter.packets_to_process != ZEBRA_ZAPI_PACKETS_TO_PROCESS)
 		vty_out(vty, "zebra zapi-packets %u\n",
 			zrouter.packets_to_process);
 
+	zserv_config_write(vty);
+
 	enum multicast_mode ipv4_multicast_mode = multicast_mode_ipv4_get();
 
 	if (ipv4_multicast_mode != MCAST_NO_CONFIG)
@@ -2631,6 +2807,29 @@ DEFUN (show_zebra,
 			zvrf->lsp_removals);
 	}
 
+#if defined(HAVE_NETLINK)
+	{
+		struct netlink_recv_stats nlstats;
+
+		netlink_recv_stats_get(&nlstats);
+		vty_out(vty, "\n");
+		vty_out(vty,
+			"Netlink receive: %" PRIu64 " messages in %" PRIu64
+			" read batches\n",
+			nlstats.msgs, nlstats.batches);
+		vty_out(vty, "Netlink kernel drops (ENOBUFS): %" PRIu64 "\n",
+			nlstats.overruns);
+		if (nlstats.overruns)
+			vty_out(vty, "Last netlink overrun: %lld seconds ago\n",
+				(long long)(monotime(NULL)
+					    - nlstats.last_overrun));
+		if (nlstats.rcvbuf_grown)
+			vty_out(vty,
+				"Netlink receive buffer grown to %u bytes\n",
+				nlstats.rcvbuf_grown);
+	}
+#endif /* HAVE_NETLINK */
+
 	return CMD_SUCCESS;
 }
 
@@ -2782,6 +2981,18 @@ DEFUN (show_dataplane,
 	return dplane_show_helper(vty, detailed);
 }
 
+/* Display dataplane per-stage latency stats */
+DEFUN (show_dataplane_stats,
+       show_dataplane_stats_cmd,
+       "show zebra dplane stats",
+       SHOW_STR
+       ZEBRA_STR
+       "Zebra dataplane information\n"
+       "Per-stage latency statistics\n")
+{
+	return dplane_show_stats_helper(vty);
+}
+
 /* Display dataplane providers info */
 DEFUN (show_dataplane_providers,
        show_dataplane_providers_cmd,
@@ -2834,6 +3045,97 @@ DEFUN (no_zebra_dplane_queue_limit,
 	return CMD_SUCCESS;
 }
 
+/* Configure dataplane per-cycle update batch size */
+DEFUN (zebra_dplane_batch_size,
+       zebra_dplane_batch_size_cmd,
+       "zebra dplane batch-size (1-10000)",
+       ZEBRA_STR
+       "Zebra dataplane\n"
+       "Number of updates dequeued per work cycle\n"
+       "Number of updates\n")
+{
+	uint32_t batch = 0;
+
+	batch = strtoul(argv[3]->arg, NULL, 10);
+
+	dplane_set_update_batch(batch, true);
+
+	return CMD_SUCCESS;
+}
+
+/* Reset dataplane batch size to default value */
+DEFUN (no_zebra_dplane_batch_size,
+       no_zebra_dplane_batch_size_cmd,
+       "no zebra dplane batch-size [(1-10000)]",
+       NO_STR
+       ZEBRA_STR
+       "Zebra dataplane\n"
+       "Number of updates dequeued per work cycle\n"
+       "Number of updates\n")
+{
+	dplane_set_update_batch(0, false);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (zebra_nexthop_group,
+       zebra_nexthop_group_cmd,
+       "zebra nexthop-group",
+       ZEBRA_STR
+       "Use kernel nexthop-group objects for route installation\n")
+{
+	zebra_nhg_set_kernel_nexthops(true);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_zebra_nexthop_group,
+       no_zebra_nexthop_group_cmd,
+       "no zebra nexthop-group",
+       NO_STR
+       ZEBRA_STR
+       "Use kernel nexthop-group objects for route installation\n")
+{
+	zebra_nhg_set_kernel_nexthops(false);
+
+	return CMD_SUCCESS;
+}
+
+#if defined(HAVE_NETLINK)
+/* Configure netlink batch size for kernel route programming */
+DEFUN (zebra_netlink_batch_size,
+       zebra_netlink_batch_size_cmd,
+       "zebra netlink batch-size (1-256)",
+       ZEBRA_STR
+       "Netlink kernel interface\n"
+       "Number of route messages packed per sendmsg()\n"
+       "Number of messages\n")
+{
+	uint32_t limit = 0;
+
+	limit = strtoul(argv[3]->arg, NULL, 10);
+
+	netlink_batch_set_limit(limit, true);
+
+	return CMD_SUCCESS;
+}
+
+/* Reset netlink batch size to default value */
+DEFUN (no_zebra_netlink_batch_size,
+       no_zebra_netlink_batch_size_cmd,
+       "no zebra netlink batch-size [(1-256)]",
+       NO_STR
+       ZEBRA_STR
+       "Netlink kernel interface\n"
+       "Number of route messages packed per sendmsg()\n"
+       "Number of messages\n")
+{
+	netlink_batch_set_limit(0, false);
+
+	return CMD_SUCCESS;
+}
+#endif /* HAVE_NETLINK */
+
 DEFUN (zebra_show_routing_tables_summary,
        zebra_show_routing_tables_summary_cmd,
        "show zebra router table summary",
@@ -2919,7 +3221,17 @@ void zebra_vty_init(void)
 	install_element(CONFIG_NODE, &no_ip_zebra_import_table_cmd);
 	install_element(CONFIG_NODE, &zebra_workqueue_timer_cmd);
 	install_element(CONFIG_NODE, &no_zebra_workqueue_timer_cmd);
+	install_element(CONFIG_NODE, &zebra_rib_workers_cmd);
+	install_element(CONFIG_NODE, &no_zebra_rib_workers_cmd);
+	install_element(CONFIG_NODE, &zebra_interface_settle_time_cmd);
+	install_element(CONFIG_NODE, &no_zebra_interface_settle_time_cmd);
+	install_element(CONFIG_NODE, &zebra_nexthop_group_cmd);
+	install_element(CONFIG_NODE, &no_zebra_nexthop_group_cmd);
 	install_element(CONFIG_NODE, &zebra_packet_process_cmd);
+	install_element(CONFIG_NODE, &zebra_zapi_weight_cmd);
+	install_element(CONFIG_NODE, &no_zebra_zapi_weight_cmd);
+	install_element(CONFIG_NODE, &zebra_zapi_ratelimit_cmd);
+	install_element(CONFIG_NODE, &no_zebra_zapi_ratelimit_cmd);
 	install_element(CONFIG_NODE, &no_zebra_packet_process_cmd);
 
 	install_element(VIEW_NODE, &show_vrf_cmd);
@@ -2985,9 +3297,16 @@ void zebra_vty_init(void)
 	install_element(VRF_NODE, &no_vrf_vni_mapping_cmd);
 
 	install_element(VIEW_NODE, &show_dataplane_cmd);
+	install_element(VIEW_NODE, &show_dataplane_stats_cmd);
 	install_element(VIEW_NODE, &show_dataplane_providers_cmd);
 	install_element(CONFIG_NODE, &zebra_dplane_queue_limit_cmd);
 	install_element(CONFIG_NODE, &no_zebra_dplane_queue_limit_cmd);
+	install_element(CONFIG_NODE, &zebra_dplane_batch_size_cmd);
+	install_element(CONFIG_NODE, &no_zebra_dplane_batch_size_cmd);
+#if defined(HAVE_NETLINK)
+	install_element(CONFIG_NODE, &zebra_netlink_batch_size_cmd);
+	install_element(CONFIG_NODE, &no_zebra_netlink_batch_size_cmd);
+#endif
 
 	install_element(VIEW_NODE, &zebra_show_routing_tables_summary_cmd);
 }
@@ -2057,7 +2057,79 @@ static void zvni_print_hash_detail(struct hash_bucket *bucket, void *data)
 }
 
 /*
- * Inform BGP about local MACIP.
+ * Pending batched MACIP messages for BGP. Consecutive MACIP records of
+ * the same type are packed into a single zapi message, and the filled
+ * messages are sent a bounded number per pass of the event loop, so
+ * that a MAC move storm neither costs one message per MAC nor
+ * monopolizes the main thread in a single burst.
+ */
+#define ZVNI_MACIP_RECORD_MAX_LEN                                              \
+	(4 + ETH_ALEN + 4 + IPV6_MAX_BYTELEN + 1 + 4)
+
+#define ZVNI_MACIP_FLUSH_PER_RUN 32
+
+static struct {
+	struct stream *s; /* message currently being packed */
+	uint16_t cmd;	  /* command of 's' */
+	struct stream_fifo *fifo; /* filled messages awaiting send */
+	struct thread *t_flush;
+} zvni_macip_batch;
+
+/*
+ * Close out the MACIP message being packed and queue it for sending.
+ */
+static void zvni_macip_batch_seal(void)
+{
+	struct stream *s = zvni_macip_batch.s;
+
+	if (!s)
+		return;
+
+	/* Write packet size. */
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	stream_fifo_push(zvni_macip_batch.fifo, s);
+	zvni_macip_batch.s = NULL;
+}
+
+/*
+ * Send queued MACIP messages to the BGP client, a bounded number per
+ * run; reschedule if more remain.
+ */
+static int zvni_macip_batch_flush(struct thread *t)
+{
+	struct zserv *client;
+	struct stream *s;
+	int num_sent = 0;
+
+	zvni_macip_batch.t_flush = NULL;
+
+	zvni_macip_batch_seal();
+
+	/* BGP may have gone away while messages were pending. */
+	client = zserv_find_client(ZEBRA_ROUTE_BGP, 0);
+
+	while ((s = stream_fifo_pop(zvni_macip_batch.fifo))) {
+		if (!client) {
+			stream_free(s);
+			continue;
+		}
+
+		zserv_send_message(client, s);
+		if (++num_sent >= ZVNI_MACIP_FLUSH_PER_RUN)
+			break;
+	}
+
+	if (stream_fifo_head(zvni_macip_batch.fifo))
+		thread_add_event(zrouter.master, zvni_macip_batch_flush, NULL,
+				 0, &zvni_macip_batch.t_flush);
+
+	return 0;
+}
+
+/*
+ * Inform BGP about local MACIP. The record is packed into the pending
+ * batch message and sent from zvni_macip_batch_flush().
  */
 static int zvni_macip_send_msg_to_client(vni_t vni, struct ethaddr *macaddr,
 					 struct ipaddr *ip, uint8_t flags,
@@ -2074,9 +2146,23 @@ static int zvni_macip_send_msg_to_client(vni_t vni, struct ethaddr *macaddr,
 	if (!client)
 		return 0;
 
-	s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	/*
+	 * Close out the pending message if it is of the other type or
+	 * cannot take another record.
+	 */
+	if (zvni_macip_batch.s
+	    && (zvni_macip_batch.cmd != cmd
+		|| STREAM_WRITEABLE(zvni_macip_batch.s)
+			   < ZVNI_MACIP_RECORD_MAX_LEN))
+		zvni_macip_batch_seal();
+
+	if (!zvni_macip_batch.s) {
+		zvni_macip_batch.s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+		zvni_macip_batch.cmd = cmd;
+		zclient_create_header(zvni_macip_batch.s, cmd, VRF_DEFAULT);
+	}
+	s = zvni_macip_batch.s;
 
-	zclient_create_header(s, cmd, VRF_DEFAULT);
 	stream_putl(s, vni);
 	stream_put(s, macaddr->octet, ETH_ALEN);
 	if (ip) {
@@ -2099,10 +2185,6 @@ static int zvni_macip_send_msg_to_client(vni_t vni, struct ethaddr *macaddr,
 		stream_putl(s, state); /* state - active/inactive */
 	}
 
-
-	/* Write packet size. */
-	stream_putw_at(s, 0, stream_get_endp(s));
-
 	if (IS_ZEBRA_DEBUG_VXLAN)
 		zlog_debug(
 			"Send MACIP %s flags 0x%x MAC %s IP %s seq %u L2-VNI %u to %s",
@@ -2116,7 +2198,11 @@ static int zvni_macip_send_msg_to_client(vni_t vni, struct ethaddr *macaddr,
 	else
 		client->macipdel_cnt++;
 
-	return zserv_send_message(client, s);
+	if (!zvni_macip_batch.t_flush)
+		thread_add_event(zrouter.master, zvni_macip_batch_flush, NULL,
+				 0, &zvni_macip_batch.t_flush);
+
+	return 0;
 }
 
 /*
@@ -9126,12 +9212,20 @@ void zebra_vxlan_init(void)
 {
 	zrouter.l3vni_table = hash_create(l3vni_hash_keymake, l3vni_hash_cmp,
 					  "Zebra VRF L3 VNI table");
+
+	zvni_macip_batch.fifo = stream_fifo_new();
 }
 
 /* free l3vni table */
 void zebra_vxlan_disable(void)
 {
 	hash_free(zrouter.l3vni_table);
+
+	if (zvni_macip_batch.s)
+		stream_free(zvni_macip_batch.s);
+	zvni_macip_batch.s = NULL;
+	stream_fifo_free(zvni_macip_batch.fifo);
+	zvni_macip_batch.fifo = NULL;
 }
 
 /* get the l3vni svi ifindex */
@@ -33,7 +33,6 @@
 #include <time.h>                 /* for NULL, tm, gmtime, time_t */
 #include <unistd.h>               /* for close, unlink, ssize_t */
 
-#include "lib/buffer.h"           /* for BUFFER_EMPTY, BUFFER_ERROR, BUFFE... */
 #include "lib/command.h"          /* for vty, install_element, CMD_SUCCESS... */
 #include "lib/hook.h"             /* for DEFINE_HOOK, DEFINE_KOOH, hook_call */
 #include "lib/linklist.h"         /* for ALL_LIST_ELEMENTS_RO, ALL_LIST_EL... */
@@ -191,80 +190,85 @@ static void zserv_client_fail(struct zserv *client)
 /*
  * Write all pending messages to client socket.
  *
- * This function first attempts to flush any buffered data. If unsuccessful,
- * the function reschedules itself and returns. If successful, it pops all
- * available messages from the output queue and continues to write data
- * directly to the socket until the socket would block. If the socket never
- * blocks and all data is written, the function returns without rescheduling
- * itself. If the socket ends up throwing EWOULDBLOCK, the remaining data is
- * buffered and the function reschedules itself.
- *
- * The utility of the buffer is that it allows us to vastly reduce lock
- * contention by allowing us to pop *all* messages off the output queue at once
- * instead of locking and unlocking each time we want to pop a single message
- * off the queue. The same thing could arguably be accomplished faster by
- * allowing the main thread to write directly into the buffer instead of
- * enqueuing packets onto an intermediary queue, but the intermediary queue
- * allows us to expose information about input and output queues to the user in
- * terms of number of packets rather than size of data.
+ * This function pops *all* messages off the output queue in one locked
+ * pass into wbuf_fifo, which only this thread touches, then writes them
+ * out of the queued streams' buffers with writev() - no intermediate
+ * copy.  If the socket would block, whatever remains (including a
+ * partially written head) stays on wbuf_fifo and the function
+ * reschedules itself.
  */
 static int zserv_write(struct thread *thread)
 {
 	struct zserv *client = THREAD_ARG(thread);
 	struct stream *msg;
 	uint32_t wcmd = 0;
-	struct stream_fifo *cache;
-
-	/* If we have any data pending, try to flush it first */
-	switch (buffer_flush_all(client->wb, client->sock)) {
-	case BUFFER_ERROR:
-		goto zwrite_fail;
-	case BUFFER_PENDING:
-		atomic_store_explicit(&client->last_write_time,
-				      (uint32_t)monotime(NULL),
-				      memory_order_relaxed);
-		zserv_client_event(client, ZSERV_CLIENT_WRITE);
-		return 0;
-	case BUFFER_EMPTY:
-		break;
-	}
-
-	cache = stream_fifo_new();
+	ssize_t rv;
 
 	pthread_mutex_lock(&client->obuf_mtx);
 	{
 		while (stream_fifo_head(client->obuf_fifo))
-			stream_fifo_push(cache,
+			stream_fifo_push(client->wbuf_fifo,
 					 stream_fifo_pop(client->obuf_fifo));
 	}
 	pthread_mutex_unlock(&client->obuf_mtx);
 
-	if (cache->tail) {
-		msg = cache->tail;
-		stream_set_getp(msg, 0);
+	if (client->wbuf_fifo->tail) {
+		msg = client->wbuf_fifo->tail;
 		wcmd = stream_getw_from(msg, 6);
 	}
 
-	while (stream_fifo_head(cache)) {
-		msg = stream_fifo_pop(cache);
-		buffer_put(client->wb, STREAM_DATA(msg), stream_get_endp(msg));
-		stream_free(msg);
-	}
-
-	stream_fifo_free(cache);
-
-	/* If we have any data pending, try to flush it first */
-	switch (buffer_flush_all(client->wb, client->sock)) {
-	case BUFFER_ERROR:
-		goto zwrite_fail;
-	case BUFFER_PENDING:
+	/* Negotiated shared-memory transport: copy into the tx ring
+	 * instead, using getp as the consumed-so-far cursor.  If the ring
+	 * fills up the client is still draining; retry shortly. */
+	if (client->shm_tx_active) {
+		bool wrote = false;
+
+		while ((msg = stream_fifo_head(client->wbuf_fifo)) != NULL) {
+			size_t left =
+				stream_get_endp(msg) - stream_get_getp(msg);
+			size_t done = zshm_ring_put(
+				&client->shm_tx,
+				STREAM_DATA(msg) + stream_get_getp(msg), left);
+
+			wrote |= done != 0;
+			if (done < left) {
+				stream_set_getp(msg,
+						stream_get_getp(msg) + done);
+				break;
+			}
+			stream_free(stream_fifo_pop(client->wbuf_fifo));
+		}
+		if (wrote)
+			zshm_ring_kick(&client->shm_tx);
+		if (stream_fifo_head(client->wbuf_fifo))
+			thread_add_timer_msec(client->pthread->master,
+					      zserv_write, client, 1,
+					      &client->t_write);
+
+		atomic_store_explicit(&client->last_write_cmd, wcmd,
+				      memory_order_relaxed);
 		atomic_store_explicit(&client->last_write_time,
 				      (uint32_t)monotime(NULL),
 				      memory_order_relaxed);
-		zserv_client_event(client, ZSERV_CLIENT_WRITE);
 		return 0;
-	case BUFFER_EMPTY:
-		break;
+	}
+
+	/*
+	 * Write directly out of the queued streams; partially written
+	 * messages simply stay on wbuf_fifo (which only this thread
+	 * touches) until the socket drains.
+	 */
+	while (stream_fifo_head(client->wbuf_fifo)) {
+		rv = stream_fifo_writev(client->wbuf_fifo, client->sock);
+		if (rv < 0) {
+			if (!ERRNO_IO_RETRY(errno))
+				goto zwrite_fail;
+			atomic_store_explicit(&client->last_write_time,
+					      (uint32_t)monotime(NULL),
+					      memory_order_relaxed);
+			zserv_client_event(client, ZSERV_CLIENT_WRITE);
+			return 0;
+		}
 	}
 
 	atomic_store_explicit(&client->last_write_cmd, wcmd,
@@ -283,6 +287,164 @@ zwrite_fail:
 	return 0;
 }
 
+/*
+ * Commands that arrive in large bursts are scheduled behind everything
+ * else, so interface, registration and query traffic stays responsive
+ * while e.g. bgpd replays a full table of routes.
+ */
+static bool zserv_command_is_bulk(uint16_t cmd)
+{
+	switch (cmd) {
+	case ZEBRA_ROUTE_ADD:
+	case ZEBRA_ROUTE_DELETE:
+	case ZEBRA_ROUTE_ADD_BULK:
+	case ZEBRA_REMOTE_MACIP_ADD:
+	case ZEBRA_REMOTE_MACIP_DEL:
+	case ZEBRA_MPLS_LABELS_ADD:
+	case ZEBRA_MPLS_LABELS_DELETE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Shared-memory transport negotiation (see lib/zshmring.h) ---------------- */
+
+/*
+ * Like stream_read_try(), but via recvmsg() so SCM_RIGHTS descriptors
+ * sent along with a shared-memory transport offer are captured instead
+ * of being closed by the kernel.  Only used until the first message
+ * from a fresh client has been seen.
+ */
+static ssize_t zserv_read_fds_try(struct zserv *client, int sock, size_t size)
+{
+	struct msghdr msgh;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	union {
+		struct cmsghdr align;
+		char buf[CMSG_SPACE(sizeof(client->shm_fds))];
+	} cmsgbuf;
+	ssize_t nb;
+
+	memset(&msgh, 0, sizeof(msgh));
+	memset(&cmsgbuf, 0, sizeof(cmsgbuf));
+	msgh.msg_iov = &iov;
+	msgh.msg_iovlen = 1;
+	msgh.msg_control = cmsgbuf.buf;
+	msgh.msg_controllen = sizeof(cmsgbuf.buf);
+
+	nb = stream_recvmsg(client->ibuf_work, sock, &msgh, MSG_DONTWAIT,
+			    size);
+	if (nb < 0)
+		return ERRNO_IO_RETRY(errno) ? -2 : -1;
+
+	for (cmsg = CMSG_FIRSTHDR(&msgh); cmsg;
+	     cmsg = CMSG_NXTHDR(&msgh, cmsg)) {
+		int nfds, i;
+
+		if (cmsg->cmsg_level != SOL_SOCKET
+		    || cmsg->cmsg_type != SCM_RIGHTS)
+			continue;
+		nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		for (i = 0; i < nfds; i++) {
+			int fd;
+
+			memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int),
+			       sizeof(fd));
+			if (client->shm_nfds
+			    < (int)array_size(client->shm_fds))
+				client->shm_fds[client->shm_nfds++] = fd;
+			else
+				close(fd);
+		}
+	}
+
+	return nb;
+}
+
+/*
+ * Synchronously push everything on wbuf_fifo out of the socket.  Only
+ * used for the handful of bytes involved in the shm handshake, where a
+ * strict ordering point between the socket and the ring is needed.
+ */
+static int zserv_sock_drain(struct zserv *client)
+{
+	int tries = 0;
+
+	while (stream_fifo_head(client->wbuf_fifo)) {
+		if (stream_fifo_writev(client->wbuf_fifo, client->sock) >= 0)
+			continue;
+		if (!ERRNO_IO_RETRY(errno) || ++tries > 50)
+			return -1;
+
+		struct pollfd pfd = {.fd = client->sock, .events = POLLOUT};
+
+		poll(&pfd, 1, 100);
+	}
+	return 0;
+}
+
+/*
+ * Handle a shared-memory transport offer.  The four descriptors must
+ * have arrived as SCM_RIGHTS with this message: client->server ring and
+ * doorbell, then server->client ring and doorbell.  On success the ack
+ * goes out as our last socket message and our output switches to the
+ * ring; on failure the descriptors are dropped and the session simply
+ * stays on the socket.  Returns -1 only if the client must be killed.
+ */
+static int zserv_shm_hello(struct zserv *client)
+{
+	struct stream *ack;
+	int i;
+
+	client->shm_fd_wait = false;
+
+	if (!zshm_available() || client->shm_nfds != 4)
+		goto drop;
+
+	if (zshm_ring_attach(&client->shm_rx, client->shm_fds[0],
+			     client->shm_fds[1]) < 0)
+		goto drop;
+	client->shm_fds[0] = client->shm_fds[1] = -1;
+	if (zshm_ring_attach(&client->shm_tx, client->shm_fds[2],
+			     client->shm_fds[3]) < 0) {
+		zshm_ring_close(&client->shm_rx);
+		goto drop;
+	}
+	client->shm_fds[2] = client->shm_fds[3] = -1;
+	client->shm_nfds = 0;
+
+	/* Flush anything already queued plus the ack, then switch. */
+	ack = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	zclient_create_header(ack, ZEBRA_SHM_HELLO, VRF_DEFAULT);
+	stream_putw_at(ack, 0, stream_get_endp(ack));
+
+	pthread_mutex_lock(&client->obuf_mtx);
+	{
+		while (stream_fifo_head(client->obuf_fifo))
+			stream_fifo_push(client->wbuf_fifo,
+					 stream_fifo_pop(client->obuf_fifo));
+	}
+	pthread_mutex_unlock(&client->obuf_mtx);
+	stream_fifo_push(client->wbuf_fifo, ack);
+
+	if (zserv_sock_drain(client) < 0)
+		return -1;
+
+	client->shm_tx_active = true;
+	zlog_info("client %d negotiated shared-memory ZAPI transport",
+		  client->sock);
+	return 0;
+
+drop:
+	for (i = 0; i < client->shm_nfds; i++)
+		if (client->shm_fds[i] >= 0)
+			close(client->shm_fds[i]);
+	client->shm_nfds = 0;
+	return 0;
+}
+
 /*
  * Read and process data from a client socket.
  *
@@ -305,12 +467,57 @@ zwrite_fail:
  *
  * Any failure in any of these actions is handled by terminating the client.
  */
+/* Resume reading after an intake rate-limit pause. */
+static int zserv_read_resume(struct thread *thread)
+{
+	zserv_client_event(THREAD_ARG(thread), ZSERV_CLIENT_READ);
+	return 0;
+}
+
+/*
+ * Cap a read quota by the client's configured intake rate.  Returns how
+ * many messages may be read on this wakeup; zero means the bucket is
+ * empty and a resume timer has been scheduled in t_read's place.
+ * Tokens for messages not actually read are handed back via
+ * zserv_recv_credit().
+ */
+static uint32_t zserv_recv_quota(struct zserv *client, uint32_t p2p)
+{
+	uint32_t pps = atomic_load_explicit(&client->recv_pps,
+					    memory_order_relaxed);
+	uint32_t allowed;
+
+	if (!pps)
+		return p2p;
+
+	/* Config changed since our last pass; rebuild the bucket. */
+	if (client->recv_limit.rate != pps)
+		token_bucket_init(&client->recv_limit, pps, pps);
+
+	allowed = token_bucket_take(&client->recv_limit, p2p);
+	if (allowed == 0)
+		thread_add_timer_msec(
+			client->pthread->master, zserv_read_resume, client,
+			token_bucket_wait_msec(&client->recv_limit, 1),
+			&client->t_read);
+
+	return allowed;
+}
+
+static void zserv_recv_credit(struct zserv *client, uint32_t unused)
+{
+	if (unused
+	    && atomic_load_explicit(&client->recv_pps, memory_order_relaxed))
+		token_bucket_credit(&client->recv_limit, unused);
+}
+
 static int zserv_read(struct thread *thread)
 {
 	struct zserv *client = THREAD_ARG(thread);
 	int sock;
 	size_t already;
 	struct stream_fifo *cache;
+	struct stream_fifo *cache_prio;
 	uint32_t p2p_orig;
 
 	uint32_t p2p;
@@ -318,7 +525,15 @@ static int zserv_read(struct thread *thread)
 
 	p2p_orig = atomic_load_explicit(&zrouter.packets_to_process,
 					memory_order_relaxed);
+	/* Intake policing: shrink this wakeup's quota to the tokens
+	 * available; zserv_recv_quota() scheduled a resume timer if we
+	 * have to back off entirely. */
+	p2p_orig = zserv_recv_quota(client, p2p_orig);
+	if (p2p_orig == 0)
+		return 0;
+
 	cache = stream_fifo_new();
+	cache_prio = stream_fifo_new();
 	p2p = p2p_orig;
 	sock = THREAD_FD(thread);
 
@@ -329,10 +544,18 @@ static int zserv_read(struct thread *thread)
 
 		already = stream_get_endp(client->ibuf_work);
 
-		/* Read length and command (if we don't have it already). */
+		/* Read length and command (if we don't have it already).
+		 * While the first message is pending, read via recvmsg()
+		 * so a shared-memory offer's descriptors are captured. */
 		if (already < ZEBRA_HEADER_SIZE) {
-			nb = stream_read_try(client->ibuf_work, sock,
-					     ZEBRA_HEADER_SIZE - already);
+			if (client->shm_fd_wait)
+				nb = zserv_read_fds_try(
+					client, sock,
+					ZEBRA_HEADER_SIZE - already);
+			else
+				nb = stream_read_try(client->ibuf_work, sock,
+						     ZEBRA_HEADER_SIZE
+							     - already);
 			if ((nb == 0 || nb == -1)) {
 				if (IS_ZEBRA_DEBUG_EVENT)
 					zlog_debug("connection closed socket [%d]",
@@ -404,6 +627,28 @@ static int zserv_read(struct thread *thread)
 			}
 		}
 
+		/* Shared-memory transport negotiation; these messages are
+		 * consumed here on the I/O thread and never reach the main
+		 * thread. */
+		if (hdr.command == ZEBRA_SHM_HELLO) {
+			if (zserv_shm_hello(client) < 0)
+				goto zread_fail;
+			stream_reset(client->ibuf_work);
+			p2p--;
+			continue;
+		}
+		if (hdr.command == ZEBRA_SHM_SWITCH) {
+			/* The client's last socket message; everything
+			 * further arrives on the ring. */
+			client->shm_rx_active = true;
+			stream_reset(client->ibuf_work);
+			p2p--;
+			break;
+		}
+		if (client->shm_fd_wait)
+			/* First message was not an shm offer. */
+			client->shm_fd_wait = false;
+
 		/* Debug packet information. */
 		if (IS_ZEBRA_DEBUG_PACKET)
 			zlog_debug("zebra message[%s:%u:%u] comes from socket [%d]",
@@ -417,7 +662,10 @@ static int zserv_read(struct thread *thread)
 		stream_set_getp(client->ibuf_work, 0);
 		struct stream *msg = stream_dup(client->ibuf_work);
 
-		stream_fifo_push(cache, msg);
+		if (zserv_command_is_bulk(hdr.command))
+			stream_fifo_push(cache, msg);
+		else
+			stream_fifo_push(cache_prio, msg);
 		stream_reset(client->ibuf_work);
 		p2p--;
 	}
@@ -429,9 +677,12 @@ static int zserv_read(struct thread *thread)
 		atomic_store_explicit(&client->last_read_cmd, hdr.command,
 				      memory_order_relaxed);
 
-		/* publish read packets on client's input queue */
+		/* publish read packets on client's input queues */
 		pthread_mutex_lock(&client->ibuf_mtx);
 		{
+			while (cache_prio->head)
+				stream_fifo_push(client->ibuf_prio_fifo,
+						 stream_fifo_pop(cache_prio));
 			while (cache->head)
 				stream_fifo_push(client->ibuf_fifo,
 						 stream_fifo_pop(cache));
@@ -447,15 +698,142 @@ static int zserv_read(struct thread *thread)
 		zlog_debug("Read %d packets from client: %s", p2p_orig - p2p,
 			   zebra_route_string(client->proto));
 
+	/* Hand back tokens for the part of the quota we did not use. */
+	zserv_recv_credit(client, p2p);
+
 	/* Reschedule ourselves */
 	zserv_client_event(client, ZSERV_CLIENT_READ);
 
 	stream_fifo_free(cache);
+	stream_fifo_free(cache_prio);
+
+	return 0;
+
+zread_fail:
+	stream_fifo_free(cache);
+	stream_fifo_free(cache_prio);
+	zserv_client_fail(client);
+	return -1;
+}
+
+/*
+ * Ring counterpart of zserv_read(), driven by the doorbell eventfd.
+ * Lifts complete messages off shm_rx into ibuf_work and publishes them
+ * on the input queues exactly like the socket path.
+ */
+static int zserv_shm_read(struct thread *thread)
+{
+	struct zserv *client = THREAD_ARG(thread);
+	struct stream_fifo *cache = stream_fifo_new();
+	struct stream_fifo *cache_prio = stream_fifo_new();
+	uint32_t p2p_orig = atomic_load_explicit(&zrouter.packets_to_process,
+						 memory_order_relaxed);
+	uint32_t p2p = p2p_orig;
+	struct zmsghdr hdr;
+	uint8_t buf[4096];
+
+	/* Intake policing, as in zserv_read().  The doorbell has not
+	 * been drained yet, so the resume timer's read event will fire
+	 * immediately. */
+	p2p_orig = zserv_recv_quota(client, p2p_orig);
+	if (p2p_orig == 0) {
+		stream_fifo_free(cache);
+		stream_fifo_free(cache_prio);
+		return 0;
+	}
+	p2p = p2p_orig;
 
+	zshm_ring_doorbell_drain(&client->shm_rx);
+
+	while (p2p) {
+		size_t already = stream_get_endp(client->ibuf_work);
+		size_t n;
+
+		if (already < ZEBRA_HEADER_SIZE) {
+			n = zshm_ring_get(&client->shm_rx, buf,
+					  ZEBRA_HEADER_SIZE - already);
+			stream_put(client->ibuf_work, buf, n);
+			already += n;
+			if (already < ZEBRA_HEADER_SIZE)
+				/* Partial header; wait for the next kick. */
+				break;
+		}
+
+		stream_set_getp(client->ibuf_work, 0);
+		if (!zapi_parse_header(client->ibuf_work, &hdr)
+		    || hdr.marker != ZEBRA_HEADER_MARKER
+		    || hdr.version != ZSERV_VERSION
+		    || hdr.length < ZEBRA_HEADER_SIZE
+		    || hdr.length > STREAM_SIZE(client->ibuf_work)) {
+			zserv_log_message("Corrupt header on shm ring",
+					  client->ibuf_work, &hdr);
+			goto zread_fail;
+		}
+
+		while (already < hdr.length) {
+			n = zshm_ring_get(&client->shm_rx, buf,
+					  MIN((size_t)(hdr.length - already),
+					      sizeof(buf)));
+			if (n == 0)
+				break;
+			stream_put(client->ibuf_work, buf, n);
+			already += n;
+		}
+		if (already < hdr.length)
+			break;
+
+		stream_set_getp(client->ibuf_work, 0);
+		struct stream *msg = stream_dup(client->ibuf_work);
+
+		if (zserv_command_is_bulk(hdr.command))
+			stream_fifo_push(cache, msg);
+		else
+			stream_fifo_push(cache_prio, msg);
+		stream_reset(client->ibuf_work);
+		p2p--;
+	}
+
+	if (p2p < p2p_orig) {
+		/* update session statistics */
+		atomic_store_explicit(&client->last_read_time, monotime(NULL),
+				      memory_order_relaxed);
+		atomic_store_explicit(&client->last_read_cmd, hdr.command,
+				      memory_order_relaxed);
+
+		/* publish read packets on client's input queues */
+		pthread_mutex_lock(&client->ibuf_mtx);
+		{
+			while (cache_prio->head)
+				stream_fifo_push(client->ibuf_prio_fifo,
+						 stream_fifo_pop(cache_prio));
+			while (cache->head)
+				stream_fifo_push(client->ibuf_fifo,
+						 stream_fifo_pop(cache));
+		}
+		pthread_mutex_unlock(&client->ibuf_mtx);
+
+		/* Schedule job to process those packets */
+		zserv_event(client, ZSERV_PROCESS_MESSAGES);
+	}
+
+	/* Hand back tokens for the part of the quota we did not use. */
+	zserv_recv_credit(client, p2p);
+
+	/* If the packets-to-process quota cut us short, the producer has
+	 * no reason to kick again: re-arm the doorbell ourselves. */
+	if (p2p == 0 && zshm_ring_readable(&client->shm_rx))
+		zshm_ring_kick(&client->shm_rx);
+
+	/* Reschedule ourselves */
+	zserv_client_event(client, ZSERV_CLIENT_READ);
+
+	stream_fifo_free(cache);
+	stream_fifo_free(cache_prio);
 	return 0;
 
 zread_fail:
 	stream_fifo_free(cache);
+	stream_fifo_free(cache_prio);
 	zserv_client_fail(client);
 	return -1;
 }
@@ -465,8 +843,14 @@ static void zserv_client_event(struct zserv *client,
 {
 	switch (event) {
 	case ZSERV_CLIENT_READ:
-		thread_add_read(client->pthread->master, zserv_read, client,
-				client->sock, &client->t_read);
+		if (client->shm_rx_active)
+			thread_add_read(client->pthread->master,
+					zserv_shm_read, client,
+					client->shm_rx.doorbell,
+					&client->t_read);
+		else
+			thread_add_read(client->pthread->master, zserv_read,
+					client, client->sock, &client->t_read);
 		break;
 	case ZSERV_CLIENT_WRITE:
 		thread_add_write(client->pthread->master, zserv_write, client,
@@ -499,14 +883,30 @@ static int zserv_process_messages(struct thread *thread)
 	struct zserv *client = THREAD_ARG(thread);
 	struct stream *msg;
 	struct stream_fifo *cache = stream_fifo_new();
-	uint32_t p2p = zrouter.packets_to_process;
+	uint32_t p2p;
 	bool need_resched = false;
 
+	/* Weigh this client's batch against the others: a client at the
+	 * default weight gets the configured batch size, one at half the
+	 * default gets half a batch per wakeup, and so on.
+	 */
+	p2p = zrouter.packets_to_process * client->msg_weight
+	      / ZSERV_MSG_WEIGHT_DEFAULT;
+	if (p2p == 0)
+		p2p = 1;
+
 	pthread_mutex_lock(&client->ibuf_mtx);
 	{
 		uint32_t i;
-		for (i = 0; i < p2p && stream_fifo_head(client->ibuf_fifo);
+
+		/* Priority traffic is always drained first. */
+		for (i = 0; i < p2p && stream_fifo_head(client->ibuf_prio_fifo);
 		     ++i) {
+			msg = stream_fifo_pop(client->ibuf_prio_fifo);
+			stream_fifo_push(cache, msg);
+		}
+
+		for (; i < p2p && stream_fifo_head(client->ibuf_fifo); ++i) {
 			msg = stream_fifo_pop(client->ibuf_fifo);
 			stream_fifo_push(cache, msg);
 		}
@@ -514,9 +914,10 @@ static int zserv_process_messages(struct thread *thread)
 		msg = NULL;
 
 		/* Need to reschedule processing work if there are still
-		 * packets in the fifo.
+		 * packets in the fifos.
 		 */
-		if (stream_fifo_head(client->ibuf_fifo))
+		if (stream_fifo_head(client->ibuf_prio_fifo)
+		    || stream_fifo_head(client->ibuf_fifo))
 			need_resched = true;
 	}
 	pthread_mutex_unlock(&client->ibuf_mtx);
@@ -571,6 +972,36 @@ int zserv_send_message(struct zserv *client, struct stream *msg)
 	return 0;
 }
 
+/*
+ * Send a batch of messages to a client. The entire fifo is moved onto
+ * the client's output queue under a single lock acquisition, with one
+ * write event scheduled for the whole batch.
+ */
+int zserv_send_fifo(struct zserv *client, struct stream_fifo *fifo)
+{
+	struct stream *msg;
+
+	if (client->is_synchronous) {
+		while ((msg = stream_fifo_pop(fifo)) != NULL)
+			stream_free(msg);
+		return 0;
+	}
+
+	if (stream_fifo_head(fifo) == NULL)
+		return 0;
+
+	pthread_mutex_lock(&client->obuf_mtx);
+	{
+		while ((msg = stream_fifo_pop(fifo)) != NULL)
+			stream_fifo_push(client->obuf_fifo, msg);
+	}
+	pthread_mutex_unlock(&client->obuf_mtx);
+
+	zserv_client_event(client, ZSERV_CLIENT_WRITE);
+
+	return 0;
+}
+
 
 /* Hooks for client connect / disconnect */
 DEFINE_HOOK(zserv_client_connect, (struct zserv *client), (client));
@@ -613,10 +1044,19 @@ static void zserv_client_free(struct zserv *client)
 		stream_free(client->obuf_work);
 	if (client->ibuf_fifo)
 		stream_fifo_free(client->ibuf_fifo);
+	if (client->ibuf_prio_fifo)
+		stream_fifo_free(client->ibuf_prio_fifo);
 	if (client->obuf_fifo)
 		stream_fifo_free(client->obuf_fifo);
-	if (client->wb)
-		buffer_free(client->wb);
+	if (client->wbuf_fifo)
+		stream_fifo_free(client->wbuf_fifo);
+
+	/* Tear down the shared-memory transport, if any. */
+	zshm_ring_close(&client->shm_rx);
+	zshm_ring_close(&client->shm_tx);
+	for (int i = 0; i < client->shm_nfds; i++)
+		if (client->shm_fds[i] >= 0)
+			close(client->shm_fds[i]);
 
 	/* Free buffer mutexes */
 	pthread_mutex_destroy(&client->obuf_mtx);
@@ -693,12 +1133,22 @@ static struct zserv *zserv_client_create(int sock)
 	/* Make client input/output buffer. */
 	client->sock = sock;
 	client->ibuf_fifo = stream_fifo_new();
+	client->ibuf_prio_fifo = stream_fifo_new();
 	client->obuf_fifo = stream_fifo_new();
+	client->msg_weight = ZSERV_MSG_WEIGHT_DEFAULT;
 	client->ibuf_work = stream_new(ZEBRA_MAX_PACKET_SIZ);
 	client->obuf_work = stream_new(ZEBRA_MAX_PACKET_SIZ);
 	pthread_mutex_init(&client->ibuf_mtx, NULL);
 	pthread_mutex_init(&client->obuf_mtx, NULL);
-	client->wb = buffer_new(0);
+	client->wbuf_fifo = stream_fifo_new();
+
+	/* Shared-memory transport: nothing negotiated yet, but peek for
+	 * descriptors on the client's first message. */
+	client->shm_rx.fd = client->shm_rx.doorbell = -1;
+	client->shm_tx.fd = client->shm_tx.doorbell = -1;
+	for (i = 0; i < (int)array_size(client->shm_fds); i++)
+		client->shm_fds[i] = -1;
+	client->shm_fd_wait = true;
 
 	/* Set table number. */
 	client->rtm_table = zrouter.rtm_table_default;
@@ -970,8 +1420,9 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client)
 	vty_out(vty, "MAC-IP delete notifications: %d\n", client->macipdel_cnt);
 
 #if defined DEV_BUILD
-	vty_out(vty, "Input Fifo: %zu:%zu Output Fifo: %zu:%zu\n",
+	vty_out(vty, "Input Fifo: %zu:%zu Prio Fifo: %zu:%zu Output Fifo: %zu:%zu\n",
 		client->ibuf_fifo->count, client->ibuf_fifo->max_count,
+		client->ibuf_prio_fifo->count, client->ibuf_prio_fifo->max_count,
 		client->obuf_fifo->count, client->obuf_fifo->max_count);
 #endif
 	vty_out(vty, "\n");
@@ -1056,6 +1507,87 @@ DEFUN (show_zebra_client_summary,
 	return CMD_SUCCESS;
 }
 
+/*
+ * Configured scheduling weight per client protocol type; zero means
+ * "use the default".
+ */
+static uint32_t zserv_proto_weight[ZEBRA_ROUTE_MAX];
+
+void zserv_set_client_weight(uint8_t proto, uint32_t weight)
+{
+	struct listnode *node;
+	struct zserv *client;
+
+	if (proto >= ZEBRA_ROUTE_MAX || weight > ZSERV_MSG_WEIGHT_MAX)
+		return;
+
+	zserv_proto_weight[proto] = weight;
+
+	/* Apply to clients of this protocol that are already connected. */
+	for (ALL_LIST_ELEMENTS_RO(zrouter.client_list, node, client))
+		if (client->proto == proto)
+			client->msg_weight =
+				weight ? weight : ZSERV_MSG_WEIGHT_DEFAULT;
+}
+
+uint32_t zserv_get_client_weight(uint8_t proto)
+{
+	if (proto >= ZEBRA_ROUTE_MAX || zserv_proto_weight[proto] == 0)
+		return ZSERV_MSG_WEIGHT_DEFAULT;
+
+	return zserv_proto_weight[proto];
+}
+
+/*
+ * Configured intake rate limit per client protocol type, messages per
+ * second; zero means unlimited.
+ */
+static uint32_t zserv_proto_ratelimit[ZEBRA_ROUTE_MAX];
+
+void zserv_set_client_ratelimit(uint8_t proto, uint32_t pps)
+{
+	struct listnode *node;
+	struct zserv *client;
+
+	if (proto >= ZEBRA_ROUTE_MAX)
+		return;
+
+	zserv_proto_ratelimit[proto] = pps;
+
+	/* Apply to clients of this protocol that are already connected;
+	 * the I/O thread rebuilds its bucket when it sees the change. */
+	for (ALL_LIST_ELEMENTS_RO(zrouter.client_list, node, client))
+		if (client->proto == proto)
+			atomic_store_explicit(&client->recv_pps, pps,
+					      memory_order_relaxed);
+}
+
+uint32_t zserv_get_client_ratelimit(uint8_t proto)
+{
+	if (proto >= ZEBRA_ROUTE_MAX)
+		return 0;
+
+	return zserv_proto_ratelimit[proto];
+}
+
+int zserv_config_write(struct vty *vty)
+{
+	int i;
+
+	for (i = 0; i < ZEBRA_ROUTE_MAX; i++)
+		if (zserv_proto_weight[i])
+			vty_out(vty, "zebra zapi-weight %s %u\n",
+				zebra_route_string(i), zserv_proto_weight[i]);
+
+	for (i = 0; i < ZEBRA_ROUTE_MAX; i++)
+		if (zserv_proto_ratelimit[i])
+			vty_out(vty, "zebra zapi-ratelimit %s %u\n",
+				zebra_route_string(i),
+				zserv_proto_ratelimit[i]);
+
+	return 0;
+}
+
 #if defined(HANDLE_ZAPI_FUZZING)
 void zserv_read_file(char *input)
 {
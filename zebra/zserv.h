@@ -36,6 +36,8 @@
 #include "lib/linklist.h"     /* for list */
 #include "lib/workqueue.h"    /* for work_queue */
 #include "lib/hook.h"         /* for DECLARE_HOOK, DECLARE_KOOH */
+#include "lib/zshmring.h"     /* for zshm_ring */
+#include "lib/tokenbucket.h"  /* for token_bucket */
 
 #include "zebra/zebra_vrf.h"  /* for zebra_vrf */
 /* clang-format on */
@@ -62,17 +64,61 @@ struct zserv {
 	pthread_mutex_t obuf_mtx;
 	struct stream_fifo *obuf_fifo;
 
+	/*
+	 * Priority input queue, also protected by ibuf_mtx.  The I/O
+	 * thread steers interface, registration and query traffic here;
+	 * the main thread always drains it ahead of the bulk route
+	 * updates sitting on ibuf_fifo.
+	 */
+	struct stream_fifo *ibuf_prio_fifo;
+
+	/*
+	 * Scheduling weight for this client, relative to
+	 * ZSERV_MSG_WEIGHT_DEFAULT.  It scales how many queued messages
+	 * the main thread handles for this client per wakeup; lowering a
+	 * chatty client's weight leaves more cycles for the others.
+	 */
+	uint32_t msg_weight;
+
+	/*
+	 * Intake rate limit, messages per second; zero is unlimited.
+	 * recv_pps is written by the main thread on config change, the
+	 * bucket itself belongs to the I/O thread, which rebuilds it
+	 * whenever it notices recv_pps changed.
+	 */
+	_Atomic uint32_t recv_pps;
+	struct token_bucket recv_limit;
+
 	/* Private I/O buffers */
 	struct stream *ibuf_work;
 	struct stream *obuf_work;
 
-	/* Buffer of data waiting to be written to client. */
-	struct buffer *wb;
+	/*
+	 * Data waiting to be written to the client, owned by the client
+	 * pthread (no lock).  zserv_write() drains obuf_fifo into this
+	 * and writes straight out of the queued streams with writev().
+	 */
+	struct stream_fifo *wbuf_fifo;
 
 	/* Threads for read/write. */
 	struct thread *t_read;
 	struct thread *t_write;
 
+	/*
+	 * Shared-memory ring transport, negotiated via ZEBRA_SHM_HELLO
+	 * (see lib/zshmring.h).  All fields are owned by the client
+	 * pthread.  shm_rx carries the client's messages to us, shm_tx
+	 * the reverse direction; while inactive the socket is used.
+	 */
+	struct zshm_ring shm_rx;
+	struct zshm_ring shm_tx;
+	bool shm_rx_active;
+	bool shm_tx_active;
+	/* fds captured from SCM_RIGHTS while waiting for the offer */
+	int shm_fds[4];
+	int shm_nfds;
+	bool shm_fd_wait;
+
 	/* Event for message processing, for the main pthread */
 	struct thread *t_process;
 
@@ -166,6 +212,10 @@ struct zserv {
 	struct zserv *client, struct zmsghdr *hdr, struct stream *msg,         \
 		struct zebra_vrf *zvrf
 
+/* Default and maximum per-client message scheduling weight. */
+#define ZSERV_MSG_WEIGHT_DEFAULT 4
+#define ZSERV_MSG_WEIGHT_MAX 8
+
 /* Hooks for client connect / disconnect */
 DECLARE_HOOK(zserv_client_connect, (struct zserv *client), (client));
 DECLARE_KOOH(zserv_client_close, (struct zserv *client), (client));
@@ -201,6 +251,21 @@ extern void zserv_start(char *path);
  */
 extern int zserv_send_message(struct zserv *client, struct stream *msg);
 
+/*
+ * Send a batch of messages to a client.
+ *
+ * The messages are moved from the fifo onto the client's output queue
+ * in one operation; the fifo is empty on return and remains owned by
+ * the caller.
+ *
+ * client
+ *    the client to send to
+ *
+ * fifo
+ *    the messages to send
+ */
+extern int zserv_send_fifo(struct zserv *client, struct stream_fifo *fifo);
+
 /*
  * Retrieve a client by its protocol and instance number.
  *
@@ -227,6 +292,43 @@ extern struct zserv *zserv_find_client(uint8_t proto, unsigned short instance);
  */
 extern void zserv_close_client(struct zserv *client);
 
+/*
+ * Set the message scheduling weight for all clients of a protocol type.
+ *
+ * The weight applies to connected clients immediately and is inherited
+ * by clients of that protocol connecting later.
+ *
+ * proto
+ *    the client protocol (ZEBRA_ROUTE_*)
+ *
+ * weight
+ *    scheduling weight, 1..ZSERV_MSG_WEIGHT_MAX
+ */
+extern void zserv_set_client_weight(uint8_t proto, uint32_t weight);
+
+/*
+ * Get the configured message scheduling weight for a protocol type.
+ */
+extern uint32_t zserv_get_client_weight(uint8_t proto);
+
+/*
+ * Set the intake rate limit for all clients of a protocol type, in
+ * messages per second; zero removes the limit.  Applies to connected
+ * clients immediately and is inherited by later ones.
+ */
+extern void zserv_set_client_ratelimit(uint8_t proto, uint32_t pps);
+
+/*
+ * Get the configured intake rate limit for a protocol type; zero means
+ * unlimited.
+ */
+extern uint32_t zserv_get_client_ratelimit(uint8_t proto);
+
+/*
+ * Write the zserv scheduling configuration to vty.
+ */
+extern int zserv_config_write(struct vty *vty);
+
 #if defined(HANDLE_ZAPI_FUZZING)
 extern void zserv_read_file(char *input);
 #endif